@@ -17,6 +17,7 @@
 #define KSPConvergedReason PetscEnum
 #define KSPNormType PetscEnum
 #define KSPGMRESCGSRefinementType PetscEnum
+#define KSPSStepBasisType PetscEnum
 #define MatSchurComplementAinvType PetscEnum
 !
 !  Various Krylov subspace methods
@@ -28,11 +29,15 @@
 #define KSPSTCG 'stcg'
 #define KSPGLTR 'gltr'
 #define KSPFCG 'fcg'
+#define KSPSCG 'scg'
 #define KSPGMRES 'gmres'
 #define KSPFGMRES 'fgmres'
 #define KSPLGMRES 'lgmres'
 #define KSPDGMRES 'dgmres'
 #define KSPPGMRES 'pgmres'
+#define KSPSGMRES 'sgmres'
+#define KSPPIPELGMRES 'pipelgmres'
+#define KSPGCRODR 'gcrodr'
 #define KSPTCQMR 'tcqmr'
 #define KSPBCGS 'bcgs'
 #define KSPIBCGS 'ibcgs'
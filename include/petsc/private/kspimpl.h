@@ -20,6 +20,7 @@ struct _KSPOps {
                                                           calculates the residual in a
                                                           user-provided area.  */
   PetscErrorCode (*solve)(KSP);                        /* actual solver */
+  PetscErrorCode (*matsolve)(KSP,Mat,Mat);             /* solver for several right hand sides stored in dense matrices */
   PetscErrorCode (*setup)(KSP);
   PetscErrorCode (*setfromoptions)(PetscOptionItems*,KSP);
   PetscErrorCode (*publishoptions)(KSP);
@@ -187,6 +188,8 @@ PETSC_STATIC_INLINE PetscErrorCode KSPLogResidualHistory(KSP ksp,PetscReal norm)
 PETSC_INTERN PetscErrorCode KSPSetUpNorms_Private(KSP,PetscBool,KSPNormType*,PCSide*);
 
 PETSC_INTERN PetscErrorCode KSPPlotEigenContours_Private(KSP,PetscInt,const PetscReal*,const PetscReal*);
+PETSC_INTERN PetscErrorCode KSPSStepBasisCoefficients_Private(KSPSStepBasisType,PetscInt,const PetscReal[],const PetscReal[],PetscInt,PetscScalar[],PetscScalar[],PetscScalar[]);
+PETSC_INTERN PetscErrorCode KSPSStepUseMatMultBasis_Private(KSP,PetscBool*);
 
 typedef struct _p_DMKSP *DMKSP;
 typedef struct _DMKSPOps *DMKSPOps;
@@ -330,6 +333,7 @@ PETSC_STATIC_INLINE PetscErrorCode KSP_PCApplyBAorABTranspose(KSP ksp,Vec x,Vec
 PETSC_EXTERN PetscLogEvent KSP_GMRESOrthogonalization;
 PETSC_EXTERN PetscLogEvent KSP_SetUp;
 PETSC_EXTERN PetscLogEvent KSP_Solve;
+PETSC_EXTERN PetscLogEvent KSP_MatSolve;
 PETSC_EXTERN PetscLogEvent KSP_Solve_FS_0;
 PETSC_EXTERN PetscLogEvent KSP_Solve_FS_1;
 PETSC_EXTERN PetscLogEvent KSP_Solve_FS_2;
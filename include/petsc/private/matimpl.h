@@ -232,6 +232,9 @@ PETSC_INTERN PetscErrorCode MatFindNonzeroRowsOrCols_Basic(Mat,PetscBool,PetscRe
 PETSC_INTERN PetscErrorCode MatConvert_Basic(Mat,MatType,MatReuse,Mat*);
 PETSC_INTERN PetscErrorCode MatCopy_Basic(Mat,Mat,MatStructure);
 PETSC_INTERN PetscErrorCode MatDiagonalSet_Default(Mat,Vec,InsertMode);
+PETSC_INTERN PetscErrorCode MatSetPreallocationCOO_Basic(Mat,PetscInt,const PetscInt[],const PetscInt[]);
+PETSC_INTERN PetscErrorCode MatSetValuesCOO_Basic(Mat,const PetscScalar[],InsertMode);
+PETSC_INTERN PetscErrorCode MatMultBasis_Basic(Mat,Vec,PetscInt,const PetscScalar[],const PetscScalar[],const PetscScalar[],Vec[]);
 
 #if defined(PETSC_USE_DEBUG)
 #  define MatCheckPreallocated(A,arg) do {                              \
@@ -330,6 +333,8 @@ struct _MatStash {
   MPI_Datatype   blocktype;
   size_t         blocktype_size;
   InsertMode     *insertmode;   /* Pointer to check mat->insertmode and set upon message arrival in case no local values have been set. */
+  PetscLogDouble sendbytes;     /* Bytes sent by the current assembly, reported with -info */
+  PetscLogDouble recvbytes;     /* Bytes received so far by the current assembly */
 };
 
 PETSC_INTERN PetscErrorCode MatStashCreate_Private(MPI_Comm,PetscInt,MatStash*);
@@ -1621,6 +1626,7 @@ PETSC_EXTERN PetscLogEvent MAT_MultMatrixFree;
 PETSC_EXTERN PetscLogEvent MAT_Mults;
 PETSC_EXTERN PetscLogEvent MAT_MultConstrained;
 PETSC_EXTERN PetscLogEvent MAT_MultAdd;
+PETSC_EXTERN PetscLogEvent MAT_MultCommWait;
 PETSC_EXTERN PetscLogEvent MAT_MultTranspose;
 PETSC_EXTERN PetscLogEvent MAT_MultTransposeConstrained;
 PETSC_EXTERN PetscLogEvent MAT_MultTransposeAdd;
@@ -1707,9 +1713,12 @@ PETSC_EXTERN PetscLogEvent MATMFFD_Mult;
 PETSC_EXTERN PetscLogEvent MAT_GetMultiProcBlock;
 PETSC_EXTERN PetscLogEvent MAT_CUSPARSECopyToGPU;
 PETSC_EXTERN PetscLogEvent MAT_SetValuesBatch;
+PETSC_EXTERN PetscLogEvent MAT_PreallCOO;
+PETSC_EXTERN PetscLogEvent MAT_SetVCOO;
 PETSC_EXTERN PetscLogEvent MAT_ViennaCLCopyToGPU;
 PETSC_EXTERN PetscLogEvent MAT_Merge;
 PETSC_EXTERN PetscLogEvent MAT_Residual;
+PETSC_EXTERN PetscLogEvent MAT_MultBasis;
 PETSC_EXTERN PetscLogEvent MAT_SetRandom;
 PETSC_EXTERN PetscLogEvent MATCOLORING_Apply;
 PETSC_EXTERN PetscLogEvent MATCOLORING_Comm;
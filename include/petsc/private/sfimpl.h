@@ -18,17 +18,33 @@ struct _PetscSFOps {
   PetscErrorCode (*Reset)(PetscSF);
   PetscErrorCode (*Destroy)(PetscSF);
   PetscErrorCode (*SetUp)(PetscSF);
+  PetscErrorCode (*SetUpBegin)(PetscSF);
+  PetscErrorCode (*SetUpEnd)(PetscSF);
+  PetscErrorCode (*GetRootRanks)(PetscSF,PetscInt*,PetscInt*,const PetscMPIInt**,const PetscInt**,const PetscInt**);
   PetscErrorCode (*SetFromOptions)(PetscOptionItems*,PetscSF);
   PetscErrorCode (*View)(PetscSF,PetscViewer);
   PetscErrorCode (*Duplicate)(PetscSF,PetscSFDuplicateOption,PetscSF);
   PetscErrorCode (*BcastBegin)(PetscSF,MPI_Datatype,const void*,void*);
   PetscErrorCode (*BcastEnd)(PetscSF,MPI_Datatype,const void*,void*);
+  PetscErrorCode (*BcastAndOpBegin)(PetscSF,MPI_Datatype,const void*,void*,MPI_Op);
+  PetscErrorCode (*BcastAndOpEnd)(PetscSF,MPI_Datatype,const void*,void*,MPI_Op);
   PetscErrorCode (*ReduceBegin)(PetscSF,MPI_Datatype,const void*,void*,MPI_Op);
   PetscErrorCode (*ReduceEnd)(PetscSF,MPI_Datatype,const void*,void*,MPI_Op);
   PetscErrorCode (*FetchAndOpBegin)(PetscSF,MPI_Datatype,void*,const void*,void*,MPI_Op);
   PetscErrorCode (*FetchAndOpEnd)(PetscSF,MPI_Datatype,void*,const void *,void *,MPI_Op);
+  PetscErrorCode (*Progress)(PetscSF);
 };
 
+/* The lists of ranks with leaves of sfB that PetscSFCompose() sends to the root ranks of sfA, and the ranks it receives lists from */
+typedef struct {
+  PetscMPIInt nto,*toranks;     /* Root ranks of sfA, possibly including this process */
+  PetscInt    *tooffset,*tolist; /* The ranks attached to toranks[i] are tolist[tooffset[i]..tooffset[i+1]) */
+  PetscMPIInt nfrom,*fromranks; /* Other ranks with leaves of sfA referencing my roots */
+  PetscMPIInt tag;
+  PetscInt    *tolength,*fromlength,*fromlist; /* Lengths sent and received, and the lists received in the order of fromranks */
+  MPI_Request *reqs;            /* Sends of the lengths and lists, then receives from fromranks, NULL until the exchange begins */
+} PetscSFComposeRanks;
+
 struct _p_PetscSF {
   PETSCHEADER(struct _PetscSFOps);
   PetscInt        nroots;       /* Number of root vertices on current process (candidates for incoming edges) */
@@ -53,6 +69,13 @@ struct _p_PetscSF {
   PetscSF         multi;        /* Internal graph used to implement gather and scatter operations */
   PetscBool       graphset;     /* Flag indicating that the graph has been set, required before calling communication routines */
   PetscBool       setupcalled;  /* Type and communication structures have been set up */
+  PetscBool       setupbegun;   /* PetscSFSetUpBegin() has been called, PetscSFSetUpEnd() has not */
+  PetscMPIInt     nkranks;      /* Number of other ranks with leaves referencing my roots when known from the PetscSF this one was derived from, -1 if not */
+  PetscMPIInt     *kranks;      /* Those ranks, so that setup does not have to discover them */
+  PetscInt        *koffset;     /* NULL, or array of length nkranks+1 holding offsets in kroots[] for each of those ranks */
+  PetscInt        *kroots;      /* My roots referenced by each of those ranks, in the order of its leaves */
+  PetscBool       kagree;       /* The known ranks may be used only if all processes know them, which is agreed on when they are requested */
+  PetscSFComposeRanks *kcompose; /* Exchange that derives the known ranks of a PetscSF created by PetscSFCompose(), done during its setup */
 
   void *data;                   /* Pointer to implementation */
 };
@@ -60,6 +83,10 @@ struct _p_PetscSF {
 PETSC_EXTERN PetscBool PetscSFRegisterAllCalled;
 PETSC_EXTERN PetscErrorCode PetscSFRegisterAll(void);
 
+PETSC_INTERN PetscErrorCode PetscSFSetKnownRootRanks_Private(PetscSF,PetscBool,PetscMPIInt,PetscMPIInt*,PetscInt*,PetscInt*);
+PETSC_INTERN PetscErrorCode PetscSFGetKnownRootRanksBegin_Private(PetscSF,PetscBool*);
+PETSC_INTERN PetscErrorCode PetscSFGetKnownRootRanksEnd_Private(PetscSF,PetscMPIInt*,const PetscMPIInt**,const PetscInt**,const PetscInt**);
+
 PETSC_EXTERN PetscErrorCode MPIPetsc_Type_unwrap(MPI_Datatype,MPI_Datatype*,PetscBool*);
 PETSC_EXTERN PetscErrorCode MPIPetsc_Type_compare(MPI_Datatype,MPI_Datatype,PetscBool*);
 PETSC_EXTERN PetscErrorCode MPIPetsc_Type_compare_contig(MPI_Datatype,MPI_Datatype,PetscInt*);
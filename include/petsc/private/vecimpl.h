@@ -93,6 +93,7 @@ struct _VecOps {
   PetscErrorCode (*restorelocalvector)(Vec,Vec);
   PetscErrorCode (*getlocalvectorread)(Vec,Vec);
   PetscErrorCode (*restorelocalvectorread)(Vec,Vec);
+  PetscErrorCode (*maxpymdot)(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*); /* y = y + alpha[j] x[j], then z[j] = y dot x[j] and ||y|| */
 };
 
 /*
@@ -160,6 +161,7 @@ PETSC_EXTERN PetscLogEvent VEC_AXPY;
 PETSC_EXTERN PetscLogEvent VEC_AYPX;
 PETSC_EXTERN PetscLogEvent VEC_WAXPY;
 PETSC_EXTERN PetscLogEvent VEC_MAXPY;
+PETSC_EXTERN PetscLogEvent VEC_MAXPYMDot;
 PETSC_EXTERN PetscLogEvent VEC_AssemblyEnd;
 PETSC_EXTERN PetscLogEvent VEC_PointwiseMult;
 PETSC_EXTERN PetscLogEvent VEC_SetValues;
@@ -200,7 +202,8 @@ PETSC_EXTERN PetscErrorCode VecCUDACopyFromGPU(Vec v);
 #define VECHEADER                          \
   PetscScalar *array;                      \
   PetscScalar *array_allocated;                        /* if the array was allocated by PETSc this is its pointer */  \
-  PetscScalar *unplacedarray;                           /* if one called VecPlaceArray(), this is where it stashed the original */
+  PetscScalar *unplacedarray;                           /* if one called VecPlaceArray(), this is where it stashed the original */ \
+  PetscInt    nthreads;                                 /* number of OpenMP threads used by the BLAS-1 operations, see -vec_threads */
 
 /* Default obtain and release vectors; can be used by any implementation */
 PETSC_EXTERN PetscErrorCode VecDuplicateVecs_Default(Vec,PetscInt,Vec *[]);
@@ -18,7 +18,7 @@ PETSC_EXTERN PetscErrorCode VecScatterRegisterAll(void);
 
 typedef enum { VEC_SCATTER_SEQ_GENERAL,VEC_SCATTER_SEQ_STRIDE,
                VEC_SCATTER_MPI_GENERAL,VEC_SCATTER_MPI_TOALL,
-               VEC_SCATTER_MPI_TOONE} VecScatterFormat;
+               VEC_SCATTER_MPI_TOONE,VEC_SCATTER_SF} VecScatterFormat;
 
 #define VECSCATTER_IMPL_HEADER \
       VecScatterFormat format;
@@ -297,12 +297,16 @@ struct _VecScatterOps {
   PetscErrorCode (*viewfromoptions)(VecScatter,const char prefix[],const char name[]);
   PetscErrorCode (*remap)(VecScatter,PetscInt *,PetscInt*);
   PetscErrorCode (*getmerged)(VecScatter,PetscBool *);
+  PetscErrorCode (*beginvecs)(VecScatter,PetscInt,const Vec[],const Vec[],InsertMode,ScatterMode);
+  PetscErrorCode (*endvecs)(VecScatter,PetscInt,const Vec[],const Vec[],InsertMode,ScatterMode);
+  PetscErrorCode (*progress)(VecScatter);
 };
 
 struct _p_VecScatter {
   PETSCHEADER(struct _VecScatterOps);
   PetscInt       to_n,from_n;
-  PetscBool      inuse;                /* prevents corruption from mixing two scatters */
+  PetscInt       inuse;                /* number of scatters begun and not ended, prevents corruption from mixing two scatters */
+  PetscBool      concurrent;           /* the implementation allows several scatters to be in flight at once, with different vectors */
   PetscBool      beginandendtogether;  /* indicates that the scatter begin and end  function are called together, VecScatterEnd() is then treated as a nop */
   void           *fromdata,*todata;
   void           *spptr;
@@ -315,7 +319,9 @@ PETSC_INTERN PetscErrorCode VecScatterCreate_Seq(VecScatter);
 PETSC_INTERN PetscErrorCode VecScatterCreate_MPI1(VecScatter);
 PETSC_INTERN PetscErrorCode VecScatterCreate_MPI3(VecScatter);
 PETSC_INTERN PetscErrorCode VecScatterCreate_MPI3Node(VecScatter);
+PETSC_INTERN PetscErrorCode VecScatterCreate_SF(VecScatter);
 
+PETSC_INTERN PetscErrorCode VecScatterProgress_PtoP(VecScatter);
 PETSC_INTERN PetscErrorCode VecScatterSetUp_vectype_private(VecScatter,PetscErrorCode (*)(PetscInt,const PetscInt*,PetscInt,const PetscInt*,Vec,Vec,PetscInt,VecScatter),PetscErrorCode (*)(PetscInt,const PetscInt*,PetscInt,const PetscInt*,Vec,Vec,PetscInt,VecScatter),PetscErrorCode (*)(PetscInt,const PetscInt*,PetscInt,const PetscInt*,Vec,Vec,PetscInt,VecScatter));
 
 PETSC_INTERN PetscErrorCode VecScatterDestroy_SGToSG(VecScatter);
@@ -309,6 +309,8 @@ PETSC_EXTERN PetscErrorCode MatSetValuesBlocked(Mat,PetscInt,const PetscInt[],Pe
 PETSC_EXTERN PetscErrorCode MatSetValuesRow(Mat,PetscInt,const PetscScalar[]);
 PETSC_EXTERN PetscErrorCode MatSetValuesRowLocal(Mat,PetscInt,const PetscScalar[]);
 PETSC_EXTERN PetscErrorCode MatSetValuesBatch(Mat,PetscInt,PetscInt,PetscInt[],const PetscScalar[]);
+PETSC_EXTERN PetscErrorCode MatSetPreallocationCOO(Mat,PetscInt,const PetscInt[],const PetscInt[]);
+PETSC_EXTERN PetscErrorCode MatSetValuesCOO(Mat,const PetscScalar[],InsertMode);
 PETSC_EXTERN PetscErrorCode MatSetRandom(Mat,PetscRandom);
 
 /*S
@@ -437,6 +439,7 @@ PETSC_EXTERN PetscErrorCode MatIsTranspose(Mat,Mat,PetscReal,PetscBool *);
 PETSC_EXTERN PetscErrorCode MatIsHermitianTranspose(Mat,Mat,PetscReal,PetscBool *);
 PETSC_EXTERN PetscErrorCode MatMultTransposeAdd(Mat,Vec,Vec,Vec);
 PETSC_EXTERN PetscErrorCode MatMultHermitianTransposeAdd(Mat,Vec,Vec,Vec);
+PETSC_EXTERN PetscErrorCode MatMultBasis(Mat,Vec,PetscInt,const PetscScalar[],const PetscScalar[],const PetscScalar[],Vec[]);
 PETSC_EXTERN PetscErrorCode MatMultConstrained(Mat,Vec,Vec);
 PETSC_EXTERN PetscErrorCode MatMultTransposeConstrained(Mat,Vec,Vec);
 PETSC_EXTERN PetscErrorCode MatMatSolve(Mat,Mat,Mat);
@@ -1030,6 +1033,22 @@ PETSC_EXTERN PetscErrorCode MatInodeAdjustForInodes(Mat,IS*,IS*);
 PETSC_EXTERN PetscErrorCode MatInodeGetInodeSizes(Mat,PetscInt *,PetscInt *[],PetscInt *);
 
 PETSC_EXTERN PetscErrorCode MatSeqAIJSetColumnIndices(Mat,PetscInt[]);
+
+/*E
+    MatAIJMultPrecision - precision in which the values of an AIJ matrix are stored for MatMult() and MatMultAdd()
+
++   MAT_AIJ_MULT_DOUBLE - use the matrix values as they are stored (the default)
+.   MAT_AIJ_MULT_SINGLE - use a copy of the values rounded to single precision
+-   MAT_AIJ_MULT_BFLOAT16 - use a copy of the values rounded to bfloat16 (single precision exponent, 8 bit significand)
+
+    Level: advanced
+
+.seealso: MatAIJSetMultPrecision()
+E*/
+typedef enum {MAT_AIJ_MULT_DOUBLE,MAT_AIJ_MULT_SINGLE,MAT_AIJ_MULT_BFLOAT16} MatAIJMultPrecision;
+PETSC_EXTERN const char *const MatAIJMultPrecisions[];
+PETSC_EXTERN PetscErrorCode MatAIJSetMultPrecision(Mat,MatAIJMultPrecision);
+PETSC_EXTERN PetscErrorCode MatAIJSetCompressedIndices(Mat,PetscBool);
 PETSC_EXTERN PetscErrorCode MatSeqBAIJSetColumnIndices(Mat,PetscInt[]);
 PETSC_EXTERN PetscErrorCode MatCreateSeqAIJWithArrays(MPI_Comm,PetscInt,PetscInt,PetscInt[],PetscInt[],PetscScalar[],Mat*);
 PETSC_EXTERN PetscErrorCode MatCreateSeqBAIJWithArrays(MPI_Comm,PetscInt,PetscInt,PetscInt,PetscInt[],PetscInt[],PetscScalar[],Mat*);
@@ -16,17 +16,23 @@ PETSC_EXTERN PetscClassId PETSCSF_CLASSID;
    Level: beginner
 
    Notes:
-    The two approaches provided are
-$     PETSCSFBASIC which uses MPI 1 message passing to perform the communication and
+    The approaches provided are
+$     PETSCSFBASIC which uses MPI 1 message passing to perform the communication,
+$     PETSCSFNEIGHBOR which uses MPI 3 neighborhood collectives on a graph communicator created once,
+$     PETSCSFSHARED which moves the data between processes of the same node through MPI 3 shared memory,
 $     PETSCSFWINDOW which uses MPI 2 one-sided operations to perform the communication, this may be more efficient,
 $                   but may not be available for all MPI distributions. In particular OpenMPI has bugs in its one-sided
-$                   operations that prevent its use.
+$                   operations that prevent its use, and
+$     PETSCSFAUTO which times the other approaches on the first operations and then uses the fastest one.
 
 .seealso: PetscSFSetType(), PetscSF
 J*/
 typedef const char *PetscSFType;
 #define PETSCSFBASIC  "basic"
 #define PETSCSFWINDOW "window"
+#define PETSCSFNEIGHBOR "neighbor"
+#define PETSCSFSHARED "shared"
+#define PETSCSFAUTO "auto"
 
 /*E
     PetscSFWindowSyncType - Type of synchronization for PETSCSFWINDOW
@@ -68,10 +74,14 @@ PETSC_EXTERN PetscErrorCode PetscSFGetType(PetscSF,PetscSFType*);
 PETSC_EXTERN PetscErrorCode PetscSFView(PetscSF,PetscViewer);
 PETSC_STATIC_INLINE PetscErrorCode PetscSFViewFromOptions(PetscSF A,PetscObject obj,const char name[]) {return PetscObjectViewFromOptions((PetscObject)A,obj,name);}
 PETSC_EXTERN PetscErrorCode PetscSFSetUp(PetscSF);
+PETSC_EXTERN PetscErrorCode PetscSFSetUpBegin(PetscSF);
+PETSC_EXTERN PetscErrorCode PetscSFSetUpEnd(PetscSF);
 PETSC_EXTERN PetscErrorCode PetscSFSetFromOptions(PetscSF);
 PETSC_EXTERN PetscErrorCode PetscSFDuplicate(PetscSF,PetscSFDuplicateOption,PetscSF*);
 PETSC_EXTERN PetscErrorCode PetscSFWindowSetSyncType(PetscSF,PetscSFWindowSyncType);
 PETSC_EXTERN PetscErrorCode PetscSFWindowGetSyncType(PetscSF,PetscSFWindowSyncType*);
+PETSC_EXTERN PetscErrorCode PetscSFAutoSetType(PetscSF,const char[]);
+PETSC_EXTERN PetscErrorCode PetscSFAutoGetType(PetscSF,const char**);
 PETSC_EXTERN PetscErrorCode PetscSFSetRankOrder(PetscSF,PetscBool);
 PETSC_EXTERN PetscErrorCode PetscSFSetGraph(PetscSF,PetscInt,PetscInt,const PetscInt*,PetscCopyMode,const PetscSFNode*,PetscCopyMode);
 PETSC_EXTERN PetscErrorCode PetscSFGetGraph(PetscSF,PetscInt*,PetscInt*,const PetscInt**,const PetscSFNode**);
@@ -90,6 +100,11 @@ PETSC_EXTERN PetscErrorCode PetscSFBcastBegin(PetscSF,MPI_Datatype,const void*,v
   PetscAttrMPIPointerWithType(3,2) PetscAttrMPIPointerWithType(4,2);
 PETSC_EXTERN PetscErrorCode PetscSFBcastEnd(PetscSF,MPI_Datatype,const void*,void*)
   PetscAttrMPIPointerWithType(3,2) PetscAttrMPIPointerWithType(4,2);
+/* broadcasts rootdata to leafdata, combining with the leaf values using provided operation */
+PETSC_EXTERN PetscErrorCode PetscSFBcastAndOpBegin(PetscSF,MPI_Datatype,const void*,void*,MPI_Op)
+  PetscAttrMPIPointerWithType(3,2) PetscAttrMPIPointerWithType(4,2);
+PETSC_EXTERN PetscErrorCode PetscSFBcastAndOpEnd(PetscSF,MPI_Datatype,const void*,void*,MPI_Op)
+  PetscAttrMPIPointerWithType(3,2) PetscAttrMPIPointerWithType(4,2);
 /* Reduce leafdata into rootdata using provided operation */
 PETSC_EXTERN PetscErrorCode PetscSFReduceBegin(PetscSF,MPI_Datatype,const void*,void *,MPI_Op)
   PetscAttrMPIPointerWithType(3,2) PetscAttrMPIPointerWithType(4,2);
@@ -100,6 +115,8 @@ PETSC_EXTERN PetscErrorCode PetscSFFetchAndOpBegin(PetscSF,MPI_Datatype,void*,co
   PetscAttrMPIPointerWithType(3,2) PetscAttrMPIPointerWithType(4,2) PetscAttrMPIPointerWithType(5,2);
 PETSC_EXTERN PetscErrorCode PetscSFFetchAndOpEnd(PetscSF,MPI_Datatype,void*,const void*,void*,MPI_Op)
   PetscAttrMPIPointerWithType(3,2) PetscAttrMPIPointerWithType(4,2) PetscAttrMPIPointerWithType(5,2);
+/* Let MPI move the messages of the operations in progress */
+PETSC_EXTERN PetscErrorCode PetscSFProgress(PetscSF);
 /* Compute the degree of every root vertex (number of leaves in its star) */
 PETSC_EXTERN PetscErrorCode PetscSFComputeDegreeBegin(PetscSF,const PetscInt**);
 PETSC_EXTERN PetscErrorCode PetscSFComputeDegreeEnd(PetscSF,const PetscInt**);
@@ -2320,6 +2320,7 @@ PETSC_EXTERN PetscErrorCode PetscCommBuildTwoSidedSetType(MPI_Comm,PetscBuildTwo
 PETSC_EXTERN PetscErrorCode PetscCommBuildTwoSidedGetType(MPI_Comm,PetscBuildTwoSidedType*);
 
 PETSC_EXTERN PetscErrorCode PetscSSEIsEnabled(MPI_Comm,PetscBool*,PetscBool*);
+PETSC_EXTERN PetscErrorCode PetscAVXIsEnabled(PetscBool*,PetscBool*);
 
 PETSC_EXTERN MPI_Comm PetscObjectComm(PetscObject);
 
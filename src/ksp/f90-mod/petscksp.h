@@ -103,6 +103,16 @@
       parameter (KSP_GMRES_CGS_REFINE_IFNEEDED = 1)
       parameter (KSP_GMRES_CGS_REFINE_ALWAYS = 2)
 !
+!   Possible arguments to KSPSStepSetBasisType()
+!
+      PetscEnum KSP_SSTEP_BASIS_MONOMIAL
+      PetscEnum KSP_SSTEP_BASIS_NEWTON
+      PetscEnum KSP_SSTEP_BASIS_CHEBYSHEV
+!
+      parameter (KSP_SSTEP_BASIS_MONOMIAL = 0)
+      parameter (KSP_SSTEP_BASIS_NEWTON = 1)
+      parameter (KSP_SSTEP_BASIS_CHEBYSHEV = 2)
+!
 !  End of Fortran include file for the KSP package in PETSc
 !
 
@@ -0,0 +1,147 @@
+static char help[] = "Tests KSPMatSolve() with several right hand sides, some of which are linearly dependent.\n\
+  -m <m>, -n <n> : grid dimensions of the five point operator\n\
+  -k <k>         : number of right hand sides\n\
+  -nonsym        : add a convection term to the operator\n\n";
+
+/*
+   The last right hand sides are combinations of the first ones and one is zero, so the block methods must drop the
+   dependent directions. Every column of the solution must satisfy the system to the requested accuracy, and the
+   solution of KSPSolve() with the same method must agree with the first column.
+*/
+#include <petscksp.h>
+
+int main(int argc,char **argv)
+{
+  KSP            ksp;
+  Mat            A,B,X;
+  Vec            b,x,r;
+  PetscInt       m = 12,n = 11,k = 6,N,i,j,row,col,Istart,Iend,c;
+  PetscScalar    v,*bb,*cb;
+  PetscReal      err,nrm,conv = 0.0;
+  PetscBool      nonsym = PETSC_FALSE;
+  KSPConvergedReason reason;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = PetscOptionsGetInt(NULL,NULL,"-m",&m,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-k",&k,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(NULL,NULL,"-nonsym",&nonsym,NULL);CHKERRQ(ierr);
+  if (k < 4) SETERRQ(PETSC_COMM_WORLD,PETSC_ERR_ARG_OUTOFRANGE,"Needs at least 4 right hand sides");
+  if (nonsym) conv = 0.4;
+  N = m*n;
+
+  ierr = MatCreate(PETSC_COMM_WORLD,&A);CHKERRQ(ierr);
+  ierr = MatSetSizes(A,PETSC_DECIDE,PETSC_DECIDE,N,N);CHKERRQ(ierr);
+  ierr = MatSetFromOptions(A);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation(A,5,NULL);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetPreallocation(A,5,NULL,2,NULL);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&Istart,&Iend);CHKERRQ(ierr);
+  for (row=Istart; row<Iend; row++) {
+    i = row/n; j = row - i*n;
+    v    = 4.0 + 1.0/(row+3.0);
+    ierr = MatSetValues(A,1,&row,1,&row,&v,INSERT_VALUES);CHKERRQ(ierr);
+    if (i>0)   {col = row-n; v = -1.0; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (i<m-1) {col = row+n; v = -1.0; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j>0)   {col = row-1; v = -1.0-conv; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j<n-1) {col = row+1; v = -1.0+conv; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatCreateVecs(A,&x,&b);CHKERRQ(ierr);
+  ierr = VecDuplicate(b,&r);CHKERRQ(ierr);
+
+  /* columns k-3 and k-2 are combinations of the first two columns, column k-1 is zero */
+  ierr = MatCreateDense(PETSC_COMM_WORLD,Iend-Istart,PETSC_DECIDE,N,k,NULL,&B);CHKERRQ(ierr);
+  ierr = MatCreateDense(PETSC_COMM_WORLD,Iend-Istart,PETSC_DECIDE,N,k,NULL,&X);CHKERRQ(ierr);
+  ierr = MatDenseGetArray(B,&bb);CHKERRQ(ierr);
+  for (c=0; c<k-3; c++) {
+    for (row=Istart; row<Iend; row++) bb[c*(Iend-Istart) + row-Istart] = 1.0/(row+c+1.0) + ((row+3*c)%7);
+  }
+  for (row=0; row<Iend-Istart; row++) {
+    bb[(k-3)*(Iend-Istart) + row] = bb[row] - 2.0*bb[(Iend-Istart) + row];
+    bb[(k-2)*(Iend-Istart) + row] = 3.0*bb[row];
+    bb[(k-1)*(Iend-Istart) + row] = 0.0;
+  }
+  ierr = MatDenseRestoreArray(B,&bb);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(X,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(X,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = KSPCreate(PETSC_COMM_WORLD,&ksp);CHKERRQ(ierr);
+  ierr = KSPSetOperators(ksp,A,A);CHKERRQ(ierr);
+  ierr = KSPSetTolerances(ksp,1.e-10,PETSC_DEFAULT,PETSC_DEFAULT,1000);CHKERRQ(ierr);
+  ierr = KSPSetFromOptions(ksp);CHKERRQ(ierr);
+  ierr = KSPMatSolve(ksp,B,X);CHKERRQ(ierr);
+  ierr = KSPGetConvergedReason(ksp,&reason);CHKERRQ(ierr);
+  if (reason < 0) SETERRQ1(PETSC_COMM_WORLD,PETSC_ERR_PLIB,"KSPMatSolve() did not converge: %s",KSPConvergedReasons[reason]);
+
+  for (c=0; c<k; c++) {
+    ierr = MatGetColumnVector(B,b,c);CHKERRQ(ierr);
+    ierr = MatGetColumnVector(X,x,c);CHKERRQ(ierr);
+    ierr = MatMult(A,x,r);CHKERRQ(ierr);
+    ierr = VecAXPY(r,-1.0,b);CHKERRQ(ierr);
+    ierr = VecNorm(r,NORM_2,&err);CHKERRQ(ierr);
+    ierr = VecNorm(b,NORM_2,&nrm);CHKERRQ(ierr);
+    if (err > 1.e-7*nrm || (nrm == 0.0 && err != 0.0)) SETERRQ2(PETSC_COMM_WORLD,PETSC_ERR_PLIB,"Column %D has relative residual %g",c,(double)(nrm > 0.0 ? err/nrm : err));
+  }
+
+  /* a single right hand side with KSPSolve() */
+  ierr = MatDenseGetColumn(B,0,&cb);CHKERRQ(ierr);
+  ierr = VecGetArray(b,&bb);CHKERRQ(ierr);
+  ierr = PetscMemcpy(bb,cb,(Iend-Istart)*sizeof(PetscScalar));CHKERRQ(ierr);
+  ierr = VecRestoreArray(b,&bb);CHKERRQ(ierr);
+  ierr = MatDenseRestoreColumn(B,&cb);CHKERRQ(ierr);
+  ierr = KSPSolve(ksp,b,x);CHKERRQ(ierr);
+  ierr = MatGetColumnVector(X,r,0);CHKERRQ(ierr);
+  ierr = VecNorm(r,NORM_2,&nrm);CHKERRQ(ierr);
+  ierr = VecAXPY(r,-1.0,x);CHKERRQ(ierr);
+  ierr = VecNorm(r,NORM_2,&err);CHKERRQ(ierr);
+  if (err > 1.e-6*nrm) SETERRQ1(PETSC_COMM_WORLD,PETSC_ERR_PLIB,"KSPSolve() and KSPMatSolve() differ by %g",(double)(err/nrm));
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"All columns solved to the requested accuracy\n");CHKERRQ(ierr);
+
+  ierr = KSPDestroy(&ksp);CHKERRQ(ierr);
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&b);CHKERRQ(ierr);
+  ierr = VecDestroy(&r);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&B);CHKERRQ(ierr);
+  ierr = MatDestroy(&X);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      args: -ksp_type bcg -pc_type jacobi
+
+   test:
+      suffix: 2
+      nsize: 2
+      args: -ksp_type bcg -pc_type jacobi
+      output_file: output/ex58_1.out
+
+   test:
+      suffix: bgmres
+      args: -ksp_type bgmres -nonsym -pc_type jacobi
+
+   test:
+      suffix: bgmres_2
+      nsize: 2
+      args: -ksp_type bgmres -nonsym -pc_type jacobi -ksp_pc_side right -ksp_bgmres_restart 5
+      output_file: output/ex58_bgmres.out
+
+   test:
+      suffix: bgmres_mpiaij
+      args: -ksp_type bgmres -nonsym -pc_type jacobi -mat_type mpiaij -k 9
+      output_file: output/ex58_bgmres.out
+
+   test:
+      suffix: columns
+      nsize: 2
+      args: -ksp_type gmres -nonsym -pc_type jacobi
+      output_file: output/ex58_bgmres.out
+
+TEST*/
@@ -201,4 +201,9 @@ int main(int argc,char **args)
       nsize: 2
       args: -ntimes 4 -ksp_gmres_cgs_refinement_type refine_always
 
+   test:
+      suffix: gcrodr
+      nsize: 2
+      args: -ntimes 4 -m 20 -n 20 -pc_type jacobi -ksp_type gcrodr -ksp_gmres_restart 15 -ksp_gcrodr_recycle 5
+
 TEST*/
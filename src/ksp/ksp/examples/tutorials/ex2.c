@@ -238,6 +238,13 @@ int main(int argc,char **args)
       args: -ksp_monitor_short -m 5 -n 5 -mat_view draw -ksp_gmres_cgs_refinement_type refine_always -nox
       output_file: output/ex2_2.out
 
+   test:
+      suffix: aij_threads
+      nsize: 2
+      requires: openmp
+      args: -ksp_monitor_short -m 5 -n 5 -ksp_gmres_cgs_refinement_type refine_always -mat_aij_threads 2 -mat_no_inode
+      output_file: output/ex2_2.out
+
    test:
       suffix: bjacobi
       nsize: 4
@@ -297,6 +304,56 @@ int main(int argc,char **args)
       args: -ksp_monitor_short -ksp_type pipelcg -m 9 -n 9 -pc_type none -ksp_pipelcg_pipel 2 -ksp_pipelcg_lmax 2
       filter: grep -v "sqrt breakdown in iteration"
 
+   test:
+      suffix: scg
+      args: -ksp_monitor_short -ksp_type scg -m 9 -n 9
+
+   test:
+      suffix: scg_2
+      nsize: 2
+      args: -ksp_monitor_short -ksp_type scg -m 20 -n 20 -pc_type none -ksp_sstep_basis newton -ksp_sstep_s 6 -mat_mpiaij_matrix_powers
+
+   test:
+      suffix: sgmres
+      args: -ksp_monitor_short -ksp_type sgmres -m 9 -n 9 -ksp_gmres_restart 10
+
+   test:
+      suffix: sgmres_2
+      nsize: 2
+      args: -ksp_monitor_short -ksp_type sgmres -m 20 -n 20 -pc_type none -ksp_gmres_restart 12 -ksp_sstep_basis chebyshev -mat_mpiaij_matrix_powers
+
+   test:
+      suffix: sgmres_3
+      args: -ksp_monitor_short -ksp_type sgmres -m 9 -n 9 -ksp_gmres_restart 10 -ksp_sstep_basis monomial -ksp_sstep_s 3 -ksp_sgmres_cholqr2 0
+
+   test:
+      suffix: onereduce
+      args: -ksp_monitor_short -m 9 -n 9 -ksp_gmres_onereducegramschmidt -ksp_type {{gmres fgmres lgmres}separate output}
+
+   test:
+      suffix: onereduce_2
+      nsize: 2
+      args: -m 20 -n 20 -pc_type jacobi -ksp_gmres_onereducegramschmidt -ksp_gmres_cgs_refinement_type {{refine_never refine_ifneeded refine_always}separate output} -ksp_gmres_orthogonality_monitor
+      filter: sed -e "s/orthogonality loss [^ ]* /orthogonality loss /g"
+
+   test:
+      suffix: contiguous
+      args: -ksp_monitor_short -m 9 -n 9 -ksp_gmres_contiguous_basis -ksp_type {{gmres fgmres lgmres}separate output}
+
+   test:
+      suffix: contiguous_2
+      nsize: 2
+      args: -ksp_monitor_short -m 20 -n 20 -pc_type jacobi -ksp_gmres_contiguous_basis -ksp_gmres_onereducegramschmidt -ksp_gmres_cgs_refinement_type refine_always
+
+   test:
+      suffix: pipelgmres
+      args: -ksp_monitor_short -m 9 -n 9 -ksp_type pipelgmres -ksp_pipelgmres_pipel {{1 3}separate output}
+
+   test:
+      suffix: pipelgmres_2
+      nsize: 2
+      args: -ksp_monitor_short -m 20 -n 20 -pc_type jacobi -ksp_type pipelgmres -ksp_pipelgmres_pipel 4 -ksp_gmres_restart 10 -ksp_pipelgmres_lmin 0.01 -ksp_pipelgmres_lmax 2 -ksp_pc_side right
+
    test:
       suffix: sell
       args: -ksp_monitor_short -ksp_gmres_cgs_refinement_type refine_always -m 9 -n 9 -mat_type sell
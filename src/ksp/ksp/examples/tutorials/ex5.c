@@ -353,6 +353,10 @@ int main(int argc,char **args)
       nsize: 2
       args: -ksp_gmres_cgs_refinement_type refine_always -ksp_monitor_lg_residualnorm -ksp_monitor_lg_true_residualnorm
 
+   test:
+      suffix: gcrodr
+      args: -pc_type jacobi -ksp_monitor_short -ksp_type gcrodr -ksp_gmres_restart 10 -ksp_gcrodr_recycle 4
+
    test:
       suffix: asm
       nsize: 4
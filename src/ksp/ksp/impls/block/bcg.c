@@ -0,0 +1,249 @@
+/*
+    Breakdown-free block conjugate gradient method
+*/
+#include <../src/ksp/ksp/impls/block/blockimpl.h>       /*I "petscksp.h" I*/
+
+typedef struct {
+  KSPBLOCKHEADER
+} KSP_BCG;
+
+/*
+   KSPBCGSolve_Private - solves for the k right hand sides in b, the initial guesses and the solutions are in x
+
+   The columns of the residual are scaled to the same initial norm; the search directions are orthonormalized,
+   dropping the directions of the block that have become linearly dependent, so their number p may shrink below k.
+*/
+static PetscErrorCode KSPBCGSolve_Private(KSP ksp,PetscInt k,const PetscScalar *b,PetscScalar *x)
+{
+  KSP_BCG        *bcg = (KSP_BCG*)ksp->data;
+  MPI_Comm       comm = PetscObjectComm((PetscObject)ksp);
+  PetscInt       n = bcg->n,i,j,p;
+  PetscScalar    *R,*Z,*P,*Q,*tmp,*pq,*buf,one = 1.0,mone = -1.0;
+  PetscReal      *scale,rho,rnorm;
+  PetscBLASInt   bn,ldn,bk,bp,info;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBlockGetWork_Private(ksp,k,4);CHKERRQ(ierr);
+  R    = bcg->work;
+  Z    = R + n*k;
+  P    = Z + n*k;
+  Q    = P + n*k;
+  ierr = PetscMalloc3(k*k,&pq,2*k*k+k,&buf,k,&scale);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(n,&bn);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(PetscMax(n,1),&ldn);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(k,&bk);CHKERRQ(ierr);
+
+  /* R = B - A X */
+  ksp->its = 0;
+  if (ksp->guess_zero) {
+    ierr = PetscMemzero(x,n*k*sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = PetscMemcpy(R,b,n*k*sizeof(PetscScalar));CHKERRQ(ierr);
+  } else {
+    ierr = KSPBlockMatMult_Private(ksp,k,x,R);CHKERRQ(ierr);
+    for (i=0; i<n*k; i++) R[i] = b[i] - R[i];
+  }
+  ierr = KSPBlockNormsLocal_Private(ksp,k,R,buf);CHKERRQ(ierr);
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,buf,k,MPIU_SCALAR,MPIU_SUM,comm);CHKERRQ(ierr);
+  rho  = 0.0;
+  for (j=0; j<k; j++) rho = PetscMax(rho,PetscSqrtReal(PetscRealPart(buf[j])));
+  for (j=0; j<k; j++) {
+    scale[j] = PetscRealPart(buf[j]) > 0.0 ? rho/PetscSqrtReal(PetscRealPart(buf[j])) : 1.0;
+    for (i=0; i<n; i++) R[i+j*n] *= scale[j];
+  }
+  ierr = KSPBlockConverged_Private(ksp,k,rho);CHKERRQ(ierr);
+  if (ksp->reason) goto done;
+
+  ierr = KSPBlockPCApply_Private(ksp,k,R,P);CHKERRQ(ierr);
+  ierr = KSPBlockOrthonormalize_Private(ksp,k,P,0.0,&p,NULL,0);CHKERRQ(ierr);
+  while (1) {
+    if (!p) {
+      ierr        = PetscInfo(ksp,"No search direction is left\n");CHKERRQ(ierr);
+      ksp->reason = KSP_DIVERGED_BREAKDOWN;
+      break;
+    }
+    ierr = PetscBLASIntCast(p,&bp);CHKERRQ(ierr);
+    ierr = KSPBlockMatMult_Private(ksp,p,P,Q);CHKERRQ(ierr);
+
+    /* P^H Q and P^H R with one reduction */
+    ierr = KSPBlockDotLocal_Private(ksp,p,P,p,Q,buf,p);CHKERRQ(ierr);
+    ierr = KSPBlockDotLocal_Private(ksp,p,P,k,R,buf+p*p,p);CHKERRQ(ierr);
+    ierr = MPIU_Allreduce(MPI_IN_PLACE,buf,p*(p+k),MPIU_SCALAR,MPIU_SUM,comm);CHKERRQ(ierr);
+    ierr = PetscMemcpy(pq,buf,p*p*sizeof(PetscScalar));CHKERRQ(ierr);
+    PetscStackCallBLAS("LAPACKpotrf",LAPACKpotrf_("U",&bp,pq,&bp,&info));
+    if (info) {
+      ierr        = PetscInfo(ksp,"The block P^H A P is not positive definite\n");CHKERRQ(ierr);
+      ksp->reason = KSP_DIVERGED_INDEFINITE_MAT;
+      break;
+    }
+
+    /* alpha = (P^H Q)^{-1} P^H R, R = R - Q alpha, X = X + P alpha scaled back to the original columns */
+    tmp  = buf + p*p;
+    PetscStackCallBLAS("LAPACKpotrs",LAPACKpotrs_("U",&bp,&bk,pq,&bp,tmp,&bp,&info));
+    if (info) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in LAPACK routine potrs %d",(int)info);
+    PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bn,&bk,&bp,&mone,Q,&ldn,tmp,&bp,&one,R,&ldn));
+    for (j=0; j<k; j++) {
+      for (i=0; i<p; i++) tmp[i+j*p] /= scale[j];
+    }
+    PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bn,&bk,&bp,&one,P,&ldn,tmp,&bp,&one,x,&ldn));
+    ierr = PetscLogFlops(4.0*n*p*k);CHKERRQ(ierr);
+
+    ierr = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+    ksp->its++;
+    ierr = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+    ierr = KSPBlockPCApply_Private(ksp,k,R,Z);CHKERRQ(ierr);
+
+    /* Q^H Z and the norms of the columns of R with one reduction */
+    ierr  = KSPBlockDotLocal_Private(ksp,p,Q,k,Z,buf,p);CHKERRQ(ierr);
+    ierr  = KSPBlockNormsLocal_Private(ksp,k,R,buf+p*k);CHKERRQ(ierr);
+    ierr  = MPIU_Allreduce(MPI_IN_PLACE,buf,p*k+k,MPIU_SCALAR,MPIU_SUM,comm);CHKERRQ(ierr);
+    rnorm = 0.0;
+    for (j=0; j<k; j++) rnorm = PetscMax(rnorm,PetscSqrtReal(PetscRealPart(buf[p*k+j])));
+    ierr = KSPBlockConverged_Private(ksp,k,rnorm);CHKERRQ(ierr);
+    if (ksp->reason) break;
+    if (ksp->its >= ksp->max_it) {
+      ksp->reason = KSP_DIVERGED_ITS;
+      break;
+    }
+
+    /* P = orth(Z + P beta) with beta = -(P^H Q)^{-1} Q^H Z */
+    PetscStackCallBLAS("LAPACKpotrs",LAPACKpotrs_("U",&bp,&bk,pq,&bp,buf,&bp,&info));
+    if (info) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in LAPACK routine potrs %d",(int)info);
+    PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bn,&bk,&bp,&mone,P,&ldn,buf,&bp,&one,Z,&ldn));
+    ierr = PetscLogFlops(2.0*n*p*k);CHKERRQ(ierr);
+    ierr = KSPBlockOrthonormalize_Private(ksp,k,Z,0.0,&p,NULL,0);CHKERRQ(ierr);
+    tmp  = P; P = Z; Z = tmp;
+  }
+
+done:
+  ierr = PetscFree3(pq,buf,scale);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSolve_BCG(KSP ksp)
+{
+  const PetscScalar *b;
+  PetscScalar       *x;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(ksp->vec_rhs,&b);CHKERRQ(ierr);
+  ierr = VecGetArray(ksp->vec_sol,&x);CHKERRQ(ierr);
+  ierr = KSPBCGSolve_Private(ksp,1,b,x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(ksp->vec_sol,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(ksp->vec_rhs,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPMatSolve_BCG(KSP ksp,Mat B,Mat X)
+{
+  KSP_BCG        *bcg = (KSP_BCG*)ksp->data;
+  PetscScalar    *b,*x;
+  PetscInt       k;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(B,NULL,&k);CHKERRQ(ierr);
+  ierr = PetscMalloc2(bcg->n*k,&b,bcg->n*k,&x);CHKERRQ(ierr);
+  ierr = KSPBlockGetDense_Private(ksp,B,b);CHKERRQ(ierr);
+  if (!ksp->guess_zero) {ierr = KSPBlockGetDense_Private(ksp,X,x);CHKERRQ(ierr);}
+  ierr = KSPBCGSolve_Private(ksp,k,b,x);CHKERRQ(ierr);
+  ierr = KSPBlockSetDense_Private(ksp,x,X);CHKERRQ(ierr);
+  ierr = PetscFree2(b,x);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetUp_BCG(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBlockSetUp_Private(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPReset_BCG(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBlockReset_Private(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPDestroy_BCG(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPReset_BCG(ksp);CHKERRQ(ierr);
+  ierr = KSPDestroyDefault(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetFromOptions_BCG(PetscOptionItems *PetscOptionsObject,KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsHead(PetscOptionsObject,"KSP BCG options");CHKERRQ(ierr);
+  ierr = KSPSetFromOptions_Block(PetscOptionsObject,ksp);CHKERRQ(ierr);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*MC
+     KSPBCG - The breakdown-free block conjugate gradient method, which solves for several right hand sides at once
+     with KSPMatSolve()
+
+   Options Database Keys:
+.   -ksp_block_deflation_tol <tol> - relative singular value below which search directions are dropped
+
+   Level: intermediate
+
+   Notes:
+    The operator and the preconditioner must be symmetric (Hermitian) positive definite. Only left preconditioning
+    is supported and the norm used in the convergence test is the 2-norm of the unpreconditioned residual.
+
+    The k right hand sides share one search space: each iteration applies the operator to the block of search
+    directions (with MatMatMult() for AIJ matrices, so the matrix is read once for all the columns) and computes
+    all the inner products of the iteration with two reductions, plus one for the orthonormalization of the search
+    directions. Directions that become linearly dependent, for instance because some right hand sides are linear
+    combinations of the others or because some columns have converged, are dropped, so the method does not break down.
+
+    The columns of the initial residual are scaled to the norm of the largest one; the residual norm passed to the
+    monitors and the convergence test is the largest norm of a scaled column, so the default test stops when every
+    column has been reduced by the relative tolerance. With a single right hand side this is the usual residual norm
+    and the method is the conjugate gradient method with normalized search directions.
+
+    An iteration counts as one iteration for all the columns.
+
+   References:
+.   1. - H. Ji and Y. Li, A breakdown-free block conjugate gradient method, BIT Numerical Mathematics, 2017.
+
+.seealso:  KSPCreate(), KSPSetType(), KSPType (for list of available types), KSP, KSPMatSolve(), KSPCG, KSPBGMRES
+M*/
+PETSC_EXTERN PetscErrorCode KSPCreate_BCG(KSP ksp)
+{
+  KSP_BCG        *bcg;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscNewLog(ksp,&bcg);CHKERRQ(ierr);
+  bcg->deflation_tol = PETSC_SQRT_MACHINE_EPSILON;
+  ksp->data          = (void*)bcg;
+
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_UNPRECONDITIONED,PC_LEFT,3);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_LEFT,1);CHKERRQ(ierr);
+
+  ksp->ops->setup          = KSPSetUp_BCG;
+  ksp->ops->solve          = KSPSolve_BCG;
+  ksp->ops->matsolve       = KSPMatSolve_BCG;
+  ksp->ops->reset          = KSPReset_BCG;
+  ksp->ops->destroy        = KSPDestroy_BCG;
+  ksp->ops->view           = KSPView_Block;
+  ksp->ops->setfromoptions = KSPSetFromOptions_BCG;
+  ksp->ops->buildsolution  = KSPBuildSolutionDefault;
+  ksp->ops->buildresidual  = KSPBuildResidualDefault;
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,375 @@
+/*
+    Block GMRES method with deflation of linearly dependent directions
+*/
+#include <../src/ksp/ksp/impls/block/blockimpl.h>       /*I "petscksp.h" I*/
+
+typedef struct {
+  KSPBLOCKHEADER
+  PetscInt    restart;      /* maximum number of block Arnoldi steps in a cycle */
+  PetscInt    kalloc;       /* number of right hand sides the arrays below are allocated for */
+  PetscInt    restartalloc;
+  PetscScalar *V;           /* orthonormal basis of the block Krylov space, at most (restart+1)*k vectors */
+  PetscScalar *H;           /* block Hessenberg matrix, reduced to triangular form by Householder reflections */
+  PetscScalar *tau;         /* scalar factors of the Householder reflections */
+  PetscScalar *G;           /* right hand sides of the least squares problem, transformed by the reflections */
+  PetscScalar *Y;           /* coefficients of the basis vectors in the update of the solution */
+  PetscScalar *buf;         /* inner products reduced together */
+  PetscInt    *off;         /* off[j] is the first column of the basis belonging to the j-th block */
+} KSP_BGMRES;
+
+#if defined(PETSC_USE_COMPLEX)
+#define KSPBGMRES_ADJOINT "C"
+#else
+#define KSPBGMRES_ADJOINT "T"
+#endif
+
+static PetscErrorCode KSPBGMRESGetWork_Private(KSP ksp,PetscInt k)
+{
+  KSP_BGMRES     *bgmres = (KSP_BGMRES*)ksp->data;
+  PetscInt       nr = (bgmres->restart+1)*k,nc = bgmres->restart*k;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBlockGetWork_Private(ksp,k,2);CHKERRQ(ierr);
+  if (k == bgmres->kalloc && bgmres->restart == bgmres->restartalloc) PetscFunctionReturn(0);
+  ierr = PetscFree7(bgmres->V,bgmres->H,bgmres->tau,bgmres->G,bgmres->Y,bgmres->buf,bgmres->off);CHKERRQ(ierr);
+  ierr = PetscMalloc7(bgmres->n*nr,&bgmres->V,nr*nc,&bgmres->H,nc,&bgmres->tau,nr*k,&bgmres->G,nc*k,&bgmres->Y,nr*k+k,&bgmres->buf,bgmres->restart+2,&bgmres->off);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)ksp,(bgmres->n*nr+nr*nc+nc+nr*k+nc*k+nr*k+k)*sizeof(PetscScalar)+(bgmres->restart+2)*sizeof(PetscInt));CHKERRQ(ierr);
+  bgmres->kalloc       = k;
+  bgmres->restartalloc = bgmres->restart;
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPBGMRESSolve_Private - solves for the k right hand sides in b, the initial guesses and the solutions are in x
+
+   A cycle builds the block Arnoldi basis V with block classical Gram-Schmidt with reorthogonalization; a new block
+   is orthonormalized with KSPBlockOrthonormalize_Private() so it may have fewer columns than the previous one when
+   directions become linearly dependent. The block Hessenberg matrix is reduced to triangular form one block column
+   at a time with Householder reflections, which also give the residual norms of all the columns.
+*/
+static PetscErrorCode KSPBGMRESSolve_Private(KSP ksp,PetscInt k,const PetscScalar *b,PetscScalar *x)
+{
+  KSP_BGMRES     *bgmres = (KSP_BGMRES*)ksp->data;
+  MPI_Comm       comm = PetscObjectComm((PetscObject)ksp);
+  PetscInt       n = bgmres->n,nr = (bgmres->restart+1)*k,i,j,l,c,m,p,pnext,*off = bgmres->off;
+  PetscScalar    *R,*T,*V = bgmres->V,*H = bgmres->H,*G = bgmres->G,*Y = bgmres->Y,*buf = bgmres->buf,*hcol;
+  PetscScalar    one = 1.0,zero = 0.0,mone = -1.0;
+  PetscReal      *scale,rho,rnorm,ref,sum;
+  PetscBool      first = PETSC_TRUE;
+  PetscBLASInt   bn,ldn,bk,bm,bp,bmr,bc,ldh,ldy,info;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  R    = bgmres->work;
+  T    = R + n*k;
+  ierr = PetscMalloc1(k,&scale);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(n,&bn);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(PetscMax(n,1),&ldn);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(k,&bk);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(nr,&ldh);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(PetscMax(bgmres->restart*k,1),&ldy);CHKERRQ(ierr);
+
+  ksp->its = 0;
+  if (ksp->guess_zero) {ierr = PetscMemzero(x,n*k*sizeof(PetscScalar));CHKERRQ(ierr);}
+  while (1) {
+    /* the residual, preconditioned from the left if requested */
+    if (first && ksp->guess_zero) {
+      ierr = PetscMemcpy(T,b,n*k*sizeof(PetscScalar));CHKERRQ(ierr);
+    } else {
+      ierr = KSPBlockMatMult_Private(ksp,k,x,T);CHKERRQ(ierr);
+      for (i=0; i<n*k; i++) T[i] = b[i] - T[i];
+    }
+    if (ksp->pc_side == PC_LEFT) {
+      ierr = KSPBlockPCApply_Private(ksp,k,T,R);CHKERRQ(ierr);
+    } else {
+      ierr = PetscMemcpy(R,T,n*k*sizeof(PetscScalar));CHKERRQ(ierr);
+    }
+    if (first) {
+      ierr = KSPBlockNormsLocal_Private(ksp,k,R,buf);CHKERRQ(ierr);
+      ierr = MPIU_Allreduce(MPI_IN_PLACE,buf,k,MPIU_SCALAR,MPIU_SUM,comm);CHKERRQ(ierr);
+      rho  = 0.0;
+      for (j=0; j<k; j++) rho = PetscMax(rho,PetscSqrtReal(PetscRealPart(buf[j])));
+      for (j=0; j<k; j++) scale[j] = PetscRealPart(buf[j]) > 0.0 ? rho/PetscSqrtReal(PetscRealPart(buf[j])) : 1.0;
+      ierr = KSPBlockConverged_Private(ksp,k,rho);CHKERRQ(ierr);
+      if (ksp->reason) break;
+      first = PETSC_FALSE;
+    }
+    for (j=0; j<k; j++) {
+      for (i=0; i<n; i++) R[i+j*n] *= scale[j];
+    }
+
+    /* V_0 G_0 = R */
+    ierr = PetscMemzero(G,nr*k*sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = PetscMemcpy(V,R,n*k*sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = KSPBlockOrthonormalize_Private(ksp,k,V,0.0,&p,G,nr);CHKERRQ(ierr);
+    if (!p) {
+      ierr        = PetscInfo(ksp,"The residual of the restart is numerically zero\n");CHKERRQ(ierr);
+      ksp->reason = KSP_DIVERGED_BREAKDOWN;
+      break;
+    }
+
+    c      = 0;
+    off[0] = 0;
+    for (j=0; j<bgmres->restart; j++) {
+      m        = c + p;
+      off[j+1] = m;
+      hcol     = H + c*nr;
+
+      /* the next block of vectors is computed in place after the current basis */
+      if (ksp->pc_side == PC_LEFT) {
+        ierr = KSPBlockMatMult_Private(ksp,p,V+c*n,T);CHKERRQ(ierr);
+        ierr = KSPBlockPCApply_Private(ksp,p,T,V+m*n);CHKERRQ(ierr);
+      } else {
+        ierr = KSPBlockPCApply_Private(ksp,p,V+c*n,T);CHKERRQ(ierr);
+        ierr = KSPBlockMatMult_Private(ksp,p,T,V+m*n);CHKERRQ(ierr);
+      }
+
+      /* block classical Gram-Schmidt with reorthogonalization, the first pass also gives the norms of the new vectors */
+      ierr = PetscLogEventBegin(KSP_GMRESOrthogonalization,ksp,0,0,0);CHKERRQ(ierr);
+      ierr = PetscBLASIntCast(m,&bm);CHKERRQ(ierr);
+      ierr = PetscBLASIntCast(p,&bp);CHKERRQ(ierr);
+      ierr = KSPBlockDotLocal_Private(ksp,m,V,p,V+m*n,buf,m);CHKERRQ(ierr);
+      ierr = KSPBlockNormsLocal_Private(ksp,p,V+m*n,buf+m*p);CHKERRQ(ierr);
+      ierr = MPIU_Allreduce(MPI_IN_PLACE,buf,m*p+p,MPIU_SCALAR,MPIU_SUM,comm);CHKERRQ(ierr);
+      ref  = 0.0;
+      for (l=0; l<p; l++) ref = PetscMax(ref,PetscRealPart(buf[m*p+l]));
+      for (l=0; l<p; l++) {
+        for (i=0; i<m; i++) hcol[i+l*nr] = buf[i+l*m];
+      }
+      PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bn,&bp,&bm,&mone,V,&ldn,buf,&bm,&one,V+m*n,&ldn));
+      ierr = KSPBlockDotLocal_Private(ksp,m,V,p,V+m*n,buf,m);CHKERRQ(ierr);
+      ierr = MPIU_Allreduce(MPI_IN_PLACE,buf,m*p,MPIU_SCALAR,MPIU_SUM,comm);CHKERRQ(ierr);
+      for (l=0; l<p; l++) {
+        for (i=0; i<m; i++) hcol[i+l*nr] += buf[i+l*m];
+      }
+      PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bn,&bp,&bm,&mone,V,&ldn,buf,&bm,&one,V+m*n,&ldn));
+      ierr = PetscLogFlops(4.0*n*m*p);CHKERRQ(ierr);
+      ierr = KSPBlockOrthonormalize_Private(ksp,p,V+m*n,ref,&pnext,hcol+m,nr);CHKERRQ(ierr);
+      ierr = PetscLogEventEnd(KSP_GMRESOrthogonalization,ksp,0,0,0);CHKERRQ(ierr);
+
+      /* apply the reflections of the previous block columns, then triangularize this one and update G */
+      for (i=0; i<j; i++) {
+        ierr = PetscBLASIntCast(off[i+2]-off[i],&bmr);CHKERRQ(ierr);
+        ierr = PetscBLASIntCast(off[i+1]-off[i],&bc);CHKERRQ(ierr);
+        PetscStackCallBLAS("LAPACKormqr",LAPACKormqr_("L",KSPBGMRES_ADJOINT,&bmr,&bp,&bc,H+off[i]+off[i]*nr,&ldh,bgmres->tau+off[i],hcol+off[i],&ldh,bgmres->lwork,&bgmres->nlwork,&info));
+        if (info) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in LAPACK routine ormqr %d",(int)info);
+      }
+      ierr = PetscBLASIntCast(p+pnext,&bmr);CHKERRQ(ierr);
+      PetscStackCallBLAS("LAPACKgeqrf",LAPACKgeqrf_(&bmr,&bp,hcol+c,&ldh,bgmres->tau+c,bgmres->lwork,&bgmres->nlwork,&info));
+      if (info) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in LAPACK routine geqrf %d",(int)info);
+      PetscStackCallBLAS("LAPACKormqr",LAPACKormqr_("L",KSPBGMRES_ADJOINT,&bmr,&bk,&bp,hcol+c,&ldh,bgmres->tau+c,G+c,&ldh,bgmres->lwork,&bgmres->nlwork,&info));
+      if (info) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in LAPACK routine ormqr %d",(int)info);
+
+      /* the residual of the least squares problem is in the rows of G below the triangular part */
+      rnorm = 0.0;
+      for (l=0; l<k; l++) {
+        sum = 0.0;
+        for (i=m; i<m+pnext; i++) sum += PetscRealPart(G[i+l*nr]*PetscConj(G[i+l*nr]));
+        rnorm = PetscMax(rnorm,PetscSqrtReal(sum));
+      }
+      c = m;
+      p = pnext;
+
+      ierr = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+      ksp->its++;
+      ierr = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+      ierr = KSPBlockConverged_Private(ksp,k,rnorm);CHKERRQ(ierr);
+      if (ksp->reason) break;
+      if (ksp->its >= ksp->max_it) {
+        ksp->reason = KSP_DIVERGED_ITS;
+        break;
+      }
+      if (!p) {
+        /* the block Krylov space is invariant, the least squares solution is the solution of the system */
+        ierr = PetscInfo1(ksp,"Block Krylov space is invariant after %D vectors\n",c);CHKERRQ(ierr);
+        break;
+      }
+    }
+
+    /* X = X + V Y with R Y = G, scaled back to the original columns; with right preconditioning X = X + B V Y */
+    for (i=0; i<c; i++) {
+      if (H[i+i*nr] == 0.0) {
+        ierr        = PetscInfo1(ksp,"Zero diagonal entry %D in the triangular factor\n",i);CHKERRQ(ierr);
+        ksp->reason = KSP_DIVERGED_BREAKDOWN;
+        c           = i;
+        break;
+      }
+    }
+    if (c) {
+      ierr = PetscBLASIntCast(c,&bc);CHKERRQ(ierr);
+      for (l=0; l<k; l++) {
+        for (i=0; i<c; i++) Y[i+l*ldy] = G[i+l*nr];
+      }
+      PetscStackCallBLAS("BLAStrsm",BLAStrsm_("L","U","N","N",&bc,&bk,&one,H,&ldh,Y,&ldy));
+      for (l=0; l<k; l++) {
+        for (i=0; i<c; i++) Y[i+l*ldy] /= scale[l];
+      }
+      if (ksp->pc_side == PC_LEFT) {
+        PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bn,&bk,&bc,&one,V,&ldn,Y,&ldy,&one,x,&ldn));
+      } else {
+        PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bn,&bk,&bc,&one,V,&ldn,Y,&ldy,&zero,T,&ldn));
+        ierr = KSPBlockPCApply_Private(ksp,k,T,R);CHKERRQ(ierr);
+        for (i=0; i<n*k; i++) x[i] += R[i];
+      }
+      ierr = PetscLogFlops(2.0*n*c*k+1.0*c*c*k);CHKERRQ(ierr);
+    }
+    if (ksp->reason) break;
+  }
+  ierr = PetscFree(scale);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSolve_BGMRES(KSP ksp)
+{
+  const PetscScalar *b;
+  PetscScalar       *x;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBGMRESGetWork_Private(ksp,1);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(ksp->vec_rhs,&b);CHKERRQ(ierr);
+  ierr = VecGetArray(ksp->vec_sol,&x);CHKERRQ(ierr);
+  ierr = KSPBGMRESSolve_Private(ksp,1,b,x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(ksp->vec_sol,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(ksp->vec_rhs,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPMatSolve_BGMRES(KSP ksp,Mat B,Mat X)
+{
+  KSP_BGMRES     *bgmres = (KSP_BGMRES*)ksp->data;
+  PetscScalar    *b,*x;
+  PetscInt       k;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(B,NULL,&k);CHKERRQ(ierr);
+  ierr = KSPBGMRESGetWork_Private(ksp,k);CHKERRQ(ierr);
+  ierr = PetscMalloc2(bgmres->n*k,&b,bgmres->n*k,&x);CHKERRQ(ierr);
+  ierr = KSPBlockGetDense_Private(ksp,B,b);CHKERRQ(ierr);
+  if (!ksp->guess_zero) {ierr = KSPBlockGetDense_Private(ksp,X,x);CHKERRQ(ierr);}
+  ierr = KSPBGMRESSolve_Private(ksp,k,b,x);CHKERRQ(ierr);
+  ierr = KSPBlockSetDense_Private(ksp,x,X);CHKERRQ(ierr);
+  ierr = PetscFree2(b,x);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetUp_BGMRES(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBlockSetUp_Private(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPReset_BGMRES(KSP ksp)
+{
+  KSP_BGMRES     *bgmres = (KSP_BGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBlockReset_Private(ksp);CHKERRQ(ierr);
+  ierr = PetscFree7(bgmres->V,bgmres->H,bgmres->tau,bgmres->G,bgmres->Y,bgmres->buf,bgmres->off);CHKERRQ(ierr);
+  bgmres->kalloc       = 0;
+  bgmres->restartalloc = 0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPDestroy_BGMRES(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPReset_BGMRES(ksp);CHKERRQ(ierr);
+  ierr = KSPDestroyDefault(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetFromOptions_BGMRES(PetscOptionItems *PetscOptionsObject,KSP ksp)
+{
+  KSP_BGMRES     *bgmres = (KSP_BGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsHead(PetscOptionsObject,"KSP BGMRES options");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-ksp_bgmres_restart","Number of block Arnoldi steps before restart","None",bgmres->restart,&bgmres->restart,NULL);CHKERRQ(ierr);
+  if (bgmres->restart < 1) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Restart must be positive");
+  ierr = KSPSetFromOptions_Block(PetscOptionsObject,ksp);CHKERRQ(ierr);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPView_BGMRES(KSP ksp,PetscViewer viewer)
+{
+  KSP_BGMRES     *bgmres = (KSP_BGMRES*)ksp->data;
+  PetscBool      iascii;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerASCIIPrintf(viewer,"  restart=%D block Arnoldi steps\n",bgmres->restart);CHKERRQ(ierr);
+  }
+  ierr = KSPView_Block(ksp,viewer);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*MC
+     KSPBGMRES - The block GMRES method, which solves for several right hand sides at once with KSPMatSolve()
+
+   Options Database Keys:
++   -ksp_bgmres_restart <restart> - the number of block Arnoldi steps before restart
+-   -ksp_block_deflation_tol <tol> - relative singular value below which basis vectors are dropped
+
+   Level: intermediate
+
+   Notes:
+    The k right hand sides share one block Krylov space: each step applies the operator to a block of basis vectors
+    (with MatMatMult() for AIJ matrices, so the matrix is read once for all the columns) and orthogonalizes the new block
+    against the basis with block classical Gram-Schmidt with reorthogonalization, that is with BLAS 3 operations and
+    three reductions. Directions that become linearly dependent, for instance because some right hand sides are linear
+    combinations of the others, are dropped, so a block may have fewer than k columns.
+
+    A cycle stores up to (restart+1)*k basis vectors. Left (the default) and right preconditioning are supported,
+    with the preconditioned and the unpreconditioned residual norm respectively.
+
+    The columns of the initial residual are scaled to the norm of the largest one; the residual norm passed to the
+    monitors and the convergence test is the largest norm of a scaled column, so the default test stops when every
+    column has been reduced by the relative tolerance. With a single right hand side this is the usual residual norm.
+
+    An iteration is one block Arnoldi step for all the columns.
+
+   References:
+.   1. - Y. Saad, Iterative Methods for Sparse Linear Systems, second edition, SIAM, 2003, Section 6.12.
+
+.seealso:  KSPCreate(), KSPSetType(), KSPType (for list of available types), KSP, KSPMatSolve(), KSPGMRES, KSPBCG
+M*/
+PETSC_EXTERN PetscErrorCode KSPCreate_BGMRES(KSP ksp)
+{
+  KSP_BGMRES     *bgmres;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscNewLog(ksp,&bgmres);CHKERRQ(ierr);
+  bgmres->deflation_tol = PETSC_SQRT_MACHINE_EPSILON;
+  bgmres->restart       = 30;
+  ksp->data             = (void*)bgmres;
+
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_PRECONDITIONED,PC_LEFT,3);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_UNPRECONDITIONED,PC_RIGHT,2);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_LEFT,1);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_RIGHT,1);CHKERRQ(ierr);
+
+  ksp->ops->setup          = KSPSetUp_BGMRES;
+  ksp->ops->solve          = KSPSolve_BGMRES;
+  ksp->ops->matsolve       = KSPMatSolve_BGMRES;
+  ksp->ops->reset          = KSPReset_BGMRES;
+  ksp->ops->destroy        = KSPDestroy_BGMRES;
+  ksp->ops->view           = KSPView_BGMRES;
+  ksp->ops->setfromoptions = KSPSetFromOptions_BGMRES;
+  ksp->ops->buildsolution  = KSPBuildSolutionDefault;
+  ksp->ops->buildresidual  = KSPBuildResidualDefault;
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,380 @@
+/*
+    Routines shared by the block Krylov methods KSPBCG and KSPBGMRES: application of the operator and the
+    preconditioner to a block of vectors, block inner products with a single reduction and the rank revealing
+    orthonormalization that deflates linearly dependent directions.
+*/
+#include <../src/ksp/ksp/impls/block/blockimpl.h>       /*I "petscksp.h" I*/
+
+PetscErrorCode KSPBlockSetUp_Private(KSP ksp)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  Mat            A;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PCGetOperators(ksp->pc,&A,NULL);CHKERRQ(ierr);
+  if (!blk->vx) {
+    ierr = MatCreateVecs(A,&blk->vx,&blk->vy);CHKERRQ(ierr);
+    ierr = PetscLogObjectParent((PetscObject)ksp,(PetscObject)blk->vx);CHKERRQ(ierr);
+    ierr = PetscLogObjectParent((PetscObject)ksp,(PetscObject)blk->vy);CHKERRQ(ierr);
+    ierr = VecGetLocalSize(blk->vy,&blk->n);CHKERRQ(ierr);
+  }
+  /* the product with a dense matrix is only worthwhile when it is implemented by a blocked kernel; the MPIAIJ
+     kernel relies on the parallel layout of the scatter of the matrix, which a single process does not have */
+  ierr = PetscObjectTypeCompare((PetscObject)A,MATSEQAIJ,&blk->matmat);CHKERRQ(ierr);
+  if (!blk->matmat) {
+    PetscMPIInt size;
+
+    ierr = MPI_Comm_size(PetscObjectComm((PetscObject)A),&size);CHKERRQ(ierr);
+    if (size > 1) {ierr = PetscObjectTypeCompare((PetscObject)A,MATMPIAIJ,&blk->matmat);CHKERRQ(ierr);}
+  }
+  ierr = MatDestroy(&blk->Xw);CHKERRQ(ierr);
+  ierr = MatDestroy(&blk->Yw);CHKERRQ(ierr);
+  blk->rw = 0;
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode KSPBlockReset_Private(KSP ksp)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecDestroy(&blk->vx);CHKERRQ(ierr);
+  ierr = VecDestroy(&blk->vy);CHKERRQ(ierr);
+  ierr = MatDestroy(&blk->Xw);CHKERRQ(ierr);
+  ierr = MatDestroy(&blk->Yw);CHKERRQ(ierr);
+  ierr = PetscFree(blk->work);CHKERRQ(ierr);
+  ierr = PetscFree7(blk->orthwork,blk->gram,blk->tw,blk->tw2,blk->lwork,blk->eig,blk->rwork);CHKERRQ(ierr);
+  blk->rw    = 0;
+  blk->kmax  = 0;
+  blk->nwork = 0;
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPBlockGetWork_Private - makes sure nwork blocks of k vectors are available in blk->work, together with the
+   work space for the orthonormalization of a block of k vectors
+*/
+PetscErrorCode KSPBlockGetWork_Private(KSP ksp,PetscInt k,PetscInt nwork)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscInt       n = blk->n;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (k <= blk->kmax && nwork <= blk->nwork) PetscFunctionReturn(0);
+  ierr = PetscFree(blk->work);CHKERRQ(ierr);
+  ierr = PetscFree7(blk->orthwork,blk->gram,blk->tw,blk->tw2,blk->lwork,blk->eig,blk->rwork);CHKERRQ(ierr);
+  blk->kmax  = PetscMax(k,blk->kmax);
+  blk->nwork = PetscMax(nwork,blk->nwork);
+  k          = blk->kmax;
+  ierr = PetscBLASIntCast(64*k,&blk->nlwork);CHKERRQ(ierr);
+  ierr = PetscMalloc1(blk->nwork*n*k,&blk->work);CHKERRQ(ierr);
+  ierr = PetscMalloc7(n*k,&blk->orthwork,k*k,&blk->gram,k*k,&blk->tw,k*k,&blk->tw2,blk->nlwork,&blk->lwork,k,&blk->eig,3*k,&blk->rwork);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)ksp,((blk->nwork+1)*n*k+3*k*k+blk->nlwork)*sizeof(PetscScalar)+4*k*sizeof(PetscReal));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* copies the local columns of the dense matrix B into the block b */
+PetscErrorCode KSPBlockGetDense_Private(KSP ksp,Mat B,PetscScalar *b)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscScalar    *col;
+  PetscInt       j,k;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(B,NULL,&k);CHKERRQ(ierr);
+  for (j=0; j<k; j++) {
+    ierr = MatDenseGetColumn(B,j,&col);CHKERRQ(ierr);
+    ierr = PetscMemcpy(b+j*blk->n,col,blk->n*sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = MatDenseRestoreColumn(B,&col);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/* copies the block x into the local columns of the dense matrix X */
+PetscErrorCode KSPBlockSetDense_Private(KSP ksp,const PetscScalar *x,Mat X)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscScalar    *col;
+  PetscInt       j,k;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(X,NULL,&k);CHKERRQ(ierr);
+  for (j=0; j<k; j++) {
+    ierr = MatDenseGetColumn(X,j,&col);CHKERRQ(ierr);
+    ierr = PetscMemcpy(col,x+j*blk->n,blk->n*sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = MatDenseRestoreColumn(X,&col);CHKERRQ(ierr);
+  }
+  ierr = PetscObjectStateIncrease((PetscObject)X);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPBlockMatMult_Private - y = A x for the r vectors of the block x
+
+   For AIJ operators the block is multiplied with MatMatMult(), which streams the matrix once for all the columns;
+   the arrays are placed in dense matrices that are kept until the number of columns changes.
+*/
+PetscErrorCode KSPBlockMatMult_Private(KSP ksp,PetscInt r,const PetscScalar *x,PetscScalar *y)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  Mat            A;
+  PetscInt       j,N;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PCGetOperators(ksp->pc,&A,NULL);CHKERRQ(ierr);
+  if (blk->matmat && r > 1 && !ksp->transpose_solve) {
+    if (r != blk->rw) {
+      PetscBool   seq;
+      PetscScalar *yw;
+
+      ierr = MatDestroy(&blk->Xw);CHKERRQ(ierr);
+      ierr = MatDestroy(&blk->Yw);CHKERRQ(ierr);
+      ierr = PetscObjectTypeCompare((PetscObject)A,MATSEQAIJ,&seq);CHKERRQ(ierr);
+      ierr = MatGetSize(A,NULL,&N);CHKERRQ(ierr);
+      ierr = MatCreate(PetscObjectComm((PetscObject)A),&blk->Xw);CHKERRQ(ierr);
+      ierr = MatSetSizes(blk->Xw,blk->n,PETSC_DECIDE,N,r);CHKERRQ(ierr);
+      ierr = MatSetType(blk->Xw,seq ? MATSEQDENSE : MATMPIDENSE);CHKERRQ(ierr);
+      ierr = MatSeqDenseSetPreallocation(blk->Xw,(PetscScalar*)x);CHKERRQ(ierr);
+      ierr = MatMPIDenseSetPreallocation(blk->Xw,(PetscScalar*)x);CHKERRQ(ierr);
+      ierr = MatAssemblyBegin(blk->Xw,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+      ierr = MatAssemblyEnd(blk->Xw,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+      ierr = MatMatMult(A,blk->Xw,MAT_INITIAL_MATRIX,PETSC_DEFAULT,&blk->Yw);CHKERRQ(ierr);
+      ierr = MatDenseGetArray(blk->Yw,&yw);CHKERRQ(ierr);
+      ierr = PetscMemcpy(y,yw,blk->n*r*sizeof(PetscScalar));CHKERRQ(ierr);
+      ierr = MatDenseRestoreArray(blk->Yw,&yw);CHKERRQ(ierr);
+      ierr = PetscLogObjectParent((PetscObject)ksp,(PetscObject)blk->Xw);CHKERRQ(ierr);
+      ierr = PetscLogObjectParent((PetscObject)ksp,(PetscObject)blk->Yw);CHKERRQ(ierr);
+      blk->rw = r;
+      PetscFunctionReturn(0);
+    }
+    ierr = MatDensePlaceArray(blk->Xw,x);CHKERRQ(ierr);
+    ierr = MatDensePlaceArray(blk->Yw,y);CHKERRQ(ierr);
+    ierr = MatMatMult(A,blk->Xw,MAT_REUSE_MATRIX,PETSC_DEFAULT,&blk->Yw);CHKERRQ(ierr);
+    ierr = MatDenseResetArray(blk->Xw);CHKERRQ(ierr);
+    ierr = MatDenseResetArray(blk->Yw);CHKERRQ(ierr);
+  } else {
+    for (j=0; j<r; j++) {
+      ierr = VecPlaceArray(blk->vx,x+j*blk->n);CHKERRQ(ierr);
+      ierr = VecPlaceArray(blk->vy,y+j*blk->n);CHKERRQ(ierr);
+      ierr = KSP_MatMult(ksp,A,blk->vx,blk->vy);CHKERRQ(ierr);
+      ierr = VecResetArray(blk->vx);CHKERRQ(ierr);
+      ierr = VecResetArray(blk->vy);CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/* y = B x for the r vectors of the block x, where B is the preconditioner */
+PetscErrorCode KSPBlockPCApply_Private(KSP ksp,PetscInt r,const PetscScalar *x,PetscScalar *y)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscInt       j;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (j=0; j<r; j++) {
+    ierr = VecPlaceArray(blk->vy,x+j*blk->n);CHKERRQ(ierr);
+    ierr = VecPlaceArray(blk->vx,y+j*blk->n);CHKERRQ(ierr);
+    ierr = KSP_PCApply(ksp,blk->vy,blk->vx);CHKERRQ(ierr);
+    ierr = VecResetArray(blk->vy);CHKERRQ(ierr);
+    ierr = VecResetArray(blk->vx);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPBlockDotLocal_Private - the local part of the r x s matrix of inner products g = x^H y, stored with leading
+   dimension ldg; the caller sums the contributions of all processes, possibly together with other quantities
+*/
+PetscErrorCode KSPBlockDotLocal_Private(KSP ksp,PetscInt r,const PetscScalar *x,PetscInt s,const PetscScalar *y,PetscScalar *g,PetscInt ldg)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscScalar    one = 1.0,zero = 0.0;
+  PetscBLASInt   n,ldn,br,bs,bldg;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!r || !s) PetscFunctionReturn(0);
+  ierr = PetscBLASIntCast(blk->n,&n);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(PetscMax(blk->n,1),&ldn);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(r,&br);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(s,&bs);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(ldg,&bldg);CHKERRQ(ierr);
+  PetscStackCallBLAS("BLASgemm",BLASgemm_("C","N",&br,&bs,&n,&one,x,&ldn,y,&ldn,&zero,g,&bldg));
+  ierr = PetscLogFlops(2.0*r*s*blk->n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* the local parts of the squared 2-norms of the r vectors of the block x, stored as scalars for a combined reduction */
+PetscErrorCode KSPBlockNormsLocal_Private(KSP ksp,PetscInt r,const PetscScalar *x,PetscScalar *nrm)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscInt       i,j;
+  PetscReal      sum;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (j=0; j<r; j++) {
+    sum = 0.0;
+    for (i=0; i<blk->n; i++) sum += PetscRealPart(x[i+j*blk->n]*PetscConj(x[i+j*blk->n]));
+    nrm[j] = sum;
+  }
+  ierr = PetscLogFlops(2.0*r*blk->n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   One pass of the SVQB orthonormalization: with the eigendecomposition w^H w = V L V^H the columns of w are
+   replaced by w V_J L_J^{-1/2}, where J are the eigenvalues above deflation_tol^2 times the largest eigenvalue (or ref
+   if this is larger). t (p x r) is set to L_J^{1/2} V_J^H so that the original w is w t up to the dropped directions.
+*/
+static PetscErrorCode KSPBlockSVQB_Private(KSP ksp,PetscInt r,PetscScalar *w,PetscReal ref,PetscInt *p,PetscScalar *t,PetscInt ldt,PetscReal *ratio)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscScalar    one = 1.0,zero = 0.0,*c;
+  PetscReal      lmax,thr;
+  PetscInt       a,b,j0;
+  PetscBLASInt   n,ldn,br,bp,info;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  *p     = 0;
+  *ratio = 1.0;
+  if (!r) PetscFunctionReturn(0);
+  ierr = KSPBlockDotLocal_Private(ksp,r,w,r,w,blk->gram,r);CHKERRQ(ierr);
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,blk->gram,r*r,MPIU_SCALAR,MPIU_SUM,PetscObjectComm((PetscObject)ksp));CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(r,&br);CHKERRQ(ierr);
+  ierr = PetscFPTrapPush(PETSC_FP_TRAP_OFF);CHKERRQ(ierr);
+#if defined(PETSC_USE_COMPLEX)
+  PetscStackCallBLAS("LAPACKsyev",LAPACKsyev_("V","U",&br,blk->gram,&br,blk->eig,blk->lwork,&blk->nlwork,blk->rwork,&info));
+#else
+  PetscStackCallBLAS("LAPACKsyev",LAPACKsyev_("V","U",&br,blk->gram,&br,blk->eig,blk->lwork,&blk->nlwork,&info));
+#endif
+  ierr = PetscFPTrapPop();CHKERRQ(ierr);
+  if (info) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in LAPACK routine syev %d",(int)info);
+
+  /* the eigenvalues are in ascending order */
+  lmax = blk->eig[r-1];
+  if (lmax <= 0.0) PetscFunctionReturn(0);
+  thr = blk->deflation_tol*blk->deflation_tol*PetscMax(lmax,ref);
+  for (j0=r; j0>0 && blk->eig[j0-1] > thr; j0--) ;
+  *p = r-j0;
+  if (!*p) PetscFunctionReturn(0);
+  *ratio = blk->eig[j0]/lmax;
+
+  c = blk->gram + j0*r;
+  for (a=0; a<*p; a++) {
+    PetscReal s = 1.0/PetscSqrtReal(blk->eig[j0+a]);
+    for (b=0; b<r; b++) c[b+a*r] *= s;
+  }
+  ierr = PetscBLASIntCast(blk->n,&n);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(PetscMax(blk->n,1),&ldn);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(*p,&bp);CHKERRQ(ierr);
+  PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&n,&bp,&br,&one,w,&ldn,c,&br,&zero,blk->orthwork,&ldn));
+  ierr = PetscMemcpy(w,blk->orthwork,blk->n*(*p)*sizeof(PetscScalar));CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*blk->n*r*(*p));CHKERRQ(ierr);
+  if (t) {
+    for (a=0; a<*p; a++) {
+      for (b=0; b<r; b++) t[a+b*ldt] = blk->eig[j0+a]*PetscConj(c[b+a*r]);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPBlockOrthonormalize_Private - replaces the r vectors of the block w by p <= r orthonormal vectors spanning the
+   same space up to the directions whose singular values are below blk->deflation_tol times the largest singular value
+   (or sqrt(ref) if this is larger)
+
+   If t is given it is set to the p x r matrix (leading dimension ldt) with w_in = w_out t, up to the dropped directions.
+
+   The orthonormalization uses the Gram matrix so it needs a single reduction; its loss of orthogonality grows with the
+   square of the condition number of the kept directions, so a second pass is made when they are badly conditioned.
+*/
+PetscErrorCode KSPBlockOrthonormalize_Private(KSP ksp,PetscInt r,PetscScalar *w,PetscReal ref,PetscInt *p,PetscScalar *t,PetscInt ldt)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscScalar    one = 1.0,zero = 0.0;
+  PetscReal      ratio;
+  PetscInt       p1,i,j;
+  PetscBLASInt   br,bp,bp1,bldt;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPBlockSVQB_Private(ksp,r,w,ref,&p1,blk->tw,PetscMax(r,1),&ratio);CHKERRQ(ierr);
+  if (p1 && ratio < 1.e-4) {
+    ierr = KSPBlockSVQB_Private(ksp,p1,w,0.0,p,blk->tw2,p1,&ratio);CHKERRQ(ierr);
+    if (t && *p) {
+      ierr = PetscBLASIntCast(r,&br);CHKERRQ(ierr);
+      ierr = PetscBLASIntCast(*p,&bp);CHKERRQ(ierr);
+      ierr = PetscBLASIntCast(p1,&bp1);CHKERRQ(ierr);
+      ierr = PetscBLASIntCast(ldt,&bldt);CHKERRQ(ierr);
+      PetscStackCallBLAS("BLASgemm",BLASgemm_("N","N",&bp,&br,&bp1,&one,blk->tw2,&bp1,blk->tw,&br,&zero,t,&bldt));
+    }
+  } else {
+    *p = p1;
+    if (t) {
+      for (j=0; j<r; j++) {
+        for (i=0; i<p1; i++) t[i+j*ldt] = blk->tw[i+j*r];
+      }
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPBlockConverged_Private - logs and monitors the norm of the block residual and runs the convergence test
+
+   With several right hand sides the columns are scaled to the same initial residual norm, so the initial residual,
+   and not the norm of a single right hand side, is the reference of the relative tolerance.
+*/
+PetscErrorCode KSPBlockConverged_Private(KSP ksp,PetscInt k,PetscReal rnorm)
+{
+  PetscBool      guess_zero = ksp->guess_zero;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ksp->rnorm = rnorm;
+  ierr = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ierr = KSPLogResidualHistory(ksp,rnorm);CHKERRQ(ierr);
+  ierr = KSPMonitor(ksp,ksp->its,rnorm);CHKERRQ(ierr);
+  if (PetscIsInfOrNanReal(rnorm)) {
+    ksp->reason = KSP_DIVERGED_NANORINF;
+    PetscFunctionReturn(0);
+  }
+  if (k > 1 && !ksp->its) ksp->guess_zero = PETSC_TRUE;
+  ierr = (*ksp->converged)(ksp,ksp->its,rnorm,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+  ksp->guess_zero = guess_zero;
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode KSPSetFromOptions_Block(PetscOptionItems *PetscOptionsObject,KSP ksp)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsReal("-ksp_block_deflation_tol","Relative singular value below which directions of a block are dropped","None",blk->deflation_tol,&blk->deflation_tol,NULL);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode KSPView_Block(KSP ksp,PetscViewer viewer)
+{
+  KSP_Block      *blk = (KSP_Block*)ksp->data;
+  PetscBool      iascii;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerASCIIPrintf(viewer,"  deflation tolerance %g, %s\n",(double)blk->deflation_tol,blk->matmat ? "operator applied with MatMatMult()" : "operator applied to each column");CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,47 @@
+/*
+   Private data structure shared by the block Krylov methods. The data structures of KSPBCG and KSPBGMRES
+   begin with KSPBLOCKHEADER so the helper routines in block.c can be used by both.
+
+   A block of r vectors is stored column by column in an array with the local length n of the vectors as
+   leading dimension, the layout of the local part of a MATDENSE matrix.
+*/
+#if !defined(__BLOCKIMPL_H)
+#define __BLOCKIMPL_H
+
+#include <petsc/private/kspimpl.h>        /*I "petscksp.h" I*/
+#include <petscblaslapack.h>
+
+#define KSPBLOCKHEADER                                                  \
+  PetscReal   deflation_tol; /* directions with singular values below deflation_tol times the largest are dropped */ \
+  PetscInt    n;             /* local length of the vectors */         \
+  PetscInt    kmax;          /* number of columns the work space below is allocated for */ \
+  PetscInt    nwork;         /* number of blocks of kmax vectors in work */ \
+  PetscScalar *work;         /* nwork blocks of kmax vectors used by the method */ \
+  PetscScalar *orthwork;     /* block of kmax vectors used by KSPBlockOrthonormalize_Private() */ \
+  PetscScalar *gram,*tw,*tw2,*lwork; /* work space for the small dense problems */ \
+  PetscReal   *eig,*rwork;                                              \
+  PetscBLASInt nlwork;                                                  \
+  Vec         vx,vy;         /* vectors into which columns of the blocks are placed */ \
+  PetscBool   matmat;        /* the operator can be applied to a block with MatMatMult() */ \
+  Mat         Xw,Yw;         /* dense matrices into which the blocks are placed for MatMatMult() */ \
+  PetscInt    rw;            /* number of columns of Xw and Yw */
+
+typedef struct {
+  KSPBLOCKHEADER
+} KSP_Block;
+
+PETSC_INTERN PetscErrorCode KSPBlockSetUp_Private(KSP);
+PETSC_INTERN PetscErrorCode KSPBlockReset_Private(KSP);
+PETSC_INTERN PetscErrorCode KSPBlockGetWork_Private(KSP,PetscInt,PetscInt);
+PETSC_INTERN PetscErrorCode KSPBlockGetDense_Private(KSP,Mat,PetscScalar*);
+PETSC_INTERN PetscErrorCode KSPBlockSetDense_Private(KSP,const PetscScalar*,Mat);
+PETSC_INTERN PetscErrorCode KSPBlockMatMult_Private(KSP,PetscInt,const PetscScalar*,PetscScalar*);
+PETSC_INTERN PetscErrorCode KSPBlockPCApply_Private(KSP,PetscInt,const PetscScalar*,PetscScalar*);
+PETSC_INTERN PetscErrorCode KSPBlockDotLocal_Private(KSP,PetscInt,const PetscScalar*,PetscInt,const PetscScalar*,PetscScalar*,PetscInt);
+PETSC_INTERN PetscErrorCode KSPBlockNormsLocal_Private(KSP,PetscInt,const PetscScalar*,PetscScalar*);
+PETSC_INTERN PetscErrorCode KSPBlockOrthonormalize_Private(KSP,PetscInt,PetscScalar*,PetscReal,PetscInt*,PetscScalar*,PetscInt);
+PETSC_INTERN PetscErrorCode KSPBlockConverged_Private(KSP,PetscInt,PetscReal);
+PETSC_INTERN PetscErrorCode KSPSetFromOptions_Block(PetscOptionItems*,KSP);
+PETSC_INTERN PetscErrorCode KSPView_Block(KSP,PetscViewer);
+
+#endif
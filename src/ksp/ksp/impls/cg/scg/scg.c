@@ -0,0 +1,480 @@
+/*
+    This file implements s-step CG, a communication avoiding variant of the preconditioned conjugate gradient method.
+
+    Each outer step computes s basis vectors V = [z, p_1(BA) z, ..., p_{s-1}(BA) z] of the Krylov space of the
+    preconditioned residual z = Br with the three term recurrence of MatMultBasis(), together with U = AV. A single
+    global reduction then provides everything needed to make the block A-conjugate to the previous block and to
+    minimize the A-norm of the error over it:
+
+       B     = D_old^{-1} (AP_old)^H V,    P = V - P_old B,    AP = U - AP_old B,
+       D     = V^H U - B^H D_old B,        alpha = D^{-1} V^H r,
+       x    += P alpha,                    r -= AP alpha.
+
+    Reference: A. T. Chronopoulos and C. W. Gear, s-step iterative methods for symmetric linear systems,
+    J. Comput. Appl. Math. 25 (1989), pp. 153-168.
+*/
+#include <petsc/private/kspimpl.h>      /*I "petscksp.h" I*/
+#include <petscblaslapack.h>
+
+#define SCG_DEFAULT_S 4
+
+typedef struct {
+  PetscInt          s;                /* number of basis vectors computed between two reductions */
+  KSPSStepBasisType basis;            /* polynomial basis used to compute them */
+  PetscBool         powers;           /* the basis is computed with MatMultBasis() on the operator */
+
+  PetscInt          nritz;            /* number of Ritz values known, 0 until the first 2s iterations are done */
+  PetscReal         *ritz;
+  PetscObjectState  Astate,Pstate;    /* state of the operators the Ritz values belong to */
+  PetscReal         *d,*e;            /* Lanczos tridiagonal matrix collected from the first iterations */
+
+  PetscScalar       *a,*b,*c;         /* coefficients of the basis recurrence */
+  Vec               *V,*U,*P,*AP,*Pold,*APold;
+  PetscScalar       *VU,*APV,*Vr;     /* inner products computed by the single reduction */
+  PetscScalar       *D,*Dold,*Y,*B,*alpha;
+} KSP_SCG;
+
+static PetscErrorCode KSPSetUp_SCG(KSP ksp)
+{
+  KSP_SCG        *scg = (KSP_SCG*)ksp->data;
+  PetscInt       s = scg->s;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPSetWorkVecs(ksp,1);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,s+1,&scg->V,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,s,&scg->U,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,s,&scg->P,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,s,&scg->AP,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,s,&scg->Pold,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,s,&scg->APold,0,NULL);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,s+1,scg->V);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,s,scg->U);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,s,scg->P);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,s,scg->AP);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,s,scg->Pold);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,s,scg->APold);CHKERRQ(ierr);
+  ierr = PetscMalloc3(2*s,&scg->ritz,2*s,&scg->d,2*s,&scg->e);CHKERRQ(ierr);
+  ierr = PetscMalloc3(s,&scg->a,s,&scg->b,s,&scg->c);CHKERRQ(ierr);
+  ierr = PetscMalloc3(s*s,&scg->VU,s*s,&scg->APV,s,&scg->Vr);CHKERRQ(ierr);
+  ierr = PetscMalloc5(s*s,&scg->D,s*s,&scg->Dold,s*s,&scg->Y,s*s,&scg->B,s,&scg->alpha);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)ksp,6*s*sizeof(PetscReal)+(3*s+2*s*s+s+4*s*s+s)*sizeof(PetscScalar));CHKERRQ(ierr);
+  scg->nritz = 0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPReset_SCG(KSP ksp)
+{
+  KSP_SCG        *scg = (KSP_SCG*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecDestroyVecs(scg->s+1,&scg->V);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(scg->s,&scg->U);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(scg->s,&scg->P);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(scg->s,&scg->AP);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(scg->s,&scg->Pold);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(scg->s,&scg->APold);CHKERRQ(ierr);
+  ierr = PetscFree3(scg->ritz,scg->d,scg->e);CHKERRQ(ierr);
+  ierr = PetscFree3(scg->a,scg->b,scg->c);CHKERRQ(ierr);
+  ierr = PetscFree3(scg->VU,scg->APV,scg->Vr);CHKERRQ(ierr);
+  ierr = PetscFree5(scg->D,scg->Dold,scg->Y,scg->B,scg->alpha);CHKERRQ(ierr);
+  scg->nritz = 0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPDestroy_SCG(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPReset_SCG(ksp);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetSteps_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetBasisType_C",NULL);CHKERRQ(ierr);
+  ierr = KSPDestroyDefault(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Computes V[0] = Br, V[1],...,V[sb-1] and U[j] = A V[j]
+*/
+static PetscErrorCode KSPSCGBasis_Private(KSP ksp,Mat Amat,Vec R,PetscInt sb)
+{
+  KSP_SCG        *scg = (KSP_SCG*)ksp->data;
+  PetscScalar    *a = scg->a,*b = scg->b,*c = scg->c;
+  Vec            *V = scg->V,*U = scg->U;
+  PetscInt       j;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (scg->powers) {
+    /* B = I, so A V[j] = c_j V[j+1] + a_j V[j] + b_j V[j-1] follows from one more basis vector */
+    ierr = VecCopy(R,V[0]);CHKERRQ(ierr);
+    ierr = MatMultBasis(Amat,V[0],sb,a,b,c,V+1);CHKERRQ(ierr);
+    for (j=0; j<sb; j++) {
+      ierr = VecCopy(V[j+1],U[j]);CHKERRQ(ierr);
+      if (j && b[j] != 0.0) {
+        ierr = VecAXPBYPCZ(U[j],a[j],b[j],c[j],V[j],V[j-1]);CHKERRQ(ierr);
+      } else {
+        ierr = VecAXPBY(U[j],a[j],c[j],V[j]);CHKERRQ(ierr);
+      }
+    }
+    PetscFunctionReturn(0);
+  }
+  ierr = KSP_PCApply(ksp,R,V[0]);CHKERRQ(ierr);
+  for (j=0; j<sb; j++) {
+    ierr = KSP_MatMult(ksp,Amat,V[j],U[j]);CHKERRQ(ierr);
+    if (j == sb-1) break;
+    ierr = KSP_PCApply(ksp,U[j],V[j+1]);CHKERRQ(ierr);
+    if (j && b[j] != 0.0) {
+      ierr = VecAXPBYPCZ(V[j+1],-a[j]/c[j],-b[j]/c[j],1.0/c[j],V[j],V[j-1]);CHKERRQ(ierr);
+    } else if (a[j] != 0.0 || c[j] != 1.0) {
+      ierr = VecAXPBY(V[j+1],-a[j]/c[j],1.0/c[j],V[j]);CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   Computes the Ritz values from the Lanczos tridiagonal matrix of the first n iterations and the coefficients of the basis from them
+*/
+static PetscErrorCode KSPSCGComputeBasis_Private(KSP ksp,PetscInt n)
+{
+  KSP_SCG        *scg = (KSP_SCG*)ksp->data;
+  PetscBLASInt   bn,lierr;
+  PetscReal      sdummy;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (n) {
+    ierr = PetscBLASIntCast(n,&bn);CHKERRQ(ierr);
+    ierr = PetscMemcpy(scg->ritz,scg->d,n*sizeof(PetscReal));CHKERRQ(ierr);
+    ierr = PetscFPTrapPush(PETSC_FP_TRAP_OFF);CHKERRQ(ierr);
+    PetscStackCallBLAS("LAPACKsteqr",LAPACKREALsteqr_("N",&bn,scg->ritz,scg->e+1,&sdummy,&bn,&sdummy,&lierr));
+    ierr = PetscFPTrapPop();CHKERRQ(ierr);
+    if (lierr) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in STEQR Lapack routine %d",(int)lierr);
+    scg->nritz = n;
+    ierr = PetscInfo3(ksp,"Using %D Ritz values in [%g, %g] for the basis\n",n,(double)scg->ritz[0],(double)scg->ritz[n-1]);CHKERRQ(ierr);
+  }
+  ierr = KSPSStepBasisCoefficients_Private(scg->basis,scg->nritz,scg->ritz,NULL,scg->s,scg->a,scg->b,scg->c);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSolve_SCG(KSP ksp)
+{
+  KSP_SCG          *scg = (KSP_SCG*)ksp->data;
+  PetscErrorCode   ierr;
+  PetscInt         s = scg->s,sb,sold = 0,i,j,k,nlan = 0;
+  PetscScalar      *VU = scg->VU,*APV = scg->APV,*Vr = scg->Vr,*D = scg->D,*Dold = scg->Dold,*Y = scg->Y,*B = scg->B,*alpha = scg->alpha,sum,*tmp;
+  PetscReal        dp = 0.0,beta,acur,aold = 0.0;
+  PetscBLASInt     bsb,info;
+  Vec              X,R,*swap;
+  Mat              Amat,Pmat;
+  PetscBool        diagonalscale,lanczos;
+  PetscObjectState Astate,Pstate;
+
+  PetscFunctionBegin;
+  ierr = PCGetDiagonalScale(ksp->pc,&diagonalscale);CHKERRQ(ierr);
+  if (diagonalscale) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_SUP,"Krylov method %s does not support diagonal scaling",((PetscObject)ksp)->type_name);
+
+  X    = ksp->vec_sol;
+  R    = ksp->work[0];
+  ierr = PCGetOperators(ksp->pc,&Amat,&Pmat);CHKERRQ(ierr);
+
+  /* the Ritz values of an earlier solve are kept as long as the operators do not change */
+  ierr = PetscObjectStateGet((PetscObject)Amat,&Astate);CHKERRQ(ierr);
+  ierr = PetscObjectStateGet((PetscObject)Pmat,&Pstate);CHKERRQ(ierr);
+  if (Astate != scg->Astate || Pstate != scg->Pstate) {
+    scg->nritz  = 0;
+    scg->Astate = Astate;
+    scg->Pstate = Pstate;
+  }
+  ierr    = KSPSCGComputeBasis_Private(ksp,0);CHKERRQ(ierr);
+  ierr    = KSPSStepUseMatMultBasis_Private(ksp,&scg->powers);CHKERRQ(ierr);
+  lanczos = (PetscBool)(!scg->nritz && scg->basis != KSP_SSTEP_BASIS_MONOMIAL);
+
+  ksp->its = 0;
+  if (!ksp->guess_zero) {
+    ierr = KSP_MatMult(ksp,Amat,X,R);CHKERRQ(ierr);            /*    r <- b - Ax                       */
+    ierr = VecAYPX(R,-1.0,ksp->vec_rhs);CHKERRQ(ierr);
+  } else {
+    ierr = VecCopy(ksp->vec_rhs,R);CHKERRQ(ierr);              /*    r <- b (x is 0)                   */
+  }
+
+  while (1) {
+    /* until the Ritz values are known CG is run one step at a time, collecting the Lanczos matrix. A block is A-conjugate
+       to all the blocks before the previous one only if it is not larger than the previous one, so it never grows */
+    sb = PetscMin(lanczos ? 1 : s,ksp->max_it - ksp->its);
+    if (sold) sb = PetscMin(sb,sold);
+    sb = PetscMax(sb,1);
+    ierr = KSPSCGBasis_Private(ksp,Amat,R,sb);CHKERRQ(ierr);
+
+    /* the single global reduction of the outer step */
+    for (j=0; j<sb; j++) {
+      ierr = VecMDotBegin(scg->V[j],sb,scg->U,VU+j*sb);CHKERRQ(ierr);
+      if (sold) {ierr = VecMDotBegin(scg->V[j],sold,scg->APold,APV+j*sold);CHKERRQ(ierr);}
+    }
+    ierr = VecMDotBegin(R,sb,scg->V,Vr);CHKERRQ(ierr);
+    if (ksp->normtype == KSP_NORM_UNPRECONDITIONED) {
+      ierr = VecNormBegin(R,NORM_2,&dp);CHKERRQ(ierr);
+    } else if (ksp->normtype == KSP_NORM_PRECONDITIONED) {
+      ierr = VecNormBegin(scg->V[0],NORM_2,&dp);CHKERRQ(ierr);
+    }
+    ierr = PetscCommSplitReductionBegin(PetscObjectComm((PetscObject)R));CHKERRQ(ierr);
+    for (j=0; j<sb; j++) {
+      ierr = VecMDotEnd(scg->V[j],sb,scg->U,VU+j*sb);CHKERRQ(ierr);
+      if (sold) {ierr = VecMDotEnd(scg->V[j],sold,scg->APold,APV+j*sold);CHKERRQ(ierr);}
+    }
+    ierr = VecMDotEnd(R,sb,scg->V,Vr);CHKERRQ(ierr);
+    if (ksp->normtype == KSP_NORM_UNPRECONDITIONED) {
+      ierr = VecNormEnd(R,NORM_2,&dp);CHKERRQ(ierr);
+    } else if (ksp->normtype == KSP_NORM_PRECONDITIONED) {
+      ierr = VecNormEnd(scg->V[0],NORM_2,&dp);CHKERRQ(ierr);
+    } else if (ksp->normtype == KSP_NORM_NATURAL) {
+      KSPCheckDot(ksp,Vr[0]);
+      dp = PetscSqrtReal(PetscAbsScalar(Vr[0]));               /*    dp <- r'*z = r'*B*r               */
+    } else dp = 0.0;
+    KSPCheckNorm(ksp,dp);
+
+    ksp->rnorm = dp;
+    ierr = KSPLogResidualHistory(ksp,dp);CHKERRQ(ierr);
+    ierr = KSPMonitor(ksp,ksp->its,dp);CHKERRQ(ierr);
+    ierr = (*ksp->converged)(ksp,ksp->its,dp,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+    if (ksp->reason) break;
+    if (ksp->its >= ksp->max_it) {
+      ksp->reason = KSP_DIVERGED_ITS;
+      break;
+    }
+
+    /* B = D_old^{-1} APV computed as Y = R_old^{-H} APV and B = R_old^{-1} Y with D_old = R_old^H R_old, so B^H D_old B = Y^H Y */
+    for (j=0; j<sb; j++) {
+      for (i=0; i<sold; i++) {
+        sum = APV[i+j*sold];
+        for (k=0; k<i; k++) sum -= PetscConj(Dold[k+i*sold])*Y[k+j*sold];
+        Y[i+j*sold] = sum/PetscConj(Dold[i+i*sold]);
+      }
+      for (i=sold-1; i>=0; i--) {
+        sum = Y[i+j*sold];
+        for (k=i+1; k<sold; k++) sum -= Dold[i+k*sold]*B[k+j*sold];
+        B[i+j*sold] = sum/Dold[i+i*sold];
+      }
+    }
+
+    /* D = V^H U - B^H D_old B, U^H V = V^H U since A is Hermitian */
+    for (j=0; j<sb; j++) {
+      for (i=0; i<sb; i++) {
+        if (i > j) {D[i+j*sb] = 0.0; continue;}
+        sum = VU[i+j*sb];
+        for (k=0; k<sold; k++) sum -= PetscConj(Y[k+i*sold])*Y[k+j*sold];
+        D[i+j*sb] = sum;
+      }
+    }
+    ierr = PetscBLASIntCast(sb,&bsb);CHKERRQ(ierr);
+#if defined(PETSC_MISSING_LAPACK_POTRF)
+    SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"POTRF - Lapack routine is unavailable.");
+#else
+    ierr = PetscFPTrapPush(PETSC_FP_TRAP_OFF);CHKERRQ(ierr);
+    PetscStackCallBLAS("LAPACKpotrf",LAPACKpotrf_("U",&bsb,D,&bsb,&info));
+    ierr = PetscFPTrapPop();CHKERRQ(ierr);
+#endif
+    if (info < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in POTRF Lapack routine %d",(int)info);
+    if (info == 1) {
+      if (ksp->errorifnotconverged) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"Diverged due to indefinite matrix");
+      ksp->reason = KSP_DIVERGED_INDEFINITE_MAT;
+      ierr        = PetscInfo(ksp,"diverging due to indefinite or negative definite matrix\n");CHKERRQ(ierr);
+      break;
+    } else if (info) {
+      /* the basis is numerically rank deficient, keep its leading part */
+      ierr = PetscInfo2(ksp,"Block of %D basis vectors is numerically rank deficient, keeping %D\n",sb,(PetscInt)info-1);CHKERRQ(ierr);
+      for (j=0; j<info-1; j++) for (i=0; i<=j; i++) D[i+j*(info-1)] = D[i+j*sb];
+      sb = info-1;
+    }
+
+    /* alpha = D^{-1} V^H r */
+    for (i=0; i<sb; i++) {
+      sum = Vr[i];
+      for (k=0; k<i; k++) sum -= PetscConj(D[k+i*sb])*alpha[k];
+      alpha[i] = sum/PetscConj(D[i+i*sb]);
+    }
+    for (i=sb-1; i>=0; i--) {
+      sum = alpha[i];
+      for (k=i+1; k<sb; k++) sum -= D[i+k*sb]*alpha[k];
+      alpha[i] = sum/D[i+i*sb];
+    }
+
+    /* P = V - P_old B, AP = U - AP_old B */
+    for (j=0; j<sb; j++) {
+      ierr = VecCopy(scg->V[j],scg->P[j]);CHKERRQ(ierr);
+      ierr = VecCopy(scg->U[j],scg->AP[j]);CHKERRQ(ierr);
+      if (sold) {
+        for (i=0; i<sold; i++) B[i+j*sold] = -B[i+j*sold];
+        ierr = VecMAXPY(scg->P[j],sold,B+j*sold,scg->Pold);CHKERRQ(ierr);
+        ierr = VecMAXPY(scg->AP[j],sold,B+j*sold,scg->APold);CHKERRQ(ierr);
+      }
+    }
+    ierr = VecMAXPY(X,sb,alpha,scg->P);CHKERRQ(ierr);          /*    x <- x + P alpha                  */
+    for (i=0; i<sb; i++) alpha[i] = -alpha[i];
+    ierr = VecMAXPY(R,sb,alpha,scg->AP);CHKERRQ(ierr);         /*    r <- r - AP alpha                 */
+
+    if (lanczos) {
+      /* with one vector per step the last entry of B (negated above) is the CG beta and -alpha the CG step length */
+      acur = -PetscRealPart(alpha[0]);
+      if (nlan) {
+        beta         = PetscRealPart(B[sold-1]);
+        scg->d[nlan] = 1.0/acur + beta/aold;
+        scg->e[nlan] = PetscSqrtReal(PetscAbsReal(beta))/aold;
+      } else scg->d[nlan] = 1.0/acur;
+      aold = acur;
+      nlan++;
+    }
+
+    ksp->its += sb;
+    if (lanczos) {
+      /* the last s directions, which are A-conjugate, form the previous block so that the first block of s vectors is conjugate to them */
+      PetscInt nk = PetscMin(sold+1,s),first = sold+1-nk;
+      Vec      tp = first ? scg->Pold[0] : scg->Pold[sold],tap = first ? scg->APold[0] : scg->APold[sold];
+      for (i=0; i<nk-1; i++) {scg->Pold[i] = scg->Pold[i+first]; scg->APold[i] = scg->APold[i+first];}
+      scg->Pold[nk-1] = scg->P[0];  scg->P[0]  = tp;
+      scg->APold[nk-1] = scg->AP[0]; scg->AP[0] = tap;
+      sum  = D[0];
+      ierr = PetscMemzero(D,nk*nk*sizeof(PetscScalar));CHKERRQ(ierr);
+      for (i=0; i<nk-1; i++) D[i+i*nk] = Dold[(i+first)+(i+first)*sold];
+      D[nk*nk-1] = sum;
+      sb       = nk;
+    } else {
+      swap = scg->Pold;  scg->Pold  = scg->P;  scg->P  = swap;
+      swap = scg->APold; scg->APold = scg->AP; scg->AP = swap;
+    }
+    tmp  = Dold; Dold = D; D = tmp;
+    sold = sb;
+    if (lanczos && nlan == 2*s) {
+      ierr    = KSPSCGComputeBasis_Private(ksp,nlan);CHKERRQ(ierr);
+      lanczos = PETSC_FALSE;
+    }
+  }
+  if (lanczos && nlan) {ierr = KSPSCGComputeBasis_Private(ksp,nlan);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPView_SCG(KSP ksp,PetscViewer viewer)
+{
+  KSP_SCG        *scg = (KSP_SCG*)ksp->data;
+  PetscErrorCode ierr;
+  PetscBool      iascii,isstring;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERSTRING,&isstring);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerASCIIPrintf(viewer,"  s=%D, %s basis\n",scg->s,KSPSStepBasisTypes[scg->basis]);CHKERRQ(ierr);
+  } else if (isstring) {
+    ierr = PetscViewerStringSPrintf(viewer,"s %D",scg->s);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetFromOptions_SCG(PetscOptionItems *PetscOptionsObject,KSP ksp)
+{
+  KSP_SCG           *scg = (KSP_SCG*)ksp->data;
+  PetscInt          s;
+  KSPSStepBasisType basis;
+  PetscBool         flg;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsHead(PetscOptionsObject,"KSP s-step CG Options");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-ksp_sstep_s","Number of basis vectors computed between two reductions","KSPSStepSetSteps",scg->s,&s,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPSStepSetSteps(ksp,s);CHKERRQ(ierr); }
+  ierr = PetscOptionsEnum("-ksp_sstep_basis","Polynomial basis","KSPSStepSetBasisType",KSPSStepBasisTypes,(PetscEnum)scg->basis,(PetscEnum*)&basis,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPSStepSetBasisType(ksp,basis);CHKERRQ(ierr); }
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSStepSetSteps_SCG(KSP ksp,PetscInt s)
+{
+  KSP_SCG        *scg = (KSP_SCG*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (s < 1) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Number of steps must be positive");
+  if (!ksp->setupstage) {
+    scg->s = s;
+  } else if (scg->s != s) {
+    ierr = KSPReset_SCG(ksp);CHKERRQ(ierr);
+    scg->s          = s;
+    ksp->setupstage = KSP_SETUP_NEW;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSStepSetBasisType_SCG(KSP ksp,KSPSStepBasisType basis)
+{
+  KSP_SCG *scg = (KSP_SCG*)ksp->data;
+
+  PetscFunctionBegin;
+  if (scg->basis != basis) scg->nritz = 0;
+  scg->basis = basis;
+  PetscFunctionReturn(0);
+}
+
+/*MC
+     KSPSCG - Implements s-step CG, a communication avoiding variant of the preconditioned conjugate gradient method
+              that computes s basis vectors between two global reductions.
+
+   Options Database Keys:
++   -ksp_sstep_s <s> - the number of basis vectors computed at once, see KSPSStepSetSteps()
+-   -ksp_sstep_basis <monomial,newton,chebyshev> - the polynomial basis, see KSPSStepSetBasisType()
+
+   Level: intermediate
+
+   Notes:
+    The operator and the preconditioner must be symmetric (Hermitian) positive definite, as for KSPCG.
+
+    Each outer step costs s applications of the operator and the preconditioner and one global reduction, against s
+    iterations of KSPCG with two reductions each. The residual norm is monitored once per outer step, so KSPGetIterationNumber()
+    advances by s. A basis that is numerically rank deficient is shrunk automatically.
+    With the Newton and Chebyshev bases the first 2s iterations are run one at a time to obtain Ritz values from the
+    Lanczos matrix; they are kept for later solves while the operators do not change.
+
+    When no preconditioner is used (PCNONE) the basis is computed with MatMultBasis(), so for MATMPIAIJ with
+    -mat_mpiaij_matrix_powers the s products need a single exchange of ghost values.
+
+   References:
+.     1. - A. T. Chronopoulos and C. W. Gear, s-step iterative methods for symmetric linear systems,
+           J. Comput. Appl. Math. 25 (1989), pp. 153-168.
+
+.seealso:  KSPCreate(), KSPSetType(), KSPType (for list of available types), KSP, KSPCG, KSPPIPECG, KSPPIPELCG, KSPSGMRES,
+           KSPSStepSetSteps(), KSPSStepSetBasisType(), MatMultBasis()
+M*/
+
+PETSC_EXTERN PetscErrorCode KSPCreate_SCG(KSP ksp)
+{
+  KSP_SCG        *scg;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr      = PetscNewLog(ksp,&scg);CHKERRQ(ierr);
+  ksp->data = (void*)scg;
+
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_PRECONDITIONED,PC_LEFT,3);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_UNPRECONDITIONED,PC_LEFT,2);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NATURAL,PC_LEFT,2);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_LEFT,1);CHKERRQ(ierr);
+
+  ksp->ops->setup          = KSPSetUp_SCG;
+  ksp->ops->solve          = KSPSolve_SCG;
+  ksp->ops->reset          = KSPReset_SCG;
+  ksp->ops->destroy        = KSPDestroy_SCG;
+  ksp->ops->view           = KSPView_SCG;
+  ksp->ops->setfromoptions = KSPSetFromOptions_SCG;
+  ksp->ops->buildsolution  = KSPBuildSolutionDefault;
+  ksp->ops->buildresidual  = KSPBuildResidualDefault;
+
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetSteps_C",KSPSStepSetSteps_SCG);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetBasisType_C",KSPSStepSetBasisType_SCG);CHKERRQ(ierr);
+
+  scg->s     = SCG_DEFAULT_S;
+  scg->basis = KSP_SSTEP_BASIS_CHEBYSHEV;
+  PetscFunctionReturn(0);
+}
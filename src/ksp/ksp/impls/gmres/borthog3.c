@@ -0,0 +1,185 @@
+/*
+    Routines used for the orthogonalization of the Hessenberg matrix with a single global reduction.
+
+    Note that for the complex numbers version, the VecDot() and
+    VecMDot() arguments within the code MUST remain in the order
+    given for correct computation of inner products.
+*/
+#include <../src/ksp/ksp/impls/gmres/gmresimpl.h>
+
+/*
+   The inner products of classical Gram-Schmidt: those with the basis and the squared norm of the new direction come from
+   the same VecMDot(), since the new direction follows the basis in the array of vectors. They are added to the Hessenberg
+   matrix and their negatives are left in orthogwork for the update of the new direction.
+*/
+static PetscErrorCode KSPGMRESOneReduceDots_Private(KSP ksp,PetscInt it,PetscReal *wnrm2,PetscReal *hnrm2)
+{
+  KSP_GMRES      *gmres = (KSP_GMRES*)(ksp->data);
+  PetscErrorCode ierr;
+  PetscInt       j;
+  PetscScalar    *hh = HH(0,it),*hes = HES(0,it),*lhh = gmres->orthogwork;
+
+  PetscFunctionBegin;
+  *wnrm2 = *hnrm2 = 0.0;  /* also on the early return of KSPCheckDot() */
+  ierr = VecMDot(VEC_VV(it+1),it+2,&(VEC_VV(0)),lhh);CHKERRQ(ierr); /* <v,vnew> and <vnew,vnew> */
+  for (j=0; j<=it+1; j++) KSPCheckDot(ksp,lhh[j]);
+  *wnrm2 = PetscRealPart(lhh[it+1]);
+  for (j=0; j<=it; j++) {
+    *hnrm2 += PetscRealPart(lhh[j]*PetscConj(lhh[j]));
+    hh[j]   = lhh[j];
+    hes[j]  = lhh[j];
+    lhh[j]  = -lhh[j];
+  }
+  PetscFunctionReturn(0);
+}
+
+/*@C
+     KSPGMRESOneReduceGramSchmidtOrthogonalization - Classical Gram-Schmidt orthogonalization that needs a single global
+                reduction per iteration, including the norm of the new direction
+
+     Collective on KSP
+
+  Input Parameters:
++   ksp - KSP object, must be associated with GMRES, FGMRES, or LGMRES Krylov method
+-   its - one less then the current GMRES restart iteration, i.e. the size of the Krylov space
+
+   Options Database Keys:
++   -ksp_gmres_onereducegramschmidt - Activates KSPGMRESOneReduceGramSchmidtOrthogonalization()
+-   -ksp_gmres_cgs_refinement_type <refine_never,refine_ifneeded,refine_always> - determine if a second pass is made
+
+    Notes:
+    The inner products with the basis and the norm of the new direction are computed together, and the norm of the
+    orthogonalized direction follows from Pythagoras, ||w - V h||^2 = ||w||^2 - ||h||^2. GMRES, FGMRES and LGMRES use this
+    norm instead of computing it with a second reduction, so classical Gram-Schmidt without refinement costs one reduction
+    per iteration instead of two.
+
+    With KSP_GMRES_CGS_REFINE_IFNEEDED (the default) a second pass, with a second reduction, is made when more than half
+    of ||w||^2 cancelled, which is also when the Pythagorean norm would lose accuracy; this costs two reductions per iteration
+    in the worst case instead of four. KSP_GMRES_CGS_REFINE_ALWAYS always makes the second pass and KSP_GMRES_CGS_REFINE_NEVER
+    never does, but then the norm is computed directly when the cancellation is so severe that the Pythagorean norm is
+    meaningless.
+
+    Since the second pass is decided before the update of the first, that update and the inner products of the second pass
+    are done by VecMAXPYMDot(), so an iteration with a second pass reads the Krylov basis three times instead of four. With
+    -ksp_gmres_contiguous_basis the remaining VecMDot() and VecMAXPY() read the new direction only once.
+
+    Use KSPGMRESMonitorOrthogonality() to follow the loss of orthogonality of the Krylov basis and the number of second passes.
+
+   Level: intermediate
+
+.seealso:  KSPGMRESSetOrthogonalization(), KSPGMRESClassicalGramSchmidtOrthogonalization(), KSPGMRESSetCGSRefinementType(),
+           KSPGMRESGetCGSRefinementType(), KSPGMRESGetOrthogonalization(), KSPGMRESMonitorOrthogonality(), VecMAXPYMDot()
+
+@*/
+PetscErrorCode  KSPGMRESOneReduceGramSchmidtOrthogonalization(KSP ksp,PetscInt it)
+{
+  KSP_GMRES      *gmres = (KSP_GMRES*)(ksp->data);
+  PetscErrorCode ierr;
+  PetscInt       j;
+  PetscScalar    *hh,*hes,*lhh;
+  PetscReal      wnrm2,hnrm2,nrm2,wnrm;
+  PetscBool      refine = (PetscBool)(gmres->cgstype == KSP_GMRES_CGS_REFINE_ALWAYS);
+
+  PetscFunctionBegin;
+  ierr = PetscLogEventBegin(KSP_GMRESOrthogonalization,ksp,0,0,0);CHKERRQ(ierr);
+  if (!gmres->orthogwork) {
+    ierr = PetscMalloc1(gmres->max_k + 2,&gmres->orthogwork);CHKERRQ(ierr);
+  }
+  if (!it && !ksp->its) gmres->nreorth = 0;
+  lhh = gmres->orthogwork;
+  hh  = HH(0,it);
+  hes = HES(0,it);
+
+  ierr = KSPGMRESOneReduceDots_Private(ksp,it,&wnrm2,&hnrm2);CHKERRQ(ierr);
+  nrm2 = wnrm2 - hnrm2;
+  if (gmres->cgstype == KSP_GMRES_CGS_REFINE_IFNEEDED && nrm2 < 0.5*wnrm2) {
+    refine = PETSC_TRUE;
+    ierr   = PetscInfo2(ksp,"Performing iterative refinement wnorm %g hnorm %g\n",(double)PetscSqrtReal(PetscMax(nrm2,0.0)),(double)PetscSqrtReal(hnrm2));CHKERRQ(ierr);
+  }
+  if (refine) {
+    /* update of the first pass fused with the inner products of the second, which are accumulated through hes */
+    ierr  = VecMAXPYMDot(VEC_VV(it+1),it+1,lhh,&VEC_VV(0),hes,&wnrm);CHKERRQ(ierr);
+    hnrm2 = 0.0;
+    for (j=0; j<=it; j++) {
+      KSPCheckDot(ksp,hes[j]);
+      hnrm2  += PetscRealPart(hes[j]*PetscConj(hes[j]));
+      hh[j]  += hes[j];
+      lhh[j]  = -hes[j];
+      hes[j]  = hh[j];
+    }
+    ierr = VecMAXPY(VEC_VV(it+1),it+1,lhh,&VEC_VV(0));CHKERRQ(ierr);
+    gmres->nreorth++;
+    /* the direction left after the first pass is nearly orthogonal, so little cancels in the second */
+    gmres->orthognorm = PetscSqrtReal(PetscMax(wnrm*wnrm - hnrm2,0.0));
+  } else if (nrm2 > PETSC_SQRT_MACHINE_EPSILON*wnrm2) {
+    ierr = VecMAXPY(VEC_VV(it+1),it+1,lhh,&VEC_VV(0));CHKERRQ(ierr);
+    gmres->orthognorm = PetscSqrtReal(nrm2);
+  } else {
+    /* the Pythagorean norm is dominated by rounding errors, compute the norm during the update */
+    ierr = VecMAXPYMDot(VEC_VV(it+1),it+1,lhh,&VEC_VV(0),NULL,&gmres->orthognorm);CHKERRQ(ierr);
+  }
+  ierr = PetscLogEventEnd(KSP_GMRESOrthogonalization,ksp,0,0,0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@C
+   KSPGMRESMonitorOrthogonality - Prints the residual norm together with the loss of orthogonality of the Krylov basis
+   of GMRES, FGMRES or LGMRES
+
+   Collective on KSP
+
+   Input Parameters:
++  ksp - the KSP context
+.  its - iteration number
+.  fgnorm - 2-norm of residual (or gradient)
+-  dummy - a viewer
+
+   Options Database Key:
+.   -ksp_gmres_orthogonality_monitor - Activates KSPGMRESMonitorOrthogonality()
+
+   Notes:
+   The loss of orthogonality is max(|<v_j,v_k>|, |<v_k,v_k> - 1|) over the basis vectors v_j, j < k, where v_k is the newest
+   basis vector; it is computed with an extra global reduction. The number of second orthogonalization passes made by
+   KSPGMRESOneReduceGramSchmidtOrthogonalization() in the solve is also printed.
+
+   Level: intermediate
+
+.keywords: KSP, GMRES, monitor, orthogonality
+
+.seealso: KSPMonitorSet(), KSPMonitorDefault(), KSPGMRESOneReduceGramSchmidtOrthogonalization(), KSPGMRESSetCGSRefinementType()
+@*/
+PetscErrorCode KSPGMRESMonitorOrthogonality(KSP ksp,PetscInt its,PetscReal fgnorm,PetscViewerAndFormat *dummy)
+{
+  KSP_GMRES      *gmres = (KSP_GMRES*)ksp->data;
+  PetscViewer    viewer = dummy->viewer;
+  PetscScalar    *dots;
+  PetscReal      loss;
+  PetscInt       j,k;
+  PetscBool      isgmres;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,4);
+  ierr = PetscObjectTypeCompareAny((PetscObject)ksp,&isgmres,KSPGMRES,KSPFGMRES,KSPLGMRES,"");CHKERRQ(ierr);
+  ierr = PetscViewerPushFormat(viewer,dummy->format);CHKERRQ(ierr);
+  ierr = PetscViewerASCIIAddTab(viewer,((PetscObject)ksp)->tablevel);CHKERRQ(ierr);
+  if (!isgmres || !gmres->vecs) {
+    ierr = PetscViewerASCIIPrintf(viewer,"%3D KSP Residual norm %14.12e \n",its,(double)fgnorm);CHKERRQ(ierr);
+  } else {
+    /* the newest basis vector; after a happy breakdown it is not normalized and is left out */
+    k    = gmres->it+1;
+    if (k && (ksp->reason == KSP_CONVERGED_HAPPY_BREAKDOWN || ksp->reason == KSP_DIVERGED_BREAKDOWN)) k--;
+    loss = 0.0;
+    if (k) {
+      ierr = PetscMalloc1(k+1,&dots);CHKERRQ(ierr);
+      ierr = VecMDot(VEC_VV(k),k+1,&VEC_VV(0),dots);CHKERRQ(ierr);
+      loss = PetscAbsScalar(dots[k]-1.0);
+      for (j=0; j<k; j++) loss = PetscMax(loss,PetscAbsScalar(dots[j]));
+      ierr = PetscFree(dots);CHKERRQ(ierr);
+    }
+    ierr = PetscViewerASCIIPrintf(viewer,"%3D KSP Residual norm %14.12e orthogonality loss %g reorthogonalizations %D\n",its,(double)fgnorm,(double)loss,gmres->nreorth);CHKERRQ(ierr);
+  }
+  ierr = PetscViewerASCIISubtractTab(viewer,((PetscObject)ksp)->tablevel);CHKERRQ(ierr);
+  ierr = PetscViewerPopFormat(viewer);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,870 @@
+/*
+    This file implements GCRO-DR, a restarted GMRES that recycles a subspace from one linear solve to the next.
+
+    The method keeps k vectors U and C = A U with C^H C = I. Each cycle projects the residual onto the complement
+    of range(C) and runs Arnoldi with (I - C C^H) A, which gives
+
+       A V_j = C B_j + V_{j+1} H_j,   B_j = C^H A V_j,
+
+    so the least squares problem is the one of GMRES with H_j and the correction to the solution is (V_j - U B_j) y.
+    At the end of each cycle U and C are replaced by the k harmonic Ritz vectors of smallest magnitude from the
+    augmented space [U V_j]. They are kept when KSPSolve() returns and used by the next solve. If the operators have
+    changed, C = A U is recomputed first, which costs k applications of the operator.
+
+    Reference: M. L. Parks, E. de Sturler, G. Mackey, D. D. Johnson and S. Maiti, Recycling Krylov subspaces for
+    sequences of linear systems, SIAM J. Sci. Comput., 28(5), 2006.
+*/
+#define KSPGMRES_NO_MACROS
+#include <../src/ksp/ksp/impls/gmres/gmresimpl.h>       /*I  "petscksp.h"  I*/
+#include <petscblaslapack.h>
+
+#define GCRODR_DEFAULT_MAXK    30
+#define GCRODR_DEFAULT_RECYCLE 10
+
+typedef struct {
+  KSPGMRESHEADER
+
+  PetscInt         kmax;            /* maximum dimension of the recycled subspace */
+  PetscInt         k;               /* current dimension of the recycled subspace */
+  Vec              *U,*C;           /* the recycled subspace and its image C = A U, with C^H C = I */
+  Vec              *Unew,*Cnew;     /* used to update them at the end of a cycle */
+  PetscObjectState Astate,Pstate;   /* state of the operators C was computed with */
+
+  PetscInt         kproj;           /* number of coefficients in alpha not yet added to the solution */
+  PetscScalar      *alpha;          /* C^H r of the projection at the start of the cycle */
+  PetscScalar      *B;              /* C^H A V of the cycle */
+  PetscScalar      *coef;           /* coefficients for VecMAXPY() */
+  PetscScalar      *dots;           /* inner products of U with C and V */
+  PetscReal        *d;              /* norms of U */
+
+  /* dense work space of the harmonic Ritz problem, whose dimension is at most max_k */
+  PetscScalar      *G,*W,*QG,*RG,*X,*VR,*GP,*R,*T,*work,*eigr;
+  PetscReal        *eigi,*rwork,*modul;
+  PetscInt         *perm;
+} KSP_GCRODR;
+
+#define HH(a,b)  (gcrodr->hh_origin + (b)*(gcrodr->max_k+2)+(a))
+#define HES(a,b) (gcrodr->hes_origin + (b)*(gcrodr->max_k+1)+(a))
+#define CC(a)    (gcrodr->cc_origin + (a))
+#define SS(a)    (gcrodr->ss_origin + (a))
+#define GRS(a)   (gcrodr->rs_origin + (a))
+#define BB(a,b)  (gcrodr->B + (b)*gcrodr->kmax+(a))
+
+/* vector names, the same layout as KSPGMRES */
+#define VEC_OFFSET     2
+#define VEC_TEMP       gcrodr->vecs[0]
+#define VEC_TEMP_MATOP gcrodr->vecs[1]
+#define VEC_VV(i)      gcrodr->vecs[VEC_OFFSET+i]
+
+static PetscErrorCode KSPGCRODRUpdateHessenberg(KSP,PetscInt,PetscBool,PetscReal*);
+static PetscErrorCode KSPGCRODRBuildSoln(PetscScalar*,Vec,Vec,KSP,PetscInt);
+
+static PetscErrorCode KSPSetUp_GCRODR(KSP ksp)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscInt       M = gcrodr->max_k,K = gcrodr->kmax;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (K >= M) SETERRQ2(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_INCOMP,"The dimension of the recycled subspace %D must be smaller than the restart %D",K,M);
+  ierr = KSPSetUp_GMRES(ksp);CHKERRQ(ierr);
+  gcrodr->k     = 0;
+  gcrodr->kproj = 0;
+  if (!K) PetscFunctionReturn(0);
+
+  ierr = KSPCreateVecs(ksp,K,&gcrodr->U,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,K,&gcrodr->C,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,K,&gcrodr->Unew,0,NULL);CHKERRQ(ierr);
+  ierr = KSPCreateVecs(ksp,K,&gcrodr->Cnew,0,NULL);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,K,gcrodr->U);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,K,gcrodr->C);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,K,gcrodr->Unew);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,K,gcrodr->Cnew);CHKERRQ(ierr);
+
+  ierr = PetscMalloc5(K,&gcrodr->alpha,K*M,&gcrodr->B,K+M+1,&gcrodr->coef,(M+1)*K,&gcrodr->dots,K,&gcrodr->d);CHKERRQ(ierr);
+  ierr = PetscMalloc7((M+1)*M,&gcrodr->G,(M+1)*M,&gcrodr->W,(M+1)*M,&gcrodr->QG,M*M,&gcrodr->RG,M*M,&gcrodr->X,M*M,&gcrodr->VR,(M+1)*K,&gcrodr->GP);CHKERRQ(ierr);
+  ierr = PetscMalloc5(K*K,&gcrodr->R,M*K,&gcrodr->T,5*M,&gcrodr->work,M,&gcrodr->eigr,M,&gcrodr->eigi);CHKERRQ(ierr);
+  ierr = PetscMalloc3(2*M,&gcrodr->rwork,M,&gcrodr->modul,M,&gcrodr->perm);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)ksp,(K*(2+2*M+K+2)+M+1+(M+1)*(3*M+K)+3*M*M+M*K+6*M)*sizeof(PetscScalar)+(K+4*M)*sizeof(PetscReal)+M*sizeof(PetscInt));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   QR factorization of the n x k matrix A by Gram-Schmidt with reorthogonalization; Q overwrites A. Only the
+   leading rank columns are independent to working precision.
+*/
+static PetscErrorCode KSPGCRODRDenseQR_Private(PetscInt n,PetscInt k,PetscScalar *A,PetscInt lda,PetscScalar *R,PetscInt ldr,PetscInt *rank)
+{
+  PetscInt    i,j,l,pass;
+  PetscScalar h;
+  PetscReal   nrm0,nrm;
+
+  PetscFunctionBegin;
+  for (j=0; j<k; j++) {
+    for (i=0; i<k; i++) R[i+j*ldr] = 0.0;
+    nrm0 = 0.0;
+    for (l=0; l<n; l++) nrm0 += PetscRealPart(PetscConj(A[l+j*lda])*A[l+j*lda]);
+    for (pass=0; pass<2; pass++) {
+      for (i=0; i<j; i++) {
+        h = 0.0;
+        for (l=0; l<n; l++) h += PetscConj(A[l+i*lda])*A[l+j*lda];
+        for (l=0; l<n; l++) A[l+j*lda] -= h*A[l+i*lda];
+        R[i+j*ldr] += h;
+      }
+    }
+    nrm = 0.0;
+    for (l=0; l<n; l++) nrm += PetscRealPart(PetscConj(A[l+j*lda])*A[l+j*lda]);
+    nrm0 = PetscSqrtReal(nrm0);
+    nrm  = PetscSqrtReal(nrm);
+    if (nrm == 0.0 || nrm <= PETSC_SQRT_MACHINE_EPSILON*nrm0) break;
+    R[j+j*ldr] = nrm;
+    for (l=0; l<n; l++) A[l+j*lda] /= nrm;
+  }
+  *rank = j;
+  PetscFunctionReturn(0);
+}
+
+/*
+   Recomputes C = A U for new operators and makes C orthonormal again, applying the same transformation to U.
+   Vectors of U that have become dependent are dropped.
+*/
+static PetscErrorCode KSPGCRODRRecomputeC_Private(KSP ksp)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  Vec            *U = gcrodr->U,*C = gcrodr->C,t;
+  PetscScalar    *coef = gcrodr->coef;
+  PetscInt       i,j,kk,pass;
+  PetscReal      nrm0,nrm;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (j=0; j<gcrodr->k; j++) {
+    ierr = KSP_PCApplyBAorAB(ksp,U[j],C[j],VEC_TEMP_MATOP);CHKERRQ(ierr);
+  }
+  for (j=0,kk=0; j<gcrodr->k; j++) {
+    if (kk < j) {
+      t = U[kk]; U[kk] = U[j]; U[j] = t;
+      t = C[kk]; C[kk] = C[j]; C[j] = t;
+    }
+    ierr = VecNorm(C[kk],NORM_2,&nrm0);CHKERRQ(ierr);
+    for (pass=0; pass<2 && kk; pass++) {
+      ierr = VecMDot(C[kk],kk,C,coef);CHKERRQ(ierr);
+      for (i=0; i<kk; i++) coef[i] = -coef[i];
+      ierr = VecMAXPY(C[kk],kk,coef,C);CHKERRQ(ierr);
+      ierr = VecMAXPY(U[kk],kk,coef,U);CHKERRQ(ierr);
+    }
+    ierr = VecNorm(C[kk],NORM_2,&nrm);CHKERRQ(ierr);
+    if (nrm == 0.0 || nrm <= PETSC_SQRT_MACHINE_EPSILON*nrm0) {
+      ierr = PetscInfo1(ksp,"Dropping recycled vector %D that is dependent for the new operator\n",j);CHKERRQ(ierr);
+      continue;
+    }
+    ierr = VecScale(C[kk],1.0/nrm);CHKERRQ(ierr);
+    ierr = VecScale(U[kk],1.0/nrm);CHKERRQ(ierr);
+    kk++;
+  }
+  gcrodr->k = kk;
+  PetscFunctionReturn(0);
+}
+
+/*
+   Removes the component of the residual in VEC_VV(0) in range(C), which is the minimal residual correction from
+   range(U). At the start of a solve this counts as an iteration, so the convergence test is relative to the true
+   initial residual. At later restarts the residual is already orthogonal to C up to rounding.
+*/
+static PetscErrorCode KSPGCRODRProject_Private(KSP ksp)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscInt       i,k = gcrodr->k;
+  PetscReal      res;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  gcrodr->it    = -1;
+  gcrodr->kproj = 0;
+  if (!k) PetscFunctionReturn(0);
+  if (!ksp->its) {
+    ierr = VecMDotBegin(VEC_VV(0),k,gcrodr->C,gcrodr->alpha);CHKERRQ(ierr);
+    ierr = VecNormBegin(VEC_VV(0),NORM_2,&res);CHKERRQ(ierr);
+    ierr = PetscCommSplitReductionBegin(PetscObjectComm((PetscObject)VEC_VV(0)));CHKERRQ(ierr);
+    ierr = VecMDotEnd(VEC_VV(0),k,gcrodr->C,gcrodr->alpha);CHKERRQ(ierr);
+    ierr = VecNormEnd(VEC_VV(0),NORM_2,&res);CHKERRQ(ierr);
+    KSPCheckNorm(ksp,res);
+    ierr       = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+    ksp->rnorm = res;
+    ierr       = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+    ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+    ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+    if (!res) {
+      ksp->reason = KSP_CONVERGED_ATOL;
+      ierr        = PetscInfo(ksp,"Converged due to zero residual norm on entry\n");CHKERRQ(ierr);
+      PetscFunctionReturn(0);
+    }
+    ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+    if (ksp->reason) PetscFunctionReturn(0);
+    ksp->its++;
+  } else {
+    ierr = VecMDot(VEC_VV(0),k,gcrodr->C,gcrodr->alpha);CHKERRQ(ierr);
+  }
+  for (i=0; i<k; i++) gcrodr->coef[i] = -gcrodr->alpha[i];
+  ierr = VecMAXPY(VEC_VV(0),k,gcrodr->coef,gcrodr->C);CHKERRQ(ierr);
+  gcrodr->kproj = k;
+  PetscFunctionReturn(0);
+}
+
+/*
+   Replaces U and C by the kmax harmonic Ritz vectors of smallest magnitude from the augmented space of the cycle
+   just done, W = [U D, V] with D = diag(1/|u_i|). Since A W = Vh G with Vh = [C V], they are the solutions of
+   G^H G z = theta G^H Vh^H W z, computed as the eigenvectors of largest magnitude of X = R^{-1} Q^H Vh^H W, where
+   G = Q R. If G is numerically rank deficient the subspace is kept as it is.
+*/
+static PetscErrorCode KSPGCRODRUpdateRecycleSpace_Private(KSP ksp,PetscInt nr)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscInt       k = gcrodr->k,m = k+nr,ld = m+1,kk,i,j,l,rank;
+  PetscScalar    *G = gcrodr->G,*W = gcrodr->W,*QG = gcrodr->QG,*RG = gcrodr->RG,*X = gcrodr->X,*VR = gcrodr->VR;
+  PetscScalar    *GP = gcrodr->GP,*R = gcrodr->R,*T = gcrodr->T,*dots = gcrodr->dots,sum;
+  PetscReal      *d = gcrodr->d;
+  Vec            *tmp;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!gcrodr->kmax) PetscFunctionReturn(0);
+
+  /* the inner products of U with C and V and the norms of U, with a single reduction */
+  for (j=0; j<k; j++) {
+    ierr = VecMDotBegin(gcrodr->U[j],k,gcrodr->C,dots+j*ld);CHKERRQ(ierr);
+    ierr = VecMDotBegin(gcrodr->U[j],nr+1,&VEC_VV(0),dots+j*ld+k);CHKERRQ(ierr);
+    ierr = VecNormBegin(gcrodr->U[j],NORM_2,&d[j]);CHKERRQ(ierr);
+  }
+  if (k) {ierr = PetscCommSplitReductionBegin(PetscObjectComm((PetscObject)VEC_VV(0)));CHKERRQ(ierr);}
+  for (j=0; j<k; j++) {
+    ierr = VecMDotEnd(gcrodr->U[j],k,gcrodr->C,dots+j*ld);CHKERRQ(ierr);
+    ierr = VecMDotEnd(gcrodr->U[j],nr+1,&VEC_VV(0),dots+j*ld+k);CHKERRQ(ierr);
+    ierr = VecNormEnd(gcrodr->U[j],NORM_2,&d[j]);CHKERRQ(ierr);
+  }
+
+  /* G = [D B; 0 H] and W = Vh^H [U D V] */
+  ierr = PetscMemzero(G,ld*m*sizeof(PetscScalar));CHKERRQ(ierr);
+  ierr = PetscMemzero(W,ld*m*sizeof(PetscScalar));CHKERRQ(ierr);
+  for (j=0; j<k; j++) {
+    G[j+j*ld] = 1.0/d[j];
+    for (i=0; i<ld; i++) W[i+j*ld] = dots[i+j*ld]/d[j];
+  }
+  for (j=0; j<nr; j++) {
+    for (i=0; i<k; i++) G[i+(k+j)*ld] = *BB(i,j);
+    for (i=0; i<=j+1; i++) G[k+i+(k+j)*ld] = *HES(i,j);
+    W[k+j+(k+j)*ld] = 1.0;
+  }
+
+  /* X = RG^{-1} QG^H W */
+  ierr = PetscMemcpy(QG,G,ld*m*sizeof(PetscScalar));CHKERRQ(ierr);
+  ierr = KSPGCRODRDenseQR_Private(ld,m,QG,ld,RG,m,&rank);CHKERRQ(ierr);
+  if (rank < m) {
+    ierr = PetscInfo2(ksp,"Keeping the recycled subspace, the augmented Hessenberg matrix has rank %D < %D\n",rank,m);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  for (j=0; j<m; j++) {
+    for (i=0; i<m; i++) {
+      sum = 0.0;
+      for (l=0; l<ld; l++) sum += PetscConj(QG[l+i*ld])*W[l+j*ld];
+      X[i+j*m] = sum;
+    }
+    for (i=m-1; i>=0; i--) {
+      sum = X[i+j*m];
+      for (l=i+1; l<m; l++) sum -= RG[i+l*m]*X[l+j*m];
+      X[i+j*m] = sum/RG[i+i*m];
+    }
+  }
+
+#if defined(PETSC_MISSING_LAPACK_GEEV)
+  SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_SUP,"GEEV - Lapack routine is unavailable.");
+#else
+  {
+    PetscBLASInt bm,lwork,idummy = 1,info;
+    PetscScalar  sdummy;
+
+    ierr = PetscBLASIntCast(m,&bm);CHKERRQ(ierr);
+    ierr = PetscBLASIntCast(5*gcrodr->max_k,&lwork);CHKERRQ(ierr);
+    ierr = PetscFPTrapPush(PETSC_FP_TRAP_OFF);CHKERRQ(ierr);
+#if !defined(PETSC_USE_COMPLEX)
+    PetscStackCallBLAS("LAPACKgeev",LAPACKgeev_("N","V",&bm,X,&bm,gcrodr->eigr,gcrodr->eigi,&sdummy,&idummy,VR,&bm,gcrodr->work,&lwork,&info));
+#else
+    PetscStackCallBLAS("LAPACKgeev",LAPACKgeev_("N","V",&bm,X,&bm,gcrodr->eigr,&sdummy,&idummy,VR,&bm,gcrodr->work,&lwork,gcrodr->rwork,&info));
+#endif
+    ierr = PetscFPTrapPop();CHKERRQ(ierr);
+    if (info) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in LAPACK routine GEEV %d",(int)info);
+  }
+#endif
+
+  /* the eigenvectors of largest magnitude; a complex conjugate pair contributes its real and imaginary parts */
+  for (i=0; i<m; i++) {
+#if !defined(PETSC_USE_COMPLEX)
+    gcrodr->modul[i] = PetscSqrtReal(gcrodr->eigr[i]*gcrodr->eigr[i]+gcrodr->eigi[i]*gcrodr->eigi[i]);
+#else
+    gcrodr->modul[i] = PetscAbsScalar(gcrodr->eigr[i]);
+#endif
+    gcrodr->perm[i] = i;
+  }
+  ierr = PetscSortRealWithPermutation(m,gcrodr->modul,gcrodr->perm);CHKERRQ(ierr);
+  for (l=m-1,kk=0; l>=0 && kk<gcrodr->kmax; l--) {
+    j = gcrodr->perm[l];
+#if !defined(PETSC_USE_COMPLEX)
+    if (gcrodr->eigi[j] < 0.0) continue;
+#endif
+    ierr = PetscMemcpy(T+kk*m,VR+j*m,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    kk++;
+#if !defined(PETSC_USE_COMPLEX)
+    if (gcrodr->eigi[j] > 0.0 && kk < gcrodr->kmax) {
+      ierr = PetscMemcpy(T+kk*m,VR+(j+1)*m,m*sizeof(PetscScalar));CHKERRQ(ierr);
+      kk++;
+    }
+#endif
+  }
+
+  /* GP = G P = Q R gives C = Vh Q and U = W P R^{-1} */
+  for (j=0; j<kk; j++) {
+    for (i=0; i<ld; i++) {
+      sum = 0.0;
+      for (l=0; l<m; l++) sum += G[i+l*ld]*T[l+j*m];
+      GP[i+j*ld] = sum;
+    }
+  }
+  ierr = KSPGCRODRDenseQR_Private(ld,kk,GP,ld,R,gcrodr->kmax,&rank);CHKERRQ(ierr);
+  kk   = rank;
+  if (!kk) PetscFunctionReturn(0);
+  for (j=0; j<kk; j++) {
+    for (i=0; i<j; i++) {
+      for (l=0; l<m; l++) T[l+j*m] -= R[i+j*gcrodr->kmax]*T[l+i*m];
+    }
+    for (l=0; l<m; l++) T[l+j*m] /= R[j+j*gcrodr->kmax];
+  }
+  for (j=0; j<kk; j++) {
+    for (l=0; l<k; l++) T[l+j*m] /= d[l];
+  }
+  for (j=0; j<kk; j++) {
+    ierr = VecSet(gcrodr->Cnew[j],0.0);CHKERRQ(ierr);
+    if (k) {ierr = VecMAXPY(gcrodr->Cnew[j],k,GP+j*ld,gcrodr->C);CHKERRQ(ierr);}
+    ierr = VecMAXPY(gcrodr->Cnew[j],nr+1,GP+j*ld+k,&VEC_VV(0));CHKERRQ(ierr);
+    ierr = VecSet(gcrodr->Unew[j],0.0);CHKERRQ(ierr);
+    if (k) {ierr = VecMAXPY(gcrodr->Unew[j],k,T+j*m,gcrodr->U);CHKERRQ(ierr);}
+    ierr = VecMAXPY(gcrodr->Unew[j],nr,T+j*m+k,&VEC_VV(0));CHKERRQ(ierr);
+  }
+  tmp = gcrodr->U; gcrodr->U = gcrodr->Unew; gcrodr->Unew = tmp;
+  tmp = gcrodr->C; gcrodr->C = gcrodr->Cnew; gcrodr->Cnew = tmp;
+  gcrodr->k = kk;
+  ierr = PetscInfo2(ksp,"Recycling %D harmonic Ritz vectors out of %D\n",kk,m);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   One cycle of GCRO-DR, the same as KSPGMRESCycle() except that each new vector is first orthogonalized
+   against C and the cycle has max_k - k iterations.
+ */
+static PetscErrorCode KSPGCRODRCycle(PetscInt *itcount,KSP ksp)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)(ksp->data);
+  PetscReal      res,hapbnd,tt;
+  PetscErrorCode ierr;
+  PetscInt       it = 0,i,k = gcrodr->k,max_k = gcrodr->max_k - gcrodr->k;
+  PetscBool      hapend = PETSC_FALSE;
+
+  PetscFunctionBegin;
+  if (itcount) *itcount = 0;
+  ierr    = VecNormalize(VEC_VV(0),&res);CHKERRQ(ierr);
+  KSPCheckNorm(ksp,res);
+  *GRS(0) = res;
+
+  /* check for the convergence */
+  ierr       = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ksp->rnorm = res;
+  ierr       = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+  gcrodr->it = (it - 1);
+  ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+  ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+  if (!res) {
+    ksp->reason = KSP_CONVERGED_ATOL;
+    ierr        = PetscInfo(ksp,"Converged due to zero residual norm on entry\n");CHKERRQ(ierr);
+    ierr        = KSPGCRODRBuildSoln(GRS(0),ksp->vec_sol,ksp->vec_sol,ksp,-1);CHKERRQ(ierr);
+    gcrodr->kproj = 0;
+    PetscFunctionReturn(0);
+  }
+
+  ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+  while (!ksp->reason && it < max_k && ksp->its < ksp->max_it) {
+    if (it) {
+      ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+      ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+    }
+    gcrodr->it = (it - 1);
+    if (gcrodr->vv_allocated <= it + VEC_OFFSET + 1) {
+      ierr = KSPGMRESGetNewVectors(ksp,it+1);CHKERRQ(ierr);
+    }
+    ierr = KSP_PCApplyBAorAB(ksp,VEC_VV(it),VEC_VV(1+it),VEC_TEMP_MATOP);CHKERRQ(ierr);
+
+    /* B(:,it) = C^H A v_it, then Gram-Schmidt against the Krylov basis updates the Hessenberg matrix */
+    if (k) {
+      ierr = VecMDot(VEC_VV(it+1),k,gcrodr->C,BB(0,it));CHKERRQ(ierr);
+      for (i=0; i<k; i++) gcrodr->coef[i] = -*BB(i,it);
+      ierr = VecMAXPY(VEC_VV(it+1),k,gcrodr->coef,gcrodr->C);CHKERRQ(ierr);
+    }
+    gcrodr->orthognorm = -1.0;
+    ierr = (*gcrodr->orthog)(ksp,it);CHKERRQ(ierr);
+    if (ksp->reason) break;
+
+    /* vv(i+1) . vv(i+1), unless the orthogonalization computed it */
+    if (gcrodr->orthognorm >= 0.0) {
+      tt   = gcrodr->orthognorm;
+      if (tt > 0.0) {ierr = VecScale(VEC_VV(it+1),1.0/tt);CHKERRQ(ierr);}
+    } else {
+      ierr = VecNormalize(VEC_VV(it+1),&tt);CHKERRQ(ierr);
+    }
+    KSPCheckNorm(ksp,tt);
+
+    /* save the magnitude */
+    *HH(it+1,it)  = tt;
+    *HES(it+1,it) = tt;
+
+    /* check for the happy breakdown */
+    hapbnd = PetscAbsScalar(tt / *GRS(it));
+    if (hapbnd > gcrodr->haptol) hapbnd = gcrodr->haptol;
+    if (tt < hapbnd) {
+      ierr   = PetscInfo2(ksp,"Detected happy breakdown, current hapbnd = %14.12e tt = %14.12e\n",(double)hapbnd,(double)tt);CHKERRQ(ierr);
+      hapend = PETSC_TRUE;
+    }
+    ierr = KSPGCRODRUpdateHessenberg(ksp,it,hapend,&res);CHKERRQ(ierr);
+
+    it++;
+    gcrodr->it = (it-1);   /* For converged */
+    ksp->its++;
+    ksp->rnorm = res;
+    if (ksp->reason) break;
+
+    ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+
+    /* Catch error in happy breakdown and signal convergence and break from loop */
+    if (hapend) {
+      if (ksp->normtype == KSP_NORM_NONE) { /* convergence test was skipped in this case */
+        ksp->reason = KSP_CONVERGED_HAPPY_BREAKDOWN;
+      } else if (!ksp->reason) {
+        if (ksp->errorifnotconverged) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"You reached the happy break down, but convergence was not indicated. Residual norm = %g",(double)res);
+        else {
+          ksp->reason = KSP_DIVERGED_BREAKDOWN;
+          break;
+        }
+      }
+    }
+  }
+
+  /* Monitor if we know that we will not return for a restart */
+  if (it && (ksp->reason || ksp->its >= ksp->max_it)) {
+    ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+    ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+  }
+
+  if (itcount) *itcount = it;
+
+  /* Form the solution (or the solution so far) */
+  ierr = KSPGCRODRBuildSoln(GRS(0),ksp->vec_sol,ksp->vec_sol,ksp,it-1);CHKERRQ(ierr);
+  gcrodr->kproj = 0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSolve_GCRODR(KSP ksp)
+{
+  KSP_GCRODR       *gcrodr    = (KSP_GCRODR*)ksp->data;
+  PetscBool        guess_zero = ksp->guess_zero;
+  PetscInt         its;
+  Mat              Amat,Pmat;
+  PetscObjectState Astate,Pstate;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  if (ksp->calc_sings && !gcrodr->Rsvd) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ORDER,"Must call KSPSetComputeSingularValues() before KSPSetUp() is called");
+
+  /* the recycled subspace of an earlier solve is kept, but its image must be recomputed if the operators changed */
+  ierr = PCGetOperators(ksp->pc,&Amat,&Pmat);CHKERRQ(ierr);
+  ierr = PetscObjectStateGet((PetscObject)Amat,&Astate);CHKERRQ(ierr);
+  ierr = PetscObjectStateGet((PetscObject)Pmat,&Pstate);CHKERRQ(ierr);
+  if (gcrodr->k && (Astate != gcrodr->Astate || Pstate != gcrodr->Pstate)) {
+    ierr = KSPGCRODRRecomputeC_Private(ksp);CHKERRQ(ierr);
+  }
+  gcrodr->Astate = Astate;
+  gcrodr->Pstate = Pstate;
+
+  ierr     = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ksp->its = 0;
+  ierr     = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+
+  gcrodr->fullcycle = 0;
+  ksp->reason       = KSP_CONVERGED_ITERATING;
+  while (!ksp->reason) {
+    ierr = KSPInitialResidual(ksp,ksp->vec_sol,VEC_TEMP,VEC_TEMP_MATOP,VEC_VV(0),ksp->vec_rhs);CHKERRQ(ierr);
+    ierr = KSPGCRODRProject_Private(ksp);CHKERRQ(ierr);
+    if (ksp->reason) break;
+    ierr = KSPGCRODRCycle(&its,ksp);CHKERRQ(ierr);
+    if (its == gcrodr->max_k - gcrodr->k) gcrodr->fullcycle++;
+    if (its && ksp->reason >= 0) {
+      ierr = KSPGCRODRUpdateRecycleSpace_Private(ksp,its);CHKERRQ(ierr);
+    }
+    if (ksp->its >= ksp->max_it) {
+      if (!ksp->reason) ksp->reason = KSP_DIVERGED_ITS;
+      break;
+    }
+    ksp->guess_zero = PETSC_FALSE; /* every future call to KSPInitialResidual() will have nonzero guess */
+  }
+  ksp->guess_zero = guess_zero; /* restore if user provided nonzero initial guess */
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPReset_GCRODR(KSP ksp)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecDestroyVecs(gcrodr->kmax,&gcrodr->U);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(gcrodr->kmax,&gcrodr->C);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(gcrodr->kmax,&gcrodr->Unew);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(gcrodr->kmax,&gcrodr->Cnew);CHKERRQ(ierr);
+  ierr = PetscFree5(gcrodr->alpha,gcrodr->B,gcrodr->coef,gcrodr->dots,gcrodr->d);CHKERRQ(ierr);
+  ierr = PetscFree7(gcrodr->G,gcrodr->W,gcrodr->QG,gcrodr->RG,gcrodr->X,gcrodr->VR,gcrodr->GP);CHKERRQ(ierr);
+  ierr = PetscFree5(gcrodr->R,gcrodr->T,gcrodr->work,gcrodr->eigr,gcrodr->eigi);CHKERRQ(ierr);
+  ierr = PetscFree3(gcrodr->rwork,gcrodr->modul,gcrodr->perm);CHKERRQ(ierr);
+  gcrodr->k     = 0;
+  gcrodr->kproj = 0;
+  ierr = KSPReset_GMRES(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPDestroy_GCRODR(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPReset_GCRODR(ksp);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGCRODRSetRecycle_C",NULL);CHKERRQ(ierr);
+  ierr = KSPDestroy_GMRES(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+    KSPGCRODRBuildSoln - create the solution from the starting vector and the
+    current iterates.
+
+    Input parameters:
+        nrs - work area of size it + 1.
+        vs  - index of initial guess
+        vdest - index of result.  Note that vs may == vdest (replace
+                guess with the solution).
+
+     The correction is V y + U (alpha - B y), where alpha are the coefficients of the projection
+     at the start of the cycle. This is an internal routine that knows about the GCRODR internals.
+ */
+static PetscErrorCode KSPGCRODRBuildSoln(PetscScalar *nrs,Vec vs,Vec vdest,KSP ksp,PetscInt it)
+{
+  PetscScalar    tt;
+  PetscErrorCode ierr;
+  PetscInt       ii,k,j,kproj;
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)(ksp->data);
+
+  PetscFunctionBegin;
+  kproj = gcrodr->kproj;
+  /* If it is < 0, no gmres steps have been performed */
+  if (it < 0 && !kproj) {
+    ierr = VecCopy(vs,vdest);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (it >= 0) {
+    if (*HH(it,it) != 0.0) {
+      nrs[it] = *GRS(it) / *HH(it,it);
+    } else {
+      if (ksp->errorifnotconverged) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"You reached the break down in GMRES; HH(it,it) = 0");
+      else ksp->reason = KSP_DIVERGED_BREAKDOWN;
+
+      ierr = PetscInfo2(ksp,"Likely your matrix or preconditioner is singular. HH(it,it) is identically zero; it = %D GRS(it) = %g\n",it,(double)PetscAbsScalar(*GRS(it)));CHKERRQ(ierr);
+      PetscFunctionReturn(0);
+    }
+    for (ii=1; ii<=it; ii++) {
+      k  = it - ii;
+      tt = *GRS(k);
+      for (j=k+1; j<=it; j++) tt = tt - *HH(k,j) * nrs[j];
+      if (*HH(k,k) == 0.0) {
+        if (ksp->errorifnotconverged) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"Likely your matrix or preconditioner is singular. HH(k,k) is identically zero; k = %D\n",k);
+        else {
+          ksp->reason = KSP_DIVERGED_BREAKDOWN;
+          ierr = PetscInfo1(ksp,"Likely your matrix or preconditioner is singular. HH(k,k) is identically zero; k = %D\n",k);CHKERRQ(ierr);
+          PetscFunctionReturn(0);
+        }
+      }
+      nrs[k] = tt / *HH(k,k);
+    }
+  }
+
+  /* Accumulate the correction to the solution of the preconditioned problem in TEMP */
+  ierr = VecSet(VEC_TEMP,0.0);CHKERRQ(ierr);
+  if (it >= 0) {ierr = VecMAXPY(VEC_TEMP,it+1,nrs,&VEC_VV(0));CHKERRQ(ierr);}
+  if (kproj) {
+    for (k=0; k<kproj; k++) {
+      tt = gcrodr->alpha[k];
+      for (j=0; j<=it; j++) tt -= *BB(k,j) * nrs[j];
+      gcrodr->coef[k] = tt;
+    }
+    ierr = VecMAXPY(VEC_TEMP,kproj,gcrodr->coef,gcrodr->U);CHKERRQ(ierr);
+  }
+
+  ierr = KSPUnwindPreconditioner(ksp,VEC_TEMP,VEC_TEMP_MATOP);CHKERRQ(ierr);
+  /* add solution to previous solution */
+  if (vdest != vs) {
+    ierr = VecCopy(vs,vdest);CHKERRQ(ierr);
+  }
+  ierr = VecAXPY(vdest,1.0,VEC_TEMP);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Applies the plane rotations to the Hessenberg column it, exactly as KSPGMRES does. Returns the new residual norm.
+ */
+static PetscErrorCode KSPGCRODRUpdateHessenberg(KSP ksp,PetscInt it,PetscBool hapend,PetscReal *res)
+{
+  PetscScalar *hh,*cc,*ss,tt;
+  PetscInt    j;
+  KSP_GCRODR  *gcrodr = (KSP_GCRODR*)(ksp->data);
+
+  PetscFunctionBegin;
+  hh = HH(0,it);
+  cc = CC(0);
+  ss = SS(0);
+
+  /* Apply all the previously computed plane rotations to the new column
+     of the Hessenberg matrix */
+  for (j=1; j<=it; j++) {
+    tt  = *hh;
+    *hh = PetscConj(*cc) * tt + *ss * *(hh+1);
+    hh++;
+    *hh = *cc++ * *hh - (*ss++ * tt);
+  }
+
+  if (!hapend) {
+    tt = PetscSqrtScalar(PetscConj(*hh) * *hh + PetscConj(*(hh+1)) * *(hh+1));
+    if (tt == 0.0) {
+      if (ksp->errorifnotconverged) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"tt == 0.0");
+      else {
+        ksp->reason = KSP_DIVERGED_NULL;
+        PetscFunctionReturn(0);
+      }
+    }
+    *cc        = *hh / tt;
+    *ss        = *(hh+1) / tt;
+    *GRS(it+1) = -(*ss * *GRS(it));
+    *GRS(it)   = PetscConj(*cc) * *GRS(it);
+    *hh        = PetscConj(*cc) * *hh + *ss * *(hh+1);
+    *res       = PetscAbsScalar(*GRS(it+1));
+  } else {
+    /* happy breakdown: HH(it+1, it) = 0, the residual is zero */
+    *res = 0.0;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPBuildSolution_GCRODR(KSP ksp,Vec ptr,Vec *result)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!ptr) {
+    if (!gcrodr->sol_temp) {
+      ierr = VecDuplicate(ksp->vec_sol,&gcrodr->sol_temp);CHKERRQ(ierr);
+      ierr = PetscLogObjectParent((PetscObject)ksp,(PetscObject)gcrodr->sol_temp);CHKERRQ(ierr);
+    }
+    ptr = gcrodr->sol_temp;
+  }
+  if (!gcrodr->nrs) {
+    /* allocate the work area */
+    ierr = PetscMalloc1(gcrodr->max_k,&gcrodr->nrs);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory((PetscObject)ksp,gcrodr->max_k*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
+
+  ierr = KSPGCRODRBuildSoln(gcrodr->nrs,ksp->vec_sol,ptr,ksp,gcrodr->it);CHKERRQ(ierr);
+  if (result) *result = ptr;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPView_GCRODR(KSP ksp,PetscViewer viewer)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscErrorCode ierr;
+  PetscBool      iascii;
+
+  PetscFunctionBegin;
+  ierr = KSPView_GMRES(ksp,viewer);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerASCIIPrintf(viewer,"  recycled subspace of dimension %D, at most %D\n",gcrodr->k,gcrodr->kmax);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetFromOptions_GCRODR(PetscOptionItems *PetscOptionsObject,KSP ksp)
+{
+  PetscErrorCode ierr;
+  PetscInt       recycle;
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscBool      flg;
+
+  PetscFunctionBegin;
+  ierr = KSPSetFromOptions_GMRES(PetscOptionsObject,ksp);CHKERRQ(ierr);
+  ierr = PetscOptionsHead(PetscOptionsObject,"KSP GCRODR Options");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-ksp_gcrodr_recycle","Dimension of the subspace kept between cycles and solves","KSPGCRODRSetRecycle",gcrodr->kmax,&recycle,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPGCRODRSetRecycle(ksp,recycle);CHKERRQ(ierr); }
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPGMRESSetRestart_GCRODR(KSP ksp,PetscInt max_k)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (max_k < 1) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Restart must be positive");
+  if (!ksp->setupstage) {
+    gcrodr->max_k = max_k;
+  } else if (gcrodr->max_k != max_k) {
+    ierr = KSPReset_GCRODR(ksp);CHKERRQ(ierr);
+    gcrodr->max_k   = max_k;
+    ksp->setupstage = KSP_SETUP_NEW;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPGCRODRSetRecycle_GCRODR(KSP ksp,PetscInt k)
+{
+  KSP_GCRODR     *gcrodr = (KSP_GCRODR*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (k < 0) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Dimension of the recycled subspace must be nonnegative");
+  if (!ksp->setupstage) {
+    gcrodr->kmax = k;
+  } else if (gcrodr->kmax != k) {
+    ierr = KSPReset_GCRODR(ksp);CHKERRQ(ierr);
+    gcrodr->kmax    = k;
+    ksp->setupstage = KSP_SETUP_NEW;
+  }
+  PetscFunctionReturn(0);
+}
+
+/*@
+   KSPGCRODRSetRecycle - Sets the maximum dimension of the subspace that KSPGCRODR keeps between restarts and
+   between linear solves
+
+   Logically Collective on KSP
+
+   Input Parameters:
++  ksp - the Krylov space context
+-  k - the dimension, which must be smaller than the restart
+
+   Options Database:
+.  -ksp_gcrodr_recycle <k> - the dimension of the recycled subspace
+
+   Notes:
+   Changing the dimension after the KSP is set up discards the recycled subspace. With k = 0 the method is
+   restarted GMRES.
+
+   Level: intermediate
+
+.keywords: KSP, GCRODR, recycling, deflation
+
+.seealso: KSPGCRODR, KSPGMRESSetRestart()
+@*/
+PetscErrorCode KSPGCRODRSetRecycle(KSP ksp,PetscInt k)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(ksp,KSP_CLASSID,1);
+  PetscValidLogicalCollectiveInt(ksp,k,2);
+  ierr = PetscTryMethod(ksp,"KSPGCRODRSetRecycle_C",(KSP,PetscInt),(ksp,k));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*MC
+     KSPGCRODR - Implements GCRO-DR, a restarted GMRES that keeps a subspace of harmonic Ritz vectors between
+                 restarts and between consecutive linear solves with the same KSP (Krylov subspace recycling).
+
+   Options Database Keys:
++   -ksp_gmres_restart <restart> - the total number of vectors, recycled plus Krylov, of a cycle
+.   -ksp_gmres_haptol <tol> - sets the tolerance for "happy ending" (exact convergence)
+.   -ksp_gmres_classicalgramschmidt - use classical (unmodified) Gram-Schmidt to orthogonalize against the Krylov space (fast) (the default)
+.   -ksp_gmres_modifiedgramschmidt - use modified Gram-Schmidt in the orthogonalization (more stable, but slower)
+.   -ksp_gmres_cgs_refinement_type <never,ifneeded,always> - determine if iterative refinement is used to increase the
+                                   stability of the classical Gram-Schmidt orthogonalization.
+-   -ksp_gcrodr_recycle <k> - the dimension of the recycled subspace, see KSPGCRODRSetRecycle()
+
+   Level: intermediate
+
+   Notes:
+    Left and right preconditioning are supported, but not symmetric preconditioning.
+
+    The method is meant for sequences of linear systems whose operators change slowly, such as the systems of a
+    Newton iteration or of a time stepping loop. Each cycle after the first has restart - k Krylov iterations and
+    the recycled vectors take the place of the others. The first solve starts as GMRES; each later solve starts by
+    projecting the residual onto the recycled subspace, which counts as one iteration. When the matrices of the
+    KSP have changed since the previous solve, the image of the subspace is recomputed with k applications of the
+    operator. The subspace is discarded by KSPReset() or when the restart or its dimension is changed.
+
+    KSPGCRODR can also be used for symmetric positive definite systems, at the price of storing the restart + k
+    vectors that KSPCG does not need.
+
+   References:
+.     1. - M. L. Parks, E. de Sturler, G. Mackey, D. D. Johnson and S. Maiti, Recycling Krylov subspaces for
+           sequences of linear systems, SIAM J. Sci. Comput., 28(5), 2006.
+
+.seealso:  KSPCreate(), KSPSetType(), KSPType (for list of available types), KSP, KSPGMRES, KSPDGMRES, KSPLGMRES,
+           KSPGMRESSetRestart(), KSPGMRESSetHapTol(), KSPGCRODRSetRecycle(), KSPSetGuess()
+M*/
+
+PETSC_EXTERN PetscErrorCode KSPCreate_GCRODR(KSP ksp)
+{
+  KSP_GCRODR     *gcrodr;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr      = PetscNewLog(ksp,&gcrodr);CHKERRQ(ierr);
+  ksp->data = (void*)gcrodr;
+
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_PRECONDITIONED,PC_LEFT,3);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_UNPRECONDITIONED,PC_RIGHT,2);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_RIGHT,1);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_LEFT,1);CHKERRQ(ierr);
+
+  ksp->ops->buildsolution                = KSPBuildSolution_GCRODR;
+  ksp->ops->setup                        = KSPSetUp_GCRODR;
+  ksp->ops->solve                        = KSPSolve_GCRODR;
+  ksp->ops->reset                        = KSPReset_GCRODR;
+  ksp->ops->destroy                      = KSPDestroy_GCRODR;
+  ksp->ops->view                         = KSPView_GCRODR;
+  ksp->ops->setfromoptions               = KSPSetFromOptions_GCRODR;
+  ksp->ops->computeextremesingularvalues = KSPComputeExtremeSingularValues_GMRES;
+  ksp->ops->computeeigenvalues           = KSPComputeEigenvalues_GMRES;
+
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetPreAllocateVectors_C",KSPGMRESSetPreAllocateVectors_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetOrthogonalization_C",KSPGMRESSetOrthogonalization_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESGetOrthogonalization_C",KSPGMRESGetOrthogonalization_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetRestart_C",KSPGMRESSetRestart_GCRODR);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESGetRestart_C",KSPGMRESGetRestart_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetHapTol_C",KSPGMRESSetHapTol_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetCGSRefinementType_C",KSPGMRESSetCGSRefinementType_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESGetCGSRefinementType_C",KSPGMRESGetCGSRefinementType_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGCRODRSetRecycle_C",KSPGCRODRSetRecycle_GCRODR);CHKERRQ(ierr);
+
+  gcrodr->haptol         = 1.0e-30;
+  gcrodr->q_preallocate  = 1;
+  gcrodr->delta_allocate = GCRODR_DEFAULT_MAXK;
+  gcrodr->orthog         = KSPGMRESClassicalGramSchmidtOrthogonalization;
+  gcrodr->max_k          = GCRODR_DEFAULT_MAXK;
+  gcrodr->cgstype        = KSP_GMRES_CGS_REFINE_NEVER;
+  gcrodr->kmax           = GCRODR_DEFAULT_RECYCLE;
+  PetscFunctionReturn(0);
+}
@@ -68,10 +68,10 @@ PetscErrorCode    KSPSetUp_GMRES(KSP ksp)
   ierr = PetscMalloc1(VEC_OFFSET+2+max_k,&gmres->mwork_alloc);CHKERRQ(ierr);
   ierr = PetscLogObjectMemory((PetscObject)ksp,(VEC_OFFSET+2+max_k)*(sizeof(Vec*)+sizeof(PetscInt)) + gmres->vecs_allocated*sizeof(Vec));CHKERRQ(ierr);
 
-  if (gmres->q_preallocate) {
+  if (gmres->q_preallocate || gmres->contiguous) {
     gmres->vv_allocated = VEC_OFFSET + 2 + max_k;
 
-    ierr = KSPCreateVecs(ksp,gmres->vv_allocated,&gmres->user_work[0],0,NULL);CHKERRQ(ierr);
+    ierr = KSPGMRESCreateVecs_Private(ksp,gmres->vv_allocated,&gmres->user_work[0]);CHKERRQ(ierr);
     ierr = PetscLogObjectParents(ksp,gmres->vv_allocated,gmres->user_work[0]);CHKERRQ(ierr);
 
     gmres->mwork_alloc[0] = gmres->vv_allocated;
@@ -82,7 +82,7 @@ PetscErrorCode    KSPSetUp_GMRES(KSP ksp)
   } else {
     gmres->vv_allocated = 5;
 
-    ierr = KSPCreateVecs(ksp,5,&gmres->user_work[0],0,NULL);CHKERRQ(ierr);
+    ierr = KSPGMRESCreateVecs_Private(ksp,5,&gmres->user_work[0]);CHKERRQ(ierr);
     ierr = PetscLogObjectParents(ksp,5,gmres->user_work[0]);CHKERRQ(ierr);
 
     gmres->mwork_alloc[0] = 5;
@@ -152,11 +152,17 @@ PetscErrorCode KSPGMRESCycle(PetscInt *itcount,KSP ksp)
     ierr = KSP_PCApplyBAorAB(ksp,VEC_VV(it),VEC_VV(1+it),VEC_TEMP_MATOP);CHKERRQ(ierr);
 
     /* update hessenberg matrix and do Gram-Schmidt */
+    gmres->orthognorm = -1.0;
     ierr = (*gmres->orthog)(ksp,it);CHKERRQ(ierr);
     if (ksp->reason) break;
 
-    /* vv(i+1) . vv(i+1) */
-    ierr = VecNormalize(VEC_VV(it+1),&tt);CHKERRQ(ierr);
+    /* vv(i+1) . vv(i+1), unless the orthogonalization computed it */
+    if (gmres->orthognorm >= 0.0) {
+      tt   = gmres->orthognorm;
+      if (tt > 0.0) {ierr = VecScale(VEC_VV(it+1),1.0/tt);CHKERRQ(ierr);}
+    } else {
+      ierr = VecNormalize(VEC_VV(it+1),&tt);CHKERRQ(ierr);
+    }
     KSPCheckNorm(ksp,tt);
 
     /* save the magnitude */
@@ -435,6 +441,55 @@ static PetscErrorCode KSPGMRESUpdateHessenberg(KSP ksp,PetscInt it,PetscBool hap
   }
   PetscFunctionReturn(0);
 }
+/*
+   KSPGMRESCreateVecs_Private - Creates n work vectors like KSPCreateVecs(). With -ksp_gmres_contiguous_basis the local parts
+   of VECSEQ and VECMPI vectors follow each other in a single array, owned by the first vector, so that VecMDot() and
+   VecMAXPY() with consecutive Krylov vectors are a single dense matrix-vector product that reads the other vector once.
+*/
+PetscErrorCode KSPGMRESCreateVecs_Private(KSP ksp,PetscInt n,Vec **vecs)
+{
+  KSP_GMRES      *gmres = (KSP_GMRES*)ksp->data;
+  PetscErrorCode ierr;
+  Vec            *t;
+  PetscBool      isseq,ismpi;
+  PetscInt       k,nloc,N,bs;
+  PetscScalar    *array;
+  MPI_Comm       comm;
+
+  PetscFunctionBegin;
+  if (!gmres->contiguous || n < 2) {
+    ierr = KSPCreateVecs(ksp,n,vecs,0,NULL);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = KSPCreateVecs(ksp,1,&t,0,NULL);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)t[0],VECSEQ,&isseq);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)t[0],VECMPI,&ismpi);CHKERRQ(ierr);
+  if (!isseq && !ismpi) {
+    ierr = PetscInfo1(ksp,"Vectors of type %s cannot share an array, the Krylov basis is not contiguous\n",((PetscObject)t[0])->type_name);CHKERRQ(ierr);
+    ierr = VecDestroyVecs(1,&t);CHKERRQ(ierr);
+    ierr = KSPCreateVecs(ksp,n,vecs,0,NULL);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscObjectGetComm((PetscObject)t[0],&comm);CHKERRQ(ierr);
+  ierr = VecGetLocalSize(t[0],&nloc);CHKERRQ(ierr);
+  ierr = VecGetSize(t[0],&N);CHKERRQ(ierr);
+  ierr = VecGetBlockSize(t[0],&bs);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(1,&t);CHKERRQ(ierr);
+
+  ierr = PetscMalloc1(n,vecs);CHKERRQ(ierr);
+  ierr = PetscCalloc1(n*nloc,&array);CHKERRQ(ierr);
+  for (k=0; k<n; k++) {
+    if (isseq) {
+      ierr = VecCreateSeqWithArray(comm,bs,nloc,array+k*nloc,&(*vecs)[k]);CHKERRQ(ierr);
+    } else {
+      ierr = VecCreateMPIWithArray(comm,bs,nloc,N,array+k*nloc,&(*vecs)[k]);CHKERRQ(ierr);
+    }
+  }
+  ierr = VecReplaceArray((*vecs)[0],array);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)(*vecs)[0],n*nloc*sizeof(PetscScalar));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /*
    This routine allocates more work vectors, starting from VEC_VV(it).
  */
@@ -455,7 +510,7 @@ PetscErrorCode KSPGMRESGetNewVectors(KSP ksp,PetscInt it)
 
   gmres->vv_allocated += nalloc;
 
-  ierr = KSPCreateVecs(ksp,nalloc,&gmres->user_work[nwork],0,NULL);CHKERRQ(ierr);
+  ierr = KSPGMRESCreateVecs_Private(ksp,nalloc,&gmres->user_work[nwork]);CHKERRQ(ierr);
   ierr = PetscLogObjectParents(ksp,nalloc,gmres->user_work[nwork]);CHKERRQ(ierr);
 
   gmres->mwork_alloc[nwork] = nalloc;
@@ -514,6 +569,20 @@ PetscErrorCode KSPView_GMRES(KSP ksp,PetscViewer viewer)
     default:
       SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Unknown orthogonalization");
     }
+  } else if (gmres->orthog == KSPGMRESOneReduceGramSchmidtOrthogonalization) {
+    switch (gmres->cgstype) {
+    case (KSP_GMRES_CGS_REFINE_NEVER):
+      cstr = "One-reduce classical Gram-Schmidt Orthogonalization with no iterative refinement";
+      break;
+    case (KSP_GMRES_CGS_REFINE_ALWAYS):
+      cstr = "One-reduce classical Gram-Schmidt Orthogonalization with one step of iterative refinement";
+      break;
+    case (KSP_GMRES_CGS_REFINE_IFNEEDED):
+      cstr = "One-reduce classical Gram-Schmidt Orthogonalization with one step of iterative refinement when needed";
+      break;
+    default:
+      SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Unknown orthogonalization");
+    }
   } else if (gmres->orthog == KSPGMRESModifiedGramSchmidtOrthogonalization) {
     cstr = "Modified Gram-Schmidt Orthogonalization";
   } else {
@@ -588,8 +657,11 @@ PetscErrorCode KSPSetFromOptions_GMRES(PetscOptionItems *PetscOptionsObject,KSP
   flg  = PETSC_FALSE;
   ierr = PetscOptionsBool("-ksp_gmres_preallocate","Preallocate Krylov vectors","KSPGMRESSetPreAllocateVectors",flg,&flg,NULL);CHKERRQ(ierr);
   if (flg) {ierr = KSPGMRESSetPreAllocateVectors(ksp);CHKERRQ(ierr);}
+  ierr = PetscOptionsBool("-ksp_gmres_contiguous_basis","Store the Krylov vectors in a single array","None",gmres->contiguous,&gmres->contiguous,NULL);CHKERRQ(ierr);
   ierr = PetscOptionsBoolGroupBegin("-ksp_gmres_classicalgramschmidt","Classical (unmodified) Gram-Schmidt (fast)","KSPGMRESSetOrthogonalization",&flg);CHKERRQ(ierr);
   if (flg) {ierr = KSPGMRESSetOrthogonalization(ksp,KSPGMRESClassicalGramSchmidtOrthogonalization);CHKERRQ(ierr);}
+  ierr = PetscOptionsBoolGroup("-ksp_gmres_onereducegramschmidt","Classical Gram-Schmidt with a single reduction (fastest)","KSPGMRESSetOrthogonalization",&flg);CHKERRQ(ierr);
+  if (flg) {ierr = KSPGMRESSetOrthogonalization(ksp,KSPGMRESOneReduceGramSchmidtOrthogonalization);CHKERRQ(ierr);}
   ierr = PetscOptionsBoolGroupEnd("-ksp_gmres_modifiedgramschmidt","Modified Gram-Schmidt (slow,more stable)","KSPGMRESSetOrthogonalization",&flg);CHKERRQ(ierr);
   if (flg) {ierr = KSPGMRESSetOrthogonalization(ksp,KSPGMRESModifiedGramSchmidtOrthogonalization);CHKERRQ(ierr);}
   ierr = PetscOptionsEnum("-ksp_gmres_cgs_refinement_type","Type of iterative refinement for classical (unmodified) Gram-Schmidt","KSPGMRESSetCGSRefinementType",
@@ -601,6 +673,7 @@ PetscErrorCode KSPSetFromOptions_GMRES(PetscOptionItems *PetscOptionsObject,KSP
     ierr = PetscViewersCreate(PetscObjectComm((PetscObject)ksp),&viewers);CHKERRQ(ierr);
     ierr = KSPMonitorSet(ksp,KSPGMRESMonitorKrylov,viewers,(PetscErrorCode (*)(void**))PetscViewersDestroy);CHKERRQ(ierr);
   }
+  ierr = KSPMonitorSetFromOptions(ksp,"-ksp_gmres_orthogonality_monitor","Monitor the loss of orthogonality of the Krylov basis","KSPGMRESMonitorOrthogonality",KSPGMRESMonitorOrthogonality);CHKERRQ(ierr);
   ierr = PetscOptionsTail();CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -849,10 +922,14 @@ PetscErrorCode  KSPGMRESSetHapTol(KSP ksp,PetscReal tol)
 .   -ksp_gmres_haptol <tol> - sets the tolerance for "happy ending" (exact convergence)
 .   -ksp_gmres_preallocate - preallocate all the Krylov search directions initially (otherwise groups of
                              vectors are allocated as needed)
+.   -ksp_gmres_contiguous_basis - preallocate the Krylov search directions in a single array, so that the orthogonalization
+                             reads each of them once per dense matrix-vector product (only for VECSEQ and VECMPI vectors)
 .   -ksp_gmres_classicalgramschmidt - use classical (unmodified) Gram-Schmidt to orthogonalize against the Krylov space (fast) (the default)
 .   -ksp_gmres_modifiedgramschmidt - use modified Gram-Schmidt in the orthogonalization (more stable, but slower)
+.   -ksp_gmres_onereducegramschmidt - use classical Gram-Schmidt with a single global reduction per iteration, see KSPGMRESOneReduceGramSchmidtOrthogonalization()
 .   -ksp_gmres_cgs_refinement_type <refine_never,refine_ifneeded,refine_always> - determine if iterative refinement is used to increase the
                                    stability of the classical Gram-Schmidt  orthogonalization.
+.   -ksp_gmres_orthogonality_monitor - print the loss of orthogonality of the Krylov basis, see KSPGMRESMonitorOrthogonality()
 -   -ksp_gmres_krylov_monitor - plot the Krylov space generated
 
    Level: beginner
@@ -866,7 +943,7 @@ PetscErrorCode  KSPGMRESSetHapTol(KSP ksp,PetscReal tol)
 
 .seealso:  KSPCreate(), KSPSetType(), KSPType (for list of available types), KSP, KSPFGMRES, KSPLGMRES,
            KSPGMRESSetRestart(), KSPGMRESSetHapTol(), KSPGMRESSetPreAllocateVectors(), KSPGMRESSetOrthogonalization(), KSPGMRESGetOrthogonalization(),
-           KSPGMRESClassicalGramSchmidtOrthogonalization(), KSPGMRESModifiedGramSchmidtOrthogonalization(),
+           KSPGMRESClassicalGramSchmidtOrthogonalization(), KSPGMRESModifiedGramSchmidtOrthogonalization(), KSPGMRESOneReduceGramSchmidtOrthogonalization(),
            KSPGMRESCGSRefinementType, KSPGMRESSetCGSRefinementType(), KSPGMRESGetCGSRefinementType(), KSPGMRESMonitorKrylov(), KSPSetPCSide()
 
 M*/
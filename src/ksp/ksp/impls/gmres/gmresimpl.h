@@ -30,10 +30,13 @@
                                                                         \
   PetscErrorCode (*orthog)(KSP,PetscInt);                    \
   KSPGMRESCGSRefinementType cgstype;                                    \
+  PetscReal orthognorm;       /* norm of the new direction if the orthogonalization computed it, negative otherwise */ \
+  PetscInt  nreorth;          /* number of second passes of KSPGMRESOneReduceGramSchmidtOrthogonalization() in the solve */ \
                                                                         \
   Vec      *vecs;                                        /* the work vectors */ \
   Vec      *vecb;                                        /* holds the last full basis vectors of the Krylov subspace to compute (harmonic) Ritz pairs */ \
   PetscInt q_preallocate;    /* 0=don't preallocate space for work vectors */ \
+  PetscBool contiguous;      /* allocate the work vectors of a chunk in a single array */ \
   PetscInt delta_allocate;    /* number of vectors to preallocaate in each block if not preallocated */ \
   PetscInt vv_allocated;      /* number of allocated gmres direction vectors */ \
   PetscInt vecs_allocated;                              /*   total number of vecs available */ \
@@ -61,6 +64,7 @@ PETSC_INTERN PetscErrorCode KSPComputeRitz_GMRES(KSP,PetscBool,PetscBool,PetscIn
 PETSC_INTERN PetscErrorCode KSPReset_GMRES(KSP);
 PETSC_INTERN PetscErrorCode KSPDestroy_GMRES(KSP);
 PETSC_INTERN PetscErrorCode KSPGMRESGetNewVectors(KSP,PetscInt);
+PETSC_INTERN PetscErrorCode KSPGMRESCreateVecs_Private(KSP,PetscInt,Vec**);
 
 typedef PetscErrorCode (*FCN)(KSP,PetscInt); /* force argument to next function to not be extern C*/
 
@@ -0,0 +1,633 @@
+/*
+    This file implements p(l)-GMRES, GMRES with a pipeline of depth l.
+
+    An auxiliary basis Z is computed l iterations ahead of the orthonormal Krylov basis V with
+
+       z_{i+1} = (A - sigma_i) z_i,                                            i < l,
+       z_{i+1} = (A z_i - sum_{k<=i-l} h_{k,i-l} z_{k+l}) / h_{i-l+1,i-l},     i >= l,
+
+    so that Z = V G with G upper triangular. The inner products of z_{i+1} with the basis vectors already known, which
+    give column i+1 of G, are reduced with MPI_Iallreduce() and only waited for l iterations later: l reductions are in
+    flight while the operator is applied. Column i-l of the Hessenberg matrix then follows from G and the recurrence of
+    Z, H = G B G^{-1}, so the least squares problem, the convergence test and the solution are the same as for GMRES.
+
+    Reference: P. Ghysels, T. J. Ashby, K. Meerbergen and W. Vanroose, Hiding global communication latency in the GMRES
+    algorithm on massively parallel machines, SIAM J. Sci. Comput. 35(1), 2013.
+*/
+#define KSPGMRES_NO_MACROS
+#include <../src/ksp/ksp/impls/gmres/gmresimpl.h>       /*I  "petscksp.h"  I*/
+#include <petsc/private/vecimpl.h>
+
+#define PIPELGMRES_DEFAULT_MAXK 30
+
+typedef struct {
+  KSPGMRESHEADER
+
+  PetscInt    l;            /* pipeline depth */
+  PetscReal   lmin,lmax;    /* estimates of the extreme eigenvalues, they give the shifts of the first l vectors of Z */
+  PetscReal   *sigma;       /* the shifts */
+  Vec         *Z;           /* auxiliary basis, Z = V G */
+  Vec         *dotvecs;     /* the vectors a new z is multiplied with */
+  PetscScalar *G;           /* change of basis, upper triangular */
+  PetscScalar *y,*By;       /* work space for a column of the Hessenberg matrix */
+  MPI_Request *req;         /* the reduction of each column of G */
+} KSP_PIPELGMRES;
+
+#define HH(a,b)  (plgmres->hh_origin + (b)*(plgmres->max_k+2)+(a))
+#define HES(a,b) (plgmres->hes_origin + (b)*(plgmres->max_k+1)+(a))
+#define CC(a)    (plgmres->cc_origin + (a))
+#define SS(a)    (plgmres->ss_origin + (a))
+#define GRS(a)   (plgmres->rs_origin + (a))
+#define GG(a,b)  (plgmres->G + (b)*(plgmres->max_k+1)+(a))
+
+/* vector names, the same layout as KSPGMRES */
+#define VEC_OFFSET     2
+#define VEC_TEMP       plgmres->vecs[0]
+#define VEC_TEMP_MATOP plgmres->vecs[1]
+#define VEC_VV(i)      plgmres->vecs[VEC_OFFSET+i]
+
+static PetscErrorCode KSPPIPELGMRESUpdateHessenberg(KSP,PetscInt,PetscBool,PetscReal*);
+static PetscErrorCode KSPPIPELGMRESBuildSoln(PetscScalar*,Vec,Vec,KSP,PetscInt);
+
+static PetscErrorCode MPIPetsc_Iallreduce(void *sendbuf,void *recvbuf,PetscMPIInt count,MPI_Datatype datatype,MPI_Op op,MPI_Comm comm,MPI_Request *request)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+#if defined(PETSC_HAVE_MPI_IALLREDUCE)
+  ierr = MPI_Iallreduce(sendbuf,recvbuf,count,datatype,op,comm,request);CHKERRQ(ierr);
+#else
+  ierr = MPIU_Allreduce(sendbuf,recvbuf,count,datatype,op,comm);CHKERRQ(ierr);
+  *request = MPI_REQUEST_NULL;
+#endif
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetUp_PIPELGMRES(KSP ksp)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscInt       max_k = plgmres->max_k,l = plgmres->l;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPSetUp_GMRES(ksp);CHKERRQ(ierr);
+  ierr = PetscMalloc1(max_k+1,&plgmres->orthogwork);CHKERRQ(ierr);
+  ierr = KSPGMRESCreateVecs_Private(ksp,max_k+1,&plgmres->Z);CHKERRQ(ierr);
+  ierr = PetscLogObjectParents(ksp,max_k+1,plgmres->Z);CHKERRQ(ierr);
+  ierr = PetscMalloc1(max_k+1,&plgmres->dotvecs);CHKERRQ(ierr);
+  ierr = PetscMalloc5((max_k+1)*(max_k+1),&plgmres->G,max_k+2,&plgmres->y,max_k+2,&plgmres->By,max_k+1,&plgmres->req,l,&plgmres->sigma);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)ksp,((max_k+1)*(max_k+4)+2)*sizeof(PetscScalar)+(max_k+1)*(sizeof(Vec)+sizeof(MPI_Request))+l*sizeof(PetscReal));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Starts the reduction of column j of G: the inner products of z_j with v_0,...,v_s, the basis vectors known when z_j
+   is computed, and with z_{s+1},...,z_j
+*/
+static PetscErrorCode KSPPIPELGMRESDotsBegin_Private(KSP ksp,PetscInt j)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  Vec            *Z = plgmres->Z,*dotvecs = plgmres->dotvecs;
+  PetscInt       k,s = PetscMax(0,j-plgmres->l);
+  PetscMPIInt    count;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (k=0; k<=s; k++) dotvecs[k] = VEC_VV(k);
+  for (k=s+1; k<=j; k++) dotvecs[k] = Z[k];
+  ierr = (*Z[j]->ops->mdot_local)(Z[j],j+1,dotvecs,GG(0,j));CHKERRQ(ierr);
+  ierr = PetscMPIIntCast(j+1,&count);CHKERRQ(ierr);
+  ierr = MPIPetsc_Iallreduce(MPI_IN_PLACE,GG(0,j),count,MPIU_SCALAR,MPIU_SUM,PetscObjectComm((PetscObject)ksp),&plgmres->req[j]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Waits for column j of G and turns the inner products with z_{s+1},...,z_j into inner products with v_{s+1},...,v_j,
+   using z_k = sum_{m<=k} g_{m,k} v_m. Returns g_{j,j}^2 and <z_j,z_j>; the first is computed by cancellation.
+*/
+static PetscErrorCode KSPPIPELGMRESDotsEnd_Private(KSP ksp,PetscInt j,PetscReal *nrm2,PetscReal *znrm2)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscInt       k,m,s = PetscMax(0,j-plgmres->l);
+  PetscScalar    tt;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MPI_Wait(&plgmres->req[j],MPI_STATUS_IGNORE);CHKERRQ(ierr);
+  for (k=s+1; k<j; k++) {
+    tt = *GG(k,j);
+    for (m=0; m<k; m++) tt -= PetscConj(*GG(m,k)) * *GG(m,j);
+    *GG(k,j) = tt / *GG(k,k);
+  }
+  *znrm2 = PetscRealPart(*GG(j,j));
+  *nrm2  = *znrm2;
+  for (m=0; m<j; m++) *nrm2 -= PetscRealPart(PetscConj(*GG(m,j)) * *GG(m,j));
+  PetscFunctionReturn(0);
+}
+
+/*
+   Computes column a of the Hessenberg matrix from columns 0,...,a+1 of G: since v_a = Z y with y = G^{-1} e_a and
+   A Z = Z B, where B holds the shifts and the earlier columns of H, A v_a = Z B y = V G B y
+*/
+static PetscErrorCode KSPPIPELGMRESHessenbergColumn_Private(KSP ksp,PetscInt a)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscScalar    *y = plgmres->y,*By = plgmres->By,tt;
+  PetscInt       k,m,l = plgmres->l;
+
+  PetscFunctionBegin;
+  y[a] = 1.0 / *GG(a,a);
+  for (k=a-1; k>=0; k--) {
+    tt = 0.0;
+    for (m=k+1; m<=a; m++) tt += *GG(k,m) * y[m];
+    y[k] = -tt / *GG(k,k);
+  }
+  for (k=0; k<=a+1; k++) By[k] = 0.0;
+  for (m=0; m<=a; m++) {
+    if (m < l) {
+      By[m]   += plgmres->sigma[m] * y[m];
+      By[m+1] += y[m];
+    } else {
+      for (k=0; k<=m-l+1; k++) By[k+l] += *HES(k,m-l) * y[m];
+    }
+  }
+  for (k=0; k<=a+1; k++) {
+    tt = 0.0;
+    for (m=k; m<=a+1; m++) tt += *GG(k,m) * By[m];
+    *HES(k,a) = tt;
+    *HH(k,a)  = tt;
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+    Runs one restart cycle of p(l)-GMRES, on entry VEC_VV(0) holds the initial residual
+*/
+static PetscErrorCode KSPPIPELGMRESCycle(PetscInt *itcount,KSP ksp)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)(ksp->data);
+  PetscReal      res_norm,res,hapbnd,tt,nrm2 = 0.0,znrm2 = 0.0;
+  PetscErrorCode ierr;
+  PetscInt       it = 0,i,j,k,a,amax,l = plgmres->l;
+  PetscBool      hapend = PETSC_FALSE,breakdown = PETSC_FALSE;
+  PetscScalar    *work = plgmres->orthogwork;
+  Vec            *Z = plgmres->Z;
+
+  PetscFunctionBegin;
+  if (itcount) *itcount = 0;
+  ierr    = VecNormalize(VEC_VV(0),&res_norm);CHKERRQ(ierr);
+  KSPCheckNorm(ksp,res_norm);
+  res     = res_norm;
+  *GRS(0) = res_norm;
+
+  /* check for the convergence */
+  ierr        = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ksp->rnorm  = res;
+  ierr        = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+  plgmres->it = (it - 1);
+  ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+  ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+  if (!res) {
+    ksp->reason = KSP_CONVERGED_ATOL;
+    ierr        = PetscInfo(ksp,"Converged due to zero residual norm on entry\n");CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+  if (ksp->reason) PetscFunctionReturn(0);
+
+  /* columns 0,...,amax of the Hessenberg matrix are computed in this cycle, they need z_0,...,z_{amax+1} */
+  amax = PetscMin(plgmres->max_k,ksp->max_it - ksp->its) - 1;
+  for (k=0; k<=amax+1; k++) plgmres->req[k] = MPI_REQUEST_NULL;
+  ierr     = VecCopy(VEC_VV(0),Z[0]);CHKERRQ(ierr);
+  *GG(0,0) = 1.0;
+
+  for (i=0; ; i++) {
+    a = i - l;
+    if (i <= amax) {
+      /* z_{i+1}, it is completed below once column i-l of the Hessenberg matrix is known */
+      ierr = KSP_PCApplyBAorAB(ksp,Z[i],Z[i+1],VEC_TEMP_MATOP);CHKERRQ(ierr);
+      if (i < l && plgmres->sigma[i] != 0.0) {
+        ierr = VecAXPY(Z[i+1],-plgmres->sigma[i],Z[i]);CHKERRQ(ierr);
+      }
+    }
+    if (a >= 0) {
+      /* the reduction started l iterations ago gives column a+1 of G and then column a of H */
+      j    = a + 1;
+      ierr = KSPPIPELGMRESDotsEnd_Private(ksp,j,&nrm2,&znrm2);CHKERRQ(ierr);
+      if (PetscIsInfOrNanReal(nrm2)) {
+        ierr = MPI_Waitall(amax+2,plgmres->req,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+        KSPCheckNorm(ksp,nrm2);
+      }
+      /*
+         when more than half of the digits cancel g_{a+1,a+1}, and hence column a of the Hessenberg matrix, is unreliable:
+         the column is dropped, the solution is formed from columns 0,...,a-1 and the cycle restarts from the true residual
+      */
+      if (nrm2 <= PETSC_SQRT_MACHINE_EPSILON*znrm2) {
+        breakdown = PETSC_TRUE;
+        ierr      = PetscInfo3(ksp,"Breakdown of the auxiliary basis at column %D: g^2 %g, |z|^2 %g\n",j,(double)nrm2,(double)znrm2);CHKERRQ(ierr);
+        if (!a) ksp->reason = KSP_DIVERGED_BREAKDOWN; /* no column is left, restarting would not make progress */
+        break;
+      }
+      *GG(j,j) = PetscSqrtReal(nrm2);
+
+      if (a) {
+        ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+        ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+      }
+      ierr = KSPPIPELGMRESHessenbergColumn_Private(ksp,a);CHKERRQ(ierr);
+
+      /* check for the happy breakdown */
+      tt     = PetscAbsScalar(*HES(a+1,a));
+      hapbnd = PetscAbsScalar(tt / *GRS(a));
+      if (hapbnd > plgmres->haptol) hapbnd = plgmres->haptol;
+      if (tt < hapbnd) {
+        ierr   = PetscInfo2(ksp,"Detected happy breakdown, current hapbnd = %14.12e tt = %14.12e\n",(double)hapbnd,(double)tt);CHKERRQ(ierr);
+        hapend = PETSC_TRUE;
+      }
+      ierr = KSPPIPELGMRESUpdateHessenberg(ksp,a,hapend,&res);CHKERRQ(ierr);
+
+      it++;
+      plgmres->it = (it-1);   /* For converged */
+      ksp->its++;
+      ksp->rnorm  = res;
+      if (ksp->reason) break;
+
+      ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+
+      /* Catch error in happy breakdown and signal convergence and break from loop */
+      if (hapend) {
+        if (ksp->normtype == KSP_NORM_NONE) { /* convergence test was skipped in this case */
+          ksp->reason = KSP_CONVERGED_HAPPY_BREAKDOWN;
+        } else if (!ksp->reason) {
+          if (ksp->errorifnotconverged) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"You reached the happy break down, but convergence was not indicated. Residual norm = %g",(double)res);
+          else ksp->reason = KSP_DIVERGED_BREAKDOWN;
+        }
+      }
+      if (ksp->reason || a == amax) break;
+
+      /* v_{a+1} = (z_{a+1} - sum_{k<=a} g_{k,a+1} v_k) / g_{a+1,a+1} */
+      for (k=0; k<j; k++) work[k] = -*GG(k,j);
+      ierr = VecCopy(Z[j],VEC_VV(j));CHKERRQ(ierr);
+      ierr = VecMAXPY(VEC_VV(j),j,work,&VEC_VV(0));CHKERRQ(ierr);
+      ierr = VecScale(VEC_VV(j),1.0 / *GG(j,j));CHKERRQ(ierr);
+    }
+    if (i <= amax) {
+      if (a >= 0) {
+        /* z_{i+1} = (A z_i - sum_{k<=a} h_{k,a} z_{k+l}) / h_{a+1,a} */
+        for (k=0; k<=a; k++) work[k] = -*HES(k,a);
+        ierr = VecMAXPY(Z[i+1],a+1,work,&Z[l]);CHKERRQ(ierr);
+        ierr = VecScale(Z[i+1],1.0 / *HES(a+1,a));CHKERRQ(ierr);
+      }
+      ierr = KSPPIPELGMRESDotsBegin_Private(ksp,i+1);CHKERRQ(ierr);
+    }
+  }
+  /* drain the pipeline */
+  ierr = MPI_Waitall(amax+2,plgmres->req,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+
+  /* Monitor if we know that we will not return for a restart */
+  if (it && !breakdown && (ksp->reason || ksp->its >= ksp->max_it)) {
+    ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+    ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+  }
+
+  if (itcount) *itcount = it;
+
+  /* Form the solution (or the solution so far) */
+  ierr = KSPPIPELGMRESBuildSoln(GRS(0),ksp->vec_sol,ksp->vec_sol,ksp,it-1);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSolve_PIPELGMRES(KSP ksp)
+{
+  PetscErrorCode ierr;
+  PetscInt       its,itcount,i,l;
+  KSP_PIPELGMRES *plgmres    = (KSP_PIPELGMRES*)ksp->data;
+  PetscBool      guess_zero = ksp->guess_zero;
+  PetscReal      lmin = plgmres->lmin,lmax = plgmres->lmax;
+
+  PetscFunctionBegin;
+  if (ksp->calc_sings && !plgmres->Rsvd) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ORDER,"Must call KSPSetComputeSingularValues() before KSPSetUp() is called");
+  if (!VEC_VV(0)->ops->mdot_local) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_SUP,"Vector type %s does not provide local inner products",((PetscObject)VEC_VV(0))->type_name);
+
+  /* Chebyshev nodes of [lmin,lmax], which are all zero without estimates of the eigenvalues */
+  l = plgmres->l;
+  for (i=0; i<l; i++) plgmres->sigma[i] = 0.5*(lmin+lmax) + 0.5*(lmax-lmin)*PetscCosReal(PETSC_PI*(2.0*i+1.0)/(2.0*l));
+
+  ierr     = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ksp->its = 0;
+  ierr     = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+
+  itcount            = 0;
+  plgmres->fullcycle = 0;
+  ksp->reason        = KSP_CONVERGED_ITERATING;
+  while (!ksp->reason) {
+    ierr     = KSPInitialResidual(ksp,ksp->vec_sol,VEC_TEMP,VEC_TEMP_MATOP,VEC_VV(0),ksp->vec_rhs);CHKERRQ(ierr);
+    ierr     = KSPPIPELGMRESCycle(&its,ksp);CHKERRQ(ierr);
+    if (its == plgmres->max_k) plgmres->fullcycle++;
+    itcount += its;
+    if (itcount >= ksp->max_it) {
+      if (!ksp->reason) ksp->reason = KSP_DIVERGED_ITS;
+      break;
+    }
+    ksp->guess_zero = PETSC_FALSE; /* every future call to KSPInitialResidual() will have nonzero guess */
+  }
+  ksp->guess_zero = guess_zero; /* restore if user provided nonzero initial guess */
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPReset_PIPELGMRES(KSP ksp)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (plgmres->Z) {
+    ierr = VecDestroyVecs(plgmres->max_k+1,&plgmres->Z);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(plgmres->dotvecs);CHKERRQ(ierr);
+  ierr = PetscFree5(plgmres->G,plgmres->y,plgmres->By,plgmres->req,plgmres->sigma);CHKERRQ(ierr);
+  ierr = KSPReset_GMRES(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPDestroy_PIPELGMRES(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPReset_PIPELGMRES(ksp);CHKERRQ(ierr);
+  ierr = KSPDestroy_GMRES(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+    KSPPIPELGMRESBuildSoln - create the solution from the starting vector and the
+    current iterates.
+
+    Input parameters:
+        nrs - work area of size it + 1.
+        vs  - index of initial guess
+        vdest - index of result.  Note that vs may == vdest (replace
+                guess with the solution).
+
+     This is an internal routine that knows about the PIPELGMRES internals.
+ */
+static PetscErrorCode KSPPIPELGMRESBuildSoln(PetscScalar *nrs,Vec vs,Vec vdest,KSP ksp,PetscInt it)
+{
+  PetscScalar    tt;
+  PetscErrorCode ierr;
+  PetscInt       ii,k,j;
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)(ksp->data);
+
+  PetscFunctionBegin;
+  /* If it is < 0, no gmres steps have been performed */
+  if (it < 0) {
+    ierr = VecCopy(vs,vdest);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (*HH(it,it) != 0.0) {
+    nrs[it] = *GRS(it) / *HH(it,it);
+  } else {
+    if (ksp->errorifnotconverged) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"You reached the break down in GMRES; HH(it,it) = 0");
+    else ksp->reason = KSP_DIVERGED_BREAKDOWN;
+
+    ierr = PetscInfo2(ksp,"Likely your matrix or preconditioner is singular. HH(it,it) is identically zero; it = %D GRS(it) = %g\n",it,(double)PetscAbsScalar(*GRS(it)));CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  for (ii=1; ii<=it; ii++) {
+    k  = it - ii;
+    tt = *GRS(k);
+    for (j=k+1; j<=it; j++) tt = tt - *HH(k,j) * nrs[j];
+    if (*HH(k,k) == 0.0) {
+      if (ksp->errorifnotconverged) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"Likely your matrix or preconditioner is singular. HH(k,k) is identically zero; k = %D\n",k);
+      else {
+        ksp->reason = KSP_DIVERGED_BREAKDOWN;
+        ierr = PetscInfo1(ksp,"Likely your matrix or preconditioner is singular. HH(k,k) is identically zero; k = %D\n",k);CHKERRQ(ierr);
+        PetscFunctionReturn(0);
+      }
+    }
+    nrs[k] = tt / *HH(k,k);
+  }
+
+  /* Accumulate the correction to the solution of the preconditioned problem in TEMP */
+  ierr = VecSet(VEC_TEMP,0.0);CHKERRQ(ierr);
+  ierr = VecMAXPY(VEC_TEMP,it+1,nrs,&VEC_VV(0));CHKERRQ(ierr);
+
+  ierr = KSPUnwindPreconditioner(ksp,VEC_TEMP,VEC_TEMP_MATOP);CHKERRQ(ierr);
+  /* add solution to previous solution */
+  if (vdest != vs) {
+    ierr = VecCopy(vs,vdest);CHKERRQ(ierr);
+  }
+  ierr = VecAXPY(vdest,1.0,VEC_TEMP);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Applies the plane rotations to the Hessenberg column it, exactly as KSPGMRES does. Returns the new residual norm.
+ */
+static PetscErrorCode KSPPIPELGMRESUpdateHessenberg(KSP ksp,PetscInt it,PetscBool hapend,PetscReal *res)
+{
+  PetscScalar    *hh,*cc,*ss,tt;
+  PetscInt       j;
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)(ksp->data);
+
+  PetscFunctionBegin;
+  hh = HH(0,it);
+  cc = CC(0);
+  ss = SS(0);
+
+  /* Apply all the previously computed plane rotations to the new column
+     of the Hessenberg matrix */
+  for (j=1; j<=it; j++) {
+    tt  = *hh;
+    *hh = PetscConj(*cc) * tt + *ss * *(hh+1);
+    hh++;
+    *hh = *cc++ * *hh - (*ss++ * tt);
+  }
+
+  if (!hapend) {
+    tt = PetscSqrtScalar(PetscConj(*hh) * *hh + PetscConj(*(hh+1)) * *(hh+1));
+    if (tt == 0.0) {
+      if (ksp->errorifnotconverged) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"tt == 0.0");
+      else {
+        ksp->reason = KSP_DIVERGED_NULL;
+        PetscFunctionReturn(0);
+      }
+    }
+    *cc        = *hh / tt;
+    *ss        = *(hh+1) / tt;
+    *GRS(it+1) = -(*ss * *GRS(it));
+    *GRS(it)   = PetscConj(*cc) * *GRS(it);
+    *hh        = PetscConj(*cc) * *hh + *ss * *(hh+1);
+    *res       = PetscAbsScalar(*GRS(it+1));
+  } else {
+    /* happy breakdown: HH(it+1, it) = 0, the residual is zero */
+    *res = 0.0;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPBuildSolution_PIPELGMRES(KSP ksp,Vec ptr,Vec *result)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!ptr) {
+    if (!plgmres->sol_temp) {
+      ierr = VecDuplicate(ksp->vec_sol,&plgmres->sol_temp);CHKERRQ(ierr);
+      ierr = PetscLogObjectParent((PetscObject)ksp,(PetscObject)plgmres->sol_temp);CHKERRQ(ierr);
+    }
+    ptr = plgmres->sol_temp;
+  }
+  if (!plgmres->nrs) {
+    /* allocate the work area */
+    ierr = PetscMalloc1(plgmres->max_k,&plgmres->nrs);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory((PetscObject)ksp,plgmres->max_k*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
+
+  ierr = KSPPIPELGMRESBuildSoln(plgmres->nrs,ksp->vec_sol,ptr,ksp,plgmres->it);CHKERRQ(ierr);
+  if (result) *result = ptr;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPView_PIPELGMRES(KSP ksp,PetscViewer viewer)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscErrorCode ierr;
+  PetscBool      iascii,isstring;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERSTRING,&isstring);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerASCIIPrintf(viewer,"  restart=%D, pipeline depth %D\n",plgmres->max_k,plgmres->l);CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPrintf(viewer,"  shifts from the eigenvalue estimates [%g,%g]\n",(double)plgmres->lmin,(double)plgmres->lmax);CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPrintf(viewer,"  happy breakdown tolerance %g\n",(double)plgmres->haptol);CHKERRQ(ierr);
+  } else if (isstring) {
+    ierr = PetscViewerStringSPrintf(viewer,"restart %D pipel %D",plgmres->max_k,plgmres->l);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetFromOptions_PIPELGMRES(PetscOptionItems *PetscOptionsObject,KSP ksp)
+{
+  PetscErrorCode ierr;
+  PetscInt       restart,l;
+  PetscReal      haptol;
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscBool      flg;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsHead(PetscOptionsObject,"KSP pipelined(l) GMRES Options");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-ksp_gmres_restart","Number of Krylov search directions","KSPGMRESSetRestart",plgmres->max_k,&restart,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPGMRESSetRestart(ksp,restart);CHKERRQ(ierr); }
+  ierr = PetscOptionsReal("-ksp_gmres_haptol","Tolerance for exact convergence (happy ending)","KSPGMRESSetHapTol",plgmres->haptol,&haptol,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPGMRESSetHapTol(ksp,haptol);CHKERRQ(ierr); }
+  ierr = PetscOptionsBool("-ksp_gmres_contiguous_basis","Allocate the Krylov basis in a single array","KSPGMRES",plgmres->contiguous,&plgmres->contiguous,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-ksp_pipelgmres_pipel","Pipeline length","KSPPIPELGMRES",plgmres->l,&l,&flg);CHKERRQ(ierr);
+  if (flg) {
+    if (l < 1) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Pipeline length must be positive");
+    if (ksp->setupstage && plgmres->l != l) {
+      ierr = KSPReset_PIPELGMRES(ksp);CHKERRQ(ierr);
+      ksp->setupstage = KSP_SETUP_NEW;
+    }
+    plgmres->l = l;
+  }
+  ierr = PetscOptionsReal("-ksp_pipelgmres_lmin","Estimate for smallest eigenvalue","KSPPIPELGMRES",plgmres->lmin,&plgmres->lmin,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsReal("-ksp_pipelgmres_lmax","Estimate for largest eigenvalue","KSPPIPELGMRES",plgmres->lmax,&plgmres->lmax,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPGMRESSetRestart_PIPELGMRES(KSP ksp,PetscInt max_k)
+{
+  KSP_PIPELGMRES *plgmres = (KSP_PIPELGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (max_k < 1) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Restart must be positive");
+  if (!ksp->setupstage) {
+    plgmres->max_k = max_k;
+  } else if (plgmres->max_k != max_k) {
+    ierr = KSPReset_PIPELGMRES(ksp);CHKERRQ(ierr);
+    plgmres->max_k  = max_k;
+    ksp->setupstage = KSP_SETUP_NEW;
+  }
+  PetscFunctionReturn(0);
+}
+
+/*MC
+     KSPPIPELGMRES - Implements p(l)-GMRES, the deep pipelined Generalized Minimal Residual method. Each iteration starts
+                     a single non-blocking global reduction, which is overlapped with the matrix-vector products and
+                     preconditioner applications of the next l iterations.
+
+   Options Database Keys:
++   -ksp_gmres_restart <restart> - the number of Krylov directions to orthogonalize against
+.   -ksp_gmres_haptol <tol> - sets the tolerance for "happy ending" (exact convergence)
+.   -ksp_gmres_contiguous_basis - allocate the Krylov basis and the auxiliary basis in single arrays
+.   -ksp_pipelgmres_pipel <l> - the pipeline depth l
+.   -ksp_pipelgmres_lmin <lmin> - estimate of the smallest eigenvalue of the preconditioned operator
+-   -ksp_pipelgmres_lmax <lmax> - estimate of the largest eigenvalue of the preconditioned operator
+
+   Level: intermediate
+
+   Notes:
+    The method builds an auxiliary basis Z, which is l iterations ahead of the orthonormal Krylov basis and related
+    to it by an upper triangular change of basis computed from the inner products. So that Z stays well conditioned its
+    first l vectors use the shifts sigma_i, the Chebyshev nodes of [lmin,lmax] (zero by default); for larger l good
+    estimates of the extreme eigenvalues matter, as for KSPPIPELCG.
+
+    The convergence test sees the residual norm of an iteration l iterations after its matrix-vector product, so
+    up to l extra products are done after convergence. When the change of basis loses more than half of its digits to
+    cancellation the pipeline is drained and the method restarts from the true residual, which replaces the recursively
+    computed one. The memory needed is about twice that of KSPGMRES.
+
+    MPI configuration may be necessary for reductions to make asynchronous progress, which is important for
+    performance of pipelined methods. See the FAQ on the PETSc website for details.
+
+   References:
+.     1. - P. Ghysels, T. J. Ashby, K. Meerbergen and W. Vanroose, Hiding global communication latency in the GMRES algorithm
+           on massively parallel machines, SIAM J. Sci. Comput. 35(1), 2013.
+
+.seealso:  KSPCreate(), KSPSetType(), KSPType (for list of available types), KSP, KSPGMRES, KSPPGMRES, KSPPIPEFGMRES, KSPPIPELCG,
+           KSPPIPEBCGS, KSPSGMRES, KSPGMRESSetRestart(), KSPGMRESSetHapTol()
+M*/
+
+PETSC_EXTERN PetscErrorCode KSPCreate_PIPELGMRES(KSP ksp)
+{
+  KSP_PIPELGMRES *plgmres;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr      = PetscNewLog(ksp,&plgmres);CHKERRQ(ierr);
+  ksp->data = (void*)plgmres;
+
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_PRECONDITIONED,PC_LEFT,3);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_UNPRECONDITIONED,PC_RIGHT,2);CHKERRQ(ierr);
+
+  ksp->ops->buildsolution                = KSPBuildSolution_PIPELGMRES;
+  ksp->ops->setup                        = KSPSetUp_PIPELGMRES;
+  ksp->ops->solve                        = KSPSolve_PIPELGMRES;
+  ksp->ops->reset                        = KSPReset_PIPELGMRES;
+  ksp->ops->destroy                      = KSPDestroy_PIPELGMRES;
+  ksp->ops->view                         = KSPView_PIPELGMRES;
+  ksp->ops->setfromoptions               = KSPSetFromOptions_PIPELGMRES;
+  ksp->ops->computeextremesingularvalues = KSPComputeExtremeSingularValues_GMRES;
+  ksp->ops->computeeigenvalues           = KSPComputeEigenvalues_GMRES;
+
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetRestart_C",KSPGMRESSetRestart_PIPELGMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESGetRestart_C",KSPGMRESGetRestart_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetHapTol_C",KSPGMRESSetHapTol_GMRES);CHKERRQ(ierr);
+
+  plgmres->haptol         = 1.0e-30;
+  plgmres->q_preallocate  = 1;
+  plgmres->delta_allocate = PIPELGMRES_DEFAULT_MAXK;
+  plgmres->orthog         = 0;
+  plgmres->max_k          = PIPELGMRES_DEFAULT_MAXK;
+  plgmres->cgstype        = KSP_GMRES_CGS_REFINE_NEVER;
+  plgmres->l              = 1;
+  plgmres->lmin           = 0.0;
+  plgmres->lmax           = 0.0;
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,739 @@
+/*
+    This file implements s-step GMRES, a communication avoiding variant of GMRES.
+
+    Each outer step computes s new basis vectors W_1,...,W_s from the last orthonormal basis vector
+    with the three term recurrence of MatMultBasis()
+
+       W_{t+1} = ((A - a_t) W_t - b_t W_{t-1})/c_t,   W_0 = v_k,
+
+    and orthogonalizes them as a block against the basis and among each other with CholQR (one global
+    reduction per pass). The Hessenberg matrix is then recovered from the change of basis coefficients so
+    the least squares problem, the convergence test and the solution are the same as for GMRES.
+
+    Reference: M. Hoemmen, Communication-avoiding Krylov subspace methods, PhD thesis, UC Berkeley, 2010.
+*/
+#define KSPGMRES_NO_MACROS
+#include <../src/ksp/ksp/impls/gmres/gmresimpl.h>       /*I  "petscksp.h"  I*/
+#include <petscblaslapack.h>
+
+#define SGMRES_DEFAULT_MAXK 30
+#define SGMRES_DEFAULT_S    4
+
+typedef struct {
+  KSPGMRESHEADER
+
+  PetscInt          s;              /* number of basis vectors computed between two reductions */
+  KSPSStepBasisType basis;          /* polynomial basis used to compute them */
+  PetscBool         cholqr2;        /* orthogonalize each block twice */
+  PetscBool         powers;         /* the basis is computed with MatMultBasis() on the operator */
+
+  PetscInt          nritz;          /* number of Ritz values known, 0 until the first cycle is done */
+  PetscReal         *ritzr,*ritzi;
+  PetscObjectState  Astate,Pstate;  /* state of the operators the Ritz values belong to */
+
+  PetscScalar       *a,*b,*c;       /* coefficients of the basis recurrence */
+  PetscScalar       *dots;          /* inner products of a block with the basis */
+  PetscScalar       *C,*R,*C2,*R2;  /* CholQR factors of the first and second pass */
+  PetscScalar       *Rz;            /* coefficients of W_0,...,W_s in the orthonormal basis */
+  PetscScalar       *M;             /* the operator applied to the block, in the orthonormal basis */
+} KSP_SGMRES;
+
+#define HH(a,b)  (sgmres->hh_origin + (b)*(sgmres->max_k+2)+(a))
+#define HES(a,b) (sgmres->hes_origin + (b)*(sgmres->max_k+1)+(a))
+#define CC(a)    (sgmres->cc_origin + (a))
+#define SS(a)    (sgmres->ss_origin + (a))
+#define GRS(a)   (sgmres->rs_origin + (a))
+#define RZ(a,b)  (sgmres->Rz + (b)*(sgmres->max_k+1)+(a))
+#define MM(a,b)  (sgmres->M + (b)*(sgmres->max_k+1)+(a))
+
+/* vector names, the same layout as KSPGMRES */
+#define VEC_OFFSET     2
+#define VEC_TEMP       sgmres->vecs[0]
+#define VEC_TEMP_MATOP sgmres->vecs[1]
+#define VEC_VV(i)      sgmres->vecs[VEC_OFFSET+i]
+
+static PetscErrorCode KSPSGMRESUpdateHessenberg(KSP,PetscInt,PetscBool,PetscReal*);
+static PetscErrorCode KSPSGMRESBuildSoln(PetscScalar*,Vec,Vec,KSP,PetscInt);
+
+static PetscErrorCode KSPSetUp_SGMRES(KSP ksp)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscInt       max_k = sgmres->max_k,s = sgmres->s;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPSetUp_GMRES(ksp);CHKERRQ(ierr);
+  if (!sgmres->Rsvd) {
+    /* workspace of KSPComputeEigenvalues_GMRES() that computes the Ritz values */
+    ierr = PetscMalloc1((max_k + 3)*(max_k + 9),&sgmres->Rsvd);CHKERRQ(ierr);
+    ierr = PetscMalloc1(6*(max_k+2),&sgmres->Dsvd);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory((PetscObject)ksp,(max_k + 3)*(max_k + 9)*sizeof(PetscScalar)+6*(max_k+2)*sizeof(PetscReal));CHKERRQ(ierr);
+  }
+  ierr = PetscMalloc1(max_k+1,&sgmres->orthogwork);CHKERRQ(ierr);
+  ierr = PetscMalloc2(max_k+1,&sgmres->ritzr,max_k+1,&sgmres->ritzi);CHKERRQ(ierr);
+  ierr = PetscMalloc3(s,&sgmres->a,s,&sgmres->b,s,&sgmres->c);CHKERRQ(ierr);
+  ierr = PetscMalloc7(s*(max_k+1),&sgmres->dots,s*(max_k+1),&sgmres->C,s*s,&sgmres->R,s*(max_k+1),&sgmres->C2,s*s,&sgmres->R2,(s+1)*(max_k+1),&sgmres->Rz,s*(max_k+1),&sgmres->M);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)ksp,(max_k+1)*(sizeof(PetscScalar)+2*sizeof(PetscReal))+(3*s+s*(5*(max_k+1)+2*s)+(s+1)*(max_k+1))*sizeof(PetscScalar));CHKERRQ(ierr);
+  sgmres->nritz = 0;
+  PetscFunctionReturn(0);
+}
+
+/*
+   Computes W_1,...,W_sb into VEC_VV(k+1),...,VEC_VV(k+sb) from VEC_VV(k)
+*/
+static PetscErrorCode KSPSGMRESBasis_Private(KSP ksp,PetscInt k,PetscInt sb)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscScalar    *a = sgmres->a,*b = sgmres->b,*c = sgmres->c;
+  PetscInt       t;
+  Mat            Amat;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (sgmres->powers) {
+    ierr = PCGetOperators(ksp->pc,&Amat,NULL);CHKERRQ(ierr);
+    ierr = MatMultBasis(Amat,VEC_VV(k),sb,a,b,c,&VEC_VV(k+1));CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  for (t=0; t<sb; t++) {
+    ierr = KSP_PCApplyBAorAB(ksp,VEC_VV(k+t),VEC_VV(k+t+1),VEC_TEMP_MATOP);CHKERRQ(ierr);
+    if (t && b[t] != 0.0) {
+      ierr = VecAXPBYPCZ(VEC_VV(k+t+1),-a[t]/c[t],-b[t]/c[t],1.0/c[t],VEC_VV(k+t),VEC_VV(k+t-1));CHKERRQ(ierr);
+    } else if (a[t] != 0.0 || c[t] != 1.0) {
+      ierr = VecAXPBY(VEC_VV(k+t+1),-a[t]/c[t],1.0/c[t],VEC_VV(k+t));CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   One CholQR pass on the block VEC_VV(k+1),...,VEC_VV(k+nb): with a single reduction computes C = V^H W and the
+   Cholesky factor R of W^H W - C^H C, then replaces W by (W - V C) R^{-1} in place. If the block is numerically rank
+   deficient only the leading nfact columns are kept.
+*/
+static PetscErrorCode KSPSGMRESCholQR_Private(KSP ksp,PetscInt k,PetscInt nb,PetscScalar *C,PetscScalar *R,PetscInt *nfact)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscScalar    *dots = sgmres->dots,*coef = sgmres->orthogwork,sum;
+  PetscInt       ld = k+1+nb,i,j,jj,nf;
+  PetscBLASInt   bnb,info;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (j=0; j<nb; j++) {
+    ierr = VecMDotBegin(VEC_VV(k+1+j),k+2+j,&VEC_VV(0),dots+j*ld);CHKERRQ(ierr);
+  }
+  ierr = PetscCommSplitReductionBegin(PetscObjectComm((PetscObject)VEC_VV(0)));CHKERRQ(ierr);
+  for (j=0; j<nb; j++) {
+    ierr = VecMDotEnd(VEC_VV(k+1+j),k+2+j,&VEC_VV(0),dots+j*ld);CHKERRQ(ierr);
+  }
+  for (j=0; j<nb; j++) {
+    for (i=0; i<=k; i++) C[i+j*(k+1)] = dots[i+j*ld];
+  }
+  for (j=0; j<nb; j++) {
+    for (jj=0; jj<nb; jj++) {
+      if (jj > j) {R[jj+j*nb] = 0.0; continue;}
+      sum = dots[k+1+jj+j*ld];
+      for (i=0; i<=k; i++) sum -= PetscConj(C[i+jj*(k+1)])*C[i+j*(k+1)];
+      R[jj+j*nb] = sum;
+    }
+  }
+  ierr = PetscBLASIntCast(nb,&bnb);CHKERRQ(ierr);
+#if defined(PETSC_MISSING_LAPACK_POTRF)
+  SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"POTRF - Lapack routine is unavailable.");
+#else
+  ierr = PetscFPTrapPush(PETSC_FP_TRAP_OFF);CHKERRQ(ierr);
+  PetscStackCallBLAS("LAPACKpotrf",LAPACKpotrf_("U",&bnb,R,&bnb,&info));
+  ierr = PetscFPTrapPop();CHKERRQ(ierr);
+#endif
+  if (info < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_LIB,"Error in POTRF Lapack routine %d",(int)info);
+  nf = info ? info-1 : nb;
+  if (nf < nb) {ierr = PetscInfo2(ksp,"Block of %D basis vectors is numerically rank deficient, keeping %D\n",nb,nf);CHKERRQ(ierr);}
+  for (j=0; j<nf; j++) {
+    for (i=0; i<=k; i++) coef[i] = -C[i+j*(k+1)];
+    for (jj=0; jj<j; jj++) coef[k+1+jj] = -R[jj+j*nb];
+    ierr = VecMAXPY(VEC_VV(k+1+j),k+1+j,coef,&VEC_VV(0));CHKERRQ(ierr);
+    ierr = VecScale(VEC_VV(k+1+j),1.0/R[j+j*nb]);CHKERRQ(ierr);
+  }
+  *nfact = nf;
+  PetscFunctionReturn(0);
+}
+
+/*
+   Used when not even the first vector of a block survives CholQR: orthogonalizes it with the C already computed
+   and normalizes it explicitly, this detects the happy breakdown.
+*/
+static PetscErrorCode KSPSGMRESNormalize_Private(KSP ksp,PetscInt k,PetscScalar *C,PetscScalar *R)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscScalar    *coef = sgmres->orthogwork;
+  PetscReal      nrm;
+  PetscInt       i;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (i=0; i<=k; i++) coef[i] = -C[i];
+  ierr = VecMAXPY(VEC_VV(k+1),k+1,coef,&VEC_VV(0));CHKERRQ(ierr);
+  ierr = VecNormalize(VEC_VV(k+1),&nrm);CHKERRQ(ierr);
+  KSPCheckNorm(ksp,nrm);
+  R[0] = nrm;
+  PetscFunctionReturn(0);
+}
+
+/*
+   Orthogonalizes the block VEC_VV(k+1),...,VEC_VV(k+*sb) and computes the Hessenberg columns k,...,k+*sb-1.
+   The block may shrink if it is numerically rank deficient.
+*/
+static PetscErrorCode KSPSGMRESOrthogonalize_Private(KSP ksp,PetscInt k,PetscInt *sb)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscScalar    *a = sgmres->a,*b = sgmres->b,*c = sgmres->c,*C = sgmres->C,*R = sgmres->R,*C2 = sgmres->C2,*R2 = sgmres->R2,sum;
+  PetscInt       nb = *sb,nf,i,j,jj,t,tt,ld;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscLogEventBegin(KSP_GMRESOrthogonalization,ksp,0,0,0);CHKERRQ(ierr);
+  ierr = KSPSGMRESCholQR_Private(ksp,k,nb,C,R,&nf);CHKERRQ(ierr);
+  if (!nf) {
+    ierr = KSPSGMRESNormalize_Private(ksp,k,C,R);CHKERRQ(ierr);
+    nf = 1;
+  }
+  if (nf < nb) {
+    /* the factors were computed with leading dimension nb */
+    for (j=0; j<nf; j++) for (jj=0; jj<=j; jj++) R[jj+j*nf] = R[jj+j*nb];
+  }
+  nb = nf;
+  /* RZ(:,0) is W_0 = v_k and RZ(:,j+1) holds the coefficients of W_{j+1} */
+  for (t=0; t<=nb; t++) for (i=0; i<=k+nb; i++) *RZ(i,t) = 0.0;
+  *RZ(k,0) = 1.0;
+  if (sgmres->cholqr2 && PetscAbsScalar(R[0]) > 0.0) {
+    ierr = KSPSGMRESCholQR_Private(ksp,k,nb,C2,R2,&nf);CHKERRQ(ierr);
+    if (!nf) {
+      ierr = KSPSGMRESNormalize_Private(ksp,k,C2,R2);CHKERRQ(ierr);
+      nf = 1;
+    }
+    ld = nb;
+    nb = nf;
+    /* W = V (C + C2 R) + Q (R2 R) */
+    for (j=0; j<nb; j++) {
+      for (i=0; i<=k; i++) {
+        sum = C[i+j*(k+1)];
+        for (jj=0; jj<=j; jj++) sum += C2[i+jj*(k+1)]*R[jj+j*ld];
+        *RZ(i,j+1) = sum;
+      }
+      for (i=0; i<=j; i++) {
+        sum = 0.0;
+        for (jj=i; jj<=j; jj++) sum += R2[i+jj*ld]*R[jj+j*ld];
+        *RZ(k+1+i,j+1) = sum;
+      }
+    }
+  } else {
+    for (j=0; j<nb; j++) {
+      for (i=0; i<=k; i++) *RZ(i,j+1) = C[i+j*(k+1)];
+      for (i=0; i<=j; i++) *RZ(k+1+i,j+1) = R[i+j*nb];
+    }
+  }
+
+  /* M(:,t) = V^H A W_t = c_t RZ(:,t+1) + a_t RZ(:,t) + b_t RZ(:,t-1), less the part due to the old basis vectors */
+  for (t=0; t<nb; t++) {
+    for (i=0; i<=k+t+1; i++) {
+      sum = c[t]*(*RZ(i,t+1)) + a[t]*(*RZ(i,t));
+      if (t) sum += b[t]*(*RZ(i,t-1));
+      *MM(i,t) = sum;
+    }
+    for (j=0; j<k; j++) {
+      if (*RZ(j,t) == 0.0) continue;
+      for (i=0; i<=j+1; i++) *MM(i,t) -= *HES(i,j)*(*RZ(j,t));
+    }
+  }
+  /* the new Hessenberg columns H satisfy H T = M with T = RZ(k:k+nb-1,0:nb-1) upper triangular */
+  for (t=0; t<nb; t++) {
+    for (i=0; i<=k+t+1; i++) {
+      sum = *MM(i,t);
+      for (tt=0; tt<t; tt++) sum -= *HES(i,k+tt)*(*RZ(k+tt,t));
+      *HES(i,k+t) = sum/(*RZ(k+t,t));
+    }
+    for (i=k+t+2; i<=sgmres->max_k; i++) *HES(i,k+t) = 0.0;
+    for (i=0; i<=k+t+1; i++) *HH(i,k+t) = *HES(i,k+t);
+  }
+  *sb  = nb;
+  ierr = PetscLogEventEnd(KSP_GMRESOrthogonalization,ksp,0,0,0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+    Runs one restart cycle of s-step GMRES, on entry VEC_VV(0) holds the initial residual
+*/
+static PetscErrorCode KSPSGMRESCycle(PetscInt *itcount,KSP ksp)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)(ksp->data);
+  PetscReal      res_norm,res,hapbnd,tt;
+  PetscErrorCode ierr;
+  PetscInt       it = 0,max_k = sgmres->max_k,k,sb,t;
+  PetscBool      hapend = PETSC_FALSE;
+
+  PetscFunctionBegin;
+  if (itcount) *itcount = 0;
+  ierr    = VecNormalize(VEC_VV(0),&res_norm);CHKERRQ(ierr);
+  KSPCheckNorm(ksp,res_norm);
+  res     = res_norm;
+  *GRS(0) = res_norm;
+
+  /* check for the convergence */
+  ierr       = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ksp->rnorm = res;
+  ierr       = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+  sgmres->it = (it - 1);
+  ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+  ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+  if (!res) {
+    ksp->reason = KSP_CONVERGED_ATOL;
+    ierr        = PetscInfo(ksp,"Converged due to zero residual norm on entry\n");CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+
+  ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+  while (!ksp->reason && it < max_k && ksp->its < ksp->max_it) {
+    /* until the Ritz values are known the basis vectors are computed one at a time */
+    k  = it;
+    sb = PetscMin(sgmres->s,PetscMin(max_k - it,ksp->max_it - ksp->its));
+    if (!sgmres->nritz && sgmres->basis != KSP_SSTEP_BASIS_MONOMIAL) sb = 1;
+    ierr = KSPSGMRESBasis_Private(ksp,k,sb);CHKERRQ(ierr);
+    ierr = KSPSGMRESOrthogonalize_Private(ksp,k,&sb);CHKERRQ(ierr);
+    if (ksp->reason) break;
+
+    for (t=0; t<sb; t++) {
+      if (it) {
+        ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+        ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+      }
+      sgmres->it = (it - 1);
+
+      /* check for the happy breakdown */
+      tt     = PetscAbsScalar(*HES(it+1,it));
+      hapbnd = PetscAbsScalar(tt / *GRS(it));
+      if (hapbnd > sgmres->haptol) hapbnd = sgmres->haptol;
+      if (tt < hapbnd) {
+        ierr   = PetscInfo2(ksp,"Detected happy breakdown, current hapbnd = %14.12e tt = %14.12e\n",(double)hapbnd,(double)tt);CHKERRQ(ierr);
+        hapend = PETSC_TRUE;
+      }
+      ierr = KSPSGMRESUpdateHessenberg(ksp,it,hapend,&res);CHKERRQ(ierr);
+
+      it++;
+      sgmres->it = (it-1);   /* For converged */
+      ksp->its++;
+      ksp->rnorm = res;
+      if (ksp->reason) break;
+
+      ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+
+      /* Catch error in happy breakdown and signal convergence and break from loop */
+      if (hapend) {
+        if (ksp->normtype == KSP_NORM_NONE) { /* convergence test was skipped in this case */
+          ksp->reason = KSP_CONVERGED_HAPPY_BREAKDOWN;
+        } else if (!ksp->reason) {
+          if (ksp->errorifnotconverged) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"You reached the happy break down, but convergence was not indicated. Residual norm = %g",(double)res);
+          else {
+            ksp->reason = KSP_DIVERGED_BREAKDOWN;
+            break;
+          }
+        }
+      }
+      if (ksp->reason) break;
+    }
+  }
+
+  /* Monitor if we know that we will not return for a restart */
+  if (it && (ksp->reason || ksp->its >= ksp->max_it)) {
+    ierr = KSPLogResidualHistory(ksp,res);CHKERRQ(ierr);
+    ierr = KSPMonitor(ksp,ksp->its,res);CHKERRQ(ierr);
+  }
+
+  if (itcount) *itcount = it;
+
+  /* Form the solution (or the solution so far) */
+  ierr = KSPSGMRESBuildSoln(GRS(0),ksp->vec_sol,ksp->vec_sol,ksp,it-1);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Computes the Ritz values from the Hessenberg matrix of the cycle just done and the coefficients of the basis from them
+*/
+static PetscErrorCode KSPSGMRESComputeBasis_Private(KSP ksp)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+#if !defined(PETSC_MISSING_LAPACK_GEEV)
+  if (!sgmres->nritz && sgmres->it >= 0 && sgmres->basis != KSP_SSTEP_BASIS_MONOMIAL) {
+    ierr = KSPComputeEigenvalues_GMRES(ksp,sgmres->max_k+1,sgmres->ritzr,sgmres->ritzi,&sgmres->nritz);CHKERRQ(ierr);
+    ierr = PetscInfo1(ksp,"Using %D Ritz values for the basis\n",sgmres->nritz);CHKERRQ(ierr);
+  }
+#endif
+  ierr = KSPSStepBasisCoefficients_Private(sgmres->basis,sgmres->nritz,sgmres->ritzr,sgmres->ritzi,sgmres->s,sgmres->a,sgmres->b,sgmres->c);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSolve_SGMRES(KSP ksp)
+{
+  PetscErrorCode   ierr;
+  PetscInt         its,itcount;
+  KSP_SGMRES       *sgmres    = (KSP_SGMRES*)ksp->data;
+  PetscBool        guess_zero = ksp->guess_zero;
+  Mat              Amat,Pmat;
+  PetscObjectState Astate,Pstate;
+
+  PetscFunctionBegin;
+  if (ksp->calc_sings && !sgmres->Rsvd) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ORDER,"Must call KSPSetComputeSingularValues() before KSPSetUp() is called");
+
+  /* the Ritz values of an earlier solve are kept as long as the operators do not change */
+  ierr = PCGetOperators(ksp->pc,&Amat,&Pmat);CHKERRQ(ierr);
+  ierr = PetscObjectStateGet((PetscObject)Amat,&Astate);CHKERRQ(ierr);
+  ierr = PetscObjectStateGet((PetscObject)Pmat,&Pstate);CHKERRQ(ierr);
+  if (Astate != sgmres->Astate || Pstate != sgmres->Pstate) {
+    sgmres->nritz  = 0;
+    sgmres->Astate = Astate;
+    sgmres->Pstate = Pstate;
+  }
+  sgmres->it = -1;
+  ierr = KSPSGMRESComputeBasis_Private(ksp);CHKERRQ(ierr);
+  ierr = KSPSStepUseMatMultBasis_Private(ksp,&sgmres->powers);CHKERRQ(ierr);
+
+  ierr     = PetscObjectSAWsTakeAccess((PetscObject)ksp);CHKERRQ(ierr);
+  ksp->its = 0;
+  ierr     = PetscObjectSAWsGrantAccess((PetscObject)ksp);CHKERRQ(ierr);
+
+  itcount          = 0;
+  sgmres->fullcycle = 0;
+  ksp->reason      = KSP_CONVERGED_ITERATING;
+  while (!ksp->reason) {
+    ierr     = KSPInitialResidual(ksp,ksp->vec_sol,VEC_TEMP,VEC_TEMP_MATOP,VEC_VV(0),ksp->vec_rhs);CHKERRQ(ierr);
+    ierr     = KSPSGMRESCycle(&its,ksp);CHKERRQ(ierr);
+    if (its == sgmres->max_k) sgmres->fullcycle++;
+    if (!sgmres->nritz && its) {ierr = KSPSGMRESComputeBasis_Private(ksp);CHKERRQ(ierr);}
+    itcount += its;
+    if (itcount >= ksp->max_it) {
+      if (!ksp->reason) ksp->reason = KSP_DIVERGED_ITS;
+      break;
+    }
+    ksp->guess_zero = PETSC_FALSE; /* every future call to KSPInitialResidual() will have nonzero guess */
+  }
+  ksp->guess_zero = guess_zero; /* restore if user provided nonzero initial guess */
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPReset_SGMRES(KSP ksp)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree2(sgmres->ritzr,sgmres->ritzi);CHKERRQ(ierr);
+  ierr = PetscFree3(sgmres->a,sgmres->b,sgmres->c);CHKERRQ(ierr);
+  ierr = PetscFree7(sgmres->dots,sgmres->C,sgmres->R,sgmres->C2,sgmres->R2,sgmres->Rz,sgmres->M);CHKERRQ(ierr);
+  sgmres->nritz = 0;
+  ierr = KSPReset_GMRES(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPDestroy_SGMRES(KSP ksp)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = KSPReset_SGMRES(ksp);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetSteps_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetBasisType_C",NULL);CHKERRQ(ierr);
+  ierr = KSPDestroy_GMRES(ksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+    KSPSGMRESBuildSoln - create the solution from the starting vector and the
+    current iterates.
+
+    Input parameters:
+        nrs - work area of size it + 1.
+        vs  - index of initial guess
+        vdest - index of result.  Note that vs may == vdest (replace
+                guess with the solution).
+
+     This is an internal routine that knows about the SGMRES internals.
+ */
+static PetscErrorCode KSPSGMRESBuildSoln(PetscScalar *nrs,Vec vs,Vec vdest,KSP ksp,PetscInt it)
+{
+  PetscScalar    tt;
+  PetscErrorCode ierr;
+  PetscInt       ii,k,j;
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)(ksp->data);
+
+  PetscFunctionBegin;
+  /* If it is < 0, no gmres steps have been performed */
+  if (it < 0) {
+    ierr = VecCopy(vs,vdest);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (*HH(it,it) != 0.0) {
+    nrs[it] = *GRS(it) / *HH(it,it);
+  } else {
+    if (ksp->errorifnotconverged) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"You reached the break down in GMRES; HH(it,it) = 0");
+    else ksp->reason = KSP_DIVERGED_BREAKDOWN;
+
+    ierr = PetscInfo2(ksp,"Likely your matrix or preconditioner is singular. HH(it,it) is identically zero; it = %D GRS(it) = %g\n",it,(double)PetscAbsScalar(*GRS(it)));CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  for (ii=1; ii<=it; ii++) {
+    k  = it - ii;
+    tt = *GRS(k);
+    for (j=k+1; j<=it; j++) tt = tt - *HH(k,j) * nrs[j];
+    if (*HH(k,k) == 0.0) {
+      if (ksp->errorifnotconverged) SETERRQ1(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"Likely your matrix or preconditioner is singular. HH(k,k) is identically zero; k = %D\n",k);
+      else {
+        ksp->reason = KSP_DIVERGED_BREAKDOWN;
+        ierr = PetscInfo1(ksp,"Likely your matrix or preconditioner is singular. HH(k,k) is identically zero; k = %D\n",k);CHKERRQ(ierr);
+        PetscFunctionReturn(0);
+      }
+    }
+    nrs[k] = tt / *HH(k,k);
+  }
+
+  /* Accumulate the correction to the solution of the preconditioned problem in TEMP */
+  ierr = VecSet(VEC_TEMP,0.0);CHKERRQ(ierr);
+  ierr = VecMAXPY(VEC_TEMP,it+1,nrs,&VEC_VV(0));CHKERRQ(ierr);
+
+  ierr = KSPUnwindPreconditioner(ksp,VEC_TEMP,VEC_TEMP_MATOP);CHKERRQ(ierr);
+  /* add solution to previous solution */
+  if (vdest != vs) {
+    ierr = VecCopy(vs,vdest);CHKERRQ(ierr);
+  }
+  ierr = VecAXPY(vdest,1.0,VEC_TEMP);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Applies the plane rotations to the Hessenberg column it, exactly as KSPGMRES does. Returns the new residual norm.
+ */
+static PetscErrorCode KSPSGMRESUpdateHessenberg(KSP ksp,PetscInt it,PetscBool hapend,PetscReal *res)
+{
+  PetscScalar *hh,*cc,*ss,tt;
+  PetscInt    j;
+  KSP_SGMRES  *sgmres = (KSP_SGMRES*)(ksp->data);
+
+  PetscFunctionBegin;
+  hh = HH(0,it);
+  cc = CC(0);
+  ss = SS(0);
+
+  /* Apply all the previously computed plane rotations to the new column
+     of the Hessenberg matrix */
+  for (j=1; j<=it; j++) {
+    tt  = *hh;
+    *hh = PetscConj(*cc) * tt + *ss * *(hh+1);
+    hh++;
+    *hh = *cc++ * *hh - (*ss++ * tt);
+  }
+
+  if (!hapend) {
+    tt = PetscSqrtScalar(PetscConj(*hh) * *hh + PetscConj(*(hh+1)) * *(hh+1));
+    if (tt == 0.0) {
+      if (ksp->errorifnotconverged) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_NOT_CONVERGED,"tt == 0.0");
+      else {
+        ksp->reason = KSP_DIVERGED_NULL;
+        PetscFunctionReturn(0);
+      }
+    }
+    *cc        = *hh / tt;
+    *ss        = *(hh+1) / tt;
+    *GRS(it+1) = -(*ss * *GRS(it));
+    *GRS(it)   = PetscConj(*cc) * *GRS(it);
+    *hh        = PetscConj(*cc) * *hh + *ss * *(hh+1);
+    *res       = PetscAbsScalar(*GRS(it+1));
+  } else {
+    /* happy breakdown: HH(it+1, it) = 0, the residual is zero */
+    *res = 0.0;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPBuildSolution_SGMRES(KSP ksp,Vec ptr,Vec *result)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!ptr) {
+    if (!sgmres->sol_temp) {
+      ierr = VecDuplicate(ksp->vec_sol,&sgmres->sol_temp);CHKERRQ(ierr);
+      ierr = PetscLogObjectParent((PetscObject)ksp,(PetscObject)sgmres->sol_temp);CHKERRQ(ierr);
+    }
+    ptr = sgmres->sol_temp;
+  }
+  if (!sgmres->nrs) {
+    /* allocate the work area */
+    ierr = PetscMalloc1(sgmres->max_k,&sgmres->nrs);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory((PetscObject)ksp,sgmres->max_k*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
+
+  ierr = KSPSGMRESBuildSoln(sgmres->nrs,ksp->vec_sol,ptr,ksp,sgmres->it);CHKERRQ(ierr);
+  if (result) *result = ptr;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPView_SGMRES(KSP ksp,PetscViewer viewer)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscErrorCode ierr;
+  PetscBool      iascii,isstring;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERSTRING,&isstring);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerASCIIPrintf(viewer,"  restart=%D, s=%D, %s basis, using %s\n",sgmres->max_k,sgmres->s,KSPSStepBasisTypes[sgmres->basis],sgmres->cholqr2 ? "CholQR2" : "CholQR");CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPrintf(viewer,"  happy breakdown tolerance %g\n",(double)sgmres->haptol);CHKERRQ(ierr);
+  } else if (isstring) {
+    ierr = PetscViewerStringSPrintf(viewer,"restart %D s %D",sgmres->max_k,sgmres->s);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSetFromOptions_SGMRES(PetscOptionItems *PetscOptionsObject,KSP ksp)
+{
+  PetscErrorCode    ierr;
+  PetscInt          restart,s;
+  PetscReal         haptol;
+  KSPSStepBasisType basis;
+  KSP_SGMRES        *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscBool         flg;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsHead(PetscOptionsObject,"KSP s-step GMRES Options");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-ksp_gmres_restart","Number of Krylov search directions","KSPGMRESSetRestart",sgmres->max_k,&restart,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPGMRESSetRestart(ksp,restart);CHKERRQ(ierr); }
+  ierr = PetscOptionsReal("-ksp_gmres_haptol","Tolerance for exact convergence (happy ending)","KSPGMRESSetHapTol",sgmres->haptol,&haptol,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPGMRESSetHapTol(ksp,haptol);CHKERRQ(ierr); }
+  ierr = PetscOptionsInt("-ksp_sstep_s","Number of basis vectors computed between two reductions","KSPSStepSetSteps",sgmres->s,&s,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPSStepSetSteps(ksp,s);CHKERRQ(ierr); }
+  ierr = PetscOptionsEnum("-ksp_sstep_basis","Polynomial basis","KSPSStepSetBasisType",KSPSStepBasisTypes,(PetscEnum)sgmres->basis,(PetscEnum*)&basis,&flg);CHKERRQ(ierr);
+  if (flg) { ierr = KSPSStepSetBasisType(ksp,basis);CHKERRQ(ierr); }
+  ierr = PetscOptionsBool("-ksp_sgmres_cholqr2","Orthogonalize each block twice","KSPSGMRES",sgmres->cholqr2,&sgmres->cholqr2,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSStepSetSteps_SGMRES(KSP ksp,PetscInt s)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (s < 1) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Number of steps must be positive");
+  if (!ksp->setupstage) {
+    sgmres->s = s;
+  } else if (sgmres->s != s) {
+    ierr = KSPReset_SGMRES(ksp);CHKERRQ(ierr);
+    sgmres->s       = s;
+    ksp->setupstage = KSP_SETUP_NEW;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPSStepSetBasisType_SGMRES(KSP ksp,KSPSStepBasisType basis)
+{
+  KSP_SGMRES *sgmres = (KSP_SGMRES*)ksp->data;
+
+  PetscFunctionBegin;
+  if (sgmres->basis != basis) sgmres->nritz = 0;
+  sgmres->basis = basis;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode KSPGMRESSetRestart_SGMRES(KSP ksp,PetscInt max_k)
+{
+  KSP_SGMRES     *sgmres = (KSP_SGMRES*)ksp->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (max_k < 1) SETERRQ(PetscObjectComm((PetscObject)ksp),PETSC_ERR_ARG_OUTOFRANGE,"Restart must be positive");
+  if (!ksp->setupstage) {
+    sgmres->max_k = max_k;
+  } else if (sgmres->max_k != max_k) {
+    ierr = KSPReset_SGMRES(ksp);CHKERRQ(ierr);
+    sgmres->max_k   = max_k;
+    ksp->setupstage = KSP_SETUP_NEW;
+  }
+  PetscFunctionReturn(0);
+}
+
+/*MC
+     KSPSGMRES - Implements s-step GMRES, a communication avoiding variant of GMRES that computes s basis vectors
+                 between two global reductions.
+
+   Options Database Keys:
++   -ksp_gmres_restart <restart> - the number of Krylov directions to orthogonalize against
+.   -ksp_gmres_haptol <tol> - sets the tolerance for "happy ending" (exact convergence)
+.   -ksp_sstep_s <s> - the number of basis vectors computed at once, see KSPSStepSetSteps()
+.   -ksp_sstep_basis <monomial,newton,chebyshev> - the polynomial basis, see KSPSStepSetBasisType()
+-   -ksp_sgmres_cholqr2 <true,false> - orthogonalize each block twice (CholQR2), which costs a second reduction but keeps the basis orthonormal to working accuracy
+
+   Level: intermediate
+
+   Notes:
+    Left and right preconditioning are supported, but not symmetric preconditioning.
+
+    The s new basis vectors are orthogonalized as a block with Cholesky QR. A block that is numerically rank
+    deficient is shrunk automatically; use the Newton or Chebyshev basis for s larger than a few.
+    With the Newton and Chebyshev bases the first restart cycle computes one basis vector at a time to obtain Ritz values.
+
+    When no preconditioner is used (PCNONE) the basis is computed with MatMultBasis(), so for MATMPIAIJ with
+    -mat_mpiaij_matrix_powers the s products need a single exchange of ghost values.
+
+   References:
+.     1. - M. Hoemmen, Communication-avoiding Krylov subspace methods, PhD thesis, UC Berkeley, 2010.
+
+.seealso:  KSPCreate(), KSPSetType(), KSPType (for list of available types), KSP, KSPGMRES, KSPPGMRES, KSPPIPEFGMRES, KSPSCG,
+           KSPGMRESSetRestart(), KSPGMRESSetHapTol(), KSPSStepSetSteps(), KSPSStepSetBasisType(), MatMultBasis()
+M*/
+
+PETSC_EXTERN PetscErrorCode KSPCreate_SGMRES(KSP ksp)
+{
+  KSP_SGMRES     *sgmres;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr      = PetscNewLog(ksp,&sgmres);CHKERRQ(ierr);
+  ksp->data = (void*)sgmres;
+
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_PRECONDITIONED,PC_LEFT,3);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_UNPRECONDITIONED,PC_RIGHT,2);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_RIGHT,1);CHKERRQ(ierr);
+  ierr = KSPSetSupportedNorm(ksp,KSP_NORM_NONE,PC_LEFT,1);CHKERRQ(ierr);
+
+  ksp->ops->buildsolution                = KSPBuildSolution_SGMRES;
+  ksp->ops->setup                        = KSPSetUp_SGMRES;
+  ksp->ops->solve                        = KSPSolve_SGMRES;
+  ksp->ops->reset                        = KSPReset_SGMRES;
+  ksp->ops->destroy                      = KSPDestroy_SGMRES;
+  ksp->ops->view                         = KSPView_SGMRES;
+  ksp->ops->setfromoptions               = KSPSetFromOptions_SGMRES;
+  ksp->ops->computeextremesingularvalues = KSPComputeExtremeSingularValues_GMRES;
+  ksp->ops->computeeigenvalues           = KSPComputeEigenvalues_GMRES;
+
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetRestart_C",KSPGMRESSetRestart_SGMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESGetRestart_C",KSPGMRESGetRestart_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPGMRESSetHapTol_C",KSPGMRESSetHapTol_GMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetSteps_C",KSPSStepSetSteps_SGMRES);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)ksp,"KSPSStepSetBasisType_C",KSPSStepSetBasisType_SGMRES);CHKERRQ(ierr);
+
+  sgmres->haptol         = 1.0e-30;
+  sgmres->q_preallocate  = 1;
+  sgmres->delta_allocate = SGMRES_DEFAULT_MAXK;
+  sgmres->orthog         = 0;
+  sgmres->max_k          = SGMRES_DEFAULT_MAXK;
+  sgmres->cgstype        = KSP_GMRES_CGS_REFINE_NEVER;
+  sgmres->s              = SGMRES_DEFAULT_S;
+  sgmres->basis          = KSP_SSTEP_BASIS_NEWTON;
+  sgmres->cholqr2        = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
@@ -4,6 +4,7 @@
 */
 
 #include <petsc/private/kspimpl.h>   /*I "petscksp.h" I*/
+#include <petsc/private/pcimpl.h>
 #include <petscdm.h>
 
 PETSC_STATIC_INLINE PetscErrorCode ObjectView(PetscObject obj, PetscViewer viewer, PetscViewerFormat format)
@@ -958,6 +959,109 @@ PetscErrorCode  KSPSolveTranspose(KSP ksp,Vec b,Vec x)
   PetscFunctionReturn(0);
 }
 
+/*@
+   KSPMatSolve - Solves a linear system with several right hand sides, stored as the columns of a dense matrix
+
+   Collective on KSP
+
+   Input Parameters:
++  ksp - iterative context obtained from KSPCreate()
+-  B - the right hand sides, a MATDENSE matrix whose rows are distributed like those of the operator
+
+   Output Parameter:
+.  X - the solutions, a MATDENSE matrix with the layout of B; it contains the initial guesses when KSPSetInitialGuessNonzero() is used
+
+   Notes:
+   Block Krylov methods such as KSPBCG and KSPBGMRES solve for all the columns at once: they apply the operator to blocks of
+   vectors and compute the inner products of all the columns with one reduction. With the other methods the columns are
+   solved one after the other with KSPSolve(), as they are with the block methods when the solve uses diagonal scaling, a null
+   space of the transposed operator, a KSPGuess, the Knoll initial guess or pre- and post-solve routines.
+
+   KSPGetConvergedReason() and KSPGetIterationNumber() return the result of the block solve, or of the last column when the
+   columns are solved one after the other.
+
+   Level: intermediate
+
+.keywords: solve, linear system, multiple right hand sides
+
+.seealso: KSPSolve(), KSPBCG, KSPBGMRES, MATDENSE
+@*/
+PetscErrorCode KSPMatSolve(KSP ksp,Mat B,Mat X)
+{
+  PetscErrorCode ierr;
+  Mat            mat,pmat;
+  MatNullSpace   nullsp = NULL;
+  Vec            b,x;
+  PetscScalar    *cb,*cx;
+  PetscInt       M,N,m,n,k,kx,j;
+  PetscBool      flg,block;
+  MPI_Comm       comm;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(ksp,KSP_CLASSID,1);
+  PetscValidHeaderSpecific(B,MAT_CLASSID,2);
+  PetscValidHeaderSpecific(X,MAT_CLASSID,3);
+  PetscCheckSameComm(ksp,1,B,2);
+  PetscCheckSameComm(ksp,1,X,3);
+  comm = PetscObjectComm((PetscObject)ksp);
+  if (B == X) SETERRQ(comm,PETSC_ERR_ARG_IDN,"B and X must be different matrices");
+  ierr = PetscObjectTypeCompareAny((PetscObject)B,&flg,MATSEQDENSE,MATMPIDENSE,"");CHKERRQ(ierr);
+  if (!flg) SETERRQ(comm,PETSC_ERR_ARG_WRONG,"The right hand sides must be stored in a dense matrix");
+  ierr = PetscObjectTypeCompareAny((PetscObject)X,&flg,MATSEQDENSE,MATMPIDENSE,"");CHKERRQ(ierr);
+  if (!flg) SETERRQ(comm,PETSC_ERR_ARG_WRONG,"The solutions must be stored in a dense matrix");
+  ierr = MatGetSize(B,&M,&k);CHKERRQ(ierr);
+  ierr = MatGetSize(X,&N,&kx);CHKERRQ(ierr);
+  ierr = MatGetLocalSize(B,&m,NULL);CHKERRQ(ierr);
+  ierr = MatGetLocalSize(X,&n,NULL);CHKERRQ(ierr);
+  if (M != N || k != kx || m != n) SETERRQ4(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Right hand sides (%D x %D) and solutions (%D x %D) have different layouts",M,k,N,kx);
+
+  if (ksp->pc) {ierr = PCGetOperators(ksp->pc,NULL,&pmat);CHKERRQ(ierr);}
+  if (ksp->pc && pmat) {ierr = MatGetTransposeNullSpace(pmat,&nullsp);CHKERRQ(ierr);}
+  block = (PetscBool)(ksp->ops->matsolve && !(ksp->dm && ksp->dmActive) && !ksp->dscale && !nullsp && !ksp->guess && !ksp->guess_knoll && !ksp->presolve && !ksp->postsolve);
+  if (block && ksp->pc && (ksp->pc->ops->presolve || ksp->pc->ops->postsolve)) block = PETSC_FALSE;
+
+  if (!block) {
+    ierr = MatCreateVecs(B,NULL,&b);CHKERRQ(ierr);
+    ierr = VecDuplicate(b,&x);CHKERRQ(ierr);
+    for (j=0; j<k; j++) {
+      ierr = MatDenseGetColumn(B,j,&cb);CHKERRQ(ierr);
+      ierr = MatDenseGetColumn(X,j,&cx);CHKERRQ(ierr);
+      ierr = VecPlaceArray(b,cb);CHKERRQ(ierr);
+      ierr = VecPlaceArray(x,cx);CHKERRQ(ierr);
+      ierr = KSPSolve(ksp,b,x);CHKERRQ(ierr);
+      ierr = VecResetArray(b);CHKERRQ(ierr);
+      ierr = VecResetArray(x);CHKERRQ(ierr);
+      ierr = MatDenseRestoreColumn(X,&cx);CHKERRQ(ierr);
+      ierr = MatDenseRestoreColumn(B,&cb);CHKERRQ(ierr);
+    }
+    ierr = VecDestroy(&b);CHKERRQ(ierr);
+    ierr = VecDestroy(&x);CHKERRQ(ierr);
+    ierr = PetscObjectStateIncrease((PetscObject)X);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+
+  ierr = KSPSetUp(ksp);CHKERRQ(ierr);
+  ierr = KSPSetUpOnBlocks(ksp);CHKERRQ(ierr);
+  ierr = PCGetOperators(ksp->pc,&mat,&pmat);CHKERRQ(ierr);
+  ierr = MatGetLocalSize(mat,&n,NULL);CHKERRQ(ierr);
+  if (m != n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"The right hand sides have %D local rows, the operator %D",m,n);
+
+  ierr = PetscLogEventBegin(KSP_MatSolve,ksp,B,X,0);CHKERRQ(ierr);
+  if (ksp->res_hist_reset) ksp->res_hist_len = 0;
+  ksp->transpose_solve = PETSC_FALSE;
+  if (ksp->reason != KSP_DIVERGED_PC_FAILED) {
+    ierr = (*ksp->ops->matsolve)(ksp,B,X);CHKERRQ(ierr);
+  }
+  if (!ksp->reason) SETERRQ(comm,PETSC_ERR_PLIB,"Internal error, solver returned without setting converged reason");
+  ksp->totalits += ksp->its;
+  ierr = PetscLogEventEnd(KSP_MatSolve,ksp,B,X,0);CHKERRQ(ierr);
+
+  if (ksp->viewReason) {ierr = KSPReasonView_Internal(ksp, ksp->viewerReason, ksp->formatReason);CHKERRQ(ierr);}
+  if (ksp->view)       {ierr = ObjectView((PetscObject) ksp, ksp->viewer, ksp->format);CHKERRQ(ierr);}
+  if (ksp->errorifnotconverged && ksp->reason < 0 && ksp->reason != KSP_DIVERGED_ITS) SETERRQ1(comm,PETSC_ERR_NOT_CONVERGED,"KSPMatSolve has not converged, reason %s",KSPConvergedReasons[ksp->reason]);
+  PetscFunctionReturn(0);
+}
+
 /*@
    KSPReset - Resets a KSP context to the kspsetupcalled = 0 state and removes any allocated Vecs and Mats
 
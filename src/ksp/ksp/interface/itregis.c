@@ -8,6 +8,7 @@ PETSC_EXTERN PetscErrorCode KSPCreate_GROPPCG(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_PIPECG(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_PIPECGRR(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_PIPELCG(KSP);
+PETSC_EXTERN PetscErrorCode KSPCreate_SCG(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_CGNE(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_CGNASH(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_CGSTCG(KSP);
@@ -39,12 +40,17 @@ PETSC_EXTERN PetscErrorCode KSPCreate_LCD(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_GCR(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_PIPEGCR(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_PGMRES(KSP);
+PETSC_EXTERN PetscErrorCode KSPCreate_SGMRES(KSP);
+PETSC_EXTERN PetscErrorCode KSPCreate_PIPELGMRES(KSP);
+PETSC_EXTERN PetscErrorCode KSPCreate_GCRODR(KSP);
 #if !defined(PETSC_USE_COMPLEX)
 PETSC_EXTERN PetscErrorCode KSPCreate_DGMRES(KSP);
 #endif
 PETSC_EXTERN PetscErrorCode KSPCreate_TSIRM(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_CGLS(KSP);
 PETSC_EXTERN PetscErrorCode KSPCreate_FETIDP(KSP);
+PETSC_EXTERN PetscErrorCode KSPCreate_BCG(KSP);
+PETSC_EXTERN PetscErrorCode KSPCreate_BGMRES(KSP);
 
 /*@C
   KSPRegisterAll - Registers all of the Krylov subspace methods in the KSP package.
@@ -70,6 +76,7 @@ PetscErrorCode  KSPRegisterAll(void)
   ierr = KSPRegister(KSPPIPECG,      KSPCreate_PIPECG);CHKERRQ(ierr);
   ierr = KSPRegister(KSPPIPECGRR,    KSPCreate_PIPECGRR);CHKERRQ(ierr);
   ierr = KSPRegister(KSPPIPELCG,     KSPCreate_PIPELCG);CHKERRQ(ierr);
+  ierr = KSPRegister(KSPSCG,         KSPCreate_SCG);CHKERRQ(ierr);
   ierr = KSPRegister(KSPCGNE,        KSPCreate_CGNE);CHKERRQ(ierr);
   ierr = KSPRegister(KSPCGNASH,      KSPCreate_CGNASH);CHKERRQ(ierr);
   ierr = KSPRegister(KSPCGSTCG,      KSPCreate_CGSTCG);CHKERRQ(ierr);
@@ -103,12 +110,17 @@ PetscErrorCode  KSPRegisterAll(void)
   ierr = KSPRegister(KSPGCR,         KSPCreate_GCR);CHKERRQ(ierr);
   ierr = KSPRegister(KSPPIPEGCR,     KSPCreate_PIPEGCR);CHKERRQ(ierr);
   ierr = KSPRegister(KSPPGMRES,      KSPCreate_PGMRES);CHKERRQ(ierr);
+  ierr = KSPRegister(KSPSGMRES,      KSPCreate_SGMRES);CHKERRQ(ierr);
+  ierr = KSPRegister(KSPPIPELGMRES,  KSPCreate_PIPELGMRES);CHKERRQ(ierr);
+  ierr = KSPRegister(KSPGCRODR,      KSPCreate_GCRODR);CHKERRQ(ierr);
 #if !defined(PETSC_USE_COMPLEX)
   ierr = KSPRegister(KSPDGMRES,      KSPCreate_DGMRES);CHKERRQ(ierr);
 #endif
   ierr = KSPRegister(KSPTSIRM,       KSPCreate_TSIRM);CHKERRQ(ierr);
   ierr = KSPRegister(KSPCGLS,        KSPCreate_CGLS);CHKERRQ(ierr);
   ierr = KSPRegister(KSPFETIDP,      KSPCreate_FETIDP);CHKERRQ(ierr);
+  ierr = KSPRegister(KSPBCG,         KSPCreate_BCG);CHKERRQ(ierr);
+  ierr = KSPRegister(KSPBGMRES,      KSPCreate_BGMRES);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -0,0 +1,177 @@
+/*
+    Code shared by the s-step (communication avoiding) Krylov methods KSPSGMRES and KSPSCG
+*/
+#include <petsc/private/kspimpl.h>   /*I "petscksp.h" I*/
+
+/*@
+   KSPSStepSetSteps - Sets the number of basis vectors an s-step Krylov method computes between two global reductions
+
+   Logically Collective on KSP
+
+   Input Parameters:
++  ksp - the Krylov space context
+-  s - the number of steps
+
+   Options Database:
+.  -ksp_sstep_s <s> - the number of steps
+
+   Notes:
+   The s vectors are computed by a polynomial recurrence, see KSPSStepSetBasisType(), and are then orthogonalized as a block
+   with a single global reduction. Large values of s make the basis ill conditioned; the methods then shrink the block
+   automatically, which costs extra reductions.
+
+   Level: intermediate
+
+.keywords: KSP, s-step, communication avoiding
+
+.seealso: KSPSGMRES, KSPSCG, KSPSStepSetBasisType(), MatMultBasis()
+@*/
+PetscErrorCode KSPSStepSetSteps(KSP ksp,PetscInt s)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(ksp,KSP_CLASSID,1);
+  PetscValidLogicalCollectiveInt(ksp,s,2);
+  ierr = PetscTryMethod(ksp,"KSPSStepSetSteps_C",(KSP,PetscInt),(ksp,s));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@
+   KSPSStepSetBasisType - Sets the polynomial basis an s-step Krylov method uses to compute its s basis vectors
+
+   Logically Collective on KSP
+
+   Input Parameters:
++  ksp - the Krylov space context
+-  type - the basis, KSP_SSTEP_BASIS_MONOMIAL, KSP_SSTEP_BASIS_NEWTON or KSP_SSTEP_BASIS_CHEBYSHEV
+
+   Options Database:
+.  -ksp_sstep_basis <monomial,newton,chebyshev> - the basis
+
+   Notes:
+   The Newton basis uses the Ritz values of the operator in Leja order as shifts; the Chebyshev basis uses the interval
+   spanned by their real parts. The Ritz values are obtained from the first iterations of the solve, which are run with s = 1,
+   and are kept for later solves as long as the operators are unchanged. The monomial basis needs no Ritz values but is only
+   well conditioned for small s.
+
+   Level: intermediate
+
+.keywords: KSP, s-step, communication avoiding
+
+.seealso: KSPSGMRES, KSPSCG, KSPSStepSetSteps(), KSPSStepBasisType
+@*/
+PetscErrorCode KSPSStepSetBasisType(KSP ksp,KSPSStepBasisType type)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(ksp,KSP_CLASSID,1);
+  PetscValidLogicalCollectiveEnum(ksp,type,2);
+  ierr = PetscTryMethod(ksp,"KSPSStepSetBasisType_C",(KSP,KSPSStepBasisType),(ksp,type));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPSStepBasisCoefficients_Private - Computes the coefficients of the recurrence
+
+       W[t+1] = ((A - a[t]) W[t] - b[t] W[t-1])/c[t],  t = 0,...,s-1
+
+   used by MatMultBasis() from the m Ritz values re[] + i im[] (im may be NULL). Without Ritz values the monomial basis is returned.
+
+   In real arithmetic a complex conjugate pair of Ritz values occupies two consecutive steps so the basis stays real.
+*/
+PetscErrorCode KSPSStepBasisCoefficients_Private(KSPSStepBasisType type,PetscInt m,const PetscReal re[],const PetscReal im[],PetscInt s,PetscScalar a[],PetscScalar b[],PetscScalar c[])
+{
+  PetscErrorCode ierr;
+  PetscInt       i,j,t,best,nsel;
+  PetscReal      lmin,lmax,d,h,dist,bestdist,*sre,*sim;
+  PetscBool      *used;
+
+  PetscFunctionBegin;
+  for (t=0; t<s; t++) {a[t] = 0.0; b[t] = 0.0; c[t] = 1.0;}
+  if (!m || type == KSP_SSTEP_BASIS_MONOMIAL) PetscFunctionReturn(0);
+  if (type == KSP_SSTEP_BASIS_CHEBYSHEV) {
+    lmin = lmax = re[0];
+    for (i=1; i<m; i++) {lmin = PetscMin(lmin,re[i]); lmax = PetscMax(lmax,re[i]);}
+    d = 0.5*(lmax + lmin);
+    h = 0.5*(lmax - lmin);
+    if (h <= PETSC_SMALL*PetscAbsReal(d)) h = d != 0.0 ? PetscAbsReal(d) : 1.0;
+    for (t=0; t<s; t++) {
+      a[t] = d;
+      b[t] = t ? 0.5*h : 0.0;
+      c[t] = t ? 0.5*h : h;
+    }
+    PetscFunctionReturn(0);
+  }
+
+  /* Newton basis: the Ritz values in modified Leja order, starting over when they are used up */
+  ierr = PetscMalloc3(s,&sre,s,&sim,m,&used);CHKERRQ(ierr);
+  for (i=0; i<m; i++) used[i] = PETSC_FALSE;
+  nsel = 0;
+  for (t=0; t<s; ) {
+    best = -1; bestdist = PETSC_MIN_REAL;
+    for (i=0; i<m; i++) {
+#if !defined(PETSC_USE_COMPLEX)
+      if (used[i] || (im && im[i] < 0.0)) continue;
+#else
+      if (used[i]) continue;
+#endif
+      if (!nsel) dist = PetscLogReal(1.0 + PetscSqrtReal(re[i]*re[i] + (im ? im[i]*im[i] : 0.0)));
+      else {
+        dist = 0.0;
+        for (j=0; j<nsel && dist > PETSC_MIN_REAL; j++) {
+          PetscReal dr = re[i] - sre[j],di = (im ? im[i] : 0.0) - sim[j],r = PetscSqrtReal(dr*dr + di*di);
+          dist = r > 0.0 ? dist + PetscLogReal(r) : PETSC_MIN_REAL;
+        }
+      }
+      if (best < 0 || dist > bestdist) {best = i; bestdist = dist;}
+    }
+    if (best < 0) {
+      if (!nsel) break;
+      for (i=0; i<m; i++) used[i] = PETSC_FALSE;
+      nsel = 0;
+      continue;
+    }
+    used[best] = PETSC_TRUE;
+    sre[nsel]  = re[best];
+    sim[nsel]  = im ? im[best] : 0.0;
+    nsel++;
+#if !defined(PETSC_USE_COMPLEX)
+    a[t++] = re[best];
+    if (im && im[best] > 0.0 && t < s) {
+      a[t]   = re[best];
+      b[t++] = -im[best]*im[best];
+    }
+#else
+    a[t++] = re[best] + PETSC_i*(im ? im[best] : 0.0);
+#endif
+  }
+  ierr = PetscFree3(sre,sim,used);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   KSPSStepUseMatMultBasis_Private - Determines if the s-step methods may hand the operator to MatMultBasis(); this is only
+   the case when the preconditioned operator is the matrix itself.
+*/
+PetscErrorCode KSPSStepUseMatMultBasis_Private(KSP ksp,PetscBool *flg)
+{
+  PetscErrorCode ierr;
+  PetscBool      isnone,scale;
+  Mat            Amat;
+  MatNullSpace   nullsp;
+
+  PetscFunctionBegin;
+  *flg = PETSC_FALSE;
+  if (ksp->transpose_solve) PetscFunctionReturn(0);
+  ierr = PetscObjectTypeCompare((PetscObject)ksp->pc,PCNONE,&isnone);CHKERRQ(ierr);
+  if (!isnone) PetscFunctionReturn(0);
+  ierr = PCGetDiagonalScale(ksp->pc,&scale);CHKERRQ(ierr);
+  if (scale) PetscFunctionReturn(0);
+  ierr = PCGetOperators(ksp->pc,&Amat,NULL);CHKERRQ(ierr);
+  ierr = MatGetNullSpace(Amat,&nullsp);CHKERRQ(ierr);
+  if (nullsp) PetscFunctionReturn(0);
+  *flg = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,141 @@
+static char help[] = "Tests and benchmarks the SEQSELL kernels selected at runtime with -mat_sell_simd.\n\
+  -m <m>, -n <n>     : grid dimensions of the convection-diffusion operator\n\
+  -benchmark         : time MatMult() with each available kernel and report the achieved memory bandwidth\n\
+  -its <its>         : number of products timed with -benchmark\n\
+  -stream_bw <MB/s>  : bandwidth measured by 'make streams' in $PETSC_DIR, used to report the fraction obtained\n\n";
+
+/*
+   Compares MatMult(), MatMultAdd(), MatMultTranspose() and MatMultTransposeAdd() with each SELL kernel that the
+   processor supports against SEQAIJ. The bandwidth reported with -benchmark counts the matrix values and column
+   indices including the padding of the slices, one read of x and one write of y; it can be compared with the
+   Triad rate printed by the STREAMS benchmark in src/benchmarks/streams.
+*/
+#include <petscmat.h>
+#include <petsctime.h>
+
+int main(int argc,char **argv)
+{
+  Mat            A,S;
+  Vec            x,y,z,yref,zref;
+  PetscInt       m = 17,n = 13,N,i,j,row,col,k,its = 100;
+  PetscScalar    v;
+  PetscReal      err,maxerr = 0.0,streambw = 0.0,tol = 1000*PETSC_MACHINE_EPSILON;
+  PetscBool      avx2,avx512,benchmark = PETSC_FALSE;
+  PetscLogDouble t0,t1,bytes;
+  MatInfo        info;
+  const char     *kernels[] = {"generic","avx2","avx512"};
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = PetscOptionsGetInt(NULL,NULL,"-m",&m,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-its",&its,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(NULL,NULL,"-benchmark",&benchmark,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetReal(NULL,NULL,"-stream_bw",&streambw,NULL);CHKERRQ(ierr);
+  N    = m*n;
+
+  /* nonsymmetric operator so that the transpose products are tested; the number of rows need not be a multiple of 8 */
+  ierr = MatCreateSeqAIJ(PETSC_COMM_SELF,N,N,5,NULL,&A);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    for (j=0; j<n; j++) {
+      row = i*n+j;
+      v   = 4.0;
+      ierr = MatSetValues(A,1,&row,1,&row,&v,INSERT_VALUES);CHKERRQ(ierr);
+      if (i>0)   {col = row-n; v = -1.5; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+      if (i<m-1) {col = row+n; v = -0.5; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+      if (j>0)   {col = row-1; v = -1.25; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+      if (j<n-1 && (i+j)%3) {col = row+1; v = -0.75; ierr = MatSetValues(A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = MatCreateVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&z);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&yref);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&zref);CHKERRQ(ierr);
+  for (i=0; i<N; i++) {
+    v    = 1.0/(i+1.0) + (i%7);
+    ierr = VecSetValue(x,i,v,INSERT_VALUES);CHKERRQ(ierr);
+    v    = (i%5) - 2.0;
+    ierr = VecSetValue(z,i,v,INSERT_VALUES);CHKERRQ(ierr);
+  }
+  ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+  ierr = VecAssemblyBegin(z);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(z);CHKERRQ(ierr);
+
+  ierr = PetscAVXIsEnabled(&avx2,&avx512);CHKERRQ(ierr);
+  for (k=0; k<3; k++) {
+    if ((k == 1 && !avx2) || (k == 2 && !avx512)) continue;
+    ierr = PetscOptionsSetValue(NULL,"-mat_sell_simd",kernels[k]);CHKERRQ(ierr);
+    ierr = MatConvert(A,MATSEQSELL,MAT_INITIAL_MATRIX,&S);CHKERRQ(ierr);
+    ierr = PetscOptionsClearValue(NULL,"-mat_sell_simd");CHKERRQ(ierr);
+
+    ierr = MatMult(A,x,yref);CHKERRQ(ierr);
+    ierr = MatMult(S,x,y);CHKERRQ(ierr);
+    ierr = VecAXPY(y,-1.0,yref);CHKERRQ(ierr);
+    ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+    maxerr = PetscMax(maxerr,err);
+
+    ierr = MatMultAdd(A,x,z,zref);CHKERRQ(ierr);
+    ierr = MatMultAdd(S,x,z,y);CHKERRQ(ierr);
+    ierr = VecAXPY(y,-1.0,zref);CHKERRQ(ierr);
+    ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+    maxerr = PetscMax(maxerr,err);
+
+    ierr = MatMultTranspose(A,x,yref);CHKERRQ(ierr);
+    ierr = MatMultTranspose(S,x,y);CHKERRQ(ierr);
+    ierr = VecAXPY(y,-1.0,yref);CHKERRQ(ierr);
+    ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+    maxerr = PetscMax(maxerr,err);
+
+    ierr = MatMultTransposeAdd(A,x,z,zref);CHKERRQ(ierr);
+    ierr = MatMultTransposeAdd(S,x,z,y);CHKERRQ(ierr);
+    ierr = VecAXPY(y,-1.0,zref);CHKERRQ(ierr);
+    ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+    maxerr = PetscMax(maxerr,err);
+    if (maxerr > tol) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_PLIB,"SELL kernel %s differs from AIJ by %g",kernels[k],(double)maxerr);
+
+    if (benchmark) {
+      ierr = MatGetInfo(S,MAT_LOCAL,&info);CHKERRQ(ierr);
+      bytes = info.nz_used*(sizeof(PetscScalar)+sizeof(PetscInt)) + 2.0*N*sizeof(PetscScalar);
+      ierr = MatMult(S,x,y);CHKERRQ(ierr);
+      ierr = PetscTime(&t0);CHKERRQ(ierr);
+      for (i=0; i<its; i++) {
+        ierr = MatMult(S,x,y);CHKERRQ(ierr);
+      }
+      ierr = PetscTime(&t1);CHKERRQ(ierr);
+      ierr = PetscPrintf(PETSC_COMM_SELF,"%-8s MatMult %10.4e s  %9.1f MB/s",kernels[k],(t1-t0)/its,1.e-6*bytes*its/(t1-t0));CHKERRQ(ierr);
+      if (streambw > 0.0) {
+        ierr = PetscPrintf(PETSC_COMM_SELF,"  %5.1f%% of STREAMS",100.0*1.e-6*bytes*its/(t1-t0)/streambw);CHKERRQ(ierr);
+      }
+      ierr = PetscPrintf(PETSC_COMM_SELF,"\n");CHKERRQ(ierr);
+    }
+    ierr = MatDestroy(&S);CHKERRQ(ierr);
+  }
+  if (!benchmark) {
+    ierr = PetscPrintf(PETSC_COMM_SELF,"All available SELL kernels agree with AIJ\n");CHKERRQ(ierr);
+  }
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  ierr = VecDestroy(&yref);CHKERRQ(ierr);
+  ierr = VecDestroy(&zref);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      args: -m 37 -n 23
+
+   test:
+      suffix: 2
+      args: -m 8 -n 11 -disable_avx
+      output_file: output/ex228_1.out
+
+TEST*/
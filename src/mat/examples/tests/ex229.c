@@ -0,0 +1,392 @@
+static char help[] = "Tests the variants of the AIJ MatMult() kernels selected with options against the standard kernels.\n\
+  -check <precision,compressed,split,dense> : the variant tested, see below\n\
+  -m <m>, -n <n>     : grid dimensions of the convection-diffusion operator\n\
+  -wide              : add a coupling between the first and the last unknown\n\n";
+
+/*
+   All variants are tested on the same nonsymmetric operator, whose values are not exactly representable in single
+   precision. A is the reference matrix; C, when used, is the same matrix created with the options prefix c_, so that
+   the options of the variant are given to C only.
+
+   The sequential blocks of an MPIAIJ matrix read the options without prefix, so with more than one process options
+   such as -mat_no_inode apply to both A and C.
+
+   precision  - MatMult() and MatMultAdd() with the values stored in single precision and bfloat16
+                (MatAIJSetMultPrecision()) have relative errors of the order of the unit roundoff of that precision,
+                also after the matrix is changed. Rows with i == 2 are empty to exercise compressed rows.
+   compressed - MatMult(), MatMultAdd() and MatSOR() of C with -c_mat_aij_compressed_indices agree with those of A,
+                also after new nonzeros. With -wide and a grid with more than 32768 unknowns the 16 bit offsets do not
+                fit, so the standard kernels must be used.
+   split      - MatMult() and MatMultAdd() of C with -c_mat_mpiaij_split_mult or -c_mat_mpiaij_progress_rows agree
+                with those of A, also after new off-process entries.
+   dense      - MatMatMult() of A with dense matrices of 1 to 70 columns, covering the remainders of the blocks of
+                columns of the kernel, agrees with MatMult() of each column, also with MAT_REUSE_MATRIX.
+*/
+#include <petscmat.h>
+
+typedef enum {CHECK_PRECISION,CHECK_COMPRESSED,CHECK_SPLIT,CHECK_DENSE} CheckType;
+static const char *const CheckTypes[] = {"precision","compressed","split","dense","CheckType","CHECK_",0};
+
+static PetscErrorCode FormMatrix(PetscInt m,PetscInt n,const char prefix[],PetscBool emptyrows,PetscBool wide,Mat *A)
+{
+  PetscInt       N = m*n,i,j,row,col,Istart,Iend;
+  PetscScalar    v;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatCreate(PETSC_COMM_WORLD,A);CHKERRQ(ierr);
+  ierr = MatSetOptionsPrefix(*A,prefix);CHKERRQ(ierr);
+  ierr = MatSetSizes(*A,PETSC_DECIDE,PETSC_DECIDE,N,N);CHKERRQ(ierr);
+  ierr = MatSetFromOptions(*A);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation(*A,6,NULL);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetPreallocation(*A,6,NULL,2,NULL);CHKERRQ(ierr);
+  ierr = MatSetOption(*A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(*A,&Istart,&Iend);CHKERRQ(ierr);
+  for (row=Istart; row<Iend; row++) {
+    i = row/n; j = row - i*n;
+    if (emptyrows && i == 2) continue;
+    v    = 4.0 + 1.0/(row+3.0);
+    ierr = MatSetValues(*A,1,&row,1,&row,&v,INSERT_VALUES);CHKERRQ(ierr);
+    if (i>0)   {col = row-n; v = -1.1; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (i<m-1) {col = row+n; v = -0.9; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j>0)   {col = row-1; v = -1.0/3.0; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j<n-1) {col = row+1; v = -2.0/3.0; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (wide && (row == 0 || row == N-1)) {col = N-1-row; v = 0.1; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+  }
+  ierr = MatAssemblyBegin(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Fails when y differs from yref by more than tol relative to yref, and leaves y - yref in y */
+static PetscErrorCode CheckDifference(Vec y,Vec yref,PetscReal tol,const char *name)
+{
+  PetscReal      err,nrm;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecNorm(yref,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+  ierr = VecAXPY(y,-1.0,yref);CHKERRQ(ierr);
+  ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+  if (err > tol*nrm) SETERRQ3(PETSC_COMM_WORLD,PETSC_ERR_PLIB,"%s has relative error %g > %g",name,(double)(err/nrm),(double)tol);
+  PetscFunctionReturn(0);
+}
+
+/* MatMult(), MatMultAdd() and in place MatMultAdd() of C against those of A */
+static PetscErrorCode CheckProducts(Mat A,Mat C,Vec x,Vec z,PetscReal tol,const char *variant)
+{
+  Vec            y,yref;
+  char           name[128];
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatCreateVecs(A,NULL,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&yref);CHKERRQ(ierr);
+  ierr = MatMult(A,x,yref);CHKERRQ(ierr);
+  ierr = MatMult(C,x,y);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(name,sizeof(name),"MatMult() with %s",variant);CHKERRQ(ierr);
+  ierr = CheckDifference(y,yref,tol,name);CHKERRQ(ierr);
+  ierr = MatMultAdd(A,x,z,yref);CHKERRQ(ierr);
+  ierr = MatMultAdd(C,x,z,y);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(name,sizeof(name),"MatMultAdd() with %s",variant);CHKERRQ(ierr);
+  ierr = CheckDifference(y,yref,tol,name);CHKERRQ(ierr);
+  ierr = VecCopy(z,y);CHKERRQ(ierr);
+  ierr = MatMultAdd(C,x,y,y);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(name,sizeof(name),"In place MatMultAdd() with %s",variant);CHKERRQ(ierr);
+  ierr = CheckDifference(y,yref,tol,name);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&yref);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode CheckPrecision(Mat A,Vec x,Vec z)
+{
+  Mat                 Alow;
+  PetscReal           tols[] = {0.0,1.e-6,1.e-2};
+  MatAIJMultPrecision precisions[] = {MAT_AIJ_MULT_DOUBLE,MAT_AIJ_MULT_SINGLE,MAT_AIJ_MULT_BFLOAT16};
+  PetscInt            k;
+  PetscErrorCode      ierr;
+
+  PetscFunctionBegin;
+  for (k=0; k<3; k++) {
+    const char *name = MatAIJMultPrecisions[precisions[k]];
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&Alow);CHKERRQ(ierr);
+    ierr = MatAIJSetMultPrecision(Alow,precisions[k]);CHKERRQ(ierr);
+    ierr = CheckProducts(A,Alow,x,z,tols[k],name);CHKERRQ(ierr);
+    /* the low precision values must follow changes of the matrix */
+    ierr = MatScale(A,-2.0);CHKERRQ(ierr);
+    ierr = MatScale(Alow,-2.0);CHKERRQ(ierr);
+    ierr = CheckProducts(A,Alow,x,z,tols[k],name);CHKERRQ(ierr);
+    ierr = MatShift(A,1.5);CHKERRQ(ierr);
+    ierr = MatShift(Alow,1.5);CHKERRQ(ierr);
+    ierr = CheckProducts(A,Alow,x,z,tols[k],name);CHKERRQ(ierr);
+    ierr = MatScale(A,0.5);CHKERRQ(ierr);
+    ierr = MatCopy(A,Alow,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+    ierr = CheckProducts(A,Alow,x,z,tols[k],name);CHKERRQ(ierr);
+    ierr = MatDestroy(&Alow);CHKERRQ(ierr);
+  }
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Low precision products agree with double precision to the expected accuracy\n");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Adds the same entries, which are new nonzeros, to A and C */
+static PetscErrorCode AddEntries(Mat A,Mat C,PetscInt n,const PetscInt rows[],const PetscInt cols[],PetscScalar v)
+{
+  PetscInt       k;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (k=0; k<n; k++) {
+    ierr = MatSetValues(A,1,&rows[k],1,&cols[k],&v,INSERT_VALUES);CHKERRQ(ierr);
+    ierr = MatSetValues(C,1,&rows[k],1,&cols[k],&v,INSERT_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode CheckCompressed(Mat A,Mat C,Vec x,Vec z,PetscBool wide)
+{
+  Vec            y,yref;
+  PetscInt       N,Istart,Iend,row,j,k,n = 0,*rows,*cols;
+  PetscReal      omegas[] = {1.0,1.3},tol = 100*PETSC_MACHINE_EPSILON;
+  MatSORType     flags[] = {(MatSORType)(SOR_LOCAL_FORWARD_SWEEP | SOR_ZERO_INITIAL_GUESS),SOR_LOCAL_BACKWARD_SWEEP,
+                            (MatSORType)(SOR_LOCAL_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),SOR_LOCAL_SYMMETRIC_SWEEP,SOR_LOCAL_FORWARD_SWEEP};
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(A,&N,NULL);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&Istart,&Iend);CHKERRQ(ierr);
+  ierr = MatCreateVecs(A,NULL,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&yref);CHKERRQ(ierr);
+  ierr = CheckProducts(A,C,x,z,tol,"compressed indices");CHKERRQ(ierr);
+  for (j=0; j<2; j++) {
+    for (k=0; k<5; k++) {
+      ierr = VecCopy(x,yref);CHKERRQ(ierr);
+      ierr = VecCopy(x,y);CHKERRQ(ierr);
+      ierr = MatSOR(A,z,omegas[j],flags[k],0.0,2,1,yref);CHKERRQ(ierr);
+      ierr = MatSOR(C,z,omegas[j],flags[k],0.0,2,1,y);CHKERRQ(ierr);
+      ierr = CheckDifference(y,yref,tol,"MatSOR() with compressed indices");CHKERRQ(ierr);
+    }
+  }
+
+  /* the offsets must follow a change of the nonzero structure (one malloc per row, so skipped for the large grid) */
+  ierr = PetscMalloc2(Iend-Istart,&rows,Iend-Istart,&cols);CHKERRQ(ierr);
+  for (row=Istart; row<Iend; row++) {
+    if (row+2 < N && !wide) {rows[n] = row; cols[n++] = row+2;}
+  }
+  ierr = AddEntries(A,C,n,rows,cols,0.25);CHKERRQ(ierr);
+  ierr = PetscFree2(rows,cols);CHKERRQ(ierr);
+  ierr = CheckProducts(A,C,x,z,tol,"compressed indices after new nonzeros");CHKERRQ(ierr);
+  ierr = VecCopy(x,yref);CHKERRQ(ierr);
+  ierr = VecCopy(x,y);CHKERRQ(ierr);
+  ierr = MatSOR(A,z,1.0,SOR_LOCAL_SYMMETRIC_SWEEP,0.0,1,1,yref);CHKERRQ(ierr);
+  ierr = MatSOR(C,z,1.0,SOR_LOCAL_SYMMETRIC_SWEEP,0.0,1,1,y);CHKERRQ(ierr);
+  ierr = CheckDifference(y,yref,tol,"MatSOR() with compressed indices after new nonzeros");CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&yref);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Kernels with compressed indices agree\n");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode CheckSplit(Mat A,Mat C,Vec x,Vec z)
+{
+  Mat            D;
+  PetscInt       N,Istart,Iend,row,n = 0,rows[2],cols[2];
+  PetscReal      tol = 100*PETSC_MACHINE_EPSILON;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(A,&N,NULL);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&Istart,&Iend);CHKERRQ(ierr);
+  ierr = CheckProducts(A,C,x,z,tol,"split rows");CHKERRQ(ierr);
+  /* couple the first and last rows; this changes the off-diagonal blocks and hence the interior rows */
+  for (row=Istart; row<Iend; row++) {
+    if (row == 0 || row == N-1) {rows[n] = row; cols[n++] = N-1-row;}
+  }
+  ierr = AddEntries(A,C,n,rows,cols,0.1);CHKERRQ(ierr);
+  ierr = CheckProducts(A,C,x,z,tol,"split rows after new nonzeros");CHKERRQ(ierr);
+  ierr = MatDuplicate(C,MAT_COPY_VALUES,&D);CHKERRQ(ierr);
+  ierr = CheckProducts(A,D,x,z,tol,"split rows of a duplicate");CHKERRQ(ierr);
+  ierr = MatDestroy(&D);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Products with split rows agree\n");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode CheckDense(Mat A)
+{
+  Mat            B,C;
+  Vec            x,y,yref;
+  PetscInt       N,Istart,Iend,row,k,c;
+  PetscInt       ks[] = {1,2,3,5,8,31,32,33,70};
+  PetscScalar    *b;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(A,&N,NULL);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&Istart,&Iend);CHKERRQ(ierr);
+  ierr = MatCreateVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&yref);CHKERRQ(ierr);
+  for (k=0; k<(PetscInt)(sizeof(ks)/sizeof(ks[0])); k++) {
+    ierr = MatCreateDense(PETSC_COMM_WORLD,Iend-Istart,PETSC_DECIDE,N,ks[k],NULL,&B);CHKERRQ(ierr);
+    ierr = MatDenseGetArray(B,&b);CHKERRQ(ierr);
+    for (c=0; c<ks[k]; c++) {
+      for (row=Istart; row<Iend; row++) b[c*(Iend-Istart) + row-Istart] = 1.0/(row+c+1.0) + ((row+3*c)%7);
+    }
+    ierr = MatDenseRestoreArray(B,&b);CHKERRQ(ierr);
+    ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+    ierr = MatMatMult(A,B,MAT_INITIAL_MATRIX,PETSC_DEFAULT,&C);CHKERRQ(ierr);
+    ierr = MatScale(B,-0.5);CHKERRQ(ierr);
+    ierr = MatMatMult(A,B,MAT_REUSE_MATRIX,PETSC_DEFAULT,&C);CHKERRQ(ierr);
+    for (c=0; c<ks[k]; c++) {
+      char name[64];
+      ierr = MatGetColumnVector(B,x,c);CHKERRQ(ierr);
+      ierr = MatMult(A,x,yref);CHKERRQ(ierr);
+      ierr = MatGetColumnVector(C,y,c);CHKERRQ(ierr);
+      ierr = PetscSNPrintf(name,sizeof(name),"Column %D of MatMatMult() with %D columns",c,ks[k]);CHKERRQ(ierr);
+      ierr = CheckDifference(y,yref,100*PETSC_MACHINE_EPSILON,name);CHKERRQ(ierr);
+    }
+    ierr = MatDestroy(&B);CHKERRQ(ierr);
+    ierr = MatDestroy(&C);CHKERRQ(ierr);
+  }
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&yref);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"MatMatMult() agrees with MatMult() of each column\n");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+int main(int argc,char **argv)
+{
+  Mat            A,C = NULL;
+  Vec            x,z;
+  PetscInt       m = 17,n = 13,row,Istart,Iend;
+  PetscScalar    v;
+  PetscBool      wide = PETSC_FALSE;
+  CheckType      check = CHECK_PRECISION;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = PetscOptionsGetEnum(NULL,NULL,"-check",CheckTypes,(PetscEnum*)&check,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-m",&m,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(NULL,NULL,"-wide",&wide,NULL);CHKERRQ(ierr);
+
+  /* SOR needs the diagonal, so only the checks of the products have empty rows */
+  ierr = FormMatrix(m,n,NULL,(PetscBool)(check == CHECK_PRECISION || check == CHECK_DENSE),wide,&A);CHKERRQ(ierr);
+  if (check == CHECK_COMPRESSED || check == CHECK_SPLIT) {ierr = FormMatrix(m,n,"c_",PETSC_FALSE,wide,&C);CHKERRQ(ierr);}
+
+  ierr = MatCreateVecs(A,&x,&z);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&Istart,&Iend);CHKERRQ(ierr);
+  for (row=Istart; row<Iend; row++) {
+    v    = 1.0/(row+1.0) + (row%7);
+    ierr = VecSetValue(x,row,v,INSERT_VALUES);CHKERRQ(ierr);
+    v    = (row%5) - 2.0;
+    ierr = VecSetValue(z,row,v,INSERT_VALUES);CHKERRQ(ierr);
+  }
+  ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+  ierr = VecAssemblyBegin(z);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(z);CHKERRQ(ierr);
+
+  switch (check) {
+  case CHECK_PRECISION:  ierr = CheckPrecision(A,x,z);CHKERRQ(ierr); break;
+  case CHECK_COMPRESSED: ierr = CheckCompressed(A,C,x,z,wide);CHKERRQ(ierr); break;
+  case CHECK_SPLIT:      ierr = CheckSplit(A,C,x,z);CHKERRQ(ierr); break;
+  case CHECK_DENSE:      ierr = CheckDense(A);CHKERRQ(ierr); break;
+  }
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      suffix: precision
+      requires: double !complex
+      args: -check precision
+
+   test:
+      suffix: precision_2
+      nsize: 2
+      requires: double !complex
+      args: -check precision
+      output_file: output/ex229_precision.out
+
+   test:
+      suffix: precision_threads
+      nsize: 2
+      requires: double !complex openmp
+      args: -check precision -mat_aij_threads 2
+      output_file: output/ex229_precision.out
+
+   test:
+      suffix: compressed
+      args: -check compressed -mat_no_inode -c_mat_no_inode -c_mat_aij_compressed_indices
+
+   test:
+      suffix: compressed_2
+      nsize: 2
+      args: -check compressed -mat_no_inode -c_mat_aij_compressed_indices
+      output_file: output/ex229_compressed.out
+
+   test:
+      suffix: compressed_wide
+      args: -check compressed -mat_no_inode -c_mat_no_inode -c_mat_aij_compressed_indices -m 200 -n 200 -wide
+      output_file: output/ex229_compressed.out
+
+   test:
+      suffix: compressed_threads
+      nsize: 2
+      requires: openmp
+      args: -check compressed -mat_no_inode -c_mat_aij_compressed_indices -mat_aij_threads 2
+      output_file: output/ex229_compressed.out
+
+   test:
+      suffix: split
+      nsize: 3
+      args: -check split -c_mat_mpiaij_split_mult
+
+   test:
+      suffix: split_2
+      nsize: 2
+      args: -check split -c_mat_mpiaij_split_mult -c_mat_aij_compressed_indices
+      output_file: output/ex229_split.out
+
+   test:
+      suffix: split_3
+      args: -check split -c_mat_type mpiaij -c_mat_mpiaij_split_mult
+      output_file: output/ex229_split.out
+
+   test:
+      suffix: progress
+      nsize: 3
+      args: -check split -c_mat_mpiaij_progress_rows 7 -vecscatter_type {{mpi1 mpi3 sf}}
+      output_file: output/ex229_split.out
+
+   test:
+      suffix: progress_split
+      nsize: 4
+      args: -check split -c_mat_mpiaij_split_mult -c_mat_mpiaij_progress_rows 5 -vecscatter_type sf -sf_type {{basic auto}}
+      output_file: output/ex229_split.out
+
+   test:
+      suffix: dense
+      args: -check dense
+
+   test:
+      suffix: dense_2
+      nsize: 3
+      args: -check dense
+      output_file: output/ex229_dense.out
+
+TEST*/
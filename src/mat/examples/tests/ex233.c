@@ -0,0 +1,120 @@
+static char help[] = "Tests MatSetPreallocationCOO() and MatSetValuesCOO() against MatSetValues().\n\
+  -m <m>, -n <n> : number of bilinear elements in each direction\n\n";
+
+/*
+   Every process computes the element matrices of a contiguous range of elements, which is unrelated to the rows it
+   owns, so the coordinates repeat and many belong to other processes. The nodes on the left side are eliminated by
+   giving them the index -1. The matrix is compared with the one assembled by MatSetValues() after INSERT_VALUES,
+   after ADD_VALUES, and after setting the pattern a second time.
+*/
+#include <petscmat.h>
+
+static PetscErrorCode CheckEqual(Mat A,Mat R,PetscScalar alpha,const char *stage)
+{
+  Mat            D;
+  PetscReal      err,nrm;
+  PetscErrorCode ierr;
+
+  PetscFunctionBeginUser;
+  ierr = MatDuplicate(R,MAT_COPY_VALUES,&D);CHKERRQ(ierr);
+  ierr = MatScale(D,alpha);CHKERRQ(ierr);
+  ierr = MatNorm(D,NORM_FROBENIUS,&nrm);CHKERRQ(ierr);
+  ierr = MatAXPY(D,-1.0,A,DIFFERENT_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = MatNorm(D,NORM_FROBENIUS,&err);CHKERRQ(ierr);
+  if (err > 1.e-12*nrm) SETERRQ2(PETSC_COMM_WORLD,PETSC_ERR_PLIB,"%s: the matrices differ by %g",stage,(double)(err/nrm));
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: the matrices agree\n",stage);CHKERRQ(ierr);
+  ierr = MatDestroy(&D);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+int main(int argc,char **argv)
+{
+  Mat            A,R;
+  PetscInt       m = 9,n = 7,N,ne,estart = 0,e,ei,ej,a,b,k,nodes[4],*coo_i,*coo_j;
+  PetscScalar    *v;
+  MatInfo        info;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = PetscOptionsGetInt(NULL,NULL,"-m",&m,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  N  = m*(n+1);
+  ne = PETSC_DECIDE;
+  e  = m*n;
+  ierr = PetscSplitOwnership(PETSC_COMM_WORLD,&ne,&e);CHKERRQ(ierr);
+  ierr = MPI_Scan(&ne,&estart,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  estart -= ne;
+
+  ierr = PetscMalloc3(16*ne,&coo_i,16*ne,&coo_j,16*ne,&v);CHKERRQ(ierr);
+  for (e=estart,k=0; e<estart+ne; e++) {
+    ei       = e%m;
+    ej       = e/m;
+    nodes[0] = ej*(m+1) + ei;
+    nodes[1] = nodes[0] + 1;
+    nodes[2] = nodes[1] + m+1;
+    nodes[3] = nodes[0] + m+1;
+    /* node (i,j) has index j*m + i-1, the nodes with i = 0 are eliminated */
+    for (a=0; a<4; a++) nodes[a] = (nodes[a]%(m+1)) ? (nodes[a]/(m+1))*m + nodes[a]%(m+1) - 1 : -1;
+    for (a=0; a<4; a++) {
+      for (b=0; b<4; b++,k++) {
+        coo_i[k] = nodes[a];
+        coo_j[k] = nodes[b];
+        v[k]     = (a == b ? 4.0 : (a+b)%2 ? -1.0 : -0.5) + 0.01*e + 0.001*b;
+      }
+    }
+  }
+
+  ierr = MatCreate(PETSC_COMM_WORLD,&R);CHKERRQ(ierr);
+  ierr = MatSetSizes(R,PETSC_DECIDE,PETSC_DECIDE,N,N);CHKERRQ(ierr);
+  ierr = MatSetFromOptions(R);CHKERRQ(ierr);
+  ierr = MatSetUp(R);CHKERRQ(ierr);
+  ierr = MatSetOption(R,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  for (k=0; k<16*ne; k++) {
+    ierr = MatSetValues(R,1,coo_i+k,1,coo_j+k,v+k,ADD_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(R,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(R,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = MatCreate(PETSC_COMM_WORLD,&A);CHKERRQ(ierr);
+  ierr = MatSetSizes(A,PETSC_DECIDE,PETSC_DECIDE,N,N);CHKERRQ(ierr);
+  ierr = MatSetFromOptions(A);CHKERRQ(ierr);
+  ierr = MatSetPreallocationCOO(A,16*ne,coo_i,coo_j);CHKERRQ(ierr);
+  ierr = MatGetInfo(A,MAT_GLOBAL_SUM,&info);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Nonzeros %D\n",(PetscInt)info.nz_used);CHKERRQ(ierr);
+  ierr = MatSetValuesCOO(A,v,INSERT_VALUES);CHKERRQ(ierr);
+  ierr = CheckEqual(A,R,1.0,"INSERT_VALUES");CHKERRQ(ierr);
+  ierr = MatSetValuesCOO(A,v,ADD_VALUES);CHKERRQ(ierr);
+  ierr = CheckEqual(A,R,2.0,"ADD_VALUES");CHKERRQ(ierr);
+  ierr = MatSetPreallocationCOO(A,16*ne,coo_i,coo_j);CHKERRQ(ierr);
+  ierr = MatSetValuesCOO(A,v,ADD_VALUES);CHKERRQ(ierr);
+  ierr = CheckEqual(A,R,1.0,"New pattern");CHKERRQ(ierr);
+
+  ierr = PetscFree3(coo_i,coo_j,v);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&R);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+
+   test:
+      suffix: 2
+      nsize: 3
+      output_file: output/ex233_1.out
+
+   test:
+      suffix: perm
+      nsize: 3
+      args: -mat_type aijperm -m 5 -n 12
+      output_file: output/ex233_perm.out
+
+   test:
+      suffix: baij
+      nsize: 2
+      args: -mat_type baij
+      output_file: output/ex233_1.out
+
+TEST*/
@@ -0,0 +1,86 @@
+static char help[] = "Tests the hash table that keeps the new nonzeros of full AIJ rows until the final assembly.\n\
+  -n <n> : number of rows per process\n\n";
+
+/*
+   Each row is preallocated for a single nonzero, so all but the first entry set in a row of the diagonal block, and all
+   the entries of the off-diagonal block of MPIAIJ, go into the hash table. The entries are added twice, so that the
+   second addition finds them in the hash table, and after a flush assembly some are overwritten with INSERT_VALUES.
+*/
+#include <petscmat.h>
+
+/* the value set in entry (i,j) */
+#define EntryValue(i,j) ((PetscScalar)(1 + (i) + 100*(j)))
+
+int main(int argc,char **argv)
+{
+  Mat            A;
+  PetscInt       n = 6,N,rstart,rend,i,j,k,cols[4];
+  PetscScalar    v,expected[4];
+  PetscReal      err = 0.0,gerr;
+  MatInfo        info;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = MatCreate(PETSC_COMM_WORLD,&A);CHKERRQ(ierr);
+  ierr = MatSetSizes(A,n,n,PETSC_DETERMINE,PETSC_DETERMINE);CHKERRQ(ierr);
+  ierr = MatSetType(A,MATAIJ);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation(A,1,NULL);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetPreallocation(A,1,NULL,0,NULL);CHKERRQ(ierr);
+  ierr = MatSetOption(A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatGetSize(A,&N,NULL);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+
+  /* the three diagonals and a column half the matrix away, which is in the off-diagonal block in parallel */
+  for (k=0; k<2; k++) {
+    for (i=rstart; i<rend; i++) {
+      cols[0] = i; cols[1] = (i+N-1)%N; cols[2] = (i+1)%N; cols[3] = (i+N/2)%N;
+      for (j=0; j<4; j++) {
+        if (j == 3 && (cols[3] == cols[0] || cols[3] == cols[1] || cols[3] == cols[2])) continue;
+        v    = EntryValue(i,cols[j]);
+        ierr = MatSetValues(A,1,&i,1,&cols[j],&v,ADD_VALUES);CHKERRQ(ierr);
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FLUSH_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FLUSH_ASSEMBLY);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    cols[2] = (i+1)%N; cols[3] = (i+N/2)%N;
+    for (j=2; j<4; j++) {
+      v    = -EntryValue(i,cols[j]);
+      ierr = MatSetValues(A,1,&i,1,&cols[j],&v,INSERT_VALUES);CHKERRQ(ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  for (i=rstart; i<rend; i++) {
+    cols[0] = i; cols[1] = (i+N-1)%N; cols[2] = (i+1)%N; cols[3] = (i+N/2)%N;
+    expected[0] = 2.0*EntryValue(i,cols[0]);
+    expected[1] = 2.0*EntryValue(i,cols[1]);
+    expected[2] = -EntryValue(i,cols[2]);
+    expected[3] = -EntryValue(i,cols[3]);
+    for (j=0; j<4; j++) {
+      if (j == 3 && (cols[3] == cols[0] || cols[3] == cols[1] || cols[3] == cols[2])) continue;
+      ierr = MatGetValues(A,1,&i,1,&cols[j],&v);CHKERRQ(ierr);
+      err  = PetscMax(err,PetscAbsScalar(v-expected[j]));
+    }
+  }
+  ierr = MPIU_Allreduce(&err,&gerr,1,MPIU_REAL,MPIU_MAX,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Largest error in the assembled values %g\n",(double)gerr);CHKERRQ(ierr);
+  ierr = MatGetInfo(A,MAT_GLOBAL_SUM,&info);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"nonzeros %D, allocated %D, mallocs %D\n",(PetscInt)info.nz_used,(PetscInt)info.nz_allocated,(PetscInt)info.mallocs);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+
+   test:
+      suffix: 2
+      nsize: 3
+
+TEST*/
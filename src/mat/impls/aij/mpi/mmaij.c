@@ -123,8 +123,11 @@ PetscErrorCode MatSetUpMultiply_MPIAIJ(Mat mat)
   /* generate the scatter context */
   if (aij->Mvctx_mpi1_flg) {
     ierr = VecScatterDestroy(&aij->Mvctx_mpi1);CHKERRQ(ierr);
-    ierr = VecScatterCreateWithData(gvec,from,aij->lvec,to,&aij->Mvctx_mpi1);CHKERRQ(ierr);
+    /* the type is set before the setup, whatever -vecscatter_type says */
+    ierr = VecScatterCreate(PetscObjectComm((PetscObject)mat),&aij->Mvctx_mpi1);CHKERRQ(ierr);
+    ierr = VecScatterSetData(aij->Mvctx_mpi1,gvec,from,aij->lvec,to);CHKERRQ(ierr);
     ierr = VecScatterSetType(aij->Mvctx_mpi1,VECSCATTERMPI1);CHKERRQ(ierr);
+    ierr = VecScatterSetUp(aij->Mvctx_mpi1);CHKERRQ(ierr);
     ierr = PetscLogObjectParent((PetscObject)mat,(PetscObject)aij->Mvctx_mpi1);CHKERRQ(ierr);
   } else {
     ierr = VecScatterDestroy(&aij->Mvctx);CHKERRQ(ierr);
@@ -447,6 +447,10 @@ PetscErrorCode MatCreateColmap_MPIAIJ_Private(Mat mat)
       if (value == 0.0 && ignorezeroentries && row != col) {low1 = 0; high1 = nrow1;goto a_noinsert;} \
       if (nonew == 1) {low1 = 0; high1 = nrow1; goto a_noinsert;}                \
       if (nonew == -1) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Inserting a new nonzero at global row/column (%D, %D) into matrix", orow, ocol); \
+      if (nrow1 >= rmax1 && nonew != -2) { \
+        ierr = MatSeqAIJSetValueHash_Private(A,row,col,value,addv);CHKERRQ(ierr); \
+        low1 = 0; high1 = nrow1; goto a_noinsert; \
+      } \
       MatSeqXAIJReallocateAIJ(A,am,1,nrow1,row,col,rmax1,aa,ai,aj,rp1,ap1,aimax,nonew,MatScalar); \
       N = nrow1++ - 1; a->nz++; high1++; \
       /* shift up all the later entries in this row */ \
@@ -482,6 +486,10 @@ PetscErrorCode MatCreateColmap_MPIAIJ_Private(Mat mat)
     if (value == 0.0 && ignorezeroentries) {low2 = 0; high2 = nrow2; goto b_noinsert;} \
     if (nonew == 1) {low2 = 0; high2 = nrow2; goto b_noinsert;}                        \
     if (nonew == -1) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Inserting a new nonzero at global row/column (%D, %D) into matrix", orow, ocol); \
+    if (nrow2 >= rmax2 && nonew != -2) {                  \
+      ierr = MatSeqAIJSetValueHash_Private(B,row,col,value,addv);CHKERRQ(ierr); \
+      low2 = 0; high2 = nrow2; goto b_noinsert;           \
+    }                                                     \
     MatSeqXAIJReallocateAIJ(B,bm,1,nrow2,row,col,rmax2,ba,bi,bj,rp2,ap2,bimax,nonew,MatScalar); \
     N = nrow2++ - 1; b->nz++; high2++;                    \
     /* shift up all the later entries in this row */      \
@@ -777,6 +785,40 @@ PetscErrorCode MatAssemblyBegin_MPIAIJ(Mat mat,MatAssemblyType mode)
   PetscFunctionReturn(0);
 }
 
+/* The diagonal and off-diagonal blocks are MATSEQAIJ matrices multiplied by the standard kernels, which MatMult() may inline */
+static PetscErrorCode MatMPIAIJBlocksArePlain(Mat A,PetscBool *plain)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  Mat_SeqAIJ     *ad = (Mat_SeqAIJ*)a->A->data,*bd = (Mat_SeqAIJ*)a->B->data;
+  PetscBool      seqa,seqb;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr   = PetscObjectTypeCompare((PetscObject)a->A,MATSEQAIJ,&seqa);CHKERRQ(ierr);
+  ierr   = PetscObjectTypeCompare((PetscObject)a->B,MATSEQAIJ,&seqb);CHKERRQ(ierr);
+  *plain = (PetscBool)(seqa && seqb && a->multprecision == MAT_AIJ_MULT_DOUBLE && !a->compressedindices && !ad->threads.rstart && !bd->threads.rstart);
+  PetscFunctionReturn(0);
+}
+
+/*
+   MatMult() falls back to the kernels of the blocks, without polling, when MatMultDiagonalRows_MPIAIJ() cannot be used.
+   The threads of the blocks are set up when their nonzero structure changes, so the check is repeated then, and when
+   the options of the blocks are changed.
+*/
+static PetscErrorCode MatMPIAIJSetUpProgress(Mat A)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJBlocksArePlain(A,&a->progressplain);CHKERRQ(ierr);
+  a->progressstate = a->A->nonzerostate + a->B->nonzerostate;
+  if (a->progressrows && !a->progressplain) {
+    ierr = PetscInfo(A,"Blocks are not plain MATSEQAIJ matrices; not polling the scatter in MatMult()\n");CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
 PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat mat,MatAssemblyType mode)
 {
   Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
@@ -811,6 +853,12 @@ PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat mat,MatAssemblyType mode)
     }
     ierr = MatStashScatterEnd_Private(&mat->stash);CHKERRQ(ierr);
   }
+  if (aij->multprecision != MAT_AIJ_MULT_DOUBLE) {
+    ierr = MatAIJSetMultPrecision(aij->A,aij->multprecision);CHKERRQ(ierr);
+  }
+  if (aij->compressedindices) {
+    ierr = MatAIJSetCompressedIndices(aij->A,PETSC_TRUE);CHKERRQ(ierr);
+  }
   ierr = MatAssemblyBegin(aij->A,mode);CHKERRQ(ierr);
   ierr = MatAssemblyEnd(aij->A,mode);CHKERRQ(ierr);
 
@@ -827,13 +875,29 @@ PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat mat,MatAssemblyType mode)
     }
   }
   if (!mat->was_assembled && mode == MAT_FINAL_ASSEMBLY) {
+    /* the off-diagonal nonzeros kept in the hash table of B need their global columns compacted as well */
+    ierr = MatSeqAIJMergeHash_Private(aij->B);CHKERRQ(ierr);
     ierr = MatSetUpMultiply_MPIAIJ(mat);CHKERRQ(ierr);
   }
   ierr = MatSetOption(aij->B,MAT_USE_INODES,PETSC_FALSE);CHKERRQ(ierr);
+  /* B may have been recreated by MatDisAssemble_MPIAIJ() */
+  /*
+     Most rows of B are usually empty. In MatMultAdd() each empty row costs a row offset and a read and write of y while
+     the compressed row format costs an extra row index per nonempty row, so it is used as soon as a quarter of the rows are empty
+  */
+  ((Mat_SeqAIJ*)aij->B->data)->compressedrowratio = 0.25;
+  if (aij->multprecision != MAT_AIJ_MULT_DOUBLE) {
+    ierr = MatAIJSetMultPrecision(aij->B,aij->multprecision);CHKERRQ(ierr);
+  }
+  if (aij->compressedindices) {
+    ierr = MatAIJSetCompressedIndices(aij->B,PETSC_TRUE);CHKERRQ(ierr);
+  }
   ierr = MatAssemblyBegin(aij->B,mode);CHKERRQ(ierr);
   ierr = MatAssemblyEnd(aij->B,mode);CHKERRQ(ierr);
 
   ierr = PetscFree2(aij->rowvalues,aij->rowindices);CHKERRQ(ierr);
+  ierr = PetscFree(aij->splitrows);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetUpProgress(mat);CHKERRQ(ierr);
 
   aij->rowvalues = 0;
 
@@ -1021,6 +1085,160 @@ PetscErrorCode MatZeroRowsColumns_MPIAIJ(Mat A,PetscInt N,const PetscInt rows[],
   PetscFunctionReturn(0);
 }
 
+/*
+   Splits the rows into the interior rows, which have no entries in B, and the rows coupled to other processes. Called
+   by MatMult() and MatMultAdd() whenever the nonzero structure of B has changed; falls back to the standard products
+   when the diagonal and off-diagonal blocks are not plain MATSEQAIJ matrices or use other MatMult() kernels.
+*/
+static PetscErrorCode MatMPIAIJSetUpSplitMult(Mat A)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  Mat_SeqAIJ     *bd = (Mat_SeqAIJ*)a->B->data;
+  PetscInt       i,m = A->rmap->n,ni = 0,nb = 0,*rows;
+  PetscBool      plain;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(a->splitrows);CHKERRQ(ierr);
+  ierr = MatMPIAIJBlocksArePlain(A,&plain);CHKERRQ(ierr);
+  if (!plain) {
+    ierr = PetscInfo(A,"Blocks are not plain MATSEQAIJ matrices; not splitting the interior rows in MatMult()\n");CHKERRQ(ierr);
+    a->splitmult = PETSC_FALSE;
+    PetscFunctionReturn(0);
+  }
+  for (i=0; i<m; i++) ni += (bd->i[i+1] == bd->i[i]);
+  ierr = PetscMalloc1(m,&rows);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    if (bd->i[i+1] == bd->i[i]) rows[nb++] = i;
+    else rows[ni + i - nb] = i;
+  }
+  a->ninterior  = ni;
+  a->splitrows  = rows;
+  a->splitstate = a->B->nonzerostate;
+  ierr = PetscInfo2(A,"%D of %D rows have no off-process entries and are multiplied while the ghost values are communicated\n",ni,m);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   z = y + A_d x (z = A_d x if y is NULL) for the rows rows[0],...,rows[nrows-1], or the first nrows rows if rows is
+   NULL. With -mat_mpiaij_progress_rows the scatter in progress is given a chance to move its messages after each
+   chunk of that many rows.
+*/
+static PetscErrorCode MatMultDiagonalRows_MPIAIJ(Mat A,VecScatter Mvctx,const PetscInt *rows,PetscInt nrows,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  Mat_MPIAIJ      *a = (Mat_MPIAIJ*)A->data;
+  Mat_SeqAIJ      *ad = (Mat_SeqAIJ*)a->A->data;
+  const PetscInt  *aj;
+  const MatScalar *aa;
+  PetscScalar     sum;
+  PetscInt        i,r,n,start,end,chunk = a->progressrows > 0 ? a->progressrows : nrows;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  for (start=0; start<nrows; start=end) {
+    end = PetscMin(nrows,start+chunk);
+    for (i=start; i<end; i++) {
+      r   = rows ? rows[i] : i;
+      n   = ad->i[r+1] - ad->i[r];
+      aj  = ad->j + ad->i[r];
+      aa  = ad->a + ad->i[r];
+      sum = y ? y[r] : 0.0;
+      PetscSparseDensePlusDot(sum,x,aa,aj,n);
+      z[r] = sum;
+    }
+    if (end < nrows) {ierr = VecScatterProgress(Mvctx);CHKERRQ(ierr);}
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   zz = A_d xx while the ghost values are communicated, polling the scatter with -mat_mpiaij_progress_rows, then
+   zz += A_o lvec. When yy is given the rows of yy are added.
+*/
+static PetscErrorCode MatMultProgress_MPIAIJ(Mat A,VecScatter Mvctx,Vec xx,Vec yy,Vec zz)
+{
+  Mat_MPIAIJ        *a = (Mat_MPIAIJ*)A->data;
+  Mat_SeqAIJ        *ad = (Mat_SeqAIJ*)a->A->data;
+  const PetscScalar *x,*y = NULL;
+  PetscScalar       *z;
+  PetscInt          m = A->rmap->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecScatterBegin(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy) {
+    ierr = VecGetArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  }
+  ierr = MatMultDiagonalRows_MPIAIJ(A,Mvctx,NULL,m,x,y,z);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy) {
+    ierr = VecRestoreArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  }
+  ierr = PetscLogFlops(2.0*ad->nz - (yy ? 0 : m));CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
+  ierr = VecScatterEnd(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
+  ierr = (*a->B->ops->multadd)(a->B,a->lvec,zz,zz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   zz = A_d xx for the interior rows, then (once the ghost values have arrived) zz = A_d xx + A_o lvec for the
+   remaining rows in one pass. When yy is given the rows of yy are added.
+*/
+static PetscErrorCode MatMultSplit_MPIAIJ(Mat A,VecScatter Mvctx,Vec xx,Vec yy,Vec zz)
+{
+  Mat_MPIAIJ        *a = (Mat_MPIAIJ*)A->data;
+  Mat_SeqAIJ        *ad = (Mat_SeqAIJ*)a->A->data,*bd = (Mat_SeqAIJ*)a->B->data;
+  const PetscInt    *rows = a->splitrows,*aj,*bj;
+  const MatScalar   *aa,*ba;
+  const PetscScalar *x,*y = NULL,*l;
+  PetscScalar       *z,sum;
+  PetscInt          i,r,n,m = A->rmap->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecScatterBegin(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy) {
+    ierr = VecGetArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  }
+  ierr = MatMultDiagonalRows_MPIAIJ(A,Mvctx,rows,a->ninterior,x,y,z);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
+  ierr = VecScatterEnd(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(a->lvec,&l);CHKERRQ(ierr);
+  for (i=a->ninterior; i<m; i++) {
+    r   = rows[i];
+    n   = ad->i[r+1] - ad->i[r];
+    aj  = ad->j + ad->i[r];
+    aa  = ad->a + ad->i[r];
+    sum = y ? y[r] : 0.0;
+    PetscSparseDensePlusDot(sum,x,aa,aj,n);
+    n   = bd->i[r+1] - bd->i[r];
+    bj  = bd->j + bd->i[r];
+    ba  = bd->a + bd->i[r];
+    PetscSparseDensePlusDot(sum,l,ba,bj,n);
+    z[r] = sum;
+  }
+  ierr = VecRestoreArrayRead(a->lvec,&l);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy) {
+    ierr = VecRestoreArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  }
+  ierr = PetscLogFlops(2.0*(ad->nz + bd->nz) - (yy ? 0 : m));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 PetscErrorCode MatMult_MPIAIJ(Mat A,Vec xx,Vec yy)
 {
   Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
@@ -1032,9 +1250,21 @@ PetscErrorCode MatMult_MPIAIJ(Mat A,Vec xx,Vec yy)
   ierr = VecGetLocalSize(xx,&nt);CHKERRQ(ierr);
   if (nt != A->cmap->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Incompatible partition of A (%D) and xx (%D)",A->cmap->n,nt);
 
+  if (a->splitmult && (!a->splitrows || a->splitstate != a->B->nonzerostate)) {ierr = MatMPIAIJSetUpSplitMult(A);CHKERRQ(ierr);}
+  if (a->splitmult) {
+    ierr = MatMultSplit_MPIAIJ(A,Mvctx,xx,NULL,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (a->progressrows && a->progressstate != a->A->nonzerostate + a->B->nonzerostate) {ierr = MatMPIAIJSetUpProgress(A);CHKERRQ(ierr);}
+  if (a->progressrows && a->progressplain) {
+    ierr = MatMultProgress_MPIAIJ(A,Mvctx,xx,NULL,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   ierr = VecScatterBegin(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
   ierr = (*a->A->ops->mult)(a->A,xx,yy);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
   ierr = VecScatterEnd(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
   ierr = (*a->B->ops->multadd)(a->B,a->lvec,yy,yy);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -1057,9 +1287,21 @@ PetscErrorCode MatMultAdd_MPIAIJ(Mat A,Vec xx,Vec yy,Vec zz)
 
   PetscFunctionBegin;
   if (a->Mvctx_mpi1_flg) Mvctx = a->Mvctx_mpi1;
+  if (a->splitmult && (!a->splitrows || a->splitstate != a->B->nonzerostate)) {ierr = MatMPIAIJSetUpSplitMult(A);CHKERRQ(ierr);}
+  if (a->splitmult) {
+    ierr = MatMultSplit_MPIAIJ(A,Mvctx,xx,yy,zz);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (a->progressrows && a->progressstate != a->A->nonzerostate + a->B->nonzerostate) {ierr = MatMPIAIJSetUpProgress(A);CHKERRQ(ierr);}
+  if (a->progressrows && a->progressplain) {
+    ierr = MatMultProgress_MPIAIJ(A,Mvctx,xx,yy,zz);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   ierr = VecScatterBegin(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
   ierr = (*a->A->ops->multadd)(a->A,xx,yy,zz);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
   ierr = VecScatterEnd(Mvctx,xx,a->lvec,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(MAT_MultCommWait,A,xx,a->lvec,0);CHKERRQ(ierr);
   ierr = (*a->B->ops->multadd)(a->B,a->lvec,zz,zz);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -1188,6 +1430,21 @@ PetscErrorCode MatScale_MPIAIJ(Mat A,PetscScalar aa)
   PetscFunctionReturn(0);
 }
 
+static PetscErrorCode MatResetCOO_MPIAIJ(Mat mat)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFDestroy(&aij->coo_sf);CHKERRQ(ierr);
+  ierr = PetscFree(aij->coo_recv);CHKERRQ(ierr);
+  ierr = PetscFree2(aij->Ajmap,aij->Aperm);CHKERRQ(ierr);
+  ierr = PetscFree2(aij->Bjmap,aij->Bperm);CHKERRQ(ierr);
+  aij->coo_n     = 0;
+  aij->coo_nrecv = 0;
+  PetscFunctionReturn(0);
+}
+
 PetscErrorCode MatDestroy_MPIAIJ(Mat mat)
 {
   Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
@@ -1198,6 +1455,7 @@ PetscErrorCode MatDestroy_MPIAIJ(Mat mat)
   PetscLogObjectState((PetscObject)mat,"Rows=%D, Cols=%D",mat->rmap->N,mat->cmap->N);
 #endif
   ierr = MatStashDestroy_Private(&mat->stash);CHKERRQ(ierr);
+  ierr = MatResetCOO_MPIAIJ(mat);CHKERRQ(ierr);
   ierr = VecDestroy(&aij->diag);CHKERRQ(ierr);
   ierr = MatDestroy(&aij->A);CHKERRQ(ierr);
   ierr = MatDestroy(&aij->B);CHKERRQ(ierr);
@@ -1212,15 +1470,21 @@ PetscErrorCode MatDestroy_MPIAIJ(Mat mat)
   if (aij->Mvctx_mpi1) {ierr = VecScatterDestroy(&aij->Mvctx_mpi1);CHKERRQ(ierr);}
   ierr = PetscFree2(aij->rowvalues,aij->rowindices);CHKERRQ(ierr);
   ierr = PetscFree(aij->ld);CHKERRQ(ierr);
+  ierr = PetscFree(aij->splitrows);CHKERRQ(ierr);
   ierr = PetscFree(mat->data);CHKERRQ(ierr);
 
   ierr = PetscObjectChangeTypeName((PetscObject)mat,0);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatStoreValues_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)mat,"MatAIJSetMultPrecision_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)mat,"MatAIJSetCompressedIndices_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatRetrieveValues_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatIsTranspose_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatMPIAIJSetPreallocation_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatResetPreallocation_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatMPIAIJSetPreallocationCSR_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)mat,"MatSetPreallocationCOO_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)mat,"MatSetValuesCOO_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)mat,"MatMultBasis_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatDiagonalScaleLocal_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatConvert_mpiaij_mpisbaij_C",NULL);CHKERRQ(ierr);
 #if defined(PETSC_HAVE_ELEMENTAL)
@@ -2514,10 +2778,41 @@ PetscErrorCode MatMPIAIJSetUseScalableIncreaseOverlap(Mat A,PetscBool sc)
   PetscFunctionReturn(0);
 }
 
+static PetscErrorCode MatAIJSetMultPrecision_MPIAIJ(Mat A,MatAIJMultPrecision precision)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  a->multprecision = precision;
+  if (a->A) {ierr = MatAIJSetMultPrecision(a->A,precision);CHKERRQ(ierr);}
+  if (a->B) {ierr = MatAIJSetMultPrecision(a->B,precision);CHKERRQ(ierr);}
+  ierr = PetscFree(a->splitrows);CHKERRQ(ierr);
+  a->progressstate = -1;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode MatAIJSetCompressedIndices_MPIAIJ(Mat A,PetscBool flg)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  a->compressedindices = flg;
+  if (a->A) {ierr = MatAIJSetCompressedIndices(a->A,flg);CHKERRQ(ierr);}
+  if (a->B) {ierr = MatAIJSetCompressedIndices(a->B,flg);CHKERRQ(ierr);}
+  ierr = PetscFree(a->splitrows);CHKERRQ(ierr);
+  a->progressstate = -1;
+  PetscFunctionReturn(0);
+}
+
 PetscErrorCode MatSetFromOptions_MPIAIJ(PetscOptionItems *PetscOptionsObject,Mat A)
 {
+  Mat_MPIAIJ           *a = (Mat_MPIAIJ*)A->data;
   PetscErrorCode       ierr;
   PetscBool            sc = PETSC_FALSE,flg;
+  MatAIJMultPrecision  precision = a->multprecision;
+  PetscBool            cidx = a->compressedindices;
 
   PetscFunctionBegin;
   ierr = PetscOptionsHead(PetscOptionsObject,"MPIAIJ options");CHKERRQ(ierr);
@@ -2526,6 +2821,18 @@ PetscErrorCode MatSetFromOptions_MPIAIJ(PetscOptionItems *PetscOptionsObject,Mat
   if (flg) {
     ierr = MatMPIAIJSetUseScalableIncreaseOverlap(A,sc);CHKERRQ(ierr);
   }
+  ierr = PetscOptionsEnum("-mat_aij_mult_precision","Precision of the matrix values used by MatMult() and MatMultAdd()","MatAIJSetMultPrecision",MatAIJMultPrecisions,(PetscEnum)precision,(PetscEnum*)&precision,&flg);CHKERRQ(ierr);
+  if (flg) {
+    ierr = MatAIJSetMultPrecision(A,precision);CHKERRQ(ierr);
+  }
+  ierr = PetscOptionsBool("-mat_aij_compressed_indices","Use 16 bit column offsets in MatMult() and MatSOR()","MatAIJSetCompressedIndices",cidx,&cidx,&flg);CHKERRQ(ierr);
+  if (flg) {
+    ierr = MatAIJSetCompressedIndices(A,cidx);CHKERRQ(ierr);
+  }
+  ierr = PetscOptionsBool("-mat_mpiaij_split_mult","Multiply with the interior rows while the ghost values are communicated","None",a->splitmult,&a->splitmult,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-mat_mpiaij_progress_rows","Let MPI progress the ghost value communication after each chunk of this many rows in MatMult()","VecScatterProgress",a->progressrows,&a->progressrows,NULL);CHKERRQ(ierr);
+  if (a->progressrows < 0) SETERRQ1(PetscObjectComm((PetscObject)A),PETSC_ERR_ARG_OUTOFRANGE,"-mat_mpiaij_progress_rows %D cannot be negative",a->progressrows);
+  ierr = PetscOptionsBool("-mat_mpiaij_matrix_powers","Compute the vectors of MatMultBasis() with a single communication of a deep ghost region","MatMultBasis",a->matrixpowers,&a->matrixpowers,NULL);CHKERRQ(ierr);
   ierr = PetscOptionsTail();CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -2765,6 +3072,7 @@ PetscErrorCode  MatMPIAIJSetPreallocation_MPIAIJ(Mat B,PetscInt d_nz,const Petsc
   ierr = PetscFree(b->garray);CHKERRQ(ierr);
   ierr = VecDestroy(&b->lvec);CHKERRQ(ierr);
   ierr = VecScatterDestroy(&b->Mvctx);CHKERRQ(ierr);
+  ierr = MatResetCOO_MPIAIJ(B);CHKERRQ(ierr);
 
   /* Because the B will have been resized we simply destroy it and create a new one each time */
   ierr = MatDestroy(&b->B);CHKERRQ(ierr);
@@ -2809,6 +3117,7 @@ PetscErrorCode MatResetPreallocation_MPIAIJ(Mat B)
   ierr = PetscFree(b->garray);CHKERRQ(ierr);
   ierr = VecDestroy(&b->lvec);CHKERRQ(ierr);
   ierr = VecScatterDestroy(&b->Mvctx);CHKERRQ(ierr);
+  ierr = MatResetCOO_MPIAIJ(B);CHKERRQ(ierr);
 
   ierr = MatResetPreallocation(b->A);CHKERRQ(ierr);
   ierr = MatResetPreallocation(b->B);CHKERRQ(ierr);
@@ -2845,6 +3154,14 @@ PetscErrorCode MatDuplicate_MPIAIJ(Mat matin,MatDuplicateOption cpvalues,Mat *ne
   a->rowvalues    = 0;
   a->getrowactive = PETSC_FALSE;
 
+  a->multprecision     = oldmat->multprecision;
+  a->compressedindices = oldmat->compressedindices;
+  a->splitmult         = oldmat->splitmult;
+  a->progressrows      = oldmat->progressrows;
+  a->progressplain     = PETSC_FALSE;
+  a->progressstate     = -1;
+  a->matrixpowers      = oldmat->matrixpowers;
+
   ierr = PetscLayoutReference(matin->rmap,&mat->rmap);CHKERRQ(ierr);
   ierr = PetscLayoutReference(matin->cmap,&mat->cmap);CHKERRQ(ierr);
 
@@ -4012,6 +4329,171 @@ PetscErrorCode  MatMPIAIJSetPreallocationCSR(Mat B,const PetscInt i[],const Pets
   PetscFunctionReturn(0);
 }
 
+PetscErrorCode MatSetPreallocationCOO_MPIAIJ(Mat mat,PetscInt n,const PetscInt coo_i[],const PetscInt coo_j[])
+{
+  Mat_MPIAIJ     *mpiaij;
+  Mat_SeqAIJ     *a,*b;
+  PetscSF        sf;
+  PetscSFNode    *iremote;
+  const PetscInt *degree;
+  PetscInt       *ilocal,*rows,*cols,*src,*recvj,*Ai,*Aj,*jmap,*perm;
+  PetscInt       m,rstart,rend,cstart,cend,k,r,d,s,t,nleaves,nrecv,nv,nz,na,nb,pa,pb;
+  PetscMPIInt    owner;
+  PetscBool      same;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  /* the types derived from MPIAIJ that keep their own copy of the values go through MatSetValues() */
+  ierr = PetscObjectTypeCompareAny((PetscObject)mat,&same,MATMPIAIJ,MATMPIAIJPERM,"");CHKERRQ(ierr);
+  if (!same) {
+    ierr = MatSetPreallocationCOO_Basic(mat,n,coo_i,coo_j);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr   = MatResetCOO_MPIAIJ(mat);CHKERRQ(ierr);
+  m      = mat->rmap->n;
+  rstart = mat->rmap->rstart;
+  rend   = mat->rmap->rend;
+  cstart = mat->cmap->rstart;
+  cend   = mat->cmap->rend;
+
+  /* the coordinates of rows owned by other processes are the leaves of an SF rooted at the owned rows */
+  for (k=0,nleaves=0; k<n; k++) {
+    if (coo_i[k] < 0 || coo_j[k] < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+    if (coo_i[k] >= mat->rmap->N) SETERRQ3(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Coordinate %D has row %D, the matrix has %D rows",k,coo_i[k],mat->rmap->N);
+    if (coo_j[k] >= mat->cmap->N) SETERRQ3(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Coordinate %D has column %D, the matrix has %D columns",k,coo_j[k],mat->cmap->N);
+#endif
+    if (coo_i[k] < rstart || coo_i[k] >= rend) nleaves++;
+  }
+  ierr = PetscMalloc1(nleaves,&ilocal);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nleaves,&iremote);CHKERRQ(ierr);
+  for (k=0,nleaves=0; k<n; k++) {
+    if (coo_i[k] < 0 || coo_j[k] < 0 || (coo_i[k] >= rstart && coo_i[k] < rend)) continue;
+    ierr = PetscLayoutFindOwner(mat->rmap,coo_i[k],&owner);CHKERRQ(ierr);
+    ilocal[nleaves]        = k;
+    iremote[nleaves].rank  = owner;
+    iremote[nleaves].index = coo_i[k] - mat->rmap->range[owner];
+    nleaves++;
+  }
+  ierr = PetscSFCreate(PetscObjectComm((PetscObject)mat),&sf);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(sf,m,nleaves,ilocal,PETSC_OWN_POINTER,iremote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+  ierr = PetscSFSetFromOptions(sf);CHKERRQ(ierr);
+  ierr = PetscSFComputeDegreeBegin(sf,&degree);CHKERRQ(ierr);
+  ierr = PetscSFComputeDegreeEnd(sf,&degree);CHKERRQ(ierr);
+  for (r=0,nrecv=0; r<m; r++) nrecv += degree[r];
+  ierr = PetscMalloc1(nrecv,&recvj);CHKERRQ(ierr);
+  ierr = PetscSFGatherBegin(sf,MPIU_INT,coo_j,recvj);CHKERRQ(ierr);
+  ierr = PetscSFGatherEnd(sf,MPIU_INT,coo_j,recvj);CHKERRQ(ierr);
+
+  /* coordinate k given here is identified by k, the s-th received one by n+s */
+  ierr = PetscMalloc3(n+nrecv,&rows,n+nrecv,&cols,n+nrecv,&src);CHKERRQ(ierr);
+  for (k=0,nv=0; k<n; k++) {
+    if (coo_i[k] < rstart || coo_i[k] >= rend || coo_j[k] < 0) continue;
+    rows[nv] = coo_i[k] - rstart;
+    cols[nv] = coo_j[k];
+    src[nv]  = k;
+    nv++;
+  }
+  for (r=0,s=0; r<m; r++) {
+    for (d=0; d<degree[r]; d++,s++) {
+      rows[nv] = r;
+      cols[nv] = recvj[s];
+      src[nv]  = n+s;
+      nv++;
+    }
+  }
+  ierr = PetscFree(recvj);CHKERRQ(ierr);
+  ierr = MatSeqAIJCOOSortPattern_Private(m,nv,rows,cols,src,&Ai,&Aj,&nz,&jmap,&perm);CHKERRQ(ierr);
+  ierr = PetscFree3(rows,cols,src);CHKERRQ(ierr);
+  if (mat->preallocated) {
+    ierr = MatSetOption(mat,MAT_NEW_NONZERO_LOCATIONS,PETSC_TRUE);CHKERRQ(ierr);
+  }
+  ierr = MatMPIAIJSetPreallocationCSR(mat,Ai,Aj,NULL);CHKERRQ(ierr);
+
+  /*
+     Within a row the nonzeros of A and of B (whose columns are compacted in increasing global order) come in the order
+     of their global columns, so splitting the sorted pattern gives the position of each one in a->a and b->a.
+  */
+  mpiaij = (Mat_MPIAIJ*)mat->data;
+  a      = (Mat_SeqAIJ*)mpiaij->A->data;
+  b      = (Mat_SeqAIJ*)mpiaij->B->data;
+  for (k=0,na=0,pa=0; k<nz; k++) {
+    if (Aj[k] >= cstart && Aj[k] < cend) {na++; pa += jmap[k+1]-jmap[k];}
+  }
+  nb = nz - na;
+  pb = nv - pa;
+  if (a->nz != na || b->nz != nb) SETERRQ4(PETSC_COMM_SELF,PETSC_ERR_PLIB,"The matrix has %D and %D nonzeros in its diagonal and off-diagonal blocks instead of %D and %D, is MAT_IGNORE_ZERO_ENTRIES set?",a->nz,b->nz,na,nb);
+  ierr = PetscMalloc2(na+1,&mpiaij->Ajmap,pa,&mpiaij->Aperm);CHKERRQ(ierr);
+  ierr = PetscMalloc2(nb+1,&mpiaij->Bjmap,pb,&mpiaij->Bperm);CHKERRQ(ierr);
+  mpiaij->Ajmap[0] = 0;
+  mpiaij->Bjmap[0] = 0;
+  for (k=0,na=0,nb=0,pa=0,pb=0; k<nz; k++) {
+    if (Aj[k] >= cstart && Aj[k] < cend) {
+      for (t=jmap[k]; t<jmap[k+1]; t++) mpiaij->Aperm[pa++] = perm[t];
+      mpiaij->Ajmap[++na] = pa;
+    } else {
+      for (t=jmap[k]; t<jmap[k+1]; t++) mpiaij->Bperm[pb++] = perm[t];
+      mpiaij->Bjmap[++nb] = pb;
+    }
+  }
+  ierr = PetscFree2(Ai,Aj);CHKERRQ(ierr);
+  ierr = PetscFree2(jmap,perm);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nrecv,&mpiaij->coo_recv);CHKERRQ(ierr);
+  mpiaij->coo_sf    = sf;
+  mpiaij->coo_n     = n;
+  mpiaij->coo_nrecv = nrecv;
+  mpiaij->Annz      = na;
+  mpiaij->Bnnz      = nb;
+  ierr = PetscLogObjectMemory((PetscObject)mat,(na+nb+2+nv)*sizeof(PetscInt)+nrecv*sizeof(PetscScalar));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatSetValuesCOO_MPIAIJ(Mat mat,const PetscScalar v[],InsertMode imode)
+{
+  Mat_MPIAIJ        *mpiaij = (Mat_MPIAIJ*)mat->data;
+  Mat_SeqAIJ        *a,*b;
+  const PetscInt    n = mpiaij->coo_n;
+  const PetscScalar *recv = mpiaij->coo_recv;
+  MatScalar         *aa,*ba;
+  PetscScalar       sum;
+  PetscInt          k,t,p;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (!mpiaij->coo_sf) {
+    ierr = MatSetValuesCOO_Basic(mat,v,imode);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  a  = (Mat_SeqAIJ*)mpiaij->A->data;
+  b  = (Mat_SeqAIJ*)mpiaij->B->data;
+  aa = a->a;
+  ba = b->a;
+  if (a->nz != mpiaij->Annz || b->nz != mpiaij->Bnnz) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"The nonzero structure changed since MatSetPreallocationCOO()");
+  ierr = PetscSFGatherBegin(mpiaij->coo_sf,MPIU_SCALAR,v,mpiaij->coo_recv);CHKERRQ(ierr);
+  ierr = PetscSFGatherEnd(mpiaij->coo_sf,MPIU_SCALAR,v,mpiaij->coo_recv);CHKERRQ(ierr);
+  for (k=0; k<mpiaij->Annz; k++) {
+    sum = (imode == INSERT_VALUES) ? 0.0 : aa[k];
+    for (t=mpiaij->Ajmap[k]; t<mpiaij->Ajmap[k+1]; t++) {
+      p    = mpiaij->Aperm[t];
+      sum += (p < n) ? v[p] : recv[p-n];
+    }
+    aa[k] = sum;
+  }
+  for (k=0; k<mpiaij->Bnnz; k++) {
+    sum = (imode == INSERT_VALUES) ? 0.0 : ba[k];
+    for (t=mpiaij->Bjmap[k]; t<mpiaij->Bjmap[k+1]; t++) {
+      p    = mpiaij->Bperm[t];
+      sum += (p < n) ? v[p] : recv[p-n];
+    }
+    ba[k] = sum;
+  }
+  ierr = MatSeqAIJInvalidateDiagonal(mpiaij->A);CHKERRQ(ierr);
+  ierr = PetscObjectStateIncrease((PetscObject)mpiaij->A);CHKERRQ(ierr);
+  ierr = PetscObjectStateIncrease((PetscObject)mpiaij->B);CHKERRQ(ierr);
+  ierr = PetscLogFlops(mpiaij->Ajmap[mpiaij->Annz]+mpiaij->Bjmap[mpiaij->Bnnz]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /*@C
    MatMPIAIJSetPreallocation - Preallocates memory for a sparse parallel matrix in AIJ format
    (the default parallel PETSc format).  For good matrix assembly performance
@@ -5616,7 +6098,23 @@ PETSC_INTERN PetscErrorCode MatMatMult_MPIDense_MPIAIJ(Mat A,Mat B,MatReuse scal
    MATMPIAIJ - MATMPIAIJ = "mpiaij" - A matrix type to be used for parallel sparse matrices.
 
    Options Database Keys:
-. -mat_type mpiaij - sets the matrix type to "mpiaij" during a call to MatSetFromOptions()
++ -mat_type mpiaij - sets the matrix type to "mpiaij" during a call to MatSetFromOptions()
+. -mat_mpiaij_split_mult - in MatMult() and MatMultAdd() first multiply with the rows that have no off-process entries, while the
+                           ghost values are communicated, then with the remaining rows of both blocks in a single pass
+. -mat_mpiaij_progress_rows <n> - in MatMult() and MatMultAdd() call VecScatterProgress() after each n rows multiplied while the
+                           ghost values are communicated
+- -mat_mpiaij_matrix_powers - in MatMultBasis() gather the rows within distance s-1 of the local rows once, so that the s vectors
+                           of a basis need a single communication of ghost values
+
+   Notes:
+   The time MatMult() and MatMultAdd() spend waiting for the ghost values is logged in the MatMultCommWait event. With an MPI
+   that only moves messages inside MPI calls, -mat_mpiaij_progress_rows lets them arrive during the local product, which
+   shows as a shorter MatMultCommWait; chunks of a few thousand rows are usually enough.
+
+   With -mat_mpiaij_matrix_powers the rows are gathered with MatCreateSubMatrices() the first time a basis of s vectors is
+   computed and again whenever the matrix changes; each basis then costs one scatter of the values of x within distance s
+   and some redundant computation on the ghost rows, instead of s scatters. This pays off when the messages cost more than
+   the extra flops, typically for small local problems with a narrow stencil on many processes.
 
   Level: beginner
 
@@ -5644,10 +6142,17 @@ PETSC_EXTERN PetscErrorCode MatCreate_MPIAIJ(Mat B)
   /* build cache for off array entries formed */
   ierr = MatStashCreate_Private(PetscObjectComm((PetscObject)B),1,&B->stash);CHKERRQ(ierr);
 
-  b->donotstash  = PETSC_FALSE;
-  b->colmap      = 0;
-  b->garray      = 0;
-  b->roworiented = PETSC_TRUE;
+  b->donotstash        = PETSC_FALSE;
+  b->colmap            = 0;
+  b->garray            = 0;
+  b->roworiented       = PETSC_TRUE;
+  b->multprecision     = MAT_AIJ_MULT_DOUBLE;
+  b->compressedindices = PETSC_FALSE;
+  b->splitmult         = PETSC_FALSE;
+  b->progressrows      = 0;
+  b->progressplain     = PETSC_FALSE;
+  b->progressstate     = -1;
+  b->matrixpowers      = PETSC_FALSE;
 
   /* stuff used for matrix vector multiply */
   b->lvec  = NULL;
@@ -5662,12 +6167,17 @@ PETSC_EXTERN PetscErrorCode MatCreate_MPIAIJ(Mat B)
   b->spptr = NULL;
 
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatMPIAIJSetUseScalableIncreaseOverlap_C",MatMPIAIJSetUseScalableIncreaseOverlap_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatAIJSetMultPrecision_C",MatAIJSetMultPrecision_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatAIJSetCompressedIndices_C",MatAIJSetCompressedIndices_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatStoreValues_C",MatStoreValues_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatRetrieveValues_C",MatRetrieveValues_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatIsTranspose_C",MatIsTranspose_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatMPIAIJSetPreallocation_C",MatMPIAIJSetPreallocation_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatResetPreallocation_C",MatResetPreallocation_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatMPIAIJSetPreallocationCSR_C",MatMPIAIJSetPreallocationCSR_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatSetPreallocationCOO_C",MatSetPreallocationCOO_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatSetValuesCOO_C",MatSetValuesCOO_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatMultBasis_C",MatMultBasis_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatDiagonalScaleLocal_C",MatDiagonalScaleLocal_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatConvert_mpiaij_mpiaijperm_C",MatConvert_MPIAIJ_MPIAIJPERM);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatConvert_mpiaij_mpiaijsell_C",MatConvert_MPIAIJ_MPIAIJSELL);CHKERRQ(ierr);
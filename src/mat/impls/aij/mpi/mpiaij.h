@@ -70,6 +70,29 @@ typedef struct {
   /* Used by MatDistribute_MPIAIJ() to allow reuse of previous matrix allocation  and nonzero pattern */
   PetscInt *ld;                    /* number of entries per row left of diagona block */
 
+  MatAIJMultPrecision multprecision; /* passed on to A and B, see MatAIJSetMultPrecision() */
+  PetscBool           compressedindices; /* passed on to A and B, see MatAIJSetCompressedIndices() */
+
+  /* Used by MatMult() and MatMultAdd() with -mat_mpiaij_split_mult and -mat_mpiaij_progress_rows */
+  PetscBool        splitmult;      /* multiply with the interior rows of A while the ghost values are communicated */
+  PetscInt         ninterior;      /* number of rows without entries in B, they come first in splitrows[] */
+  PetscInt         *splitrows;     /* the interior rows followed by the rows with entries in B */
+  PetscObjectState splitstate;     /* B->nonzerostate when splitrows[] was computed */
+  PetscInt         progressrows;   /* call VecScatterProgress() after each chunk of this many rows, -mat_mpiaij_progress_rows */
+  PetscBool        progressplain;  /* the blocks can be multiplied with the polling loop */
+  PetscObjectState progressstate;  /* A->nonzerostate + B->nonzerostate when progressplain was computed, -1 to recompute */
+
+  /* Used by MatMultBasis() with -mat_mpiaij_matrix_powers, the ghost region itself is composed with the matrix */
+  PetscBool        matrixpowers;   /* gather the rows within distance s of the local rows and communicate once per basis */
+
+  /* Used by MatSetPreallocationCOO() and MatSetValuesCOO() */
+  PetscSF     coo_sf;              /* roots are the local rows, leaves the coordinates given here for rows of other processes */
+  PetscInt    coo_n,coo_nrecv;     /* number of coordinates given here and received from other processes */
+  PetscScalar *coo_recv;           /* values gathered through coo_sf, in multi-root order */
+  PetscInt    Annz,Bnnz;           /* nonzeros of A and B when the plan was built */
+  PetscInt    *Ajmap,*Aperm;       /* nonzero k of A sums v[Aperm[t]] for Ajmap[k] <= t < Ajmap[k+1], coo_recv[Aperm[t]-coo_n] if >= coo_n */
+  PetscInt    *Bjmap,*Bperm;       /* the same for B */
+
   /* Used by MatMatMult() and MatPtAP() */
   Mat_APMPI *ap;
 
@@ -88,6 +111,9 @@ PETSC_INTERN PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat,MatAssemblyType);
 PETSC_INTERN PetscErrorCode MatSetUpMultiply_MPIAIJ(Mat);
 PETSC_INTERN PetscErrorCode MatDisAssemble_MPIAIJ(Mat);
 PETSC_INTERN PetscErrorCode MatDuplicate_MPIAIJ(Mat,MatDuplicateOption,Mat*);
+PETSC_INTERN PetscErrorCode MatSetPreallocationCOO_MPIAIJ(Mat,PetscInt,const PetscInt[],const PetscInt[]);
+PETSC_INTERN PetscErrorCode MatSetValuesCOO_MPIAIJ(Mat,const PetscScalar[],InsertMode);
+PETSC_INTERN PetscErrorCode MatMultBasis_MPIAIJ(Mat,Vec,PetscInt,const PetscScalar[],const PetscScalar[],const PetscScalar[],Vec[]);
 PETSC_INTERN PetscErrorCode MatIncreaseOverlap_MPIAIJ(Mat,PetscInt,IS [],PetscInt);
 PETSC_INTERN PetscErrorCode MatIncreaseOverlap_MPIAIJ_Scalable(Mat,PetscInt,IS [],PetscInt);
 PETSC_INTERN PetscErrorCode MatFDColoringCreate_MPIXAIJ(Mat,ISColoring,MatFDColoring);
@@ -0,0 +1,246 @@
+/*
+   Matrix powers kernel for MATMPIAIJ: MatMultBasis() with a single communication of the ghost values for the s
+   vectors of the basis. The rows within distance s-1 of the local rows (in the graph of the matrix) are gathered once
+   with MatCreateSubMatrices() and kept with the matrix; each product then scatters the values of x on the rows within
+   distance s and computes the basis redundantly on a region that shrinks by one level with each vector.
+*/
+#include <../src/mat/impls/aij/mpi/mpiaij.h>   /*I "petscmat.h" I*/
+#include <petsc/private/hashmapi.h>
+
+typedef struct {
+  PetscInt         s;           /* depth of the ghost region */
+  PetscObjectState state;       /* state of the matrix when the rows were gathered */
+  PetscInt         n;           /* number of local rows, they come first in the extended numbering */
+  PetscInt         next;        /* number of rows within distance s, the length of the extended vectors */
+  PetscInt         *nlev;       /* the rows within distance l of the local rows are the first nlev[l], l = 0,...,s */
+  PetscInt         *ai,*aj;     /* the rows within distance s-1, with the columns in the extended numbering */
+  PetscScalar      *aa;
+  PetscScalar      *work;       /* three extended vectors */
+  Vec              xext;        /* x on the rows within distance s */
+  VecScatter       scatter;     /* from x to xext */
+} Mat_MPIAIJPowers;
+
+static PetscErrorCode MatMPIAIJPowersReset_Private(Mat_MPIAIJPowers *pw)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(pw->nlev);CHKERRQ(ierr);
+  ierr = PetscFree3(pw->ai,pw->aj,pw->aa);CHKERRQ(ierr);
+  ierr = PetscFree(pw->work);CHKERRQ(ierr);
+  ierr = VecDestroy(&pw->xext);CHKERRQ(ierr);
+  ierr = VecScatterDestroy(&pw->scatter);CHKERRQ(ierr);
+  pw->s = 0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode MatMPIAIJPowersDestroy_Private(void *ptr)
+{
+  Mat_MPIAIJPowers *pw = (Mat_MPIAIJPowers*)ptr;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJPowersReset_Private(pw);CHKERRQ(ierr);
+  ierr = PetscFree(pw);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* appends the global index g to the list of rows in the extended numbering unless it is local or already there */
+static PetscErrorCode MatMPIAIJPowersAdd_Private(Mat A,PetscInt g,PetscHMapI map,PetscInt *next,PetscInt *nalloc,PetscInt **glob)
+{
+  PetscBool      has;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (g >= A->rmap->rstart && g < A->rmap->rend) PetscFunctionReturn(0);
+  ierr = PetscHMapIHas(map,g,&has);CHKERRQ(ierr);
+  if (has) PetscFunctionReturn(0);
+  if (*next == *nalloc) {
+    PetscInt *tmp;
+
+    *nalloc = 2*(*nalloc)+16;
+    ierr    = PetscMalloc1(*nalloc,&tmp);CHKERRQ(ierr);
+    ierr    = PetscMemcpy(tmp,*glob,(*next)*sizeof(PetscInt));CHKERRQ(ierr);
+    ierr    = PetscFree(*glob);CHKERRQ(ierr);
+    *glob   = tmp;
+  }
+  (*glob)[*next] = g;
+  ierr = PetscHMapISet(map,g,*next);CHKERRQ(ierr);
+  (*next)++;
+  PetscFunctionReturn(0);
+}
+
+/* translates a global column to the extended numbering */
+PETSC_STATIC_INLINE PetscErrorCode MatMPIAIJPowersColumn_Private(Mat A,PetscHMapI map,PetscInt g,PetscInt *e)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (g >= A->rmap->rstart && g < A->rmap->rend) *e = g - A->rmap->rstart;
+  else {
+    ierr = PetscHMapIGet(map,g,e);CHKERRQ(ierr);
+    if (*e < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Column %D is not in the ghost region",g);
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   Gathers the rows within distance s-1 of the local rows, level by level: the columns of the rows of level l that are
+   not yet numbered form level l+1. Collective, each level is one call to MatCreateSubMatrices() with all the columns.
+*/
+static PetscErrorCode MatMPIAIJPowersSetUp_Private(Mat A,Vec x,PetscInt s,Mat_MPIAIJPowers *pw)
+{
+  Mat_MPIAIJ        *aij = (Mat_MPIAIJ*)A->data;
+  PetscInt          n = A->rmap->n,rstart = A->rmap->rstart,nghost = aij->B->cmap->n;
+  PetscInt          i,k,l,m,nz,ncols,next,nalloc,*glob;
+  const PetscInt    *cols;
+  const PetscScalar *vals;
+  PetscHMapI        map;
+  Mat               **sub;
+  IS                isrow,iscol;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJPowersReset_Private(pw);CHKERRQ(ierr);
+  ierr = PetscMalloc1(s+1,&pw->nlev);CHKERRQ(ierr);
+  ierr = PetscCalloc1(s,&sub);CHKERRQ(ierr);
+  ierr = PetscHMapICreate(&map);CHKERRQ(ierr);
+
+  /* the local rows, then the ghost columns of the local rows, which are at distance 1 */
+  nalloc = n+nghost;
+  ierr   = PetscMalloc1(PetscMax(nalloc,1),&glob);CHKERRQ(ierr);
+  for (i=0; i<n; i++) glob[i] = rstart+i;
+  next   = n;
+  for (i=0; i<nghost; i++) {ierr = MatMPIAIJPowersAdd_Private(A,aij->garray[i],map,&next,&nalloc,&glob);CHKERRQ(ierr);}
+  pw->nlev[0] = n;
+  pw->nlev[1] = next;
+
+  ierr = ISCreateStride(PETSC_COMM_SELF,A->cmap->N,0,1,&iscol);CHKERRQ(ierr);
+  for (l=1; l<s; l++) {
+    /* the rows are gathered in increasing order and numbered in that order */
+    ierr = PetscSortInt(pw->nlev[l]-pw->nlev[l-1],glob+pw->nlev[l-1]);CHKERRQ(ierr);
+    for (i=pw->nlev[l-1]; i<pw->nlev[l]; i++) {ierr = PetscHMapISet(map,glob[i],i);CHKERRQ(ierr);}
+    ierr = ISCreateGeneral(PETSC_COMM_SELF,pw->nlev[l]-pw->nlev[l-1],glob+pw->nlev[l-1],PETSC_COPY_VALUES,&isrow);CHKERRQ(ierr);
+    ierr = MatCreateSubMatrices(A,1,&isrow,&iscol,MAT_INITIAL_MATRIX,&sub[l]);CHKERRQ(ierr);
+    ierr = ISDestroy(&isrow);CHKERRQ(ierr);
+    for (i=0; i<pw->nlev[l]-pw->nlev[l-1]; i++) {
+      ierr = MatGetRow(sub[l][0],i,&ncols,&cols,NULL);CHKERRQ(ierr);
+      for (k=0; k<ncols; k++) {ierr = MatMPIAIJPowersAdd_Private(A,cols[k],map,&next,&nalloc,&glob);CHKERRQ(ierr);}
+      ierr = MatRestoreRow(sub[l][0],i,&ncols,&cols,NULL);CHKERRQ(ierr);
+    }
+    pw->nlev[l+1] = next;
+  }
+  ierr = ISDestroy(&iscol);CHKERRQ(ierr);
+  ierr = PetscSortInt(pw->nlev[s]-pw->nlev[s-1],glob+pw->nlev[s-1]);CHKERRQ(ierr);
+  for (i=pw->nlev[s-1]; i<pw->nlev[s]; i++) {ierr = PetscHMapISet(map,glob[i],i);CHKERRQ(ierr);}
+
+  /* the rows within distance s-1 in the extended numbering */
+  m  = pw->nlev[s-1];
+  nz = 0;
+  for (i=0; i<n; i++) {
+    ierr = MatGetRow(A,rstart+i,&ncols,NULL,NULL);CHKERRQ(ierr);
+    nz  += ncols;
+    ierr = MatRestoreRow(A,rstart+i,&ncols,NULL,NULL);CHKERRQ(ierr);
+  }
+  for (l=1; l<s; l++) {
+    for (i=0; i<pw->nlev[l]-pw->nlev[l-1]; i++) {
+      ierr = MatGetRow(sub[l][0],i,&ncols,NULL,NULL);CHKERRQ(ierr);
+      nz  += ncols;
+      ierr = MatRestoreRow(sub[l][0],i,&ncols,NULL,NULL);CHKERRQ(ierr);
+    }
+  }
+  ierr = PetscMalloc3(m+1,&pw->ai,nz,&pw->aj,nz,&pw->aa);CHKERRQ(ierr);
+  pw->ai[0] = 0;
+  nz        = 0;
+  for (i=0; i<m; i++) {
+    Mat      B = A;
+    PetscInt row = rstart+i;
+
+    if (i >= n) {
+      for (l=1; i >= pw->nlev[l]; l++) ;
+      B   = sub[l][0];
+      row = i-pw->nlev[l-1];
+    }
+    ierr = MatGetRow(B,row,&ncols,&cols,&vals);CHKERRQ(ierr);
+    for (k=0; k<ncols; k++) {
+      ierr = MatMPIAIJPowersColumn_Private(A,map,cols[k],&pw->aj[nz]);CHKERRQ(ierr);
+      pw->aa[nz++] = vals[k];
+    }
+    ierr = MatRestoreRow(B,row,&ncols,&cols,&vals);CHKERRQ(ierr);
+    pw->ai[i+1] = nz;
+  }
+  for (l=1; l<s; l++) {ierr = MatDestroySubMatrices(1,&sub[l]);CHKERRQ(ierr);}
+  ierr = PetscFree(sub);CHKERRQ(ierr);
+  ierr = PetscHMapIDestroy(&map);CHKERRQ(ierr);
+
+  pw->s    = s;
+  pw->n    = n;
+  pw->next = next;
+  ierr = PetscMalloc1(3*next,&pw->work);CHKERRQ(ierr);
+  ierr = VecCreateSeq(PETSC_COMM_SELF,next,&pw->xext);CHKERRQ(ierr);
+  ierr = ISCreateGeneral(PETSC_COMM_SELF,next,glob,PETSC_OWN_POINTER,&isrow);CHKERRQ(ierr);
+  ierr = VecScatterCreateWithData(x,isrow,pw->xext,NULL,&pw->scatter);CHKERRQ(ierr);
+  ierr = ISDestroy(&isrow);CHKERRQ(ierr);
+  ierr = PetscObjectStateGet((PetscObject)A,&pw->state);CHKERRQ(ierr);
+  ierr = PetscInfo4(A,"Ghost region of depth %D: %D rows, %D of them gathered, %D nonzeros\n",s,next,m-n,nz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMultBasis_MPIAIJ(Mat A,Vec x,PetscInt s,const PetscScalar a[],const PetscScalar b[],const PetscScalar c[],Vec W[])
+{
+  Mat_MPIAIJ        *aij = (Mat_MPIAIJ*)A->data;
+  Mat_MPIAIJPowers  *pw;
+  PetscContainer    container;
+  PetscObjectState  state;
+  const PetscScalar *xx,*p1,*p2 = NULL;
+  PetscScalar       *cur,*w,sum,alpha,beta,gamma;
+  PetscInt          i,j,k,m;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (!aij->matrixpowers || aij->size == 1) {
+    ierr = MatMultBasis_Basic(A,x,s,a,b,c,W);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscObjectQuery((PetscObject)A,"__PETSc_MatMPIAIJPowers",(PetscObject*)&container);CHKERRQ(ierr);
+  if (!container) {
+    ierr = PetscNew(&pw);CHKERRQ(ierr);
+    ierr = PetscContainerCreate(PETSC_COMM_SELF,&container);CHKERRQ(ierr);
+    ierr = PetscContainerSetPointer(container,pw);CHKERRQ(ierr);
+    ierr = PetscContainerSetUserDestroy(container,MatMPIAIJPowersDestroy_Private);CHKERRQ(ierr);
+    ierr = PetscObjectCompose((PetscObject)A,"__PETSc_MatMPIAIJPowers",(PetscObject)container);CHKERRQ(ierr);
+    ierr = PetscContainerDestroy(&container);CHKERRQ(ierr);
+  } else {
+    ierr = PetscContainerGetPointer(container,(void**)&pw);CHKERRQ(ierr);
+  }
+  ierr = PetscObjectStateGet((PetscObject)A,&state);CHKERRQ(ierr);
+  /* a deeper ghost region also serves smaller s, as the levels are nested */
+  if (pw->s < s || pw->state != state) {ierr = MatMPIAIJPowersSetUp_Private(A,x,s,pw);CHKERRQ(ierr);}
+
+  ierr = VecScatterBegin(pw->scatter,x,pw->xext,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = VecScatterEnd(pw->scatter,x,pw->xext,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(pw->xext,&xx);CHKERRQ(ierr);
+  p1   = xx;
+  for (j=0; j<s; j++) {
+    /* W[j] is needed on the rows within distance s-1-j, where the rows of W[j-1] it uses are known */
+    cur   = pw->work+(j%3)*pw->next;
+    m     = pw->nlev[s-1-j];
+    alpha = a ? a[j] : 0.0;
+    beta  = (b && p2) ? b[j] : 0.0;
+    gamma = c ? 1.0/c[j] : 1.0;
+    for (i=0; i<m; i++) {
+      sum = -alpha*p1[i];
+      for (k=pw->ai[i]; k<pw->ai[i+1]; k++) sum += pw->aa[k]*p1[pw->aj[k]];
+      if (p2) sum -= beta*p2[i];
+      cur[i] = gamma*sum;
+    }
+    ierr = PetscLogFlops(2.0*pw->ai[m]+5.0*m);CHKERRQ(ierr);
+    ierr = VecGetArray(W[j],&w);CHKERRQ(ierr);
+    ierr = PetscMemcpy(w,cur,pw->n*sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = VecRestoreArray(W[j],&w);CHKERRQ(ierr);
+    p2 = p1;
+    p1 = cur;
+  }
+  ierr = VecRestoreArrayRead(pw->xext,&xx);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
@@ -379,6 +379,31 @@ PetscErrorCode MatMPIAIJ_MPIDenseDestroy(void *ctx)
 }
 
 #include <petsc/private/vecscatterimpl.h>
+
+/*
+    The products with dense matrices below read the messages of an MPI1 or MPI3 scatter, so a matrix whose Mvctx is
+    a VECSCATTERSF gets an additional MPI1 scatter, as in MatGetBrowsOfAoCols_MPIAIJ()
+*/
+static PetscErrorCode MatMPIAIJGetScatterMPI_Private(Mat A,VecScatter *ctx)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)A->data;
+  PetscBool      sf;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)aij->Mvctx,VECSCATTERSF,&sf);CHKERRQ(ierr);
+  if (!sf) {
+    *ctx = aij->Mvctx;
+    PetscFunctionReturn(0);
+  }
+  if (!aij->Mvctx_mpi1) {
+    aij->Mvctx_mpi1_flg = PETSC_TRUE;
+    ierr = MatSetUpMultiply_MPIAIJ(A);CHKERRQ(ierr);
+  }
+  *ctx = aij->Mvctx_mpi1;
+  PetscFunctionReturn(0);
+}
+
 /*
     This is a "dummy function" that handles the case where matrix C was created as a dense matrix
   directly by the user and passed to MatMatMult() with the MAT_REUSE_MATRIX option
@@ -397,11 +422,13 @@ PetscErrorCode MatMatMultNumeric_MPIDense(Mat A,Mat B,Mat C)
   PetscInt               nz   = aij->B->cmap->n;
   PetscContainer         container;
   MPIAIJ_MPIDense        *contents;
-  VecScatter             ctx   = aij->Mvctx;
-  VecScatter_MPI_General *from = (VecScatter_MPI_General*) ctx->fromdata;
-  VecScatter_MPI_General *to   = (VecScatter_MPI_General*) ctx->todata;
+  VecScatter             ctx;
+  VecScatter_MPI_General *from,*to;
 
   PetscFunctionBegin;
+  ierr = MatMPIAIJGetScatterMPI_Private(A,&ctx);CHKERRQ(ierr);
+  from = (VecScatter_MPI_General*)ctx->fromdata;
+  to   = (VecScatter_MPI_General*)ctx->todata;
   ierr = PetscObjectTypeCompare((PetscObject)B,MATMPIDENSE,&flg);CHKERRQ(ierr);
   if (!flg) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Second matrix must be mpidense");
 
@@ -437,12 +464,14 @@ PetscErrorCode MatMatMultSymbolic_MPIAIJ_MPIDense(Mat A,Mat B,PetscReal fill,Mat
   PetscInt               nz   = aij->B->cmap->n;
   PetscContainer         container;
   MPIAIJ_MPIDense        *contents;
-  VecScatter             ctx   = aij->Mvctx;
-  VecScatter_MPI_General *from = (VecScatter_MPI_General*) ctx->fromdata;
-  VecScatter_MPI_General *to   = (VecScatter_MPI_General*) ctx->todata;
+  VecScatter             ctx;
+  VecScatter_MPI_General *from,*to;
   PetscInt               m     = A->rmap->n,n=B->cmap->n;
 
   PetscFunctionBegin;
+  ierr = MatMPIAIJGetScatterMPI_Private(A,&ctx);CHKERRQ(ierr);
+  from = (VecScatter_MPI_General*)ctx->fromdata;
+  to   = (VecScatter_MPI_General*)ctx->todata;
   ierr = MatCreate(PetscObjectComm((PetscObject)B),C);CHKERRQ(ierr);
   ierr = MatSetSizes(*C,m,n,A->rmap->N,B->cmap->N);CHKERRQ(ierr);
   ierr = MatSetBlockSizesFromMats(*C,A,B);CHKERRQ(ierr);
@@ -472,28 +501,32 @@ PetscErrorCode MatMatMultSymbolic_MPIAIJ_MPIDense(Mat A,Mat B,PetscReal fill,Mat
 
 /*
     Performs an efficient scatter on the rows of B needed by this process; this is
-    a modification of the VecScatterBegin_() routines.
+    a modification of the VecScatterBegin_() routines. All the columns of B go in a
+    single message to each neighbor. MatMPIDenseScatterBegin() posts the receives and
+    sends, MatMPIDenseScatterEnd() unpacks the rows into the work matrix.
 */
-PetscErrorCode MatMPIDenseScatter(Mat A,Mat B,Mat C,Mat *outworkB)
+static PetscErrorCode MatMPIDenseScatterBegin(Mat A,Mat B,Mat C,Mat *outworkB)
 {
   Mat_MPIAIJ             *aij = (Mat_MPIAIJ*)A->data;
   PetscErrorCode         ierr;
-  PetscScalar            *b,*w,*svalues,*rvalues;
-  VecScatter             ctx   = aij->Mvctx;
-  VecScatter_MPI_General *from = (VecScatter_MPI_General*) ctx->fromdata;
-  VecScatter_MPI_General *to   = (VecScatter_MPI_General*) ctx->todata;
+  PetscScalar            *b,*svalues,*rvalues;
+  VecScatter             ctx;
+  VecScatter_MPI_General *from,*to;
   PetscInt               i,j,k;
-  PetscInt               *sindices,*sstarts,*rindices,*rstarts;
-  PetscMPIInt            *sprocs,*rprocs,nrecvs;
+  PetscInt               *sindices,*sstarts,*rstarts,lda = ((Mat_SeqDense*)((Mat_MPIDense*)B->data)->A->data)->lda;
+  PetscMPIInt            *sprocs,*rprocs;
   MPI_Request            *swaits,*rwaits;
   MPI_Comm               comm;
-  PetscMPIInt            tag  = ((PetscObject)ctx)->tag,ncols = B->cmap->N, nrows = aij->B->cmap->n,imdex,nrowsB = B->rmap->n;
-  MPI_Status             status;
+  PetscMPIInt            tag,ncols = B->cmap->N, nrows = aij->B->cmap->n;
   MPIAIJ_MPIDense        *contents;
   PetscContainer         container;
   Mat                    workB;
 
   PetscFunctionBegin;
+  ierr = MatMPIAIJGetScatterMPI_Private(A,&ctx);CHKERRQ(ierr);
+  from = (VecScatter_MPI_General*)ctx->fromdata;
+  to   = (VecScatter_MPI_General*)ctx->todata;
+  tag  = ((PetscObject)ctx)->tag;
   ierr = PetscObjectGetComm((PetscObject)A,&comm);CHKERRQ(ierr);
   ierr = PetscObjectQuery((PetscObject)C,"workB",(PetscObject*)&container);CHKERRQ(ierr);
   if (!container) SETERRQ(comm,PETSC_ERR_PLIB,"Container does not exist");
@@ -507,15 +540,12 @@ PetscErrorCode MatMPIDenseScatter(Mat A,Mat B,Mat C,Mat *outworkB)
   swaits   = contents->swaits;
   svalues  = contents->svalues;
 
-  rindices = from->indices;
   rstarts  = from->starts;
   rprocs   = from->procs;
   rwaits   = contents->rwaits;
   rvalues  = contents->rvalues;
 
   ierr = MatDenseGetArray(B,&b);CHKERRQ(ierr);
-  ierr = MatDenseGetArray(workB,&w);CHKERRQ(ierr);
-
   for (i=0; i<from->n; i++) {
     ierr = MPI_Irecv(rvalues+ncols*rstarts[i],ncols*(rstarts[i+1]-rstarts[i]),MPIU_SCALAR,rprocs[i],tag,comm,rwaits+i);CHKERRQ(ierr);
   }
@@ -524,15 +554,42 @@ PetscErrorCode MatMPIDenseScatter(Mat A,Mat B,Mat C,Mat *outworkB)
     /* pack a message at a time */
     for (j=0; j<sstarts[i+1]-sstarts[i]; j++) {
       for (k=0; k<ncols; k++) {
-        svalues[ncols*(sstarts[i] + j) + k] = b[sindices[sstarts[i]+j] + nrowsB*k];
+        svalues[ncols*(sstarts[i] + j) + k] = b[sindices[sstarts[i]+j] + lda*k];
       }
     }
     ierr = MPI_Isend(svalues+ncols*sstarts[i],ncols*(sstarts[i+1]-sstarts[i]),MPIU_SCALAR,sprocs[i],tag,comm,swaits+i);CHKERRQ(ierr);
   }
+  ierr = MatDenseRestoreArray(B,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
 
+static PetscErrorCode MatMPIDenseScatterEnd(Mat A,Mat B,Mat C,Mat workB)
+{
+  Mat_MPIAIJ             *aij = (Mat_MPIAIJ*)A->data;
+  PetscErrorCode         ierr;
+  PetscScalar            *w,*rvalues;
+  VecScatter             ctx;
+  VecScatter_MPI_General *from,*to;
+  PetscInt               j,k,*rindices,*rstarts;
+  PetscMPIInt            nrecvs,imdex,ncols = B->cmap->N,nrows = aij->B->cmap->n;
+  MPI_Status             status;
+  MPIAIJ_MPIDense        *contents;
+  PetscContainer         container;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJGetScatterMPI_Private(A,&ctx);CHKERRQ(ierr);
+  from = (VecScatter_MPI_General*)ctx->fromdata;
+  to   = (VecScatter_MPI_General*)ctx->todata;
+  ierr = PetscObjectQuery((PetscObject)C,"workB",(PetscObject*)&container);CHKERRQ(ierr);
+  ierr = PetscContainerGetPointer(container,(void**)&contents);CHKERRQ(ierr);
+  rindices = from->indices;
+  rstarts  = from->starts;
+  rvalues  = contents->rvalues;
+
+  ierr   = MatDenseGetArray(workB,&w);CHKERRQ(ierr);
   nrecvs = from->n;
   while (nrecvs) {
-    ierr = MPI_Waitany(from->n,rwaits,&imdex,&status);CHKERRQ(ierr);
+    ierr = MPI_Waitany(from->n,contents->rwaits,&imdex,&status);CHKERRQ(ierr);
     nrecvs--;
     /* unpack a message at a time */
     for (j=0; j<rstarts[imdex+1]-rstarts[imdex]; j++) {
@@ -541,9 +598,8 @@ PetscErrorCode MatMPIDenseScatter(Mat A,Mat B,Mat C,Mat *outworkB)
       }
     }
   }
-  if (to->n) {ierr = MPI_Waitall(to->n,swaits,to->sstatus);CHKERRQ(ierr);}
+  if (to->n) {ierr = MPI_Waitall(to->n,contents->swaits,to->sstatus);CHKERRQ(ierr);}
 
-  ierr = MatDenseRestoreArray(B,&b);CHKERRQ(ierr);
   ierr = MatDenseRestoreArray(workB,&w);CHKERRQ(ierr);
   ierr = MatAssemblyBegin(workB,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
   ierr = MatAssemblyEnd(workB,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
@@ -557,14 +613,19 @@ PetscErrorCode MatMatMultNumeric_MPIAIJ_MPIDense(Mat A,Mat B,Mat C)
   Mat_MPIAIJ     *aij    = (Mat_MPIAIJ*)A->data;
   Mat_MPIDense   *bdense = (Mat_MPIDense*)B->data;
   Mat_MPIDense   *cdense = (Mat_MPIDense*)C->data;
-  Mat            workB;
+  Mat            workB = NULL;
 
   PetscFunctionBegin;
-  /* diagonal block of A times all local rows of B*/
+  /* start sending the rows of B needed by the other processes, all columns in one message */
+  ierr = MatMPIDenseScatterBegin(A,B,C,&workB);CHKERRQ(ierr);
+
+  /* diagonal block of A times all local rows of B, overlapped with the communication */
   ierr = MatMatMultNumeric_SeqAIJ_SeqDense(aij->A,bdense->A,cdense->A);CHKERRQ(ierr);
 
   /* get off processor parts of B needed to complete the product */
-  ierr = MatMPIDenseScatter(A,B,C,&workB);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_MultCommWait,A,B,C,0);CHKERRQ(ierr);
+  ierr = MatMPIDenseScatterEnd(A,B,C,workB);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(MAT_MultCommWait,A,B,C,0);CHKERRQ(ierr);
 
   /* off-diagonal block of A times nonlocal rows of B */
   ierr = MatMatMultNumericAdd_SeqAIJ_SeqDense(aij->B,workB,cdense->A);CHKERRQ(ierr);
@@ -475,6 +475,11 @@ PetscErrorCode MatSetValues_SeqAIJ(Mat A,PetscInt m,const PetscInt im[],PetscInt
       if (value == 0.0 && ignorezeroentries && row != col) goto noinsert;
       if (nonew == 1) goto noinsert;
       if (nonew == -1) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Inserting a new nonzero at (%D,%D) in the matrix",row,col);
+      if (nrow >= rmax && nonew != -2) {
+        /* the row is full, keep the entry aside until the assembly instead of enlarging the arrays */
+        ierr = MatSeqAIJSetValueHash_Private(A,row,col,value,is);CHKERRQ(ierr);
+        goto noinsert;
+      }
       if (A->structure_only) {
         MatSeqXAIJReallocateAIJ_structure_only(A,A->rmap->n,1,nrow,row,col,rmax,ai,aj,rp,imax,nonew,MatScalar);
       } else {
@@ -978,6 +983,81 @@ PetscErrorCode MatView_SeqAIJ(Mat A,PetscViewer viewer)
   PetscFunctionReturn(0);
 }
 
+/*
+   MatSeqAIJMergeHash_Private - Moves the nonzeros kept in the hash table by MatSetValues(), because their rows were
+   full, into the matrix. The arrays are allocated once with the exact number of nonzeros, which replaces the
+   repeated reallocations and copies of MatSeqXAIJReallocateAIJ() when the matrix is not (correctly) preallocated.
+*/
+PetscErrorCode MatSeqAIJMergeHash_Private(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscInt       m = A->rmap->n,nh,i,k,nz,len,*off,*new_i,*new_j;
+  PetscHashIJKey *keys;
+  PetscScalar    *vals;
+  MatScalar      *new_a = NULL;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!a->ht) PetscFunctionReturn(0);
+  ierr = PetscHMapIJVGetSize(a->ht,&nh);CHKERRQ(ierr);
+  if (!nh) PetscFunctionReturn(0);
+  ierr = PetscMalloc3(nh,&keys,nh,&vals,m+1,&off);CHKERRQ(ierr);
+  k    = 0;
+  ierr = PetscHMapIJVGetKeys(a->ht,&k,keys);CHKERRQ(ierr);
+  k    = 0;
+  ierr = PetscHMapIJVGetVals(a->ht,&k,vals);CHKERRQ(ierr);
+  ierr = PetscHMapIJVClear(a->ht);CHKERRQ(ierr);
+
+  /* count the new nonzeros of each row, then lay out the rows without any unused space */
+  ierr = PetscMemzero(off,(m+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  for (k=0; k<nh; k++) off[keys[k].i]++;
+  nz = 0;
+  for (i=0; i<m; i++) nz += a->ilen[i] + off[i];
+  if (A->structure_only) {
+    ierr = PetscMalloc1(nz,&new_j);CHKERRQ(ierr);
+    ierr = PetscMalloc1(m+1,&new_i);CHKERRQ(ierr);
+  } else {
+    ierr = PetscMalloc3(nz,&new_a,nz,&new_j,m+1,&new_i);CHKERRQ(ierr);
+  }
+  new_i[0] = 0;
+  for (i=0; i<m; i++) {
+    new_i[i+1] = new_i[i] + a->ilen[i] + off[i];
+    ierr       = PetscMemcpy(new_j+new_i[i],a->j+a->i[i],a->ilen[i]*sizeof(PetscInt));CHKERRQ(ierr);
+    if (new_a) {ierr = PetscMemcpy(new_a+new_i[i],a->a+a->i[i],a->ilen[i]*sizeof(MatScalar));CHKERRQ(ierr);}
+    off[i] = new_i[i] + a->ilen[i];
+  }
+  for (k=0; k<nh; k++) {
+    i          = off[keys[k].i]++;
+    new_j[i]   = keys[k].j;
+    if (new_a) new_a[i] = vals[k];
+  }
+  for (i=0; i<m; i++) {
+    len = new_i[i+1] - new_i[i];
+    if (len == a->ilen[i]) continue;
+    if (new_a) {ierr = PetscSortIntWithScalarArray(len,new_j+new_i[i],new_a+new_i[i]);CHKERRQ(ierr);}
+    else       {ierr = PetscSortInt(len,new_j+new_i[i]);CHKERRQ(ierr);}
+  }
+  ierr = PetscFree3(keys,vals,off);CHKERRQ(ierr);
+
+  ierr = MatSeqXAIJFreeAIJ(A,&a->a,&a->j,&a->i);CHKERRQ(ierr);
+  a->a = new_a; a->j = new_j; a->i = new_i;
+  if (A->structure_only) {
+    a->singlemalloc = PETSC_FALSE;
+    a->free_a       = PETSC_FALSE;
+  } else {
+    a->singlemalloc = PETSC_TRUE;
+    a->free_a       = PETSC_TRUE;
+  }
+  a->free_ij = PETSC_TRUE;
+  for (i=0; i<m; i++) a->imax[i] = a->ilen[i] = new_i[i+1] - new_i[i];
+  ierr = PetscLogObjectMemory((PetscObject)A,(PetscLogDouble)(nz-a->maxnz)*(sizeof(PetscInt)+(A->structure_only ? 0 : sizeof(MatScalar))));CHKERRQ(ierr);
+  ierr = PetscInfo2(A,"Moved %D new nonzeros of full rows from the hash table into the matrix, %D nonzeros\n",nh,nz);CHKERRQ(ierr);
+  a->nz    = nz;
+  a->maxnz = nz;
+  a->reallocs++;
+  PetscFunctionReturn(0);
+}
+
 PetscErrorCode MatAssemblyEnd_SeqAIJ(Mat A,MatAssemblyType mode)
 {
   Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
@@ -985,11 +1065,13 @@ PetscErrorCode MatAssemblyEnd_SeqAIJ(Mat A,MatAssemblyType mode)
   PetscInt       fshift = 0,i,j,*ai = a->i,*aj = a->j,*imax = a->imax;
   PetscInt       m      = A->rmap->n,*ip,N,*ailen = a->ilen,rmax = 0;
   MatScalar      *aa    = a->a,*ap;
-  PetscReal      ratio  = 0.6;
+  PetscReal      ratio  = a->compressedrowratio;
 
   PetscFunctionBegin;
   if (mode == MAT_FLUSH_ASSEMBLY) PetscFunctionReturn(0);
 
+  ierr = MatSeqAIJMergeHash_Private(A);CHKERRQ(ierr);
+  ai   = a->i; aj = a->j; aa = a->a;
   if (m) rmax = ailen[0]; /* determine row with most nonzeros */
   for (i=1; i<m; i++) {
     /* move each row back by the amount of empty slots (fshift) before it*/
@@ -1038,6 +1120,8 @@ PetscErrorCode MatAssemblyEnd_SeqAIJ(Mat A,MatAssemblyType mode)
     ierr = MatCheckCompressedRow(A,a->nonzerorowcnt,&a->compressedrow,a->i,m,ratio);CHKERRQ(ierr);
   }
   ierr = MatAssemblyEnd_SeqAIJ_Inode(A,mode);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetUpThreads(A);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetUpCompressedIndices(A);CHKERRQ(ierr);
   ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -1074,6 +1158,7 @@ PetscErrorCode MatZeroEntries_SeqAIJ(Mat A)
   PetscErrorCode ierr;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJMergeHash_Private(A);CHKERRQ(ierr);
   ierr = PetscMemzero(a->a,(a->i[A->rmap->n])*sizeof(PetscScalar));CHKERRQ(ierr);
   ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
   PetscFunctionReturn(0);
@@ -1089,6 +1174,8 @@ PetscErrorCode MatDestroy_SeqAIJ(Mat A)
   PetscLogObjectState((PetscObject)A,"Rows=%D, Cols=%D, NZ=%D",A->rmap->n,A->cmap->n,a->nz);
 #endif
   ierr = MatSeqXAIJFreeAIJ(A,&a->a,&a->j,&a->i);CHKERRQ(ierr);
+  ierr = PetscHMapIJVDestroy(&a->ht);CHKERRQ(ierr);
+  ierr = PetscFree2(a->coo_jmap,a->coo_perm);CHKERRQ(ierr);
   ierr = ISDestroy(&a->row);CHKERRQ(ierr);
   ierr = ISDestroy(&a->col);CHKERRQ(ierr);
   ierr = PetscFree(a->diag);CHKERRQ(ierr);
@@ -1104,6 +1191,9 @@ PetscErrorCode MatDestroy_SeqAIJ(Mat A)
   ierr = PetscFree(a->matmult_abdense);CHKERRQ(ierr);
 
   ierr = MatDestroy_SeqAIJ_Inode(A);CHKERRQ(ierr);
+  ierr = MatDestroy_SeqAIJ_Threads(A);CHKERRQ(ierr);
+  ierr = MatDestroy_SeqAIJ_LowPrecision(A);CHKERRQ(ierr);
+  ierr = MatDestroy_SeqAIJ_CompressedIndices(A);CHKERRQ(ierr);
   ierr = PetscFree(A->data);CHKERRQ(ierr);
 
   ierr = PetscObjectChangeTypeName((PetscObject)A,0);CHKERRQ(ierr);
@@ -1127,8 +1217,12 @@ PetscErrorCode MatDestroy_SeqAIJ(Mat A)
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatSeqAIJSetPreallocation_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatResetPreallocation_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatSeqAIJSetPreallocationCSR_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)A,"MatSetPreallocationCOO_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)A,"MatSetValuesCOO_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatReorderForNonzeroDiagonal_C",NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatPtAP_is_seqaij_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)A,"MatAIJSetMultPrecision_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)A,"MatAIJSetCompressedIndices_C",NULL);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -1301,6 +1395,22 @@ PetscErrorCode MatMult_SeqAIJ(Mat A,Vec xx,Vec yy)
 #endif
 
   PetscFunctionBegin;
+#if defined(MATSEQAIJ_LOW_PRECISION)
+  if (a->lowp.precision != MAT_AIJ_MULT_DOUBLE) {
+    ierr = MatMult_SeqAIJ_LowPrecision(A,xx,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
+  if (a->cidx.j) {
+    ierr = MatMult_SeqAIJ_CompressedIndices(A,xx,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.rstart) {
+    ierr = MatMult_SeqAIJ_OpenMP(A,xx,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
   ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
   ii   = a->i;
@@ -1453,6 +1563,22 @@ PetscErrorCode MatMultAdd_SeqAIJ(Mat A,Vec xx,Vec yy,Vec zz)
   PetscBool         usecprow=a->compressedrow.use;
 
   PetscFunctionBegin;
+#if defined(MATSEQAIJ_LOW_PRECISION)
+  if (a->lowp.precision != MAT_AIJ_MULT_DOUBLE) {
+    ierr = MatMultAdd_SeqAIJ_LowPrecision(A,xx,yy,zz);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
+  if (a->cidx.j) {
+    ierr = MatMultAdd_SeqAIJ_CompressedIndices(A,xx,yy,zz);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.rstart) {
+    ierr = MatMultAdd_SeqAIJ_OpenMP(A,xx,yy,zz);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
   ierr = VecGetArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
   if (usecprow) { /* use compressed row format */
@@ -1757,6 +1883,11 @@ PetscErrorCode MatSOR_SeqAIJ(Mat A,Vec bb,PetscReal omega,MatSORType flag,PetscR
   a->fshift = fshift;
   a->omega  = omega;
 
+  if (a->cidx.j && !(flag & SOR_EISENSTAT) && flag != SOR_APPLY_UPPER && flag != SOR_APPLY_LOWER) {
+    ierr = MatSOR_SeqAIJ_CompressedIndices(A,bb,omega,flag,its,xx);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+
   diag  = a->diag;
   t     = a->ssor_work;
   idiag = a->idiag;
@@ -2830,6 +2961,7 @@ PetscErrorCode MatCopy_SeqAIJ(Mat A,Mat B,MatStructure str)
 
     if (a->i[A->rmap->n] != b->i[B->rmap->n]) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_INCOMP,"Number of nonzeros in two matrices are different");
     ierr = PetscMemcpy(b->a,a->a,(a->i[A->rmap->n])*sizeof(PetscScalar));CHKERRQ(ierr);
+    b->lowp.valid = PETSC_FALSE;
     ierr = PetscObjectStateIncrease((PetscObject)B);CHKERRQ(ierr);
   } else {
     ierr = MatCopy_Basic(A,B,str);CHKERRQ(ierr);
@@ -2857,7 +2989,10 @@ PetscErrorCode MatSeqAIJGetArray_SeqAIJ(Mat A,PetscScalar *array[])
 
 PetscErrorCode MatSeqAIJRestoreArray_SeqAIJ(Mat A,PetscScalar *array[])
 {
+  Mat_SeqAIJ *a = (Mat_SeqAIJ*)A->data;
+
   PetscFunctionBegin;
+  a->lowp.valid = PETSC_FALSE;
   PetscFunctionReturn(0);
 }
 
@@ -3545,6 +3680,7 @@ PetscErrorCode  MatRetrieveValues_SeqAIJ(Mat mat)
   if (!aij->saved_values) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ORDER,"Must call MatStoreValues(A);first");
   /* copy values over */
   ierr = PetscMemcpy(aij->a,aij->saved_values,nz*sizeof(PetscScalar));CHKERRQ(ierr);
+  aij->lowp.valid = PETSC_FALSE;
   PetscFunctionReturn(0);
 }
 
@@ -3728,6 +3864,8 @@ PetscErrorCode  MatSeqAIJSetPreallocation_SeqAIJ(Mat B,PetscInt nz,const PetscIn
   B->preallocated = PETSC_TRUE;
 
   b = (Mat_SeqAIJ*)B->data;
+  ierr = PetscHMapIJVDestroy(&b->ht);CHKERRQ(ierr);
+  ierr = PetscFree2(b->coo_jmap,b->coo_perm);CHKERRQ(ierr);
 
   if (!skipallocation) {
     if (!b->imax) {
@@ -3810,6 +3948,8 @@ PetscErrorCode MatResetPreallocation_SeqAIJ(Mat A)
 
   if (!a->i || !a->j || !a->a || !a->imax || !a->ilen) SETERRQ(PETSC_COMM_WORLD,PETSC_ERR_ARG_NULL,"Memory info is incomplete, and can not reset preallocation \n");
 
+  ierr = PetscHMapIJVDestroy(&a->ht);CHKERRQ(ierr);
+  ierr = PetscFree2(a->coo_jmap,a->coo_perm);CHKERRQ(ierr);
   ierr = PetscMemcpy(a->imax,a->ipre,A->rmap->n*sizeof(PetscInt));CHKERRQ(ierr);
   ierr = PetscMemzero(a->ilen,A->rmap->n*sizeof(PetscInt));CHKERRQ(ierr);
   a->i[0] = 0;
@@ -3900,6 +4040,120 @@ PetscErrorCode  MatSeqAIJSetPreallocationCSR_SeqAIJ(Mat B,const PetscInt Ii[],co
   PetscFunctionReturn(0);
 }
 
+/*
+   Groups n coordinates by their local row in [0,m) and sorts them by column within each row. On return Ai[] and Aj[]
+   hold the pattern in CSR form without duplicates (free with PetscFree2()), and unique nonzero k collects the
+   coordinates src[perm[t]] for jmap[k] <= t < jmap[k+1] (free with PetscFree2()). src[] is how the caller identifies
+   each coordinate, typically its position in the value array of MatSetValuesCOO().
+*/
+PetscErrorCode MatSeqAIJCOOSortPattern_Private(PetscInt m,PetscInt n,const PetscInt rows[],const PetscInt cols[],const PetscInt src[],PetscInt **Ai,PetscInt **Aj,PetscInt *nnz,PetscInt **jmap,PetscInt **perm)
+{
+  PetscInt       *ai,*cur,*j,*p,*jm,r,t,k,nz;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscCalloc2(m+1,&ai,m,&cur);CHKERRQ(ierr);
+  ierr = PetscMalloc3(n,&j,n,&p,n+1,&jm);CHKERRQ(ierr);
+  for (k=0; k<n; k++) ai[rows[k]+1]++;
+  for (r=0; r<m; r++) {ai[r+1] += ai[r]; cur[r] = ai[r];}
+  for (k=0; k<n; k++) {
+    t    = cur[rows[k]]++;
+    j[t] = cols[k];
+    p[t] = src[k];
+  }
+  /* sort each row by column and squeeze the repeated columns out of j[], the number of repeats goes to jm[] */
+  for (r=0,nz=0; r<m; r++) {
+    ierr = PetscSortIntWithArray(ai[r+1]-ai[r],j+ai[r],p+ai[r]);CHKERRQ(ierr);
+    for (t=ai[r]; t<ai[r+1]; t++) {
+      if (t > ai[r] && j[t] == j[t-1]) continue;
+      j[nz]  = j[t];
+      jm[nz] = t;
+      nz++;
+    }
+    cur[r] = nz;
+  }
+  jm[nz] = n;
+  ierr = PetscMalloc2(m+1,Ai,nz,Aj);CHKERRQ(ierr);
+  ierr = PetscMalloc2(nz+1,jmap,n,perm);CHKERRQ(ierr);
+  (*Ai)[0] = 0;
+  for (r=0; r<m; r++) (*Ai)[r+1] = cur[r];
+  ierr = PetscMemcpy(*Aj,j,nz*sizeof(PetscInt));CHKERRQ(ierr);
+  ierr = PetscMemcpy(*jmap,jm,(nz+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  ierr = PetscMemcpy(*perm,p,n*sizeof(PetscInt));CHKERRQ(ierr);
+  *nnz = nz;
+  ierr = PetscFree2(ai,cur);CHKERRQ(ierr);
+  ierr = PetscFree3(j,p,jm);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatSetPreallocationCOO_SeqAIJ(Mat A,PetscInt n,const PetscInt coo_i[],const PetscInt coo_j[])
+{
+  Mat_SeqAIJ     *a;
+  PetscInt       *rows,*cols,*src,*Ai,*Aj,*jmap,*perm,k,nv,nz;
+  PetscBool      same;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  /* the types derived from SeqAIJ that keep their own copy of the values go through MatSetValues() */
+  ierr = PetscObjectTypeCompareAny((PetscObject)A,&same,MATSEQAIJ,MATSEQAIJPERM,"");CHKERRQ(ierr);
+  if (!same) {
+    ierr = MatSetPreallocationCOO_Basic(A,n,coo_i,coo_j);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscMalloc3(n,&rows,n,&cols,n,&src);CHKERRQ(ierr);
+  for (k=0,nv=0; k<n; k++) {
+    if (coo_i[k] < 0 || coo_j[k] < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+    if (coo_i[k] >= A->rmap->n) SETERRQ3(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Coordinate %D has row %D, the matrix has %D rows",k,coo_i[k],A->rmap->n);
+    if (coo_j[k] >= A->cmap->n) SETERRQ3(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Coordinate %D has column %D, the matrix has %D columns",k,coo_j[k],A->cmap->n);
+#endif
+    rows[nv] = coo_i[k];
+    cols[nv] = coo_j[k];
+    src[nv]  = k;
+    nv++;
+  }
+  ierr = MatSeqAIJCOOSortPattern_Private(A->rmap->n,nv,rows,cols,src,&Ai,&Aj,&nz,&jmap,&perm);CHKERRQ(ierr);
+  ierr = PetscFree3(rows,cols,src);CHKERRQ(ierr);
+  ierr = MatSetOption(A,MAT_NEW_NONZERO_LOCATIONS,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocationCSR(A,Ai,Aj,NULL);CHKERRQ(ierr);
+  ierr = PetscFree2(Ai,Aj);CHKERRQ(ierr);
+
+  a = (Mat_SeqAIJ*)A->data;
+  if (a->nz != nz) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_PLIB,"The matrix has %D nonzeros instead of %D, is MAT_IGNORE_ZERO_ENTRIES set?",a->nz,nz);
+  a->coo_n    = n;
+  a->coo_nz   = nz;
+  a->coo_jmap = jmap;
+  a->coo_perm = perm;
+  ierr = PetscLogObjectMemory((PetscObject)A,(nz+1+nv)*sizeof(PetscInt));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatSetValuesCOO_SeqAIJ(Mat A,const PetscScalar v[],InsertMode imode)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  const PetscInt *jmap = a->coo_jmap,*perm = a->coo_perm;
+  MatScalar      *aa = a->a;
+  PetscScalar    sum;
+  PetscInt       k,t;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!jmap) {
+    ierr = MatSetValuesCOO_Basic(A,v,imode);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (a->nz != a->coo_nz) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"The nonzero structure changed since MatSetPreallocationCOO(), %D nonzeros instead of %D",a->nz,a->coo_nz);
+  if (a->coo_n) PetscValidScalarPointer(v,2);
+  for (k=0; k<a->coo_nz; k++) {
+    sum = (imode == INSERT_VALUES) ? 0.0 : aa[k];
+    for (t=jmap[k]; t<jmap[k+1]; t++) sum += v[perm[t]];
+    aa[k] = sum;
+  }
+  ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
+  ierr = PetscLogFlops(jmap[a->coo_nz]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 #include <../src/mat/impls/dense/seq/dense.h>
 #include <petsc/private/kernels/petscaxpy.h>
 
@@ -4158,6 +4412,7 @@ PETSC_EXTERN PetscErrorCode MatCreate_SeqAIJ(Mat B)
   b->idiagvalid         = PETSC_FALSE;
   b->ibdiagvalid        = PETSC_FALSE;
   b->keepnonzeropattern = PETSC_FALSE;
+  b->compressedrowratio = 0.6;
 
   ierr = PetscObjectChangeTypeName((PetscObject)B,MATSEQAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatSeqAIJGetArray_C",MatSeqAIJGetArray_SeqAIJ);CHKERRQ(ierr);
@@ -4197,12 +4452,17 @@ PETSC_EXTERN PetscErrorCode MatCreate_SeqAIJ(Mat B)
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatSeqAIJSetPreallocation_C",MatSeqAIJSetPreallocation_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatResetPreallocation_C",MatResetPreallocation_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatSeqAIJSetPreallocationCSR_C",MatSeqAIJSetPreallocationCSR_SeqAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatSetPreallocationCOO_C",MatSetPreallocationCOO_SeqAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatSetValuesCOO_C",MatSetValuesCOO_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatReorderForNonzeroDiagonal_C",MatReorderForNonzeroDiagonal_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatMatMult_seqdense_seqaij_C",MatMatMult_SeqDense_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatMatMultSymbolic_seqdense_seqaij_C",MatMatMultSymbolic_SeqDense_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatMatMultNumeric_seqdense_seqaij_C",MatMatMultNumeric_SeqDense_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatPtAP_is_seqaij_C",MatPtAP_IS_XAIJ);CHKERRQ(ierr);
   ierr = MatCreate_SeqAIJ_Inode(B);CHKERRQ(ierr);
+  ierr = MatCreate_SeqAIJ_Threads(B);CHKERRQ(ierr);
+  ierr = MatCreate_SeqAIJ_LowPrecision(B);CHKERRQ(ierr);
+  ierr = MatCreate_SeqAIJ_CompressedIndices(B);CHKERRQ(ierr);
   ierr = PetscObjectChangeTypeName((PetscObject)B,MATSEQAIJ);CHKERRQ(ierr);
   ierr = MatSeqAIJSetTypeFromOptions(B);CHKERRQ(ierr);  /* this allows changing the matrix subtype to say MATSEQAIJPERM */
   PetscFunctionReturn(0);
@@ -4272,6 +4532,7 @@ PetscErrorCode MatDuplicateNoCreate_SeqAIJ(Mat C,Mat A,MatDuplicateOption cpvalu
   c->idiag              = 0;
   c->ssor_work          = 0;
   c->keepnonzeropattern = a->keepnonzeropattern;
+  c->compressedrowratio = a->compressedrowratio;
   c->free_a             = PETSC_TRUE;
   c->free_ij            = PETSC_TRUE;
 
@@ -4296,6 +4557,9 @@ PetscErrorCode MatDuplicateNoCreate_SeqAIJ(Mat C,Mat A,MatDuplicateOption cpvalu
   C->nonzerostate  = A->nonzerostate;
 
   ierr = MatDuplicate_SeqAIJ_Inode(A,cpvalues,&C);CHKERRQ(ierr);
+  ierr = MatDuplicate_SeqAIJ_Threads(A,C);CHKERRQ(ierr);
+  ierr = MatDuplicate_SeqAIJ_LowPrecision(A,C);CHKERRQ(ierr);
+  ierr = MatDuplicate_SeqAIJ_CompressedIndices(A,C);CHKERRQ(ierr);
   ierr = PetscFunctionListDuplicate(((PetscObject)A)->qlist,&((PetscObject)C)->qlist);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -4616,6 +4880,7 @@ PetscErrorCode MatSeqAIJInvalidateDiagonal(Mat A)
   PetscFunctionBegin;
   a->idiagvalid  = PETSC_FALSE;
   a->ibdiagvalid = PETSC_FALSE;
+  a->lowp.valid  = PETSC_FALSE;
 
   ierr = MatSeqAIJInvalidateDiagonal_Inode(A);CHKERRQ(ierr);
   PetscFunctionReturn(0);
@@ -4904,6 +5169,12 @@ PETSC_EXTERN void PETSC_STDCALL matsetvaluesseqaij_(Mat *AA,PetscInt *mm,const P
       if (value == 0.0 && ignorezeroentries) goto noinsert;
       if (nonew == 1) goto noinsert;
       if (nonew == -1) SETERRABORT(PetscObjectComm((PetscObject)A),PETSC_ERR_ARG_OUTOFRANGE,"Inserting a new nonzero in the matrix");
+      if (nrow >= rmax && nonew != -2) {
+        /* as in MatSetValues_SeqAIJ(), so that an entry is never both in the hash table and in the arrays */
+        ierr = MatSeqAIJSetValueHash_Private(A,row,col,value,is);CHKERRQ(ierr);
+        low  = i;
+        continue;
+      }
       MatSeqXAIJReallocateAIJ(A,A->rmap->n,1,nrow,row,col,rmax,aa,ai,aj,rp,ap,imax,nonew,MatScalar);
       N = nrow++ - 1; a->nz++; high++;
       /* shift up all the later entries in this row */
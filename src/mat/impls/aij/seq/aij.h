@@ -4,6 +4,7 @@
 
 #include <petsc/private/matimpl.h>
 #include <petscctable.h>
+#include <petsc/private/hashmapijv.h>
 
 /*
     Struct header shared by SeqAIJ, SeqBAIJ and SeqSBAIJ matrix formats
@@ -97,6 +98,58 @@ typedef struct {
   PetscObjectState mat_nonzerostate;               /* non-zero state when inodes were checked for */
 } Mat_SeqAIJ_Inode;
 
+/* Info about the row partition used by the OpenMP threaded MatMult() and MatMultAdd() helper class for SeqAIJ */
+typedef struct {
+  PetscInt         nthreads;                       /* number of threads requested with -mat_aij_threads */
+  PetscInt         nchunks;                        /* number of chunks in the partitions below */
+  PetscInt         *rstart;                        /* first row (compressed row if compressedrow.use) of each chunk */
+  PetscInt         *nstart,*nrstart;               /* first inode of each chunk and the row it starts at */
+  PetscObjectState mat_nonzerostate;               /* non-zero state when the partitions were computed */
+} Mat_SeqAIJ_Threads;
+
+PETSC_INTERN PetscErrorCode MatCreate_SeqAIJ_Threads(Mat);
+PETSC_INTERN PetscErrorCode MatSeqAIJSetUpThreads(Mat);
+PETSC_INTERN PetscErrorCode MatDestroy_SeqAIJ_Threads(Mat);
+PETSC_INTERN PetscErrorCode MatDuplicate_SeqAIJ_Threads(Mat,Mat);
+#if defined(PETSC_HAVE_OPENMP)
+PETSC_INTERN PetscErrorCode MatMult_SeqAIJ_OpenMP(Mat,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatMultAdd_SeqAIJ_OpenMP(Mat,Vec,Vec,Vec);
+#endif
+
+/* Low precision copy of the matrix values used by MatMult() and MatMultAdd(), see MatAIJSetMultPrecision() */
+typedef struct {
+  MatAIJMultPrecision precision;                  /* precision requested with -mat_aij_mult_precision */
+  void                *a;                         /* the values, float or unsigned short (bfloat16) */
+  PetscInt            nz;                         /* length of a */
+  PetscBool           valid;                      /* a is up to date with the values of the matrix */
+  PetscObjectState    state;                      /* object state when a was computed */
+} Mat_SeqAIJ_LowPrecision;
+
+PETSC_INTERN PetscErrorCode MatCreate_SeqAIJ_LowPrecision(Mat);
+PETSC_INTERN PetscErrorCode MatDestroy_SeqAIJ_LowPrecision(Mat);
+PETSC_INTERN PetscErrorCode MatDuplicate_SeqAIJ_LowPrecision(Mat,Mat);
+#if defined(PETSC_USE_REAL_DOUBLE) && !defined(PETSC_USE_COMPLEX)
+#define MATSEQAIJ_LOW_PRECISION
+PETSC_INTERN PetscErrorCode MatMult_SeqAIJ_LowPrecision(Mat,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatMultAdd_SeqAIJ_LowPrecision(Mat,Vec,Vec,Vec);
+#endif
+
+/* 16 bit column offsets from the diagonal used by MatMult(), MatMultAdd() and MatSOR(), see MatAIJSetCompressedIndices() */
+typedef struct {
+  PetscBool        use;                           /* requested with -mat_aij_compressed_indices */
+  PetscShort       *j;                            /* column minus row of each nonzero, NULL if some does not fit */
+  PetscInt         nz;                            /* number of nonzeros when j was computed */
+  PetscObjectState mat_nonzerostate;              /* non-zero state when j was computed */
+} Mat_SeqAIJ_CompressedIndices;
+
+PETSC_INTERN PetscErrorCode MatCreate_SeqAIJ_CompressedIndices(Mat);
+PETSC_INTERN PetscErrorCode MatSeqAIJSetUpCompressedIndices(Mat);
+PETSC_INTERN PetscErrorCode MatDestroy_SeqAIJ_CompressedIndices(Mat);
+PETSC_INTERN PetscErrorCode MatDuplicate_SeqAIJ_CompressedIndices(Mat,Mat);
+PETSC_INTERN PetscErrorCode MatMult_SeqAIJ_CompressedIndices(Mat,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatMultAdd_SeqAIJ_CompressedIndices(Mat,Vec,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatSOR_SeqAIJ_CompressedIndices(Mat,Vec,PetscReal,MatSORType,PetscInt,Vec);
+
 PETSC_INTERN PetscErrorCode MatView_SeqAIJ_Inode(Mat,PetscViewer);
 PETSC_INTERN PetscErrorCode MatAssemblyEnd_SeqAIJ_Inode(Mat,MatAssemblyType);
 PETSC_INTERN PetscErrorCode MatDestroy_SeqAIJ_Inode(Mat);
@@ -110,6 +163,13 @@ PETSC_INTERN PetscErrorCode MatLUFactorNumeric_SeqAIJ_Inode(Mat,Mat,const MatFac
 typedef struct {
   SEQAIJHEADER(MatScalar);
   Mat_SeqAIJ_Inode inode;
+  Mat_SeqAIJ_Threads threads;
+  Mat_SeqAIJ_LowPrecision lowp;
+  Mat_SeqAIJ_CompressedIndices cidx;
+  PetscReal        compressedrowratio;        /* fraction of empty rows above which the compressed row format is used */
+  PetscHMapIJV     ht;                        /* new nonzeros of full rows, moved into the matrix at assembly */
+  PetscInt         coo_n,coo_nz;              /* number of coordinates given to MatSetPreallocationCOO() and of nonzeros they make */
+  PetscInt         *coo_jmap,*coo_perm;       /* nonzero k is the sum of v[coo_perm[t]] for coo_jmap[k] <= t < coo_jmap[k+1] */
   MatScalar        *saved_values;             /* location for stashing nonzero values of matrix */
 
   PetscScalar *idiag,*mdiag,*ssor_work;       /* inverse of diagonal entries, diagonal values and workspace for Eisenstat trick */
@@ -213,6 +273,37 @@ PETSC_STATIC_INLINE PetscErrorCode MatSeqXAIJFreeAIJ(Mat AA,MatScalar **a,PetscI
     Ain->reallocs++; \
   } \
 
+/*
+    Keeps a new nonzero of a row that has no room left in the hash table of the matrix instead of enlarging the
+    arrays with MatSeqXAIJReallocateAIJ(); MatSeqAIJMergeHash_Private() moves the entries into the matrix, allocating
+    the arrays once with the exact number of nonzeros, at the next final assembly.
+*/
+PETSC_STATIC_INLINE PetscErrorCode MatSeqAIJSetValueHash_Private(Mat A,PetscInt row,PetscInt col,PetscScalar value,InsertMode is)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscHashIJKey key;
+  PetscHashIter  iter;
+  PetscBool      missing;
+  PetscScalar    v;
+  PetscErrorCode ierr;
+
+  if (!a->ht) {ierr = PetscHMapIJVCreate(&a->ht);CHKERRQ(ierr);}
+  key.i = row;
+  key.j = col;
+  ierr  = PetscHMapIJVPut(a->ht,key,&iter,&missing);CHKERRQ(ierr);
+  if (!missing && is == ADD_VALUES) {
+    ierr   = PetscHMapIJVIterGet(a->ht,iter,&v);CHKERRQ(ierr);
+    value += v;
+  }
+  ierr = PetscHMapIJVIterSet(a->ht,iter,value);CHKERRQ(ierr);
+  if (missing) A->nonzerostate++;
+  return 0;
+}
+
+PETSC_INTERN PetscErrorCode MatSeqAIJMergeHash_Private(Mat);
+PETSC_INTERN PetscErrorCode MatSeqAIJCOOSortPattern_Private(PetscInt,PetscInt,const PetscInt[],const PetscInt[],const PetscInt[],PetscInt**,PetscInt**,PetscInt*,PetscInt**,PetscInt**);
+PETSC_INTERN PetscErrorCode MatSetPreallocationCOO_SeqAIJ(Mat,PetscInt,const PetscInt[],const PetscInt[]);
+PETSC_INTERN PetscErrorCode MatSetValuesCOO_SeqAIJ(Mat,const PetscScalar[],InsertMode);
 PETSC_INTERN PetscErrorCode MatSeqAIJSetPreallocation_SeqAIJ(Mat,PetscInt,const PetscInt*);
 PETSC_INTERN PetscErrorCode MatILUFactorSymbolic_SeqAIJ_inplace(Mat,Mat,IS,IS,const MatFactorInfo*);
 PETSC_INTERN PetscErrorCode MatILUFactorSymbolic_SeqAIJ(Mat,Mat,IS,IS,const MatFactorInfo*);
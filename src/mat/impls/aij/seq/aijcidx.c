@@ -0,0 +1,363 @@
+/*
+    Compressed column indices for MatMult(), MatMultAdd() and MatSOR() with the SeqAIJ (and hence MPIAIJ) format.
+
+    With -mat_aij_compressed_indices each column index is also stored as a 16 bit offset from the index of its row,
+  which is the natural base for the banded matrices produced by finite element or finite difference discretizations
+  (after a bandwidth reducing ordering such as RCM). The kernels read the offsets, 2 bytes per nonzero instead of
+  sizeof(PetscInt), and add them to the row index on the fly. If some row has a column further than 32767 from the
+  diagonal the offsets are not used for that matrix.
+*/
+#include <../src/mat/impls/aij/seq/aij.h>
+
+#define MATSEQAIJ_CIDX_MAX 32767
+
+static PetscErrorCode MatAIJSetCompressedIndices_SeqAIJ(Mat A,PetscBool flg)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (flg != a->cidx.use) {
+    ierr = MatDestroy_SeqAIJ_CompressedIndices(A);CHKERRQ(ierr);
+    a->cidx.use = flg;
+    if (flg && A->assembled) {ierr = MatSeqAIJSetUpCompressedIndices(A);CHKERRQ(ierr);}
+  }
+  PetscFunctionReturn(0);
+}
+
+/*@
+   MatAIJSetCompressedIndices - Use 16 bit column offsets in MatMult(), MatMultAdd() and MatSOR() with MATSEQAIJ
+   and MATMPIAIJ matrices
+
+   Logically Collective on Mat
+
+   Input Parameters:
++  A - the matrix
+-  flg - PETSC_TRUE to use the compressed indices
+
+   Options Database Key:
+.  -mat_aij_compressed_indices - use the compressed indices
+
+   Notes:
+   In addition to the column indices, the matrix stores for each nonzero the difference between its column and its
+   row as a 16 bit integer; the kernels load these differences instead of the column indices, reducing the index
+   traffic by a factor of 2 (4 with --with-64-bit-indices). This requires that every row has its nonzeros within 32767
+   columns of the diagonal, which holds for the banded matrices of most structured and, after a bandwidth reducing
+   ordering, unstructured discretizations. Otherwise the option is ignored for that matrix (see -info).
+
+   The offsets are recomputed at MatAssemblyEnd() when the nonzero structure has changed. The point block SOR used
+   with inodes keeps using the column indices; MATSEQAIJ subclasses that provide their own MatMult(), such as
+   MATSEQAIJPERM and MATSEQAIJSELL, ignore the option. With MatAIJSetMultPrecision() the low precision kernels,
+   which use the column indices, take precedence for MatMult() and MatMultAdd().
+
+   For MATMPIAIJ the option applies to the diagonal and off-diagonal blocks; the latter is indexed by the off-process
+   columns so it uses compressed indices only when the number of those columns and of the local rows are small enough.
+
+   Level: advanced
+
+.seealso: MatAIJSetMultPrecision(), MatMult(), MatSOR()
+@*/
+PetscErrorCode MatAIJSetCompressedIndices(Mat A,PetscBool flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(A,MAT_CLASSID,1);
+  PetscValidLogicalCollectiveBool(A,flg,2);
+  ierr = PetscTryMethod(A,"MatAIJSetCompressedIndices_C",(Mat,PetscBool),(A,flg));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatCreate_SeqAIJ_CompressedIndices(Mat B)
+{
+  Mat_SeqAIJ     *b = (Mat_SeqAIJ*)B->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  b->cidx.use              = PETSC_FALSE;
+  b->cidx.j                = NULL;
+  b->cidx.nz               = -1;
+  b->cidx.mat_nonzerostate = 0;
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatAIJSetCompressedIndices_C",MatAIJSetCompressedIndices_SeqAIJ);CHKERRQ(ierr);
+
+  ierr = PetscOptionsBegin(PetscObjectComm((PetscObject)B),((PetscObject)B)->prefix,"Options for SEQAIJ matrix","Mat");CHKERRQ(ierr);
+  ierr = PetscOptionsBool("-mat_aij_compressed_indices","Use 16 bit column offsets in MatMult() and MatSOR()","MatAIJSetCompressedIndices",b->cidx.use,&b->cidx.use,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsEnd();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatDestroy_SeqAIJ_CompressedIndices(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(a->cidx.j);CHKERRQ(ierr);
+  a->cidx.nz = -1;
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatDuplicate_SeqAIJ_CompressedIndices(Mat A,Mat C)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data,*c = (Mat_SeqAIJ*)C->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  c->cidx.use              = a->cidx.use;
+  c->cidx.j                = NULL;
+  c->cidx.nz               = a->cidx.nz;
+  c->cidx.mat_nonzerostate = a->cidx.mat_nonzerostate;
+  if (a->cidx.j) {
+    ierr = PetscMalloc1(a->nz,&c->cidx.j);CHKERRQ(ierr);
+    ierr = PetscMemcpy(c->cidx.j,a->cidx.j,a->nz*sizeof(PetscShort));CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory((PetscObject)C,a->nz*sizeof(PetscShort));CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+    Computes the offsets; called from MatAssemblyEnd_SeqAIJ() after MatSeqAIJSetUpThreads(), whose row partition is
+  used to place the offsets near the threads that read them. Nothing is done unless the nonzero structure has changed.
+*/
+PetscErrorCode MatSeqAIJSetUpCompressedIndices(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscInt       r,k,t,m = A->rmap->n,mc = m,nz = a->nz,nc = 1,maxoff = 0,off;
+  const PetscInt *ai = a->i,*aj = a->j,*rstart = NULL,*ii = NULL;
+  PetscShort     *cj;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!a->cidx.use || A->factortype || A->structure_only) PetscFunctionReturn(0);
+  if (a->cidx.nz == nz && a->cidx.mat_nonzerostate == A->nonzerostate) PetscFunctionReturn(0);
+  ierr = MatDestroy_SeqAIJ_CompressedIndices(A);CHKERRQ(ierr);
+
+  for (r=0; r<m; r++) {
+    for (k=ai[r]; k<ai[r+1]; k++) {
+      off    = PetscAbsInt(aj[k] - r);
+      maxoff = PetscMax(maxoff,off);
+    }
+  }
+  if (maxoff > MATSEQAIJ_CIDX_MAX) {
+    ierr = PetscInfo2(A,"Not using compressed column indices, a nonzero is %D columns from the diagonal (maximum %d); consider a bandwidth reducing ordering\n",maxoff,MATSEQAIJ_CIDX_MAX);CHKERRQ(ierr);
+    a->cidx.nz               = nz;
+    a->cidx.mat_nonzerostate = A->nonzerostate;
+    PetscFunctionReturn(0);
+  }
+
+  ierr = PetscMalloc1(nz,&cj);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory((PetscObject)A,nz*sizeof(PetscShort));CHKERRQ(ierr);
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.rstart) {
+    nc     = a->threads.nchunks;
+    rstart = a->threads.rstart;
+    if (a->compressedrow.use) {
+      mc = a->compressedrow.nrows;
+      ii = a->compressedrow.rindex;
+    }
+  }
+#endif
+#if defined(PETSC_HAVE_OPENMP)
+#pragma omp parallel for num_threads(nc) schedule(static,1) private(r,k) if(nc > 1)
+#endif
+  for (t=0; t<nc; t++) {
+    /* chunk t of the threaded kernels covers the (compressed) rows rstart[t] to rstart[t+1]-1 */
+    PetscInt rs = 0,re = m;
+    if (rstart) {
+      rs = rstart[t] < mc ? (ii ? ii[rstart[t]] : rstart[t]) : m;
+      re = rstart[t+1] < mc ? (ii ? ii[rstart[t+1]] : rstart[t+1]) : m;
+    }
+    for (r=rs; r<re; r++) {
+      for (k=ai[r]; k<ai[r+1]; k++) cj[k] = (PetscShort)(aj[k] - r);
+    }
+  }
+  a->cidx.j                = cj;
+  a->cidx.nz               = nz;
+  a->cidx.mat_nonzerostate = A->nonzerostate;
+  ierr = PetscInfo1(A,"Using 16 bit column offsets, maximum distance of a nonzero from the diagonal %D\n",maxoff);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* z = A x (y == NULL) or z = y + A x */
+static PetscErrorCode MatMultAdd_SeqAIJ_CompressedIndices_Private(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  const PetscScalar *x,*y = NULL;
+  PetscScalar       *z;
+  const MatScalar   *aa = a->a;
+  const PetscShort  *cj = a->cidx.j;
+  const PetscInt    *ii = a->i,*ridx = NULL,*rstart = NULL;
+  PetscInt          t,m = A->rmap->n,nc = 1;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy) {
+    ierr = VecGetArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  }
+  if (a->compressedrow.use) {
+    if (!yy) {
+      ierr = PetscMemzero(z,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    } else if (zz != yy) {
+      ierr = PetscMemcpy(z,y,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    }
+    m    = a->compressedrow.nrows;
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+  }
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.rstart) {
+    nc     = a->threads.nchunks;
+    rstart = a->threads.rstart;
+  }
+#pragma omp parallel for num_threads(nc) schedule(static,1) if(nc > 1)
+#endif
+  for (t=0; t<nc; t++) {
+    PetscInt i,n,r;
+    for (i=(rstart ? rstart[t] : 0); i<(rstart ? rstart[t+1] : m); i++) {
+      const PetscScalar *xr;
+      const MatScalar   *v   = aa + ii[i];
+      const PetscShort  *idx = cj + ii[i];
+      PetscScalar       sum;
+
+      r   = ridx ? ridx[i] : i;
+      n   = ii[i+1] - ii[i];
+      xr  = x + r;
+      sum = y ? y[r] : 0.0;
+      PetscSparseDensePlusDot(sum,xr,v,idx,n);
+      z[r] = sum;
+    }
+  }
+  if (yy) {
+    ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+    ierr = VecRestoreArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = PetscLogFlops(2.0*a->nz - a->nonzerorowcnt);CHKERRQ(ierr);
+    ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMult_SeqAIJ_CompressedIndices(Mat A,Vec xx,Vec yy)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMultAdd_SeqAIJ_CompressedIndices_Private(A,xx,NULL,yy);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMultAdd_SeqAIJ_CompressedIndices(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMultAdd_SeqAIJ_CompressedIndices_Private(A,xx,yy,zz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+    The forward, backward and symmetric sweeps of MatSOR_SeqAIJ() with the compressed indices; the diagonal has been
+  inverted by the caller. The row offsets index x + i, so the macros of the standard kernels are used unchanged.
+*/
+PetscErrorCode MatSOR_SeqAIJ_CompressedIndices(Mat A,Vec bb,PetscReal omega,MatSORType flag,PetscInt its,Vec xx)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  PetscScalar       *x,*xi,sum,*t = a->ssor_work;
+  const MatScalar   *v,*idiag = a->idiag,*mdiag = a->mdiag;
+  const PetscScalar *b,*xb;
+  const PetscShort  *idx;
+  const PetscInt    *diag = a->diag,*ai = a->i;
+  PetscInt          n,m = A->rmap->n,i;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+  if (flag & SOR_ZERO_INITIAL_GUESS) {
+    if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+      for (i=0; i<m; i++) {
+        n   = diag[i] - ai[i];
+        idx = a->cidx.j + ai[i];
+        v   = a->a + ai[i];
+        xi  = x + i;
+        sum = b[i];
+        PetscSparseDenseMinusDot(sum,xi,v,idx,n);
+        t[i] = sum;
+        x[i] = sum*idiag[i];
+      }
+      xb   = t;
+      ierr = PetscLogFlops(a->nz);CHKERRQ(ierr);
+    } else xb = b;
+    if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+      for (i=m-1; i>=0; i--) {
+        n   = ai[i+1] - diag[i] - 1;
+        idx = a->cidx.j + diag[i] + 1;
+        v   = a->a + diag[i] + 1;
+        xi  = x + i;
+        sum = xb[i];
+        PetscSparseDenseMinusDot(sum,xi,v,idx,n);
+        if (xb == b) {
+          x[i] = sum*idiag[i];
+        } else {
+          x[i] = (1-omega)*x[i] + sum*idiag[i];  /* omega in idiag */
+        }
+      }
+      ierr = PetscLogFlops(a->nz);CHKERRQ(ierr); /* assumes 1/2 in upper */
+    }
+    its--;
+  }
+  while (its--) {
+    if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+      for (i=0; i<m; i++) {
+        xi  = x + i;
+        /* lower */
+        n   = diag[i] - ai[i];
+        idx = a->cidx.j + ai[i];
+        v   = a->a + ai[i];
+        sum = b[i];
+        PetscSparseDenseMinusDot(sum,xi,v,idx,n);
+        t[i] = sum;             /* save application of the lower-triangular part */
+        /* upper */
+        n   = ai[i+1] - diag[i] - 1;
+        idx = a->cidx.j + diag[i] + 1;
+        v   = a->a + diag[i] + 1;
+        PetscSparseDenseMinusDot(sum,xi,v,idx,n);
+        x[i] = (1. - omega)*x[i] + sum*idiag[i]; /* omega in idiag */
+      }
+      xb   = t;
+      ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+    } else xb = b;
+    if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+      for (i=m-1; i>=0; i--) {
+        xi  = x + i;
+        sum = xb[i];
+        if (xb == b) {
+          /* whole matrix (no checkpointing available) */
+          n   = ai[i+1] - ai[i];
+          idx = a->cidx.j + ai[i];
+          v   = a->a + ai[i];
+          PetscSparseDenseMinusDot(sum,xi,v,idx,n);
+          x[i] = (1. - omega)*x[i] + (sum + mdiag[i]*x[i])*idiag[i];
+        } else { /* lower-triangular part has been saved, so only apply upper-triangular */
+          n   = ai[i+1] - diag[i] - 1;
+          idx = a->cidx.j + diag[i] + 1;
+          v   = a->a + diag[i] + 1;
+          PetscSparseDenseMinusDot(sum,xi,v,idx,n);
+          x[i] = (1. - omega)*x[i] + sum*idiag[i];  /* omega in idiag */
+        }
+      }
+      if (xb == b) {
+        ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+      } else {
+        ierr = PetscLogFlops(a->nz);CHKERRQ(ierr); /* assumes 1/2 in upper */
+      }
+    }
+  }
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
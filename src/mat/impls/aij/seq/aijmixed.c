@@ -0,0 +1,290 @@
+/*
+    Mixed precision MatMult() and MatMultAdd() for the SeqAIJ (and hence MPIAIJ) format.
+
+    MatMult() with AIJ is limited by the memory bandwidth and, for a typical matrix, most of the bytes
+  moved are the matrix values. With -mat_aij_mult_precision single (or bfloat16) the products use a copy
+  of the values rounded to 4 (or 2) bytes, while the vectors and the sums remain in double precision.
+  The copy is computed at the first product after the values of the matrix have changed; all the other
+  operations (factorizations, MatGetValues(), MatView(), ...) keep using the double precision values.
+*/
+#include <../src/mat/impls/aij/seq/aij.h>
+
+const char *const MatAIJMultPrecisions[] = {"DOUBLE","SINGLE","BFLOAT16","MatAIJMultPrecision","MAT_AIJ_MULT_",0};
+
+static PetscErrorCode MatAIJSetMultPrecision_SeqAIJ(Mat A,MatAIJMultPrecision precision)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+#if !defined(MATSEQAIJ_LOW_PRECISION)
+  if (precision != MAT_AIJ_MULT_DOUBLE) {
+    ierr = PetscInfo1(A,"Ignoring MatAIJMultPrecision %s, only supported for real double precision scalars\n",MatAIJMultPrecisions[precision]);CHKERRQ(ierr);
+    precision = MAT_AIJ_MULT_DOUBLE;
+  }
+#endif
+  if (precision != a->lowp.precision) {
+    ierr = MatDestroy_SeqAIJ_LowPrecision(A);CHKERRQ(ierr);
+    a->lowp.precision = precision;
+  }
+  PetscFunctionReturn(0);
+}
+
+/*@
+   MatAIJSetMultPrecision - Sets the precision of the matrix values used by MatMult() and MatMultAdd() with
+   MATSEQAIJ and MATMPIAIJ matrices
+
+   Logically Collective on Mat
+
+   Input Parameters:
++  A - the matrix
+-  precision - MAT_AIJ_MULT_DOUBLE, MAT_AIJ_MULT_SINGLE or MAT_AIJ_MULT_BFLOAT16
+
+   Options Database Key:
+.  -mat_aij_mult_precision <double,single,bfloat16> - the precision
+
+   Notes:
+   The matrix keeps its values in full precision. With MAT_AIJ_MULT_SINGLE or MAT_AIJ_MULT_BFLOAT16 an additional
+   copy of the values, rounded to the nearest representable number, is used by the matrix-vector products; the input
+   and output vectors and the accumulation of the sums are in full precision. This reduces the memory traffic of
+   MatMult() by roughly 30 percent (single) or 45 percent (bfloat16) but introduces relative errors of the order of 1e-7
+   (single) or 4e-3 (bfloat16) in the products. It is intended for matrices used only to build preconditioners, such
+   as the coarse grid operators of multigrid methods, and for the operator of inner iterations of
+   flexible or defect-correction methods. Values outside the range of single precision become infinite.
+
+   Only available for real double precision scalars; otherwise the call is ignored. For MATMPIAIJ the precision applies
+   to the diagonal and off-diagonal blocks; MATSEQAIJ subclasses that provide their own MatMult(), such as MATSEQAIJPERM
+   and MATSEQAIJSELL, ignore it.
+
+   Level: advanced
+
+.seealso: MatAIJMultPrecision, MatMult()
+@*/
+PetscErrorCode MatAIJSetMultPrecision(Mat A,MatAIJMultPrecision precision)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(A,MAT_CLASSID,1);
+  PetscValidLogicalCollectiveEnum(A,precision,2);
+  ierr = PetscTryMethod(A,"MatAIJSetMultPrecision_C",(Mat,MatAIJMultPrecision),(A,precision));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatCreate_SeqAIJ_LowPrecision(Mat B)
+{
+  Mat_SeqAIJ          *b = (Mat_SeqAIJ*)B->data;
+  MatAIJMultPrecision precision = MAT_AIJ_MULT_DOUBLE;
+  PetscErrorCode      ierr;
+
+  PetscFunctionBegin;
+  b->lowp.precision = MAT_AIJ_MULT_DOUBLE;
+  b->lowp.a         = NULL;
+  b->lowp.nz        = 0;
+  b->lowp.valid     = PETSC_FALSE;
+  b->lowp.state     = 0;
+  ierr = PetscObjectComposeFunction((PetscObject)B,"MatAIJSetMultPrecision_C",MatAIJSetMultPrecision_SeqAIJ);CHKERRQ(ierr);
+
+  ierr = PetscOptionsBegin(PetscObjectComm((PetscObject)B),((PetscObject)B)->prefix,"Options for SEQAIJ matrix","Mat");CHKERRQ(ierr);
+  ierr = PetscOptionsEnum("-mat_aij_mult_precision","Precision of the matrix values used by MatMult() and MatMultAdd()","MatAIJSetMultPrecision",MatAIJMultPrecisions,(PetscEnum)precision,(PetscEnum*)&precision,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsEnd();CHKERRQ(ierr);
+  ierr = MatAIJSetMultPrecision_SeqAIJ(B,precision);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatDestroy_SeqAIJ_LowPrecision(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(a->lowp.a);CHKERRQ(ierr);
+  a->lowp.nz    = 0;
+  a->lowp.valid = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatDuplicate_SeqAIJ_LowPrecision(Mat A,Mat C)
+{
+  Mat_SeqAIJ *a = (Mat_SeqAIJ*)A->data,*c = (Mat_SeqAIJ*)C->data;
+
+  PetscFunctionBegin;
+  /* the copy of the values is recomputed at the first product with C */
+  c->lowp.precision = a->lowp.precision;
+  c->lowp.a         = NULL;
+  c->lowp.nz        = 0;
+  c->lowp.valid     = PETSC_FALSE;
+  c->lowp.state     = 0;
+  PetscFunctionReturn(0);
+}
+
+#if defined(MATSEQAIJ_LOW_PRECISION)
+typedef union {
+  float        f;
+  unsigned int i;
+} MatSeqAIJFloatBits;
+
+/* rounds to the nearest bfloat16, ties to even; NaN stay (quiet) NaN */
+PETSC_STATIC_INLINE unsigned short MatSeqAIJFloatToBFloat16(float f)
+{
+  MatSeqAIJFloatBits u;
+
+  u.f = f;
+  if ((u.i & 0x7fffffffu) > 0x7f800000u) return (unsigned short)((u.i >> 16) | 0x40u);
+  u.i += 0x7fffu + ((u.i >> 16) & 1u);
+  return (unsigned short)(u.i >> 16);
+}
+
+PETSC_STATIC_INLINE PetscReal MatSeqAIJBFloat16ToReal(unsigned short b)
+{
+  MatSeqAIJFloatBits u;
+
+  u.i = ((unsigned int)b) << 16;
+  return (PetscReal)u.f;
+}
+
+/*
+    Recomputes the low precision values if the matrix has changed since they were computed. With
+  -mat_aij_threads the copy is made by the threads that use it, see MatSeqAIJSetUpThreads().
+*/
+static PetscErrorCode MatSeqAIJUpdateLowPrecision(Mat A)
+{
+  Mat_SeqAIJ       *a = (Mat_SeqAIJ*)A->data;
+  PetscInt         t,k,nz = a->nz,nc = 1;
+  const PetscInt   *ii = a->compressedrow.use ? a->compressedrow.i : a->i;
+  const PetscInt   *rstart = NULL;
+  const MatScalar  *aa = a->a;
+  PetscObjectState state;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectStateGet((PetscObject)A,&state);CHKERRQ(ierr);
+  if (a->lowp.valid && a->lowp.state == state && a->lowp.nz == nz) PetscFunctionReturn(0);
+  if (a->lowp.nz != nz) {
+    size_t size = a->lowp.precision == MAT_AIJ_MULT_SINGLE ? sizeof(float) : sizeof(unsigned short);
+
+    ierr = PetscFree(a->lowp.a);CHKERRQ(ierr);
+    ierr = PetscMalloc(nz*size,&a->lowp.a);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory((PetscObject)A,nz*size);CHKERRQ(ierr);
+    a->lowp.nz = nz;
+  }
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.rstart) {
+    nc     = a->threads.nchunks;
+    rstart = a->threads.rstart;
+  }
+#endif
+  if (a->lowp.precision == MAT_AIJ_MULT_SINGLE) {
+    float *la = (float*)a->lowp.a;
+#if defined(PETSC_HAVE_OPENMP)
+#pragma omp parallel for num_threads(nc) schedule(static,1) private(k) if(nc > 1)
+#endif
+    for (t=0; t<nc; t++) {
+      PetscInt kstart = rstart ? ii[rstart[t]] : 0,kend = rstart ? ii[rstart[t+1]] : nz;
+      for (k=kstart; k<kend; k++) la[k] = (float)aa[k];
+    }
+  } else {
+    unsigned short *la = (unsigned short*)a->lowp.a;
+#if defined(PETSC_HAVE_OPENMP)
+#pragma omp parallel for num_threads(nc) schedule(static,1) private(k) if(nc > 1)
+#endif
+    for (t=0; t<nc; t++) {
+      PetscInt kstart = rstart ? ii[rstart[t]] : 0,kend = rstart ? ii[rstart[t+1]] : nz;
+      for (k=kstart; k<kend; k++) la[k] = MatSeqAIJFloatToBFloat16((float)aa[k]);
+    }
+  }
+  a->lowp.valid = PETSC_TRUE;
+  a->lowp.state = state;
+  ierr = PetscInfo2(A,"Computed %s copy of %D matrix values for MatMult()\n",MatAIJMultPrecisions[a->lowp.precision],nz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* loops over the (compressed) rows of chunk t; y is NULL for MatMult() */
+#define MatSeqAIJLowPrecisionRows(la,conv) do {                             \
+    PetscInt i,k,r;                                                         \
+    for (i=(rstart ? rstart[t] : 0); i<(rstart ? rstart[t+1] : m); i++) {   \
+      PetscScalar sum;                                                      \
+      r   = ridx ? ridx[i] : i;                                             \
+      sum = y ? y[r] : 0.0;                                                 \
+      for (k=ii[i]; k<ii[i+1]; k++) sum += conv(la[k])*x[aj[k]];            \
+      z[r] = sum;                                                           \
+    }                                                                       \
+  } while (0)
+
+#define MatSeqAIJLowPrecisionFloat(v) ((PetscScalar)(v))
+
+static PetscErrorCode MatMultAdd_SeqAIJ_LowPrecision_Private(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  const PetscScalar *x,*y = NULL;
+  PetscScalar       *z;
+  const PetscInt    *ii = a->i,*aj = a->j,*ridx = NULL,*rstart = NULL;
+  PetscInt          t,m = A->rmap->n,nc = 1;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUpdateLowPrecision(A);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy) {
+    ierr = VecGetArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  }
+  if (a->compressedrow.use) {
+    if (!yy) {
+      ierr = PetscMemzero(z,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    } else if (zz != yy) {
+      ierr = PetscMemcpy(z,y,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    }
+    m    = a->compressedrow.nrows;
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+  }
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.rstart) {
+    nc     = a->threads.nchunks;
+    rstart = a->threads.rstart;
+  }
+#endif
+  if (a->lowp.precision == MAT_AIJ_MULT_SINGLE) {
+    const float *la = (const float*)a->lowp.a;
+#if defined(PETSC_HAVE_OPENMP)
+#pragma omp parallel for num_threads(nc) schedule(static,1) if(nc > 1)
+#endif
+    for (t=0; t<nc; t++) MatSeqAIJLowPrecisionRows(la,MatSeqAIJLowPrecisionFloat);
+  } else {
+    const unsigned short *la = (const unsigned short*)a->lowp.a;
+#if defined(PETSC_HAVE_OPENMP)
+#pragma omp parallel for num_threads(nc) schedule(static,1) if(nc > 1)
+#endif
+    for (t=0; t<nc; t++) MatSeqAIJLowPrecisionRows(la,MatSeqAIJBFloat16ToReal);
+  }
+  if (yy) {
+    ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+    ierr = VecRestoreArrayPair(yy,zz,(PetscScalar**)&y,&z);CHKERRQ(ierr);
+  } else {
+    ierr = PetscLogFlops(2.0*a->nz - a->nonzerorowcnt);CHKERRQ(ierr);
+    ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMult_SeqAIJ_LowPrecision(Mat A,Vec xx,Vec yy)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMultAdd_SeqAIJ_LowPrecision_Private(A,xx,NULL,yy);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMultAdd_SeqAIJ_LowPrecision(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMultAdd_SeqAIJ_LowPrecision_Private(A,xx,yy,zz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+#endif
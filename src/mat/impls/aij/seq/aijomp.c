@@ -0,0 +1,240 @@
+/*
+    OpenMP threaded MatMult() and MatMultAdd() support for the SeqAIJ (and hence MPIAIJ) format.
+
+    The rows (and the inodes, when they are used) are split into chunks with roughly the same number
+  of nonzeros, one chunk per thread. The same partition is used at MatAssemblyEnd() to copy the matrix
+  values and column indices into fresh memory, so that with a first-touch page placement policy each
+  chunk lives on the NUMA domain of the thread that multiplies with it.
+*/
+#include <../src/mat/impls/aij/seq/aij.h>
+
+PetscErrorCode MatCreate_SeqAIJ_Threads(Mat B)
+{
+  Mat_SeqAIJ     *b = (Mat_SeqAIJ*)B->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  b->threads.nthreads = 0;
+  b->threads.nchunks  = 0;
+  b->threads.rstart   = NULL;
+  b->threads.nstart   = NULL;
+  b->threads.nrstart  = NULL;
+
+  ierr = PetscOptionsBegin(PetscObjectComm((PetscObject)B),((PetscObject)B)->prefix,"Options for SEQAIJ matrix","Mat");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-mat_aij_threads","Number of OpenMP threads used by MatMult() and MatMultAdd()",NULL,b->threads.nthreads,&b->threads.nthreads,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsEnd();CHKERRQ(ierr);
+#if !defined(PETSC_HAVE_OPENMP)
+  if (b->threads.nthreads > 1) {
+    ierr = PetscInfo(B,"Ignoring -mat_aij_threads since PETSc was not configured --with-openmp\n");CHKERRQ(ierr);
+    b->threads.nthreads = 0;
+  }
+#endif
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatDestroy_SeqAIJ_Threads(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(a->threads.rstart);CHKERRQ(ierr);
+  ierr = PetscFree2(a->threads.nstart,a->threads.nrstart);CHKERRQ(ierr);
+  a->threads.nchunks = 0;
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatDuplicate_SeqAIJ_Threads(Mat A,Mat C)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data,*c = (Mat_SeqAIJ*)C->data;
+  PetscInt       nc = a->threads.nchunks;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  c->threads.nthreads         = a->threads.nthreads;
+  c->threads.nchunks          = 0;
+  c->threads.rstart           = NULL;
+  c->threads.nstart           = NULL;
+  c->threads.nrstart          = NULL;
+  c->threads.mat_nonzerostate = a->threads.mat_nonzerostate;
+  if (a->threads.rstart) {
+    c->threads.nchunks = nc;
+    ierr = PetscMalloc1(nc+1,&c->threads.rstart);CHKERRQ(ierr);
+    ierr = PetscMemcpy(c->threads.rstart,a->threads.rstart,(nc+1)*sizeof(PetscInt));CHKERRQ(ierr);
+    if (a->threads.nstart && c->inode.size) {
+      ierr = PetscMalloc2(nc+1,&c->threads.nstart,nc+1,&c->threads.nrstart);CHKERRQ(ierr);
+      ierr = PetscMemcpy(c->threads.nstart,a->threads.nstart,(nc+1)*sizeof(PetscInt));CHKERRQ(ierr);
+      ierr = PetscMemcpy(c->threads.nrstart,a->threads.nrstart,(nc+1)*sizeof(PetscInt));CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+    Computes the partitions used by the threaded kernels; called from MatAssemblyEnd_SeqAIJ() after
+  the compressed row and inode information has been determined. Nothing is done unless the nonzero
+  structure has changed since the previous call.
+*/
+PetscErrorCode MatSeqAIJSetUpThreads(Mat A)
+{
+#if defined(PETSC_HAVE_OPENMP)
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+  PetscInt       t,k,r,m = A->rmap->n,mc,nc = a->threads.nthreads,nz = a->nz;
+  PetscInt       *rstart,*nstart = NULL,*nrstart = NULL,*new_i,*new_j;
+  const PetscInt *ii,*ns;
+  PetscInt64     target;
+  MatScalar      *new_a;
+#endif
+
+  PetscFunctionBegin;
+#if defined(PETSC_HAVE_OPENMP)
+  if (nc < 2 || A->factortype || A->structure_only) PetscFunctionReturn(0);
+  if (a->threads.rstart && a->threads.mat_nonzerostate == A->nonzerostate) PetscFunctionReturn(0);
+  ierr = MatDestroy_SeqAIJ_Threads(A);CHKERRQ(ierr);
+
+  /* the threaded inode kernels cannot return errors, so reject here the node sizes they do not handle */
+  for (k=0; a->inode.size && k<a->inode.node_count; k++) {
+    if (a->inode.size[k] < 1 || a->inode.size[k] > 5) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_COR,"Inode %D has size %D, the inode kernels support sizes 1 to 5",k,a->inode.size[k]);
+  }
+
+  /* partition the (compressed) rows traversed by MatMult_SeqAIJ() */
+  if (a->compressedrow.use) {
+    mc = a->compressedrow.nrows;
+    ii = a->compressedrow.i;
+  } else {
+    mc = m;
+    ii = a->i;
+  }
+  ierr      = PetscMalloc1(nc+1,&rstart);CHKERRQ(ierr);
+  rstart[0] = 0;
+  for (t=1,r=0; t<nc; t++) {
+    target = ((PetscInt64)nz*t)/nc;
+    while (r < mc && ii[r] < target) r++;
+    rstart[t] = r;
+  }
+  rstart[nc] = mc;
+
+  /* partition the inodes traversed by MatMult_SeqAIJ_Inode() */
+  if (a->inode.size) {
+    ns        = a->inode.size;
+    ierr      = PetscMalloc2(nc+1,&nstart,nc+1,&nrstart);CHKERRQ(ierr);
+    nstart[0] = nrstart[0] = 0;
+    for (t=1,k=0,r=0; t<nc; t++) {
+      target = ((PetscInt64)nz*t)/nc;
+      while (k < a->inode.node_count && a->i[r] < target) r += ns[k++];
+      nstart[t]  = k;
+      nrstart[t] = r;
+    }
+    nstart[nc]  = a->inode.node_count;
+    nrstart[nc] = m;
+  }
+
+  /* first touch: each thread copies the values and column indices of the chunk it will multiply with */
+  if (a->singlemalloc) {
+    ierr = PetscMalloc3(nz,&new_a,nz,&new_j,m+1,&new_i);CHKERRQ(ierr);
+    ierr = PetscMemcpy(new_i,a->i,(m+1)*sizeof(PetscInt));CHKERRQ(ierr);
+#pragma omp parallel for num_threads(nc) schedule(static,1) private(k)
+    for (t=0; t<nc; t++) {
+      PetscInt kstart = nstart ? a->i[nrstart[t]] : ii[rstart[t]];
+      PetscInt kend   = nstart ? a->i[nrstart[t+1]] : ii[rstart[t+1]];
+      for (k=kstart; k<kend; k++) {
+        new_a[k] = a->a[k];
+        new_j[k] = a->j[k];
+      }
+    }
+    ierr     = MatSeqXAIJFreeAIJ(A,&a->a,&a->j,&a->i);CHKERRQ(ierr);
+    a->a     = new_a;
+    a->j     = new_j;
+    a->i     = new_i;
+    a->maxnz = nz;
+  }
+
+  a->threads.nchunks          = nc;
+  a->threads.rstart           = rstart;
+  a->threads.nstart           = nstart;
+  a->threads.nrstart          = nrstart;
+  a->threads.mat_nonzerostate = A->nonzerostate;
+  ierr = PetscInfo2(A,"Using %D OpenMP threads in MatMult(), rows partitioned by nonzeros%s\n",nc,nstart ? " along inode boundaries" : "");CHKERRQ(ierr);
+#endif
+  PetscFunctionReturn(0);
+}
+
+#if defined(PETSC_HAVE_OPENMP)
+PetscErrorCode MatMult_SeqAIJ_OpenMP(Mat A,Vec xx,Vec yy)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  PetscScalar       *y;
+  const PetscScalar *x;
+  const MatScalar   *aa;
+  PetscErrorCode    ierr;
+  const PetscInt    *aj,*ii,*ridx = NULL,*rstart = a->threads.rstart;
+  PetscInt          t,n,i,nc = a->threads.nchunks;
+  PetscScalar       sum;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  ii   = a->i;
+  if (a->compressedrow.use) {
+    ierr = PetscMemzero(y,A->rmap->n*sizeof(PetscScalar));CHKERRQ(ierr);
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+  }
+#pragma omp parallel for num_threads(nc) schedule(static,1) private(i,n,aj,aa,sum)
+  for (t=0; t<nc; t++) {
+    for (i=rstart[t]; i<rstart[t+1]; i++) {
+      n   = ii[i+1] - ii[i];
+      aj  = a->j + ii[i];
+      aa  = a->a + ii[i];
+      sum = 0.0;
+      PetscSparseDensePlusDot(sum,x,aa,aj,n);
+      y[ridx ? ridx[i] : i] = sum;
+    }
+  }
+  ierr = PetscLogFlops(2.0*a->nz - a->nonzerorowcnt);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMultAdd_SeqAIJ_OpenMP(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  PetscScalar       *y,*z;
+  const PetscScalar *x;
+  const MatScalar   *aa;
+  PetscErrorCode    ierr;
+  const PetscInt    *aj,*ii,*ridx = NULL,*rstart = a->threads.rstart;
+  PetscInt          t,n,i,r,nc = a->threads.nchunks;
+  PetscScalar       sum;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
+  ii   = a->i;
+  if (a->compressedrow.use) {
+    if (zz != yy) {
+      ierr = PetscMemcpy(z,y,A->rmap->n*sizeof(PetscScalar));CHKERRQ(ierr);
+    }
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+  }
+#pragma omp parallel for num_threads(nc) schedule(static,1) private(i,r,n,aj,aa,sum)
+  for (t=0; t<nc; t++) {
+    for (i=rstart[t]; i<rstart[t+1]; i++) {
+      r   = ridx ? ridx[i] : i;
+      n   = ii[i+1] - ii[i];
+      aj  = a->j + ii[i];
+      aa  = a->a + ii[i];
+      sum = y[r];
+      PetscSparseDensePlusDot(sum,x,aa,aj,n);
+      z[r] = sum;
+    }
+  }
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+#endif
@@ -373,32 +373,29 @@ static PetscErrorCode MatRestoreColumnIJ_SeqAIJ_Inode(Mat A,PetscInt oshift,Pets
 
 /* ----------------------------------------------------------- */
 
-static PetscErrorCode MatMult_SeqAIJ_Inode(Mat A,Vec xx,Vec yy)
+/*
+   Computes y = A x for the inodes nstart <= i < nend, the first of which starts at row rstart.
+   Returns -1, or the first node whose size is not supported, in which case y is incomplete. It does not
+   raise the error itself since it is called from within OpenMP parallel regions; the threaded callers
+   need not check since MatSeqAIJSetUpThreads() rejects such node sizes before any threaded use.
+*/
+PETSC_STATIC_INLINE PetscInt MatMult_SeqAIJ_Inode_Nodes(Mat_SeqAIJ *a,const PetscScalar *x,PetscScalar *y,PetscInt nstart,PetscInt nend,PetscInt rstart,PetscInt *nonzerorows)
 {
-  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
   PetscScalar       sum1,sum2,sum3,sum4,sum5,tmp0,tmp1;
-  PetscScalar       *y;
-  const PetscScalar *x;
   const MatScalar   *v1,*v2,*v3,*v4,*v5;
-  PetscErrorCode    ierr;
-  PetscInt          i1,i2,n,i,row,node_max,nsz,sz,nonzerorow=0;
+  PetscInt          i1,i2,n,i,row,nsz,sz,nonzerorow=0;
   const PetscInt    *idx,*ns,*ii;
 
 #if defined(PETSC_HAVE_PRAGMA_DISJOINT)
 #pragma disjoint(*x,*y,*v1,*v2,*v3,*v4,*v5)
 #endif
 
-  PetscFunctionBegin;
-  if (!a->inode.size) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_COR,"Missing Inode Structure");
-  node_max = a->inode.node_count;
-  ns       = a->inode.size;     /* Node Size array */
-  ierr     = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
-  ierr     = VecGetArray(yy,&y);CHKERRQ(ierr);
-  idx      = a->j;
-  v1       = a->a;
-  ii       = a->i;
+  ns  = a->inode.size;          /* Node Size array */
+  idx = a->j + a->i[rstart];
+  v1  = a->a + a->i[rstart];
+  ii  = a->i + rstart;
 
-  for (i = 0,row = 0; i< node_max; ++i) {
+  for (i = nstart,row = rstart; i< nend; ++i) {
     nsz         = ns[i];
     n           = ii[1] - ii[0];
     nonzerorow += (n>0)*nsz;
@@ -553,41 +550,73 @@ static PetscErrorCode MatMult_SeqAIJ_Inode(Mat A,Vec xx,Vec yy)
       idx    +=4*sz;
       break;
     default:
-      SETERRQ(PETSC_COMM_SELF,PETSC_ERR_COR,"Node size not yet supported");
+      return i;
     }
   }
+  *nonzerorows = nonzerorow;
+  return -1;
+}
+
+static PetscErrorCode MatMult_SeqAIJ_Inode(Mat A,Vec xx,Vec yy)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  PetscScalar       *y;
+  const PetscScalar *x;
+  PetscErrorCode    ierr;
+  PetscInt          nonzerorow=0,node;
+
+  PetscFunctionBegin;
+  if (!a->inode.size) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_COR,"Missing Inode Structure");
+#if defined(MATSEQAIJ_LOW_PRECISION)
+  if (a->lowp.precision != MAT_AIJ_MULT_DOUBLE) {
+    ierr = MatMult_SeqAIJ_LowPrecision(A,xx,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
+  if (a->cidx.j) {
+    ierr = MatMult_SeqAIJ_CompressedIndices(A,xx,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.nstart) {
+    const PetscInt *nstart = a->threads.nstart,*nrstart = a->threads.nrstart;
+    PetscInt       t,nc = a->threads.nchunks,nzr;
+
+#pragma omp parallel for num_threads(nc) schedule(static,1) private(nzr) reduction(+:nonzerorow)
+    for (t=0; t<nc; t++) {
+      (void)MatMult_SeqAIJ_Inode_Nodes(a,x,y,nstart[t],nstart[t+1],nrstart[t],&nzr);
+      nonzerorow += nzr;
+    }
+  } else
+#endif
+  {
+    node = MatMult_SeqAIJ_Inode_Nodes(a,x,y,0,a->inode.node_count,0,&nonzerorow);
+    if (node >= 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_COR,"Node size %D not yet supported",a->inode.size[node]);
+  }
   ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
   ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
   ierr = PetscLogFlops(2.0*a->nz - nonzerorow);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 /* ----------------------------------------------------------- */
-/* Almost same code as the MatMult_SeqAIJ_Inode() */
-static PetscErrorCode MatMultAdd_SeqAIJ_Inode(Mat A,Vec xx,Vec zz,Vec yy)
+/* Almost same code as the MatMult_SeqAIJ_Inode_Nodes(), and likewise returns the first unsupported node or -1 */
+PETSC_STATIC_INLINE PetscInt MatMultAdd_SeqAIJ_Inode_Nodes(Mat_SeqAIJ *a,const PetscScalar *x,const PetscScalar *z,PetscScalar *y,PetscInt nstart,PetscInt nend,PetscInt rstart)
 {
-  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
   PetscScalar       sum1,sum2,sum3,sum4,sum5,tmp0,tmp1;
   const MatScalar   *v1,*v2,*v3,*v4,*v5;
-  const PetscScalar *x;
-  PetscScalar       *y,*z,*zt;
-  PetscErrorCode    ierr;
-  PetscInt          i1,i2,n,i,row,node_max,nsz,sz;
+  const PetscScalar *zt;
+  PetscInt          i1,i2,n,i,row,nsz,sz;
   const PetscInt    *idx,*ns,*ii;
 
-  PetscFunctionBegin;
-  if (!a->inode.size) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_COR,"Missing Inode Structure");
-  node_max = a->inode.node_count;
-  ns       = a->inode.size;     /* Node Size array */
-
-  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
-  ierr = VecGetArrayPair(zz,yy,&z,&y);CHKERRQ(ierr);
-  zt = z;
+  ns  = a->inode.size;          /* Node Size array */
+  zt  = z + rstart;
+  idx = a->j + a->i[rstart];
+  v1  = a->a + a->i[rstart];
+  ii  = a->i + rstart;
 
-  idx = a->j;
-  v1  = a->a;
-  ii  = a->i;
-
-  for (i = 0,row = 0; i< node_max; ++i) {
+  for (i = nstart,row = rstart; i< nend; ++i) {
     nsz = ns[i];
     n   = ii[1] - ii[0];
     ii += nsz;
@@ -739,8 +768,48 @@ static PetscErrorCode MatMultAdd_SeqAIJ_Inode(Mat A,Vec xx,Vec zz,Vec yy)
       idx    +=4*sz;
       break;
     default:
-      SETERRQ(PETSC_COMM_SELF,PETSC_ERR_COR,"Node size not yet supported");
+      return i;
+    }
+  }
+  return -1;
+}
+
+static PetscErrorCode MatMultAdd_SeqAIJ_Inode(Mat A,Vec xx,Vec zz,Vec yy)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y,*z;
+  PetscErrorCode    ierr;
+  PetscInt          node;
+
+  PetscFunctionBegin;
+  if (!a->inode.size) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_COR,"Missing Inode Structure");
+#if defined(MATSEQAIJ_LOW_PRECISION)
+  if (a->lowp.precision != MAT_AIJ_MULT_DOUBLE) {
+    ierr = MatMultAdd_SeqAIJ_LowPrecision(A,xx,zz,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
+  if (a->cidx.j) {
+    ierr = MatMultAdd_SeqAIJ_CompressedIndices(A,xx,zz,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayPair(zz,yy,&z,&y);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_OPENMP)
+  if (a->threads.nstart) {
+    const PetscInt *nstart = a->threads.nstart,*nrstart = a->threads.nrstart;
+    PetscInt       t,nc = a->threads.nchunks;
+
+#pragma omp parallel for num_threads(nc) schedule(static,1)
+    for (t=0; t<nc; t++) {
+      (void)MatMultAdd_SeqAIJ_Inode_Nodes(a,x,z,y,nstart[t],nstart[t+1],nrstart[t]);
     }
+  } else
+#endif
+  {
+    node = MatMultAdd_SeqAIJ_Inode_Nodes(a,x,z,y,0,a->inode.node_count,0);
+    if (node >= 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_COR,"Node size %D not yet supported",a->inode.size[node]);
   }
   ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
   ierr = VecRestoreArrayPair(zz,yy,&z,&y);CHKERRQ(ierr);
@@ -327,6 +327,15 @@ PetscErrorCode MatMult_SeqSELL(Mat A,Vec xx,Vec yy)
 #endif
 
   PetscFunctionBegin;
+#if defined(MATSEQSELL_RUNTIME_SIMD)
+  if (a->simd == MAT_SELL_SIMD_AVX512) {
+    ierr = MatMult_SeqSELL_AVX512(A,xx,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  } else if (a->simd == MAT_SELL_SIMD_AVX2) {
+    ierr = MatMult_SeqSELL_AVX2(A,xx,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
   ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
 #if defined(PETSC_HAVE_IMMINTRIN_H) && defined(__AVX512F__) && defined(PETSC_USE_REAL_DOUBLE) && !defined(PETSC_USE_COMPLEX) && !defined(PETSC_USE_64BIT_INDICES)
@@ -526,6 +535,15 @@ PetscErrorCode MatMultAdd_SeqSELL(Mat A,Vec xx,Vec yy,Vec zz)
 #endif
 
   PetscFunctionBegin;
+#if defined(MATSEQSELL_RUNTIME_SIMD)
+  if (a->simd == MAT_SELL_SIMD_AVX512) {
+    ierr = MatMultAdd_SeqSELL_AVX512(A,xx,yy,zz);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  } else if (a->simd == MAT_SELL_SIMD_AVX2) {
+    ierr = MatMultAdd_SeqSELL_AVX2(A,xx,yy,zz);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
   ierr = VecGetArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
 #if defined(PETSC_HAVE_IMMINTRIN_H) && defined(__AVX512F__) && defined(PETSC_USE_REAL_DOUBLE) && !defined(PETSC_USE_COMPLEX) && !defined(PETSC_USE_64BIT_INDICES)
@@ -680,6 +698,12 @@ PetscErrorCode MatMultTransposeAdd_SeqSELL(Mat A,Vec xx,Vec zz,Vec yy)
     ierr = MatMultAdd_SeqSELL(A,xx,zz,yy);CHKERRQ(ierr);
     PetscFunctionReturn(0);
   }
+#if defined(MATSEQSELL_RUNTIME_SIMD)
+  if (a->simd == MAT_SELL_SIMD_AVX512) {
+    ierr = MatMultTransposeAdd_SeqSELL_AVX512(A,xx,zz,yy);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   if (zz != yy) { ierr = VecCopy(zz,yy);CHKERRQ(ierr); }
   ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
   ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
@@ -688,7 +712,7 @@ PetscErrorCode MatMultTransposeAdd_SeqSELL(Mat A,Vec xx,Vec zz,Vec yy)
       for (r=0; r<(A->rmap->n & 0x07); ++r) {
         row        = 8*i + r;
         nnz_in_row = a->rlen[row];
-        for (j=0; j<nnz_in_row; ++j) y[acolidx[8*j+r]] += aval[8*j+r] * x[row];
+        for (j=0; j<nnz_in_row; ++j) y[acolidx[a->sliidx[i]+8*j+r]] += aval[a->sliidx[i]+8*j+r] * x[row];
       }
       break;
     }
@@ -1966,6 +1990,7 @@ PETSC_EXTERN PetscErrorCode MatCreate_SeqSELL(Mat B)
   b->fshift             = 0.0;
   b->idiagvalid         = PETSC_FALSE;
   b->keepnonzeropattern = PETSC_FALSE;
+  ierr = MatSeqSELLSetSIMDFromOptions_Private(B);CHKERRQ(ierr);
 
   ierr = PetscObjectChangeTypeName((PetscObject)B,MATSEQSELL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)B,"MatSeqSELLGetArray_C",MatSeqSELLGetArray_SeqSELL);CHKERRQ(ierr);
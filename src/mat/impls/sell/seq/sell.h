@@ -40,6 +40,17 @@ PetscInt    totalslices;       /* total number of slices */ \
 PetscInt    *getrowcols;       /* workarray for MatGetRow_SeqSELL */ \
 PetscScalar *getrowvals        /* workarray for MatGetRow_SeqSELL */ \
 
+/*
+ Compilers that can build the AVX2 and AVX-512 kernels with __attribute__((target())), independently of the
+ compiler flags; the kernels are then selected at runtime with PetscAVXIsEnabled()
+*/
+#if defined(PETSC_HAVE_IMMINTRIN_H) && (defined(__x86_64__) || defined(__i386__)) && !defined(__INTEL_COMPILER) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))) && defined(PETSC_USE_REAL_DOUBLE) && !defined(PETSC_USE_COMPLEX) && !defined(PETSC_USE_64BIT_INDICES)
+#define MATSEQSELL_RUNTIME_SIMD
+#endif
+
+/* kernels used by MatMult(), MatMultAdd() and MatMultTransposeAdd(), see -mat_sell_simd */
+typedef enum {MAT_SELL_SIMD_GENERIC,MAT_SELL_SIMD_AVX2,MAT_SELL_SIMD_AVX512} MatSeqSELLSIMDType;
+
 typedef struct {
   SEQSELLHEADER(MatScalar);
   MatScalar   *saved_values;             /* location for stashing nonzero values of matrix */
@@ -47,6 +58,7 @@ typedef struct {
   PetscBool   idiagvalid;                /* current idiag[] and mdiag[] are valid */
   PetscScalar fshift,omega;              /* last used omega and fshift */
   ISColoring  coloring;                  /* set with MatADSetColoring() used by MatADSetValues() */
+  MatSeqSELLSIMDType simd;               /* kernels selected at runtime for the products */
 } Mat_SeqSELL;
 
 /*
@@ -171,6 +183,14 @@ PETSC_INTERN PetscErrorCode MatMult_SeqSELL(Mat,Vec,Vec);
 PETSC_INTERN PetscErrorCode MatMultAdd_SeqSELL(Mat,Vec,Vec,Vec);
 PETSC_INTERN PetscErrorCode MatMultTranspose_SeqSELL(Mat,Vec,Vec);
 PETSC_INTERN PetscErrorCode MatMultTransposeAdd_SeqSELL(Mat,Vec,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatSeqSELLSetSIMDFromOptions_Private(Mat);
+#if defined(MATSEQSELL_RUNTIME_SIMD)
+PETSC_INTERN PetscErrorCode MatMult_SeqSELL_AVX2(Mat,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatMultAdd_SeqSELL_AVX2(Mat,Vec,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatMult_SeqSELL_AVX512(Mat,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatMultAdd_SeqSELL_AVX512(Mat,Vec,Vec,Vec);
+PETSC_INTERN PetscErrorCode MatMultTransposeAdd_SeqSELL_AVX512(Mat,Vec,Vec,Vec);
+#endif
 PETSC_INTERN PetscErrorCode MatMissingDiagonal_SeqSELL(Mat,PetscBool*,PetscInt*);
 PETSC_INTERN PetscErrorCode MatMarkDiagonal_SeqSELL(Mat);
 PETSC_INTERN PetscErrorCode MatInvertDiagonal_SeqSELL(Mat,PetscScalar,PetscScalar);
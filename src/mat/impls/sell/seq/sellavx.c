@@ -0,0 +1,280 @@
+/*
+    AVX2 and AVX-512 kernels for the SELL matrix products that are selected at runtime, so that one executable
+  built without -mavx2 or -mavx512f can use the widest vector instructions of the machine it runs on.
+
+    A slice of 8 rows fills one AVX-512 register or two AVX2 registers; the last slice is handled with masked
+  loads and stores when the number of rows is not a multiple of 8.
+*/
+#include <../src/mat/impls/sell/seq/sell.h>  /*I   "petscmat.h"  I*/
+
+#if defined(MATSEQSELL_RUNTIME_SIMD)
+#include <immintrin.h>
+
+#define AVX512_FMA_Private(k,vec_y) \
+  vec_idx  = _mm256_loadu_si256((__m256i const*)(acolidx+(k))); \
+  vec_vals = _mm512_loadu_pd(aval+(k)); \
+  vec_x    = _mm512_i32gather_pd(vec_idx,x,8); \
+  vec_y    = _mm512_fmadd_pd(vec_x,vec_vals,vec_y)
+
+#define AVX2_FMA_Private(k,vec_y) \
+  vec_idx  = _mm_loadu_si128((__m128i const*)(acolidx+(k))); \
+  vec_vals = _mm256_loadu_pd(aval+(k)); \
+  vec_x    = _mm256_i32gather_pd(x,vec_idx,8); \
+  vec_y    = _mm256_fmadd_pd(vec_x,vec_vals,vec_y)
+
+/* z = A x + y, or z = A x when y is NULL */
+static __attribute__((target("avx512f"))) PetscErrorCode MatMultAdd_SeqSELL_AVX512_Kernel(PetscInt m,PetscInt totalslices,const PetscInt *sliidx,const PetscInt *colidx,const MatScalar *val,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  __m512d         vec_x,vec_vals,vec_y,vec_y2,vec_y3,vec_y4;
+  __m256i         vec_idx;
+  __mmask8        mask = 0xff;
+  const PetscInt  *acolidx;
+  const MatScalar *aval;
+  PetscInt        i,j,ncols;
+
+  for (i=0; i<totalslices; i++) {
+    if (i == totalslices-1 && (m & 0x07)) mask = (__mmask8)(0xff >> (8-(m & 0x07))); /* last slice has padding rows */
+    acolidx = colidx + sliidx[i];
+    aval    = val + sliidx[i];
+    ncols   = (sliidx[i+1]-sliidx[i])>>3;
+    PetscPrefetchBlock(acolidx,sliidx[i+1]-sliidx[i],0,PETSC_PREFETCH_HINT_T0);
+    PetscPrefetchBlock(aval,sliidx[i+1]-sliidx[i],0,PETSC_PREFETCH_HINT_T0);
+
+    vec_y  = y ? _mm512_maskz_loadu_pd(mask,y+8*i) : _mm512_setzero_pd();
+    vec_y2 = _mm512_setzero_pd();
+    vec_y3 = _mm512_setzero_pd();
+    vec_y4 = _mm512_setzero_pd();
+    for (j=0; j<ncols-3; j+=4) {
+      AVX512_FMA_Private(0,vec_y);
+      AVX512_FMA_Private(8,vec_y2);
+      AVX512_FMA_Private(16,vec_y3);
+      AVX512_FMA_Private(24,vec_y4);
+      acolidx += 32; aval += 32;
+    }
+    for (; j<ncols; j++) {
+      AVX512_FMA_Private(0,vec_y);
+      acolidx += 8; aval += 8;
+    }
+    vec_y = _mm512_add_pd(_mm512_add_pd(vec_y,vec_y2),_mm512_add_pd(vec_y3,vec_y4));
+    _mm512_mask_storeu_pd(z+8*i,mask,vec_y);
+  }
+  return 0;
+}
+
+/* y = A^T x + y; a slice column is updated with one gather and one scatter when its 8 column indices are distinct */
+static __attribute__((target("avx512f,avx512cd"))) PetscErrorCode MatMultTransposeAdd_SeqSELL_AVX512_Kernel(PetscInt m,PetscInt totalslices,const PetscInt *sliidx,const PetscInt *colidx,const MatScalar *val,const PetscScalar *x,PetscScalar *y)
+{
+  __m512d     vec_x,vec_vals,vec_y;
+  __m256i     vec_idx;
+  __m512i     vec_conflict;
+  __mmask8    mask = 0xff;
+  PetscInt    i,j,k;
+  PetscScalar xs[8];
+
+  for (i=0; i<totalslices; i++) {
+    if (i == totalslices-1 && (m & 0x07)) mask = (__mmask8)(0xff >> (8-(m & 0x07))); /* padding rows see x = 0 */
+    vec_x = _mm512_maskz_loadu_pd(mask,x+8*i);
+    _mm512_storeu_pd(xs,vec_x);
+    for (j=sliidx[i]; j<sliidx[i+1]; j+=8) {
+      vec_idx      = _mm256_loadu_si256((__m256i const*)(colidx+j));
+      vec_conflict = _mm512_maskz_conflict_epi32(0xff,_mm512_castsi256_si512(vec_idx));
+      if (!_mm512_mask_test_epi32_mask(0xff,vec_conflict,vec_conflict)) {
+        vec_vals = _mm512_loadu_pd(val+j);
+        vec_y    = _mm512_i32gather_pd(vec_idx,y,8);
+        vec_y    = _mm512_fmadd_pd(vec_x,vec_vals,vec_y);
+        _mm512_i32scatter_pd(y,vec_idx,vec_y,8);
+      } else {
+        for (k=0; k<8; k++) y[colidx[j+k]] += val[j+k]*xs[k];
+      }
+    }
+  }
+  return 0;
+}
+
+/* z = A x + y, or z = A x when y is NULL; each slice is processed as two subslices of height 4 */
+static __attribute__((target("avx2,fma"))) PetscErrorCode MatMultAdd_SeqSELL_AVX2_Kernel(PetscInt m,PetscInt totalslices,const PetscInt *sliidx,const PetscInt *colidx,const MatScalar *val,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  __m256d         vec_x,vec_vals,vec_y,vec_y2,vec_y3,vec_y4;
+  __m128i         vec_idx;
+  __m256i         mask = _mm256_set1_epi64x(-1),mask2 = _mm256_set1_epi64x(-1);
+  PetscBool       partial = PETSC_FALSE;
+  const PetscInt  *acolidx;
+  const MatScalar *aval;
+  PetscInt        i,j,ncols,r;
+
+  for (i=0; i<totalslices; i++) {
+    if (i == totalslices-1 && (m & 0x07)) { /* last slice has padding rows */
+      r       = m & 0x07;
+      mask    = _mm256_set_epi64x(r>3 ? -1 : 0,r>2 ? -1 : 0,r>1 ? -1 : 0,-1);
+      mask2   = _mm256_set_epi64x(0,r>6 ? -1 : 0,r>5 ? -1 : 0,r>4 ? -1 : 0);
+      partial = PETSC_TRUE;
+    }
+    acolidx = colidx + sliidx[i];
+    aval    = val + sliidx[i];
+    ncols   = (sliidx[i+1]-sliidx[i])>>3;
+    PetscPrefetchBlock(acolidx,sliidx[i+1]-sliidx[i],0,PETSC_PREFETCH_HINT_T0);
+    PetscPrefetchBlock(aval,sliidx[i+1]-sliidx[i],0,PETSC_PREFETCH_HINT_T0);
+
+    if (!y) {
+      vec_y  = _mm256_setzero_pd();
+      vec_y2 = _mm256_setzero_pd();
+    } else if (partial) {
+      vec_y  = _mm256_maskload_pd(y+8*i,mask);
+      vec_y2 = _mm256_maskload_pd(y+8*i+4,mask2);
+    } else {
+      vec_y  = _mm256_loadu_pd(y+8*i);
+      vec_y2 = _mm256_loadu_pd(y+8*i+4);
+    }
+    vec_y3 = _mm256_setzero_pd();
+    vec_y4 = _mm256_setzero_pd();
+    for (j=0; j<ncols-1; j+=2) {
+      AVX2_FMA_Private(0,vec_y);
+      AVX2_FMA_Private(4,vec_y2);
+      AVX2_FMA_Private(8,vec_y3);
+      AVX2_FMA_Private(12,vec_y4);
+      acolidx += 16; aval += 16;
+    }
+    if (j < ncols) {
+      AVX2_FMA_Private(0,vec_y);
+      AVX2_FMA_Private(4,vec_y2);
+    }
+    vec_y  = _mm256_add_pd(vec_y,vec_y3);
+    vec_y2 = _mm256_add_pd(vec_y2,vec_y4);
+    if (partial) {
+      _mm256_maskstore_pd(z+8*i,mask,vec_y);
+      _mm256_maskstore_pd(z+8*i+4,mask2,vec_y2);
+    } else {
+      _mm256_storeu_pd(z+8*i,vec_y);
+      _mm256_storeu_pd(z+8*i+4,vec_y2);
+    }
+  }
+  return 0;
+}
+
+PetscErrorCode MatMult_SeqSELL_AVX512(Mat A,Vec xx,Vec yy)
+{
+  Mat_SeqSELL       *a = (Mat_SeqSELL*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  ierr = MatMultAdd_SeqSELL_AVX512_Kernel(A->rmap->n,a->totalslices,a->sliidx,a->colidx,a->val,x,NULL,y);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz-a->nonzerorowcnt);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMultAdd_SeqSELL_AVX512(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqSELL       *a = (Mat_SeqSELL*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y,*z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
+  ierr = MatMultAdd_SeqSELL_AVX512_Kernel(A->rmap->n,a->totalslices,a->sliidx,a->colidx,a->val,x,y,z);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMultTransposeAdd_SeqSELL_AVX512(Mat A,Vec xx,Vec zz,Vec yy)
+{
+  Mat_SeqSELL       *a = (Mat_SeqSELL*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (zz != yy) { ierr = VecCopy(zz,yy);CHKERRQ(ierr); }
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd_SeqSELL_AVX512_Kernel(A->rmap->n,a->totalslices,a->sliidx,a->colidx,a->val,x,y);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->sliidx[a->totalslices]);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMult_SeqSELL_AVX2(Mat A,Vec xx,Vec yy)
+{
+  Mat_SeqSELL       *a = (Mat_SeqSELL*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  ierr = MatMultAdd_SeqSELL_AVX2_Kernel(A->rmap->n,a->totalslices,a->sliidx,a->colidx,a->val,x,NULL,y);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz-a->nonzerorowcnt);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatMultAdd_SeqSELL_AVX2(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqSELL       *a = (Mat_SeqSELL*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y,*z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
+  ierr = MatMultAdd_SeqSELL_AVX2_Kernel(A->rmap->n,a->totalslices,a->sliidx,a->colidx,a->val,x,y,z);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayPair(yy,zz,&y,&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+#endif
+
+static const char *const MatSeqSELLSIMDTypes[] = {"auto","generic","avx2","avx512"};
+
+/*
+   Selects the kernels used by MatMult_SeqSELL(), MatMultAdd_SeqSELL() and MatMultTransposeAdd_SeqSELL(); the
+   default picks the widest instructions supported by the processor, generic uses the kernels chosen at compile time
+*/
+PetscErrorCode MatSeqSELLSetSIMDFromOptions_Private(Mat A)
+{
+  Mat_SeqSELL    *a = (Mat_SeqSELL*)A->data;
+  PetscInt       choice = 0;
+  PetscBool      avx2,avx512;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscAVXIsEnabled(&avx2,&avx512);CHKERRQ(ierr);
+  ierr = PetscOptionsBegin(PetscObjectComm((PetscObject)A),((PetscObject)A)->prefix,"Options for SEQSELL matrix","Mat");CHKERRQ(ierr);
+  ierr = PetscOptionsEList("-mat_sell_simd","Vector instructions used by the products","None",MatSeqSELLSIMDTypes,4,MatSeqSELLSIMDTypes[choice],&choice,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsEnd();CHKERRQ(ierr);
+#if !defined(MATSEQSELL_RUNTIME_SIMD)
+  avx2 = avx512 = PETSC_FALSE;
+#endif
+  switch (choice) {
+  case 0:
+    a->simd = avx512 ? MAT_SELL_SIMD_AVX512 : (avx2 ? MAT_SELL_SIMD_AVX2 : MAT_SELL_SIMD_GENERIC);
+    break;
+  case 1:
+    a->simd = MAT_SELL_SIMD_GENERIC;
+    break;
+  case 2:
+    if (!avx2) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"AVX2 kernels are not available on this processor or with this compiler");
+    a->simd = MAT_SELL_SIMD_AVX2;
+    break;
+  case 3:
+    if (!avx512) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"AVX-512 kernels are not available on this processor or with this compiler");
+    a->simd = MAT_SELL_SIMD_AVX512;
+    break;
+  }
+  ierr = PetscInfo1(A,"Using %s kernels for the matrix products\n",MatSeqSELLSIMDTypes[a->simd+1]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
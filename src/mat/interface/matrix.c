@@ -13,7 +13,7 @@ PetscClassId MAT_COLORING_CLASSID;
 PetscClassId MAT_FDCOLORING_CLASSID;
 PetscClassId MAT_TRANSPOSECOLORING_CLASSID;
 
-PetscLogEvent MAT_Mult, MAT_Mults, MAT_MultConstrained, MAT_MultAdd, MAT_MultTranspose;
+PetscLogEvent MAT_Mult, MAT_Mults, MAT_MultConstrained, MAT_MultAdd, MAT_MultCommWait, MAT_MultTranspose;
 PetscLogEvent MAT_MultTransposeConstrained, MAT_MultTransposeAdd, MAT_Solve, MAT_Solves, MAT_SolveAdd, MAT_SolveTranspose, MAT_MatSolve,MAT_MatTrSolve;
 PetscLogEvent MAT_SolveTransposeAdd, MAT_SOR, MAT_ForwardSolve, MAT_BackwardSolve, MAT_LUFactor, MAT_LUFactorSymbolic;
 PetscLogEvent MAT_LUFactorNumeric, MAT_CholeskyFactor, MAT_CholeskyFactorSymbolic, MAT_CholeskyFactorNumeric, MAT_ILUFactor;
@@ -32,9 +32,9 @@ PetscLogEvent MAT_Getsymtranspose, MAT_Getsymtransreduced, MAT_Transpose_SeqAIJ,
 PetscLogEvent MAT_GetBrowsOfAocols, MAT_Getlocalmat, MAT_Getlocalmatcondensed, MAT_Seqstompi, MAT_Seqstompinum, MAT_Seqstompisym;
 PetscLogEvent MAT_Applypapt, MAT_Applypapt_numeric, MAT_Applypapt_symbolic, MAT_GetSequentialNonzeroStructure;
 PetscLogEvent MAT_GetMultiProcBlock;
-PetscLogEvent MAT_CUSPARSECopyToGPU, MAT_SetValuesBatch;
+PetscLogEvent MAT_CUSPARSECopyToGPU, MAT_SetValuesBatch, MAT_PreallCOO, MAT_SetVCOO;
 PetscLogEvent MAT_ViennaCLCopyToGPU;
-PetscLogEvent MAT_Merge,MAT_Residual,MAT_SetRandom;
+PetscLogEvent MAT_Merge,MAT_Residual,MAT_MultBasis,MAT_SetRandom;
 PetscLogEvent MATCOLORING_Apply,MATCOLORING_Comm,MATCOLORING_Local,MATCOLORING_ISCreate,MATCOLORING_SetUp,MATCOLORING_Weights;
 
 const char *const MatFactorTypes[] = {"NONE","LU","CHOLESKY","ILU","ICC","ILUDT","MatFactorType","MAT_FACTOR_",0};
@@ -2683,6 +2683,104 @@ PetscErrorCode MatMultHermitianTransposeAdd(Mat mat,Vec v1,Vec v2,Vec v3)
   PetscFunctionReturn(0);
 }
 
+/*
+   The default MatMultBasis(): one MatMult() for each vector of the basis
+*/
+PetscErrorCode MatMultBasis_Basic(Mat mat,Vec x,PetscInt s,const PetscScalar a[],const PetscScalar b[],const PetscScalar c[],Vec W[])
+{
+  PetscInt       j;
+  PetscScalar    alpha,beta,gamma;
+  Vec            prev,prev2 = NULL;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  prev = x;
+  for (j=0; j<s; j++) {
+    alpha = a ? a[j] : 0.0;
+    beta  = b ? b[j] : 0.0;
+    gamma = c ? 1.0/c[j] : 1.0;
+    ierr  = MatMult(mat,prev,W[j]);CHKERRQ(ierr);
+    if (prev2) {
+      ierr = VecAXPBYPCZ(W[j],-alpha*gamma,-beta*gamma,gamma,prev,prev2);CHKERRQ(ierr);
+    } else {
+      ierr = VecAXPBY(W[j],-alpha*gamma,gamma,prev);CHKERRQ(ierr);
+    }
+    prev2 = prev;
+    prev  = W[j];
+  }
+  PetscFunctionReturn(0);
+}
+
+/*@
+   MatMultBasis - Computes the s vectors of a polynomial basis of the Krylov space of a matrix from a three term recurrence
+
+   Neighbor-wise Collective on Mat and Vec
+
+   Input Parameters:
++  mat - the matrix
+.  x - the starting vector
+.  s - the number of vectors to compute
+.  a - the shifts of the recurrence, or NULL for zero shifts
+.  b - the coefficients of the second previous vector, or NULL for zero coefficients
+-  c - the scaling factors, or NULL for no scaling
+
+   Output Parameter:
+.  W - the s vectors, W[j] = ((A - a[j] I) W[j-1] - b[j] W[j-2]) / c[j], where W[-1] = x and W[-2] = 0 (so b[0] is not used)
+
+   Notes:
+   With a = b = 0 and c = 1 this is the monomial basis A x, A^2 x, ..., A^s x; with Ritz values as shifts it is the
+   Newton basis (a pair of complex conjugate shifts re +/- i im is given in real arithmetic by the shift re twice, with
+   b = -im^2 for the second one) and with the suitable coefficients it is a Chebyshev basis.
+
+   The s-step Krylov methods KSPSGMRES and KSPSCG use this routine when the operator is the matrix itself. The default
+   implementation calls MatMult() s times; MATMPIAIJ matrices can instead gather the rows at distance less than s from
+   the local rows once, and then need a single communication of the ghost values of x for the whole basis, see
+   MATMPIAIJ.
+
+   Level: developer
+
+   Concepts: matrix vector product^Krylov basis
+
+.seealso: MatMult(), KSPSGMRES, KSPSCG
+@*/
+PetscErrorCode MatMultBasis(Mat mat,Vec x,PetscInt s,const PetscScalar a[],const PetscScalar b[],const PetscScalar c[],Vec W[])
+{
+  PetscErrorCode (*f)(Mat,Vec,PetscInt,const PetscScalar[],const PetscScalar[],const PetscScalar[],Vec[]);
+  PetscInt       j;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(mat,MAT_CLASSID,1);
+  PetscValidType(mat,1);
+  PetscValidHeaderSpecific(x,VEC_CLASSID,2);
+  if (s < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Number of vectors %D cannot be negative",s);
+  if (!s) PetscFunctionReturn(0);
+  PetscValidPointer(W,7);
+  if (!mat->assembled) SETERRQ(PetscObjectComm((PetscObject)mat),PETSC_ERR_ARG_WRONGSTATE,"Not for unassembled matrix");
+  if (mat->factortype) SETERRQ(PetscObjectComm((PetscObject)mat),PETSC_ERR_ARG_WRONGSTATE,"Not for factored matrix");
+  if (mat->rmap->N != mat->cmap->N || mat->rmap->n != mat->cmap->n) SETERRQ(PetscObjectComm((PetscObject)mat),PETSC_ERR_ARG_SIZ,"Only for square matrices with the same row and column layouts");
+  if (mat->cmap->n != x->map->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Mat mat,Vec x: local dim %D %D",mat->cmap->n,x->map->n);
+  for (j=0; j<s; j++) {
+    PetscValidHeaderSpecific(W[j],VEC_CLASSID,7);
+    if (W[j] == x) SETERRQ(PetscObjectComm((PetscObject)mat),PETSC_ERR_ARG_IDN,"x and the basis vectors must be different vectors");
+    if (mat->rmap->n != W[j]->map->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Mat mat,Vec W: local dim %D %D",mat->rmap->n,W[j]->map->n);
+  }
+  MatCheckPreallocated(mat,1);
+
+  ierr = PetscObjectQueryFunction((PetscObject)mat,"MatMultBasis_C",&f);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_MultBasis,mat,x,0,0);CHKERRQ(ierr);
+  ierr = VecLockPush(x);CHKERRQ(ierr);
+  if (f) {
+    ierr = (*f)(mat,x,s,a,b,c,W);CHKERRQ(ierr);
+  } else {
+    ierr = MatMultBasis_Basic(mat,x,s,a,b,c,W);CHKERRQ(ierr);
+  }
+  ierr = VecLockPop(x);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(MAT_MultBasis,mat,x,0,0);CHKERRQ(ierr);
+  for (j=0; j<s; j++) {ierr = PetscObjectStateIncrease((PetscObject)W[j]);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
 /*@
    MatMultConstrained - The inner multiplication routine for a
    constrained matrix P^T A P.
@@ -5298,11 +5396,15 @@ static PetscInt MatAssemblyEnd_InUse = 0;
    out by assembly. If you intend to use that extra space on a subsequent assembly, be sure to insert explicit zeros
    before MAT_FINAL_ASSEMBLY so the space is not compressed out.
 
+   Values set for rows owned by other processes are sorted and combined by destination, then sent with the nonblocking
+   consensus of PetscCommBuildTwoSidedFReq(), so no process handles data of the size of the communicator. Use -info to
+   see the messages and bytes of each assembly, and -matstash_legacy for the older exchange.
+
    Level: beginner
 
    Concepts: matrices^assembling
 
-.seealso: MatAssemblyEnd(), MatSetValues(), MatAssembled()
+.seealso: MatAssemblyEnd(), MatSetValues(), MatAssembled(), MatSetOption(), MAT_SUBSET_OFF_PROC_ENTRIES
 @*/
 PetscErrorCode MatAssemblyBegin(Mat mat,MatAssemblyType type)
 {
@@ -318,6 +318,185 @@ PetscErrorCode MatXAIJSetPreallocation(Mat A,PetscInt bs,const PetscInt dnnz[],c
   PetscFunctionReturn(0);
 }
 
+typedef struct {
+  PetscInt n,*i,*j;               /* copy of the pattern given to MatSetPreallocationCOO() */
+} MatCOOStruct_Basic;
+
+static PetscErrorCode MatCOOStructDestroy_Basic(void *ptr)
+{
+  MatCOOStruct_Basic *coo = (MatCOOStruct_Basic*)ptr;
+  PetscErrorCode     ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree2(coo->i,coo->j);CHKERRQ(ierr);
+  ierr = PetscFree(coo);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Used by the matrix types that do not provide their own plan: the pattern is kept and MatSetValuesCOO_Basic()
+   replays it through MatSetValues(), so the values still go through the stash.
+*/
+PetscErrorCode MatSetPreallocationCOO_Basic(Mat A,PetscInt n,const PetscInt coo_i[],const PetscInt coo_j[])
+{
+  MatCOOStruct_Basic *coo;
+  PetscContainer     container;
+  Mat                P;
+  PetscInt           k,bs;
+  PetscScalar        zero = 0.0;
+  PetscErrorCode     ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscNew(&coo);CHKERRQ(ierr);
+  ierr = PetscMalloc2(n,&coo->i,n,&coo->j);CHKERRQ(ierr);
+  ierr = PetscMemcpy(coo->i,coo_i,n*sizeof(PetscInt));CHKERRQ(ierr);
+  ierr = PetscMemcpy(coo->j,coo_j,n*sizeof(PetscInt));CHKERRQ(ierr);
+  coo->n = n;
+  ierr = PetscContainerCreate(PetscObjectComm((PetscObject)A),&container);CHKERRQ(ierr);
+  ierr = PetscContainerSetPointer(container,coo);CHKERRQ(ierr);
+  ierr = PetscContainerSetUserDestroy(container,MatCOOStructDestroy_Basic);CHKERRQ(ierr);
+  ierr = PetscObjectCompose((PetscObject)A,"__PETSc_MatCOOStruct_Basic",(PetscObject)container);CHKERRQ(ierr);
+  ierr = PetscContainerDestroy(&container);CHKERRQ(ierr);
+
+  /* MATPREALLOCATOR only counts scalar nonzeros, so blocked formats keep the default preallocation of MatSetUp() */
+  ierr = MatGetBlockSize(A,&bs);CHKERRQ(ierr);
+  if (bs == 1) {
+    ierr = MatCreate(PetscObjectComm((PetscObject)A),&P);CHKERRQ(ierr);
+    ierr = MatSetType(P,MATPREALLOCATOR);CHKERRQ(ierr);
+    ierr = MatSetSizes(P,A->rmap->n,A->cmap->n,A->rmap->N,A->cmap->N);CHKERRQ(ierr);
+    ierr = MatSetUp(P);CHKERRQ(ierr);
+    for (k=0; k<n; k++) {
+      ierr = MatSetValues(P,1,coo_i+k,1,coo_j+k,&zero,ADD_VALUES);CHKERRQ(ierr);
+    }
+    ierr = MatAssemblyBegin(P,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatAssemblyEnd(P,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatPreallocatorPreallocate(P,PETSC_TRUE,A);CHKERRQ(ierr);
+    ierr = MatDestroy(&P);CHKERRQ(ierr);
+  }
+  ierr = MatSetUp(A);CHKERRQ(ierr);
+  ierr = MatSetOption(A,MAT_NEW_NONZERO_LOCATIONS,PETSC_TRUE);CHKERRQ(ierr);
+  /* put the pattern in place so that MatZeroEntries() and MatSetValuesCOO() do not change the nonzero state */
+  for (k=0; k<n; k++) {
+    ierr = MatSetValues(A,1,coo_i+k,1,coo_j+k,&zero,ADD_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode MatSetValuesCOO_Basic(Mat A,const PetscScalar v[],InsertMode imode)
+{
+  MatCOOStruct_Basic *coo;
+  PetscContainer     container;
+  PetscInt           k;
+  PetscErrorCode     ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectQuery((PetscObject)A,"__PETSc_MatCOOStruct_Basic",(PetscObject*)&container);CHKERRQ(ierr);
+  if (!container) SETERRQ(PetscObjectComm((PetscObject)A),PETSC_ERR_ARG_WRONGSTATE,"Must call MatSetPreallocationCOO() first");
+  ierr = PetscContainerGetPointer(container,(void**)&coo);CHKERRQ(ierr);
+  if (imode == INSERT_VALUES) {
+    ierr = MatZeroEntries(A);CHKERRQ(ierr);
+  }
+  for (k=0; k<coo->n; k++) {
+    ierr = MatSetValues(A,1,coo->i+k,1,coo->j+k,v+k,ADD_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@C
+   MatSetPreallocationCOO - set the nonzero pattern of a matrix from a list of coordinates, once, so that the values
+   can later be given as a flat array with MatSetValuesCOO()
+
+   Collective on Mat
+
+   Input Arguments:
++  A - matrix being preallocated
+.  n - number of coordinates given on this process
+.  coo_i - row indices (global)
+-  coo_j - column indices (global)
+
+   Notes:
+   The coordinates may be in any order, may be repeated and may refer to rows owned by other processes. Repeated
+   entries are summed by MatSetValuesCOO(). Entries with a negative row or column index are ignored.
+
+   For MATSEQAIJ and MATMPIAIJ the pattern is sorted once and a plan is built that maps each position of the value array
+   to its place in the matrix; entries of rows owned by other processes are sent through a PetscSF built here, so
+   MatSetValuesCOO() does no searching, uses no stash and needs no message negotiation. Other formats keep a copy of the
+   pattern and insert it with MatSetValues().
+
+   The matrix is assembled on return, holds zeros at the given locations, and new nonzero locations are an error
+   afterwards.
+
+   Level: beginner
+
+.seealso: MatSetValuesCOO(), MatSeqAIJSetPreallocationCSR(), MatMPIAIJSetPreallocationCSR(), MATPREALLOCATOR
+@*/
+PetscErrorCode MatSetPreallocationCOO(Mat A,PetscInt n,const PetscInt coo_i[],const PetscInt coo_j[])
+{
+  PetscErrorCode (*f)(Mat,PetscInt,const PetscInt[],const PetscInt[]);
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(A,MAT_CLASSID,1);
+  PetscValidType(A,1);
+  if (n < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Number of coordinates %D cannot be negative",n);
+  if (n) PetscValidIntPointer(coo_i,3);
+  if (n) PetscValidIntPointer(coo_j,4);
+  ierr = PetscLayoutSetUp(A->rmap);CHKERRQ(ierr);
+  ierr = PetscLayoutSetUp(A->cmap);CHKERRQ(ierr);
+  ierr = PetscObjectQueryFunction((PetscObject)A,"MatSetPreallocationCOO_C",&f);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_PreallCOO,A,0,0,0);CHKERRQ(ierr);
+  if (f) {
+    ierr = (*f)(A,n,coo_i,coo_j);CHKERRQ(ierr);
+  } else {
+    ierr = MatSetPreallocationCOO_Basic(A,n,coo_i,coo_j);CHKERRQ(ierr);
+  }
+  ierr = PetscLogEventEnd(MAT_PreallCOO,A,0,0,0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@C
+   MatSetValuesCOO - set the values of a matrix whose pattern was given with MatSetPreallocationCOO()
+
+   Collective on Mat
+
+   Input Arguments:
++  A - matrix being filled
+.  v - values, in the order of the coordinates given to MatSetPreallocationCOO() on this process
+-  imode - INSERT_VALUES to replace the matrix values, ADD_VALUES to add to them
+
+   Notes:
+   Values of repeated coordinates are summed in either mode. The matrix is assembled on return; there is no need to call
+   MatAssemblyBegin() and MatAssemblyEnd().
+
+   Level: beginner
+
+.seealso: MatSetPreallocationCOO(), MatSetValues()
+@*/
+PetscErrorCode MatSetValuesCOO(Mat A,const PetscScalar v[],InsertMode imode)
+{
+  PetscErrorCode (*f)(Mat,const PetscScalar[],InsertMode);
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(A,MAT_CLASSID,1);
+  PetscValidType(A,1);
+  if (imode != INSERT_VALUES && imode != ADD_VALUES) SETERRQ(PetscObjectComm((PetscObject)A),PETSC_ERR_SUP,"Only INSERT_VALUES and ADD_VALUES are supported");
+  ierr = PetscObjectQueryFunction((PetscObject)A,"MatSetValuesCOO_C",&f);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(MAT_SetVCOO,A,0,0,0);CHKERRQ(ierr);
+  if (f) {
+    ierr = (*f)(A,v,imode);CHKERRQ(ierr);
+  } else {
+    ierr = MatSetValuesCOO_Basic(A,v,imode);CHKERRQ(ierr);
+  }
+  ierr = PetscLogEventEnd(MAT_SetVCOO,A,0,0,0);CHKERRQ(ierr);
+  ierr = PetscObjectStateIncrease((PetscObject)A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /*
         Merges some information from Cs header to A; the C object is then destroyed
 
@@ -908,6 +908,13 @@ static PetscErrorCode MatStashScatterBegin_BTS(Mat mat,MatStash *stash,PetscInt
     if (sendno != stash->nsendranks) SETERRQ2(stash->comm,PETSC_ERR_PLIB,"BTS counted %D sendranks, but %D sends",stash->nsendranks,sendno);
   }
 
+  stash->sendbytes = 0;
+  stash->recvbytes = 0;
+  {
+    PetscMPIInt i;
+    for (i=0; i<stash->nsendranks; i++) stash->sendbytes += (PetscLogDouble)stash->sendhdr[i].count*stash->blocktype_size;
+  }
+
   /* Encode insertmode on the outgoing messages. If we want to support more than two options, we would need a new
    * message or a dummy entry of some sort. */
   if (mat->insertmode == INSERT_VALUES) {
@@ -965,6 +972,7 @@ static PetscErrorCode MatStashScatterGetMesg_BTS(MatStash *stash,PetscMPIInt *n,
     if (stash->use_status) { /* Count what was actually sent */
       ierr = MPI_Get_count(&stash->some_statuses[stash->some_i],stash->blocktype,&stash->recvframe_count);CHKERRQ(ierr);
     }
+    stash->recvbytes += (PetscLogDouble)stash->recvframe_count*stash->blocktype_size;
     if (stash->recvframe_count > 0) { /* Check for InsertMode consistency */
       block = (MatStashBlock*)&((char*)stash->recvframe_active->buffer)[0];
       if (PetscUnlikely(*stash->insertmode == NOT_SET_VALUES)) *stash->insertmode = block->row < 0 ? INSERT_VALUES : ADD_VALUES;
@@ -992,6 +1000,7 @@ static PetscErrorCode MatStashScatterEnd_BTS(MatStash *stash)
 
   PetscFunctionBegin;
   ierr = MPI_Waitall(stash->nsendranks,stash->sendreqs,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+  ierr = PetscInfo4(NULL,"Stash sent %d messages of %g bytes and received %d messages of %g bytes\n",stash->nsendranks,stash->sendbytes,stash->nrecvranks,stash->recvbytes);CHKERRQ(ierr);
   if (stash->subset_off_proc) { /* Reuse the communication contexts, so consolidate and reset segrecvblocks  */
     void *dummy;
     ierr = PetscSegBufferExtractInPlace(stash->segrecvblocks,&dummy);CHKERRQ(ierr);
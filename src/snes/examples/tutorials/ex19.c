@@ -751,6 +751,13 @@ PetscErrorCode NonlinearGS(SNES snes, Vec X, Vec B, void *ctx)
       args: -snes_monitor_short -ksp_monitor_short -pc_type fieldsplit -pc_fieldsplit_type multiplicative -snes_view -da_refine 1 -ksp_type fgmres
       requires: !single
 
+   test:
+      suffix: aij_threads
+      nsize: 2
+      args: -da_refine 3 -snes_monitor_short -pc_type mg -ksp_type fgmres -pc_mg_type full -mat_aij_threads 3
+      output_file: output/ex19_1.out
+      requires: openmp !single
+
    test:
       suffix: aspin
       nsize: 4
@@ -157,3 +157,81 @@ PetscErrorCode  PetscSSEIsEnabled(MPI_Comm comm,PetscBool  *lflag,PetscBool  *gf
 }
 
 
+
+/*
+   __builtin_cpu_supports() rejects at compile time the feature names the compiler does not know: "avx2" is known
+   since GCC 4.8, "fma" and "avx512f" since GCC 5 and "avx512cd" since GCC 6; clang knows all of them since 3.9 (Apple clang 8).
+   With older compilers the corresponding extensions are reported as not available.
+*/
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__INTEL_COMPILER) && (defined(__x86_64__) || defined(__i386__))
+#  if defined(__apple_build_version__)
+#    if __clang_major__ >= 8
+#      define PETSC_CPU_SUPPORTS_AVX2_QUERY
+#      define PETSC_CPU_SUPPORTS_AVX512_QUERY
+#    endif
+#  elif defined(__clang__)
+#    if __clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 9)
+#      define PETSC_CPU_SUPPORTS_AVX2_QUERY
+#      define PETSC_CPU_SUPPORTS_AVX512_QUERY
+#    endif
+#  else
+#    if __GNUC__ >= 5
+#      define PETSC_CPU_SUPPORTS_AVX2_QUERY
+#    endif
+#    if __GNUC__ >= 6
+#      define PETSC_CPU_SUPPORTS_AVX512_QUERY
+#    endif
+#  endif
+#endif
+
+/*@C
+     PetscAVXIsEnabled - Determines if the AVX2 (with FMA) and AVX-512 (F and CD) extensions to the x86 instruction
+     set can be used by this process. The test is done at runtime, so that a single executable can select the
+     best kernels for the machine it runs on.
+
+     Not Collective
+
+     Output Parameters:
++    avx2   - PETSC_TRUE if AVX2 and FMA instructions can be used
+-    avx512 - PETSC_TRUE if AVX-512F and AVX-512CD instructions can be used
+
+     Notes:
+     NULL can be specified for avx2 or avx512 if either of these values are not desired.
+
+     Both flags are PETSC_FALSE if the compiler provides no way to query the processor features, and avx512 is
+     PETSC_FALSE if the compiler cannot query the AVX-512 features (GCC before 6, clang before 3.9).
+
+     Options Database Keys:
+.    -disable_avx - Disable use of the AVX2 and AVX-512 implementations selected at runtime
+
+     Level: developer
+
+.seealso: PetscSSEIsEnabled()
+@*/
+static PetscBool petsc_avx_is_untested = PETSC_TRUE;
+static PetscBool petsc_avx2_enabled    = PETSC_FALSE;
+static PetscBool petsc_avx512_enabled  = PETSC_FALSE;
+PetscErrorCode PetscAVXIsEnabled(PetscBool *avx2,PetscBool *avx512)
+{
+  PetscErrorCode ierr;
+  PetscBool      disabled_option = PETSC_FALSE;
+
+  PetscFunctionBegin;
+  if (petsc_avx_is_untested) {
+    ierr = PetscOptionsGetBool(NULL,NULL,"-disable_avx",&disabled_option,NULL);CHKERRQ(ierr);
+#if defined(PETSC_CPU_SUPPORTS_AVX2_QUERY)
+    if (!disabled_option) {
+      /* these also check that the operating system saves the extended register state */
+      __builtin_cpu_init();
+      petsc_avx2_enabled   = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? PETSC_TRUE : PETSC_FALSE;
+#if defined(PETSC_CPU_SUPPORTS_AVX512_QUERY)
+      petsc_avx512_enabled = (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd")) ? PETSC_TRUE : PETSC_FALSE;
+#endif
+    }
+#endif
+    petsc_avx_is_untested = PETSC_FALSE;
+  }
+  if (avx2)   *avx2   = petsc_avx2_enabled;
+  if (avx512) *avx512 = petsc_avx512_enabled;
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,179 @@
+static const char help[] = "Tests PetscSF communication with contiguous, strided, subblock and unstructured roots and leaves.\n\
+  -n <n> : edge of the cube of roots on each process\n\
+  -change <bool> : change the source array between the Begin and End calls\n\n";
+
+/*
+   Every process owns a cube of n^3 roots. Its leaves reference
+     - all roots of the next process, in order, stored contiguously,
+     - a 3D subblock of the roots of the process after, stored as a strided run in the leaf array,
+     - a 2D slab of its own roots, stored in reverse order.
+   so that the roots and leaves of each rank are contiguous, strided, subblocks or unstructured depending on the number
+   of processes. The results of PetscSFBcast(), PetscSFBcastAndOp() and PetscSFReduce() are checked against the graph.
+*/
+#include <petscsf.h>
+
+int main(int argc,char **argv)
+{
+  PetscSF        sf;
+  PetscSFNode    *remote;
+  PetscInt       n = 4,nroots,nleaves,nleafspace,*ilocal,i,j,k,l,c,nb,ns,*rootdata,*leafdata,*rootblock,*leafblock,errors = 0,bs = 3;
+  const PetscInt *degree;
+  PetscBool      change = PETSC_TRUE;
+  PetscMPIInt    rank,size;
+  MPI_Datatype   unit;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(NULL,NULL,"-change",&change,NULL);CHKERRQ(ierr);
+  if (n < 3) SETERRQ(PETSC_COMM_WORLD,PETSC_ERR_ARG_OUTOFRANGE,"Needs n >= 3");
+
+  nroots     = n*n*n;
+  nb         = (n-1)*(n-1)*(n-2);     /* subblock 1 <= x < n, 0 <= y < n-1, 1 <= z < n-1 */
+  ns         = n*n;                   /* slab z = 1 */
+  nleaves    = nroots + nb + ns;
+  nleafspace = nroots + 2*nb + ns;    /* the subblock leaves use every other row */
+  ierr = PetscMalloc2(nleaves,&ilocal,nleaves,&remote);CHKERRQ(ierr);
+  for (i=0,l=0; i<nroots; i++,l++) {
+    ilocal[l]       = i;
+    remote[l].rank  = (rank+1)%size;
+    remote[l].index = i;
+  }
+  for (k=1,c=0; k<n-1; k++) {
+    for (j=0; j<n-1; j++,c++) {
+      for (i=1; i<n; i++,l++) {
+        ilocal[l]       = nroots + 2*c*(n-1) + i-1;
+        remote[l].rank  = (rank+2)%size;
+        remote[l].index = (k*n+j)*n+i;
+      }
+    }
+  }
+  for (i=0; i<ns; i++,l++) {
+    ilocal[l]       = nleafspace-1-i;
+    remote[l].rank  = rank;
+    remote[l].index = n*n+i;
+  }
+
+  ierr = PetscSFCreate(PETSC_COMM_WORLD,&sf);CHKERRQ(ierr);
+  ierr = PetscSFSetFromOptions(sf);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(sf,nroots,nleaves,ilocal,PETSC_COPY_VALUES,remote,PETSC_COPY_VALUES);CHKERRQ(ierr);
+  ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
+
+  /* Broadcast the global number of each root, with one and with bs integers per root */
+  ierr = PetscMalloc4(nroots,&rootdata,nleafspace,&leafdata,bs*nroots,&rootblock,bs*nleafspace,&leafblock);CHKERRQ(ierr);
+  for (i=0; i<nroots; i++) {
+    rootdata[i] = rank*nroots + i;
+    for (c=0; c<bs; c++) rootblock[i*bs+c] = bs*(rank*nroots + i) + c;
+  }
+  for (i=0; i<nleafspace; i++) leafdata[i] = -1;
+  for (i=0; i<bs*nleafspace; i++) leafblock[i] = -1;
+  ierr = MPI_Type_contiguous(bs,MPIU_INT,&unit);CHKERRQ(ierr);
+  ierr = MPI_Type_commit(&unit);CHKERRQ(ierr);
+  ierr = PetscSFBcastBegin(sf,MPIU_INT,rootdata,leafdata);CHKERRQ(ierr);
+  ierr = PetscSFBcastBegin(sf,unit,rootblock,leafblock);CHKERRQ(ierr);
+  ierr = PetscSFBcastEnd(sf,MPIU_INT,rootdata,leafdata);CHKERRQ(ierr);
+  ierr = PetscSFBcastEnd(sf,unit,rootblock,leafblock);CHKERRQ(ierr);
+  for (l=0; l<nleaves; l++) {
+    PetscInt expect = remote[l].rank*nroots + remote[l].index;
+    if (leafdata[ilocal[l]] != expect) errors++;
+    for (c=0; c<bs; c++) if (leafblock[ilocal[l]*bs+c] != bs*expect+c) errors++;
+  }
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Bcast: %D wrong leaves\n",errors);CHKERRQ(ierr);
+
+  /* Adding the roots to the leaves doubles them */
+  ierr = PetscSFBcastAndOpBegin(sf,MPIU_INT,rootdata,leafdata,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFBcastAndOpBegin(sf,unit,rootblock,leafblock,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFBcastAndOpEnd(sf,MPIU_INT,rootdata,leafdata,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFBcastAndOpEnd(sf,unit,rootblock,leafblock,MPIU_SUM);CHKERRQ(ierr);
+  for (l=0,errors=0; l<nleaves; l++) {
+    PetscInt expect = remote[l].rank*nroots + remote[l].index;
+    if (leafdata[ilocal[l]] != 2*expect) errors++;
+    for (c=0; c<bs; c++) if (leafblock[ilocal[l]*bs+c] != 2*(bs*expect+c)) errors++;
+  }
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"BcastAndOp: %D wrong leaves\n",errors);CHKERRQ(ierr);
+
+  /* Sending the doubled leaves back with MPIU_REPLACE doubles the roots, the sum of ones counts the leaves of each root */
+  for (i=0; i<nroots; i++) rootdata[i] = -1;
+  ierr = PetscSFReduceBegin(sf,MPIU_INT,leafdata,rootdata,MPIU_REPLACE);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(sf,MPIU_INT,leafdata,rootdata,MPIU_REPLACE);CHKERRQ(ierr);
+  ierr = PetscSFComputeDegreeBegin(sf,&degree);CHKERRQ(ierr);
+  ierr = PetscSFComputeDegreeEnd(sf,&degree);CHKERRQ(ierr);
+  for (i=0,errors=0; i<nroots; i++) if (rootdata[i] != (degree[i] ? 2*(rank*nroots + i) : -1)) errors++;
+  for (i=0; i<nroots*bs; i++) rootblock[i] = 0;
+  for (i=0; i<nleafspace*bs; i++) leafblock[i] = 1;
+  ierr = PetscSFReduceBegin(sf,unit,leafblock,rootblock,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(sf,unit,leafblock,rootblock,MPIU_SUM);CHKERRQ(ierr);
+  for (i=0; i<nroots; i++) for (c=0; c<bs; c++) if (rootblock[i*bs+c] != degree[i]) errors++;
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Reduce: %D wrong roots\n",errors);CHKERRQ(ierr);
+
+  /* Unless -sf_basic_in_place is given, the Begin calls are done with the source array, which may be changed before the End calls */
+  if (change) {
+    for (i=0; i<nroots; i++) rootdata[i] = rank*nroots + i;
+    for (i=0; i<nleafspace; i++) leafdata[i] = -1;
+    ierr = PetscSFBcastBegin(sf,MPIU_INT,rootdata,leafdata);CHKERRQ(ierr);
+    for (i=0; i<nroots; i++) rootdata[i] = -2;
+    ierr = PetscSFBcastEnd(sf,MPIU_INT,rootdata,leafdata);CHKERRQ(ierr);
+    for (l=0,errors=0; l<nleaves; l++) if (leafdata[ilocal[l]] != remote[l].rank*nroots + remote[l].index) errors++;
+    for (i=0; i<nroots; i++) rootdata[i] = 0;
+    for (l=0; l<nleaves; l++) leafdata[ilocal[l]] = 1;
+    ierr = PetscSFReduceBegin(sf,MPIU_INT,leafdata,rootdata,MPIU_SUM);CHKERRQ(ierr);
+    for (i=0; i<nleafspace; i++) leafdata[i] = -2;
+    ierr = PetscSFReduceEnd(sf,MPIU_INT,leafdata,rootdata,MPIU_SUM);CHKERRQ(ierr);
+    for (i=0; i<nroots; i++) if (rootdata[i] != degree[i]) errors++;
+    ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"Source changed before the End calls: %D wrong leaves and roots\n",errors);CHKERRQ(ierr);
+  }
+
+  ierr = MPI_Type_free(&unit);CHKERRQ(ierr);
+  ierr = PetscFree4(rootdata,leafdata,rootblock,leafblock);CHKERRQ(ierr);
+  ierr = PetscFree2(ilocal,remote);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&sf);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      nsize: {{1 2 3 4}}
+      output_file: output/ex2_1.out
+
+   test:
+      suffix: in_place
+      nsize: {{2 3 4}}
+      args: -sf_basic_in_place -change 0
+      output_file: output/ex2_in_place.out
+
+   test:
+      suffix: nopackopt
+      nsize: 3
+      args: -sf_basic_pack_opt 0
+      output_file: output/ex2_1.out
+
+   test:
+      suffix: neighbor
+      nsize: {{2 4}}
+      args: -sf_type neighbor -n 5
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      output_file: output/ex2_1.out
+
+   test:
+      suffix: shared
+      nsize: {{1 3 4}}
+      args: -sf_type shared
+      requires: define(PETSC_HAVE_MPI_PROCESS_SHARED_MEMORY)
+      output_file: output/ex2_1.out
+
+   test:
+      suffix: shared_split
+      nsize: {{4 5}}
+      args: -sf_type shared -sf_shared_node_size 2
+      requires: define(PETSC_HAVE_MPI_PROCESS_SHARED_MEMORY)
+      output_file: output/ex2_1.out
+
+TEST*/
@@ -0,0 +1,166 @@
+static const char help[] = "Tests PetscSFSetUpBegin()/PetscSFSetUpEnd() and the setup of star forests derived from others.\n\
+  -n <n> : base number of roots on each process\n\n";
+
+/*
+   Star forests created by PetscSFCreateEmbeddedSF(), PetscSFCreateInverseSF() and PetscSFCompose() from star forests
+   that are set up do not discover the ranks referencing their roots. Each of them is compared with a duplicate of its
+   graph, whose setup discovers these ranks, by broadcasting and reducing unique numbers on both.
+*/
+#include <petscsf.h>
+
+/* Random leaves, contiguous or at the odd locations of a leaf space of twice their number in reverse order, process r has n + r%m roots */
+static PetscErrorCode CreateRandomSF(PetscRandom rnd,PetscInt n,PetscInt m,PetscInt nleaves,PetscBool sparse,PetscSF *sf)
+{
+  PetscSFNode    *remote;
+  PetscInt       *ilocal,i;
+  PetscMPIInt    rank,size;
+  PetscReal      r;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscMalloc1(sparse ? nleaves : 0,&ilocal);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nleaves,&remote);CHKERRQ(ierr);
+  for (i=0; i<nleaves; i++) {
+    if (sparse) ilocal[i] = 2*(nleaves-1-i)+1;
+    ierr = PetscRandomGetValueReal(rnd,&r);CHKERRQ(ierr);
+    remote[i].rank  = PetscMin((PetscInt)(r*size),size-1);
+    ierr = PetscRandomGetValueReal(rnd,&r);CHKERRQ(ierr);
+    remote[i].index = PetscMin((PetscInt)(r*(n+remote[i].rank%m)),n+remote[i].rank%m-1);
+  }
+  ierr = PetscSFCreate(PETSC_COMM_WORLD,sf);CHKERRQ(ierr);
+  ierr = PetscSFSetFromOptions(*sf);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(*sf,n+rank%m,nleaves,ilocal,PETSC_OWN_POINTER,remote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Compares broadcasts and reductions on sf with those on a duplicate of its graph */
+static PetscErrorCode CheckSF(PetscSF sf,const char *name)
+{
+  PetscSF        dup;
+  PetscInt       nroots,nleaves,leafsize,i,errors = 0,*roots[2],*leaves[2];
+  const PetscInt *ilocal;
+  PetscMPIInt    rank;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = PetscSFDuplicate(sf,PETSCSF_DUPLICATE_GRAPH,&dup);CHKERRQ(ierr);
+  ierr = PetscSFGetGraph(sf,&nroots,&nleaves,&ilocal,NULL);CHKERRQ(ierr);
+  for (i=0,leafsize=nleaves; i<nleaves && ilocal; i++) leafsize = PetscMax(leafsize,ilocal[i]+1);
+  ierr = PetscMalloc4(nroots,&roots[0],nroots,&roots[1],leafsize,&leaves[0],leafsize,&leaves[1]);CHKERRQ(ierr);
+  for (i=0; i<nroots; i++) roots[0][i] = roots[1][i] = 1000*rank + i;
+  for (i=0; i<leafsize; i++) leaves[0][i] = leaves[1][i] = -1;
+  ierr = PetscSFBcastBegin(sf,MPIU_INT,roots[0],leaves[0]);CHKERRQ(ierr);
+  ierr = PetscSFBcastBegin(dup,MPIU_INT,roots[1],leaves[1]);CHKERRQ(ierr);
+  ierr = PetscSFBcastEnd(sf,MPIU_INT,roots[0],leaves[0]);CHKERRQ(ierr);
+  ierr = PetscSFBcastEnd(dup,MPIU_INT,roots[1],leaves[1]);CHKERRQ(ierr);
+  for (i=0; i<leafsize; i++) if (leaves[0][i] != leaves[1][i]) errors++;
+  for (i=0; i<nroots; i++) roots[0][i] = roots[1][i] = 0;
+  for (i=0; i<leafsize; i++) leaves[0][i] = leaves[1][i] = 1000*rank + i + 1;
+  ierr = PetscSFReduceBegin(sf,MPIU_INT,leaves[0],roots[0],MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceBegin(dup,MPIU_INT,leaves[1],roots[1],MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(sf,MPIU_INT,leaves[0],roots[0],MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(dup,MPIU_INT,leaves[1],roots[1],MPIU_SUM);CHKERRQ(ierr);
+  for (i=0; i<nroots; i++) if (roots[0][i] != roots[1][i]) errors++;
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: %D errors\n",name,errors);CHKERRQ(ierr);
+  ierr = PetscFree4(roots[0],roots[1],leaves[0],leaves[1]);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&dup);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+int main(int argc,char **argv)
+{
+  PetscSF        sfA,sfB,sfP,esf,isf,csf;
+  PetscSFNode    *remote;
+  PetscInt       n = 10,nroots,i,nselected,*selected,*ilocal;
+  PetscMPIInt    rank,size;
+  PetscRandom    rnd;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_SELF,&rnd);CHKERRQ(ierr);
+  ierr = PetscRandomSetSeed(rnd,(unsigned long)(rank+1));CHKERRQ(ierr);
+  ierr = PetscRandomSeed(rnd);CHKERRQ(ierr);
+
+  /* Random star forests, sfB has a root for each leaf of sfA and contiguous leaves as PetscSFCompose() requires */
+  ierr = CreateRandomSF(rnd,n,3,2*n+rank%2,PETSC_TRUE,&sfA);CHKERRQ(ierr);
+  ierr = CreateRandomSF(rnd,2*n,2,n,PETSC_FALSE,&sfB);CHKERRQ(ierr);
+
+  /* Roots of degree at most one for the inverse: the even leaves reference the roots of the next process in reverse order */
+  nroots = n;
+  ierr = PetscMalloc1((n+1)/2,&ilocal);CHKERRQ(ierr);
+  ierr = PetscMalloc1((n+1)/2,&remote);CHKERRQ(ierr);
+  for (i=0; i<(n+1)/2; i++) {
+    ilocal[i]       = 2*i;
+    remote[i].rank  = (rank+1)%size;
+    remote[i].index = n-1-2*i;
+  }
+  ierr = PetscSFCreate(PETSC_COMM_WORLD,&sfP);CHKERRQ(ierr);
+  ierr = PetscSFSetFromOptions(sfP);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(sfP,nroots,(n+1)/2,ilocal,PETSC_OWN_POINTER,remote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+
+  /* Overlapped setup of the original star forests */
+  ierr = PetscSFSetUpBegin(sfA);CHKERRQ(ierr);
+  ierr = PetscSFSetUpBegin(sfB);CHKERRQ(ierr);
+  ierr = PetscSFSetUpBegin(sfP);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd(sfA);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd(sfB);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd(sfP);CHKERRQ(ierr);
+  ierr = CheckSF(sfA,"Random");CHKERRQ(ierr);
+
+  /* Derived star forests, set up together */
+  ierr = PetscSFGetGraph(sfA,&nroots,NULL,NULL,NULL);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nroots,&selected);CHKERRQ(ierr);
+  for (i=0,nselected=0; i<nroots; i++) if ((i+rank)%3) selected[nselected++] = i;
+  ierr = PetscSFCreateEmbeddedSF(sfA,nselected,selected,&esf);CHKERRQ(ierr);
+  ierr = PetscSFCreateInverseSF(sfP,&isf);CHKERRQ(ierr);
+  ierr = PetscSFCompose(sfA,sfB,&csf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpBegin(esf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpBegin(isf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpBegin(csf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd(esf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd(isf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd(csf);CHKERRQ(ierr);
+  ierr = CheckSF(esf,"Embedded");CHKERRQ(ierr);
+  ierr = CheckSF(isf,"Inverse");CHKERRQ(ierr);
+  ierr = CheckSF(csf,"Composed");CHKERRQ(ierr);
+
+  ierr = PetscFree(selected);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&esf);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&isf);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&csf);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&sfA);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&sfB);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&sfP);CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rnd);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      nsize: {{1 2 3 5}}
+      output_file: output/ex3_1.out
+
+   test:
+      suffix: neighbor
+      nsize: 4
+      args: -sf_type neighbor
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      output_file: output/ex3_1.out
+
+   test:
+      suffix: shared
+      nsize: 4
+      args: -sf_type shared -sf_shared_node_size 2
+      requires: define(PETSC_HAVE_MPI_PROCESS_SHARED_MEMORY)
+      output_file: output/ex3_1.out
+
+TEST*/
@@ -0,0 +1,99 @@
+static const char help[] = "Tests PetscSFReduce() with many leaves of each process on the same roots, as in finite element assembly.\n\
+  -n <n> : number of elements on each process\n\n";
+
+/*
+   The nodes 0,...,N-1 are distributed in blocks of n, and element g touches the nodes g,g+1,g+2,g+3 (modulo N), so
+   that each node has four leaves, mostly on the process owning it. The leaves are stored in a scrambled order. The
+   sums and maxima reduced into the nodes are compared with their exact values.
+*/
+#include <petscsf.h>
+
+#define NV 4
+
+int main(int argc,char **argv)
+{
+  PetscSF        sf;
+  PetscSFNode    *remote;
+  PetscInt       n = 2001,N,nleaves,e,v,j,*leafint,*rootint,*rootmax,errors = 0;
+  PetscScalar    *leafval,*rootval;
+  PetscMPIInt    rank,size;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  N       = n*size;
+  nleaves = NV*n;
+  if (!(nleaves%7919)) SETERRQ(PETSC_COMM_WORLD,PETSC_ERR_ARG_OUTOFRANGE,"The number of leaves must not be a multiple of 7919");
+
+  /* Leaf l of element e is stored at position (7919*l) mod nleaves, a permutation */
+  ierr = PetscMalloc1(nleaves,&remote);CHKERRQ(ierr);
+  ierr = PetscMalloc4(nleaves,&leafint,nleaves,&leafval,n,&rootint,n,&rootval);CHKERRQ(ierr);
+  ierr = PetscMalloc1(n,&rootmax);CHKERRQ(ierr);
+  for (e=0; e<n; e++) {
+    PetscInt g = rank*n + e;
+    for (v=0; v<NV; v++) {
+      PetscInt node = (g+v)%N,pos = (PetscInt)((7919*(PetscInt64)(e*NV+v))%nleaves);
+      remote[pos].rank  = node/n;
+      remote[pos].index = node%n;
+      leafint[pos]      = NV*g + v + 1;
+      leafval[pos]      = 0.5*(NV*g + v + 1);
+    }
+  }
+  ierr = PetscSFCreate(PETSC_COMM_WORLD,&sf);CHKERRQ(ierr);
+  ierr = PetscSFSetFromOptions(sf);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(sf,n,nleaves,NULL,PETSC_OWN_POINTER,remote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+  ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
+
+  for (j=0; j<n; j++) {
+    rootint[j] = 0;
+    rootval[j] = 0.0;
+    rootmax[j] = 0;
+  }
+  ierr = PetscSFReduceBegin(sf,MPIU_INT,leafint,rootint,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceBegin(sf,MPIU_SCALAR,leafval,rootval,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(sf,MPIU_INT,leafint,rootint,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(sf,MPIU_SCALAR,leafval,rootval,MPIU_SUM);CHKERRQ(ierr);
+  ierr = PetscSFReduceBegin(sf,MPIU_INT,leafint,rootmax,MPIU_MAX);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(sf,MPIU_INT,leafint,rootmax,MPIU_MAX);CHKERRQ(ierr);
+  for (j=0; j<n; j++) {
+    PetscInt node = rank*n + j,sum = 0,max = 0;
+    for (v=0; v<NV; v++) {
+      PetscInt g = (node-v+N)%N;
+      sum += NV*g + v + 1;
+      max  = PetscMax(max,NV*g + v + 1);
+    }
+    if (rootint[j] != sum || PetscAbsScalar(rootval[j]-0.5*sum) > 0 || rootmax[j] != max) errors++;
+  }
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Reduce: %D wrong roots\n",errors);CHKERRQ(ierr);
+
+  ierr = PetscFree4(leafint,leafval,rootint,rootval);CHKERRQ(ierr);
+  ierr = PetscFree(rootmax);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&sf);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      nsize: {{1 3}}
+      args: -sf_basic_unpack_threads {{0 4}}
+      output_file: output/ex4_1.out
+
+   test:
+      suffix: waitsome
+      nsize: 4
+      args: -sf_basic_reduce_waitsome -sf_basic_unpack_threads {{0 2}}
+      output_file: output/ex4_1.out
+
+   test:
+      suffix: neighbor
+      nsize: 3
+      args: -sf_type neighbor -sf_basic_unpack_threads 3
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      output_file: output/ex4_1.out
+
+TEST*/
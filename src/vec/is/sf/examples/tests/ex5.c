@@ -0,0 +1,98 @@
+static const char help[] = "Tests PETSCSFAUTO, which times the PetscSF implementations and selects the fastest.\n\
+  -n <n> : number of roots on each process\n\
+  -iter <iter> : number of broadcasts and reductions\n\
+  -print_type : print the selected transport\n\n";
+
+/*
+   Leaf i references my root n-1-i and leaf n+i references root i of the next process. Each iteration broadcasts the
+   roots, broadcasts them again adding into other leaves while the first broadcast is in progress, and sums the leaves
+   into the roots, so that the operations are timed on the candidates in turn and then performed by the one selected.
+*/
+#include <petscsf.h>
+
+int main(int argc,char **argv)
+{
+  PetscSF        sf;
+  PetscSFNode    *remote;
+  PetscInt       n = 100,iter = 10,i,it,errors = 0,*rootdata,*leafdata,*leafsum;
+  PetscMPIInt    rank,size;
+  PetscBool      print = PETSC_FALSE;
+  const char     *type;
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-iter",&iter,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(NULL,NULL,"-print_type",&print,NULL);CHKERRQ(ierr);
+
+  ierr = PetscMalloc1(2*n,&remote);CHKERRQ(ierr);
+  for (i=0; i<n; i++) {
+    remote[i].rank    = rank;
+    remote[i].index   = n-1-i;
+    remote[n+i].rank  = (rank+1)%size;
+    remote[n+i].index = i;
+  }
+  ierr = PetscSFCreate(PETSC_COMM_WORLD,&sf);CHKERRQ(ierr);
+  ierr = PetscSFSetType(sf,PETSCSFAUTO);CHKERRQ(ierr);
+  ierr = PetscSFSetFromOptions(sf);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(sf,n,2*n,NULL,PETSC_OWN_POINTER,remote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+  ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
+
+  ierr = PetscMalloc3(n,&rootdata,2*n,&leafdata,2*n,&leafsum);CHKERRQ(ierr);
+  for (it=0; it<iter; it++) {
+    PetscMPIInt next = (rank+1)%size;
+
+    for (i=0; i<n; i++) rootdata[i] = 1000*rank + i + it;
+    for (i=0; i<2*n; i++) leafdata[i] = -1;
+    for (i=0; i<2*n; i++) leafsum[i] = i;
+    ierr = PetscSFBcastBegin(sf,MPIU_INT,rootdata,leafdata);CHKERRQ(ierr);
+    ierr = PetscSFBcastAndOpBegin(sf,MPIU_INT,rootdata,leafsum,MPIU_SUM);CHKERRQ(ierr);
+    ierr = PetscSFBcastAndOpEnd(sf,MPIU_INT,rootdata,leafsum,MPIU_SUM);CHKERRQ(ierr);
+    ierr = PetscSFBcastEnd(sf,MPIU_INT,rootdata,leafdata);CHKERRQ(ierr);
+    for (i=0; i<n; i++) {
+      if (leafdata[i] != 1000*rank + n-1-i + it || leafsum[i] != i + leafdata[i]) errors++;
+      if (leafdata[n+i] != 1000*next + i + it || leafsum[n+i] != n+i + leafdata[n+i]) errors++;
+    }
+
+    for (i=0; i<n; i++) rootdata[i] = 0;
+    for (i=0; i<2*n; i++) leafdata[i] = i + it;
+    ierr = PetscSFReduceBegin(sf,MPIU_INT,leafdata,rootdata,MPIU_SUM);CHKERRQ(ierr);
+    ierr = PetscSFReduceEnd(sf,MPIU_INT,leafdata,rootdata,MPIU_SUM);CHKERRQ(ierr);
+    for (i=0; i<n; i++) if (rootdata[i] != (n-1-i + it) + (n+i + it)) errors++;
+  }
+  ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Errors: %D\n",errors);CHKERRQ(ierr);
+
+  ierr = PetscSFAutoGetType(sf,&type);CHKERRQ(ierr);
+  if (print) {ierr = PetscPrintf(PETSC_COMM_WORLD,"Selected: %s\n",type);CHKERRQ(ierr);}
+  else {ierr = PetscPrintf(PETSC_COMM_WORLD,"Selected a transport: %s\n",type ? "yes" : "no");CHKERRQ(ierr);}
+
+  ierr = PetscSFViewFromOptions(sf,NULL,"-sf_view");CHKERRQ(ierr);
+
+  ierr = PetscFree3(rootdata,leafdata,leafsum);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&sf);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      nsize: {{1 3}}
+      args: -sf_auto_trials 2
+
+   test:
+      suffix: fixed
+      nsize: 2
+      args: -sf_auto_type basic -print_type
+
+   test:
+      suffix: neighbor
+      nsize: 4
+      args: -sf_auto_candidates basic,neighbor -sf_auto_trials 1 -sf_basic_unpack_threads 2
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      output_file: output/ex5_1.out
+
+TEST*/
@@ -425,4 +425,44 @@ int main(int argc,char **argv)
       nsize: 3
       args: -test_bcast -test_sf_distribute -sf_type basic
 
+   test:
+      suffix: neighbor
+      nsize: 4
+      args: -test_bcast -sf_type neighbor
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      filter: sed -e "s/type: neighbor/type: basic/g"
+      output_file: output/ex1_1_basic.out
+
+   test:
+      suffix: 2_neighbor
+      nsize: 4
+      args: -test_reduce -sf_type neighbor
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      filter: sed -e "s/type: neighbor/type: basic/g"
+      output_file: output/ex1_2_basic.out
+
+   test:
+      suffix: 3_neighbor
+      nsize: 4
+      args: -test_degree -sf_type neighbor
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      filter: sed -e "s/type: neighbor/type: basic/g"
+      output_file: output/ex1_3_basic.out
+
+   test:
+      suffix: 5_neighbor
+      nsize: 4
+      args: -test_scatter -stride 2 -sf_type neighbor
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      filter: sed -e "s/type: neighbor/type: basic/g"
+      output_file: output/ex1_5_stride.out
+
+   test:
+      suffix: 8_neighbor
+      nsize: 3
+      args: -test_bcast -test_sf_distribute -sf_type neighbor
+      requires: define(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+      filter: sed -e "s/type: neighbor/type: basic/g"
+      output_file: output/ex1_8_basic.out
+
 TEST*/
@@ -0,0 +1,658 @@
+#include <petsc/private/sfimpl.h> /*I "petscsf.h" I*/
+#include <petsctime.h>
+
+/* A transport that PETSCSFAUTO can select */
+typedef struct {
+  const char            *name;
+  PetscSFType           type;
+  PetscSFWindowSyncType sync;      /* Synchronization of PETSCSFWINDOW */
+  PetscBool             bydefault; /* Timed unless -sf_auto_candidates is given */
+} PetscSFAutoCandidate;
+
+/* As in the tests of PETSCSFWINDOW, the one-sided operations are only trusted with MPICH */
+#if defined(PETSC_HAVE_MPICH_NUMVERSION)
+#define PETSCSF_AUTO_WINDOW_BYDEFAULT PETSC_TRUE
+#else
+#define PETSCSF_AUTO_WINDOW_BYDEFAULT PETSC_FALSE
+#endif
+
+static const PetscSFAutoCandidate PetscSFAutoCandidates[] = {
+  {"basic",        PETSCSFBASIC,    PETSCSF_WINDOW_SYNC_FENCE,  PETSC_TRUE},
+#if defined(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+  {"neighbor",     PETSCSFNEIGHBOR, PETSCSF_WINDOW_SYNC_FENCE,  PETSC_TRUE},
+#endif
+#if defined(PETSC_HAVE_MPI_PROCESS_SHARED_MEMORY)
+  {"shared",       PETSCSFSHARED,   PETSCSF_WINDOW_SYNC_FENCE,  PETSC_TRUE},
+#endif
+#if defined(PETSC_HAVE_MPI_WIN_CREATE) && defined(PETSC_HAVE_MPI_TYPE_DUP)
+  {"window_fence", PETSCSFWINDOW,   PETSCSF_WINDOW_SYNC_FENCE,  PETSCSF_AUTO_WINDOW_BYDEFAULT},
+  {"window_lock",  PETSCSFWINDOW,   PETSCSF_WINDOW_SYNC_LOCK,   PETSCSF_AUTO_WINDOW_BYDEFAULT},
+  {"window_active",PETSCSFWINDOW,   PETSCSF_WINDOW_SYNC_ACTIVE, PETSCSF_AUTO_WINDOW_BYDEFAULT},
+#endif
+};
+#define PETSCSF_AUTO_NCANDIDATES ((PetscInt)(sizeof(PetscSFAutoCandidates)/sizeof(PetscSFAutoCandidates[0])))
+
+typedef struct _n_PetscSFAutoOp *PetscSFAutoOp;
+struct _n_PetscSFAutoOp {
+  MPI_Datatype   unit;
+  const void     *rootdata;     /* With unit and leafdata, identifies the operation at its end */
+  const void     *leafdata;
+  PetscInt       c;             /* Candidate performing the operation */
+  PetscBool      timed;         /* Begun while probing, its time counts for candidate c */
+  PetscLogDouble time;          /* Time spent in its begin and end */
+  PetscSFAutoOp  next;
+};
+
+typedef struct {
+  PetscInt       ncand;                             /* Number of candidates */
+  PetscInt       cand[PETSCSF_AUTO_NCANDIDATES];    /* Their indices in PetscSFAutoCandidates[] */
+  PetscInt       ntrials;                           /* Number of timed operations of each candidate */
+  PetscBool      options;                           /* PetscSFSetFromOptions() was called, so the candidates read the options of their type */
+  PetscSF        sf[PETSCSF_AUTO_NCANDIDATES];      /* The candidates with the graph, NULL once discarded */
+  PetscInt       nbegun;                            /* Number of timed operations begun */
+  PetscInt       ndone[PETSCSF_AUTO_NCANDIDATES];   /* Number of timed operations of each candidate completed, on this process until the selection */
+  PetscLogDouble best[PETSCSF_AUTO_NCANDIDATES];    /* Fastest of them, on this process until the selection, then on the slowest process */
+  PetscInt       selected;                          /* Candidate selected, -1 while probing */
+  PetscSFAutoOp  inuse;                             /* Operations in progress */
+  PetscSFAutoOp  avail;                             /* Records available for reuse */
+} PetscSF_Auto;
+
+static PetscErrorCode PetscSFAutoFindCandidate(const char name[],PetscInt *c)
+{
+  PetscErrorCode ierr;
+  PetscBool      match;
+
+  PetscFunctionBegin;
+  for (*c=0; *c<PETSCSF_AUTO_NCANDIDATES; (*c)++) {
+    ierr = PetscStrcmp(name,PetscSFAutoCandidates[*c].name,&match);CHKERRQ(ierr);
+    if (match) PetscFunctionReturn(0);
+  }
+  SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_UNKNOWN_TYPE,"Unknown or unavailable PETSCSFAUTO transport %s",name);
+  PetscFunctionReturn(0);
+}
+
+static void PetscSFAutoSetDefaultCandidates(PetscSF_Auto *a)
+{
+  PetscInt c;
+
+  for (c=0,a->ncand=0; c<PETSCSF_AUTO_NCANDIDATES; c++) if (PetscSFAutoCandidates[c].bydefault) a->cand[a->ncand++] = c;
+}
+
+/*@C
+   PetscSFAutoSetType - Sets the transport used by a PETSCSFAUTO star forest, which then does not time the candidates
+
+   Logically Collective
+
+   Input Arguments:
++  sf - star forest of type PETSCSFAUTO
+-  name - basic, neighbor, shared, window_fence, window_lock or window_active, among those available, or NULL to time
+          the default candidates again
+
+   Options Database Key:
+.  -sf_auto_type <name> - sets the transport
+
+   Notes:
+   Must be called before PetscSFSetUp(). The transport selected in a run, given by PetscSFAutoGetType() or PetscSFView(),
+   can be passed to later runs on the same machine and graph to skip the timing.
+
+   Level: advanced
+
+.seealso: PetscSFAutoGetType(), PETSCSFAUTO
+@*/
+PetscErrorCode PetscSFAutoSetType(PetscSF sf,const char name[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  ierr = PetscTryMethod(sf,"PetscSFAutoSetType_C",(PetscSF,const char[]),(sf,name));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFAutoSetType_Auto(PetscSF sf,const char name[])
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (sf->setupcalled) SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONGSTATE,"Must call PetscSFAutoSetType() before PetscSFSetUp()");
+  if (name) {
+    ierr = PetscSFAutoFindCandidate(name,&a->cand[0]);CHKERRQ(ierr);
+    a->ncand = 1;
+  } else PetscSFAutoSetDefaultCandidates(a);
+  PetscFunctionReturn(0);
+}
+
+/*@C
+   PetscSFAutoGetType - Gets the transport selected by a PETSCSFAUTO star forest
+
+   Not Collective
+
+   Input Argument:
+.  sf - star forest of type PETSCSFAUTO
+
+   Output Argument:
+.  name - name of the transport, to be passed to PetscSFAutoSetType() or -sf_auto_type, or NULL if the candidates are
+          still being timed
+
+   Level: advanced
+
+.seealso: PetscSFAutoSetType(), PETSCSFAUTO
+@*/
+PetscErrorCode PetscSFAutoGetType(PetscSF sf,const char **name)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  PetscValidPointer(name,2);
+  ierr = PetscUseMethod(sf,"PetscSFAutoGetType_C",(PetscSF,const char**),(sf,name));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFAutoGetType_Auto(PetscSF sf,const char **name)
+{
+  PetscSF_Auto *a = (PetscSF_Auto*)sf->data;
+
+  PetscFunctionBegin;
+  *name = sf->setupcalled && a->selected >= 0 ? PetscSFAutoCandidates[a->cand[a->selected]].name : NULL;
+  PetscFunctionReturn(0);
+}
+
+/* Creates candidate c with the graph of sf */
+static PetscErrorCode PetscSFAutoCreateCandidate(PetscSF sf,PetscInt c)
+{
+  PetscSF_Auto               *a = (PetscSF_Auto*)sf->data;
+  const PetscSFAutoCandidate *t = &PetscSFAutoCandidates[a->cand[c]];
+  PetscSF                    csf;
+  PetscBool                  iswindow;
+  PetscErrorCode             ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFCreate(PetscObjectComm((PetscObject)sf),&csf);CHKERRQ(ierr);
+  ierr = PetscLogObjectParent((PetscObject)sf,(PetscObject)csf);CHKERRQ(ierr);
+  ierr = PetscObjectSetOptionsPrefix((PetscObject)csf,((PetscObject)sf)->prefix);CHKERRQ(ierr);
+  ierr = PetscSFSetType(csf,t->type);CHKERRQ(ierr);
+  if (a->options && csf->ops->SetFromOptions) { /* The options of its type, but not -sf_type */
+    ierr = PetscObjectOptionsBegin((PetscObject)csf);CHKERRQ(ierr);
+    ierr = (*csf->ops->SetFromOptions)(PetscOptionsObject,csf);CHKERRQ(ierr);
+    ierr = PetscOptionsEnd();CHKERRQ(ierr);
+  }
+  ierr = PetscStrcmp(t->type,PETSCSFWINDOW,&iswindow);CHKERRQ(ierr);
+  if (iswindow) {ierr = PetscSFWindowSetSyncType(csf,t->sync);CHKERRQ(ierr);}
+  ierr = PetscSFSetRankOrder(csf,sf->rankorder);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(csf,sf->nroots,sf->nleaves,sf->mine,PETSC_COPY_VALUES,sf->remote,PETSC_COPY_VALUES);CHKERRQ(ierr);
+  a->sf[c] = csf;
+  PetscFunctionReturn(0);
+}
+
+/* Passes the ranks referencing my roots, found by the setup of from, to to so that its setup does not discover them */
+static PetscErrorCode PetscSFAutoShareRootRanks(PetscSF from,PetscSF to)
+{
+  PetscErrorCode    ierr;
+  PetscMPIInt       rank,nk,*kranks;
+  PetscInt          i,niranks,*koffset,*kroots;
+  const PetscMPIInt *iranks;
+  const PetscInt    *ioffset,*irootloc;
+
+  PetscFunctionBegin;
+  if (!from->ops->GetRootRanks) PetscFunctionReturn(0);
+  ierr = MPI_Comm_rank(PetscObjectComm((PetscObject)from),&rank);CHKERRQ(ierr);
+  ierr = (*from->ops->GetRootRanks)(from,&niranks,NULL,&iranks,&ioffset,&irootloc);CHKERRQ(ierr);
+  ierr = PetscMalloc1(niranks,&kranks);CHKERRQ(ierr);
+  ierr = PetscMalloc1(niranks+1,&koffset);CHKERRQ(ierr);
+  ierr = PetscMalloc1(ioffset[niranks],&kroots);CHKERRQ(ierr);
+  koffset[0] = 0;
+  for (i=0,nk=0; i<niranks; i++) {
+    PetscInt len = ioffset[i+1] - ioffset[i];
+    if (iranks[i] == rank) continue;
+    kranks[nk] = iranks[i];
+    ierr = PetscMemcpy(kroots+koffset[nk],irootloc+ioffset[i],len*sizeof(PetscInt));CHKERRQ(ierr);
+    koffset[nk+1] = koffset[nk] + len;
+    nk++;
+  }
+  ierr = PetscSFSetKnownRootRanks_Private(to,PETSC_FALSE,nk,kranks,koffset,kroots);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFSetUp_Auto(PetscSF sf)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscInt       c;
+
+  PetscFunctionBegin;
+  ierr = PetscSFSetUpRanks(sf,MPI_GROUP_EMPTY);CHKERRQ(ierr);
+  for (c=0; c<a->ncand; c++) {ierr = PetscSFAutoCreateCandidate(sf,c);CHKERRQ(ierr);}
+  /* The first candidate finds the ranks referencing my roots, the others set up together with what it found */
+  ierr = PetscSFSetUp(a->sf[0]);CHKERRQ(ierr);
+  for (c=1; c<a->ncand; c++) {
+    ierr = PetscSFAutoShareRootRanks(a->sf[0],a->sf[c]);CHKERRQ(ierr);
+    ierr = PetscSFSetUpBegin(a->sf[c]);CHKERRQ(ierr);
+  }
+  for (c=1; c<a->ncand; c++) {ierr = PetscSFSetUpEnd(a->sf[c]);CHKERRQ(ierr);}
+  a->selected = a->ncand == 1 ? 0 : -1;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFGetRootRanks_Auto(PetscSF sf,PetscInt *niranks,PetscInt *ndiranks,const PetscMPIInt **iranks,const PetscInt **ioffset,const PetscInt **irootloc)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscInt       c;
+
+  PetscFunctionBegin;
+  for (c=0; c<a->ncand; c++) {
+    if (a->sf[c] && a->sf[c]->ops->GetRootRanks) {
+      ierr = (*a->sf[c]->ops->GetRootRanks)(a->sf[c],niranks,ndiranks,iranks,ioffset,irootloc);CHKERRQ(ierr);
+      PetscFunctionReturn(0);
+    }
+  }
+  SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"No candidate knows the ranks referencing its roots");
+  PetscFunctionReturn(0);
+}
+
+/*
+   Selects the candidate whose fastest timed operation is the fastest on the slowest process, among those that completed
+   a timed operation on every process. The others are discarded if no operation is in progress on any process.
+*/
+static PetscErrorCode PetscSFAutoSelect(PetscSF sf)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscLogDouble *in,*out;
+  PetscInt       c,n = a->ncand,sel = -1,keep = -1;
+  PetscSFAutoOp  link;
+  const char     *prefix;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc2(2*n+1,&in,2*n+1,&out);CHKERRQ(ierr);
+  for (c=0; c<n; c++) {
+    in[c]   = a->ndone[c] ? a->best[c] : 0.0;
+    in[n+c] = -(PetscLogDouble)a->ndone[c];
+  }
+  for (in[2*n]=0.0,link=a->inuse; link; link=link->next) in[2*n] += 1.0;
+  ierr = MPIU_Allreduce(in,out,2*n+1,MPIU_PETSCLOGDOUBLE,MPI_MAX,PetscObjectComm((PetscObject)sf));CHKERRQ(ierr);
+  for (c=0; c<n; c++) {
+    a->best[c]  = out[c];
+    a->ndone[c] = (PetscInt)-out[n+c];
+    if (a->ndone[c] && (sel < 0 || a->best[c] < a->best[sel])) sel = c;
+  }
+  a->selected = sel < 0 ? 0 : sel;
+  ierr = PetscObjectGetOptionsPrefix((PetscObject)sf,&prefix);CHKERRQ(ierr);
+  for (c=0; c<n; c++) {
+    ierr = PetscInfo3(sf,"Candidate %s: %g seconds in %D timed operations\n",PetscSFAutoCandidates[a->cand[c]].name,(double)a->best[c],a->ndone[c]);CHKERRQ(ierr);
+  }
+  ierr = PetscInfo3(sf,"Selected %s, use -%ssf_auto_type %s to skip the timing\n",PetscSFAutoCandidates[a->cand[a->selected]].name,prefix ? prefix : "",PetscSFAutoCandidates[a->cand[a->selected]].name);CHKERRQ(ierr);
+  if (!out[2*n]) {
+    /* Keep a candidate broadcasting with any MPI_Op if the selected one does not */
+    if (!a->sf[a->selected]->ops->BcastAndOpBegin) for (c=0; c<n && keep<0; c++) if (a->sf[c]->ops->BcastAndOpBegin) keep = c;
+    for (c=0; c<n; c++) if (c != a->selected && c != keep) {ierr = PetscSFDestroy(&a->sf[c]);CHKERRQ(ierr);}
+  }
+  ierr = PetscFree2(in,out);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Records the operation being begun with the candidate performing it. While probing the candidates take turns, shifted
+   by one at each round so that a repeating sequence of operations reaches each candidate at every position.
+*/
+static PetscErrorCode PetscSFAutoOpBegin(PetscSF sf,MPI_Datatype unit,const void *rootdata,const void *leafdata,PetscBool needop,PetscSFAutoOp *mylink)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link;
+  PetscInt       c,i;
+  PetscBool      timed = PETSC_FALSE;
+
+  PetscFunctionBegin;
+  if (a->selected < 0 && a->nbegun == a->ncand*a->ntrials) {ierr = PetscSFAutoSelect(sf);CHKERRQ(ierr);}
+  if (a->selected >= 0) c = a->selected;
+  else {
+    c     = (a->nbegun + a->nbegun/a->ncand) % a->ncand;
+    timed = PETSC_TRUE;
+    a->nbegun++;
+  }
+  if (needop && !a->sf[c]->ops->BcastAndOpBegin) { /* PETSCSFWINDOW only broadcasts with MPIU_REPLACE, the next candidate that can does it */
+    for (i=1; i<a->ncand; i++) if (a->sf[(c+i)%a->ncand] && a->sf[(c+i)%a->ncand]->ops->BcastAndOpBegin) break;
+    if (i == a->ncand) SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_SUP,"No transport of this PETSCSFAUTO broadcasts with an MPI_Op other than MPIU_REPLACE");
+    c = (c+i)%a->ncand;
+  }
+  if (a->avail) {
+    link     = a->avail;
+    a->avail = link->next;
+  } else {ierr = PetscNew(&link);CHKERRQ(ierr);}
+  link->unit     = unit;
+  link->rootdata = rootdata;
+  link->leafdata = leafdata;
+  link->c        = c;
+  link->timed    = timed;
+  link->time     = 0.0;
+  link->next     = a->inuse;
+  a->inuse       = link;
+  *mylink        = link;
+  PetscFunctionReturn(0);
+}
+
+/* Finds the operation being ended and removes it from those in progress */
+static PetscErrorCode PetscSFAutoOpFind(PetscSF sf,MPI_Datatype unit,const void *rootdata,const void *leafdata,PetscSFAutoOp *mylink)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link,*p;
+  PetscBool      match;
+
+  PetscFunctionBegin;
+  for (p=&a->inuse; (link=*p); p=&link->next) {
+    if (link->rootdata != rootdata || link->leafdata != leafdata) continue;
+    ierr = MPIPetsc_Type_compare(unit,link->unit,&match);CHKERRQ(ierr);
+    if (match) {
+      *p      = link->next;
+      *mylink = link;
+      PetscFunctionReturn(0);
+    }
+  }
+  SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONGSTATE,"Could not find the operation begun with these arguments");
+  PetscFunctionReturn(0);
+}
+
+/* Accounts for a completed operation and recycles its record */
+static PetscErrorCode PetscSFAutoOpEnd(PetscSF sf,PetscSFAutoOp link)
+{
+  PetscSF_Auto *a = (PetscSF_Auto*)sf->data;
+
+  PetscFunctionBegin;
+  if (link->timed && a->selected < 0) {
+    a->best[link->c] = a->ndone[link->c] ? PetscMin(a->best[link->c],link->time) : link->time;
+    a->ndone[link->c]++;
+  }
+  link->next = a->avail;
+  a->avail   = link;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBcastAndOpBegin_Auto(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link;
+  PetscLogDouble t0,t1;
+
+  PetscFunctionBegin;
+  ierr = PetscSFAutoOpBegin(sf,unit,rootdata,leafdata,(PetscBool)(op != MPIU_REPLACE),&link);CHKERRQ(ierr);
+  ierr = PetscTime(&t0);CHKERRQ(ierr);
+  ierr = PetscSFBcastAndOpBegin(a->sf[link->c],unit,rootdata,leafdata,op);CHKERRQ(ierr);
+  ierr = PetscTime(&t1);CHKERRQ(ierr);
+  link->time += t1 - t0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBcastAndOpEnd_Auto(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link;
+  PetscLogDouble t0,t1;
+
+  PetscFunctionBegin;
+  ierr = PetscSFAutoOpFind(sf,unit,rootdata,leafdata,&link);CHKERRQ(ierr);
+  ierr = PetscTime(&t0);CHKERRQ(ierr);
+  ierr = PetscSFBcastAndOpEnd(a->sf[link->c],unit,rootdata,leafdata,op);CHKERRQ(ierr);
+  ierr = PetscTime(&t1);CHKERRQ(ierr);
+  link->time += t1 - t0;
+  ierr = PetscSFAutoOpEnd(sf,link);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReduceBegin_Auto(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link;
+  PetscLogDouble t0,t1;
+
+  PetscFunctionBegin;
+  ierr = PetscSFAutoOpBegin(sf,unit,rootdata,leafdata,PETSC_FALSE,&link);CHKERRQ(ierr);
+  ierr = PetscTime(&t0);CHKERRQ(ierr);
+  ierr = PetscSFReduceBegin(a->sf[link->c],unit,leafdata,rootdata,op);CHKERRQ(ierr);
+  ierr = PetscTime(&t1);CHKERRQ(ierr);
+  link->time += t1 - t0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReduceEnd_Auto(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link;
+  PetscLogDouble t0,t1;
+
+  PetscFunctionBegin;
+  ierr = PetscSFAutoOpFind(sf,unit,rootdata,leafdata,&link);CHKERRQ(ierr);
+  ierr = PetscTime(&t0);CHKERRQ(ierr);
+  ierr = PetscSFReduceEnd(a->sf[link->c],unit,leafdata,rootdata,op);CHKERRQ(ierr);
+  ierr = PetscTime(&t1);CHKERRQ(ierr);
+  link->time += t1 - t0;
+  ierr = PetscSFAutoOpEnd(sf,link);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFFetchAndOpBegin_Auto(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link;
+  PetscLogDouble t0,t1;
+
+  PetscFunctionBegin;
+  ierr = PetscSFAutoOpBegin(sf,unit,rootdata,leafdata,PETSC_FALSE,&link);CHKERRQ(ierr);
+  ierr = PetscTime(&t0);CHKERRQ(ierr);
+  ierr = PetscSFFetchAndOpBegin(a->sf[link->c],unit,rootdata,leafdata,leafupdate,op);CHKERRQ(ierr);
+  ierr = PetscTime(&t1);CHKERRQ(ierr);
+  link->time += t1 - t0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFFetchAndOpEnd_Auto(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link;
+  PetscLogDouble t0,t1;
+
+  PetscFunctionBegin;
+  ierr = PetscSFAutoOpFind(sf,unit,rootdata,leafdata,&link);CHKERRQ(ierr);
+  ierr = PetscTime(&t0);CHKERRQ(ierr);
+  ierr = PetscSFFetchAndOpEnd(a->sf[link->c],unit,rootdata,leafdata,leafupdate,op);CHKERRQ(ierr);
+  ierr = PetscTime(&t1);CHKERRQ(ierr);
+  link->time += t1 - t0;
+  ierr = PetscSFAutoOpEnd(sf,link);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFProgress_Auto(PetscSF sf)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscInt       c;
+
+  PetscFunctionBegin;
+  for (c=0; c<a->ncand; c++) if (a->sf[c]) {ierr = PetscSFProgress(a->sf[c]);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFSetFromOptions_Auto(PetscOptionItems *PetscOptionsObject,PetscSF sf)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  const char     *names[PETSCSF_AUTO_NCANDIDATES];
+  char           *cand[PETSCSF_AUTO_NCANDIDATES];
+  PetscInt       c,n = PETSCSF_AUTO_NCANDIDATES,idx;
+  PetscBool      flg;
+
+  PetscFunctionBegin;
+  for (c=0; c<PETSCSF_AUTO_NCANDIDATES; c++) names[c] = PetscSFAutoCandidates[c].name;
+  ierr = PetscOptionsHead(PetscOptionsObject,"PetscSF Auto options");CHKERRQ(ierr);
+  ierr = PetscOptionsStringArray("-sf_auto_candidates","Comma separated transports to time","PETSCSFAUTO",cand,&n,&flg);CHKERRQ(ierr);
+  if (flg) {
+    if (!n) SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONG,"-sf_auto_candidates needs at least one transport");
+    for (c=0; c<n; c++) {
+      ierr = PetscSFAutoFindCandidate(cand[c],&a->cand[c]);CHKERRQ(ierr);
+      ierr = PetscFree(cand[c]);CHKERRQ(ierr);
+    }
+    a->ncand = n;
+  }
+  ierr = PetscOptionsEList("-sf_auto_type","Transport to use without timing the candidates","PetscSFAutoSetType",names,PETSCSF_AUTO_NCANDIDATES,names[a->cand[0]],&idx,&flg);CHKERRQ(ierr);
+  if (flg) {
+    a->cand[0] = idx;
+    a->ncand   = 1;
+  }
+  ierr = PetscOptionsInt("-sf_auto_trials","Number of timed operations of each candidate","PETSCSFAUTO",a->ntrials,&a->ntrials,NULL);CHKERRQ(ierr);
+  if (a->ntrials < 1) SETERRQ1(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_OUTOFRANGE,"Number of timed operations %D must be positive",a->ntrials);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  a->options = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFView_Auto(PetscSF sf,PetscViewer viewer)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscBool      iascii;
+  PetscInt       c;
+  const char     *prefix;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (!iascii) PetscFunctionReturn(0);
+  if (!sf->setupcalled || a->selected < 0) {
+    ierr = PetscViewerASCIIPrintf(viewer,"timing %D operations of each candidate, %D of %D begun:\n",a->ntrials,a->nbegun,a->ncand*a->ntrials);CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPushTab(viewer);CHKERRQ(ierr);
+    for (c=0; c<a->ncand; c++) {ierr = PetscViewerASCIIPrintf(viewer,"%s\n",PetscSFAutoCandidates[a->cand[c]].name);CHKERRQ(ierr);}
+    ierr = PetscViewerASCIIPopTab(viewer);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscObjectGetOptionsPrefix((PetscObject)sf,&prefix);CHKERRQ(ierr);
+  ierr = PetscViewerASCIIPrintf(viewer,"selected %s\n",PetscSFAutoCandidates[a->cand[a->selected]].name);CHKERRQ(ierr);
+  if (a->ncand > 1) {
+    ierr = PetscViewerASCIIPrintf(viewer,"fastest operation of each candidate, on the slowest process:\n");CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPushTab(viewer);CHKERRQ(ierr);
+    for (c=0; c<a->ncand; c++) {
+      if (a->ndone[c]) {ierr = PetscViewerASCIIPrintf(viewer,"%s: %g seconds of %D timed operations\n",PetscSFAutoCandidates[a->cand[c]].name,(double)a->best[c],a->ndone[c]);CHKERRQ(ierr);}
+      else {ierr = PetscViewerASCIIPrintf(viewer,"%s: not timed on all processes\n",PetscSFAutoCandidates[a->cand[c]].name);CHKERRQ(ierr);}
+    }
+    ierr = PetscViewerASCIIPopTab(viewer);CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPrintf(viewer,"use -%ssf_auto_type %s to skip the timing\n",prefix ? prefix : "",PetscSFAutoCandidates[a->cand[a->selected]].name);CHKERRQ(ierr);
+  }
+  if (a->sf[a->selected]->ops->View) {ierr = (*a->sf[a->selected]->ops->View)(a->sf[a->selected],viewer);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReset_Auto(PetscSF sf)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data;
+  PetscErrorCode ierr;
+  PetscSFAutoOp  link,next;
+  PetscInt       c;
+
+  PetscFunctionBegin;
+  if (a->inuse) SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONGSTATE,"Outstanding operation has not been completed");
+  for (c=0; c<PETSCSF_AUTO_NCANDIDATES; c++) {
+    ierr = PetscSFDestroy(&a->sf[c]);CHKERRQ(ierr);
+    a->ndone[c] = 0;
+    a->best[c]  = 0.0;
+  }
+  for (link=a->avail; link; link=next) {
+    next = link->next;
+    ierr = PetscFree(link);CHKERRQ(ierr);
+  }
+  a->avail    = NULL;
+  a->nbegun   = 0;
+  a->selected = -1;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFDestroy_Auto(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFReset_Auto(sf);CHKERRQ(ierr);
+  ierr = PetscFree(sf->data);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)sf,"PetscSFAutoSetType_C",NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)sf,"PetscSFAutoGetType_C",NULL);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* The duplicate times the candidates again, for its own graph */
+static PetscErrorCode PetscSFDuplicate_Auto(PetscSF sf,PetscSFDuplicateOption opt,PetscSF newsf)
+{
+  PetscSF_Auto   *a = (PetscSF_Auto*)sf->data,*b = (PetscSF_Auto*)newsf->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  b->ncand   = a->ncand;
+  ierr       = PetscMemcpy(b->cand,a->cand,sizeof(a->cand));CHKERRQ(ierr);
+  b->ntrials = a->ntrials;
+  b->options = a->options;
+  PetscFunctionReturn(0);
+}
+
+/*MC
+   PETSCSFAUTO - PetscSF implementation that times the other implementations on the graph and uses the fastest
+
+   At PetscSFSetUp() a PetscSF of each candidate type is created with the graph and set up; the first one finds the
+   ranks referencing the roots of each process and the others reuse them. The operations begun next are given to the
+   candidates in turn and the time spent in their begin and end is measured, until -sf_auto_trials operations per
+   candidate have been timed. The next operation then selects the candidate whose fastest operation is the fastest on the
+   slowest process, which performs all the following operations; this takes one MPI_Allreduce(). The selection is
+   reported by -info and PetscSFView() and can be given to later runs with -sf_auto_type or PetscSFAutoSetType().
+
+   Operations must be begun in the same order on all processes. Broadcasts with an MPI_Op other than MPIU_REPLACE are
+   not given to PETSCSFWINDOW, which does not support them; if it is selected they are performed by another candidate.
+
+   Options Database Keys:
++  -sf_type auto - use this implementation
+.  -sf_auto_candidates <basic,neighbor,shared,window_fence,window_lock,window_active> - transports to time; the window
+                         ones are only timed by default with MPICH, as their tests
+.  -sf_auto_trials <3> - number of timed operations of each candidate
+-  -sf_auto_type <name> - use this transport without timing the candidates, see PetscSFAutoSetType()
+
+   The options of the candidate types, such as -sf_basic_pack_opt or -sf_shared_node_size, apply to the candidates.
+
+   Level: intermediate
+
+.seealso: PetscSFSetType(), PetscSFAutoSetType(), PetscSFAutoGetType(), PETSCSFBASIC, PETSCSFNEIGHBOR, PETSCSFSHARED, PETSCSFWINDOW
+M*/
+
+PETSC_EXTERN PetscErrorCode PetscSFCreate_Auto(PetscSF sf)
+{
+  PetscSF_Auto   *a;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  sf->ops->SetUp           = PetscSFSetUp_Auto;
+  sf->ops->GetRootRanks    = PetscSFGetRootRanks_Auto;
+  sf->ops->SetFromOptions  = PetscSFSetFromOptions_Auto;
+  sf->ops->Reset           = PetscSFReset_Auto;
+  sf->ops->Destroy         = PetscSFDestroy_Auto;
+  sf->ops->View            = PetscSFView_Auto;
+  sf->ops->Duplicate       = PetscSFDuplicate_Auto;
+  sf->ops->BcastAndOpBegin = PetscSFBcastAndOpBegin_Auto;
+  sf->ops->BcastAndOpEnd   = PetscSFBcastAndOpEnd_Auto;
+  sf->ops->ReduceBegin     = PetscSFReduceBegin_Auto;
+  sf->ops->ReduceEnd       = PetscSFReduceEnd_Auto;
+  sf->ops->FetchAndOpBegin = PetscSFFetchAndOpBegin_Auto;
+  sf->ops->FetchAndOpEnd   = PetscSFFetchAndOpEnd_Auto;
+  sf->ops->Progress        = PetscSFProgress_Auto;
+
+  ierr = PetscNewLog(sf,&a);CHKERRQ(ierr);
+  sf->data    = (void*)a;
+  a->ntrials  = 3;
+  a->selected = -1;
+  PetscSFAutoSetDefaultCandidates(a);
+
+  ierr = PetscObjectComposeFunction((PetscObject)sf,"PetscSFAutoSetType_C",PetscSFAutoSetType_Auto);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)sf,"PetscSFAutoGetType_C",PetscSFAutoGetType_Auto);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,214 @@
+#include <../src/vec/is/sf/impls/basic/sfbasic.h> /*I "petscsf.h" I*/
+
+/*
+   PETSCSFNEIGHBOR reuses the setup, the pack buffers and the packing routines of PETSCSFBASIC, the only difference is how
+   the packed buffers are exchanged: instead of one MPI_Isend()/MPI_Irecv() pair per rank on every operation, one
+   neighborhood collective on a distributed graph communicator built once in PetscSFSetUpEnd(). Messages to and from the
+   distinguished rank (this process) are not part of the graph, they go through shared memory as in PETSCSFBASIC.
+*/
+typedef struct {
+  PetscSF_Basic bas;            /* Must be first, the PETSCSFBASIC routines are used on this type */
+  MPI_Comm      comms[2];       /* Distributed graph communicators from roots to leaves (Bcast) and from leaves to roots (Reduce) */
+  PetscMPIInt   *rootcounts;    /* Number of units sent to/received from each non-distinguished incoming rank */
+  PetscMPIInt   *rootdispls;    /* Offset of each of them in the non-distinguished part of the root buffer */
+  PetscMPIInt   *leafcounts;    /* Number of units received from/sent to each non-distinguished rank owning roots */
+  PetscMPIInt   *leafdispls;    /* Offset of each of them in the leaf buffer */
+} PetscSF_Neighbor;
+
+static PetscErrorCode PetscSFSetUpEnd_Neighbor(PetscSF sf)
+{
+  PetscSF_Neighbor  *nbr = (PetscSF_Neighbor*)sf->data;
+  PetscErrorCode    ierr;
+  PetscInt          i,nrootranks,ndrootranks,nleafranks,ndleafranks;
+  const PetscInt    *rootoffset,*leafoffset;
+  const PetscMPIInt *rootranks,*leafranks,*sources,*destinations;
+  PetscMPIInt       indegree,outdegree,*weights,empty[1] = {MPI_PROC_NULL};
+  MPI_Comm          comm;
+
+  PetscFunctionBegin;
+  ierr = PetscSFSetUpEnd_Basic(sf);CHKERRQ(ierr);
+  ierr = PetscObjectGetComm((PetscObject)sf,&comm);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetRootInfo(sf,&nrootranks,&ndrootranks,&rootranks,&rootoffset,NULL);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,&ndleafranks,&leafranks,&leafoffset,NULL);CHKERRQ(ierr);
+  ierr = PetscMPIIntCast(nrootranks-ndrootranks,&outdegree);CHKERRQ(ierr);
+  ierr = PetscMPIIntCast(nleafranks-ndleafranks,&indegree);CHKERRQ(ierr);
+
+  ierr = PetscMalloc4(outdegree,&nbr->rootcounts,outdegree,&nbr->rootdispls,indegree,&nbr->leafcounts,indegree,&nbr->leafdispls);CHKERRQ(ierr);
+  for (i=ndrootranks; i<nrootranks; i++) {
+    ierr = PetscMPIIntCast(rootoffset[i+1]-rootoffset[i],&nbr->rootcounts[i-ndrootranks]);CHKERRQ(ierr);
+    ierr = PetscMPIIntCast(rootoffset[i]-rootoffset[ndrootranks],&nbr->rootdispls[i-ndrootranks]);CHKERRQ(ierr);
+  }
+  for (i=ndleafranks; i<nleafranks; i++) {
+    ierr = PetscMPIIntCast(leafoffset[i+1]-leafoffset[i],&nbr->leafcounts[i-ndleafranks]);CHKERRQ(ierr);
+    ierr = PetscMPIIntCast(leafoffset[i]-leafoffset[ndleafranks],&nbr->leafdispls[i-ndleafranks]);CHKERRQ(ierr);
+  }
+
+  /* roots send to the ranks that reference them and leaves receive from the ranks that own their roots, and conversely.
+     Only real arrays are passed, also with no neighbors: a dummy rank list rather than an empty one, and unit weights
+     rather than MPI_UNWEIGHTED or MPI_WEIGHTS_EMPTY, which Open MPI defines as sentinel pointers that gcc -O2 reports
+     as out of bounds reads. The weights are only a hint for reordering, which is not requested. */
+  ierr = PetscMalloc1(PetscMax(PetscMax(indegree,outdegree),1),&weights);CHKERRQ(ierr);
+  for (i=0; i<PetscMax(PetscMax(indegree,outdegree),1); i++) weights[i] = 1;
+  sources      = indegree  ? leafranks+ndleafranks : empty;
+  destinations = outdegree ? rootranks+ndrootranks : empty;
+  ierr = MPI_Dist_graph_create_adjacent(comm,indegree,sources,weights,outdegree,destinations,weights,MPI_INFO_NULL,0,&nbr->comms[0]);CHKERRQ(ierr);
+  ierr = MPI_Dist_graph_create_adjacent(comm,outdegree,destinations,weights,indegree,sources,weights,MPI_INFO_NULL,0,&nbr->comms[1]);CHKERRQ(ierr);
+  ierr = PetscFree(weights);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReset_Neighbor(PetscSF sf)
+{
+  PetscSF_Neighbor *nbr = (PetscSF_Neighbor*)sf->data;
+  PetscErrorCode   ierr;
+  PetscInt         i;
+
+  PetscFunctionBegin;
+  for (i=0; i<2; i++) {
+    if (nbr->comms[i] != MPI_COMM_NULL) {ierr = MPI_Comm_free(&nbr->comms[i]);CHKERRQ(ierr);}
+  }
+  ierr = PetscFree4(nbr->rootcounts,nbr->rootdispls,nbr->leafcounts,nbr->leafdispls);CHKERRQ(ierr);
+  ierr = PetscSFReset_Basic(sf);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFDestroy_Neighbor(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFReset_Neighbor(sf);CHKERRQ(ierr);
+  ierr = PetscFree(sf->data);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Starts the exchange of the packed buffers of link in direction dir, 0 from roots to leaves and 1 from leaves to roots.
+   With MPI-4 the neighborhood collective is a persistent request created the first time the link is used, since the
+   buffers of a link never change.
+*/
+static PetscErrorCode PetscSFNeighborStart(PetscSF sf,PetscSFBasicPack link,PetscInt dir)
+{
+  PetscSF_Neighbor *nbr = (PetscSF_Neighbor*)sf->data;
+  PetscErrorCode   ierr;
+  PetscInt         nrootranks,ndrootranks;
+  const PetscInt   *rootoffset;
+  char             *rootbuf;
+
+  PetscFunctionBegin;
+  ierr    = PetscSFBasicGetRootInfo(sf,&nrootranks,&ndrootranks,NULL,&rootoffset,NULL);CHKERRQ(ierr);
+  rootbuf = link->rootbuf + rootoffset[ndrootranks]*link->unitbytes; /* skip the distinguished rank */
+#if defined(PETSC_HAVE_MPI_PERSISTENT_NEIGHBORHOOD_COLLECTIVES)
+  if (link->nbrreq[dir] == MPI_REQUEST_NULL) {
+    if (!dir) {
+      ierr = MPI_Neighbor_alltoallv_init(rootbuf,nbr->rootcounts,nbr->rootdispls,link->unit,link->leafbuf,nbr->leafcounts,nbr->leafdispls,link->unit,nbr->comms[0],MPI_INFO_NULL,&link->nbrreq[0]);CHKERRQ(ierr);
+    } else {
+      ierr = MPI_Neighbor_alltoallv_init(link->leafbuf,nbr->leafcounts,nbr->leafdispls,link->unit,rootbuf,nbr->rootcounts,nbr->rootdispls,link->unit,nbr->comms[1],MPI_INFO_NULL,&link->nbrreq[1]);CHKERRQ(ierr);
+    }
+  }
+  ierr = MPI_Start(&link->nbrreq[dir]);CHKERRQ(ierr);
+#else
+  if (!dir) {
+    ierr = MPI_Ineighbor_alltoallv(rootbuf,nbr->rootcounts,nbr->rootdispls,link->unit,link->leafbuf,nbr->leafcounts,nbr->leafdispls,link->unit,nbr->comms[0],&link->nbrreq[0]);CHKERRQ(ierr);
+  } else {
+    ierr = MPI_Ineighbor_alltoallv(link->leafbuf,nbr->leafcounts,nbr->leafdispls,link->unit,rootbuf,nbr->rootcounts,nbr->rootdispls,link->unit,nbr->comms[1],&link->nbrreq[1]);CHKERRQ(ierr);
+  }
+#endif
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBcastAndOpBegin_Neighbor(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetPack(sf,unit,rootdata,&link);CHKERRQ(ierr);
+  ierr = PetscSFBasicPackRootData(sf,link,rootdata);CHKERRQ(ierr);
+  ierr = PetscSFNeighborStart(sf,link,0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBcastAndOpEnd_Neighbor(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetPackInUse(sf,unit,rootdata,PETSC_OWN_POINTER,&link);CHKERRQ(ierr);
+  ierr = MPI_Wait(&link->nbrreq[0],MPI_STATUS_IGNORE);CHKERRQ(ierr);
+  ierr = PetscSFBasicUnpackLeafData(sf,link,unit,leafdata,op);CHKERRQ(ierr);
+  ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReduceBegin_Neighbor(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetPack(sf,unit,rootdata,&link);CHKERRQ(ierr);
+  ierr = PetscSFBasicPackLeafData(sf,link,leafdata);CHKERRQ(ierr);
+  ierr = PetscSFNeighborStart(sf,link,1);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReduceEnd_Neighbor(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetPackInUse(sf,unit,rootdata,PETSC_OWN_POINTER,&link);CHKERRQ(ierr);
+  ierr = MPI_Wait(&link->nbrreq[1],MPI_STATUS_IGNORE);CHKERRQ(ierr);
+  ierr = PetscSFBasicUnpackRootData(sf,link,unit,rootdata,op);CHKERRQ(ierr);
+  ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*MC
+   PETSCSFNEIGHBOR - PetscSF implementation with MPI-3 neighborhood collectives
+
+   The graph of the ranks that communicate is given to MPI once, in PetscSFSetUp(), as a distributed graph
+   communicator; each PetscSFBcastBegin() and PetscSFReduceBegin() then packs the data as PETSCSFBASIC does and starts a
+   single MPI_Ineighbor_alltoallv() instead of one MPI_Isend() and MPI_Irecv() per rank. When the MPI library provides
+   the MPI-4 persistent neighborhood collectives the exchange is set up once per data type and only restarted.
+   PetscSFFetchAndOpBegin() uses the PETSCSFBASIC implementation.
+
+   Options Database Keys:
+.  -sf_type neighbor - use this implementation
+
+   Level: intermediate
+
+.seealso: PetscSFSetType(), PETSCSFBASIC, PETSCSFWINDOW
+M*/
+
+PETSC_EXTERN PetscErrorCode PetscSFCreate_Neighbor(PetscSF sf)
+{
+  PetscSF_Neighbor *nbr;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  sf->ops->SetUpBegin      = PetscSFSetUpBegin_Basic;
+  sf->ops->SetUpEnd        = PetscSFSetUpEnd_Neighbor;
+  sf->ops->GetRootRanks    = PetscSFBasicGetRootInfo;
+  sf->ops->SetFromOptions  = PetscSFSetFromOptions_Basic;
+  sf->ops->Reset           = PetscSFReset_Neighbor;
+  sf->ops->Destroy         = PetscSFDestroy_Neighbor;
+  sf->ops->View            = PetscSFView_Basic;
+  sf->ops->BcastAndOpBegin = PetscSFBcastAndOpBegin_Neighbor;
+  sf->ops->BcastAndOpEnd   = PetscSFBcastAndOpEnd_Neighbor;
+  sf->ops->ReduceBegin     = PetscSFReduceBegin_Neighbor;
+  sf->ops->ReduceEnd       = PetscSFReduceEnd_Neighbor;
+  sf->ops->FetchAndOpBegin = PetscSFFetchAndOpBegin_Basic;
+  sf->ops->FetchAndOpEnd   = PetscSFFetchAndOpEnd_Basic;
+  sf->ops->Progress        = PetscSFProgress_Basic;
+
+  ierr = PetscNewLog(sf,&nbr);CHKERRQ(ierr);
+  nbr->bas.usepackopt = PETSC_TRUE;
+  nbr->comms[0]       = MPI_COMM_NULL;
+  nbr->comms[1]       = MPI_COMM_NULL;
+  sf->data            = (void*)nbr;
+  PetscFunctionReturn(0);
+}
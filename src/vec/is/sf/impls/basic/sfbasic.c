@@ -1,57 +1,7 @@
 
 #include <petsc/private/sfimpl.h> /*I "petscsf.h" I*/
 
-typedef struct _n_PetscSFBasicPack *PetscSFBasicPack;
-struct _n_PetscSFBasicPack {
-  void (*Pack)(PetscInt,PetscInt,const PetscInt*,const void*,void*);
-  void (*UnpackInsert)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackAdd)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMin)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMax)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMinloc)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMaxloc)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMult)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
-  void (*UnpackLAND)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
-  void (*UnpackBAND)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
-  void (*UnpackLOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
-  void (*UnpackBOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
-  void (*UnpackLXOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
-  void (*UnpackBXOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
-  void (*FetchAndInsert)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndAdd)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMin)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMax)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMinloc)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMaxloc)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMult)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndLAND)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndBAND)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndLOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndBOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndLXOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndBXOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
-
-  MPI_Datatype     unit;
-  size_t           unitbytes;   /* Number of bytes in a unit */
-  PetscInt         bs;          /* Number of basic units in a unit */
-  const void       *key;        /* Array used as key for operation */
-  char             **root;      /* Packed root data, indexed by leaf rank */
-  char             **leaf;      /* Packed leaf data, indexed by root rank */
-  MPI_Request      *requests;   /* Array of root requests followed by leaf requests */
-  PetscSFBasicPack next;
-};
-
-typedef struct {
-  PetscMPIInt      tag;
-  PetscMPIInt      niranks;     /* Number of incoming ranks (ranks accessing my roots) */
-  PetscMPIInt      ndiranks;    /* Number of incoming ranks (ranks accessing my roots) in distinguished set */
-  PetscMPIInt      *iranks;     /* Array of ranks that reference my roots */
-  PetscInt         itotal;      /* Total number of graph edges referencing my roots */
-  PetscInt         *ioffset;    /* Array of length niranks+1 holding offset in irootloc[] for each rank */
-  PetscInt         *irootloc;   /* Incoming roots referenced by ranks starting at ioffset[rank] */
-  PetscSFBasicPack avail;       /* One or more entries per MPI Datatype, lazily constructed */
-  PetscSFBasicPack inuse;       /* Buffers being used for transactions that have not yet completed */
-} PetscSF_Basic;
+#include <../src/vec/is/sf/impls/basic/sfbasic.h>
 
 #if !defined(PETSC_HAVE_MPI_TYPE_DUP)
 PETSC_STATIC_INLINE int MPI_Type_dup(MPI_Datatype datatype,MPI_Datatype *newtype)
@@ -531,15 +481,184 @@ DEF_Block(int,6)
 DEF_Block(int,7)
 DEF_Block(int,8)
 
-static PetscErrorCode PetscSFSetUp_Basic(PetscSF sf)
+/* Find whether the n indices idx[] form a subblock with rows of at least two units, see PetscSFBasicPackOpt */
+static PetscErrorCode PetscSFBasicDetectBlock(PetscInt n,const PetscInt *idx,PetscSFBasicPackOpt *opt,PetscInt r)
 {
-  PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
+  PetscInt start,dx,dy,dz,X,Y,i,j,k;
+
+  PetscFunctionBegin;
+  opt->isblock[r] = PETSC_FALSE;
+  if (!n) {
+    opt->isblock[r] = PETSC_TRUE;
+    opt->start[r] = 0; opt->dx[r] = 0; opt->dy[r] = 1; opt->dz[r] = 1; opt->X[r] = 0; opt->Y[r] = 1;
+    PetscFunctionReturn(0);
+  }
+  start = idx[0];
+  for (dx=1; dx<n && idx[dx] == start+dx; dx++) ;
+  /* rows of a single unit are left to the indexed kernels, which are faster than one memcpy() per unit */
+  if (dx < n && (dx < 2 || n%dx)) PetscFunctionReturn(0);
+  X = dx < n ? idx[dx]-start : dx;
+  if (X < dx) PetscFunctionReturn(0);
+  for (dy=1; dx*dy<n && idx[dx*dy] == start+dy*X; dy++) ;
+  if (n%(dx*dy)) PetscFunctionReturn(0);
+  dz = n/(dx*dy);
+  Y  = dy;
+  if (dz > 1) {
+    if ((idx[dx*dy]-start)%X) PetscFunctionReturn(0);
+    Y = (idx[dx*dy]-start)/X;
+    if (Y < dy) PetscFunctionReturn(0);
+  }
+  for (k=0; k<dz; k++) {
+    for (j=0; j<dy; j++) {
+      for (i=0; i<dx; i++) {
+        if (idx[(k*dy+j)*dx+i] != start+i+X*(j+Y*k)) PetscFunctionReturn(0);
+      }
+    }
+  }
+  opt->isblock[r] = PETSC_TRUE;
+  opt->start[r] = start; opt->dx[r] = dx; opt->dy[r] = dy; opt->dz[r] = dz; opt->X[r] = X; opt->Y[r] = Y;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBasicPackOptCreate(PetscInt nranks,const PetscInt *offset,const PetscInt *idx,PetscSFBasicPackOpt *opt)
+{
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc7(nranks,&opt->isblock,nranks,&opt->start,nranks,&opt->dx,nranks,&opt->dy,nranks,&opt->dz,nranks,&opt->X,nranks,&opt->Y);CHKERRQ(ierr);
+  for (i=0; i<nranks; i++) {ierr = PetscSFBasicDetectBlock(offset[i+1]-offset[i],idx+offset[i],opt,i);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBasicPackOptDestroy(PetscSFBasicPackOpt *opt)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree7(opt->isblock,opt->start,opt->dx,opt->dy,opt->dz,opt->X,opt->Y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PETSC_STATIC_INLINE PetscBool PetscSFBasicPackOptIsContig(const PetscSFBasicPackOpt *opt,PetscInt r)
+{
+  return (PetscBool)(opt->isblock && opt->isblock[r] && opt->dy[r] == 1 && opt->dz[r] == 1);
+}
+
+#define PETSCSF_BASIC_THREAD_MINSIZE 1024 /* Ranks referencing fewer roots are unpacked by one thread */
+
+/* Sort the roots of each rank and split them among the threads at root boundaries, in pieces of similar length */
+static PetscErrorCode PetscSFBasicThreadPlanCreate(PetscInt nranks,const PetscInt *offset,const PetscInt *idx,PetscSFBasicThreadPlan *plan)
+{
+  PetscErrorCode ierr;
+  PetscInt       r,i,j,t,nt = plan->nthreads,*tstart;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc3(offset[nranks],&plan->idx,offset[nranks],&plan->perm,nranks*(nt+1),&plan->tstart);CHKERRQ(ierr);
+  ierr = PetscMemcpy(plan->idx,idx,offset[nranks]*sizeof(PetscInt));CHKERRQ(ierr);
+  for (r=0; r<nranks; r++) {
+    PetscInt n = offset[r+1]-offset[r],*ridx = plan->idx+offset[r],*rperm = plan->perm+offset[r];
+    for (i=0; i<n; i++) rperm[i] = i;
+    ierr = PetscSortIntWithArray(n,ridx,rperm);CHKERRQ(ierr);
+    for (i=0; i<n; i=j) { /* Keep the packing order of repeated roots */
+      for (j=i+1; j<n && ridx[j] == ridx[i]; j++) ;
+      ierr = PetscSortInt(j-i,rperm+i);CHKERRQ(ierr);
+    }
+    tstart = plan->tstart + r*(nt+1);
+    for (t=0; t<nt; t++) {
+      i = PetscMax(t ? tstart[t-1] : 0,(PetscInt)(((PetscInt64)n*t)/nt));
+      while (i > 0 && i < n && ridx[i] == ridx[i-1]) i++;
+      tstart[t] = i;
+    }
+    tstart[nt] = n;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBasicThreadPlanDestroy(PetscSFBasicThreadPlan *plan)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree3(plan->idx,plan->perm,plan->tstart);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Called by PetscCommBuildTwoSidedFReq() for each root rank, sends the roots referenced by my leaves */
+static PetscErrorCode PetscSFSetUpSend_Basic(MPI_Comm comm,const PetscMPIInt tag[],PetscMPIInt rankid,PetscMPIInt rank,void *sdata,MPI_Request req[],void *ctx)
+{
+  PetscSF        sf = (PetscSF)ctx;
+  PetscInt       i  = sf->ndranks + rankid;
+  PetscMPIInt    npoints;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (rank != sf->ranks[i]) SETERRQ3(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Setup send rank %d does not match sf->ranks[%D] %d",rank,i,sf->ranks[i]);
+  ierr = PetscMPIIntCast(sf->roffset[i+1]-sf->roffset[i],&npoints);CHKERRQ(ierr);
+  ierr = MPI_Isend(sf->rremote+sf->roffset[i],npoints,MPIU_INT,rank,tag[0],comm,&req[0]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Called by PetscCommBuildTwoSidedFReq() for each incoming rank, in the order of the incoming ranks, receives the roots it references */
+static PetscErrorCode PetscSFSetUpRecv_Basic(MPI_Comm comm,const PetscMPIInt tag[],PetscMPIInt rank,void *rdata,MPI_Request req[],void *ctx)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)((PetscSF)ctx)->data;
+  PetscInt       *buf;
+  PetscMPIInt    npoints;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMPIIntCast(*(PetscInt*)rdata,&npoints);CHKERRQ(ierr);
+  ierr = PetscSegBufferGetInts(bas->setupseg,npoints,&buf);CHKERRQ(ierr);
+  ierr = MPI_Irecv(buf,npoints,MPIU_INT,rank,tag[0],comm,&req[0]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Sets the incoming ranks of a setup with known incoming ranks, the distinguished one being this process */
+static PetscErrorCode PetscSFSetUpKnownRanks_Basic(PetscSF sf,PetscMPIInt nk,const PetscMPIInt *kranks)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
+  PetscMPIInt    rank;
+  PetscInt       i;
   PetscErrorCode ierr;
-  PetscInt *rlengths,*ilengths,i;
-  PetscMPIInt rank,niranks,*iranks;
-  MPI_Comm comm;
-  MPI_Group group;
-  MPI_Request *rootreqs,*leafreqs;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_rank(PetscObjectComm((PetscObject)sf),&rank);CHKERRQ(ierr);
+  bas->niranks = bas->ndiranks + nk;
+  ierr = PetscMalloc2(bas->niranks,&bas->iranks,bas->niranks+1,&bas->ioffset);CHKERRQ(ierr);
+  bas->ioffset[0] = 0;
+  if (bas->ndiranks) {
+    bas->iranks[0]  = rank;
+    bas->ioffset[1] = sf->roffset[sf->ndranks];
+  }
+  for (i=0; i<nk; i++) {
+    if (kranks[i] == rank) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Known incoming ranks must not contain this process");
+    bas->iranks[bas->ndiranks+i] = kranks[i];
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   The incoming ranks and the roots they reference are found in one of three ways:
+
+   - known from the PetscSF this one was derived from (sf->koffset set), nothing is communicated;
+   - incoming ranks known (sf->nkranks >= 0), or derived during the setup of a PetscSF created by PetscSFCompose(),
+     lengths and roots are exchanged with them and the root ranks;
+   - otherwise discovered by PetscCommBuildTwoSidedFReq(), whose rendezvous carries the lengths.
+
+   In the last two cases the roots are received in PetscSFSetUpEnd_Basic().
+*/
+PetscErrorCode PetscSFSetUpBegin_Basic(PetscSF sf)
+{
+  PetscSF_Basic     *bas = (PetscSF_Basic*)sf->data;
+  PetscErrorCode    ierr;
+  PetscInt          *rlengths,*ilengths,*buf,i,nd;
+  PetscMPIInt       rank,niranks,*iranks,nto,nk;
+  const PetscMPIInt *kranks;
+  const PetscInt    *koffset,*kroots;
+  PetscBool         known;
+  MPI_Comm          comm;
+  MPI_Group         group;
 
   PetscFunctionBegin;
   ierr = MPI_Comm_group(PETSC_COMM_SELF,&group);CHKERRQ(ierr);
@@ -548,60 +667,129 @@ static PetscErrorCode PetscSFSetUp_Basic(PetscSF sf)
   ierr = PetscObjectGetComm((PetscObject)sf,&comm);CHKERRQ(ierr);
   ierr = PetscObjectGetNewTag((PetscObject)sf,&bas->tag);CHKERRQ(ierr);
   ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
-  /*
-   * Inform roots about how many leaves and from which ranks
-   */
-  ierr = PetscMalloc1(sf->nranks,&rlengths);CHKERRQ(ierr);
-  /* Determine number, sending ranks, and length of incoming */
-  for (i=0; i<sf->nranks; i++) {
-    rlengths[i] = sf->roffset[i+1] - sf->roffset[i]; /* Number of roots referenced by my leaves; for rank sf->ranks[i] */
-  }
-  ierr = PetscCommBuildTwoSided(comm,1,MPIU_INT,sf->nranks-sf->ndranks,sf->ranks+sf->ndranks,rlengths+sf->ndranks,&niranks,&iranks,(void**)&ilengths);CHKERRQ(ierr);
+  if (sf->ndranks > 1 || (sf->ndranks == 1 && sf->ranks[0] != rank)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Broken setup for shared ranks");
+  nd  = sf->roffset[sf->ndranks]; /* Number of my leaves referencing my roots */
+  nto = sf->nranks - sf->ndranks;
 
-  /* Partition into distinguished and non-distinguished incoming ranks */
+  /* The distinguished incoming rank is this process, the roots it references are known locally */
   bas->ndiranks = sf->ndranks;
+  ierr = PetscSFGetKnownRootRanksBegin_Private(sf,&known);CHKERRQ(ierr); /* begins deriving sf->kranks[] of a composed PetscSF */
+  if (known && sf->koffset) {
+    ierr = PetscSFGetKnownRootRanksEnd_Private(sf,&nk,&kranks,&koffset,&kroots);CHKERRQ(ierr);
+    ierr = PetscSFSetUpKnownRanks_Basic(sf,nk,kranks);CHKERRQ(ierr);
+    for (i=0; i<nk; i++) bas->ioffset[bas->ndiranks+i+1] = nd + koffset[i+1];
+    bas->itotal = bas->ioffset[bas->niranks];
+    ierr = PetscMalloc1(bas->itotal,&bas->irootloc);CHKERRQ(ierr);
+    ierr = PetscMemcpy(bas->irootloc,sf->rremote,nd*sizeof(PetscInt));CHKERRQ(ierr);
+    ierr = PetscMemcpy(bas->irootloc+nd,kroots,koffset[nk]*sizeof(PetscInt));CHKERRQ(ierr);
+    ierr = PetscInfo1(sf,"Using the roots referenced by %d known incoming ranks\n",nk);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (known) {
+    /* Send lengths and roots to the root ranks, the incoming ranks send theirs once they are known */
+    ierr = PetscMalloc1(nto,&bas->setuplengths);CHKERRQ(ierr);
+    ierr = PetscMalloc1(2*nto,&bas->setupreqs[1]);CHKERRQ(ierr);
+    for (i=0; i<nto; i++) {
+      PetscMPIInt npoints;
+      bas->setuplengths[i] = sf->roffset[sf->ndranks+i+1] - sf->roffset[sf->ndranks+i];
+      ierr = PetscMPIIntCast(bas->setuplengths[i],&npoints);CHKERRQ(ierr);
+      ierr = MPI_Isend(bas->setuplengths+i,1,MPIU_INT,sf->ranks[sf->ndranks+i],bas->tag,comm,&bas->setupreqs[1][2*i]);CHKERRQ(ierr);
+      ierr = MPI_Isend(sf->rremote+sf->roffset[sf->ndranks+i],npoints,MPIU_INT,sf->ranks[sf->ndranks+i],bas->tag,comm,&bas->setupreqs[1][2*i+1]);CHKERRQ(ierr);
+    }
+    bas->setupknown = PETSC_TRUE;
+    PetscFunctionReturn(0);
+  }
+
+  /* Inform roots about how many leaves and from which ranks, the roots are received into setupseg in the order of the incoming ranks */
+  ierr = PetscMalloc1(nto,&rlengths);CHKERRQ(ierr);
+  for (i=0; i<nto; i++) rlengths[i] = sf->roffset[sf->ndranks+i+1] - sf->roffset[sf->ndranks+i];
+  ierr = PetscSegBufferCreate(sizeof(PetscInt),PetscMax(sf->nleaves,1),&bas->setupseg);CHKERRQ(ierr);
+  ierr = PetscSegBufferGetInts(bas->setupseg,nd,&buf);CHKERRQ(ierr);
+  ierr = PetscMemcpy(buf,sf->rremote,nd*sizeof(PetscInt));CHKERRQ(ierr);
+  ierr = PetscCommBuildTwoSidedFReq(comm,1,MPIU_INT,nto,sf->ranks+sf->ndranks,rlengths,&niranks,&iranks,&ilengths,1,&bas->setupreqs[1],&bas->setupreqs[0],
+                                    PetscSFSetUpSend_Basic,PetscSFSetUpRecv_Basic,sf);CHKERRQ(ierr);
   bas->niranks = bas->ndiranks + niranks;
   ierr = PetscMalloc2(bas->niranks,&bas->iranks,bas->niranks+1,&bas->ioffset);CHKERRQ(ierr);
   bas->ioffset[0] = 0;
-  for (i=0; i<bas->ndiranks; i++) {
-    bas->iranks[i] = sf->ranks[i];
-    bas->ioffset[i+1] = bas->ioffset[i] + rlengths[i];
+  if (bas->ndiranks) {
+    bas->iranks[0]  = rank;
+    bas->ioffset[1] = nd;
   }
-  if (bas->ndiranks > 1 || (bas->ndiranks == 1 && bas->iranks[0] != rank)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Broken setup for shared ranks");
-  for ( ; i<bas->niranks; i++) {
-    bas->iranks[i] = iranks[i-bas->ndiranks];
+  for (i=bas->ndiranks; i<bas->niranks; i++) {
+    bas->iranks[i]    = iranks[i-bas->ndiranks];
     bas->ioffset[i+1] = bas->ioffset[i] + ilengths[i-bas->ndiranks];
   }
-  bas->itotal = bas->ioffset[i];
+  bas->itotal = bas->ioffset[bas->niranks];
   ierr = PetscFree(rlengths);CHKERRQ(ierr);
   ierr = PetscFree(iranks);CHKERRQ(ierr);
   ierr = PetscFree(ilengths);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
 
-  /* Send leaf identities to roots */
-  ierr = PetscMalloc1(bas->itotal,&bas->irootloc);CHKERRQ(ierr);
-  ierr = PetscMalloc2(bas->niranks-bas->ndiranks,&rootreqs,sf->nranks-sf->ndranks,&leafreqs);CHKERRQ(ierr);
-  for (i=bas->ndiranks; i<bas->niranks; i++) {
-    ierr = MPI_Irecv(bas->irootloc+bas->ioffset[i],bas->ioffset[i+1]-bas->ioffset[i],MPIU_INT,bas->iranks[i],bas->tag,comm,&rootreqs[i-bas->ndiranks]);CHKERRQ(ierr);
-  }
-  for (i=0; i<sf->nranks; i++) {
-    PetscMPIInt npoints;
-    ierr = PetscMPIIntCast(sf->roffset[i+1] - sf->roffset[i],&npoints);CHKERRQ(ierr);
-    if (i < sf->ndranks) {
-      if (sf->ranks[i] != rank) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Cannot interpret distinguished leaf rank");
-      if (bas->iranks[0] != rank) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Cannot interpret distinguished root rank");
-      if (npoints != bas->ioffset[1]-bas->ioffset[0]) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Distinguished rank exchange has mismatched lengths");
-      ierr = PetscMemcpy(bas->irootloc+bas->ioffset[0],sf->rremote+sf->roffset[i],npoints*sizeof(bas->irootloc[0]));CHKERRQ(ierr);
-      continue;
+PetscErrorCode PetscSFSetUpEnd_Basic(PetscSF sf)
+{
+  PetscSF_Basic     *bas = (PetscSF_Basic*)sf->data;
+  PetscErrorCode    ierr;
+  PetscInt          i,*ilengths,nto = sf->nranks - sf->ndranks;
+  PetscMPIInt       nk;
+  const PetscMPIInt *kranks;
+  MPI_Comm          comm;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectGetComm((PetscObject)sf,&comm);CHKERRQ(ierr);
+  if (bas->setupseg) {
+    ierr = MPI_Waitall(bas->niranks-bas->ndiranks,bas->setupreqs[0],MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+    ierr = MPI_Waitall(nto,bas->setupreqs[1],MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+    ierr = PetscSegBufferExtractAlloc(bas->setupseg,&bas->irootloc);CHKERRQ(ierr);
+    ierr = PetscSegBufferDestroy(&bas->setupseg);CHKERRQ(ierr);
+  } else if (bas->setupknown) {
+    /* Completes the derivation of the incoming ranks of a composed PetscSF, then receives the lengths and roots */
+    ierr = PetscSFGetKnownRootRanksEnd_Private(sf,&nk,&kranks,NULL,NULL);CHKERRQ(ierr);
+    ierr = PetscSFSetUpKnownRanks_Basic(sf,nk,kranks);CHKERRQ(ierr);
+    ierr = PetscMalloc1(nk,&ilengths);CHKERRQ(ierr);
+    ierr = PetscMalloc1(nk,&bas->setupreqs[0]);CHKERRQ(ierr);
+    for (i=0; i<nk; i++) {
+      ierr = MPI_Irecv(ilengths+i,1,MPIU_INT,kranks[i],bas->tag,comm,&bas->setupreqs[0][i]);CHKERRQ(ierr);
     }
-    ierr = MPI_Isend(sf->rremote+sf->roffset[i],npoints,MPIU_INT,sf->ranks[i],bas->tag,comm,&leafreqs[i-sf->ndranks]);CHKERRQ(ierr);
+    ierr = MPI_Waitall(nk,bas->setupreqs[0],MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+    for (i=bas->ndiranks; i<bas->niranks; i++) bas->ioffset[i+1] = bas->ioffset[i] + ilengths[i-bas->ndiranks];
+    bas->itotal = bas->ioffset[bas->niranks];
+    ierr = PetscMalloc1(bas->itotal,&bas->irootloc);CHKERRQ(ierr);
+    ierr = PetscMemcpy(bas->irootloc,sf->rremote,bas->ioffset[bas->ndiranks]*sizeof(PetscInt));CHKERRQ(ierr);
+    for (i=bas->ndiranks; i<bas->niranks; i++) {
+      PetscMPIInt npoints;
+      ierr = PetscMPIIntCast(bas->ioffset[i+1]-bas->ioffset[i],&npoints);CHKERRQ(ierr);
+      ierr = MPI_Irecv(bas->irootloc+bas->ioffset[i],npoints,MPIU_INT,bas->iranks[i],bas->tag,comm,&bas->setupreqs[0][i-bas->ndiranks]);CHKERRQ(ierr);
+    }
+    ierr = MPI_Waitall(nk,bas->setupreqs[0],MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+    ierr = MPI_Waitall(2*nto,bas->setupreqs[1],MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+    ierr = PetscFree(ilengths);CHKERRQ(ierr);
+    ierr = PetscFree(bas->setuplengths);CHKERRQ(ierr);
+    ierr = PetscInfo1(sf,"Using %d known incoming ranks\n",nk);CHKERRQ(ierr);
+    bas->setupknown = PETSC_FALSE;
   }
-  ierr = MPI_Waitall(bas->niranks-bas->ndiranks,rootreqs,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
-  ierr = MPI_Waitall(sf->nranks-sf->ndranks,leafreqs,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
-  ierr = PetscFree2(rootreqs,leafreqs);CHKERRQ(ierr);
+  ierr = PetscFree(bas->setupreqs[0]);CHKERRQ(ierr);
+  ierr = PetscFree(bas->setupreqs[1]);CHKERRQ(ierr);
+
+  if (bas->usepackopt) {
+    ierr = PetscSFBasicPackOptCreate(bas->niranks,bas->ioffset,bas->irootloc,&bas->rootopt);CHKERRQ(ierr);
+    ierr = PetscSFBasicPackOptCreate(sf->nranks,sf->roffset,sf->rmine,&bas->leafopt);CHKERRQ(ierr);
+  }
+  if (bas->rootplan.nthreads > 1) {ierr = PetscSFBasicThreadPlanCreate(bas->niranks,bas->ioffset,bas->irootloc,&bas->rootplan);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode PetscSFSetUp_Basic(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFSetUpBegin_Basic(sf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd_Basic(sf);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFBasicPackTypeSetup(PetscSFBasicPack link,MPI_Datatype unit)
+PetscErrorCode PetscSFBasicPackTypeSetup(PetscSFBasicPack link,MPI_Datatype unit)
 {
   PetscErrorCode ierr;
   PetscBool      isInt,isPetscInt,isPetscReal,is2Int,is2PetscInt;
@@ -682,7 +870,7 @@ static PetscErrorCode PetscSFBasicPackTypeSetup(PetscSFBasicPack link,MPI_Dataty
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFBasicPackGetUnpackOp(PetscSF sf,PetscSFBasicPack link,MPI_Op op,void (**UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*))
+PetscErrorCode PetscSFBasicPackGetUnpackOp(PetscSF sf,PetscSFBasicPack link,MPI_Op op,void (**UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*))
 {
   PetscFunctionBegin;
   *UnpackOp = NULL;
@@ -743,7 +931,7 @@ static PetscErrorCode PetscSFBasicPackWaitall(PetscSF sf,PetscSFBasicPack link)
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFBasicGetRootInfo(PetscSF sf,PetscInt *nrootranks,PetscInt *ndrootranks,const PetscMPIInt **rootranks,const PetscInt **rootoffset,const PetscInt **rootloc)
+PetscErrorCode PetscSFBasicGetRootInfo(PetscSF sf,PetscInt *nrootranks,PetscInt *ndrootranks,const PetscMPIInt **rootranks,const PetscInt **rootoffset,const PetscInt **rootloc)
 {
   PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
 
@@ -756,7 +944,7 @@ static PetscErrorCode PetscSFBasicGetRootInfo(PetscSF sf,PetscInt *nrootranks,Pe
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF sf,PetscInt *nleafranks,PetscInt *ndleafranks,const PetscMPIInt **leafranks,const PetscInt **leafoffset,const PetscInt **leafloc)
+PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF sf,PetscInt *nleafranks,PetscInt *ndleafranks,const PetscMPIInt **leafranks,const PetscInt **leafoffset,const PetscInt **leafloc)
 {
   PetscFunctionBegin;
   if (nleafranks)  *nleafranks  = sf->nranks;
@@ -767,7 +955,7 @@ static PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF sf,PetscInt *nleafranks,Pe
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFBasicGetPack(PetscSF sf,MPI_Datatype unit,const void *key,PetscSFBasicPack *mylink)
+PetscErrorCode PetscSFBasicGetPack(PetscSF sf,MPI_Datatype unit,const void *key,PetscSFBasicPack *mylink)
 {
   PetscSF_Basic    *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode   ierr;
@@ -792,21 +980,25 @@ static PetscErrorCode PetscSFBasicGetPack(PetscSF sf,MPI_Datatype unit,const voi
   ierr = PetscNew(&link);CHKERRQ(ierr);
   ierr = PetscSFBasicPackTypeSetup(link,unit);CHKERRQ(ierr);
   ierr = PetscMalloc2(nrootranks,&link->root,nleafranks,&link->leaf);CHKERRQ(ierr);
-  for (i=0; i<nrootranks; i++) {
-    ierr = PetscMalloc((rootoffset[i+1]-rootoffset[i])*link->unitbytes,&link->root[i]);CHKERRQ(ierr);
-  }
+  ierr = PetscMalloc(rootoffset[nrootranks]*link->unitbytes,&link->rootbuf);CHKERRQ(ierr);
+  ierr = PetscMalloc((leafoffset[nleafranks]-leafoffset[ndleafranks])*link->unitbytes,&link->leafbuf);CHKERRQ(ierr);
+  for (i=0; i<nrootranks; i++) link->root[i] = link->rootbuf + rootoffset[i]*link->unitbytes;
   for (i=0; i<nleafranks; i++) {
     if (i < ndleafranks) {      /* Leaf buffers for distinguished ranks are pointers directly into root buffers */
       if (ndrootranks != 1) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Cannot match distinguished ranks");
       link->leaf[i] = link->root[0];
       continue;
     }
-    ierr = PetscMalloc((leafoffset[i+1]-leafoffset[i])*link->unitbytes,&link->leaf[i]);CHKERRQ(ierr);
+    link->leaf[i] = link->leafbuf + (leafoffset[i]-leafoffset[ndleafranks])*link->unitbytes;
   }
-  ierr = PetscCalloc1(nrootranks+nleafranks,&link->requests);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nrootranks+nleafranks,&link->requests);CHKERRQ(ierr);
+  for (i=0; i<nrootranks+nleafranks; i++) link->requests[i] = MPI_REQUEST_NULL; /* tested by PetscSFProgress_Basic() */
+  link->nbrreq[0] = MPI_REQUEST_NULL;
+  link->nbrreq[1] = MPI_REQUEST_NULL;
 
 found:
-  link->key  = key;
+  link->key        = key;
+  link->leafdirect = PETSC_FALSE;
   link->next = bas->inuse;
   bas->inuse = link;
 
@@ -814,7 +1006,7 @@ found:
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFBasicGetPackInUse(PetscSF sf,MPI_Datatype unit,const void *key,PetscCopyMode cmode,PetscSFBasicPack *mylink)
+PetscErrorCode PetscSFBasicGetPackInUse(PetscSF sf,MPI_Datatype unit,const void *key,PetscCopyMode cmode,PetscSFBasicPack *mylink)
 {
   PetscSF_Basic    *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode   ierr;
@@ -839,7 +1031,7 @@ static PetscErrorCode PetscSFBasicGetPackInUse(PetscSF sf,MPI_Datatype unit,cons
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFBasicReclaimPack(PetscSF sf,PetscSFBasicPack *link)
+PetscErrorCode PetscSFBasicReclaimPack(PetscSF sf,PetscSFBasicPack *link)
 {
   PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
 
@@ -851,17 +1043,184 @@ static PetscErrorCode PetscSFBasicReclaimPack(PetscSF sf,PetscSFBasicPack *link)
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFSetFromOptions_Basic(PetscOptionItems *PetscOptionsObject,PetscSF sf)
+/* Pack the data of rank r, a subblock is copied by rows */
+PetscErrorCode PetscSFBasicPackRank(PetscSFBasicPack link,const PetscSFBasicPackOpt *opt,PetscInt r,PetscInt n,const PetscInt *idx,const void *unpacked,void *packed)
 {
   PetscErrorCode ierr;
+  PetscInt       j,k;
+  size_t         rowbytes;
+
+  PetscFunctionBegin;
+  if (!opt->isblock || !opt->isblock[r]) {(*link->Pack)(n,link->bs,idx,unpacked,packed); PetscFunctionReturn(0);}
+  rowbytes = opt->dx[r]*link->unitbytes;
+  for (k=0; k<opt->dz[r]; k++) {
+    for (j=0; j<opt->dy[r]; j++) {
+      ierr = PetscMemcpy((char*)packed+(k*opt->dy[r]+j)*rowbytes,(const char*)unpacked+(opt->start[r]+opt->X[r]*(j+opt->Y[r]*k))*link->unitbytes,rowbytes);CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/* Insert the packed data of rank r, a subblock is copied by rows */
+PetscErrorCode PetscSFBasicUnpackInsertRank(PetscSFBasicPack link,const PetscSFBasicPackOpt *opt,PetscInt r,PetscInt n,const PetscInt *idx,void *unpacked,const void *packed)
+{
+  PetscErrorCode ierr;
+  PetscInt       j,k;
+  size_t         rowbytes;
+
+  PetscFunctionBegin;
+  if (!opt->isblock || !opt->isblock[r]) {(*link->UnpackInsert)(n,link->bs,idx,unpacked,packed); PetscFunctionReturn(0);}
+  rowbytes = opt->dx[r]*link->unitbytes;
+  for (k=0; k<opt->dz[r]; k++) {
+    for (j=0; j<opt->dy[r]; j++) {
+      ierr = PetscMemcpy((char*)unpacked+(opt->start[r]+opt->X[r]*(j+opt->Y[r]*k))*link->unitbytes,(const char*)packed+(k*opt->dy[r]+j)*rowbytes,rowbytes);CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/* Pack the root data sent to every incoming rank, including the distinguished one */
+PetscErrorCode PetscSFBasicPackRootData(PetscSF sf,PetscSFBasicPack link,const void *rootdata)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
+  PetscErrorCode ierr;
+  PetscInt       i,nrootranks;
+  const PetscInt *rootoffset,*rootloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetRootInfo(sf,&nrootranks,NULL,NULL,&rootoffset,&rootloc);CHKERRQ(ierr);
+  for (i=0; i<nrootranks; i++) {ierr = PetscSFBasicPackRank(link,&bas->rootopt,i,rootoffset[i+1]-rootoffset[i],rootloc+rootoffset[i],rootdata,link->root[i]);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+/* Pack the leaf data sent to every rank owning roots, including the distinguished one */
+PetscErrorCode PetscSFBasicPackLeafData(PetscSF sf,PetscSFBasicPack link,const void *leafdata)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
+  PetscErrorCode ierr;
+  PetscInt       i,nleafranks;
+  const PetscInt *leafoffset,*leafloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,NULL,NULL,&leafoffset,&leafloc);CHKERRQ(ierr);
+  for (i=0; i<nleafranks; i++) {ierr = PetscSFBasicPackRank(link,&bas->leafopt,i,leafoffset[i+1]-leafoffset[i],leafloc+leafoffset[i],leafdata,link->leaf[i]);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+/* Combine the packed data of rank r into unpacked with op, inserting a subblock by rows */
+PetscErrorCode PetscSFBasicUnpackOpRank(PetscSFBasicPack link,const PetscSFBasicPackOpt *opt,void (*UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*),MPI_Datatype unit,MPI_Op op,PetscInt r,PetscInt n,const PetscInt *idx,void *unpacked,const void *packed)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (UnpackOp == link->UnpackInsert) {
+    ierr = PetscSFBasicUnpackInsertRank(link,opt,r,n,idx,unpacked,packed);CHKERRQ(ierr);
+  } else if (UnpackOp) {
+    (*UnpackOp)(n,link->bs,idx,unpacked,packed);
+  }
+#if defined(PETSC_HAVE_MPI_REDUCE_LOCAL)
+  else if (n) { /* the op should be defined to operate on the whole datatype, so we ignore link->bs */
+    PetscMPIInt typesize;
+    PetscInt    j;
+
+    ierr = MPI_Type_size(unit,&typesize);CHKERRQ(ierr);
+    for (j=0; j<n; j++) {
+      ierr = MPI_Reduce_local((void*)((const char*)packed+j*typesize),(char*)unpacked+idx[j]*typesize,1,unit,op);CHKERRQ(ierr);
+    }
+  }
+#else
+  else SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No unpacking reduction operation for this MPI_Op");
+#endif
+  PetscFunctionReturn(0);
+}
+
+/* Combine the received root data into the leaves once the communication is complete */
+PetscErrorCode PetscSFBasicUnpackLeafData(PetscSF sf,PetscSFBasicPack link,MPI_Datatype unit,void *leafdata,MPI_Op op)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
+  void           (*UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  PetscErrorCode ierr;
+  PetscInt       i,nleafranks,ndleafranks;
+  const PetscInt *leafoffset,*leafloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,&ndleafranks,NULL,&leafoffset,&leafloc);CHKERRQ(ierr);
+  ierr = PetscSFBasicPackGetUnpackOp(sf,link,op,&UnpackOp);CHKERRQ(ierr);
+  for (i=0; i<nleafranks; i++) {
+    if (link->leafdirect && i >= ndleafranks && PetscSFBasicPackOptIsContig(&bas->leafopt,i)) continue; /* already in place */
+    ierr = PetscSFBasicUnpackOpRank(link,&bas->leafopt,UnpackOp,unit,op,i,leafoffset[i+1]-leafoffset[i],leafloc+leafoffset[i],leafdata,link->leaf[i]);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/* Combine the packed data of incoming rank r into the roots, split among threads by roots when there is enough of it */
+static PetscErrorCode PetscSFBasicUnpackRootRank(PetscSF sf,PetscSFBasicPack link,void (*UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*),MPI_Datatype unit,MPI_Op op,PetscInt r,void *rootdata)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
+  PetscErrorCode ierr;
+  PetscInt       n = bas->ioffset[r+1]-bas->ioffset[r];
+
+  PetscFunctionBegin;
+#if defined(PETSC_HAVE_OPENMP)
+  if (bas->rootplan.tstart && UnpackOp && n >= PETSCSF_BASIC_THREAD_MINSIZE && !(bas->rootopt.isblock && bas->rootopt.isblock[r])) {
+    const PetscSFBasicThreadPlan *plan   = &bas->rootplan;
+    const PetscInt               *tstart = plan->tstart + r*(plan->nthreads+1),*idx = plan->idx + bas->ioffset[r],*perm = plan->perm + bas->ioffset[r];
+    const char                   *packed = link->root[r];
+    char                         *sorted;
+    size_t                       ub = link->unitbytes;
+    PetscInt                     t;
+
+    if (!link->sortbuf) {ierr = PetscMalloc(bas->ioffset[bas->niranks]*ub,&link->sortbuf);CHKERRQ(ierr);}
+    sorted = link->sortbuf + bas->ioffset[r]*ub;
+#pragma omp parallel for num_threads(plan->nthreads) schedule(static,1)
+    for (t=0; t<plan->nthreads; t++) { /* Each thread gathers its part of the packed data in root order and combines it with one call */
+      PetscInt k;
+      for (k=tstart[t]; k<tstart[t+1]; k++) memcpy(sorted+k*ub,packed+perm[k]*ub,ub);
+      (*UnpackOp)(tstart[t+1]-tstart[t],link->bs,idx+tstart[t],rootdata,sorted+tstart[t]*ub);
+    }
+    PetscFunctionReturn(0);
+  }
+#endif
+  ierr = PetscSFBasicUnpackOpRank(link,&bas->rootopt,UnpackOp,unit,op,r,n,bas->irootloc+bas->ioffset[r],rootdata,link->root[r]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Reduce the received leaf data into the roots once the communication is complete */
+PetscErrorCode PetscSFBasicUnpackRootData(PetscSF sf,PetscSFBasicPack link,MPI_Datatype unit,void *rootdata,MPI_Op op)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
+  void           (*UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicPackGetUnpackOp(sf,link,op,&UnpackOp);CHKERRQ(ierr);
+  for (i=0; i<bas->niranks; i++) {ierr = PetscSFBasicUnpackRootRank(sf,link,UnpackOp,unit,op,i,rootdata);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode PetscSFSetFromOptions_Basic(PetscOptionItems *PetscOptionsObject,PetscSF sf)
+{
+  PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
+  PetscErrorCode ierr;
 
   PetscFunctionBegin;
   ierr = PetscOptionsHead(PetscOptionsObject,"PetscSF Basic options");CHKERRQ(ierr);
+  ierr = PetscOptionsBool("-sf_basic_pack_opt","Copy contiguous and subblock roots and leaves by rows","PetscSFSetUp",bas->usepackopt,&bas->usepackopt,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsBool("-sf_basic_in_place","Send contiguous roots and leaves from, and receive them into, the user arrays without packing; they must not change until the End call","PetscSFBcastBegin",bas->inplace,&bas->inplace,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-sf_basic_unpack_threads","Number of OpenMP threads combining the leaf data of a rank into the roots","PetscSFReduceEnd",bas->rootplan.nthreads,&bas->rootplan.nthreads,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsBool("-sf_basic_reduce_waitsome","Combine the leaf data of each rank into the roots as it arrives, in a nondeterministic order","PetscSFReduceEnd",bas->waitsome,&bas->waitsome,NULL);CHKERRQ(ierr);
   ierr = PetscOptionsTail();CHKERRQ(ierr);
+#if !defined(PETSC_HAVE_OPENMP)
+  if (bas->rootplan.nthreads > 1) {
+    ierr = PetscInfo(sf,"Ignoring -sf_basic_unpack_threads since PETSc was not configured --with-openmp\n");CHKERRQ(ierr);
+    bas->rootplan.nthreads = 0;
+  }
+#endif
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFReset_Basic(PetscSF sf)
+PetscErrorCode PetscSFReset_Basic(PetscSF sf)
 {
   PetscSF_Basic    *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode   ierr;
@@ -871,12 +1230,19 @@ static PetscErrorCode PetscSFReset_Basic(PetscSF sf)
   if (bas->inuse) SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONGSTATE,"Outstanding operation has not been completed");
   ierr = PetscFree2(bas->iranks,bas->ioffset);CHKERRQ(ierr);
   ierr = PetscFree(bas->irootloc);CHKERRQ(ierr);
+  ierr = PetscSFBasicPackOptDestroy(&bas->rootopt);CHKERRQ(ierr);
+  ierr = PetscSFBasicPackOptDestroy(&bas->leafopt);CHKERRQ(ierr);
+  ierr = PetscSFBasicThreadPlanDestroy(&bas->rootplan);CHKERRQ(ierr);
   for (link=bas->avail; link; link=next) {
     PetscInt i;
     next = link->next;
     ierr = MPI_Type_free(&link->unit);CHKERRQ(ierr);
-    for (i=0; i<bas->niranks; i++) {ierr = PetscFree(link->root[i]);CHKERRQ(ierr);}
-    for (i=sf->ndranks; i<sf->nranks; i++) {ierr = PetscFree(link->leaf[i]);CHKERRQ(ierr);} /* Free only non-distinguished leaf buffers */
+    for (i=0; i<2; i++) {
+      if (link->nbrreq[i] != MPI_REQUEST_NULL) {ierr = MPI_Request_free(&link->nbrreq[i]);CHKERRQ(ierr);} /* persistent requests */
+    }
+    ierr = PetscFree(link->rootbuf);CHKERRQ(ierr);
+    ierr = PetscFree(link->sortbuf);CHKERRQ(ierr);
+    ierr = PetscFree(link->leafbuf);CHKERRQ(ierr);
     ierr = PetscFree2(link->root,link->leaf);CHKERRQ(ierr);
     ierr = PetscFree(link->requests);CHKERRQ(ierr);
     ierr = PetscFree(link);CHKERRQ(ierr);
@@ -885,6 +1251,29 @@ static PetscErrorCode PetscSFReset_Basic(PetscSF sf)
   PetscFunctionReturn(0);
 }
 
+/* Tests the requests of the operations in progress until one is not complete, without completing them */
+PetscErrorCode PetscSFProgress_Basic(PetscSF sf)
+{
+  PetscSF_Basic    *bas = (PetscSF_Basic*)sf->data;
+  PetscSFBasicPack link;
+  PetscInt         i,nreqs = bas->niranks+sf->nranks-(bas->ndiranks+sf->ndranks);
+  int              flag;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  for (link=bas->inuse; link; link=link->next) {
+    for (i=0; i<2; i++) {
+      ierr = MPI_Request_get_status(link->nbrreq[i],&flag,MPI_STATUS_IGNORE);CHKERRQ(ierr);
+      if (!flag) PetscFunctionReturn(0);
+    }
+    for (i=0; i<nreqs; i++) {
+      ierr = MPI_Request_get_status(link->requests[i],&flag,MPI_STATUS_IGNORE);CHKERRQ(ierr);
+      if (!flag) PetscFunctionReturn(0);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
 static PetscErrorCode PetscSFDestroy_Basic(PetscSF sf)
 {
   PetscErrorCode ierr;
@@ -895,7 +1284,7 @@ static PetscErrorCode PetscSFDestroy_Basic(PetscSF sf)
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFView_Basic(PetscSF sf,PetscViewer viewer)
+PetscErrorCode PetscSFView_Basic(PetscSF sf,PetscViewer viewer)
 {
   /* PetscSF_Basic *bas = (PetscSF_Basic*)sf->data; */
   PetscErrorCode ierr;
@@ -909,8 +1298,8 @@ static PetscErrorCode PetscSFView_Basic(PetscSF sf,PetscViewer viewer)
   PetscFunctionReturn(0);
 }
 
-/* Send from roots to leaves */
-static PetscErrorCode PetscSFBcastBegin_Basic(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata)
+/* Send from roots to leaves, combining with op */
+static PetscErrorCode PetscSFBcastAndOpBegin_Basic(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
 {
   PetscSF_Basic     *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode    ierr;
@@ -926,38 +1315,36 @@ static PetscErrorCode PetscSFBcastBegin_Basic(PetscSF sf,MPI_Datatype unit,const
   ierr = PetscSFBasicGetPack(sf,unit,rootdata,&link);CHKERRQ(ierr);
 
   ierr = PetscSFBasicPackGetReqs(sf,link,&rootreqs,&leafreqs);CHKERRQ(ierr);
+  /* With -sf_basic_in_place, contiguous leaves are received in place when they are replaced, unless the roots live in the same array */
+  link->leafdirect = (PetscBool)(bas->inplace && op == MPIU_REPLACE && rootdata != leafdata);
   /* Eagerly post leaf receives, but only from non-distinguished ranks -- distinguished ranks will receive via shared memory */
   for (i=ndleafranks; i<nleafranks; i++) {
-    PetscMPIInt n = leafoffset[i+1] - leafoffset[i];
-    ierr = MPI_Irecv(link->leaf[i],n,unit,leafranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&leafreqs[i-ndleafranks]);CHKERRQ(ierr);
+    PetscMPIInt n    = leafoffset[i+1] - leafoffset[i];
+    void        *buf = link->leaf[i];
+    if (link->leafdirect && PetscSFBasicPackOptIsContig(&bas->leafopt,i)) buf = (char*)leafdata + bas->leafopt.start[i]*link->unitbytes;
+    ierr = MPI_Irecv(buf,n,unit,leafranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&leafreqs[i-ndleafranks]);CHKERRQ(ierr);
   }
-  /* Pack and send root data */
+  /* Pack and send root data, with -sf_basic_in_place contiguous roots are sent from rootdata */
   for (i=0; i<nrootranks; i++) {
     PetscMPIInt n          = rootoffset[i+1] - rootoffset[i];
-    void        *packstart = link->root[i];
-    (*link->Pack)(n,link->bs,rootloc+rootoffset[i],rootdata,packstart);
+    const void  *packstart = link->root[i];
+    if (bas->inplace && i >= ndrootranks && PetscSFBasicPackOptIsContig(&bas->rootopt,i)) packstart = (const char*)rootdata + bas->rootopt.start[i]*link->unitbytes;
+    else {ierr = PetscSFBasicPackRank(link,&bas->rootopt,i,n,rootloc+rootoffset[i],rootdata,link->root[i]);CHKERRQ(ierr);}
     if (i < ndrootranks) continue; /* shared memory */
-    ierr = MPI_Isend(packstart,n,unit,rootranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&rootreqs[i-ndrootranks]);CHKERRQ(ierr);
+    ierr = MPI_Isend((void*)packstart,n,unit,rootranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&rootreqs[i-ndrootranks]);CHKERRQ(ierr);
   }
   PetscFunctionReturn(0);
 }
 
-PetscErrorCode PetscSFBcastEnd_Basic(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata)
+static PetscErrorCode PetscSFBcastAndOpEnd_Basic(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
 {
   PetscErrorCode   ierr;
   PetscSFBasicPack link;
-  PetscInt         i,nleafranks,ndleafranks;
-  const PetscInt   *leafoffset,*leafloc;
 
   PetscFunctionBegin;
   ierr = PetscSFBasicGetPackInUse(sf,unit,rootdata,PETSC_OWN_POINTER,&link);CHKERRQ(ierr);
   ierr = PetscSFBasicPackWaitall(sf,link);CHKERRQ(ierr);
-  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,&ndleafranks,NULL,&leafoffset,&leafloc);CHKERRQ(ierr);
-  for (i=0; i<nleafranks; i++) {
-    PetscMPIInt n          = leafoffset[i+1] - leafoffset[i];
-    const void  *packstart = link->leaf[i];
-    (*link->UnpackInsert)(n,link->bs,leafloc+leafoffset[i],leafdata,packstart);
-  }
+  ierr = PetscSFBasicUnpackLeafData(sf,link,unit,leafdata,op);CHKERRQ(ierr);
   ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -984,64 +1371,54 @@ PetscErrorCode PetscSFReduceBegin_Basic(PetscSF sf,MPI_Datatype unit,const void
     PetscMPIInt n = rootoffset[i+1] - rootoffset[i];
     ierr = MPI_Irecv(link->root[i],n,unit,rootranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&rootreqs[i-ndrootranks]);CHKERRQ(ierr);
   }
-  /* Pack and send leaf data */
+  /* Pack and send leaf data, with -sf_basic_in_place contiguous leaves are sent from leafdata */
   for (i=0; i<nleafranks; i++) {
     PetscMPIInt n          = leafoffset[i+1] - leafoffset[i];
-    void        *packstart = link->leaf[i];
-    (*link->Pack)(n,link->bs,leafloc+leafoffset[i],leafdata,packstart);
+    const void  *packstart = link->leaf[i];
+    if (bas->inplace && i >= ndleafranks && PetscSFBasicPackOptIsContig(&bas->leafopt,i)) packstart = (const char*)leafdata + bas->leafopt.start[i]*link->unitbytes;
+    else {ierr = PetscSFBasicPackRank(link,&bas->leafopt,i,n,leafloc+leafoffset[i],leafdata,link->leaf[i]);CHKERRQ(ierr);}
     if (i < ndleafranks) continue; /* shared memory */
-    ierr = MPI_Isend(packstart,n,unit,leafranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&leafreqs[i-ndleafranks]);CHKERRQ(ierr);
+    ierr = MPI_Isend((void*)packstart,n,unit,leafranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&leafreqs[i-ndleafranks]);CHKERRQ(ierr);
   }
   PetscFunctionReturn(0);
 }
 
 static PetscErrorCode PetscSFReduceEnd_Basic(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
 {
+  PetscSF_Basic    *bas = (PetscSF_Basic*)sf->data;
   void             (*UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
   PetscErrorCode   ierr;
   PetscSFBasicPack link;
-  PetscInt         i,nrootranks;
-  PetscMPIInt      typesize = -1;
-  const PetscInt   *rootoffset,*rootloc;
+  PetscInt         i;
+  PetscMPIInt      nreqs,ndone,*done;
+  MPI_Request      *rootreqs,*leafreqs;
 
   PetscFunctionBegin;
   ierr = PetscSFBasicGetPackInUse(sf,unit,rootdata,PETSC_OWN_POINTER,&link);CHKERRQ(ierr);
-  /* This implementation could be changed to unpack as receives arrive, at the cost of non-determinism */
-  ierr = PetscSFBasicPackWaitall(sf,link);CHKERRQ(ierr);
-  ierr = PetscSFBasicGetRootInfo(sf,&nrootranks,NULL,NULL,&rootoffset,&rootloc);CHKERRQ(ierr);
-  ierr = PetscSFBasicPackGetUnpackOp(sf,link,op,&UnpackOp);CHKERRQ(ierr);
-  if (UnpackOp) {
-    typesize = link->unitbytes;
-  }
-  else {
-    ierr = MPI_Type_size(unit,&typesize);CHKERRQ(ierr);
+  if (!bas->waitsome) {
+    ierr = PetscSFBasicPackWaitall(sf,link);CHKERRQ(ierr);
+    ierr = PetscSFBasicUnpackRootData(sf,link,unit,rootdata,op);CHKERRQ(ierr);
+    ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
   }
-  for (i=0; i<nrootranks; i++) {
-    PetscMPIInt n   = rootoffset[i+1] - rootoffset[i];
-    char *packstart = (char *) link->root[i];
-
-    if (UnpackOp) {
-      (*UnpackOp)(n,link->bs,rootloc+rootoffset[i],rootdata,(const void *)packstart);
-    }
-#if defined(PETSC_HAVE_MPI_REDUCE_LOCAL)
-    else if (n) { /* the op should be defined to operate on the whole datatype, so we ignore link->bs */
-      PetscInt j;
-
-      for (j = 0; j < n; j++) {
-        ierr = MPI_Reduce_local(packstart+j*typesize,((char *) rootdata)+(rootloc[rootoffset[i]+j])*typesize,1,unit,op);CHKERRQ(ierr);
-      }
-    }
-#else
-    else {
-      SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No unpacking reduction operation for this MPI_Op");
-    }
-#endif
+  /* Combine the distinguished ranks, then each other rank as soon as its data arrives, in a nondeterministic order */
+  ierr = PetscSFBasicPackGetUnpackOp(sf,link,op,&UnpackOp);CHKERRQ(ierr);
+  ierr = PetscSFBasicPackGetReqs(sf,link,&rootreqs,&leafreqs);CHKERRQ(ierr);
+  for (i=0; i<bas->ndiranks; i++) {ierr = PetscSFBasicUnpackRootRank(sf,link,UnpackOp,unit,op,i,rootdata);CHKERRQ(ierr);}
+  ierr = PetscMPIIntCast(bas->niranks-bas->ndiranks,&nreqs);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nreqs,&done);CHKERRQ(ierr);
+  while (1) {
+    ierr = MPI_Waitsome(nreqs,rootreqs,&ndone,done,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+    if (ndone == MPI_UNDEFINED) break;
+    for (i=0; i<ndone; i++) {ierr = PetscSFBasicUnpackRootRank(sf,link,UnpackOp,unit,op,bas->ndiranks+done[i],rootdata);CHKERRQ(ierr);}
   }
+  ierr = PetscFree(done);CHKERRQ(ierr);
+  ierr = MPI_Waitall(sf->nranks-sf->ndranks,leafreqs,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
   ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
+PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
 {
   PetscErrorCode ierr;
 
@@ -1050,7 +1427,7 @@ static PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF sf,MPI_Datatype unit,
   PetscFunctionReturn(0);
 }
 
-static PetscErrorCode PetscSFFetchAndOpEnd_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
+PetscErrorCode PetscSFFetchAndOpEnd_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
 {
   PetscSF_Basic     *bas = (PetscSF_Basic*)sf->data;
   void              (*FetchAndOp)(PetscInt,PetscInt,const PetscInt*,void*,void*);
@@ -1084,11 +1461,7 @@ static PetscErrorCode PetscSFFetchAndOpEnd_Basic(PetscSF sf,MPI_Datatype unit,vo
     ierr = MPI_Isend(packstart,n,unit,rootranks[i],bas->tag,PetscObjectComm((PetscObject)sf),&rootreqs[i-ndrootranks]);CHKERRQ(ierr);
   }
   ierr = PetscSFBasicPackWaitall(sf,link);CHKERRQ(ierr);
-  for (i=0; i<nleafranks; i++) {
-    PetscMPIInt n          = leafoffset[i+1] - leafoffset[i];
-    const void  *packstart = link->leaf[i];
-    (*link->UnpackInsert)(n,link->bs,leafloc+leafoffset[i],leafupdate,packstart);
-  }
+  ierr = PetscSFBasicUnpackLeafData(sf,link,unit,leafupdate,MPIU_REPLACE);CHKERRQ(ierr);
   ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -1100,18 +1473,23 @@ PETSC_EXTERN PetscErrorCode PetscSFCreate_Basic(PetscSF sf)
 
   PetscFunctionBegin;
   sf->ops->SetUp           = PetscSFSetUp_Basic;
+  sf->ops->SetUpBegin      = PetscSFSetUpBegin_Basic;
+  sf->ops->SetUpEnd        = PetscSFSetUpEnd_Basic;
+  sf->ops->GetRootRanks    = PetscSFBasicGetRootInfo;
   sf->ops->SetFromOptions  = PetscSFSetFromOptions_Basic;
   sf->ops->Reset           = PetscSFReset_Basic;
   sf->ops->Destroy         = PetscSFDestroy_Basic;
   sf->ops->View            = PetscSFView_Basic;
-  sf->ops->BcastBegin      = PetscSFBcastBegin_Basic;
-  sf->ops->BcastEnd        = PetscSFBcastEnd_Basic;
+  sf->ops->BcastAndOpBegin = PetscSFBcastAndOpBegin_Basic;
+  sf->ops->BcastAndOpEnd   = PetscSFBcastAndOpEnd_Basic;
   sf->ops->ReduceBegin     = PetscSFReduceBegin_Basic;
   sf->ops->ReduceEnd       = PetscSFReduceEnd_Basic;
   sf->ops->FetchAndOpBegin = PetscSFFetchAndOpBegin_Basic;
   sf->ops->FetchAndOpEnd   = PetscSFFetchAndOpEnd_Basic;
+  sf->ops->Progress        = PetscSFProgress_Basic;
 
   ierr = PetscNewLog(sf,&bas);CHKERRQ(ierr);
-  sf->data = (void*)bas;
+  bas->usepackopt = PETSC_TRUE;
+  sf->data        = (void*)bas;
   PetscFunctionReturn(0);
 }
@@ -0,0 +1,120 @@
+#if !defined(__SFBASIC_H)
+#define __SFBASIC_H
+
+#include <petsc/private/sfimpl.h>
+
+/*
+   Indices of the roots (or leaves) exchanged with one rank that form a 3D subblock of the local array: they are
+   start + x + X*(y + Y*z) for 0 <= x < dx, 0 <= y < dy, 0 <= z < dz, in this order. A contiguous range is the case
+   dy = dz = 1, a strided run of equal pieces the case dz = 1. These ranks are packed with memcpy() by rows of dx units
+   and, when contiguous, may be sent from or received into the user array directly.
+*/
+typedef struct {
+  PetscBool *isblock;           /* Indices of rank i form a subblock, otherwise the index array is used */
+  PetscInt  *start,*dx,*dy,*dz,*X,*Y;
+} PetscSFBasicPackOpt;
+
+/*
+   Roots referenced by each incoming rank sorted, with the position of each in the data packed by that rank, so that
+   the unpacking of a rank can be split among threads at root boundaries: each thread combines into its own roots, in
+   the order in which they were packed, as the sequential unpacking does.
+*/
+typedef struct {
+  PetscInt nthreads;            /* Number of OpenMP threads, -sf_basic_unpack_threads */
+  PetscInt *idx;                /* Roots of each rank sorted, indexed as irootloc[] */
+  PetscInt *perm;               /* Position of each entry of idx[] in the packed data of its rank */
+  PetscInt *tstart;             /* Start in idx[] of each thread for rank r, at tstart[r*(nthreads+1)], followed by the end */
+} PetscSFBasicThreadPlan;
+
+typedef struct _n_PetscSFBasicPack *PetscSFBasicPack;
+struct _n_PetscSFBasicPack {
+  void (*Pack)(PetscInt,PetscInt,const PetscInt*,const void*,void*);
+  void (*UnpackInsert)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackAdd)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMin)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMax)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMinloc)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMaxloc)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMult)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
+  void (*UnpackLAND)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
+  void (*UnpackBAND)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
+  void (*UnpackLOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
+  void (*UnpackBOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
+  void (*UnpackLXOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
+  void (*UnpackBXOR)(PetscInt,PetscInt,const PetscInt*,void*,const void *);
+  void (*FetchAndInsert)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndAdd)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMin)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMax)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMinloc)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMaxloc)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMult)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndLAND)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndBAND)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndLOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndBOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndLXOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndBXOR)(PetscInt,PetscInt,const PetscInt*,void*,void*);
+
+  MPI_Datatype     unit;
+  size_t           unitbytes;   /* Number of bytes in a unit */
+  PetscInt         bs;          /* Number of basic units in a unit */
+  const void       *key;        /* Array used as key for operation */
+  char             **root;      /* Packed root data, indexed by leaf rank */
+  char             **leaf;      /* Packed leaf data, indexed by root rank */
+  char             *rootbuf;    /* Contiguous storage of root[], in the order of the incoming ranks */
+  char             *leafbuf;    /* Contiguous storage of leaf[] for the non-distinguished ranks */
+  char             *sortbuf;    /* Copy of rootbuf in the root order of the thread plan, allocated on first use */
+  MPI_Request      *requests;   /* Array of root requests followed by leaf requests */
+  MPI_Request      nbrreq[2];   /* PETSCSFNEIGHBOR: neighborhood collective from roots to leaves and from leaves to roots */
+  PetscBool        leafdirect;  /* Contiguous leaves of non-distinguished ranks were received directly into leafdata */
+  PetscSFBasicPack next;
+};
+
+typedef struct {
+  PetscMPIInt      tag;
+  PetscMPIInt      niranks;     /* Number of incoming ranks (ranks accessing my roots) */
+  PetscMPIInt      ndiranks;    /* Number of incoming ranks (ranks accessing my roots) in distinguished set */
+  PetscMPIInt      *iranks;     /* Array of ranks that reference my roots */
+  PetscInt         itotal;      /* Total number of graph edges referencing my roots */
+  PetscInt         *ioffset;    /* Array of length niranks+1 holding offset in irootloc[] for each rank */
+  PetscInt         *irootloc;   /* Incoming roots referenced by ranks starting at ioffset[rank] */
+  PetscSFBasicPack avail;       /* One or more entries per MPI Datatype, lazily constructed */
+  PetscSFBasicPack inuse;       /* Buffers being used for transactions that have not yet completed */
+  PetscBool        usepackopt;  /* Detect subblocks of roots and leaves at setup, -sf_basic_pack_opt */
+  PetscBool        inplace;     /* Send contiguous ranges from and receive them into the user arrays, -sf_basic_in_place */
+  PetscSFBasicPackOpt rootopt;  /* Subblocks of the roots referenced by each incoming rank, indexed as iranks[] */
+  PetscSFBasicPackOpt leafopt;  /* Subblocks of the leaves referencing each root rank, indexed as sf->ranks[] */
+  MPI_Request      *setupreqs[2]; /* Receives of irootloc[] and sends of sf->rremote[] of a setup begun with PetscSFSetUpBegin() */
+  PetscSegBuffer   setupseg;    /* Holds irootloc[] while it is received from discovered incoming ranks */
+  PetscInt         *setuplengths; /* Lengths sent to the root ranks when the incoming ranks are known */
+  PetscBool        setupknown;  /* The incoming ranks are known, or derived in PetscSFSetUpEnd(), and send lengths and roots */
+  PetscBool        waitsome;    /* Unpack the leaf data of each rank in PetscSFReduceEnd() as it arrives, -sf_basic_reduce_waitsome */
+  PetscSFBasicThreadPlan rootplan; /* Threaded unpacking into the roots */
+} PetscSF_Basic;
+
+PETSC_INTERN PetscErrorCode PetscSFSetUp_Basic(PetscSF);
+PETSC_INTERN PetscErrorCode PetscSFSetUpBegin_Basic(PetscSF);
+PETSC_INTERN PetscErrorCode PetscSFSetUpEnd_Basic(PetscSF);
+PETSC_INTERN PetscErrorCode PetscSFReset_Basic(PetscSF);
+PETSC_INTERN PetscErrorCode PetscSFSetFromOptions_Basic(PetscOptionItems*,PetscSF);
+PETSC_INTERN PetscErrorCode PetscSFView_Basic(PetscSF,PetscViewer);
+PETSC_INTERN PetscErrorCode PetscSFProgress_Basic(PetscSF);
+PETSC_INTERN PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF,MPI_Datatype,void*,const void*,void*,MPI_Op);
+PETSC_INTERN PetscErrorCode PetscSFFetchAndOpEnd_Basic(PetscSF,MPI_Datatype,void*,const void*,void*,MPI_Op);
+PETSC_INTERN PetscErrorCode PetscSFBasicGetRootInfo(PetscSF,PetscInt*,PetscInt*,const PetscMPIInt**,const PetscInt**,const PetscInt**);
+PETSC_INTERN PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF,PetscInt*,PetscInt*,const PetscMPIInt**,const PetscInt**,const PetscInt**);
+PETSC_INTERN PetscErrorCode PetscSFBasicPackTypeSetup(PetscSFBasicPack,MPI_Datatype);
+PETSC_INTERN PetscErrorCode PetscSFBasicPackGetUnpackOp(PetscSF,PetscSFBasicPack,MPI_Op,void (**)(PetscInt,PetscInt,const PetscInt*,void*,const void*));
+PETSC_INTERN PetscErrorCode PetscSFBasicPackRank(PetscSFBasicPack,const PetscSFBasicPackOpt*,PetscInt,PetscInt,const PetscInt*,const void*,void*);
+PETSC_INTERN PetscErrorCode PetscSFBasicUnpackInsertRank(PetscSFBasicPack,const PetscSFBasicPackOpt*,PetscInt,PetscInt,const PetscInt*,void*,const void*);
+PETSC_INTERN PetscErrorCode PetscSFBasicGetPack(PetscSF,MPI_Datatype,const void*,PetscSFBasicPack*);
+PETSC_INTERN PetscErrorCode PetscSFBasicGetPackInUse(PetscSF,MPI_Datatype,const void*,PetscCopyMode,PetscSFBasicPack*);
+PETSC_INTERN PetscErrorCode PetscSFBasicReclaimPack(PetscSF,PetscSFBasicPack*);
+PETSC_INTERN PetscErrorCode PetscSFBasicPackRootData(PetscSF,PetscSFBasicPack,const void*);
+PETSC_INTERN PetscErrorCode PetscSFBasicPackLeafData(PetscSF,PetscSFBasicPack,const void*);
+PETSC_INTERN PetscErrorCode PetscSFBasicUnpackOpRank(PetscSFBasicPack,const PetscSFBasicPackOpt*,void (*)(PetscInt,PetscInt,const PetscInt*,void*,const void*),MPI_Datatype,MPI_Op,PetscInt,PetscInt,const PetscInt*,void*,const void*);
+PETSC_INTERN PetscErrorCode PetscSFBasicUnpackLeafData(PetscSF,PetscSFBasicPack,MPI_Datatype,void*,MPI_Op);
+PETSC_INTERN PetscErrorCode PetscSFBasicUnpackRootData(PetscSF,PetscSFBasicPack,MPI_Datatype,void*,MPI_Op);
+
+#endif
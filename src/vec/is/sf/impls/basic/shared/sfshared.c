@@ -0,0 +1,532 @@
+#include <../src/vec/is/sf/impls/basic/sfbasic.h> /*I "petscsf.h" I*/
+
+/*
+   PETSCSFSHARED splits the graph into the leaves whose roots are on the same shared memory node and the others. The
+   others form a PETSCSFBASIC star forest with the same roots; the data of the on-node ranks is packed into a window
+   allocated with MPI_Win_allocate_shared() and unpacked by the receiving process directly from the window of the
+   sender, so that no message is sent.
+
+   Every window is split in
+     - a header of 2+nodesize integers: the last Bcast and the last Reduce whose data this process has published, then
+       for each node rank q the last operation whose data this process has finished reading from q,
+     - the root area, with the packed roots for each on-node rank referencing them, used by Bcast,
+     - the leaf area, with the packed leaves for each on-node rank owning their roots, used by Reduce.
+   A process publishes its data by storing the number of the operation in its header, the readers poll this number and
+   store it in their own header once they have unpacked. Operations are numbered in the order they are started, which
+   is the same on every process since they are collective; operation n uses the window of slot n % NSLOTS, so up to
+   NSLOTS operations may be in progress on the same star forest. The memory of the windows is kept consistent with
+   MPI_Win_sync() in a passive target epoch opened once.
+
+   Fetch-and-op is done by PETSCSFBASIC on the whole graph.
+*/
+
+#define NSLOTS 4
+
+typedef struct {
+  MPI_Win                     win;
+  size_t                      unitbytes;  /* Size of the units the window was allocated for */
+  char                        **seg;      /* Segment of the window of each node rank */
+  struct _n_PetscSFBasicPack  kern;       /* Pack and unpack kernels of the current unit */
+  PetscBool                   haskern;
+  PetscBool                   inuse;
+  PetscInt                    dir;        /* 0: Bcast, 1: Reduce */
+  const void                  *key;
+  PetscInt64                  op;         /* Last operation using the slot, 0 if none */
+} PetscSFShared_Slot;
+
+typedef struct {
+  PetscSF_Basic      bas;                 /* Must be first, set up on the whole graph */
+  PetscSF            offsf;               /* Leaves whose roots are on other nodes */
+  PetscBool          anynode;             /* Some process of the node communicates through shared memory */
+  PetscInt           nodesize;            /* -sf_shared_node_size: split the nodes into groups of this many processes */
+  MPI_Comm           nodecomm;
+  PetscBool          ownnodecomm;
+  PetscMPIInt        nsize,nrank;
+  PetscInt           nrootranks;          /* Root side: on-node ranks referencing my roots */
+  PetscInt           *rootranks;          /* Their index in the incoming ranks of bas */
+  PetscMPIInt        *rootnrank;          /* Their node rank */
+  PetscInt           *rootoff;            /* Offset of their data in my root area, in units */
+  PetscInt           *rootpeeroff;        /* Offset of the leaf data destined to me in their leaf area, in units */
+  PetscInt           nleafranks;          /* Leaf side: on-node ranks owning roots of my leaves */
+  PetscInt           *leafranks;          /* Their index in sf->ranks */
+  PetscMPIInt        *leafnrank;
+  PetscInt           *leafoff;            /* Offset of my data for them in my leaf area, in units */
+  PetscInt           *leafpeeroff;        /* Offset of the root data destined to me in their root area, in units */
+  PetscInt           ndata;               /* Number of units in the root and leaf areas */
+  size_t             hbytes;              /* Size of the header */
+  PetscInt64         nops;
+  PetscSFShared_Slot slots[NSLOTS];
+} PetscSF_Shared;
+
+#define SlotHeader(sh,slot,q) ((volatile PetscInt64*)(slot)->seg[q])
+#define SlotData(sh,slot,q)   ((slot)->seg[q] + (sh)->hbytes)
+
+static PetscErrorCode PetscSFSharedSlotFree(PetscSF_Shared *sh,PetscSFShared_Slot *slot)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (slot->win != MPI_WIN_NULL) {
+    ierr = MPI_Win_unlock_all(slot->win);CHKERRQ(ierr);
+    ierr = MPI_Win_free(&slot->win);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(slot->seg);CHKERRQ(ierr);
+  slot->unitbytes = 0;
+  PetscFunctionReturn(0);
+}
+
+/* Collective on the node: every process starts the same operations in the same order */
+static PetscErrorCode PetscSFSharedSlotAllocate(PetscSF_Shared *sh,PetscSFShared_Slot *slot,size_t unitbytes)
+{
+  PetscErrorCode ierr;
+  MPI_Info       info;
+  MPI_Aint       sz;
+  PetscMPIInt    dsp_unit,q;
+  char           *mine;
+
+  PetscFunctionBegin;
+  ierr = PetscSFSharedSlotFree(sh,slot);CHKERRQ(ierr);
+  ierr = MPI_Info_create(&info);CHKERRQ(ierr);
+  ierr = MPI_Info_set(info,"alloc_shared_noncontig","true");CHKERRQ(ierr);
+  ierr = MPIU_Win_allocate_shared((MPI_Aint)(sh->hbytes+sh->ndata*unitbytes),1,info,sh->nodecomm,&mine,&slot->win);CHKERRQ(ierr);
+  ierr = MPI_Info_free(&info);CHKERRQ(ierr);
+  ierr = PetscMalloc1(sh->nsize,&slot->seg);CHKERRQ(ierr);
+  for (q=0; q<sh->nsize; q++) {
+    if (q == sh->nrank) slot->seg[q] = mine;
+    else {ierr = MPIU_Win_shared_query(slot->win,q,&sz,&dsp_unit,&slot->seg[q]);CHKERRQ(ierr);}
+  }
+  ierr = PetscMemzero(mine,sh->hbytes);CHKERRQ(ierr);
+  ierr = MPI_Win_lock_all(MPI_MODE_NOCHECK,slot->win);CHKERRQ(ierr);
+  ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);
+  ierr = MPI_Barrier(sh->nodecomm);CHKERRQ(ierr);
+  slot->unitbytes = unitbytes;
+  slot->op        = 0;          /* the readers of the previous operation have all completed it before the collective free */
+  PetscFunctionReturn(0);
+}
+
+/* Get the slot of the next operation, ready to be written */
+static PetscErrorCode PetscSFSharedGetSlot(PetscSF sf,MPI_Datatype unit,const void *key,PetscInt dir,PetscSFShared_Slot **myslot)
+{
+  PetscSF_Shared     *sh = (PetscSF_Shared*)sf->data;
+  PetscSFShared_Slot *slot;
+  PetscErrorCode     ierr;
+  PetscBool          match = PETSC_FALSE;
+  PetscInt           i,nreaders;
+  const PetscMPIInt  *readers;
+
+  PetscFunctionBegin;
+  sh->nops++;
+  slot = &sh->slots[sh->nops%NSLOTS];
+  if (slot->inuse) SETERRQ1(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONGSTATE,"More than %d operations in progress on the star forest",NSLOTS);
+  if (slot->haskern) {ierr = MPIPetsc_Type_compare(unit,slot->kern.unit,&match);CHKERRQ(ierr);}
+  if (!match) {
+    if (slot->haskern) {ierr = MPI_Type_free(&slot->kern.unit);CHKERRQ(ierr);}
+    ierr = PetscMemzero(&slot->kern,sizeof(slot->kern));CHKERRQ(ierr);
+    ierr = PetscSFBasicPackTypeSetup(&slot->kern,unit);CHKERRQ(ierr);
+    slot->haskern = PETSC_TRUE;
+  }
+  if (slot->kern.unitbytes > slot->unitbytes) {ierr = PetscSFSharedSlotAllocate(sh,slot,slot->kern.unitbytes);CHKERRQ(ierr);}
+  /* Wait until the data of the previous operation in this slot has been read */
+  if (slot->op) {
+    nreaders = slot->dir ? sh->nleafranks : sh->nrootranks;
+    readers  = slot->dir ? sh->leafnrank : sh->rootnrank;
+    for (i=0; i<nreaders; i++) {
+      while (SlotHeader(sh,slot,readers[i])[2+sh->nrank] < slot->op) {ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);}
+    }
+  }
+  slot->inuse = PETSC_TRUE;
+  slot->dir   = dir;
+  slot->key   = key;
+  slot->op    = sh->nops;
+  *myslot     = slot;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFSharedGetSlotInUse(PetscSF sf,MPI_Datatype unit,const void *key,PetscInt dir,PetscSFShared_Slot **myslot)
+{
+  PetscSF_Shared     *sh = (PetscSF_Shared*)sf->data;
+  PetscSFShared_Slot *slot;
+  PetscErrorCode     ierr;
+  PetscBool          match;
+  PetscInt           i;
+
+  PetscFunctionBegin;
+  *myslot = NULL;
+  for (i=0; i<NSLOTS; i++) {
+    slot = &sh->slots[i];
+    if (!slot->inuse || slot->key != key || slot->dir != dir) continue;
+    ierr = MPIPetsc_Type_compare(unit,slot->kern.unit,&match);CHKERRQ(ierr);
+    if (match && (!*myslot || slot->op < (*myslot)->op)) *myslot = slot; /* the oldest one */
+  }
+  if (!*myslot) SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONGSTATE,"Could not find the operation in progress");
+  PetscFunctionReturn(0);
+}
+
+/* Publish the data written in the slot for operation slot->op */
+static PetscErrorCode PetscSFSharedPublish(PetscSF_Shared *sh,PetscSFShared_Slot *slot)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);
+  SlotHeader(sh,slot,sh->nrank)[slot->dir] = slot->op;
+  ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFSharedWaitPublished(PetscSF_Shared *sh,PetscSFShared_Slot *slot,PetscMPIInt q)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  while (SlotHeader(sh,slot,q)[slot->dir] < slot->op) {ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);}
+  ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFSharedSignalRead(PetscSF_Shared *sh,PetscSFShared_Slot *slot,PetscInt n,const PetscMPIInt *writers)
+{
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);
+  for (i=0; i<n; i++) SlotHeader(sh,slot,sh->nrank)[2+writers[i]] = slot->op;
+  ierr = MPI_Win_sync(slot->win);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFSetUp_Shared(PetscSF sf)
+{
+  PetscSF_Shared    *sh = (PetscSF_Shared*)sf->data;
+  PetscErrorCode    ierr;
+  MPI_Comm          comm,mscomm;
+  MPI_Group         group,nodegroup;
+  PetscShmComm      scomm;
+  PetscInt          i,j,k,nroots,nleaves,nsub,nrootranks,nleafranks,*ilocal;
+  const PetscInt    *mine,*rootoffset,*leafoffset;
+  const PetscMPIInt *rootranks,*leafranks;
+  const PetscSFNode *remote;
+  PetscSFNode       *iremote;
+  PetscMPIInt       *nrank,size,hasnode,anynode,dsp_unit;
+  PetscBool         *onnode;
+  MPI_Win           win;
+  MPI_Aint          sz;
+  PetscInt          *myoff,*peeroff;
+
+  PetscFunctionBegin;
+  ierr = PetscSFSetUp_Basic(sf);CHKERRQ(ierr);
+  ierr = PetscObjectGetComm((PetscObject)sf,&comm);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+  ierr = PetscShmCommGet(comm,&scomm);CHKERRQ(ierr);
+  ierr = PetscShmCommGetMpiShmComm(scomm,&mscomm);CHKERRQ(ierr);
+  if (sh->nodesize > 0) {
+    ierr = MPI_Comm_rank(mscomm,&sh->nrank);CHKERRQ(ierr);
+    ierr = MPI_Comm_split(mscomm,(PetscMPIInt)(sh->nrank/sh->nodesize),sh->nrank,&sh->nodecomm);CHKERRQ(ierr);
+    sh->ownnodecomm = PETSC_TRUE;
+  } else sh->nodecomm = mscomm;
+  ierr = MPI_Comm_size(sh->nodecomm,&sh->nsize);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(sh->nodecomm,&sh->nrank);CHKERRQ(ierr);
+
+  /* Node rank of each rank of comm, MPI_UNDEFINED off the node */
+  ierr = PetscMalloc2(size,&nrank,size,&onnode);CHKERRQ(ierr);
+  for (i=0; i<size; i++) nrank[i] = (PetscMPIInt)i;
+  ierr = MPI_Comm_group(comm,&group);CHKERRQ(ierr);
+  ierr = MPI_Comm_group(sh->nodecomm,&nodegroup);CHKERRQ(ierr);
+  ierr = MPI_Group_translate_ranks(group,size,nrank,nodegroup,nrank);CHKERRQ(ierr);
+  ierr = MPI_Group_free(&group);CHKERRQ(ierr);
+  ierr = MPI_Group_free(&nodegroup);CHKERRQ(ierr);
+  for (i=0; i<size; i++) onnode[i] = (PetscBool)(nrank[i] != MPI_UNDEFINED);
+
+  /* On-node ranks on the root and the leaf side, with the offsets of their data in my areas */
+  ierr = PetscSFBasicGetRootInfo(sf,&nrootranks,NULL,&rootranks,&rootoffset,NULL);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,NULL,&leafranks,&leafoffset,NULL);CHKERRQ(ierr);
+  for (i=0,sh->nrootranks=0; i<nrootranks; i++) if (onnode[rootranks[i]]) sh->nrootranks++;
+  for (i=0,sh->nleafranks=0; i<nleafranks; i++) if (onnode[leafranks[i]]) sh->nleafranks++;
+  ierr = PetscMalloc4(sh->nrootranks,&sh->rootranks,sh->nrootranks,&sh->rootnrank,sh->nrootranks,&sh->rootoff,sh->nrootranks,&sh->rootpeeroff);CHKERRQ(ierr);
+  ierr = PetscMalloc4(sh->nleafranks,&sh->leafranks,sh->nleafranks,&sh->leafnrank,sh->nleafranks,&sh->leafoff,sh->nleafranks,&sh->leafpeeroff);CHKERRQ(ierr);
+  for (i=0,k=0,sh->ndata=0; i<nrootranks; i++) {
+    if (!onnode[rootranks[i]]) continue;
+    sh->rootranks[k] = i;
+    sh->rootnrank[k] = nrank[rootranks[i]];
+    sh->rootoff[k++] = sh->ndata;
+    sh->ndata       += rootoffset[i+1]-rootoffset[i];
+  }
+  for (i=0,k=0; i<nleafranks; i++) {
+    if (!onnode[leafranks[i]]) continue;
+    sh->leafranks[k] = i;
+    sh->leafnrank[k] = nrank[leafranks[i]];
+    sh->leafoff[k++] = sh->ndata;
+    sh->ndata       += leafoffset[i+1]-leafoffset[i];
+  }
+  hasnode = (PetscMPIInt)(sh->nrootranks || sh->nleafranks);
+  ierr = MPIU_Allreduce(&hasnode,&anynode,1,MPI_INT,MPI_LOR,sh->nodecomm);CHKERRQ(ierr);
+  sh->anynode = (PetscBool)anynode;
+  sh->hbytes  = ((2+sh->nsize)*sizeof(PetscInt64)+63)/64*64;
+
+  if (sh->anynode) {
+    /* Every process tells the others where their data is in its areas */
+    ierr = MPIU_Win_allocate_shared((MPI_Aint)(2*sh->nsize*sizeof(PetscInt)),sizeof(PetscInt),MPI_INFO_NULL,sh->nodecomm,&myoff,&win);CHKERRQ(ierr);
+    for (i=0; i<2*sh->nsize; i++) myoff[i] = -1;
+    for (k=0; k<sh->nrootranks; k++) myoff[sh->rootnrank[k]] = sh->rootoff[k];
+    for (k=0; k<sh->nleafranks; k++) myoff[sh->nsize+sh->leafnrank[k]] = sh->leafoff[k];
+    ierr = MPI_Barrier(sh->nodecomm);CHKERRQ(ierr);
+    for (k=0; k<sh->nleafranks; k++) {
+      peeroff = myoff;
+      if (sh->leafnrank[k] != sh->nrank) {ierr = MPIU_Win_shared_query(win,sh->leafnrank[k],&sz,&dsp_unit,&peeroff);CHKERRQ(ierr);}
+      sh->leafpeeroff[k] = peeroff[sh->nrank];
+      if (sh->leafpeeroff[k] < 0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Root rank on the node does not know about my leaves");
+    }
+    for (k=0; k<sh->nrootranks; k++) {
+      peeroff = myoff;
+      if (sh->rootnrank[k] != sh->nrank) {ierr = MPIU_Win_shared_query(win,sh->rootnrank[k],&sz,&dsp_unit,&peeroff);CHKERRQ(ierr);}
+      sh->rootpeeroff[k] = peeroff[sh->nsize+sh->nrank];
+      if (sh->rootpeeroff[k] < 0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Leaf rank on the node does not know about my roots");
+    }
+    ierr = MPI_Barrier(sh->nodecomm);CHKERRQ(ierr);
+    ierr = MPI_Win_free(&win);CHKERRQ(ierr);
+  }
+
+  /* The leaves whose roots are on other nodes */
+  ierr = PetscSFGetGraph(sf,&nroots,&nleaves,&mine,&remote);CHKERRQ(ierr);
+  for (j=0,nsub=0; j<nleaves; j++) if (!onnode[remote[j].rank]) nsub++;
+  ierr = PetscMalloc1(nsub,&ilocal);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nsub,&iremote);CHKERRQ(ierr);
+  for (j=0,nsub=0; j<nleaves; j++) {
+    if (onnode[remote[j].rank]) continue;
+    ilocal[nsub]  = mine ? mine[j] : j;
+    iremote[nsub] = remote[j];
+    nsub++;
+  }
+  ierr = PetscFree2(nrank,onnode);CHKERRQ(ierr);
+  ierr = PetscSFCreate(comm,&sh->offsf);CHKERRQ(ierr);
+  ierr = PetscSFSetType(sh->offsf,PETSCSFBASIC);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(sh->offsf,nroots,nsub,ilocal,PETSC_OWN_POINTER,iremote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+  ierr = PetscSFSetUp(sh->offsf);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFSetFromOptions_Shared(PetscOptionItems *PetscOptionsObject,PetscSF sf)
+{
+  PetscSF_Shared *sh = (PetscSF_Shared*)sf->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFSetFromOptions_Basic(PetscOptionsObject,sf);CHKERRQ(ierr);
+  ierr = PetscOptionsHead(PetscOptionsObject,"PetscSF Shared options");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-sf_shared_node_size","Number of consecutive processes of a node that share memory, 0 for all","PetscSFSetUp",sh->nodesize,&sh->nodesize,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReset_Shared(PetscSF sf)
+{
+  PetscSF_Shared *sh = (PetscSF_Shared*)sf->data;
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  for (i=0; i<NSLOTS; i++) {
+    PetscSFShared_Slot *slot = &sh->slots[i];
+    if (slot->inuse) SETERRQ(PetscObjectComm((PetscObject)sf),PETSC_ERR_ARG_WRONGSTATE,"Outstanding operation has not been completed");
+    ierr = PetscSFSharedSlotFree(sh,slot);CHKERRQ(ierr);
+    if (slot->haskern) {ierr = MPI_Type_free(&slot->kern.unit);CHKERRQ(ierr);}
+    slot->haskern = PETSC_FALSE;
+    slot->op      = 0;
+  }
+  sh->nops = 0;
+  ierr = PetscFree4(sh->rootranks,sh->rootnrank,sh->rootoff,sh->rootpeeroff);CHKERRQ(ierr);
+  ierr = PetscFree4(sh->leafranks,sh->leafnrank,sh->leafoff,sh->leafpeeroff);CHKERRQ(ierr);
+  if (sh->ownnodecomm) {ierr = MPI_Comm_free(&sh->nodecomm);CHKERRQ(ierr);}
+  sh->ownnodecomm = PETSC_FALSE;
+  sh->nodecomm    = MPI_COMM_NULL;
+  ierr = PetscSFDestroy(&sh->offsf);CHKERRQ(ierr);
+  ierr = PetscSFReset_Basic(sf);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFDestroy_Shared(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFReset_Shared(sf);CHKERRQ(ierr);
+  ierr = PetscFree(sf->data);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFProgress_Shared(PetscSF sf)
+{
+  PetscSF_Shared *sh = (PetscSF_Shared*)sf->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFProgress(sh->offsf);CHKERRQ(ierr);
+  ierr = PetscSFProgress_Basic(sf);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFView_Shared(PetscSF sf,PetscViewer viewer)
+{
+  PetscSF_Shared    *sh = (PetscSF_Shared*)sf->data;
+  PetscErrorCode    ierr;
+  PetscBool         iascii;
+  PetscViewerFormat format;
+
+  PetscFunctionBegin;
+  ierr = PetscSFView_Basic(sf,viewer);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  ierr = PetscViewerGetFormat(viewer,&format);CHKERRQ(ierr);
+  if (iascii && format == PETSC_VIEWER_ASCII_INFO_DETAIL) {
+    ierr = PetscViewerASCIIPushSynchronized(viewer);CHKERRQ(ierr);
+    ierr = PetscViewerASCIISynchronizedPrintf(viewer,"  [%d] node rank %d of %d, %D root and %D leaf ranks through shared memory\n",PetscGlobalRank,sh->nrank,sh->nsize,sh->nrootranks,sh->nleafranks);CHKERRQ(ierr);
+    ierr = PetscViewerFlush(viewer);CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPopSynchronized(viewer);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBcastAndOpBegin_Shared(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscSF_Shared     *sh  = (PetscSF_Shared*)sf->data;
+  PetscSF_Basic      *bas = &sh->bas;
+  PetscSFShared_Slot *slot;
+  PetscErrorCode     ierr;
+  PetscInt           k,i;
+  const PetscInt     *rootoffset,*rootloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBcastAndOpBegin(sh->offsf,unit,rootdata,leafdata,op);CHKERRQ(ierr);
+  if (!sh->anynode) PetscFunctionReturn(0);
+  ierr = PetscSFSharedGetSlot(sf,unit,rootdata,0,&slot);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetRootInfo(sf,NULL,NULL,NULL,&rootoffset,&rootloc);CHKERRQ(ierr);
+  for (k=0; k<sh->nrootranks; k++) {
+    i    = sh->rootranks[k];
+    ierr = PetscSFBasicPackRank(&slot->kern,&bas->rootopt,i,rootoffset[i+1]-rootoffset[i],rootloc+rootoffset[i],rootdata,SlotData(sh,slot,sh->nrank)+sh->rootoff[k]*slot->unitbytes);CHKERRQ(ierr);
+  }
+  ierr = PetscSFSharedPublish(sh,slot);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFBcastAndOpEnd_Shared(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscSF_Shared     *sh  = (PetscSF_Shared*)sf->data;
+  PetscSF_Basic      *bas = &sh->bas;
+  PetscSFShared_Slot *slot;
+  void               (*UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  PetscErrorCode     ierr;
+  PetscInt           k,i;
+  const PetscInt     *leafoffset,*leafloc;
+
+  PetscFunctionBegin;
+  if (sh->anynode) {
+    ierr = PetscSFSharedGetSlotInUse(sf,unit,rootdata,0,&slot);CHKERRQ(ierr);
+    ierr = PetscSFBasicGetLeafInfo(sf,NULL,NULL,NULL,&leafoffset,&leafloc);CHKERRQ(ierr);
+    ierr = PetscSFBasicPackGetUnpackOp(sf,&slot->kern,op,&UnpackOp);CHKERRQ(ierr);
+    for (k=0; k<sh->nleafranks; k++) {
+      i    = sh->leafranks[k];
+      ierr = PetscSFSharedWaitPublished(sh,slot,sh->leafnrank[k]);CHKERRQ(ierr);
+      ierr = PetscSFBasicUnpackOpRank(&slot->kern,&bas->leafopt,UnpackOp,unit,op,i,leafoffset[i+1]-leafoffset[i],leafloc+leafoffset[i],leafdata,SlotData(sh,slot,sh->leafnrank[k])+sh->leafpeeroff[k]*slot->unitbytes);CHKERRQ(ierr);
+    }
+    ierr = PetscSFSharedSignalRead(sh,slot,sh->nleafranks,sh->leafnrank);CHKERRQ(ierr);
+    slot->inuse = PETSC_FALSE;
+  }
+  ierr = PetscSFBcastAndOpEnd(sh->offsf,unit,rootdata,leafdata,op);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReduceBegin_Shared(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  PetscSF_Shared     *sh  = (PetscSF_Shared*)sf->data;
+  PetscSF_Basic      *bas = &sh->bas;
+  PetscSFShared_Slot *slot;
+  PetscErrorCode     ierr;
+  PetscInt           k,i;
+  const PetscInt     *leafoffset,*leafloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFReduceBegin(sh->offsf,unit,leafdata,rootdata,op);CHKERRQ(ierr);
+  if (!sh->anynode) PetscFunctionReturn(0);
+  ierr = PetscSFSharedGetSlot(sf,unit,rootdata,1,&slot);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetLeafInfo(sf,NULL,NULL,NULL,&leafoffset,&leafloc);CHKERRQ(ierr);
+  for (k=0; k<sh->nleafranks; k++) {
+    i    = sh->leafranks[k];
+    ierr = PetscSFBasicPackRank(&slot->kern,&bas->leafopt,i,leafoffset[i+1]-leafoffset[i],leafloc+leafoffset[i],leafdata,SlotData(sh,slot,sh->nrank)+sh->leafoff[k]*slot->unitbytes);CHKERRQ(ierr);
+  }
+  ierr = PetscSFSharedPublish(sh,slot);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode PetscSFReduceEnd_Shared(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  PetscSF_Shared     *sh  = (PetscSF_Shared*)sf->data;
+  PetscSF_Basic      *bas = &sh->bas;
+  PetscSFShared_Slot *slot;
+  void               (*UnpackOp)(PetscInt,PetscInt,const PetscInt*,void*,const void*);
+  PetscErrorCode     ierr;
+  PetscInt           k,i;
+  const PetscInt     *rootoffset,*rootloc;
+
+  PetscFunctionBegin;
+  if (sh->anynode) {
+    ierr = PetscSFSharedGetSlotInUse(sf,unit,rootdata,1,&slot);CHKERRQ(ierr);
+    ierr = PetscSFBasicGetRootInfo(sf,NULL,NULL,NULL,&rootoffset,&rootloc);CHKERRQ(ierr);
+    ierr = PetscSFBasicPackGetUnpackOp(sf,&slot->kern,op,&UnpackOp);CHKERRQ(ierr);
+    for (k=0; k<sh->nrootranks; k++) {
+      i    = sh->rootranks[k];
+      ierr = PetscSFSharedWaitPublished(sh,slot,sh->rootnrank[k]);CHKERRQ(ierr);
+      ierr = PetscSFBasicUnpackOpRank(&slot->kern,&bas->rootopt,UnpackOp,unit,op,i,rootoffset[i+1]-rootoffset[i],rootloc+rootoffset[i],rootdata,SlotData(sh,slot,sh->rootnrank[k])+sh->rootpeeroff[k]*slot->unitbytes);CHKERRQ(ierr);
+    }
+    ierr = PetscSFSharedSignalRead(sh,slot,sh->nrootranks,sh->rootnrank);CHKERRQ(ierr);
+    slot->inuse = PETSC_FALSE;
+  }
+  ierr = PetscSFReduceEnd(sh->offsf,unit,leafdata,rootdata,op);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*MC
+   PETSCSFSHARED - PetscSF implementation using MPI-3 shared memory between the processes of a node
+
+   The leaves whose roots are owned by a process of the same shared memory node read the packed root data directly
+   from a window allocated with MPI_Win_allocate_shared() by the owner, and the owners read the packed leaf data
+   directly from the windows of the leaf processes, with a flag per operation and process instead of a message. The
+   other leaves communicate as with PETSCSFBASIC. Up to 4 broadcasts and reductions may be in progress at the same
+   time on the same star forest. PetscSFFetchAndOpBegin() uses the PETSCSFBASIC implementation on the whole graph.
+
+   Options Database Keys:
++  -sf_type shared - use this implementation
+-  -sf_shared_node_size <n> - treat groups of n consecutive processes of a node as the shared memory nodes, for testing
+
+   Level: intermediate
+
+.seealso: PetscSFSetType(), PETSCSFBASIC, VECSCATTERMPI3NODE
+M*/
+
+PETSC_EXTERN PetscErrorCode PetscSFCreate_Shared(PetscSF sf)
+{
+  PetscSF_Shared *sh;
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  sf->ops->SetUp           = PetscSFSetUp_Shared;
+  sf->ops->GetRootRanks    = PetscSFBasicGetRootInfo;
+  sf->ops->SetFromOptions  = PetscSFSetFromOptions_Shared;
+  sf->ops->Reset           = PetscSFReset_Shared;
+  sf->ops->Destroy         = PetscSFDestroy_Shared;
+  sf->ops->View            = PetscSFView_Shared;
+  sf->ops->BcastAndOpBegin = PetscSFBcastAndOpBegin_Shared;
+  sf->ops->BcastAndOpEnd   = PetscSFBcastAndOpEnd_Shared;
+  sf->ops->ReduceBegin     = PetscSFReduceBegin_Shared;
+  sf->ops->ReduceEnd       = PetscSFReduceEnd_Shared;
+  sf->ops->FetchAndOpBegin = PetscSFFetchAndOpBegin_Basic;
+  sf->ops->FetchAndOpEnd   = PetscSFFetchAndOpEnd_Basic;
+  sf->ops->Progress        = PetscSFProgress_Shared;
+
+  ierr = PetscNewLog(sf,&sh);CHKERRQ(ierr);
+  sh->bas.usepackopt = PETSC_TRUE;
+  sh->nodecomm       = MPI_COMM_NULL;
+  for (i=0; i<NSLOTS; i++) sh->slots[i].win = MPI_WIN_NULL;
+  sf->data           = (void*)sh;
+  PetscFunctionReturn(0);
+}
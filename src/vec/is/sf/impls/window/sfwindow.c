@@ -345,20 +345,13 @@ found:
   PetscFunctionReturn(0);
 }
 
+/* The groups needed by PETSCSF_WINDOW_SYNC_ACTIVE are created by the first operation, PetscSFGetGroups() needs a PetscSF that is set up */
 static PetscErrorCode PetscSFSetUp_Window(PetscSF sf)
 {
-  PetscSF_Window *w = (PetscSF_Window*)sf->data;
   PetscErrorCode ierr;
-  MPI_Group      ingroup,outgroup;
 
   PetscFunctionBegin;
   ierr = PetscSFSetUpRanks(sf,MPI_GROUP_EMPTY);CHKERRQ(ierr);
-  switch (w->sync) {
-  case PETSCSF_WINDOW_SYNC_ACTIVE:
-    ierr = PetscSFGetGroups(sf,&ingroup,&outgroup);CHKERRQ(ierr);
-  default:
-    break;
-  }
   PetscFunctionReturn(0);
 }
 
@@ -1,5 +1,6 @@
 #include <petsc/private/sfimpl.h> /*I "petscsf.h" I*/
 #include <petscctable.h>
+#include <petscbt.h>
 
 #if defined(PETSC_USE_DEBUG)
 #  define PetscSFCheckGraphSet(sf,arg) do {                          \
@@ -47,6 +48,7 @@ PetscErrorCode PetscSFCreate(MPI_Comm comm,PetscSF *sf)
   b->ingroup   = MPI_GROUP_NULL;
   b->outgroup  = MPI_GROUP_NULL;
   b->graphset  = PETSC_FALSE;
+  b->nkranks   = -1;
 
   *sf = b;
   PetscFunctionReturn(0);
@@ -70,6 +72,7 @@ PetscErrorCode PetscSFReset(PetscSF sf)
 
   PetscFunctionBegin;
   PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  if (sf->setupbegun) {ierr = PetscSFSetUpEnd(sf);CHKERRQ(ierr);}
   if (sf->ops->Reset) {ierr = (*sf->ops->Reset)(sf);CHKERRQ(ierr);}
   sf->nroots   = -1;
   sf->nleaves  = -1;
@@ -88,6 +91,7 @@ PetscErrorCode PetscSFReset(PetscSF sf)
   if (sf->outgroup != MPI_GROUP_NULL) {ierr = MPI_Group_free(&sf->outgroup);CHKERRQ(ierr);}
   ierr = PetscSFDestroy(&sf->multi);CHKERRQ(ierr);
   sf->setupcalled = PETSC_FALSE;
+  ierr = PetscSFSetKnownRootRanks_Private(sf,PETSC_FALSE,-1,NULL,NULL,NULL);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -198,7 +202,10 @@ PetscErrorCode PetscSFDestroy(PetscSF *sf)
 
    Level: beginner
 
-.seealso: PetscSFSetFromOptions(), PetscSFSetType()
+   Notes:
+   This is PetscSFSetUpBegin() followed by PetscSFSetUpEnd().
+
+.seealso: PetscSFSetFromOptions(), PetscSFSetType(), PetscSFSetUpBegin()
 @*/
 PetscErrorCode PetscSFSetUp(PetscSF sf)
 {
@@ -208,14 +215,263 @@ PetscErrorCode PetscSFSetUp(PetscSF sf)
   PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
   PetscSFCheckGraphSet(sf,1);
   if (sf->setupcalled) PetscFunctionReturn(0);
+  ierr = PetscSFSetUpBegin(sf);CHKERRQ(ierr);
+  ierr = PetscSFSetUpEnd(sf);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@
+   PetscSFSetUpBegin - begin setting up communication structures, to be completed with PetscSFSetUpEnd()
+
+   Collective
+
+   Input Arguments:
+.  sf - star forest communication object
+
+   Level: intermediate
+
+   Notes:
+   The ranks that reference the roots of each process are found with PetscCommBuildTwoSidedFReq(), whose messages
+   also carry the referenced roots; those messages are completed in PetscSFSetUpEnd(). Starting the setup of several
+   star forests before ending any of them overlaps these transfers.
+
+   A star forest created by PetscSFCreateEmbeddedSF() or PetscSFCreateInverseSF() from a star forest that is set up
+   knows which of its roots each rank references, and one created by PetscSFCompose() from two star forests that are
+   set up knows these ranks, so that their setup does not discover them again. This applies to PETSCSFBASIC and the
+   types built on it.
+
+   Communication routines call PetscSFSetUp() when needed, which ends a setup that was begun.
+
+.seealso: PetscSFSetUpEnd(), PetscSFSetUp(), PetscCommBuildTwoSidedFReq()
+@*/
+PetscErrorCode PetscSFSetUpBegin(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  PetscSFCheckGraphSet(sf,1);
+  if (sf->setupcalled || sf->setupbegun) PetscFunctionReturn(0);
   if (!((PetscObject)sf)->type_name) {ierr = PetscSFSetType(sf,PETSCSFBASIC);CHKERRQ(ierr);}
   ierr = PetscLogEventBegin(PETSCSF_SetUp,sf,0,0,0);CHKERRQ(ierr);
-  if (sf->ops->SetUp) {ierr = (*sf->ops->SetUp)(sf);CHKERRQ(ierr);}
+  if (sf->ops->SetUpBegin) {ierr = (*sf->ops->SetUpBegin)(sf);CHKERRQ(ierr);}
+  else if (sf->ops->SetUp) {ierr = (*sf->ops->SetUp)(sf);CHKERRQ(ierr);}
   ierr = PetscLogEventEnd(PETSCSF_SetUp,sf,0,0,0);CHKERRQ(ierr);
+  sf->setupbegun = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
+
+/*@
+   PetscSFSetUpEnd - complete the setup begun with PetscSFSetUpBegin()
+
+   Collective
+
+   Input Arguments:
+.  sf - star forest communication object
+
+   Level: intermediate
+
+.seealso: PetscSFSetUpBegin(), PetscSFSetUp()
+@*/
+PetscErrorCode PetscSFSetUpEnd(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  if (sf->setupcalled) PetscFunctionReturn(0);
+  if (!sf->setupbegun) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Must call PetscSFSetUpBegin() before PetscSFSetUpEnd()");
+  ierr = PetscLogEventBegin(PETSCSF_SetUp,sf,0,0,0);CHKERRQ(ierr);
+  if (sf->ops->SetUpBegin && sf->ops->SetUpEnd) {ierr = (*sf->ops->SetUpEnd)(sf);CHKERRQ(ierr);}
+  ierr = PetscLogEventEnd(PETSCSF_SetUp,sf,0,0,0);CHKERRQ(ierr);
+  sf->setupbegun  = PETSC_FALSE;
   sf->setupcalled = PETSC_TRUE;
   PetscFunctionReturn(0);
 }
 
+static PetscErrorCode PetscSFComposeRanksDestroy_Private(PetscSFComposeRanks **cr)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!*cr) PetscFunctionReturn(0);
+  ierr = PetscFree4((*cr)->toranks,(*cr)->tooffset,(*cr)->tolist,(*cr)->fromranks);CHKERRQ(ierr);
+  ierr = PetscFree3((*cr)->tolength,(*cr)->fromlength,(*cr)->reqs);CHKERRQ(ierr);
+  ierr = PetscFree((*cr)->fromlist);CHKERRQ(ierr);
+  ierr = PetscFree(*cr);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   PetscSFSetKnownRootRanks_Private - tells a PetscSF whose graph is set which other ranks reference its roots, as
+   derived from another PetscSF, so that its setup need not discover them
+
+   Input Arguments:
++  sf - the star forest, PetscSFSetGraph() must have been called
+.  agree - whether the ranks may be used only once all processes know them, see PetscSFGetKnownRootRanks_Private()
+.  n - number of ranks other than this one whose leaves reference my roots, -1 if not known
+.  ranks - those ranks, taken over by sf
+.  offset - NULL, or offsets in roots[] for each rank, of length n+1, taken over by sf
+-  roots - NULL, or my roots referenced by each rank in the order of its leaves, taken over by sf
+*/
+PetscErrorCode PetscSFSetKnownRootRanks_Private(PetscSF sf,PetscBool agree,PetscMPIInt n,PetscMPIInt *ranks,PetscInt *offset,PetscInt *roots)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (sf->setupcalled || sf->setupbegun) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"PetscSF is already set up");
+  ierr = PetscFree(sf->kranks);CHKERRQ(ierr);
+  ierr = PetscFree(sf->koffset);CHKERRQ(ierr);
+  ierr = PetscFree(sf->kroots);CHKERRQ(ierr);
+  ierr = PetscSFComposeRanksDestroy_Private(&sf->kcompose);CHKERRQ(ierr);
+  sf->nkranks = n;
+  sf->kranks  = ranks;
+  sf->koffset = offset;
+  sf->kroots  = roots;
+  sf->kagree  = agree;
+  PetscFunctionReturn(0);
+}
+
+/*
+   Each process sends to the root ranks of sfA the ranks with leaves of sfB attached to them, and the ranks it receives
+   from the incoming ranks of sfA are the incoming ranks of the composed star forest. The lengths of the lists are sent
+   ahead of them, so that all receives can be posted without probing.
+*/
+static PetscErrorCode PetscSFComposeRanksExchangeBegin_Private(PetscSF sf)
+{
+  PetscSFComposeRanks *cr = sf->kcompose;
+  MPI_Comm            comm;
+  PetscMPIInt         rank;
+  PetscInt            i;
+  PetscErrorCode      ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectGetComm((PetscObject)sf,&comm);CHKERRQ(ierr);
+  ierr = PetscObjectGetNewTag((PetscObject)sf,&cr->tag);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+  ierr = PetscMalloc3(cr->nto,&cr->tolength,cr->nfrom,&cr->fromlength,2*cr->nto+cr->nfrom,&cr->reqs);CHKERRQ(ierr);
+  for (i=0; i<cr->nfrom; i++) {
+    ierr = MPI_Irecv(cr->fromlength+i,1,MPIU_INT,cr->fromranks[i],cr->tag,comm,&cr->reqs[2*cr->nto+i]);CHKERRQ(ierr);
+  }
+  for (i=0; i<cr->nto; i++) {
+    PetscMPIInt nsend;
+    cr->tolength[i] = cr->tooffset[i+1]-cr->tooffset[i];
+    if (cr->toranks[i] == rank) {
+      cr->reqs[2*i] = cr->reqs[2*i+1] = MPI_REQUEST_NULL;
+      continue;
+    }
+    ierr = PetscMPIIntCast(cr->tolength[i],&nsend);CHKERRQ(ierr);
+    ierr = MPI_Isend(cr->tolength+i,1,MPIU_INT,cr->toranks[i],cr->tag,comm,&cr->reqs[2*i]);CHKERRQ(ierr);
+    ierr = MPI_Isend(cr->tolist+cr->tooffset[i],nsend,MPIU_INT,cr->toranks[i],cr->tag,comm,&cr->reqs[2*i+1]);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/* Receives the lists of the exchange begun by PetscSFComposeRanksExchangeBegin_Private() and sets the known ranks of sf */
+static PetscErrorCode PetscSFComposeRanksExchangeEnd_Private(PetscSF sf)
+{
+  PetscSFComposeRanks *cr = sf->kcompose;
+  MPI_Comm            comm;
+  PetscMPIInt         rank,nk,*kranks;
+  PetscInt            i,n,nself = 0,*ranks;
+  MPI_Request         *rreqs = cr->reqs + 2*cr->nto;
+  PetscErrorCode      ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectGetComm((PetscObject)sf,&comm);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+  ierr = MPI_Waitall(cr->nfrom,rreqs,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+  for (i=0,n=0; i<cr->nfrom; i++) n += cr->fromlength[i];
+  for (i=0; i<cr->nto; i++) if (cr->toranks[i] == rank) nself += cr->tolength[i];
+  ierr = PetscMalloc1(n+nself,&cr->fromlist);CHKERRQ(ierr);
+  for (i=0,n=0; i<cr->nfrom; i++) {
+    PetscMPIInt nrecv;
+    ierr = PetscMPIIntCast(cr->fromlength[i],&nrecv);CHKERRQ(ierr);
+    ierr = MPI_Irecv(cr->fromlist+n,nrecv,MPIU_INT,cr->fromranks[i],cr->tag,comm,&rreqs[i]);CHKERRQ(ierr);
+    n   += cr->fromlength[i];
+  }
+  for (i=0; i<cr->nto; i++) {
+    if (cr->toranks[i] != rank) continue;
+    ierr = PetscMemcpy(cr->fromlist+n,cr->tolist+cr->tooffset[i],cr->tolength[i]*sizeof(PetscInt));CHKERRQ(ierr);
+    n   += cr->tolength[i];
+  }
+  ierr = MPI_Waitall(2*cr->nto+cr->nfrom,cr->reqs,MPI_STATUSES_IGNORE);CHKERRQ(ierr);
+
+  ranks = cr->fromlist;
+  ierr  = PetscSortRemoveDupsInt(&n,ranks);CHKERRQ(ierr);
+  ierr  = PetscMalloc1(n,&kranks);CHKERRQ(ierr);
+  for (i=0,nk=0; i<n; i++) if (ranks[i] != rank) {ierr = PetscMPIIntCast(ranks[i],&kranks[nk++]);CHKERRQ(ierr);}
+  /* the setup of sf has begun, so the ranks are set directly rather than with PetscSFSetKnownRootRanks_Private() */
+  ierr = PetscSFComposeRanksDestroy_Private(&sf->kcompose);CHKERRQ(ierr);
+  sf->nkranks = nk;
+  sf->kranks  = kranks;
+  PetscFunctionReturn(0);
+}
+
+/*
+   PetscSFGetKnownRootRanksBegin_Private - starts getting the other ranks that reference the roots of a PetscSF, as
+   derived from the PetscSF it was created from
+
+   Collective
+
+   Input Argument:
+.  sf - the star forest, whose setup is beginning
+
+   Output Argument:
+.  known - whether the ranks are known, they are then available from PetscSFGetKnownRootRanksEnd_Private()
+
+   Notes:
+   The communication needed to derive the ranks is only done here, so that it is left out for the star forests whose
+   type does not use them. It replaces the discovery of the ranks in the setup of the types that do. The ranks of a
+   PetscSF created by PetscSFCompose() are exchanged between this call and PetscSFGetKnownRootRanksEnd_Private(); the
+   others are available immediately.
+*/
+PetscErrorCode PetscSFGetKnownRootRanksBegin_Private(PetscSF sf,PetscBool *known)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (sf->kagree) {
+    PetscBool lknown = (PetscBool)(sf->nkranks >= 0),gknown;
+    ierr = MPIU_Allreduce(&lknown,&gknown,1,MPIU_BOOL,MPI_LAND,PetscObjectComm((PetscObject)sf));CHKERRQ(ierr);
+    if (gknown) sf->kagree = PETSC_FALSE;
+    else {ierr = PetscSFSetKnownRootRanks_Private(sf,PETSC_FALSE,-1,NULL,NULL,NULL);CHKERRQ(ierr);}
+  }
+  if (sf->kcompose) {ierr = PetscSFComposeRanksExchangeBegin_Private(sf);CHKERRQ(ierr);}
+  *known = (PetscBool)(sf->nkranks >= 0 || sf->kcompose);
+  PetscFunctionReturn(0);
+}
+
+/*
+   PetscSFGetKnownRootRanksEnd_Private - gets the ranks whose derivation was begun by PetscSFGetKnownRootRanksBegin_Private()
+
+   Collective if the ranks are exchanged
+
+   Input Argument:
+.  sf - the star forest
+
+   Output Arguments:
++  n - number of ranks other than this one whose leaves reference my roots, -1 if not known
+.  ranks - those ranks
+.  offset - NULL, or offsets in roots[] for each rank
+-  roots - NULL, or my roots referenced by each rank in the order of its leaves
+*/
+PetscErrorCode PetscSFGetKnownRootRanksEnd_Private(PetscSF sf,PetscMPIInt *n,const PetscMPIInt **ranks,const PetscInt **offset,const PetscInt **roots)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (sf->kcompose) {
+    if (!sf->kcompose->reqs) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Must call PetscSFGetKnownRootRanksBegin_Private() first");
+    ierr = PetscSFComposeRanksExchangeEnd_Private(sf);CHKERRQ(ierr);
+  }
+  *n = sf->nkranks;
+  if (ranks)  *ranks  = sf->kranks;
+  if (offset) *offset = sf->koffset;
+  if (roots)  *roots  = sf->kroots;
+  PetscFunctionReturn(0);
+}
+
 /*@
    PetscSFSetFromOptions - set PetscSF options using the options database
 
@@ -383,6 +639,57 @@ PetscErrorCode PetscSFSetGraph(PetscSF sf,PetscInt nroots,PetscInt nleaves,const
   PetscFunctionReturn(0);
 }
 
+/*
+   The leaves of the inverse reference the leaves of sf on the ranks owning the roots, in the order of those roots, so
+   the incoming ranks of the inverse are the root ranks of sf and each references my leaf locations sorted by root.
+   This holds when all roots have degree at most one, which the processes agree on when the setup of the inverse asks
+   for its known ranks.
+*/
+static PetscErrorCode PetscSFInverseSetKnownRootRanks_Private(PetscSF sf,PetscSF isf)
+{
+  PetscMPIInt       rank,nk,*kranks;
+  PetscInt          i,n,niranks,*koffset,*kroots,*remote;
+  const PetscInt    *ioffset,*irootloc;
+  PetscBool         known = PETSC_TRUE;
+  PetscBT           bt;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (!sf->setupcalled || !sf->ops->GetRootRanks) PetscFunctionReturn(0);
+  ierr = (*sf->ops->GetRootRanks)(sf,&niranks,NULL,NULL,&ioffset,&irootloc);CHKERRQ(ierr);
+  ierr = PetscBTCreate(sf->nroots,&bt);CHKERRQ(ierr);
+  for (i=0; i<ioffset[niranks]; i++) if (PetscBTLookupSet(bt,irootloc[i])) {known = PETSC_FALSE; break;}
+  ierr = PetscBTDestroy(&bt);CHKERRQ(ierr);
+  if (!known) {
+    ierr = PetscSFSetKnownRootRanks_Private(isf,PETSC_TRUE,-1,NULL,NULL,NULL);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = MPI_Comm_rank(PetscObjectComm((PetscObject)sf),&rank);CHKERRQ(ierr);
+  for (i=0,nk=0,n=0; i<sf->nranks; i++) {
+    if (sf->ranks[i] == rank) continue;
+    nk++;
+    n += sf->roffset[i+1] - sf->roffset[i];
+  }
+  ierr = PetscMalloc1(nk,&kranks);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nk+1,&koffset);CHKERRQ(ierr);
+  ierr = PetscMalloc1(n,&kroots);CHKERRQ(ierr);
+  ierr = PetscMalloc1(n,&remote);CHKERRQ(ierr);
+  koffset[0] = 0;
+  for (i=0,nk=0; i<sf->nranks; i++) {
+    PetscInt len = sf->roffset[i+1] - sf->roffset[i];
+    if (sf->ranks[i] == rank) continue;
+    kranks[nk] = sf->ranks[i];
+    ierr = PetscMemcpy(remote+koffset[nk],sf->rremote+sf->roffset[i],len*sizeof(PetscInt));CHKERRQ(ierr);
+    ierr = PetscMemcpy(kroots+koffset[nk],sf->rmine+sf->roffset[i],len*sizeof(PetscInt));CHKERRQ(ierr);
+    ierr = PetscSortIntWithArray(len,remote+koffset[nk],kroots+koffset[nk]);CHKERRQ(ierr);
+    koffset[nk+1] = koffset[nk] + len;
+    nk++;
+  }
+  ierr = PetscFree(remote);CHKERRQ(ierr);
+  ierr = PetscSFSetKnownRootRanks_Private(isf,PETSC_TRUE,nk,kranks,koffset,kroots);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /*@
    PetscSFCreateInverseSF - given a PetscSF in which all vertices have degree 1, creates the inverse map
 
@@ -449,6 +756,7 @@ PetscErrorCode PetscSFCreateInverseSF(PetscSF sf,PetscSF *isf)
 
   ierr = PetscSFDuplicate(sf,PETSCSF_DUPLICATE_CONFONLY,isf);CHKERRQ(ierr);
   ierr = PetscSFSetGraph(*isf,maxlocal,count,newilocal,PETSC_OWN_POINTER,roots,PETSC_COPY_VALUES);CHKERRQ(ierr);
+  ierr = PetscSFInverseSetKnownRootRanks_Private(sf,*isf);CHKERRQ(ierr);
   ierr = PetscFree2(roots,leaves);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -920,6 +1228,54 @@ PetscErrorCode PetscSFGetMultiSF(PetscSF sf,PetscSF *multi)
   PetscFunctionReturn(0);
 }
 
+/*
+   The embedded star forest keeps the edges of sf to the selected roots, so the roots referenced by each incoming rank
+   are those of sf that are selected. Leaves of sf sharing a location are kept or dropped together, which the roots
+   cannot predict, so nothing is derived when any process has them; the processes agree on this when the setup of the
+   embedded star forest asks for its known ranks.
+*/
+static PetscErrorCode PetscSFEmbeddedSetKnownRootRanks_Private(PetscSF sf,const PetscInt *rootselected,PetscInt leafsize,PetscSF esf)
+{
+  PetscMPIInt       rank,nk,*kranks;
+  PetscInt          i,j,n,niranks,*koffset,*kroots;
+  const PetscMPIInt *iranks;
+  const PetscInt    *ioffset,*irootloc;
+  PetscBool         known = PETSC_TRUE;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (!sf->setupcalled || !sf->ops->GetRootRanks) PetscFunctionReturn(0);
+  if (sf->mine) {
+    PetscBT bt;
+    ierr = PetscBTCreate(leafsize,&bt);CHKERRQ(ierr);
+    for (i=0; i<sf->nleaves; i++) if (PetscBTLookupSet(bt,sf->mine[i])) {known = PETSC_FALSE; break;}
+    ierr = PetscBTDestroy(&bt);CHKERRQ(ierr);
+  }
+  if (!known) {
+    ierr = PetscSFSetKnownRootRanks_Private(esf,PETSC_TRUE,-1,NULL,NULL,NULL);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = MPI_Comm_rank(PetscObjectComm((PetscObject)sf),&rank);CHKERRQ(ierr);
+  ierr = (*sf->ops->GetRootRanks)(sf,&niranks,NULL,&iranks,&ioffset,&irootloc);CHKERRQ(ierr);
+  for (i=0,nk=0,n=0; i<niranks; i++) {
+    PetscInt cnt = 0;
+    if (iranks[i] == rank) continue;
+    for (j=ioffset[i]; j<ioffset[i+1]; j++) if (rootselected[irootloc[j]]) cnt++;
+    if (cnt) {nk++; n += cnt;}
+  }
+  ierr = PetscMalloc1(nk,&kranks);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nk+1,&koffset);CHKERRQ(ierr);
+  ierr = PetscMalloc1(n,&kroots);CHKERRQ(ierr);
+  koffset[0] = 0;
+  for (i=0,nk=0,n=0; i<niranks; i++) {
+    if (iranks[i] == rank) continue;
+    for (j=ioffset[i]; j<ioffset[i+1]; j++) if (rootselected[irootloc[j]]) kroots[n++] = irootloc[j];
+    if (n > koffset[nk]) {kranks[nk] = iranks[i]; koffset[++nk] = n;}
+  }
+  ierr = PetscSFSetKnownRootRanks_Private(esf,PETSC_TRUE,nk,kranks,koffset,kroots);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /*@C
    PetscSFCreateEmbeddedSF - removes edges from all but the selected roots, does not remap indices
 
@@ -975,6 +1331,7 @@ PetscErrorCode PetscSFCreateEmbeddedSF(PetscSF sf,PetscInt nroots,const PetscInt
   if (n != nleaves) SETERRQ2(PETSC_COMM_SELF, PETSC_ERR_PLIB, "There is a size mismatch in the SF embedding, %d != %d", n, nleaves);
   ierr = PetscSFDuplicate(sf,PETSCSF_DUPLICATE_RANKS,newsf);CHKERRQ(ierr);
   ierr = PetscSFSetGraph(*newsf,sf->nroots,nleaves,ilocal,PETSC_OWN_POINTER,iremote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+  ierr = PetscSFEmbeddedSetKnownRootRanks_Private(sf,rootdata,leafsize,*newsf);CHKERRQ(ierr);
   ierr = PetscFree2(rootdata,leafdata);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -1047,7 +1404,8 @@ PetscErrorCode PetscSFBcastBegin(PetscSF sf,MPI_Datatype unit,const void *rootda
   PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
   ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
   ierr = PetscLogEventBegin(PETSCSF_BcastBegin,sf,0,0,0);CHKERRQ(ierr);
-  ierr = (*sf->ops->BcastBegin)(sf,unit,rootdata,leafdata);CHKERRQ(ierr);
+  if (sf->ops->BcastBegin) {ierr = (*sf->ops->BcastBegin)(sf,unit,rootdata,leafdata);CHKERRQ(ierr);}
+  else {ierr = (*sf->ops->BcastAndOpBegin)(sf,unit,rootdata,leafdata,MPIU_REPLACE);CHKERRQ(ierr);}
   ierr = PetscLogEventEnd(PETSCSF_BcastBegin,sf,0,0,0);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -1077,7 +1435,83 @@ PetscErrorCode PetscSFBcastEnd(PetscSF sf,MPI_Datatype unit,const void *rootdata
   PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
   ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
   ierr = PetscLogEventBegin(PETSCSF_BcastEnd,sf,0,0,0);CHKERRQ(ierr);
-  ierr = (*sf->ops->BcastEnd)(sf,unit,rootdata,leafdata);CHKERRQ(ierr);
+  if (sf->ops->BcastEnd) {ierr = (*sf->ops->BcastEnd)(sf,unit,rootdata,leafdata);CHKERRQ(ierr);}
+  else {ierr = (*sf->ops->BcastAndOpEnd)(sf,unit,rootdata,leafdata,MPIU_REPLACE);CHKERRQ(ierr);}
+  ierr = PetscLogEventEnd(PETSCSF_BcastEnd,sf,0,0,0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@C
+   PetscSFBcastAndOpBegin - begin pointwise broadcast with reduction, to be concluded with call to PetscSFBcastAndOpEnd()
+
+   Collective on PetscSF
+
+   Input Arguments:
++  sf - star forest on which to communicate
+.  unit - data type associated with each node
+.  rootdata - buffer to broadcast
+-  op - operation to use for reduction
+
+   Output Arguments:
+.  leafdata - buffer to be reduced with values from each leaf's respective root
+
+   Notes:
+   Each leaf is combined with the value of its root as leafdata = leafdata op rootdata; with MPIU_REPLACE this is
+   PetscSFBcastBegin(). PETSCSFWINDOW only supports MPIU_REPLACE.
+
+   Level: intermediate
+
+.seealso: PetscSFBcastAndOpEnd(), PetscSFBcastBegin(), PetscSFReduceBegin()
+@*/
+PetscErrorCode PetscSFBcastAndOpBegin(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  if (!sf->ops->BcastAndOpBegin) {
+    if (op != MPIU_REPLACE) SETERRQ1(PetscObjectComm((PetscObject)sf),PETSC_ERR_SUP,"PetscSF type %s only broadcasts with MPIU_REPLACE",((PetscObject)sf)->type_name);
+    ierr = PetscSFBcastBegin(sf,unit,rootdata,leafdata);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(PETSCSF_BcastBegin,sf,0,0,0);CHKERRQ(ierr);
+  ierr = (*sf->ops->BcastAndOpBegin)(sf,unit,rootdata,leafdata,op);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(PETSCSF_BcastBegin,sf,0,0,0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@C
+   PetscSFBcastAndOpEnd - end a broadcast with reduction started with PetscSFBcastAndOpBegin()
+
+   Collective
+
+   Input Arguments:
++  sf - star forest
+.  unit - data type
+.  rootdata - buffer to broadcast
+-  op - operation to use for reduction
+
+   Output Arguments:
+.  leafdata - buffer to be reduced with values from each leaf's respective root
+
+   Level: intermediate
+
+.seealso: PetscSFBcastAndOpBegin(), PetscSFBcastEnd(), PetscSFReduceEnd()
+@*/
+PetscErrorCode PetscSFBcastAndOpEnd(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata,MPI_Op op)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  if (!sf->ops->BcastAndOpEnd) {
+    ierr = PetscSFBcastEnd(sf,unit,rootdata,leafdata);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
+  ierr = PetscLogEventBegin(PETSCSF_BcastEnd,sf,0,0,0);CHKERRQ(ierr);
+  ierr = (*sf->ops->BcastAndOpEnd)(sf,unit,rootdata,leafdata,op);CHKERRQ(ierr);
   ierr = PetscLogEventEnd(PETSCSF_BcastEnd,sf,0,0,0);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -1144,6 +1578,36 @@ PetscErrorCode PetscSFReduceEnd(PetscSF sf,MPI_Datatype unit,const void *leafdat
   PetscFunctionReturn(0);
 }
 
+/*@
+   PetscSFProgress - let MPI move the messages of the operations begun on a star forest and not yet ended, without
+   waiting for them
+
+   Not Collective
+
+   Input Arguments:
+.  sf - star forest
+
+   Level: developer
+
+   Notes:
+   Many MPI implementations only move the messages of nonblocking operations while the process is inside MPI. Calling
+   this routine from time to time during the local computation done between, for example, PetscSFBcastBegin() and
+   PetscSFBcastEnd() overlaps that computation with the communication. The operations must still be ended as usual.
+
+   It does nothing for the types that do not keep requests, such as PETSCSFWINDOW, and before PetscSFSetUp().
+
+.seealso: PetscSFBcastBegin(), PetscSFReduceBegin(), VecScatterProgress()
+@*/
+PetscErrorCode PetscSFProgress(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(sf,PETSCSF_CLASSID,1);
+  if (sf->setupcalled && sf->ops->Progress) {ierr = (*sf->ops->Progress)(sf);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
 /*@C
    PetscSFComputeDegreeBegin - begin computation of degree for each root vertex, to be completed with PetscSFComputeDegreeEnd()
 
@@ -1446,6 +1910,73 @@ PetscErrorCode PetscSFScatterEnd(PetscSF sf,MPI_Datatype unit,const void *multir
   PetscFunctionReturn(0);
 }
 
+/*
+   A leaf of sfBA on rank s references a root of sfA on rank p when it references a root j of sfB on some rank q whose
+   leaf j of sfA references p. Each q therefore tells each root rank p of sfA which ranks s reference the roots of sfB
+   attached to p, and p receives these lists from the incoming ranks of sfA. Only the lists are made here, they are
+   exchanged during the setup of sfBA when it asks for its known ranks, in place of discovering them. The roots
+   referenced by those ranks are exchanged in that setup.
+*/
+static PetscErrorCode PetscSFComposeSetKnownRootRanks_Private(PetscSF sfA,PetscSF sfB,PetscSF sfBA)
+{
+  PetscSFComposeRanks *cr;
+  PetscMPIInt         rank;
+  PetscInt            i,j,k,m,n,irank,nbranks,naranks,*p,*s,*start,*len;
+  const PetscMPIInt   *branks,*aranks;
+  const PetscInt      *boffset,*brootloc;
+  PetscErrorCode      ierr;
+
+  PetscFunctionBegin;
+  if (!sfA->setupcalled || !sfB->setupcalled || !sfA->ops->GetRootRanks || !sfB->ops->GetRootRanks) PetscFunctionReturn(0);
+  ierr = MPI_Comm_rank(PetscObjectComm((PetscObject)sfA),&rank);CHKERRQ(ierr);
+
+  /* Pairs (p,s) sorted by p, with the ranks s of each p sorted and unique */
+  ierr = (*sfB->ops->GetRootRanks)(sfB,&nbranks,NULL,&branks,&boffset,&brootloc);CHKERRQ(ierr);
+  ierr = PetscMalloc2(boffset[nbranks],&p,boffset[nbranks],&s);CHKERRQ(ierr);
+  for (i=0,n=0; i<nbranks; i++) {
+    for (j=boffset[i]; j<boffset[i+1]; j++,n++) {
+      if (brootloc[j] >= sfA->nleaves) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Root %D of sfB has no leaf in sfA with %D leaves",brootloc[j],sfA->nleaves);
+      p[n] = sfA->remote[brootloc[j]].rank;
+      s[n] = branks[i];
+    }
+  }
+  ierr = PetscSortIntWithArray(n,p,s);CHKERRQ(ierr);
+  ierr = PetscCalloc2(sfA->nranks,&start,sfA->nranks,&len);CHKERRQ(ierr);
+  for (i=0,k=0; i<n; i=j) {
+    PetscInt nsi;
+    for (j=i; j<n && p[j] == p[i]; j++) ;
+    nsi  = j - i;
+    ierr = PetscSortRemoveDupsInt(&nsi,s+i);CHKERRQ(ierr);
+    ierr = PetscFindMPIInt((PetscMPIInt)p[i],sfA->ndranks,sfA->ranks,&irank);CHKERRQ(ierr);
+    if (irank < 0) {
+      ierr = PetscFindMPIInt((PetscMPIInt)p[i],sfA->nranks-sfA->ndranks,sfA->ranks+sfA->ndranks,&irank);CHKERRQ(ierr);
+      if (irank >= 0) irank += sfA->ndranks;
+    }
+    if (irank < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Could not find rank %D in the root ranks of sfA",p[i]);
+    start[irank] = k;
+    len[irank]   = nsi;
+    for (m=0; m<nsi; m++,k++) s[k] = s[i+m];
+  }
+
+  /* The list of each root rank of sfA, possibly empty, and the incoming ranks of sfA to receive lists from */
+  ierr = (*sfA->ops->GetRootRanks)(sfA,&naranks,NULL,&aranks,NULL,NULL);CHKERRQ(ierr);
+  ierr = PetscNew(&cr);CHKERRQ(ierr);
+  ierr = PetscMalloc4(sfA->nranks,&cr->toranks,sfA->nranks+1,&cr->tooffset,k,&cr->tolist,naranks,&cr->fromranks);CHKERRQ(ierr);
+  cr->nto         = sfA->nranks;
+  cr->tooffset[0] = 0;
+  for (i=0; i<sfA->nranks; i++) {
+    cr->toranks[i]    = sfA->ranks[i];
+    cr->tooffset[i+1] = cr->tooffset[i] + len[i];
+    ierr = PetscMemcpy(cr->tolist+cr->tooffset[i],s+start[i],len[i]*sizeof(PetscInt));CHKERRQ(ierr);
+  }
+  for (i=0,cr->nfrom=0; i<naranks; i++) if (aranks[i] != rank) cr->fromranks[cr->nfrom++] = aranks[i];
+  ierr = PetscFree2(start,len);CHKERRQ(ierr);
+  ierr = PetscFree2(p,s);CHKERRQ(ierr);
+  ierr = PetscSFSetKnownRootRanks_Private(sfBA,PETSC_FALSE,-1,NULL,NULL,NULL);CHKERRQ(ierr);
+  sfBA->kcompose = cr;
+  PetscFunctionReturn(0);
+}
+
 /*@
   PetscSFCompose - Compose a new PetscSF equivalent to action to PetscSFs
 
@@ -1483,5 +2014,6 @@ PetscErrorCode PetscSFCompose(PetscSF sfA, PetscSF sfB, PetscSF *sfBA)
   ierr = PetscSFBcastEnd(sfB, MPIU_2INT, remotePointsA, remotePointsBA);CHKERRQ(ierr);
   ierr = PetscSFCreate(comm, sfBA);CHKERRQ(ierr);
   ierr = PetscSFSetGraph(*sfBA, numRootsA, numLeavesB, localPointsB, PETSC_COPY_VALUES, remotePointsBA, PETSC_OWN_POINTER);CHKERRQ(ierr);
+  ierr = PetscSFComposeSetKnownRootRanks_Private(sfA, sfB, *sfBA);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
@@ -4,6 +4,13 @@ PETSC_EXTERN PetscErrorCode PetscSFCreate_Basic(PetscSF);
 #if defined(PETSC_HAVE_MPI_WIN_CREATE) && defined(PETSC_HAVE_MPI_TYPE_DUP)
 PETSC_EXTERN PetscErrorCode PetscSFCreate_Window(PetscSF);
 #endif
+#if defined(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+PETSC_EXTERN PetscErrorCode PetscSFCreate_Neighbor(PetscSF);
+#endif
+#if defined(PETSC_HAVE_MPI_PROCESS_SHARED_MEMORY)
+PETSC_EXTERN PetscErrorCode PetscSFCreate_Shared(PetscSF);
+#endif
+PETSC_EXTERN PetscErrorCode PetscSFCreate_Auto(PetscSF);
 
 PetscFunctionList PetscSFList;
 PetscBool         PetscSFRegisterAllCalled;
@@ -30,6 +37,13 @@ PetscErrorCode  PetscSFRegisterAll(void)
 #if defined(PETSC_HAVE_MPI_WIN_CREATE) && defined(PETSC_HAVE_MPI_TYPE_DUP)
   ierr = PetscSFRegister(PETSCSFWINDOW, PetscSFCreate_Window);CHKERRQ(ierr);
 #endif
+#if defined(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+  ierr = PetscSFRegister(PETSCSFNEIGHBOR,PetscSFCreate_Neighbor);CHKERRQ(ierr);
+#endif
+#if defined(PETSC_HAVE_MPI_PROCESS_SHARED_MEMORY)
+  ierr = PetscSFRegister(PETSCSFSHARED,  PetscSFCreate_Shared);CHKERRQ(ierr);
+#endif
+  ierr = PetscSFRegister(PETSCSFAUTO,   PetscSFCreate_Auto);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -0,0 +1,159 @@
+static char help[] = "Tests VecMAXPYMDot(), and VecMDot() and VecMAXPY() with vectors that share a single array.\n\n";
+
+#include <petscvec.h>
+
+/* Prints whether the largest difference is within a tolerance, the difference itself depends on the rounding of each path */
+static PetscErrorCode CheckError(const char *name,PetscReal err,PetscReal scale)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (err > 100*PETSC_MACHINE_EPSILON*PetscMax(scale,1.0)) {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: largest difference %g\n",name,(double)err);CHKERRQ(ierr);
+  } else {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: largest difference within tolerance\n",name);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode CheckScalars(const char *name,PetscInt nv,const PetscScalar a[],const PetscScalar b[])
+{
+  PetscErrorCode ierr;
+  PetscInt       j;
+  PetscReal      err = 0.0,scale = 0.0;
+
+  PetscFunctionBegin;
+  for (j=0; j<nv; j++) {
+    err   = PetscMax(err,PetscAbsScalar(a[j]-b[j]));
+    scale = PetscMax(scale,PetscAbsScalar(a[j]));
+  }
+  ierr = CheckError(name,err,scale);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode CheckVecs(const char *name,Vec a,Vec b)
+{
+  PetscErrorCode ierr;
+  Vec            d;
+  PetscReal      err,scale;
+
+  PetscFunctionBegin;
+  ierr = VecDuplicate(a,&d);CHKERRQ(ierr);
+  ierr = VecWAXPY(d,-1.0,a,b);CHKERRQ(ierr);
+  ierr = VecNorm(d,NORM_INFINITY,&err);CHKERRQ(ierr);
+  ierr = VecNorm(a,NORM_INFINITY,&scale);CHKERRQ(ierr);
+  ierr = CheckError(name,err,scale);CHKERRQ(ierr);
+  ierr = VecDestroy(&d);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+int main(int argc,char **argv)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    size;
+  PetscInt       n = 1000,nv = 7,nloc,N,j;
+  Vec            x,*v,*c,y1,y2,y3,y4;
+  PetscScalar    *alpha,*d1,*d2,*d3,*array;
+  PetscReal      n1,n2,n3,n4,nc;
+  PetscRandom    rand;
+
+  ierr = PetscInitialize(&argc,&argv,(char*)0,help);if (ierr) return ierr;
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-nv",&nv,NULL);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_WORLD,&rand);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rand);CHKERRQ(ierr);
+
+  ierr = VecCreate(PETSC_COMM_WORLD,&x);CHKERRQ(ierr);
+  ierr = VecSetSizes(x,PETSC_DECIDE,n);CHKERRQ(ierr);
+  ierr = VecSetFromOptions(x);CHKERRQ(ierr);
+  ierr = VecGetLocalSize(x,&nloc);CHKERRQ(ierr);
+  ierr = VecGetSize(x,&N);CHKERRQ(ierr);
+
+  /* the same vectors allocated separately and one after the other in a single array */
+  ierr = VecDuplicateVecs(x,nv,&v);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nv,&c);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nv*nloc,&array);CHKERRQ(ierr);
+  for (j=0; j<nv; j++) {
+    if (size == 1) {
+      ierr = VecCreateSeqWithArray(PETSC_COMM_SELF,1,nloc,array+j*nloc,&c[j]);CHKERRQ(ierr);
+    } else {
+      ierr = VecCreateMPIWithArray(PETSC_COMM_WORLD,1,nloc,N,array+j*nloc,&c[j]);CHKERRQ(ierr);
+    }
+    ierr = VecSetRandom(v[j],rand);CHKERRQ(ierr);
+    ierr = VecCopy(v[j],c[j]);CHKERRQ(ierr);
+  }
+  ierr = PetscMalloc4(nv,&alpha,nv,&d1,nv,&d2,nv,&d3);CHKERRQ(ierr);
+  for (j=0; j<nv; j++) alpha[j] = 1.0/(j+1) - 0.3;
+
+  ierr = VecDuplicate(x,&y1);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y2);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y3);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y4);CHKERRQ(ierr);
+  ierr = VecSetRandom(y1,rand);CHKERRQ(ierr);
+  ierr = VecCopy(y1,y2);CHKERRQ(ierr);
+  ierr = VecCopy(y1,y3);CHKERRQ(ierr);
+  ierr = VecCopy(y1,y4);CHKERRQ(ierr);
+
+  ierr = VecMAXPY(y1,nv,alpha,v);CHKERRQ(ierr);
+  ierr = VecMDot(y1,nv,v,d1);CHKERRQ(ierr);
+  ierr = VecNorm(y1,NORM_2,&n1);CHKERRQ(ierr);
+
+  ierr = VecMAXPYMDot(y2,nv,alpha,v,d2,&n2);CHKERRQ(ierr);
+  ierr = CheckVecs("VecMAXPYMDot() updates",y1,y2);CHKERRQ(ierr);
+  ierr = CheckScalars("VecMAXPYMDot() dot products",nv,d1,d2);CHKERRQ(ierr);
+  ierr = CheckError("VecMAXPYMDot() norm",PetscAbsReal(n1-n2),n1);CHKERRQ(ierr);
+
+  /* only the norm, which is then cached */
+  ierr = VecMAXPYMDot(y4,nv,alpha,v,NULL,&n4);CHKERRQ(ierr);
+  ierr = CheckVecs("VecMAXPYMDot() updates without dot products",y1,y4);CHKERRQ(ierr);
+  ierr = VecNorm(y4,NORM_2,&nc);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"VecNorm() %s the norm of VecMAXPYMDot()\n",nc == n4 ? "returns" : "does not return");CHKERRQ(ierr);
+
+  /* VecMAXPY() and VecMDot() with contiguous vectors */
+  ierr = VecMAXPY(y3,nv,alpha,c);CHKERRQ(ierr);
+  ierr = VecMDot(y3,nv,c,d3);CHKERRQ(ierr);
+  ierr = VecNorm(y3,NORM_2,&n3);CHKERRQ(ierr);
+  ierr = CheckVecs("VecMAXPY() updates with contiguous vectors",y1,y3);CHKERRQ(ierr);
+  ierr = CheckScalars("VecMDot() dot products with contiguous vectors",nv,d1,d3);CHKERRQ(ierr);
+  ierr = CheckError("VecNorm() with contiguous vectors",PetscAbsReal(n1-n3),n1);CHKERRQ(ierr);
+  /* a vector of the array itself, which takes the vectors one at a time */
+  ierr = VecMAXPY(c[nv-1],nv-1,alpha,c);CHKERRQ(ierr);
+  ierr = VecMAXPY(v[nv-1],nv-1,alpha,v);CHKERRQ(ierr);
+  ierr = CheckVecs("VecMAXPY() updates of a contiguous vector",v[nv-1],c[nv-1]);CHKERRQ(ierr);
+
+  ierr = PetscFree4(alpha,d1,d2,d3);CHKERRQ(ierr);
+  ierr = VecDestroy(&y1);CHKERRQ(ierr);
+  ierr = VecDestroy(&y2);CHKERRQ(ierr);
+  ierr = VecDestroy(&y3);CHKERRQ(ierr);
+  ierr = VecDestroy(&y4);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(nv,&v);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(nv,&c);CHKERRQ(ierr);
+  ierr = PetscFree(array);CHKERRQ(ierr);
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rand);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+
+   test:
+      suffix: 2
+      nsize: 2
+      args: -nv 3
+
+   test:
+      suffix: threads
+      args: -n 25000 -vec_threads 3
+      requires: openmp
+
+   test:
+      suffix: threads_2
+      nsize: 2
+      args: -n 25000 -vec_threads 2
+      requires: openmp
+
+TEST*/
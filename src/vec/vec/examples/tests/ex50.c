@@ -0,0 +1,99 @@
+static char help[] = "Tests that the threaded VecDot(), VecMDot() and VecNorm() of -vec_threads give the same results for any number of threads,\n\
+and that VecDuplicate() keeps the threads of a vector with an options prefix.\n\n";
+
+#include <petscvec.h>
+#include <../src/vec/vec/impls/dvecimpl.h>
+
+static PetscErrorCode CreateThreadedVec(const char prefix[],PetscInt n,Vec *x)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecCreate(PETSC_COMM_WORLD,x);CHKERRQ(ierr);
+  ierr = VecSetOptionsPrefix(*x,prefix);CHKERRQ(ierr);
+  ierr = VecSetSizes(*x,PETSC_DECIDE,n);CHKERRQ(ierr);
+  ierr = VecSetFromOptions(*x);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode Reductions(Vec x,Vec y[],PetscScalar *dot,PetscScalar mdot[],PetscReal norm[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecDot(x,y[0],dot);CHKERRQ(ierr);
+  ierr = VecMDot(x,3,y,mdot);CHKERRQ(ierr);
+  ierr = VecNorm(x,NORM_1,&norm[0]);CHKERRQ(ierr);
+  ierr = VecNorm(x,NORM_2,&norm[1]);CHKERRQ(ierr);
+  ierr = VecNorm(x,NORM_INFINITY,&norm[2]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+int main(int argc,char **argv)
+{
+  PetscErrorCode ierr;
+  PetscInt       n = 50000,i,j;
+  const char     *prefix[] = {"t2_","t3_","t5_"};
+  Vec            x[3],y[3],z;
+  PetscScalar    dot[3],mdot[3][3];
+  PetscReal      norm[3][3];
+  PetscRandom    rand;
+
+  ierr = PetscInitialize(&argc,&argv,(char*)0,help);if (ierr) return ierr;
+  ierr = PetscOptionsGetInt(NULL,NULL,"-n",&n,NULL);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_WORLD,&rand);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rand);CHKERRQ(ierr);
+
+  /* the same values in vectors using 2, 3 and 5 threads */
+  for (i=0; i<3; i++) {
+    ierr = CreateThreadedVec(prefix[i],n,&x[i]);CHKERRQ(ierr);
+  }
+  ierr = VecSetRandom(x[0],rand);CHKERRQ(ierr);
+  for (j=0; j<3; j++) {
+    ierr = CreateThreadedVec(NULL,n,&y[j]);CHKERRQ(ierr);
+    ierr = VecSetRandom(y[j],rand);CHKERRQ(ierr);
+  }
+  for (i=1; i<3; i++) {
+    ierr = VecCopy(x[0],x[i]);CHKERRQ(ierr);
+  }
+  for (i=0; i<3; i++) {
+    ierr = Reductions(x[i],y,&dot[i],mdot[i],norm[i]);CHKERRQ(ierr);
+  }
+  for (i=1; i<3; i++) {
+    PetscBool same = (PetscBool)(dot[i] == dot[0]);
+    for (j=0; j<3; j++) same = (PetscBool)(same && mdot[i][j] == mdot[0][j] && norm[i][j] == norm[0][j]);
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"Vector with prefix %s: reductions %s those with prefix %s\n",prefix[i],same ? "identical to" : "differ from",prefix[0]);CHKERRQ(ierr);
+  }
+
+  /* a duplicate takes the threads of the original, not those of the unprefixed -vec_threads */
+  ierr = VecDuplicate(x[1],&z);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Duplicate of the vector with prefix %s: %D threads, original %D threads, %s operations\n",prefix[1],((Vec_Seq*)z->data)->nthreads,((Vec_Seq*)x[1]->data)->nthreads,(z->ops->dot == x[1]->ops->dot && z->ops->norm == x[1]->ops->norm) ? "same" : "different");CHKERRQ(ierr);
+  ierr = VecCopy(x[1],z);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_2,&norm[0][0]);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Norm of the duplicate %s\n",norm[0][0] == norm[1][1] ? "identical" : "differs");CHKERRQ(ierr);
+
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  for (i=0; i<3; i++) {
+    ierr = VecDestroy(&x[i]);CHKERRQ(ierr);
+    ierr = VecDestroy(&y[i]);CHKERRQ(ierr);
+  }
+  ierr = PetscRandomDestroy(&rand);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   build:
+      requires: openmp
+
+   test:
+      args: -t2_vec_threads 2 -t3_vec_threads 3 -t5_vec_threads 5
+
+   test:
+      suffix: 2
+      nsize: 2
+      args: -t2_vec_threads 2 -t3_vec_threads 3 -t5_vec_threads 5 -vec_threads 4
+      output_file: output/ex50_1.out
+
+TEST*/
@@ -188,4 +188,17 @@ int main(int argc,char **argv)
       output_file: output/ex1_1.out
       requires: cuda
 
+   test:
+      suffix: threads
+      args: -n 25000 -vec_threads 3
+      output_file: output/ex1_threads.out
+      requires: openmp
+
+   test:
+      suffix: threads_2
+      nsize: 2
+      args: -n 25000 -vec_threads 2
+      output_file: output/ex1_threads.out
+      requires: openmp
+
 TEST*/
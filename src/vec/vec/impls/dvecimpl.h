@@ -15,11 +15,16 @@ typedef struct {
   VECHEADER
 } Vec_Seq;
 
+/* number of entries VecMAXPYMDot() updates before computing their dot products; the blocks of the x vectors must fit in cache */
+#define VEC_MAXPYMDOT_BLOCK 512
+
 PETSC_INTERN PetscErrorCode VecMDot_Seq(Vec,PetscInt,const Vec[],PetscScalar*);
 PETSC_INTERN PetscErrorCode VecMTDot_Seq(Vec,PetscInt,const Vec[],PetscScalar*);
 PETSC_INTERN PetscErrorCode VecMin_Seq(Vec,PetscInt*,PetscReal*);
 PETSC_INTERN PetscErrorCode VecSet_Seq(Vec,PetscScalar);
 PETSC_INTERN PetscErrorCode VecMAXPY_Seq(Vec,PetscInt,const PetscScalar*,Vec*);
+PETSC_INTERN PetscErrorCode VecMAXPYMDot_Seq(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*);
+PETSC_INTERN PetscErrorCode VecMAXPYMDotLocal_Seq(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*);
 PETSC_INTERN PetscErrorCode VecAYPX_Seq(Vec,PetscScalar,Vec);
 PETSC_INTERN PetscErrorCode VecWAXPY_Seq(Vec,PetscScalar,Vec,Vec);
 PETSC_INTERN PetscErrorCode VecAXPBYPCZ_Seq(Vec,PetscScalar,PetscScalar,PetscScalar,Vec,Vec);
@@ -53,5 +58,16 @@ PETSC_INTERN PetscErrorCode VecPointwiseDivide_Seq(Vec,Vec,Vec);
 
 PETSC_EXTERN PetscErrorCode VecCreate_Seq(Vec);
 PETSC_INTERN PetscErrorCode VecCreate_Seq_Private(Vec,const PetscScalar[]);
+PETSC_INTERN PetscErrorCode VecSetThreadsFromOptions_Private(Vec);
+PETSC_INTERN PetscErrorCode VecDuplicateThreads_Private(Vec,Vec);
+#if defined(PETSC_HAVE_OPENMP)
+PETSC_INTERN PetscErrorCode VecDot_SeqOpenMP(Vec,Vec,PetscScalar*);
+PETSC_INTERN PetscErrorCode VecMDot_SeqOpenMP(Vec,PetscInt,const Vec[],PetscScalar*);
+PETSC_INTERN PetscErrorCode VecNorm_SeqOpenMP(Vec,NormType,PetscReal*);
+PETSC_INTERN PetscErrorCode VecAXPY_SeqOpenMP(Vec,PetscScalar,Vec);
+PETSC_INTERN PetscErrorCode VecMAXPY_SeqOpenMP(Vec,PetscInt,const PetscScalar*,Vec*);
+PETSC_INTERN PetscErrorCode VecMAXPYMDot_SeqOpenMP(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*);
+PETSC_INTERN PetscErrorCode VecMAXPYMDotLocal_SeqOpenMP(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*);
+#endif
 
 #endif
@@ -267,6 +267,7 @@ PetscErrorCode VecCreate_MPICUDA_Private(Vec vv,PetscBool alloc,PetscInt nghost,
   vv->ops->axpy                   = VecAXPY_SeqCUDA;
   vv->ops->axpby                  = VecAXPBY_SeqCUDA;
   vv->ops->maxpy                  = VecMAXPY_SeqCUDA;
+  vv->ops->maxpymdot              = NULL;
   vv->ops->aypx                   = VecAYPX_SeqCUDA;
   vv->ops->axpbypcz               = VecAXPBYPCZ_SeqCUDA;
   vv->ops->pointwisemult          = VecPointwiseMult_SeqCUDA;
@@ -59,12 +59,14 @@ static PetscErrorCode VecDuplicate_MPI(Vec win,Vec *v)
   ierr = VecCreate_MPI_Private(*v,PETSC_TRUE,w->nghost,0);CHKERRQ(ierr);
   vw   = (Vec_MPI*)(*v)->data;
   ierr = PetscMemcpy((*v)->ops,win->ops,sizeof(struct _VecOps));CHKERRQ(ierr);
+  ierr = VecDuplicateThreads_Private(win,*v);CHKERRQ(ierr);
 
   /* save local representation of the parallel vector (and scatter) if it exists */
   if (w->localrep) {
     ierr = VecGetArray(*v,&array);CHKERRQ(ierr);
     ierr = VecCreateSeqWithArray(PETSC_COMM_SELF,PetscAbs(win->map->bs),win->map->n+w->nghost,array,&vw->localrep);CHKERRQ(ierr);
     ierr = PetscMemcpy(vw->localrep->ops,w->localrep->ops,sizeof(struct _VecOps));CHKERRQ(ierr);
+    ierr = VecDuplicateThreads_Private(w->localrep,vw->localrep);CHKERRQ(ierr);
     ierr = VecRestoreArray(*v,&array);CHKERRQ(ierr);
     ierr = PetscLogObjectParent((PetscObject)*v,(PetscObject)vw->localrep);CHKERRQ(ierr);
 
@@ -468,9 +470,36 @@ static struct _VecOps DvOps = { VecDuplicate_MPI, /* 1 */
                                 VecStrideSubSetGather_Default,
                                 VecStrideSubSetScatter_Default,
                                 0,
-                                0
+                                0,
+                                0,
+                                0,
+                                0,
+                                0,
+                                VecMAXPYMDot_MPI
 };
 
+/*
+    VecSetThreadsFromOptions_MPI_Private - Installs the threaded operations requested with -vec_threads.
+    Called by the creation routines below, but not by VecDuplicate_MPI(), which takes them from the
+    original vector.
+*/
+PetscErrorCode VecSetThreadsFromOptions_MPI_Private(Vec v)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecSetThreadsFromOptions_Private(v);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_OPENMP)
+  if (((Vec_MPI*)v->data)->nthreads > 1) {
+    v->ops->dot       = VecDot_MPIOpenMP;
+    v->ops->mdot      = VecMDot_MPIOpenMP;
+    v->ops->norm      = VecNorm_MPIOpenMP;
+    v->ops->maxpymdot = VecMAXPYMDot_MPIOpenMP;
+  }
+#endif
+  PetscFunctionReturn(0);
+}
+
 /*
     VecCreate_MPI_Private - Basic create routine called by VecCreate_MPI() (i.e. VecCreateMPI()),
     VecCreateMPIWithArray(), VecCreate_Shared() (i.e. VecCreateShared()), VecCreateGhost(),
@@ -540,6 +569,7 @@ PETSC_EXTERN PetscErrorCode VecCreate_MPI(Vec vv)
 
   PetscFunctionBegin;
   ierr = VecCreate_MPI_Private(vv,PETSC_TRUE,0,0);CHKERRQ(ierr);
+  ierr = VecSetThreadsFromOptions_MPI_Private(vv);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -614,6 +644,7 @@ PetscErrorCode  VecCreateMPIWithArray(MPI_Comm comm,PetscInt bs,PetscInt n,Petsc
   ierr = VecSetSizes(*vv,n,N);CHKERRQ(ierr);
   ierr = VecSetBlockSize(*vv,bs);CHKERRQ(ierr);
   ierr = VecCreate_MPI_Private(*vv,PETSC_FALSE,0,array);CHKERRQ(ierr);
+  ierr = VecSetThreadsFromOptions_MPI_Private(*vv);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -670,6 +701,7 @@ PetscErrorCode  VecCreateGhostWithArray(MPI_Comm comm,PetscInt n,PetscInt N,Pets
   ierr = VecCreate(comm,vv);CHKERRQ(ierr);
   ierr = VecSetSizes(*vv,n,N);CHKERRQ(ierr);
   ierr = VecCreate_MPI_Private(*vv,PETSC_TRUE,nghost,array);CHKERRQ(ierr);
+  ierr = VecSetThreadsFromOptions_MPI_Private(*vv);CHKERRQ(ierr);
   w    = (Vec_MPI*)(*vv)->data;
   /* Create local representation */
   ierr = VecGetArray(*vv,&larray);CHKERRQ(ierr);
@@ -794,6 +826,7 @@ PetscErrorCode  VecMPISetGhost(Vec vv,PetscInt nghost,const PetscInt ghosts[])
     ierr = (*vv->ops->destroy)(vv);CHKERRQ(ierr);
     ierr = VecSetSizes(vv,n,N);CHKERRQ(ierr);
     ierr = VecCreate_MPI_Private(vv,PETSC_TRUE,nghost,NULL);CHKERRQ(ierr);
+    ierr = VecSetThreadsFromOptions_MPI_Private(vv);CHKERRQ(ierr);
     w    = (Vec_MPI*)(vv)->data;
     /* Create local representation */
     ierr = VecGetArray(vv,&larray);CHKERRQ(ierr);
@@ -886,6 +919,7 @@ PetscErrorCode  VecCreateGhostBlockWithArray(MPI_Comm comm,PetscInt bs,PetscInt
   ierr = VecSetSizes(*vv,n,N);CHKERRQ(ierr);
   ierr = VecSetBlockSize(*vv,bs);CHKERRQ(ierr);
   ierr = VecCreate_MPI_Private(*vv,PETSC_TRUE,nghost*bs,array);CHKERRQ(ierr);
+  ierr = VecSetThreadsFromOptions_MPI_Private(*vv);CHKERRQ(ierr);
   w    = (Vec_MPI*)(*vv)->data;
   /* Create local representation */
   ierr = VecGetArray(*vv,&larray);CHKERRQ(ierr);
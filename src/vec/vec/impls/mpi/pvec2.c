@@ -22,6 +22,41 @@ PetscErrorCode VecMDot_MPI(Vec xin,PetscInt nv,const Vec y[],PetscScalar *z)
   PetscFunctionReturn(0);
 }
 
+/* the dot products and the squared norm computed by the local kernel share one reduction */
+static PetscErrorCode VecMAXPYMDot_MPI_Private(Vec yin,PetscInt nv,const PetscScalar *alpha,Vec *x,PetscScalar *z,PetscReal *norm,PetscErrorCode (*local)(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*))
+{
+  PetscScalar    awork[2*129],*work = awork,*sum;
+  PetscReal      nrm2;
+  PetscInt       j,cnt = z ? nv : 0;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (cnt+1 > 129) {
+    ierr = PetscMalloc1(2*(cnt+1),&work);CHKERRQ(ierr);
+  }
+  sum  = work + cnt + 1;
+  ierr = (*local)(yin,nv,alpha,x,z ? work : NULL,norm ? &nrm2 : NULL);CHKERRQ(ierr);
+  if (norm) work[cnt++] = nrm2;
+  if (cnt) {
+    ierr = MPIU_Allreduce(work,sum,cnt,MPIU_SCALAR,MPIU_SUM,PetscObjectComm((PetscObject)yin));CHKERRQ(ierr);
+  }
+  if (z) for (j=0; j<nv; j++) z[j] = sum[j];
+  if (norm) *norm = PetscSqrtReal(PetscRealPart(sum[cnt-1]));
+  if (work != awork) {
+    ierr = PetscFree(work);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecMAXPYMDot_MPI(Vec yin,PetscInt nv,const PetscScalar *alpha,Vec *x,PetscScalar *z,PetscReal *norm)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecMAXPYMDot_MPI_Private(yin,nv,alpha,x,z,norm,VecMAXPYMDotLocal_Seq);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 PetscErrorCode VecMTDot_MPI(Vec xin,PetscInt nv,const Vec y[],PetscScalar *z)
 {
   PetscScalar    awork[128],*work = awork;
@@ -78,6 +113,78 @@ PetscErrorCode VecNorm_MPI(Vec xin,NormType type,PetscReal *z)
   PetscFunctionReturn(0);
 }
 
+#if defined(PETSC_HAVE_OPENMP)
+/*
+   Versions used with -vec_threads; the local part is computed by the threaded kernels in
+   bvecomp.c so the results do not depend on the number of threads
+*/
+PetscErrorCode VecDot_MPIOpenMP(Vec xin,Vec yin,PetscScalar *z)
+{
+  PetscScalar    sum,work;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecDot_SeqOpenMP(xin,yin,&work);CHKERRQ(ierr);
+  ierr = MPIU_Allreduce(&work,&sum,1,MPIU_SCALAR,MPIU_SUM,PetscObjectComm((PetscObject)xin));CHKERRQ(ierr);
+  *z   = sum;
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecMDot_MPIOpenMP(Vec xin,PetscInt nv,const Vec y[],PetscScalar *z)
+{
+  PetscScalar    awork[128],*work = awork;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (nv > 128) {
+    ierr = PetscMalloc1(nv,&work);CHKERRQ(ierr);
+  }
+  ierr = VecMDot_SeqOpenMP(xin,nv,y,work);CHKERRQ(ierr);
+  ierr = MPIU_Allreduce(work,z,nv,MPIU_SCALAR,MPIU_SUM,PetscObjectComm((PetscObject)xin));CHKERRQ(ierr);
+  if (nv > 128) {
+    ierr = PetscFree(work);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecMAXPYMDot_MPIOpenMP(Vec yin,PetscInt nv,const PetscScalar *alpha,Vec *x,PetscScalar *z,PetscReal *norm)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecMAXPYMDot_MPI_Private(yin,nv,alpha,x,z,norm,VecMAXPYMDotLocal_SeqOpenMP);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecNorm_MPIOpenMP(Vec xin,NormType type,PetscReal *z)
+{
+  PetscReal      work,temp[2];
+  PetscScalar    dot;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (type == NORM_2 || type == NORM_FROBENIUS) {
+    ierr = VecDot_SeqOpenMP(xin,xin,&dot);CHKERRQ(ierr);
+    work = PetscRealPart(dot);
+    ierr = MPIU_Allreduce(&work,z,1,MPIU_REAL,MPIU_SUM,PetscObjectComm((PetscObject)xin));CHKERRQ(ierr);
+    *z   = PetscSqrtReal(*z);
+  } else if (type == NORM_1) {
+    ierr = VecNorm_SeqOpenMP(xin,NORM_1,&work);CHKERRQ(ierr);
+    ierr = MPIU_Allreduce(&work,z,1,MPIU_REAL,MPIU_SUM,PetscObjectComm((PetscObject)xin));CHKERRQ(ierr);
+  } else if (type == NORM_INFINITY) {
+    ierr = VecNorm_SeqOpenMP(xin,NORM_INFINITY,&work);CHKERRQ(ierr);
+    ierr = MPIU_Allreduce(&work,z,1,MPIU_REAL,MPIU_MAX,PetscObjectComm((PetscObject)xin));CHKERRQ(ierr);
+  } else if (type == NORM_1_AND_2) {
+    ierr    = VecNorm_SeqOpenMP(xin,NORM_1,temp);CHKERRQ(ierr);
+    ierr    = VecDot_SeqOpenMP(xin,xin,&dot);CHKERRQ(ierr);
+    temp[1] = PetscRealPart(dot);
+    ierr    = MPIU_Allreduce(temp,z,2,MPIU_REAL,MPIU_SUM,PetscObjectComm((PetscObject)xin));CHKERRQ(ierr);
+    z[1]    = PetscSqrtReal(z[1]);
+  }
+  PetscFunctionReturn(0);
+}
+#endif
+
 extern MPI_Op MPIU_MAXINDEX_OP, MPIU_MININDEX_OP;
 
 PetscErrorCode VecMax_MPI(Vec xin,PetscInt *idx,PetscReal *z)
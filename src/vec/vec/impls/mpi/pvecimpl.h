@@ -42,9 +42,17 @@ typedef struct {
 
 PETSC_INTERN PetscErrorCode VecDot_MPI(Vec,Vec,PetscScalar*);
 PETSC_INTERN PetscErrorCode VecMDot_MPI(Vec,PetscInt,const Vec[],PetscScalar*);
+PETSC_INTERN PetscErrorCode VecMAXPYMDot_MPI(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*);
 PETSC_INTERN PetscErrorCode VecTDot_MPI(Vec,Vec,PetscScalar*);
 PETSC_INTERN PetscErrorCode VecMTDot_MPI(Vec,PetscInt,const Vec[],PetscScalar*);
 PETSC_INTERN PetscErrorCode VecNorm_MPI(Vec,NormType,PetscReal*);
+PETSC_INTERN PetscErrorCode VecSetThreadsFromOptions_MPI_Private(Vec);
+#if defined(PETSC_HAVE_OPENMP)
+PETSC_INTERN PetscErrorCode VecDot_MPIOpenMP(Vec,Vec,PetscScalar*);
+PETSC_INTERN PetscErrorCode VecMDot_MPIOpenMP(Vec,PetscInt,const Vec[],PetscScalar*);
+PETSC_INTERN PetscErrorCode VecNorm_MPIOpenMP(Vec,NormType,PetscReal*);
+PETSC_INTERN PetscErrorCode VecMAXPYMDot_MPIOpenMP(Vec,PetscInt,const PetscScalar*,Vec*,PetscScalar*,PetscReal*);
+#endif
 PETSC_INTERN PetscErrorCode VecMax_MPI(Vec,PetscInt*,PetscReal*);
 PETSC_INTERN PetscErrorCode VecMin_MPI(Vec,PetscInt*,PetscReal*);
 PETSC_INTERN PetscErrorCode VecDestroy_MPI(Vec);
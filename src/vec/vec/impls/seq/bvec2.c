@@ -808,6 +808,7 @@ PetscErrorCode VecDuplicate_Seq(Vec win,Vec *V)
   ierr = PetscLayoutReference(win->map,&(*V)->map);CHKERRQ(ierr);
   ierr = PetscObjectListDuplicate(((PetscObject)win)->olist,&((PetscObject)(*V))->olist);CHKERRQ(ierr);
   ierr = PetscFunctionListDuplicate(((PetscObject)win)->qlist,&((PetscObject)(*V))->qlist);CHKERRQ(ierr);
+  ierr = VecDuplicateThreads_Private(win,*V);CHKERRQ(ierr);
 
   (*V)->ops->view          = win->ops->view;
   (*V)->stash.ignorenegidx = win->stash.ignorenegidx;
@@ -882,7 +883,12 @@ static struct _VecOps DvOps = {VecDuplicate_Seq, /* 1 */
                                VecStrideSubSetGather_Default,
                                VecStrideSubSetScatter_Default,
                                0,
-                               0
+                               0,
+                               0,
+                               0,
+                               0,
+                               0,
+                               VecMAXPYMDot_Seq
 };
 
 
@@ -902,6 +908,7 @@ PetscErrorCode VecCreate_Seq_Private(Vec v,const PetscScalar array[])
   v->petscnative     = PETSC_TRUE;
   s->array           = (PetscScalar*)array;
   s->array_allocated = 0;
+  ierr = VecSetThreadsFromOptions_Private(v);CHKERRQ(ierr);
 
   ierr = PetscLayoutSetUp(v->map);CHKERRQ(ierr);
   ierr = PetscObjectChangeTypeName((PetscObject)v,VECSEQ);CHKERRQ(ierr);
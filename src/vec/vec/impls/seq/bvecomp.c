@@ -0,0 +1,314 @@
+/*
+    OpenMP threaded BLAS-1 operations for VECSEQ (and the local part of VECMPI), selected with -vec_threads <n>.
+
+    The vector is always split into VEC_OPENMP_NBLOCKS contiguous blocks, independently of the number of
+  threads. Each reduction first computes one partial result per block and then adds these partial results
+  serially in block order, so that VecDot(), VecMDot() and VecNorm() give bitwise identical results for any
+  number of threads (the results may differ in the last bits from the BLAS based sequential versions).
+*/
+#include <../src/vec/vec/impls/dvecimpl.h>
+
+#if defined(PETSC_HAVE_OPENMP)
+
+#define VEC_OPENMP_NBLOCKS  128
+/* vectors shorter than this are processed by a single thread, the partition into blocks is the same */
+#define VEC_OPENMP_MINSIZE  10000
+
+#define VecOpenMPBlockStart(n,b) ((PetscInt)(((PetscInt64)(n)*(b))/VEC_OPENMP_NBLOCKS))
+
+PetscErrorCode VecDot_SeqOpenMP(Vec xin,Vec yin,PetscScalar *z)
+{
+  Vec_Seq           *x = (Vec_Seq*)xin->data;
+  const PetscScalar *xa,*ya;
+  PetscScalar       partial[VEC_OPENMP_NBLOCKS],sum = 0.0;
+  PetscInt          b,i,n = xin->map->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xin,&xa);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(yin,&ya);CHKERRQ(ierr);
+  /* same convention as BLASdot_(), the second vector is conjugated */
+#pragma omp parallel for num_threads(x->nthreads) schedule(static) private(i) if(n >= VEC_OPENMP_MINSIZE)
+  for (b=0; b<VEC_OPENMP_NBLOCKS; b++) {
+    PetscInt    start = VecOpenMPBlockStart(n,b),end = VecOpenMPBlockStart(n,b+1);
+    PetscScalar s     = 0.0;
+    for (i=start; i<end; i++) s += xa[i]*PetscConj(ya[i]);
+    partial[b] = s;
+  }
+  for (b=0; b<VEC_OPENMP_NBLOCKS; b++) sum += partial[b];
+  *z   = sum;
+  ierr = VecRestoreArrayRead(xin,&xa);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(yin,&ya);CHKERRQ(ierr);
+  if (n > 0) {
+    ierr = PetscLogFlops(2.0*n-1);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecMDot_SeqOpenMP(Vec xin,PetscInt nv,const Vec yin[],PetscScalar *z)
+{
+  Vec_Seq           *x = (Vec_Seq*)xin->data;
+  const PetscScalar *xa,**ya;
+  PetscScalar       *partial;
+  PetscInt          b,i,j,n = xin->map->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc2(nv,&ya,nv*VEC_OPENMP_NBLOCKS,&partial);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(xin,&xa);CHKERRQ(ierr);
+  for (j=0; j<nv; j++) {
+    ierr = VecGetArrayRead(yin[j],&ya[j]);CHKERRQ(ierr);
+  }
+  /* each block of x is reused from cache for all the vectors */
+#pragma omp parallel for num_threads(x->nthreads) schedule(static) private(i,j) if(n >= VEC_OPENMP_MINSIZE)
+  for (b=0; b<VEC_OPENMP_NBLOCKS; b++) {
+    PetscInt start = VecOpenMPBlockStart(n,b),end = VecOpenMPBlockStart(n,b+1);
+    for (j=0; j<nv; j++) {
+      const PetscScalar *yy = ya[j];
+      PetscScalar       s   = 0.0;
+      for (i=start; i<end; i++) s += xa[i]*PetscConj(yy[i]);
+      partial[j*VEC_OPENMP_NBLOCKS+b] = s;
+    }
+  }
+  for (j=0; j<nv; j++) {
+    z[j] = 0.0;
+    for (b=0; b<VEC_OPENMP_NBLOCKS; b++) z[j] += partial[j*VEC_OPENMP_NBLOCKS+b];
+    ierr = VecRestoreArrayRead(yin[j],&ya[j]);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArrayRead(xin,&xa);CHKERRQ(ierr);
+  ierr = PetscFree2(ya,partial);CHKERRQ(ierr);
+  ierr = PetscLogFlops(PetscMax(nv*(2.0*n-1),0.0));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecNorm_SeqOpenMP(Vec xin,NormType type,PetscReal *z)
+{
+  Vec_Seq           *x = (Vec_Seq*)xin->data;
+  const PetscScalar *xa;
+  PetscReal         partial[VEC_OPENMP_NBLOCKS],sum = 0.0;
+  PetscInt          b,i,n = xin->map->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (type == NORM_1_AND_2) {
+    ierr = VecNorm_SeqOpenMP(xin,NORM_1,z);CHKERRQ(ierr);
+    ierr = VecNorm_SeqOpenMP(xin,NORM_2,z+1);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = VecGetArrayRead(xin,&xa);CHKERRQ(ierr);
+#pragma omp parallel for num_threads(x->nthreads) schedule(static) private(i) if(n >= VEC_OPENMP_MINSIZE)
+  for (b=0; b<VEC_OPENMP_NBLOCKS; b++) {
+    PetscInt  start = VecOpenMPBlockStart(n,b),end = VecOpenMPBlockStart(n,b+1);
+    PetscReal s     = 0.0,tmp;
+    if (type == NORM_INFINITY) {
+      for (i=start; i<end; i++) {
+        tmp = PetscAbsScalar(xa[i]);
+        /* check special case of tmp == NaN */
+        if (tmp != tmp) {s = tmp; break;}
+        if (tmp > s) s = tmp;
+      }
+    } else if (type == NORM_1) {
+      for (i=start; i<end; i++) s += PetscAbsScalar(xa[i]);
+    } else {
+      for (i=start; i<end; i++) s += PetscRealPart(xa[i]*PetscConj(xa[i]));
+    }
+    partial[b] = s;
+  }
+  ierr = VecRestoreArrayRead(xin,&xa);CHKERRQ(ierr);
+  if (type == NORM_INFINITY) {
+    for (b=0; b<VEC_OPENMP_NBLOCKS; b++) {
+      if (partial[b] != partial[b]) {sum = partial[b]; break;}
+      if (partial[b] > sum) sum = partial[b];
+    }
+    *z = sum;
+  } else if (type == NORM_1) {
+    for (b=0; b<VEC_OPENMP_NBLOCKS; b++) sum += partial[b];
+    *z   = sum;
+    ierr = PetscLogFlops(PetscMax(n-1.0,0.0));CHKERRQ(ierr);
+  } else {
+    for (b=0; b<VEC_OPENMP_NBLOCKS; b++) sum += partial[b];
+    *z   = PetscSqrtReal(sum);
+    ierr = PetscLogFlops(PetscMax(2.0*n-1,0.0));CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecAXPY_SeqOpenMP(Vec yin,PetscScalar alpha,Vec xin)
+{
+  Vec_Seq           *y = (Vec_Seq*)yin->data;
+  const PetscScalar *xa;
+  PetscScalar       *ya;
+  PetscInt          b,i,n = yin->map->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (alpha == (PetscScalar)0.0) PetscFunctionReturn(0);
+  ierr = VecGetArrayRead(xin,&xa);CHKERRQ(ierr);
+  ierr = VecGetArray(yin,&ya);CHKERRQ(ierr);
+#pragma omp parallel for num_threads(y->nthreads) schedule(static) private(i) if(n >= VEC_OPENMP_MINSIZE)
+  for (b=0; b<VEC_OPENMP_NBLOCKS; b++) {
+    PetscInt start = VecOpenMPBlockStart(n,b),end = VecOpenMPBlockStart(n,b+1);
+    for (i=start; i<end; i++) ya[i] += alpha*xa[i];
+  }
+  ierr = VecRestoreArrayRead(xin,&xa);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yin,&ya);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecMAXPY_SeqOpenMP(Vec xin,PetscInt nv,const PetscScalar *alpha,Vec *yin)
+{
+  Vec_Seq           *x = (Vec_Seq*)xin->data;
+  const PetscScalar **ya;
+  PetscScalar       *xa;
+  PetscInt          b,i,j,n = xin->map->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc1(nv,&ya);CHKERRQ(ierr);
+  ierr = VecGetArray(xin,&xa);CHKERRQ(ierr);
+  for (j=0; j<nv; j++) {
+    ierr = VecGetArrayRead(yin[j],&ya[j]);CHKERRQ(ierr);
+  }
+  /* each block of x is updated from cache with all the vectors before moving on */
+#pragma omp parallel for num_threads(x->nthreads) schedule(static) private(i,j) if(n >= VEC_OPENMP_MINSIZE)
+  for (b=0; b<VEC_OPENMP_NBLOCKS; b++) {
+    PetscInt start = VecOpenMPBlockStart(n,b),end = VecOpenMPBlockStart(n,b+1);
+    for (j=0; j<nv; j++) {
+      const PetscScalar *yy = ya[j];
+      PetscScalar       a   = alpha[j];
+      for (i=start; i<end; i++) xa[i] += a*yy[i];
+    }
+  }
+  for (j=0; j<nv; j++) {
+    ierr = VecRestoreArrayRead(yin[j],&ya[j]);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(xin,&xa);CHKERRQ(ierr);
+  ierr = PetscFree(ya);CHKERRQ(ierr);
+  ierr = PetscLogFlops(nv*2.0*n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* see VecMAXPYMDotLocal_Seq(), each block of the partition is processed in pieces of VEC_MAXPYMDOT_BLOCK entries */
+PetscErrorCode VecMAXPYMDotLocal_SeqOpenMP(Vec yin,PetscInt nv,const PetscScalar *alpha,Vec *xin,PetscScalar *z,PetscReal *nrm2)
+{
+  Vec_Seq           *y = (Vec_Seq*)yin->data;
+  const PetscScalar **xa;
+  PetscScalar       *ya,*partial;
+  PetscReal         npartial[VEC_OPENMP_NBLOCKS];
+  PetscInt          b,i,j,n = yin->map->n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc2(nv,&xa,nv*VEC_OPENMP_NBLOCKS,&partial);CHKERRQ(ierr);
+  ierr = VecGetArray(yin,&ya);CHKERRQ(ierr);
+  for (j=0; j<nv; j++) {
+    ierr = VecGetArrayRead(xin[j],&xa[j]);CHKERRQ(ierr);
+  }
+#pragma omp parallel for num_threads(y->nthreads) schedule(static) private(i,j) if(n >= VEC_OPENMP_MINSIZE)
+  for (b=0; b<VEC_OPENMP_NBLOCKS; b++) {
+    PetscInt  start = VecOpenMPBlockStart(n,b),end = VecOpenMPBlockStart(n,b+1),s,e;
+    PetscReal ns    = 0.0;
+    for (j=0; j<nv; j++) partial[j*VEC_OPENMP_NBLOCKS+b] = 0.0;
+    for (s=start; s<end; s=e) {
+      e = PetscMin(s+VEC_MAXPYMDOT_BLOCK,end);
+      for (j=0; j<nv; j++) {
+        const PetscScalar *xx = xa[j];
+        PetscScalar       a   = alpha[j];
+        for (i=s; i<e; i++) ya[i] += a*xx[i];
+      }
+      if (z) {
+        for (j=0; j<nv; j++) {
+          const PetscScalar *xx = xa[j];
+          PetscScalar       sum = 0.0;
+          for (i=s; i<e; i++) sum += ya[i]*PetscConj(xx[i]);
+          partial[j*VEC_OPENMP_NBLOCKS+b] += sum;
+        }
+      }
+      if (nrm2) {
+        for (i=s; i<e; i++) ns += PetscRealPart(ya[i]*PetscConj(ya[i]));
+      }
+    }
+    npartial[b] = ns;
+  }
+  if (z) {
+    for (j=0; j<nv; j++) {
+      z[j] = 0.0;
+      for (b=0; b<VEC_OPENMP_NBLOCKS; b++) z[j] += partial[j*VEC_OPENMP_NBLOCKS+b];
+    }
+  }
+  if (nrm2) {
+    *nrm2 = 0.0;
+    for (b=0; b<VEC_OPENMP_NBLOCKS; b++) *nrm2 += npartial[b];
+  }
+  for (j=0; j<nv; j++) {
+    ierr = VecRestoreArrayRead(xin[j],&xa[j]);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(yin,&ya);CHKERRQ(ierr);
+  ierr = PetscFree2(xa,partial);CHKERRQ(ierr);
+  ierr = PetscLogFlops(nv*2.0*n + (z ? nv*2.0*n : 0.0) + (nrm2 ? 2.0*n : 0.0));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecMAXPYMDot_SeqOpenMP(Vec yin,PetscInt nv,const PetscScalar *alpha,Vec *xin,PetscScalar *z,PetscReal *norm)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecMAXPYMDotLocal_SeqOpenMP(yin,nv,alpha,xin,z,norm);CHKERRQ(ierr);
+  if (norm) *norm = PetscSqrtReal(*norm);
+  PetscFunctionReturn(0);
+}
+#endif
+
+/*
+   Installs the threaded operations when -vec_threads <n> with n > 1 is given. Called from
+   VecCreate_Seq_Private() and VecSetThreadsFromOptions_MPI_Private(); the latter then replaces
+   the global reductions with versions that call these for the local part.
+*/
+PetscErrorCode VecSetThreadsFromOptions_Private(Vec v)
+{
+  Vec_Seq        *s = (Vec_Seq*)v->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  s->nthreads = 0;
+  ierr = PetscOptionsGetInt(((PetscObject)v)->options,((PetscObject)v)->prefix,"-vec_threads",&s->nthreads,NULL);CHKERRQ(ierr);
+  if (s->nthreads < 2) PetscFunctionReturn(0);
+#if defined(PETSC_HAVE_OPENMP)
+  v->ops->dot        = VecDot_SeqOpenMP;
+  v->ops->mdot       = VecMDot_SeqOpenMP;
+  v->ops->norm       = VecNorm_SeqOpenMP;
+  v->ops->axpy       = VecAXPY_SeqOpenMP;
+  v->ops->maxpy      = VecMAXPY_SeqOpenMP;
+  v->ops->maxpymdot  = VecMAXPYMDot_SeqOpenMP;
+  v->ops->dot_local  = VecDot_SeqOpenMP;
+  v->ops->mdot_local = VecMDot_SeqOpenMP;
+  v->ops->norm_local = VecNorm_SeqOpenMP;
+#else
+  ierr = PetscInfo(v,"Ignoring -vec_threads since PETSc was not configured --with-openmp\n");CHKERRQ(ierr);
+  s->nthreads = 0;
+#endif
+  PetscFunctionReturn(0);
+}
+
+/*
+   Gives v the number of threads and the BLAS-1 operations of win. Used by the VecDuplicate()
+   implementations instead of reading -vec_threads again, which would ignore the options prefix of win
+   and could leave threaded operations with no threads.
+*/
+PetscErrorCode VecDuplicateThreads_Private(Vec win,Vec v)
+{
+  PetscFunctionBegin;
+  ((Vec_Seq*)v->data)->nthreads = ((Vec_Seq*)win->data)->nthreads;
+  v->ops->dot        = win->ops->dot;
+  v->ops->mdot       = win->ops->mdot;
+  v->ops->norm       = win->ops->norm;
+  v->ops->axpy       = win->ops->axpy;
+  v->ops->maxpy      = win->ops->maxpy;
+  v->ops->maxpymdot  = win->ops->maxpymdot;
+  v->ops->dot_local  = win->ops->dot_local;
+  v->ops->mdot_local = win->ops->mdot_local;
+  v->ops->norm_local = win->ops->norm_local;
+  PetscFunctionReturn(0);
+}
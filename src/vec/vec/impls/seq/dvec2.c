@@ -5,8 +5,87 @@
 */
 #include <../src/vec/vec/impls/dvecimpl.h>
 #include <petsc/private/kernels/petscaxpy.h>
+#include <petscblaslapack.h>
 
+/*
+   Returns the array of v[0] if the arrays of the nv vectors v[] follow each other in memory, as for the Krylov basis
+   of GMRES with -ksp_gmres_contiguous_basis, and NULL otherwise. A returned array is restored with v[0].
+*/
+static PetscErrorCode VecGetContiguousArrayRead_Private(PetscInt n,PetscInt nv,const Vec v[],const PetscScalar **a)
+{
+  PetscErrorCode    ierr;
+  const PetscScalar *a0,*aj;
+  PetscInt          j;
+  PetscBool         next;
+
+  PetscFunctionBegin;
+  *a = NULL;
+  if (nv < 2 || !n) PetscFunctionReturn(0);
+  ierr = VecGetArrayRead(v[0],&a0);CHKERRQ(ierr);
+  for (j=1; j<nv; j++) {
+    ierr = VecGetArrayRead(v[j],&aj);CHKERRQ(ierr);
+    next = (PetscBool)(aj == a0 + j*n);
+    ierr = VecRestoreArrayRead(v[j],&aj);CHKERRQ(ierr);
+    if (!next) break;
+  }
+  if (j < nv) {
+    ierr = VecRestoreArrayRead(v[0],&a0);CHKERRQ(ierr);
+  } else *a = a0;
+  PetscFunctionReturn(0);
+}
 
+/*
+   When the vectors y[] are contiguous in memory they form a dense matrix Y and z = Y^H x is a single BLAS gemv, which reads
+   x once instead of once for every four vectors
+*/
+static PetscErrorCode VecMDot_Seq_GEMV(Vec xin,PetscInt nv,const Vec yin[],PetscScalar *z,PetscBool *done)
+{
+  PetscErrorCode    ierr;
+  PetscInt          n = xin->map->n;
+  const PetscScalar *x,*ya;
+  PetscScalar       one = 1.0,zero = 0.0;
+  PetscBLASInt      bn,bnv,ione = 1;
+
+  PetscFunctionBegin;
+  *done = PETSC_FALSE;
+  ierr  = VecGetContiguousArrayRead_Private(n,nv,yin,&ya);CHKERRQ(ierr);
+  if (!ya) PetscFunctionReturn(0);
+  ierr = PetscBLASIntCast(n,&bn);CHKERRQ(ierr);
+  ierr = PetscBLASIntCast(nv,&bnv);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(xin,&x);CHKERRQ(ierr);
+  PetscStackCallBLAS("BLASgemv",BLASgemv_("C",&bn,&bnv,&one,ya,&bn,x,&ione,&zero,z,&ione));
+  ierr = VecRestoreArrayRead(xin,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(yin[0],&ya);CHKERRQ(ierr);
+  ierr = PetscLogFlops(PetscMax(nv*(2.0*n-1),0.0));CHKERRQ(ierr);
+  *done = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
+
+/* the same for VecMAXPY(), x = x + Y alpha, provided x is not one of the y[] */
+static PetscErrorCode VecMAXPY_Seq_GEMV(Vec xin,PetscInt nv,const PetscScalar *alpha,Vec *y,PetscBool *done)
+{
+  PetscErrorCode    ierr;
+  PetscInt          n = xin->map->n;
+  const PetscScalar *ya;
+  PetscScalar       *xx,one = 1.0;
+  PetscBLASInt      bn,bnv,ione = 1;
+
+  PetscFunctionBegin;
+  *done = PETSC_FALSE;
+  ierr  = VecGetContiguousArrayRead_Private(n,nv,y,&ya);CHKERRQ(ierr);
+  if (!ya) PetscFunctionReturn(0);
+  ierr = VecGetArray(xin,&xx);CHKERRQ(ierr);
+  if (xx + n <= ya || xx >= ya + nv*n) {
+    ierr = PetscBLASIntCast(n,&bn);CHKERRQ(ierr);
+    ierr = PetscBLASIntCast(nv,&bnv);CHKERRQ(ierr);
+    PetscStackCallBLAS("BLASgemv",BLASgemv_("N",&bn,&bnv,&one,ya,&bn,alpha,&ione,&one,xx,&ione));
+    ierr  = PetscLogFlops(nv*2.0*n);CHKERRQ(ierr);
+    *done = PETSC_TRUE;
+  }
+  ierr = VecRestoreArray(xin,&xx);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(y[0],&ya);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
 
 #if defined(PETSC_USE_FORTRAN_KERNEL_MDOT)
 #include <../src/vec/vec/impls/seq/ftn-kernels/fmdot.h>
@@ -17,8 +96,11 @@ PetscErrorCode VecMDot_Seq(Vec xin,PetscInt nv,const Vec yin[],PetscScalar *z)
   PetscScalar       sum0,sum1,sum2,sum3;
   const PetscScalar *yy0,*yy1,*yy2,*yy3,*x;
   Vec               *yy;
+  PetscBool         done;
 
   PetscFunctionBegin;
+  ierr = VecMDot_Seq_GEMV(xin,nv,yin,z,&done);CHKERRQ(ierr);
+  if (done) PetscFunctionReturn(0);
   sum0 = 0.0;
   sum1 = 0.0;
   sum2 = 0.0;
@@ -98,8 +180,11 @@ PetscErrorCode VecMDot_Seq(Vec xin,PetscInt nv,const Vec yin[],PetscScalar *z)
   PetscScalar       sum0,sum1,sum2,sum3,x0,x1,x2,x3;
   const PetscScalar *yy0,*yy1,*yy2,*yy3,*x,*xbase;
   Vec               *yy;
+  PetscBool         done;
 
   PetscFunctionBegin;
+  ierr = VecMDot_Seq_GEMV(xin,nv,yin,z,&done);CHKERRQ(ierr);
+  if (done) PetscFunctionReturn(0);
   sum0 = 0.;
   sum1 = 0.;
   sum2 = 0.;
@@ -559,12 +644,15 @@ PetscErrorCode VecMAXPY_Seq(Vec xin, PetscInt nv,const PetscScalar *alpha,Vec *y
   PetscInt          n = xin->map->n,j,j_rem;
   const PetscScalar *yy0,*yy1,*yy2,*yy3;
   PetscScalar       *xx,alpha0,alpha1,alpha2,alpha3;
+  PetscBool         done;
 
 #if defined(PETSC_HAVE_PRAGMA_DISJOINT)
 #pragma disjoint(*xx,*yy0,*yy1,*yy2,*yy3,*alpha)
 #endif
 
   PetscFunctionBegin;
+  ierr = VecMAXPY_Seq_GEMV(xin,nv,alpha,y,&done);CHKERRQ(ierr);
+  if (done) PetscFunctionReturn(0);
   ierr = PetscLogFlops(nv*2.0*n);CHKERRQ(ierr);
   ierr = VecGetArray(xin,&xx);CHKERRQ(ierr);
   switch (j_rem=nv&0x3) {
@@ -623,6 +711,72 @@ PetscErrorCode VecMAXPY_Seq(Vec xin, PetscInt nv,const PetscScalar *alpha,Vec *y
   PetscFunctionReturn(0);
 }
 
+/*
+   VecMAXPYMDotLocal_Seq - The local part of VecMAXPYMDot(): y = y + sum alpha[j] x[j], then z[j] = y dot x[j] and *nrm2 = y dot y
+   for the local entries; z or nrm2 may be NULL.
+
+   y is processed in blocks of VEC_MAXPYMDOT_BLOCK entries and each block is updated with all the x[j] before their dot
+   products with the updated block are computed, so the blocks of the x[j] are read from memory once and from cache the
+   second time.
+*/
+PetscErrorCode VecMAXPYMDotLocal_Seq(Vec yin,PetscInt nv,const PetscScalar *alpha,Vec *x,PetscScalar *z,PetscReal *nrm2)
+{
+  PetscErrorCode    ierr;
+  PetscInt          n = yin->map->n,i,j,start,end;
+  const PetscScalar *axa[128],**xa = axa,*xx;
+  PetscScalar       *ya,a,sum;
+  PetscReal         nsum = 0.0;
+
+  PetscFunctionBegin;
+  if (nv > 128) {
+    ierr = PetscMalloc1(nv,&xa);CHKERRQ(ierr);
+  }
+  ierr = VecGetArray(yin,&ya);CHKERRQ(ierr);
+  for (j=0; j<nv; j++) {
+    ierr = VecGetArrayRead(x[j],&xa[j]);CHKERRQ(ierr);
+    if (z) z[j] = 0.0;
+  }
+  for (start=0; start<n; start=end) {
+    end = PetscMin(start+VEC_MAXPYMDOT_BLOCK,n);
+    for (j=0; j<nv; j++) {
+      xx = xa[j];
+      a  = alpha[j];
+      for (i=start; i<end; i++) ya[i] += a*xx[i];
+    }
+    if (z) {
+      for (j=0; j<nv; j++) {
+        xx  = xa[j];
+        sum = 0.0;
+        for (i=start; i<end; i++) sum += ya[i]*PetscConj(xx[i]);
+        z[j] += sum;
+      }
+    }
+    if (nrm2) {
+      for (i=start; i<end; i++) nsum += PetscRealPart(ya[i]*PetscConj(ya[i]));
+    }
+  }
+  if (nrm2) *nrm2 = nsum;
+  for (j=0; j<nv; j++) {
+    ierr = VecRestoreArrayRead(x[j],&xa[j]);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(yin,&ya);CHKERRQ(ierr);
+  if (nv > 128) {
+    ierr = PetscFree(xa);CHKERRQ(ierr);
+  }
+  ierr = PetscLogFlops(nv*2.0*n + (z ? nv*2.0*n : 0.0) + (nrm2 ? 2.0*n : 0.0));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+PetscErrorCode VecMAXPYMDot_Seq(Vec yin,PetscInt nv,const PetscScalar *alpha,Vec *x,PetscScalar *z,PetscReal *norm)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecMAXPYMDotLocal_Seq(yin,nv,alpha,x,z,norm);CHKERRQ(ierr);
+  if (norm) *norm = PetscSqrtReal(*norm);
+  PetscFunctionReturn(0);
+}
+
 #include <../src/vec/vec/impls/seq/ftn-kernels/faypx.h>
 
 PetscErrorCode VecAYPX_Seq(Vec yin,PetscScalar alpha,Vec xin)
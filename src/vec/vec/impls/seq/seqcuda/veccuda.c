@@ -390,6 +390,7 @@ PetscErrorCode VecCreate_SeqCUDA_Private(Vec V,const PetscScalar *array)
   V->ops->norm_local             = VecNorm_SeqCUDA;
   V->ops->mdot_local             = VecMDot_SeqCUDA;
   V->ops->maxpy                  = VecMAXPY_SeqCUDA;
+  V->ops->maxpymdot              = NULL;
   V->ops->mdot                   = VecMDot_SeqCUDA;
   V->ops->aypx                   = VecAYPX_SeqCUDA;
   V->ops->waxpy                  = VecWAXPY_SeqCUDA;
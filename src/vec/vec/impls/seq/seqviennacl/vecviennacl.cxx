@@ -1078,6 +1078,7 @@ PETSC_EXTERN PetscErrorCode VecCreate_SeqViennaCL(Vec V)
   V->ops->mdot_local      = VecMDot_SeqViennaCL;
   V->ops->mtdot_local     = VecMTDot_SeqViennaCL;
   V->ops->maxpy           = VecMAXPY_SeqViennaCL;
+  V->ops->maxpymdot       = NULL;
   V->ops->mdot            = VecMDot_SeqViennaCL;
   V->ops->mtdot           = VecMTDot_SeqViennaCL;
   V->ops->aypx            = VecAYPX_SeqViennaCL;
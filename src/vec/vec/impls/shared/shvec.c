@@ -21,6 +21,7 @@ PetscErrorCode VecDuplicate_Shared(Vec win,Vec *v)
   ierr = VecCreate(PetscObjectComm((PetscObject)win),v);CHKERRQ(ierr);
   ierr = VecSetSizes(*v,win->map->n,win->map->N);CHKERRQ(ierr);
   ierr = VecCreate_MPI_Private(*v,PETSC_FALSE,w->nghost,array);CHKERRQ(ierr);
+  ierr = VecDuplicateThreads_Private(win,*v);CHKERRQ(ierr);
   ierr = PetscLayoutReference(win->map,&(*v)->map);CHKERRQ(ierr);
 
   /* New vector should inherit stashing property of parent */
@@ -46,6 +47,7 @@ PETSC_EXTERN PetscErrorCode VecCreate_Shared(Vec vv)
   ierr = PetscSharedMalloc(PetscObjectComm((PetscObject)vv),vv->map->n*sizeof(PetscScalar),vv->map->N*sizeof(PetscScalar),(void**)&array);CHKERRQ(ierr);
 
   ierr = VecCreate_MPI_Private(vv,PETSC_FALSE,0,array);CHKERRQ(ierr);
+  ierr = VecSetThreadsFromOptions_MPI_Private(vv);CHKERRQ(ierr);
   vv->ops->duplicate = VecDuplicate_Shared;
   PetscFunctionReturn(0);
 }
@@ -1234,6 +1234,76 @@ PetscErrorCode  VecMAXPY(Vec y,PetscInt nv,const PetscScalar alpha[],Vec x[])
   PetscFunctionReturn(0);
 }
 
+/*@
+   VecMAXPYMDot - Computes y = y + sum alpha[j] x[j] followed by the multiple dot products of the updated y with
+   the x[j] and its 2-norm, reading the x vectors from memory only once
+
+   Collective on Vec
+
+   Input Parameters:
++  y - one vector
+.  nv - number of scalars and x-vectors
+.  alpha - array of scalars
+-  x - array of vectors
+
+   Output Parameters:
++  val - array of the dot products, val[j] = (y,x[j]) as computed by VecMDot(y,nv,x,val), or NULL if they are not needed
+-  norm - the 2-norm of the updated y, or NULL if it is not needed
+
+   Level: intermediate
+
+   Notes:
+    y cannot be any of the x vectors.
+
+    The result is the same as VecMAXPY() followed by VecMDot() and VecNorm(), but the sequential and parallel vectors
+    update y and compute the dot products block by block, so that each block of the x vectors is still in cache for the
+    dot products, and the dot products and the norm share a single global reduction. This is the update of a classical
+    Gram-Schmidt pass fused with the inner products of the next pass. The norm is cached in y, so a following VecNorm()
+    or VecNormalize() does not read y again.
+
+   Concepts: BLAS
+
+.seealso: VecMAXPY(), VecMDot(), VecNorm()
+@*/
+PetscErrorCode  VecMAXPYMDot(Vec y,PetscInt nv,const PetscScalar alpha[],Vec x[],PetscScalar val[],PetscReal *norm)
+{
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(y,VEC_CLASSID,1);
+  if (nv < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Number of vectors (given %D) cannot be negative",nv);
+  if (!nv) {
+    if (norm) {ierr = VecNorm(y,NORM_2,norm);CHKERRQ(ierr);}
+    PetscFunctionReturn(0);
+  }
+  PetscValidScalarPointer(alpha,3);
+  PetscValidPointer(x,4);
+  PetscValidHeaderSpecific(*x,VEC_CLASSID,4);
+  if (val) PetscValidScalarPointer(val,5);
+  if (norm) PetscValidRealPointer(norm,6);
+  PetscValidType(y,1);
+  PetscValidType(*x,4);
+  PetscCheckSameTypeAndComm(y,1,*x,4);
+  VecCheckSameSize(y,1,*x,4);
+  for (i=0; i<nv; i++) PetscValidLogicalCollectiveScalar(y,alpha[i],3);
+
+  if (!y->ops->maxpymdot) {
+    ierr = VecMAXPY(y,nv,alpha,x);CHKERRQ(ierr);
+    if (val) {ierr = VecMDot(y,nv,x,val);CHKERRQ(ierr);}
+    if (norm) {ierr = VecNorm(y,NORM_2,norm);CHKERRQ(ierr);}
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscLogEventBegin(VEC_MAXPYMDot,*x,y,0,0);CHKERRQ(ierr);
+  ierr = (*y->ops->maxpymdot)(y,nv,alpha,x,val,norm);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(VEC_MAXPYMDot,*x,y,0,0);CHKERRQ(ierr);
+  ierr = PetscObjectStateIncrease((PetscObject)y);CHKERRQ(ierr);
+  if (norm) {
+    ierr = PetscObjectComposedDataSetReal((PetscObject)y,NormIds[NORM_2],*norm);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
 /*@
    VecGetSubVector - Gets a vector representing part of another vector
 
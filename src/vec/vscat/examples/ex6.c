@@ -0,0 +1,287 @@
+static char help[] = "Compares the VecScatter types on the ghost point exchanges of a DMDA and of an MPIAIJ matrix.\n\
+  -dof <dof>  : degrees of freedom per point of the DMDA, moved in blocks\n\
+  -m <m>      : rows of the matrix on each process\n\
+  -nnz <nnz>  : off-diagonal entries per row of the matrix\n\
+  -nvecs <nv> : number of vectors scattered together by VecScatterBeginVecs()\n\
+  -its <its>  : number of timed scatters\n\
+  -timing     : print the time taken by each type\n\n";
+
+/*
+   Every available scatter type moves the ghost points of a periodic 3D DMDA with a box stencil and the ghost columns
+   of an MPIAIJ matrix whose rows have pseudo-random columns, forward with INSERT_VALUES and in reverse with ADD_VALUES.
+   The forward scatter of the global numbering must reproduce the indices, the reverse sums must match those of
+   VECSCATTERMPI1, and VECSCATTERSF must also give the same result with two scatters in flight. VecScatterBeginVecs()
+   on nvecs vectors, as for the ghost points of several fields, must agree with scattering them one by one. Run with
+   -timing -its 1000 to compare the types on a machine, and with -log_view to see each type in its own stage.
+*/
+#include <petscdmda.h>
+#include <petscmat.h>
+#include <petscsf.h>
+#include <petsctime.h>
+
+typedef struct {
+  const char     *name;
+  VecScatterType type;
+  PetscSFType    sftype;     /* how VECSCATTERSF communicates */
+  PetscLogStage  stage;
+} ScatterKind;
+
+static ScatterKind kinds[] = {
+  {"mpi1",       VECSCATTERMPI1,NULL,0},
+#if defined(PETSC_HAVE_MPI_WIN_CREATE_FEATURE)
+  {"mpi3",       VECSCATTERMPI3,NULL,0},
+#endif
+  {"sf basic",   VECSCATTERSF,PETSCSFBASIC,0},
+#if defined(PETSC_HAVE_MPI_NEIGHBORHOOD_COLLECTIVES)
+  {"sf neighbor",VECSCATTERSF,PETSCSFNEIGHBOR,0},
+#endif
+#if defined(PETSC_HAVE_MPI_PROCESS_SHARED_MEMORY)
+  {"sf shared",  VECSCATTERSF,PETSCSFSHARED,0},
+#endif
+};
+
+/* Checks that y[i] holds scale times the global index ix[i] after a forward scatter of the global numbering */
+static PetscErrorCode CheckForward(Vec y,IS ix,PetscScalar scale,PetscInt *errors)
+{
+  const PetscScalar *ya;
+  const PetscInt    *idx;
+  PetscInt          i,n;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBeginUser;
+  ierr = ISGetLocalSize(ix,&n);CHKERRQ(ierr);
+  ierr = ISGetIndices(ix,&idx);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(y,&ya);CHKERRQ(ierr);
+  for (i=0; i<n; i++) if (ya[i] != scale*idx[i]) (*errors)++;
+  ierr = VecRestoreArrayRead(y,&ya);CHKERRQ(ierr);
+  ierr = ISRestoreIndices(ix,&idx);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Scatters y[i] = x[ix[i]] with each kind of scatter, where iy is the identity, checks the results and times them */
+static PetscErrorCode CompareScatters(const char *pattern,Vec x,IS ix,Vec y,IS iy,PetscInt nv,PetscInt its,PetscBool timing)
+{
+  MPI_Comm       comm = PetscObjectComm((PetscObject)x);
+  VecScatter     ctx;
+  Vec            x2,y2,xr,ref,*xs,*ys,*xrs;
+  PetscInt       k,i,v,rstart,rend,errors;
+  PetscScalar    *xa;
+  PetscReal      nrm;
+  PetscLogDouble t0,t1,t,tv;
+  PetscBool      sf;
+  PetscErrorCode ierr;
+
+  PetscFunctionBeginUser;
+  ierr = VecGetOwnershipRange(x,&rstart,&rend);CHKERRQ(ierr);
+  ierr = VecGetArray(x,&xa);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) xa[i-rstart] = i;
+  ierr = VecRestoreArray(x,&xa);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&x2);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&xr);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&ref);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&y2);CHKERRQ(ierr);
+  ierr = VecCopy(x,x2);CHKERRQ(ierr);
+  ierr = VecScale(x2,2.0);CHKERRQ(ierr);
+  ierr = VecDuplicateVecs(x,nv,&xs);CHKERRQ(ierr);
+  ierr = VecDuplicateVecs(x,nv,&xrs);CHKERRQ(ierr);
+  ierr = VecDuplicateVecs(y,nv,&ys);CHKERRQ(ierr);
+  for (v=0; v<nv; v++) {
+    ierr = VecCopy(x,xs[v]);CHKERRQ(ierr);
+    ierr = VecScale(xs[v],(PetscScalar)(v+1));CHKERRQ(ierr);
+  }
+
+  for (k=0; k<(PetscInt)(sizeof(kinds)/sizeof(kinds[0])); k++) {
+    ierr = VecScatterCreate(comm,&ctx);CHKERRQ(ierr);
+    ierr = VecScatterSetData(ctx,x,ix,y,iy);CHKERRQ(ierr);
+    ierr = VecScatterSetType(ctx,kinds[k].type);CHKERRQ(ierr);
+    if (kinds[k].sftype) {
+      ierr = PetscObjectSetOptionsPrefix((PetscObject)ctx,"bench_");CHKERRQ(ierr);
+      ierr = PetscOptionsSetValue(NULL,"-bench_sf_type",kinds[k].sftype);CHKERRQ(ierr);
+    }
+    ierr = VecScatterSetUp(ctx);CHKERRQ(ierr);
+    if (kinds[k].sftype) {ierr = PetscOptionsClearValue(NULL,"-bench_sf_type");CHKERRQ(ierr);}
+
+    errors = 0;
+    ierr = VecSet(y,-1.0);CHKERRQ(ierr);
+    ierr = VecScatterBegin(ctx,x,y,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+    ierr = VecScatterEnd(ctx,x,y,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+    ierr = CheckForward(y,ix,1.0,&errors);CHKERRQ(ierr);
+    ierr = PetscObjectTypeCompare((PetscObject)ctx,VECSCATTERSF,&sf);CHKERRQ(ierr);
+    if (sf) {
+      ierr = VecSet(y,-1.0);CHKERRQ(ierr);
+      ierr = VecSet(y2,-1.0);CHKERRQ(ierr);
+      ierr = VecScatterBegin(ctx,x,y,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterBegin(ctx,x2,y2,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterEnd(ctx,x,y,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterEnd(ctx,x2,y2,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = CheckForward(y,ix,1.0,&errors);CHKERRQ(ierr);
+      ierr = CheckForward(y2,ix,2.0,&errors);CHKERRQ(ierr);
+    }
+    ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,comm);CHKERRQ(ierr);
+    if (errors) SETERRQ3(comm,PETSC_ERR_PLIB,"%s: %D wrong entries after the forward scatter of type %s",pattern,errors,kinds[k].name);
+
+    /* Each entry of x receives the number of ghosts referencing it */
+    ierr = VecSet(y,1.0);CHKERRQ(ierr);
+    ierr = VecSet(xr,0.0);CHKERRQ(ierr);
+    ierr = VecScatterBegin(ctx,y,xr,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+    ierr = VecScatterEnd(ctx,y,xr,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+    if (!k) {
+      ierr = VecCopy(xr,ref);CHKERRQ(ierr);
+    } else {
+      ierr = VecAXPY(xr,-1.0,ref);CHKERRQ(ierr);
+      ierr = VecNorm(xr,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+      if (nrm != 0.0) SETERRQ3(comm,PETSC_ERR_PLIB,"%s: the reverse scatter of type %s differs from %s",pattern,kinds[k].name,kinds[0].name);
+    }
+
+    /* Several fields at once */
+    errors = 0;
+    for (v=0; v<nv; v++) {ierr = VecSet(ys[v],-1.0);CHKERRQ(ierr);}
+    ierr = VecScatterBeginVecs(ctx,nv,xs,ys,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+    ierr = VecScatterEndVecs(ctx,nv,xs,ys,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+    for (v=0; v<nv; v++) {ierr = CheckForward(ys[v],ix,(PetscScalar)(v+1),&errors);CHKERRQ(ierr);}
+    ierr = MPIU_Allreduce(MPI_IN_PLACE,&errors,1,MPIU_INT,MPI_SUM,comm);CHKERRQ(ierr);
+    if (errors) SETERRQ3(comm,PETSC_ERR_PLIB,"%s: %D wrong entries after the forward scatter of several vectors of type %s",pattern,errors,kinds[k].name);
+    for (v=0; v<nv; v++) {
+      ierr = VecSet(ys[v],(PetscScalar)(v+1));CHKERRQ(ierr);
+      ierr = VecSet(xrs[v],0.0);CHKERRQ(ierr);
+    }
+    ierr = VecScatterBeginVecs(ctx,nv,ys,xrs,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+    ierr = VecScatterEndVecs(ctx,nv,ys,xrs,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+    for (v=0; v<nv; v++) {
+      ierr = VecAXPY(xrs[v],-(PetscScalar)(v+1),ref);CHKERRQ(ierr);
+      ierr = VecNorm(xrs[v],NORM_INFINITY,&nrm);CHKERRQ(ierr);
+      if (nrm != 0.0) SETERRQ3(comm,PETSC_ERR_PLIB,"%s: the reverse scatter of several vectors of type %s differs from %s",pattern,kinds[k].name,kinds[0].name);
+    }
+
+    ierr = MPI_Barrier(comm);CHKERRQ(ierr);
+    ierr = PetscLogStagePush(kinds[k].stage);CHKERRQ(ierr);
+    ierr = PetscTime(&t0);CHKERRQ(ierr);
+    for (i=0; i<its; i++) {
+      ierr = VecScatterBegin(ctx,x,y,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterEnd(ctx,x,y,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterBegin(ctx,y,xr,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+      ierr = VecScatterEnd(ctx,y,xr,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+    }
+    ierr = PetscTime(&t1);CHKERRQ(ierr);
+    ierr = PetscLogStagePop();CHKERRQ(ierr);
+    t    = t1 - t0;
+    ierr = MPIU_Allreduce(MPI_IN_PLACE,&t,1,MPI_DOUBLE,MPI_MAX,comm);CHKERRQ(ierr);
+    ierr = MPI_Barrier(comm);CHKERRQ(ierr);
+    ierr = PetscLogStagePush(kinds[k].stage);CHKERRQ(ierr);
+    ierr = PetscTime(&t0);CHKERRQ(ierr);
+    for (i=0; i<its; i++) {
+      ierr = VecScatterBeginVecs(ctx,nv,xs,ys,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterEndVecs(ctx,nv,xs,ys,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterBeginVecs(ctx,nv,ys,xrs,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+      ierr = VecScatterEndVecs(ctx,nv,ys,xrs,ADD_VALUES,SCATTER_REVERSE);CHKERRQ(ierr);
+    }
+    ierr = PetscTime(&t1);CHKERRQ(ierr);
+    ierr = PetscLogStagePop();CHKERRQ(ierr);
+    tv   = t1 - t0;
+    ierr = MPIU_Allreduce(MPI_IN_PLACE,&tv,1,MPI_DOUBLE,MPI_MAX,comm);CHKERRQ(ierr);
+    if (timing) {ierr = PetscPrintf(comm,"%-10s %-12s %10.2f us per forward and reverse scatter, %10.2f us for %D vectors together\n",pattern,kinds[k].name,1.e6*t/PetscMax(its,1),1.e6*tv/PetscMax(its,1),nv);CHKERRQ(ierr);}
+    ierr = VecScatterDestroy(&ctx);CHKERRQ(ierr);
+  }
+  ierr = PetscPrintf(comm,"%s: the scatter types agree\n",pattern);CHKERRQ(ierr);
+
+  ierr = VecDestroy(&x2);CHKERRQ(ierr);
+  ierr = VecDestroy(&xr);CHKERRQ(ierr);
+  ierr = VecDestroy(&ref);CHKERRQ(ierr);
+  ierr = VecDestroy(&y2);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(nv,&xs);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(nv,&xrs);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(nv,&ys);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+int main(int argc,char **argv)
+{
+  DM                     da;
+  Mat                    A,Ad,Ao;
+  Vec                    x,y;
+  IS                     ix,iy;
+  ISLocalToGlobalMapping ltog;
+  const PetscInt         *bidx,*garray;
+  PetscInt               dof = 1,m = 100,nnz = 5,nv = 4,its = 10,n,nb,i,j,k,r,rstart,rend,N,*id;
+  unsigned long long     s;
+  PetscMPIInt            size;
+  PetscBool              timing = PETSC_FALSE;
+  PetscErrorCode         ierr;
+
+  ierr = PetscInitialize(&argc,&argv,NULL,help);if (ierr) return ierr;
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  if (size < 2) SETERRQ(PETSC_COMM_WORLD,PETSC_ERR_SUP,"Compares parallel scatters, run on two or more processes");
+  ierr = PetscOptionsGetInt(NULL,NULL,"-dof",&dof,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-m",&m,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-nnz",&nnz,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-nvecs",&nv,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(NULL,NULL,"-its",&its,NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(NULL,NULL,"-timing",&timing,NULL);CHKERRQ(ierr);
+  for (k=0; k<(PetscInt)(sizeof(kinds)/sizeof(kinds[0])); k++) {
+    ierr = PetscLogStageRegister(kinds[k].name,&kinds[k].stage);CHKERRQ(ierr);
+  }
+
+  /* The ghost points of a DMDA, from the global to the local vector */
+  ierr = DMDACreate3d(PETSC_COMM_WORLD,DM_BOUNDARY_PERIODIC,DM_BOUNDARY_PERIODIC,DM_BOUNDARY_PERIODIC,DMDA_STENCIL_BOX,8,8,8,PETSC_DECIDE,PETSC_DECIDE,PETSC_DECIDE,dof,1,NULL,NULL,NULL,&da);CHKERRQ(ierr);
+  ierr = DMSetFromOptions(da);CHKERRQ(ierr);
+  ierr = DMSetUp(da);CHKERRQ(ierr);
+  ierr = DMCreateGlobalVector(da,&x);CHKERRQ(ierr);
+  ierr = DMCreateLocalVector(da,&y);CHKERRQ(ierr);
+  ierr = DMGetLocalToGlobalMapping(da,&ltog);CHKERRQ(ierr);
+  ierr = ISLocalToGlobalMappingGetSize(ltog,&n);CHKERRQ(ierr);
+  nb   = n/dof;
+  ierr = ISLocalToGlobalMappingGetBlockIndices(ltog,&bidx);CHKERRQ(ierr);
+  ierr = ISCreateBlock(PETSC_COMM_SELF,dof,nb,bidx,PETSC_COPY_VALUES,&ix);CHKERRQ(ierr);
+  ierr = ISLocalToGlobalMappingRestoreBlockIndices(ltog,&bidx);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nb,&id);CHKERRQ(ierr);
+  for (i=0; i<nb; i++) id[i] = i;
+  ierr = ISCreateBlock(PETSC_COMM_SELF,dof,nb,id,PETSC_OWN_POINTER,&iy);CHKERRQ(ierr);
+  ierr = CompareScatters("DMDA",x,ix,y,iy,nv,its,timing);CHKERRQ(ierr);
+  ierr = ISDestroy(&ix);CHKERRQ(ierr);
+  ierr = ISDestroy(&iy);CHKERRQ(ierr);
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = DMDestroy(&da);CHKERRQ(ierr);
+
+  /* The ghost columns of an MPIAIJ matrix, from the input vector of MatMult() to the sequential vector of ghosts */
+  ierr = MatCreateAIJ(PETSC_COMM_WORLD,m,m,PETSC_DETERMINE,PETSC_DETERMINE,1+nnz,NULL,nnz,NULL,&A);CHKERRQ(ierr);
+  ierr = MatSetOption(A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+  ierr = MatGetSize(A,&N,NULL);CHKERRQ(ierr);
+  for (r=rstart; r<rend; r++) {
+    ierr = MatSetValue(A,r,r,1.0,INSERT_VALUES);CHKERRQ(ierr);
+    for (j=0,s=(unsigned long long)r; j<nnz; j++) {
+      s    = s*6364136223846793005ULL + 1442695040888963407ULL;
+      ierr = MatSetValue(A,r,(PetscInt)((s >> 33)%(unsigned long long)N),1.0,INSERT_VALUES);CHKERRQ(ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatMPIAIJGetSeqAIJ(A,&Ad,&Ao,&garray);CHKERRQ(ierr);
+  ierr = MatGetLocalSize(Ao,NULL,&n);CHKERRQ(ierr);
+  ierr = MatCreateVecs(A,&x,NULL);CHKERRQ(ierr);
+  ierr = VecCreateSeq(PETSC_COMM_SELF,n,&y);CHKERRQ(ierr);
+  ierr = ISCreateGeneral(PETSC_COMM_SELF,n,garray,PETSC_COPY_VALUES,&ix);CHKERRQ(ierr);
+  ierr = ISCreateStride(PETSC_COMM_SELF,n,0,1,&iy);CHKERRQ(ierr);
+  ierr = CompareScatters("MPIAIJ",x,ix,y,iy,nv,its,timing);CHKERRQ(ierr);
+  ierr = ISDestroy(&ix);CHKERRQ(ierr);
+  ierr = ISDestroy(&iy);CHKERRQ(ierr);
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return ierr;
+}
+
+/*TEST
+
+   test:
+      nsize: 4
+
+   test:
+      suffix: 2
+      nsize: 3
+      args: -dof 3 -m 50 -nnz 7 -nvecs 2
+      output_file: output/ex6_1.out
+
+TEST*/
@@ -143,11 +143,12 @@ PetscErrorCode VecScatterCopy_PtoP_X_MPI1(VecScatter in,VecScatter out)
   PetscInt               ny,bs = in_from->bs;
 
   PetscFunctionBegin;
-  out->ops->begin   = in->ops->begin;
-  out->ops->end     = in->ops->end;
-  out->ops->copy    = in->ops->copy;
-  out->ops->destroy = in->ops->destroy;
-  out->ops->view    = in->ops->view;
+  out->ops->begin    = in->ops->begin;
+  out->ops->end      = in->ops->end;
+  out->ops->copy     = in->ops->copy;
+  out->ops->destroy  = in->ops->destroy;
+  out->ops->view     = in->ops->view;
+  out->ops->progress = in->ops->progress;
 
   /* allocate entire send scatter context */
   ierr = PetscNewLog(out,&out_to);CHKERRQ(ierr);
@@ -251,6 +252,7 @@ PetscErrorCode VecScatterCopy_PtoP_AllToAll_MPI1(VecScatter in,VecScatter out)
   out->ops->copy      = in->ops->copy;
   out->ops->destroy   = in->ops->destroy;
   out->ops->view      = in->ops->view;
+  out->ops->progress  = in->ops->progress;
 
   /* allocate entire send scatter context */
   ierr = PetscNewLog(out,&out_to);CHKERRQ(ierr);
@@ -2259,7 +2261,8 @@ PetscErrorCode VecScatterCreateCommon_PtoS_MPI1(VecScatter_MPI_General *from,Vec
     for (i=0; i<to->n; i++) {
       ierr = MPI_Recv_init(Ssvalues+bs*sstarts[i],bs*sstarts[i+1]-bs*sstarts[i],MPIU_SCALAR,sprocs[i],tagr,comm,rev_rwaits+i);CHKERRQ(ierr);
     }
-    ctx->ops->copy = VecScatterCopy_PtoP_X_MPI1;
+    ctx->ops->copy     = VecScatterCopy_PtoP_X_MPI1;
+    ctx->ops->progress = VecScatterProgress_PtoP;
   }
   ierr = PetscInfo1(ctx,"Using blocksize %D scatter\n",bs);CHKERRQ(ierr);
 
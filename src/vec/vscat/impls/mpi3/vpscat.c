@@ -213,11 +213,12 @@ PetscErrorCode VecScatterCopy_PtoP_X(VecScatter in,VecScatter out)
   MPI_Info               info;
 
   PetscFunctionBegin;
-  out->ops->begin   = in->ops->begin;
-  out->ops->end     = in->ops->end;
-  out->ops->copy    = in->ops->copy;
-  out->ops->destroy = in->ops->destroy;
-  out->ops->view    = in->ops->view;
+  out->ops->begin    = in->ops->begin;
+  out->ops->end      = in->ops->end;
+  out->ops->copy     = in->ops->copy;
+  out->ops->destroy  = in->ops->destroy;
+  out->ops->view     = in->ops->view;
+  out->ops->progress = in->ops->progress;
 
   /* allocate entire send scatter context */
   ierr = PetscNewLog(out,&out_to);CHKERRQ(ierr);
@@ -370,6 +371,7 @@ PetscErrorCode VecScatterCopy_PtoP_AllToAll(VecScatter in,VecScatter out)
   out->ops->copy      = in->ops->copy;
   out->ops->destroy   = in->ops->destroy;
   out->ops->view      = in->ops->view;
+  out->ops->progress  = in->ops->progress;
 
   /* allocate entire send scatter context */
   ierr = PetscNewLog(out,&out_to);CHKERRQ(ierr);
@@ -2525,7 +2527,8 @@ PetscErrorCode VecScatterCreateCommon_PtoS_MPI3(VecScatter_MPI_General *from,Vec
     for (i=0; i<to->n; i++) {
       ierr = MPI_Recv_init(Ssvalues+bs*sstarts[i],bs*sstarts[i+1]-bs*sstarts[i],MPIU_SCALAR,sprocs[i],tagr,comm,rev_rwaits+i);CHKERRQ(ierr);
     }
-    ctx->ops->copy = VecScatterCopy_PtoP_X;
+    ctx->ops->copy     = VecScatterCopy_PtoP_X;
+    ctx->ops->progress = VecScatterProgress_PtoP;
   }
   ierr = PetscInfo1(ctx,"Using blocksize %D scatter\n",bs);CHKERRQ(ierr);
 
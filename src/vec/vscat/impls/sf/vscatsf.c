@@ -0,0 +1,589 @@
+/*
+    A vector scatter that communicates with a PetscSF. The entries of the vector scattered from are the roots and the
+    entries of the vector scattered into are the leaves, so a forward scatter is a broadcast and a reverse scatter a
+    reduction. The packing, the ordering of the messages and the choice of communication pattern are left to the PetscSF.
+*/
+#include <petsc/private/vecscatterimpl.h>    /*I   "petscvec.h"    I*/
+#include <petscsf.h>
+
+typedef struct {
+  VECSCATTER_IMPL_HEADER
+  PetscSF      sf;      /* roots are the blocks of the from vector, leaves the blocks of the to vector */
+  PetscSF      lsf;     /* the edges of sf within this process, used by SCATTER_LOCAL */
+  PetscInt     bs;      /* number of scalars moved per edge */
+  MPI_Datatype unit;    /* bs scalars */
+  /* VecScatterBeginVecs() packs the vectors into buffers holding the entries that are communicated, interlaced */
+  PetscSF      fsf;     /* sf restricted to the roots with leaves, renumbered, and with one contiguous leaf per edge */
+  PetscInt     nfroots; /* number of roots of fsf */
+  PetscInt     *froots; /* the roots of sf that are the roots of fsf */
+  PetscInt     *fleaves; /* the leaves of sf that are the leaves of fsf */
+  PetscInt     nfvecs;  /* number of vectors of the VecScatterBeginVecs() in progress, 0 if none */
+  MPI_Datatype funit;   /* nfvecs*bs scalars */
+  PetscInt     nfbuf;   /* the buffers below hold nfbuf*bs scalars per root and per leaf of fsf */
+  PetscScalar  *frootbuf,*fleafbuf;
+} VecScatter_SF;
+
+static PetscErrorCode VecScatterSFGetOp(InsertMode addv,MPI_Op *op)
+{
+  PetscFunctionBegin;
+  switch (addv) {
+  case INSERT_VALUES: *op = MPIU_REPLACE; break;
+  case ADD_VALUES:    *op = MPIU_SUM; break;
+#if !defined(PETSC_USE_COMPLEX)
+  case MAX_VALUES:    *op = MPIU_MAX; break;
+#endif
+  default: SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_SUP,"Scatter type sf does not support insert mode %d",(int)addv);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterBegin_SF(VecScatter ctx,Vec x,Vec y,InsertMode addv,ScatterMode mode)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscSF        sf    = (mode & SCATTER_LOCAL) ? data->lsf : data->sf;
+  PetscScalar    *xv,*yv;
+  MPI_Op         op;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecScatterSFGetOp(addv,&op);CHKERRQ(ierr);
+  ierr = VecGetArrayPair(x,y,&xv,&yv);CHKERRQ(ierr);
+  if (mode & SCATTER_REVERSE) {
+    ierr = PetscSFReduceBegin(sf,data->unit,xv,yv,op);CHKERRQ(ierr);
+  } else {
+    ierr = PetscSFBcastAndOpBegin(sf,data->unit,xv,yv,op);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArrayPair(x,y,&xv,&yv);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterEnd_SF(VecScatter ctx,Vec x,Vec y,InsertMode addv,ScatterMode mode)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscSF        sf    = (mode & SCATTER_LOCAL) ? data->lsf : data->sf;
+  PetscScalar    *xv,*yv;
+  MPI_Op         op;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecScatterSFGetOp(addv,&op);CHKERRQ(ierr);
+  ierr = VecGetArrayPair(x,y,&xv,&yv);CHKERRQ(ierr);
+  if (mode & SCATTER_REVERSE) {
+    ierr = PetscSFReduceEnd(sf,data->unit,xv,yv,op);CHKERRQ(ierr);
+  } else {
+    ierr = PetscSFBcastAndOpEnd(sf,data->unit,xv,yv,op);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArrayPair(x,y,&xv,&yv);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterProgress_SF(VecScatter ctx)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFProgress(data->sf);CHKERRQ(ierr);
+  if (data->fsf) {ierr = PetscSFProgress(data->fsf);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+/* Frees what VecScatterBeginVecs() built, to be rebuilt when the graph of sf has changed */
+static PetscErrorCode VecScatterSFResetVecs(VecScatter_SF *data)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (data->nfvecs) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"VecScatterBeginVecs() has not been ended");
+  ierr = PetscSFDestroy(&data->fsf);CHKERRQ(ierr);
+  ierr = PetscFree2(data->froots,data->fleaves);CHKERRQ(ierr);
+  ierr = PetscFree2(data->frootbuf,data->fleafbuf);CHKERRQ(ierr);
+  data->nfroots = 0;
+  data->nfbuf   = 0;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterDestroy_SF(VecScatter ctx)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!data) PetscFunctionReturn(0);
+  ierr = PetscSFDestroy(&data->sf);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&data->lsf);CHKERRQ(ierr);
+  if (data->bs > 1) {ierr = MPI_Type_free(&data->unit);CHKERRQ(ierr);}
+  ierr = VecScatterSFResetVecs(data);CHKERRQ(ierr);
+  ierr = PetscFree(data);CHKERRQ(ierr);
+  ctx->todata   = NULL;
+  ctx->fromdata = NULL;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterSFSetUnit(VecScatter_SF *data,PetscInt bs)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  data->bs = bs;
+  if (bs > 1) {
+    ierr = MPI_Type_contiguous((PetscMPIInt)bs,MPIU_SCALAR,&data->unit);CHKERRQ(ierr);
+    ierr = MPI_Type_commit(&data->unit);CHKERRQ(ierr);
+  } else data->unit = MPIU_SCALAR;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterCopy_SF(VecScatter in,VecScatter out)
+{
+  VecScatter_SF  *indata = (VecScatter_SF*)in->todata,*data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscNewLog(out,&data);CHKERRQ(ierr);
+  data->format = VEC_SCATTER_SF;
+  ierr = VecScatterSFSetUnit(data,indata->bs);CHKERRQ(ierr);
+  ierr = PetscSFDuplicate(indata->sf,PETSCSF_DUPLICATE_GRAPH,&data->sf);CHKERRQ(ierr);
+  ierr = PetscSFDuplicate(indata->lsf,PETSCSF_DUPLICATE_GRAPH,&data->lsf);CHKERRQ(ierr);
+  ierr = PetscMemcpy(out->ops,in->ops,sizeof(struct _VecScatterOps));CHKERRQ(ierr);
+  out->todata     = data;
+  out->fromdata   = data;
+  out->concurrent = in->concurrent;
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterView_SF(VecScatter ctx,PetscViewer viewer)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscBool      iascii;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscObjectPrintClassNamePrefixType((PetscObject)ctx,viewer);CHKERRQ(ierr);
+    ierr = PetscViewerASCIIPrintf(viewer,"  moving blocks of %D entries with a PetscSF\n",data->bs);CHKERRQ(ierr);
+  }
+  ierr = PetscViewerASCIIPushTab(viewer);CHKERRQ(ierr);
+  ierr = PetscSFView(data->sf,viewer);CHKERRQ(ierr);
+  ierr = PetscViewerASCIIPopTab(viewer);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Renumbers the roots of sf, root r becoming root newroot[r] of the nroots roots, by sending the new numbers to the
+   leaves. With byedge the leaves are renumbered as well, leaf i becoming the target of the i-th edge */
+static PetscErrorCode VecScatterSFRemapRoots(PetscSF sf,PetscInt nroots,const PetscInt *newroot,PetscBool byedge)
+{
+  PetscSF           tsf;
+  PetscInt          oldnroots,nleaves,i,*ilocal,*newindex;
+  const PetscInt    *oldilocal;
+  const PetscSFNode *oldiremote;
+  PetscSFNode       *iremote;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFGetGraph(sf,&oldnroots,&nleaves,&oldilocal,&oldiremote);CHKERRQ(ierr);
+  /* A leaf may be reached from several roots, so the numbers go to contiguous leaves, one per edge */
+  ierr = PetscSFCreate(PetscObjectComm((PetscObject)sf),&tsf);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(tsf,oldnroots,nleaves,NULL,PETSC_OWN_POINTER,oldiremote,PETSC_COPY_VALUES);CHKERRQ(ierr);
+  ierr = PetscMalloc3(nleaves,&newindex,nleaves,&ilocal,nleaves,&iremote);CHKERRQ(ierr);
+  ierr = PetscSFBcastBegin(tsf,MPIU_INT,newroot,newindex);CHKERRQ(ierr);
+  ierr = PetscSFBcastEnd(tsf,MPIU_INT,newroot,newindex);CHKERRQ(ierr);
+  ierr = PetscSFDestroy(&tsf);CHKERRQ(ierr);
+  for (i=0; i<nleaves; i++) {
+    ilocal[i]        = (oldilocal && !byedge) ? oldilocal[i] : i;
+    iremote[i].rank  = oldiremote[i].rank;
+    iremote[i].index = newindex[i];
+  }
+  ierr = PetscSFSetGraph(sf,nroots,nleaves,ilocal,PETSC_COPY_VALUES,iremote,PETSC_COPY_VALUES);CHKERRQ(ierr);
+  ierr = PetscSFSetUp(sf);CHKERRQ(ierr);
+  ierr = PetscFree3(newindex,ilocal,iremote);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* The tomap of VecScatterRemap() renumbers the entries of the vector scattered from, that is the roots */
+static PetscErrorCode VecScatterRemap_SF(VecScatter ctx,PetscInt *tomap,PetscInt *frommap)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscInt       bs = data->bs,nroots,n = 0,r,c,*newroot;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (frommap) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Unable to remap the FROM in scatters yet");
+  if (!tomap) PetscFunctionReturn(0);
+  ierr = PetscSFGetGraph(data->sf,&nroots,NULL,NULL,NULL);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nroots,&newroot);CHKERRQ(ierr);
+  for (r=0; r<nroots; r++) {
+    for (c=0; c<bs; c++) if (tomap[r*bs+c] != tomap[r*bs]+c) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Remapping splits the block of %D entries",bs);
+    if (tomap[r*bs]%bs) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Remapping does not keep the blocks of %D entries aligned",bs);
+    newroot[r] = tomap[r*bs]/bs;
+    n          = PetscMax(n,newroot[r]+1);
+  }
+  ierr = VecScatterSFRemapRoots(data->sf,n,newroot,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = VecScatterSFRemapRoots(data->lsf,n,newroot,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = VecScatterSFResetVecs(data);CHKERRQ(ierr);
+  ierr = PetscFree(newroot);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Builds fsf, whose roots are the roots of sf reached by some edge and whose leaves are the edges of sf, so that
+   packing the vectors costs as much as the communicated entries rather than the length of the vectors */
+static PetscErrorCode VecScatterSFSetUpVecs(VecScatter_SF *data)
+{
+  PetscInt       nroots,nleaves,r,i,nf = 0,*newroot;
+  const PetscInt *degree,*ilocal;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFGetGraph(data->sf,&nroots,&nleaves,&ilocal,NULL);CHKERRQ(ierr);
+  ierr = PetscSFComputeDegreeBegin(data->sf,&degree);CHKERRQ(ierr);
+  ierr = PetscSFComputeDegreeEnd(data->sf,&degree);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nroots,&newroot);CHKERRQ(ierr);
+  for (r=0; r<nroots; r++) newroot[r] = degree[r] ? nf++ : -1;
+  ierr = PetscMalloc2(nf,&data->froots,nleaves,&data->fleaves);CHKERRQ(ierr);
+  for (r=0; r<nroots; r++) if (degree[r]) data->froots[newroot[r]] = r;
+  for (i=0; i<nleaves; i++) data->fleaves[i] = ilocal ? ilocal[i] : i;
+  data->nfroots = nf;
+  ierr = PetscSFDuplicate(data->sf,PETSCSF_DUPLICATE_GRAPH,&data->fsf);CHKERRQ(ierr);
+  ierr = VecScatterSFRemapRoots(data->fsf,nf,newroot,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = PetscFree(newroot);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Interlaces the blocks idx[] of the n vectors v[] into buf, block j of vector k going to buf[(j*n+k)*bs] */
+static PetscErrorCode VecScatterSFPackVecs(PetscInt n,const Vec v[],PetscInt bs,PetscInt nidx,const PetscInt *idx,PetscScalar *buf)
+{
+  const PetscScalar *a;
+  PetscInt          k,j,c;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  for (k=0; k<n; k++) {
+    ierr = VecGetArrayRead(v[k],&a);CHKERRQ(ierr);
+    for (j=0; j<nidx; j++) for (c=0; c<bs; c++) buf[(j*n+k)*bs+c] = a[idx[j]*bs+c];
+    ierr = VecRestoreArrayRead(v[k],&a);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/* The reverse of VecScatterSFPackVecs(), combining the entries of buf with those of the vectors as addv says */
+static PetscErrorCode VecScatterSFUnpackVecs(PetscInt n,const Vec v[],PetscInt bs,PetscInt nidx,const PetscInt *idx,const PetscScalar *buf,InsertMode addv)
+{
+  PetscScalar    *a;
+  PetscInt       k,j,c;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (k=0; k<n; k++) {
+    ierr = VecGetArray(v[k],&a);CHKERRQ(ierr);
+    switch (addv) {
+    case INSERT_VALUES:
+      for (j=0; j<nidx; j++) for (c=0; c<bs; c++) a[idx[j]*bs+c] = buf[(j*n+k)*bs+c];
+      break;
+    case ADD_VALUES:
+      for (j=0; j<nidx; j++) for (c=0; c<bs; c++) a[idx[j]*bs+c] += buf[(j*n+k)*bs+c];
+      break;
+#if !defined(PETSC_USE_COMPLEX)
+    case MAX_VALUES:
+      for (j=0; j<nidx; j++) for (c=0; c<bs; c++) a[idx[j]*bs+c] = PetscMax(a[idx[j]*bs+c],buf[(j*n+k)*bs+c]);
+      break;
+#endif
+    default: SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_SUP,"Scatter type sf does not support insert mode %d",(int)addv);
+    }
+    ierr = VecRestoreArray(v[k],&a);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   The n vectors move as one with a unit of n*bs scalars: a forward scatter broadcasts the packed roots to the edges and
+   unpacks them into the leaves with addv; a reverse scatter reduces the packed leaves into the packed current values of
+   the roots and copies those back. Either way there is one message per pair of processes.
+*/
+static PetscErrorCode VecScatterBeginVecs_SF(VecScatter ctx,PetscInt n,const Vec x[],const Vec y[],InsertMode addv,ScatterMode mode)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscInt       nleaves;
+  MPI_Op         op;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (data->nfvecs) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Only one VecScatterBeginVecs() may be in progress on a scatter");
+  ierr = VecScatterSFGetOp(addv,&op);CHKERRQ(ierr);
+  if (!data->fsf) {ierr = VecScatterSFSetUpVecs(data);CHKERRQ(ierr);}
+  ierr = PetscSFGetGraph(data->fsf,NULL,&nleaves,NULL,NULL);CHKERRQ(ierr);
+  if (n > data->nfbuf) {
+    ierr = PetscFree2(data->frootbuf,data->fleafbuf);CHKERRQ(ierr);
+    ierr = PetscMalloc2(n*data->bs*data->nfroots,&data->frootbuf,n*data->bs*nleaves,&data->fleafbuf);CHKERRQ(ierr);
+    data->nfbuf = n;
+  }
+  ierr = MPI_Type_contiguous((PetscMPIInt)(n*data->bs),MPIU_SCALAR,&data->funit);CHKERRQ(ierr);
+  ierr = MPI_Type_commit(&data->funit);CHKERRQ(ierr);
+  data->nfvecs = n;
+  if (mode & SCATTER_REVERSE) {
+    ierr = VecScatterSFPackVecs(n,x,data->bs,nleaves,data->fleaves,data->fleafbuf);CHKERRQ(ierr);
+    ierr = VecScatterSFPackVecs(n,y,data->bs,data->nfroots,data->froots,data->frootbuf);CHKERRQ(ierr);
+    ierr = PetscSFReduceBegin(data->fsf,data->funit,data->fleafbuf,data->frootbuf,op);CHKERRQ(ierr);
+  } else {
+    ierr = VecScatterSFPackVecs(n,x,data->bs,data->nfroots,data->froots,data->frootbuf);CHKERRQ(ierr);
+    ierr = PetscSFBcastBegin(data->fsf,data->funit,data->frootbuf,data->fleafbuf);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterEndVecs_SF(VecScatter ctx,PetscInt n,const Vec x[],const Vec y[],InsertMode addv,ScatterMode mode)
+{
+  VecScatter_SF  *data = (VecScatter_SF*)ctx->todata;
+  PetscInt       nleaves;
+  MPI_Op         op;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (n != data->nfvecs) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"VecScatterEndVecs() with %D vectors does not match VecScatterBeginVecs() with %D",n,data->nfvecs);
+  ierr = VecScatterSFGetOp(addv,&op);CHKERRQ(ierr);
+  ierr = PetscSFGetGraph(data->fsf,NULL,&nleaves,NULL,NULL);CHKERRQ(ierr);
+  if (mode & SCATTER_REVERSE) {
+    ierr = PetscSFReduceEnd(data->fsf,data->funit,data->fleafbuf,data->frootbuf,op);CHKERRQ(ierr);
+    ierr = VecScatterSFUnpackVecs(n,y,data->bs,data->nfroots,data->froots,data->frootbuf,INSERT_VALUES);CHKERRQ(ierr);
+  } else {
+    ierr = PetscSFBcastEnd(data->fsf,data->funit,data->frootbuf,data->fleafbuf);CHKERRQ(ierr);
+    ierr = VecScatterSFUnpackVecs(n,y,data->bs,nleaves,data->fleaves,data->fleafbuf,addv);CHKERRQ(ierr);
+  }
+  ierr = MPI_Type_free(&data->funit);CHKERRQ(ierr);
+  data->nfvecs = 0;
+  PetscFunctionReturn(0);
+}
+
+/* Can the entries of the vector be moved in blocks of bs, that is, does every process own whole blocks? */
+static PetscErrorCode VecScatterSFBlocksAligned(Vec v,PetscBool parallel,PetscInt bs,PetscBool *aligned)
+{
+  PetscMPIInt    size,r;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  *aligned = PETSC_TRUE;
+  if (parallel) {
+    ierr = MPI_Comm_size(PetscObjectComm((PetscObject)v),&size);CHKERRQ(ierr);
+    for (r=0; r<=size; r++) if (v->map->range[r]%bs) *aligned = PETSC_FALSE;
+  } else if (v->map->n%bs) *aligned = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+/* The ranks in comm of the processes of the communicator of v, NULL when the two communicators order them alike */
+static PetscErrorCode VecScatterSFTranslateRanks(Vec v,MPI_Comm comm,PetscMPIInt **ranks)
+{
+  MPI_Comm       vcomm = PetscObjectComm((PetscObject)v);
+  MPI_Group      vgroup,group;
+  PetscMPIInt    result,size,i,*vranks;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  *ranks = NULL;
+  ierr = MPI_Comm_compare(vcomm,comm,&result);CHKERRQ(ierr);
+  if (result == MPI_IDENT || result == MPI_CONGRUENT) PetscFunctionReturn(0);
+  ierr = MPI_Comm_size(vcomm,&size);CHKERRQ(ierr);
+  ierr = MPI_Comm_group(vcomm,&vgroup);CHKERRQ(ierr);
+  ierr = MPI_Comm_group(comm,&group);CHKERRQ(ierr);
+  ierr = PetscMalloc1(size,&vranks);CHKERRQ(ierr);
+  ierr = PetscMalloc1(size,ranks);CHKERRQ(ierr);
+  for (i=0; i<size; i++) vranks[i] = i;
+  ierr = MPI_Group_translate_ranks(vgroup,size,vranks,group,*ranks);CHKERRQ(ierr);
+  for (i=0; i<size; i++) if ((*ranks)[i] == MPI_UNDEFINED) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_INCOMP,"The vectors of the scatter must live on processes of its communicator");
+  ierr = PetscFree(vranks);CHKERRQ(ierr);
+  ierr = MPI_Group_free(&vgroup);CHKERRQ(ierr);
+  ierr = MPI_Group_free(&group);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* Finds the process owning block idx of v, as a rank of the communicator of the scatter, and its offset there in blocks */
+PETSC_STATIC_INLINE PetscErrorCode VecScatterSFLocate(Vec v,PetscBool parallel,const PetscMPIInt *ranks,PetscMPIInt rank,PetscInt bs,PetscInt idx,PetscSFNode *node)
+{
+  PetscInt       owner;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (parallel) {
+    ierr = PetscLayoutFindOwner(v->map,idx*bs,&owner);CHKERRQ(ierr);
+    node->rank  = ranks ? ranks[owner] : owner;
+    node->index = (idx*bs - v->map->range[owner])/bs;
+  } else {
+    if (idx < 0 || idx*bs >= v->map->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Index %D out of range for a vector of local length %D",idx*bs,v->map->n);
+    node->rank  = rank;
+    node->index = idx;
+  }
+  PetscFunctionReturn(0);
+}
+
+static PetscErrorCode VecScatterSetUp_SF(VecScatter ctx)
+{
+  VecScatter_SF     *data;
+  MPI_Comm          comm;
+  PetscMPIInt       rank,size,*xranks = NULL,*yranks = NULL;
+  Vec               xin = ctx->from_v,yin = ctx->to_v;
+  IS                ix = ctx->from_is,iy = ctx->to_is,tix = NULL,tiy = NULL;
+  PetscInt          bs = 1,bsx,bsy,n,ny,i,j,k,nroots,nyroots,nleaves,nlocal,*ilocal,*llocal;
+  const PetscInt    *idx,*idy,*degree;
+  PetscSFNode       *xnodes,*ynodes,*iremote,*lremote;
+  PetscBool         xpar,ypar,ixblock,iyblock,xaligned,yaligned,remote = PETSC_FALSE,anyremote;
+  PetscSF           ysf;
+  const char        *prefix;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectGetComm((PetscObject)ctx,&comm);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PetscObjectComm((PetscObject)xin),&size);CHKERRQ(ierr);
+  xpar = (PetscBool)(size > 1);
+  ierr = MPI_Comm_size(PetscObjectComm((PetscObject)yin),&size);CHKERRQ(ierr);
+  ypar = (PetscBool)(size > 1);
+  ierr = GetInputISType_private(ctx,xpar ? VEC_MPI_ID : VEC_SEQ_ID,ypar ? VEC_MPI_ID : VEC_SEQ_ID,NULL,&tix,NULL,&tiy);CHKERRQ(ierr);
+  if (tix) ix = tix;
+  if (tiy) iy = tiy;
+
+  /* Blocked index sets with a common block size are moved block by block, unless a block straddles two processes */
+  ierr = PetscObjectTypeCompare((PetscObject)ix,ISBLOCK,&ixblock);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)iy,ISBLOCK,&iyblock);CHKERRQ(ierr);
+  if (ixblock && iyblock) {
+    ierr = ISGetBlockSize(ix,&bsx);CHKERRQ(ierr);
+    ierr = ISGetBlockSize(iy,&bsy);CHKERRQ(ierr);
+    if (bsx == bsy && bsx > 1) {
+      ierr = VecScatterSFBlocksAligned(xin,xpar,bsx,&xaligned);CHKERRQ(ierr);
+      ierr = VecScatterSFBlocksAligned(yin,ypar,bsx,&yaligned);CHKERRQ(ierr);
+      if (xaligned && yaligned) bs = bsx;
+    }
+  }
+  if (bs > 1) {
+    ierr = ISBlockGetLocalSize(ix,&n);CHKERRQ(ierr);
+    ierr = ISBlockGetLocalSize(iy,&ny);CHKERRQ(ierr);
+    ierr = ISBlockGetIndices(ix,&idx);CHKERRQ(ierr);
+    ierr = ISBlockGetIndices(iy,&idy);CHKERRQ(ierr);
+  } else {
+    ierr = ISGetLocalSize(ix,&n);CHKERRQ(ierr);
+    ierr = ISGetLocalSize(iy,&ny);CHKERRQ(ierr);
+    ierr = ISGetIndices(ix,&idx);CHKERRQ(ierr);
+    ierr = ISGetIndices(iy,&idy);CHKERRQ(ierr);
+  }
+  if (n != ny) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Local scatter sizes don't match, in %D out %D",n,ny);
+
+  /* The vectors may live on communicators ordering the processes differently from the one of the scatter */
+  if (xpar) {ierr = VecScatterSFTranslateRanks(xin,comm,&xranks);CHKERRQ(ierr);}
+  if (ypar) {ierr = VecScatterSFTranslateRanks(yin,comm,&yranks);CHKERRQ(ierr);}
+  ierr = PetscMalloc2(n,&xnodes,n,&ynodes);CHKERRQ(ierr);
+  for (i=0; i<n; i++) {
+    ierr = VecScatterSFLocate(xin,xpar,xranks,rank,bs,idx[i],&xnodes[i]);CHKERRQ(ierr);
+    ierr = VecScatterSFLocate(yin,ypar,yranks,rank,bs,idy[i],&ynodes[i]);CHKERRQ(ierr);
+    if (ynodes[i].rank != rank) remote = PETSC_TRUE;
+  }
+  ierr = PetscFree(xranks);CHKERRQ(ierr);
+  ierr = PetscFree(yranks);CHKERRQ(ierr);
+  if (bs > 1) {
+    ierr = ISBlockRestoreIndices(ix,&idx);CHKERRQ(ierr);
+    ierr = ISBlockRestoreIndices(iy,&idy);CHKERRQ(ierr);
+  } else {
+    ierr = ISRestoreIndices(ix,&idx);CHKERRQ(ierr);
+    ierr = ISRestoreIndices(iy,&idy);CHKERRQ(ierr);
+  }
+  ierr = ISDestroy(&tix);CHKERRQ(ierr);
+  ierr = ISDestroy(&tiy);CHKERRQ(ierr);
+
+  /* The leaves of a PetscSF are local, so the pairs whose to entry lives elsewhere are first moved to its owner */
+  nroots  = xin->map->n/bs;
+  nyroots = yin->map->n/bs;
+  ierr = MPIU_Allreduce(&remote,&anyremote,1,MPIU_BOOL,MPI_LOR,comm);CHKERRQ(ierr);
+  if (!anyremote) {
+    nleaves = n;
+    ierr    = PetscMalloc2(n,&ilocal,n,&iremote);CHKERRQ(ierr);
+    for (i=0; i<n; i++) {
+      ilocal[i]  = ynodes[i].index;
+      iremote[i] = xnodes[i];
+    }
+  } else {
+    ierr = PetscSFCreate(comm,&ysf);CHKERRQ(ierr);
+    ierr = PetscSFSetGraph(ysf,nyroots,n,NULL,PETSC_OWN_POINTER,ynodes,PETSC_USE_POINTER);CHKERRQ(ierr);
+    ierr = PetscSFComputeDegreeBegin(ysf,&degree);CHKERRQ(ierr);
+    ierr = PetscSFComputeDegreeEnd(ysf,&degree);CHKERRQ(ierr);
+    for (j=0,nleaves=0; j<nyroots; j++) nleaves += degree[j];
+    ierr = PetscMalloc2(nleaves,&ilocal,nleaves,&iremote);CHKERRQ(ierr);
+    ierr = PetscSFGatherBegin(ysf,MPIU_2INT,xnodes,iremote);CHKERRQ(ierr);
+    ierr = PetscSFGatherEnd(ysf,MPIU_2INT,xnodes,iremote);CHKERRQ(ierr);
+    for (j=0,k=0; j<nyroots; j++) for (i=0; i<degree[j]; i++) ilocal[k++] = j;
+    ierr = PetscSFDestroy(&ysf);CHKERRQ(ierr);
+  }
+  ierr = PetscFree2(xnodes,ynodes);CHKERRQ(ierr);
+
+  ierr = PetscNewLog(ctx,&data);CHKERRQ(ierr);
+  data->format = VEC_SCATTER_SF;
+  ierr = VecScatterSFSetUnit(data,bs);CHKERRQ(ierr);
+
+  for (i=0,nlocal=0; i<nleaves; i++) if (iremote[i].rank == rank) nlocal++;
+  ierr = PetscMalloc1(nlocal,&llocal);CHKERRQ(ierr);
+  ierr = PetscMalloc1(nlocal,&lremote);CHKERRQ(ierr);
+  for (i=0,k=0; i<nleaves; i++) {
+    if (iremote[i].rank != rank) continue;
+    llocal[k]        = ilocal[i];
+    lremote[k].rank  = 0;
+    lremote[k].index = iremote[i].index;
+    k++;
+  }
+  ierr = PetscSFCreate(PETSC_COMM_SELF,&data->lsf);CHKERRQ(ierr);
+  ierr = PetscSFSetType(data->lsf,PETSCSFBASIC);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(data->lsf,nroots,nlocal,llocal,PETSC_OWN_POINTER,lremote,PETSC_OWN_POINTER);CHKERRQ(ierr);
+  ierr = PetscSFSetUp(data->lsf);CHKERRQ(ierr);
+
+  /* -sf_type, with the prefix of the scatter, selects how the PetscSF communicates */
+  ierr = PetscSFCreate(comm,&data->sf);CHKERRQ(ierr);
+  ierr = PetscObjectGetOptionsPrefix((PetscObject)ctx,&prefix);CHKERRQ(ierr);
+  ierr = PetscObjectSetOptionsPrefix((PetscObject)data->sf,prefix);CHKERRQ(ierr);
+  ierr = PetscSFSetFromOptions(data->sf);CHKERRQ(ierr);
+  ierr = PetscSFSetGraph(data->sf,nroots,nleaves,ilocal,PETSC_COPY_VALUES,iremote,PETSC_COPY_VALUES);CHKERRQ(ierr);
+  ierr = PetscSFSetUp(data->sf);CHKERRQ(ierr);
+  ierr = PetscFree2(ilocal,iremote);CHKERRQ(ierr);
+
+  ctx->todata       = data;
+  ctx->fromdata     = data;
+  ctx->ops->begin     = VecScatterBegin_SF;
+  ctx->ops->end       = VecScatterEnd_SF;
+  ctx->ops->copy      = VecScatterCopy_SF;
+  ctx->ops->destroy   = VecScatterDestroy_SF;
+  ctx->ops->view      = VecScatterView_SF;
+  ctx->ops->remap     = VecScatterRemap_SF;
+  ctx->ops->beginvecs = VecScatterBeginVecs_SF;
+  ctx->ops->endvecs   = VecScatterEndVecs_SF;
+  ctx->ops->progress  = VecScatterProgress_SF;
+  ierr = PetscInfo3(ctx,"PetscSF with %D local roots and %D leaves, %D of them on this process\n",nroots,nleaves,nlocal);CHKERRQ(ierr);
+  ierr = VecScatterViewFromOptions(ctx,NULL,"-vecscatter_view");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*MC
+   VECSCATTERSF - A VecScatter that communicates with a PetscSF
+
+   The entries of the vector scattered from are the roots of the PetscSF and the entries of the vector scattered into
+   are its leaves. A forward scatter is PetscSFBcastAndOpBegin() and a reverse scatter PetscSFReduceBegin(), so every
+   communication optimization of PetscSF applies to VecScatter as well. Blocked index sets with the same block size
+   are moved one block per edge.
+
+   Options Database Keys:
++  -vecscatter_type sf - use this type
+-  -sf_type <basic,neighbor,shared,window> - how the PetscSF communicates, with the options prefix of the scatter
+
+   Notes:
+   Unlike the other types, several scatters with different vectors may be in flight at once: call VecScatterBegin()
+   for each pair of vectors, then VecScatterEnd() for each. VecScatterRemap() renumbers only the entries of the vector
+   scattered from. VecScatterBeginVecs() packs several vectors together so that they take one message per pair of
+   processes.
+
+   Level: intermediate
+
+.seealso: VecScatterCreate(), VecScatterSetType(), VecScatterBeginVecs(), VECSCATTERMPI1, VECSCATTERMPI3, PetscSF, PETSCSFBASIC
+M*/
+PETSC_INTERN PetscErrorCode VecScatterCreate_SF(VecScatter ctx)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ctx->ops->setup = VecScatterSetUp_SF;
+  ctx->concurrent = PETSC_TRUE;
+  ierr = PetscObjectChangeTypeName((PetscObject)ctx,VECSCATTERSF);CHKERRQ(ierr);
+  ierr = PetscInfo(ctx,"Using PetscSF for vector scatter\n");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
@@ -366,6 +366,33 @@ PetscErrorCode VecScatterMemcpyPlanDestroy(VecScatterMemcpyPlan *plan)
   PetscFunctionReturn(0);
 }
 
+/*
+   Progress of the persistent requests of a general parallel scatter, in both directions. MPI_Request_get_status()
+   enters the progress engine of MPI without completing or deactivating the request, which VecScatterEnd() still waits
+   on, and an inactive request counts as complete. Stops at the first request not yet complete.
+*/
+PetscErrorCode VecScatterProgress_PtoP(VecScatter ctx)
+{
+  VecScatter_MPI_General *to = (VecScatter_MPI_General*)ctx->todata,*from = (VecScatter_MPI_General*)ctx->fromdata;
+  MPI_Request            *reqs[4];
+  PetscInt               n[4],k,i;
+  int                    flag;
+  PetscErrorCode         ierr;
+
+  PetscFunctionBegin;
+  reqs[0] = from->requests;     n[0] = from->n;
+  reqs[1] = to->requests;       n[1] = to->n;
+  reqs[2] = to->rev_requests;   n[2] = to->rev_requests ? to->n : 0;
+  reqs[3] = from->rev_requests; n[3] = from->rev_requests ? from->n : 0;
+  for (k=0; k<4; k++) {
+    for (i=0; i<n[k]; i++) {
+      ierr = MPI_Request_get_status(reqs[k][i],&flag,MPI_STATUS_IGNORE);CHKERRQ(ierr);
+      if (!flag) PetscFunctionReturn(0);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
 /* =======================================================================*/
 /*
    Blocksizes we have optimized scatters for
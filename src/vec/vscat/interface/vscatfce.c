@@ -56,6 +56,9 @@ PetscErrorCode  VecScatterGetMerged(VecScatter ctx,PetscBool  *flg)
    You cannot change the values in the input vector between the calls to VecScatterBegin()
    and VecScatterEnd().
 
+   With VECSCATTERSF the same context may scatter several pairs of vectors at once, by calling VecScatterBegin()
+   for each pair before the matching VecScatterEnd() calls. The other types allow one scatter at a time.
+
    If you use SCATTER_REVERSE the two arguments x and y should be reversed, from
    the SCATTER_FORWARD.
 
@@ -83,7 +86,7 @@ PetscErrorCode  VecScatterBegin(VecScatter ctx,Vec x,Vec y,InsertMode addv,Scatt
   PetscValidHeaderSpecific(ctx,VEC_SCATTER_CLASSID,1);
   PetscValidHeaderSpecific(x,VEC_CLASSID,2);
   PetscValidHeaderSpecific(y,VEC_CLASSID,3);
-  if (ctx->inuse) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE," Scatter ctx already in use");
+  if (ctx->inuse && !ctx->concurrent) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE," Scatter ctx already in use");
 
 #if defined(PETSC_USE_DEBUG)
   /*
@@ -105,11 +108,11 @@ PetscErrorCode  VecScatterBegin(VecScatter ctx,Vec x,Vec y,InsertMode addv,Scatt
   }
 #endif
 
-  ctx->inuse = PETSC_TRUE;
+  ctx->inuse++;
   ierr = PetscLogEventBegin(VEC_ScatterBegin,ctx,x,y,0);CHKERRQ(ierr);
   ierr = (*ctx->ops->begin)(ctx,x,y,addv,mode);CHKERRQ(ierr);
   if (ctx->beginandendtogether && ctx->ops->end) {
-    ctx->inuse = PETSC_FALSE;
+    ctx->inuse--;
     ierr = (*ctx->ops->end)(ctx,x,y,addv,mode);CHKERRQ(ierr);
   }
   ierr = PetscLogEventEnd(VEC_ScatterBegin,ctx,x,y,0);CHKERRQ(ierr);
@@ -148,7 +151,7 @@ PetscErrorCode  VecScatterEnd(VecScatter ctx,Vec x,Vec y,InsertMode addv,Scatter
   PetscValidHeaderSpecific(ctx,VEC_SCATTER_CLASSID,1);
   PetscValidHeaderSpecific(x,VEC_CLASSID,2);
   PetscValidHeaderSpecific(y,VEC_CLASSID,3);
-  ctx->inuse = PETSC_FALSE;
+  if (ctx->inuse) ctx->inuse--;
   if (!ctx->ops->end) PetscFunctionReturn(0);
   if (!ctx->beginandendtogether) {
     ierr = PetscLogEventBegin(VEC_ScatterEnd,ctx,x,y,0);CHKERRQ(ierr);
@@ -158,6 +161,153 @@ PetscErrorCode  VecScatterEnd(VecScatter ctx,Vec x,Vec y,InsertMode addv,Scatter
   PetscFunctionReturn(0);
 }
 
+/*@
+   VecScatterBeginVecs - Begins scattering several pairs of vectors with the same scatter, packing the entries of all
+   of them into one message per pair of processes. Complete with VecScatterEndVecs().
+
+   Neighbor-wise Collective on VecScatter and Vec
+
+   Input Parameters:
++  ctx - scatter context generated by VecScatterCreate() or VecScatterCreateWithData()
+.  n - the number of pairs of vectors
+.  x - the vectors from which we scatter
+.  y - the vectors to which we scatter
+.  addv - either ADD_VALUES, MAX_VALUES or INSERT_VALUES
+-  mode - the scattering mode, usually SCATTER_FORWARD.  The available modes are:
+    SCATTER_FORWARD or SCATTER_REVERSE
+
+   Level: intermediate
+
+   Notes:
+   The result is that of VecScatterBegin() and VecScatterEnd() on each pair x[i], y[i], but when updating the ghost
+   points of several fields the message count is divided by n, which matters when the scatter is latency bound.
+
+   Only VECSCATTERSF packs the vectors together; with the other types, and with SCATTER_LOCAL, the pairs are scattered
+   one after the other in VecScatterBeginVecs() and VecScatterEndVecs() does nothing. Only one VecScatterBeginVecs()
+   may be in progress on a scatter.
+
+   The vectors of a DMDA are scattered with the scatter returned by DMDAGetScatter(), from global vectors into local
+   vectors.
+
+.seealso: VecScatterEndVecs(), VecScatterBegin(), VecScatterCreate(), VECSCATTERSF, DMDAGetScatter()
+@*/
+PetscErrorCode  VecScatterBeginVecs(VecScatter ctx,PetscInt n,const Vec x[],const Vec y[],InsertMode addv,ScatterMode mode)
+{
+  PetscErrorCode ierr;
+  PetscInt       i;
+#if defined(PETSC_USE_DEBUG)
+  PetscInt       to_n,from_n;
+#endif
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(ctx,VEC_SCATTER_CLASSID,1);
+  if (n < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Number of vectors %D cannot be negative",n);
+  if (n) {
+    PetscValidPointer(x,3);
+    PetscValidPointer(y,4);
+  }
+  for (i=0; i<n; i++) {
+    PetscValidHeaderSpecific(x[i],VEC_CLASSID,3);
+    PetscValidHeaderSpecific(y[i],VEC_CLASSID,4);
+  }
+  if (!ctx->ops->beginvecs || (mode & SCATTER_LOCAL)) {
+    for (i=0; i<n; i++) {
+      ierr = VecScatterBegin(ctx,x[i],y[i],addv,mode);CHKERRQ(ierr);
+      ierr = VecScatterEnd(ctx,x[i],y[i],addv,mode);CHKERRQ(ierr);
+    }
+    PetscFunctionReturn(0);
+  }
+  if (ctx->inuse && !ctx->concurrent) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE," Scatter ctx already in use");
+#if defined(PETSC_USE_DEBUG)
+  if (ctx->from_n >= 0 && ctx->to_n >= 0) {
+    for (i=0; i<n; i++) {
+      ierr = VecGetLocalSize(x[i],&from_n);CHKERRQ(ierr);
+      ierr = VecGetLocalSize(y[i],&to_n);CHKERRQ(ierr);
+      if (mode & SCATTER_REVERSE) {
+        if (to_n != ctx->from_n || from_n != ctx->to_n) SETERRQ5(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Vectors %D have wrong sizes %D and %D for reverse scatter %D to %D",i,from_n,to_n,ctx->to_n,ctx->from_n);
+      } else {
+        if (to_n != ctx->to_n || from_n != ctx->from_n) SETERRQ5(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Vectors %D have wrong sizes %D and %D for scatter %D to %D",i,from_n,to_n,ctx->from_n,ctx->to_n);
+      }
+    }
+  }
+#endif
+  if (!n) PetscFunctionReturn(0);
+  ctx->inuse++;
+  ierr = PetscLogEventBegin(VEC_ScatterBegin,ctx,x[0],y[0],0);CHKERRQ(ierr);
+  ierr = (*ctx->ops->beginvecs)(ctx,n,x,y,addv,mode);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(VEC_ScatterBegin,ctx,x[0],y[0],0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@
+   VecScatterEndVecs - Ends scattering several pairs of vectors, after VecScatterBeginVecs()
+
+   Neighbor-wise Collective on VecScatter and Vec
+
+   Input Parameters:
++  ctx - scatter context generated by VecScatterCreate() or VecScatterCreateWithData()
+.  n - the number of pairs of vectors
+.  x - the vectors from which we scatter
+.  y - the vectors to which we scatter
+.  addv - either ADD_VALUES, MAX_VALUES or INSERT_VALUES
+-  mode - the scattering mode, usually SCATTER_FORWARD.  The available modes are:
+    SCATTER_FORWARD or SCATTER_REVERSE
+
+   Level: intermediate
+
+   Notes:
+   The arguments must be those given to VecScatterBeginVecs().
+
+.seealso: VecScatterBeginVecs(), VecScatterEnd()
+@*/
+PetscErrorCode  VecScatterEndVecs(VecScatter ctx,PetscInt n,const Vec x[],const Vec y[],InsertMode addv,ScatterMode mode)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(ctx,VEC_SCATTER_CLASSID,1);
+  if (!n || !ctx->ops->endvecs || (mode & SCATTER_LOCAL)) PetscFunctionReturn(0);
+  PetscValidPointer(x,3);
+  PetscValidPointer(y,4);
+  if (ctx->inuse) ctx->inuse--;
+  ierr = PetscLogEventBegin(VEC_ScatterEnd,ctx,x[0],y[0],0);CHKERRQ(ierr);
+  ierr = (*ctx->ops->endvecs)(ctx,n,x,y,addv,mode);CHKERRQ(ierr);
+  ierr = PetscLogEventEnd(VEC_ScatterEnd,ctx,x[0],y[0],0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*@
+   VecScatterProgress - Lets MPI move the messages of the scatters begun with this context and not yet ended, without
+   waiting for them
+
+   Not Collective
+
+   Input Parameter:
+.  ctx - scatter context generated by VecScatterCreate() or VecScatterCreateWithData()
+
+   Level: developer
+
+   Notes:
+   Many MPI implementations only move the messages of nonblocking operations while the process is inside MPI, so that
+   a large message, or one sent with a rendezvous protocol, may not be transferred while local computation is done
+   between VecScatterBegin() and VecScatterEnd(). Calling this routine from time to time during that computation
+   overlaps it with the communication. The scatters still have to be completed with VecScatterEnd().
+
+   It does nothing for the scatters that do not keep requests, such as the sequential ones. With VECSCATTERSF it calls
+   PetscSFProgress().
+
+.seealso: VecScatterBegin(), VecScatterEnd(), PetscSFProgress(), MATMPIAIJ
+@*/
+PetscErrorCode VecScatterProgress(VecScatter ctx)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(ctx,VEC_SCATTER_CLASSID,1);
+  if (ctx->ops->progress) {ierr = (*ctx->ops->progress)(ctx);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
 /*@
    VecScatterDestroy - Destroys a scatter context created by
    VecScatterCreate() or VecScatterCreateWithData()
@@ -310,6 +460,12 @@ PetscErrorCode  VecScatterRemap(VecScatter scat,PetscInt tomap[],PetscInt fromma
   PetscValidHeaderSpecific(scat,VEC_SCATTER_CLASSID,1);
   if (tomap)   PetscValidIntPointer(tomap,2);
   if (frommap) PetscValidIntPointer(frommap,3);
+  if (scat->ops->remap) {
+    ierr = (*scat->ops->remap)(scat,tomap,frommap);CHKERRQ(ierr);
+    scat->from_n = -1;
+    scat->to_n   = -1;
+    PetscFunctionReturn(0);
+  }
 
   to     = (VecScatter_MPI_General*)scat->todata;
   from   = (VecScatter_MPI_General*)scat->fromdata;
@@ -24,7 +24,7 @@ PetscBool         VecScatterRegisterAllCalled = PETSC_FALSE;
                      of available types
 
   Notes:
-  See "petsc/include/petscvec.h" for available vector scatter types (for instance, VECSCATTERMPI1, or VECSCATTERMPI3NODE).
+  See "petsc/include/petscvec.h" for available vector scatter types (for instance, VECSCATTERMPI1, VECSCATTERMPI3NODE or VECSCATTERSF).
 
   Use VecScatterDuplicate() to form additional vectors scatter of the same type as an existing vector scatter.
 
@@ -51,6 +51,7 @@ PetscErrorCode VecScatterSetType(VecScatter vscat, VecScatterType type)
     ierr = (*vscat->ops->destroy)(vscat);CHKERRQ(ierr);
     vscat->ops->destroy = NULL;
   }
+  vscat->concurrent = PETSC_FALSE;
 
   ierr = (*r)(vscat);CHKERRQ(ierr);
   PetscFunctionReturn(0);
@@ -357,7 +358,8 @@ PetscErrorCode  VecScatterCreate(MPI_Comm comm,VecScatter *newctx)
   PetscFunctionBegin;
   ierr = VecScatterInitializePackage();CHKERRQ(ierr);
   ierr = PetscHeaderCreate(ctx,VEC_SCATTER_CLASSID,"VecScatter","Vector Scatter","Vec",comm,VecScatterDestroy,VecScatterView);CHKERRQ(ierr);
-  ctx->inuse               = PETSC_FALSE;
+  ctx->inuse               = 0;
+  ctx->concurrent          = PETSC_FALSE;
   ctx->beginandendtogether = PETSC_FALSE;
   ctx->is_duplicate        = PETSC_FALSE;
   *newctx = ctx;